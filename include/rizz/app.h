@@ -230,6 +230,7 @@ typedef struct rizz_api_app {
     const char* (*name)();
     void (*show_mouse)(bool visible);
     bool (*mouse_shown)();
+    bool (*headless)();    // RIZZ_APP_FLAG_HEADLESS: no window and no gpu/audio devices
 } rizz_api_app;
 
 #ifdef RIZZ_INTERNAL_API
@@ -27,7 +27,7 @@
 #pragma once
 
 #include "sx/io.h"
-#include "types.h"
+#include "core.h"
 
 enum rizz_asset_load_flags_ {
     RIZZ_ASSET_LOAD_FLAG_NONE = 0x0,
@@ -93,8 +93,27 @@ typedef struct rizz_asset_callbacks {
     // 'metadata' with valid information
     void (*on_read_metadata)(void* metadata, const rizz_asset_load_params* params,
                              const sx_mem_block* mem);
+
+    // Runs on main-thread (optional)
+    // Returns the memory footprint of a loaded object in bytes and the memory-id it counts against.
+    // Only assets of types that implement this are kept resident in the asset cache when their
+    // refcount reaches zero (see `rizz_api_asset.set_cache_budget`)
+    int64_t (*on_get_size)(rizz_asset_obj obj, const void* metadata, rizz_mem_id* memid);
 } rizz_asset_callbacks;
 
+// Asset cache: unloaded (zero refcount) assets are kept resident in a LRU list per memory-id, as
+//              long as the total size of them fits into the budget of that memory-id
+//              Loading an asset that is still in the cache revives it instantly without any IO
+//              Budgets are zero by default, which means the cache is disabled
+typedef struct rizz_asset_cache_info {
+    int64_t resident_bytes[_RIZZ_MEMID_COUNT];
+    int64_t budget_bytes[_RIZZ_MEMID_COUNT];
+    int num_resident;
+    int hits;
+    int misses;
+    int evictions;
+} rizz_asset_cache_info;
+
 typedef struct rizz_api_asset {
     void (*register_asset_type)(const char* name, rizz_asset_callbacks callbacks,
                                 const char* params_type_name, int params_size,
@@ -105,6 +124,14 @@ typedef struct rizz_api_asset {
 
     rizz_asset (*load)(const char* name, const char* path, const void* params,
                        rizz_asset_load_flags flags, const sx_alloc* alloc, uint32_t tags);
+    // blocking load of multiple assets of the same type (always RIZZ_ASSET_LOAD_FLAG_WAIT_ON_LOAD)
+    // files are read and `on_load` runs on worker threads in parallel, `on_prepare` and
+    // `on_finalize` run on the calling thread in the order of `paths`. `params` is used for all
+    // returns number of assets that are loaded successfully, `out_handles` (optional) receives
+    // a handle for each path
+    int (*load_batch)(const char* name, const char** paths, int count, const void* params,
+                      rizz_asset_load_flags flags, const sx_alloc* alloc, uint32_t tags,
+                      rizz_asset* out_handles);
     rizz_asset (*load_from_mem)(const char* name, const char* path_alias, sx_mem_block* mem,
                                 const void* params, rizz_asset_load_flags flags,
                                 const sx_alloc* alloc, uint32_t tags);
@@ -137,6 +164,10 @@ typedef struct rizz_api_asset {
     void (*group_delete)(rizz_asset_group group);
     void (*group_unload)(rizz_asset_group group);
     int (*group_gather)(rizz_asset_group group, rizz_asset* out_handles, int max_handles);
+
+    // budget_bytes = 0 disables caching for the memory-id and evicts everything in it
+    void (*set_cache_budget)(rizz_mem_id memid, int64_t budget_bytes);
+    void (*cache_info)(rizz_asset_cache_info* info);
 } rizz_api_asset;
 
 #ifdef RIZZ_INTERNAL_API
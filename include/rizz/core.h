@@ -31,18 +31,26 @@ typedef enum rizz_mem_id {
     _RIZZ_MEMID_COUNT
 } rizz_mem_id;
 
+// memory profiler: allocations are aggregated by call-site
+// if sample rate is more than 1, the numbers are estimated from sampled allocations
 typedef struct rizz_track_alloc_item {
     char file[32];
     char func[64];
-    void* ptr;
-    int64_t size;
     int line;
+    int mem_id;
+    int num_allocs;          // number of live allocations
+    int64_t size;            // live memory
+    int64_t peak;            // peak of live memory
+    int64_t total_allocs;    // number of allocations since the beginning
 } rizz_track_alloc_item;
 
 typedef struct {
     int offset;
-    int size;
-    int peak;
+    int size;          // reserved size
+    int peak;          // peak (high-water mark) since the beginning
+    int frame_peak;    // peak of the previous frame
+    int committed;     // committed (resident) memory
+    int fallback;      // allocated from heap, after the reserved size is exhausted
 } rizz_linalloc_info;
 
 typedef struct {
@@ -62,6 +70,9 @@ typedef struct rizz_mem_info {
     size_t heap;
     size_t heap_max;
     int heap_count;
+    int track_sample_rate;       // memory profiler: only every Nth allocation is recorded
+    int track_dropped_events;    // memory profiler: events lost, because of full thread buffers
+    sx_fiber_stack_pool_info fiber_stacks;    // job and coroutine stacks (peak: high-water mark)
 } rizz_mem_info;
 
 typedef struct rizz_api_core {
@@ -70,6 +81,8 @@ typedef struct rizz_api_core {
 
     // temp stack allocator: fast and thread-safe (per job thread only).
     //                       Temp allocators behave like stack, so they can push() and pop()
+    //                       Memory is committed on demand from a reserved range (see
+    //                       `rizz_config.tmp_mem_max`), and falls back to heap if it's exhausted
     // NOTE: do not keep tmp_alloc memory between multiple frames,
     //       At the end of each frame, the tmp_allocs are reset
     const sx_alloc* (*tmp_alloc_push)();
@@ -85,10 +98,15 @@ typedef struct rizz_api_core {
     void (*tls_register)(const char* name, void* user,
                          void* (*init_cb)(int thread_idx, uint32_t thread_id, void* user));
     void* (*tls_var)(const char* name);
+    // call on user-created threads right before they exit, so per-thread resources (thread heaps)
+    // can be reused by other threads
+    void (*thread_exit)();
 
     const sx_alloc* (*alloc)(rizz_mem_id id);
 
     void (*get_mem_info)(rizz_mem_info* info);
+    // writes memory profiler call-sites to a CSV file (needs RIZZ_CONFIG_DEBUG_MEMORY=1)
+    bool (*dump_mem_profile)(const char* filepath);
 
     // random
     uint32_t (*rand)();                       // 0..UNT32_MAX
@@ -117,6 +135,11 @@ typedef struct rizz_api_core {
     void (*coro_end)(void* pfrom);
     void (*coro_wait)(void* pfrom, int msecs);
     void (*coro_yield)(void* pfrom, int nframes);
+    // flags: see sx_coro_flags_ (SX_CORO_FLAG_MAIN_THREAD)
+    void (*coro_invoke_with_flags)(void (*coro_cb)(sx_fiber_transfer), void* user,
+                                   uint32_t flags);
+    // yields the coroutine until the job is finished, then deletes the job handle
+    void (*coro_wait_job)(void* pfrom, sx_job_t job);
 
     void (*print_info)(const char* fmt, ...);
     void (*print_debug)(const char* fmt, ...);
@@ -137,7 +160,11 @@ typedef struct rizz_gfx_cmdbuffer rizz_gfx_cmdbuffer;    // #include "rizz/graph
 bool rizz__core_init(const rizz_config* conf);
 void rizz__core_release();
 void rizz__core_frame();
+void rizz__core_frame_with_delta(uint64_t delta_tick);    // frame with a given (not measured) delta
+void rizz__core_set_rng_seed(uint32_t seed);
+uint32_t rizz__core_rng_seed();
 rizz_gfx_cmdbuffer* rizz__core_gfx_cmdbuffer();
+void rizz__core_thread_exit();
 RIZZ_API void rizz__core_fix_callback_ptrs(const void** ptrs, const void** new_ptrs, int num_ptrs);
 
 RIZZ_API rizz_api_core the__core;
@@ -159,6 +186,9 @@ RIZZ_API rizz_api_core the__core;
 #   define rizz_coro_yield()                 the__core.coro_yield(&__transfer.from, 1)
 #   define rizz_coro_yieldn(_n)              the__core.coro_yield(&__transfer.from, (_n))
 #   define rizz_coro_invoke(_name, _user)    the__core.coro_invoke(coro__##_name, (_user))
+#   define rizz_coro_invoke_with_flags(_name, _user, _flags)    \
+        the__core.coro_invoke_with_flags(coro__##_name, (_user), (_flags))
+#   define rizz_coro_wait_job(_job)          the__core.coro_wait_job(&__transfer.from, (_job))
 #else
 // logging
 #   define rizz_log_info(_core, _text, ...)     _core->print_info(_text, ##__VA_ARGS__)
@@ -185,6 +215,9 @@ RIZZ_API rizz_api_core the__core;
 #   define rizz_coro_yieldn(_core, _n)           _core->coro_yield(&__transfer.from, (_n))
 #   define rizz_coro_end(_core)                  _core->coro_end(&__transfer.from)
 #   define rizz_coro_invoke(_core, _name, _user) _core->coro_invoke(coro__##_name, (_user))
+#   define rizz_coro_invoke_with_flags(_core, _name, _user, _flags)    \
+        _core->coro_invoke_with_flags(coro__##_name, (_user), (_flags))
+#   define rizz_coro_wait_job(_core, _job)       _core->coro_wait_job(&__transfer.from, (_job))
 
 // clang-format on
 
@@ -20,7 +20,8 @@ enum rizz_app_flags_ {
     RIZZ_APP_FLAG_HTML5_CANVAS_RESIZE = 0x20,
     RIZZ_APP_FLAG_IOS_KEYBOARD_RESIZES_CANVAS = 0x40,
     RIZZ_APP_FLAG_USER_CURSOR = 0x80,
-    RIZZ_APP_FLAG_FORCE_GLES2 = 0x100
+    RIZZ_APP_FLAG_FORCE_GLES2 = 0x100,
+    RIZZ_APP_FLAG_HEADLESS = 0x200    // no window, dummy graphics backend and null audio device
 };
 typedef uint32_t rizz_app_flags;
 
@@ -29,7 +30,10 @@ enum rizz_core_flags_ {
     RIZZ_CORE_FLAG_LOG_TO_FILE = 0x02,          // log to file defined by `app_name.log`
     RIZZ_CORE_FLAG_LOG_TO_PROFILER = 0x04,      // log to remote profiler
     RIZZ_CORE_FLAG_PROFILE_GPU = 0x08,          // enable GPU profiling
-    RIZZ_CORE_FLAG_DUMP_UNUSED_ASSETS = 0x10    // write `unused-assets.json` on exit
+    RIZZ_CORE_FLAG_DUMP_UNUSED_ASSETS = 0x10,   // write `unused-assets.json` on exit
+    RIZZ_CORE_FLAG_TEMP_GUARD_PAGES = 0x20,     // temp allocators trap overruns with guard pages
+    RIZZ_CORE_FLAG_LOG_DEFER_FORMAT = 0x40,     // format log messages on the logger thread
+    RIZZ_CORE_FLAG_CORO_JOBS = 0x80             // resume due coroutines on job threads
 };
 typedef uint32_t rizz_core_flags;
 
@@ -59,7 +63,11 @@ typedef struct rizz_config {
     int coro_max_fibers;    // maximum running (active) coroutines at a time
     int coro_stack_size;    // in kbytes
 
-    int tmp_mem_max;    // in kbytes (defaut: 5mb per-thread)
+    int tmp_mem_max;    // in kbytes, reserved per-thread (default: 256mb on 64bit, 32mb on 32bit)
+    int mem_sample_rate;    // memory profiler: record every Nth allocation (default: 1, all)
+    // bitmask of (1 << rizz_mem_id): allocators of these mem-ids use thread-caching TLSF heaps
+    // instead of libc malloc. blocks must be freed with an allocator of the same kind
+    uint32_t heap_tlsf_mask;
 
     int profiler_listen_port;
     int profiler_update_interval_ms;    // default: 10
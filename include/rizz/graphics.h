@@ -131,6 +131,8 @@ typedef struct rizz_texture_load_params {
     sg_wrap wrap_u;
     sg_wrap wrap_v;
     sg_wrap wrap_w;
+    bool generate_mips;    // generate mip-chain for non DDS/KTX images (needs a mipmap min_filter)
+    bool linear_mips;      // color is linear data (normal maps, masks), default is sRGB averaging
 } rizz_texture_load_params;
 
 // texture metadata
@@ -200,6 +202,12 @@ typedef struct rizz_gfx_trace_info {
     int num_apply_pipelines;
     int num_apply_passes;
 
+    // make_pipeline/make_shader calls that returned an existing (identical) object
+    int pip_cache_hits;
+    int pip_cache_misses;
+    int shader_cache_hits;
+    int shader_cache_misses;
+
     int64_t texture_size;
     int64_t texture_peak;
 
@@ -452,4 +460,16 @@ void rizz__gfx_update();
 void rizz__gfx_commit();
 
 RIZZ_API rizz_api_gfx the__gfx;
+
+// same module built with sokol's dummy backend (graphics-headless.c), used by headless mode
+bool rizz__gfx_headless_init(const sx_alloc* alloc, const sg_desc* desc, bool enable_profile);
+void rizz__gfx_headless_release();
+void rizz__gfx_headless_trace_reset_frame_stats();
+rizz__gfx_cmdbuffer* rizz__gfx_headless_create_command_buffer(const sx_alloc* alloc);
+void rizz__gfx_headless_destroy_command_buffer(rizz__gfx_cmdbuffer* cb);
+int rizz__gfx_headless_execute_command_buffers();
+void rizz__gfx_headless_update();
+void rizz__gfx_headless_commit();
+
+RIZZ_API rizz_api_gfx the__gfx_headless;
 #endif
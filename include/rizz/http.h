@@ -2,7 +2,10 @@
 // Copyright 2019 Sepehr Taghdisian (septag@github). All rights reserved.
 // License: https://github.com/septag/rizz#license-bsd-2-clause
 //
-// NOTE: Api is not multi-threaded. But I will make it thread-safe if it's needed
+// NOTE: Api is not multi-threaded, it must be called from the main thread. Requests are
+//       processed on a dedicated network thread and results (callbacks, stream data) are delivered
+//       on the main thread when the engine updates the http client.
+//       connections are kept alive and reused for requests to the same host (http/1.1 only, no tls)
 #pragma once
 
 #include "types.h"
@@ -20,9 +23,11 @@ typedef struct rizz_http_state {
     char const* content_type;
     size_t response_size;
     void* response_data;
+    char const* headers;    // response header lines: "name: value\r\n" ...
 } rizz_http_state;
 
 typedef void(rizz_http_cb)(const rizz_http_state* http, void* user);
+typedef void(rizz_http_data_cb)(const void* data, size_t size, void* user);
 
 typedef struct rizz_api_http {
     // normal requests: returns immediately (async sockets)
@@ -41,6 +46,21 @@ typedef struct rizz_api_http {
     void (*get_cb)(const char* url, rizz_http_cb* callback, void* user);
     void (*post_cb)(const char* url, const void* data, size_t size, rizz_http_cb* callback,
                     void* user);
+
+    // streamed requests: response body is delivered in pieces to `data_cb` as it is received
+    // (chunked or not), `response_data` will be NULL and `response_size` is the total size.
+    // `callback` is optional and triggers when the request is finished, after the last piece
+    void (*get_stream)(const char* url, rizz_http_data_cb* data_cb, rizz_http_cb* callback,
+                       void* user);
+
+    // same as `get_cb`, with extra request headers. each line must end with "\r\n"
+    // example: "If-None-Match: \"1a2b\"\r\nRange: bytes=0-1023\r\n"
+    void (*get_cb_headers)(const char* url, const char* headers, rizz_http_cb* callback,
+                           void* user);
+
+    // looks up a response header by name (case-insensitive), returns false if it's not found
+    // `value` can be NULL to only check if the header exists
+    bool (*header)(const rizz_http_state* http, const char* name, char* value, int value_size);
 } rizz_api_http;
 
 #ifdef RIZZ_INTERNAL_API
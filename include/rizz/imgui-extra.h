@@ -6,6 +6,7 @@
 
 typedef struct rizz_mem_info rizz_mem_info;
 typedef struct rizz_gfx_trace_info rizz_gfx_trace_info;
+typedef struct rizz_asset_cache_info rizz_asset_cache_info;
 typedef struct ImDrawList ImDrawList;
 
 typedef enum { GIZMO_MODE_LOCAL, GIZMO_MODE_WORLD } gizmo_mode;
@@ -13,6 +14,7 @@ typedef enum { GIZMO_MODE_LOCAL, GIZMO_MODE_WORLD } gizmo_mode;
 typedef struct rizz_api_imgui_extra {
     void (*memory_debugger)(const rizz_mem_info* info, bool* p_open);
     void (*graphics_debugger)(const rizz_gfx_trace_info* info, bool* p_open);
+    void (*asset_cache_debugger)(const rizz_asset_cache_info* info, bool* p_open);
 
     // Full screen 2D drawing
     // You can begin by calling `begin_fullscreen_draw`, fetch and keep the ImDrawList
@@ -26,6 +26,9 @@
 #include "types.h"
 
 typedef struct sx_alloc sx_alloc;
+typedef struct sx_mem_writer sx_mem_writer;
+typedef struct sx_mem_reader sx_mem_reader;
+typedef struct rizz_refl_serializer rizz_refl_serializer;
 
 typedef enum rizz_refl_type { RIZZ_REFL_ENUM, RIZZ_REFL_FUNC, RIZZ_REFL_FIELD } rizz_refl_type;
 
@@ -70,12 +73,38 @@ typedef struct rizz_api_refl {
     int (*get_fields)(const char* base_type, void* obj, rizz_refl_field* fields, int max_fields);
     int (*reg_count)();
     bool (*is_cstring)(const rizz_refl_info* r);
+
+    // serializers: the struct is compiled once into a flat list of fields (offsets, types, enums)
+    // arrays of the struct are then serialized without any reflection lookups.
+    // pointer fields are skipped. destroy and re-create serializers if the types are re-registered
+    // binary: data is written with a schema, if the schema of the reader is different, fields are
+    // matched by their names (numbers are converted) and missing ones are left untouched
+    // json: array of objects, enums are written by their names (format of asset database)
+    rizz_refl_serializer* (*create_serializer)(const char* base_type, uint32_t version);
+    void (*destroy_serializer)(rizz_refl_serializer* srz);
+    bool (*serialize_bin)(const rizz_refl_serializer* srz, sx_mem_writer* writer,
+                          const void* objs, int count);
+    // returns number of items read into `objs`, or -1 if data is invalid
+    // `version` (optional) receives the version of the serializer that has written the data
+    int (*deserialize_bin)(const rizz_refl_serializer* srz, sx_mem_reader* reader, void* objs,
+                           int max_count, uint32_t* version);
+    // returned string is allocated by `alloc`, free it with `sx_free`
+    char* (*serialize_json)(const rizz_refl_serializer* srz, const void* objs, int count,
+                            const sx_alloc* alloc);
+    int (*deserialize_json)(const rizz_refl_serializer* srz, const char* json, void* objs,
+                            int max_count);
 } rizz_api_refl;
 
 
 #ifdef RIZZ_INTERNAL_API
+typedef struct sjson_node sjson_node;
+typedef struct sjson_context sjson_context;
+
 bool rizz__refl_init(const sx_alloc* alloc, int max_regs sx_default(0));
 void rizz__refl_release();
+void rizz__refl_read_json(const rizz_refl_serializer* srz, sjson_node* jobj, void* obj);
+void rizz__refl_write_json(const rizz_refl_serializer* srz, sjson_context* jctx, sjson_node* jobj,
+                           const void* obj);
 
 RIZZ_API rizz_api_refl the__refl;
 
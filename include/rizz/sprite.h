@@ -24,6 +24,7 @@ typedef struct sx_alloc sx_alloc;
 typedef struct { uint32_t id; } rizz_sprite;
 typedef struct { uint32_t id; } rizz_sprite_animclip;
 typedef struct { uint32_t id; } rizz_sprite_animctrl;
+typedef struct { uint32_t id; } rizz_sprite_layer;
 //clang-format on
 
 typedef enum {
@@ -56,18 +57,45 @@ typedef struct rizz_sprite_vertex {
     sx_color color;
 } rizz_sprite_vertex;
 
+// batches are split by `image`, which is either the texture's image or a dynamic atlas page
+// that small standalone textures are packed into. `texture` is the texture of the first sprite
 typedef struct rizz_sprite_drawbatch {
     int        index_start;
     int        index_count;
     rizz_asset texture;
+    sg_image   image;
 } rizz_sprite_drawbatch;
 
+// per-instance data of quad sprites (see `make_drawdata_instanced_batch`)
+// each instance is drawn with a static unit quad (corners (0, 0)..(1, 1), indices 0,1,2, 2,1,3)
+//  - t1, t2: 2x3 transform that maps unit quad corner to position: (m11, m12, m21), (m22, m13, m23)
+//            x' = m11*x + m21*y + m13, y' = m12*x + m22*y + m23
+//  - uv_rect: unorm16 texture coords, (u0, v0) maps to corner (0, 0) and (u1, v1) to (1, 1)
+typedef struct rizz_sprite_instance {
+    sx_vec3  t1;
+    sx_vec3  t2;
+    uint16_t uv_rect[4];
+    sx_color color;
+} rizz_sprite_instance;
+
+// `batch_index`: draw order between the two kinds of batches. the instance batch is drawn after
+// `batches[0..batch_index)` and before the rest of them, so sprites that share an image are drawn
+// in input order, whichever pipeline they go through
+typedef struct rizz_sprite_instbatch {
+    int        instance_start;
+    int        instance_count;
+    int        batch_index;
+    rizz_asset texture;
+    sg_image   image;
+} rizz_sprite_instbatch;
+
 typedef struct rizz_sprite_drawsprite {
     int index;          // index to input (original) sprite array (see `sprite_drawdata_make_batch`)
     int start_vertex;
     int start_index;
     int num_verts;
     int num_indices;
+    int instance;       // index to `instances` if sprite is instanced, -1 if it's in verts/indices
 } rizz_sprite_drawsprite;
 
 typedef struct rizz_sprite_drawdata {
@@ -75,10 +103,14 @@ typedef struct rizz_sprite_drawdata {
     rizz_sprite_drawbatch*  batches;
     rizz_sprite_vertex*     verts;
     uint16_t*               indices;
+    rizz_sprite_instbatch*  instance_batches;
+    rizz_sprite_instance*   instances;    // transforms are local to sprite (without sprite matrix)
     int                     num_sprites;
     int                     num_batches;
     int                     num_verts;
     int                     num_indices;
+    int                     num_instance_batches;
+    int                     num_instances;
 } rizz_sprite_drawdata;
 
 typedef struct rizz_atlas_info {
@@ -172,6 +204,22 @@ typedef struct rizz_sprite_animctrl_desc {
     int                                         num_transitions;
 } rizz_sprite_animctrl_desc;
 
+typedef enum rizz_sprite_event_source {
+    RIZZ_SPRITE_EVENTSOURCE_ANIMCLIP = 0,    // frame events and end event (`clip` is valid)
+    RIZZ_SPRITE_EVENTSOURCE_ANIMCTRL         // transition events (`ctrl` is valid)
+} rizz_sprite_event_source;
+
+// entry of the frame event stream, see rizz_api_sprite.events
+typedef struct rizz_sprite_event {
+    union {
+        rizz_sprite_animclip clip;
+        rizz_sprite_animctrl ctrl;
+    };
+    rizz_sprite_event_source source;
+    int                      e;
+    void*                    user;
+} rizz_sprite_event;
+
 typedef struct rizz_api_sprite {
     rizz_sprite (*create)(const rizz_sprite_desc* desc);
     void (*destroy)(rizz_sprite spr);
@@ -197,10 +245,18 @@ typedef struct rizz_api_sprite {
     rizz_sprite_drawdata* (*make_drawdata)(rizz_sprite spr, const sx_alloc* alloc);
     rizz_sprite_drawdata* (*make_drawdata_batch)(const rizz_sprite* sprs, int num_sprites,
                                                  const sx_alloc* alloc);
+    // same as `make_drawdata_batch`, but quad sprites are stored in `instances`, only
+    // mesh (cropped) atlas sprites are written to verts/indices
+    // batches are split where sprites of the same image switch between the two kinds, draw them in
+    // the order of `rizz_sprite_instbatch.batch_index`
+    rizz_sprite_drawdata* (*make_drawdata_instanced_batch)(const rizz_sprite* sprs,
+                                                           int num_sprites,
+                                                           const sx_alloc* alloc);
     void (*free_drawdata)(rizz_sprite_drawdata* data, const sx_alloc* alloc);
 
     // high-level draw calls, normal sprite drawing
-    // internally calls `make_drawdata` and draws with internal shader and buffers
+    // internally calls `make_drawdata_instanced_batch` and draws with internal shader and buffers
+    // quad sprites are drawn instanced, mesh sprites are drawn with vertex/index buffers
     void (*draw)(rizz_sprite spr, const sx_mat4* vp, const sx_mat3* mat, sx_color tint);
     void (*draw_batch)(const rizz_sprite* sprs, int num_sprites, const sx_mat4* vp,
                        const sx_mat3* mats, sx_color* tints);
@@ -209,18 +265,35 @@ typedef struct rizz_api_sprite {
     void (*draw_wireframe)(rizz_sprite spr, const sx_mat4* vp, const sx_mat3* mat);
     bool (*resize_draw_limits)(int max_verts, int max_indices);
 
+    // layers: retained sprite groups with GPU resident instance data
+    // quad sprites are kept in chunks of instances, that are rebuilt and uploaded only when their
+    // sprites change (set_size/set_origin/set_color/set_flip, animation frame), so static layers
+    // cost almost nothing to draw. runs of mesh sprites are drawn with `draw_batch`, in between
+    // the quads. draw order is the order sprites are added, removed slots are reused by next
+    // `layer_add`s
+    // a sprite can be in only one layer
+    rizz_sprite_layer (*layer_create)(int max_sprites);
+    void (*layer_destroy)(rizz_sprite_layer layer);
+    bool (*layer_add)(rizz_sprite_layer layer, rizz_sprite spr, const sx_mat3* mat, sx_color tint);
+    void (*layer_remove)(rizz_sprite_layer layer, rizz_sprite spr);
+    void (*layer_set_transform)(rizz_sprite_layer layer, rizz_sprite spr, const sx_mat3* mat,
+                                sx_color tint);
+    void (*layer_draw)(rizz_sprite_layer layer, const sx_mat4* vp);
+
     // anim-clip
     rizz_sprite_animclip (*animclip_create)(const rizz_sprite_animclip_desc* desc);
     void (*animclip_destroy)(rizz_sprite_animclip clip);
     rizz_sprite_animclip (*animclip_clone)(rizz_sprite_animclip clip);
     
+    // update functions of clips and ctrls are thread-safe, as long as a clip/ctrl (and the clip of
+    // a ctrl) is not updated by more than one thread at a time. events are written to buffers of
+    // the calling thread, see `events`
     void (*animclip_update)(rizz_sprite_animclip clip, float dt);
     void (*animclip_update_batch)(const rizz_sprite_animclip* clips, int num_clips, float dt);
 
     float (*animclip_fps)(rizz_sprite_animclip clip);
     float (*animclip_len)(rizz_sprite_animclip clip);
     rizz_sprite_flip (*animclip_flip)(rizz_sprite_animclip clip);
-    rizz_event_queue* (*animclip_events)(rizz_sprite_animclip clip);
     void (*animclip_set_fps)(rizz_sprite_animclip clip, float fps);
     void (*animclip_set_len)(rizz_sprite_animclip clip, float len); 
     void (*animclip_set_flip)(rizz_sprite_animclip clip, rizz_sprite_flip flip);
@@ -239,7 +312,18 @@ typedef struct rizz_api_sprite {
     float (*animctrl_param_valuef)(rizz_sprite_animctrl ctrl, const char* name);
     int (*animctrl_param_valuei)(rizz_sprite_animctrl ctrl, const char* name);
     void (*animctrl_restart)(rizz_sprite_animctrl ctrl);
-    rizz_event_queue* (*animctrl_events)(rizz_sprite_animctrl ctrl);
+
+    // events of all anim-clips and anim-ctrls that are triggered in the current frame
+    // the stream is cleared on each frame, before the dependent plugins and the game are updated
+    // buffers of all threads are appended to the stream here, in thread order, so events of a
+    // clip/ctrl that is updated by a single thread in the frame are kept in trigger order
+    // not thread-safe: call it from the main thread, after jobs that update clips/ctrls are done
+    const rizz_sprite_event* (*events)(int* num_events);
+
+    // atlas
+    // writes a loaded atlas to binary format (file-system path), binary atlases are loaded
+    // without parsing. json atlases are still supported and detected automatically on load
+    bool (*atlas_save_binary)(rizz_asset atlas, const char* filepath);
 
     // debugging
     void (*show_debugger)(bool* p_open);
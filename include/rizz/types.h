@@ -44,6 +44,7 @@ typedef struct { uint32_t id; } rizz_gfx_stage;
 #define RIZZ_GRAPHICS_API_METAL 0
 #define RIZZ_GRAPHICS_API_GL 0
 #define RIZZ_GRAPHICS_API_GLES 0
+#define RIZZ_GRAPHICS_API_DUMMY 0    // sokol's dummy backend, only used by headless mode
 
 #if SX_PLATFORM_WINDOWS
 #    undef RIZZ_GRAPHICS_API_D3D
@@ -29,8 +29,21 @@ typedef struct rizz_api_vfs {
     rizz_vfs_async_callbacks (*set_async_callbacks)(const rizz_vfs_async_callbacks* cbs);
     bool (*mount)(const char* path, const char* alias);
     void (*mount_mobile_assets)(const char* alias);
+
+    // mounts a remote http directory (http://host[:port]/path) on `alias`
+    // async reads under `alias` are fetched from the url and cached under `cache_dir()/http`
+    // cached files are revalidated with ETag/Last-Modified after `max_age` seconds
+    // (0: revalidate on every read, -1: never revalidate). if the server can't be reached, cached
+    // content is served instead. synchronous `read` only serves the cache and never fetches
+    bool (*mount_remote)(const char* url, const char* alias, int max_age);
     void (*watch_mounts)();
     void (*read_async)(const char* path, rizz_vfs_flags flags, const sx_alloc* alloc);
+
+    // reads `size` bytes from `offset` (size = 0: until end of file), result is reported to
+    // `on_read_complete` like `read_async`. on remote mounts, if the file is not cached, only the
+    // range is fetched (http Range request) and it's not cached
+    void (*read_range_async)(const char* path, int64_t offset, int size, rizz_vfs_flags flags,
+                             const sx_alloc* alloc);
     void (*write_async)(const char* path, sx_mem_block* mem, rizz_vfs_flags flags);
     sx_mem_block* (*read)(const char* path, rizz_vfs_flags flags, const sx_alloc* alloc);
     int (*write)(const char* path, const sx_mem_block* mem, rizz_vfs_flags flags);
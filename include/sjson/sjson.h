@@ -742,7 +742,7 @@ static inline char* sjson__str_begin(sjson_context* ctx, int init_sz)
 
     // find a page that can grow to requested size
     sjson__str_page* spage = ctx->str_pages;
-    while (spage && (spage->offset + init_sz) <= spage->size)
+    while (spage && (spage->offset + init_sz) > spage->size)
         spage = spage->next;
 
     // create a new string page
@@ -787,6 +787,7 @@ static inline char* sjson__str_grow(sjson_context* ctx, int grow_sz)
         sjson__str_page* newspage = sjson__str_page_create(ctx->alloc_user, page_sz);
         sjson_assert(newspage);
         sjson_assert(total_sz <= newspage->size);
+        sjson__str_page_add_list(&ctx->str_pages, newspage);
         char* ptr = sjson__str_page_startptr(newspage);
         newspage->offset += total_sz;
 
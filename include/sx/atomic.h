@@ -56,6 +56,7 @@
 #        pragma intrinsic(_InterlockedDecrement)
 #        pragma intrinsic(_InterlockedExchange)
 #        pragma intrinsic(_InterlockedCompareExchange)
+#        pragma intrinsic(_InterlockedCompareExchange64)
 #        pragma intrinsic(_InterlockedExchangePointer)
 #        pragma intrinsic(_InterlockedCompareExchangePointer)
 #        pragma intrinsic(__rdtsc)
@@ -305,16 +306,17 @@ SX_FORCE_INLINE int64_t sx_atomic_xchg64(sx_atomic_int64* a, int64_t b)
     return __sync_lock_test_and_set(a, b);
 #    endif
 }
+#endif    // SX_ARCH_64BIT
 
+// 64bit CAS is also available on 32bit targets (cmpxchg8b, ldrexd/strexd)
 SX_FORCE_INLINE int64_t sx_atomic_cas64(sx_atomic_int64* a, int64_t xchg, int64_t comparand)
 {
-#    if SX_PLATFORM_WINDOWS
+#if SX_PLATFORM_WINDOWS
     return _InterlockedCompareExchange64(a, xchg, comparand);
-#    else
+#else
     return __sync_val_compare_and_swap(a, comparand, xchg);
-#    endif
+#endif
 }
-#endif    // SX_ARCH_64BIT
 
 #if SX_ARCH_64BIT
 typedef sx_atomic_int64 sx_atomic_size;
@@ -74,6 +74,12 @@
 #    define SX_CONFIG_SIMD_DISABLE 0
 #endif
 
+// NEON backend of simd.h is not implemented yet, so ARM targets use the reference (scalar) backend
+// Defining this to 1 selects the NEON backend, which stops compilation until it is implemented
+#ifndef SX_CONFIG_SIMD_NEON
+#    define SX_CONFIG_SIMD_NEON 0
+#endif
+
 #if defined(_MSC_VER) && 0
 // Macros for stdint.h definitions
 // There are some problems with intellisense+gcc and I had to define these (only works in editor,
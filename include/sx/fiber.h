@@ -21,6 +21,23 @@
 //      sx_fiber_stack          fiber_stack object, must be initialized by 'sx_fiber_stack_init' or
 //                              'sx_fiber_stack_init_ptr'
 //
+//      sx_fiber_stack_pool     pool of fiber stacks that can be shared between job and coroutine
+//                              contexts. reserves virtual memory for all stacks on creation, but
+//                              commits each stack on first use (posix: pages are backed as the
+//                              stack grows). every stack has a guard page below it and stacks are
+//                              reused LIFO, so recently used (warm) stacks are returned first.
+//                              there are two size classes: small and large
+//      sx_fiber_stack_pool_get     gets a stack from the class that fits `size` (thread-safe)
+//      sx_fiber_stack_pool_put     returns the stack to the pool (thread-safe)
+//      sx_fiber_stack_pool_trim    decommits free stacks, except the `keep` most recently used ones
+//                                  job and coroutine contexts trim the pools they own periodically,
+//                                  shared pools must be trimmed by their owner
+//      sx_fiber_stack_pool_usage   high-water mark of a stack's usage in bytes, since it's creation
+//      sx_fiber_stack_pool_get_info pool statistics, includes the peak usage of all stacks
+//                              NOTE: posix: usage is the lowest resident page of stack (mincore)
+//                                    others: usage is measured by scanning untouched (zero) memory,
+//                                    so it's relatively slow and should only be used for debugging
+//
 //      sx_fiber_create         creates a new OS fiber object with already intiaized stack object
 //                              and a fiber callback.
 //                              Returns sx_fiber object that can be switch via 'sx_fiber_switch'
@@ -68,6 +85,7 @@
 //                                  (actual count of running 'invokes')
 //                                  stack_sz is the size of fiber stack is bytes,
 //                                  must be more than sx_os_minstacksz()
+//      sx_coro_create_context_with_pool    same as above, but takes stacks from a shared pool
 //      sx_coro_destroy_context    destroys fiber context
 //
 //  MACROS
@@ -79,8 +97,18 @@
 //      sx_coro_wait               yields the current coroutine and waits for `msecs` milliseconds
 //                                 then gets back to the coroutine
 //      sx_coro_yieldn             yeilds current coroutine and gets back to it after N updates
+//      sx_coro_wait_counter       yields the current coroutine until the counter reaches zero,
+//                                 like the sx_job_t handles of the job dispatcher. coroutines
+//                                 that are resumed in jobs must use this instead of blocking waits
+//      sx_coro_invoke_with_flags  same as sx_coro_invoke, but with sx_coro_flags
 //      sx_coro_update             Updates fiber-context state with a delta-time as input.
 //                                 In the game this should be called on each frame
+//      sx_coro_update_begin       Multi-threaded update, instead of sx_coro_update: collects due
+//                                 coroutines and returns the number that can run on any thread
+//      sx_coro_resume             (Thread-Safe) resumes due coroutine [0..count) of update_begin,
+//                                 usually dispatched as jobs
+//      sx_coro_update_end         Runs due coroutines with SX_CORO_FLAG_MAIN_THREAD and finishes
+//                                 the update, must be called by the thread that calls update_begin
 //      sx_coro_end                Exits the fiber execution and returns to program,
 //                                 This function MUST be called whenever you want to exit the coro
 // Example:
@@ -112,6 +140,7 @@
 #include "macros.h"
 
 #include <stdbool.h>
+#include <stdint.h>
 
 typedef struct sx_alloc sx_alloc;
 
@@ -131,19 +160,56 @@ typedef struct sx_fiber_stack {
 
 typedef void(sx_fiber_cb)(sx_fiber_transfer transfer);
 
+typedef struct sx_fiber_stack_pool sx_fiber_stack_pool;
+
+typedef struct sx_fiber_stack_pool_desc {
+    int small_stack_sz;    // stack size of small class in bytes, 0 disables the class
+    int max_small;         // maximum number of small stacks
+    int large_stack_sz;    // stack size of large class in bytes, must be more than small_stack_sz
+    int max_large;         // maximum number of large stacks
+} sx_fiber_stack_pool_desc;
+
+typedef struct sx_fiber_stack_pool_class_info {
+    int stack_sz;
+    int max_stacks;
+    int num_used;            // stacks that are currently taken from the pool
+    int num_committed;       // stacks that have committed memory (used + cached)
+    int64_t committed_sz;    // memory backed for the committed stacks (touched pages on posix)
+    int peak_usage;          // maximum high-water mark of all stacks in bytes
+} sx_fiber_stack_pool_class_info;
+
+typedef struct sx_fiber_stack_pool_info {
+    sx_fiber_stack_pool_class_info small;
+    sx_fiber_stack_pool_class_info large;
+} sx_fiber_stack_pool_info;
+
 // High level context API
 typedef struct sx_coro_context sx_coro_context;
 
+typedef enum sx_coro_flags_ {
+    SX_CORO_FLAG_MAIN_THREAD = 0x1    // always resumed by the updating thread (sx_coro_update_end)
+} sx_coro_flags_;
+typedef uint32_t sx_coro_flags;
+
 SX_API sx_coro_context* sx_coro_create_context(const sx_alloc* alloc, int max_fibers, int stack_sz);
+SX_API sx_coro_context* sx_coro_create_context_with_pool(const sx_alloc* alloc, int max_fibers,
+                                                         int stack_sz, sx_fiber_stack_pool* pool);
 SX_API void sx_coro_destroy_context(sx_coro_context* ctx, const sx_alloc* alloc);
 SX_API void sx_coro_update(sx_coro_context* ctx, float dt);
+SX_API int sx_coro_update_begin(sx_coro_context* ctx, float dt);
+SX_API void sx_coro_resume(sx_coro_context* ctx, int index);
+SX_API void sx_coro_update_end(sx_coro_context* ctx);
 SX_API bool sx_coro_replace_callback(sx_coro_context* ctx, sx_fiber_cb* callback,
                                      sx_fiber_cb* new_callback);
 
 SX_API void sx__coro_invoke(sx_coro_context* ctx, sx_fiber_cb* callback, void* user);
+SX_API void sx__coro_invoke_with_flags(sx_coro_context* ctx, sx_fiber_cb* callback, void* user,
+                                       sx_coro_flags flags);
 SX_API void sx__coro_end(sx_coro_context* ctx, sx_fiber_t* pfrom);
 SX_API void sx__coro_wait(sx_coro_context* ctx, sx_fiber_t* pfrom, int msecs);
 SX_API void sx__coro_yield(sx_coro_context* ctx, sx_fiber_t* pfrom, int nupdates sx_default(1));
+SX_API void sx__coro_wait_counter(sx_coro_context* ctx, sx_fiber_t* pfrom,
+                                  volatile int* counter);
 
 // coroutines macros (use these instead of above sx__coro functions)
 #define sx_coro_declare(_name) static void coro__##_name(sx_fiber_transfer __transfer)
@@ -153,11 +219,24 @@ SX_API void sx__coro_yield(sx_coro_context* ctx, sx_fiber_t* pfrom, int nupdates
 #define sx_coro_yield(_ctx) sx__coro_yield((_ctx), &__transfer.from, 1)
 #define sx_coro_yieldn(_ctx, _n) sx__coro_yield((_ctx), &__transfer.from, (_n))
 #define sx_coro_invoke(_ctx, _name, _user) sx__coro_invoke((_ctx), coro__##_name, (_user))
+#define sx_coro_invoke_with_flags(_ctx, _name, _user, _flags) \
+    sx__coro_invoke_with_flags((_ctx), coro__##_name, (_user), (_flags))
+#define sx_coro_wait_counter(_ctx, _counter) \
+    sx__coro_wait_counter((_ctx), &__transfer.from, (_counter))
 
 // Low-level functions
 SX_API bool sx_fiber_stack_init(sx_fiber_stack* fstack, unsigned int size sx_default(0));
 SX_API void sx_fiber_stack_init_ptr(sx_fiber_stack* fstack, void* ptr, unsigned int size);
 SX_API void sx_fiber_stack_release(sx_fiber_stack* fstack);
 
+SX_API sx_fiber_stack_pool* sx_fiber_stack_pool_create(const sx_alloc* alloc,
+                                                        const sx_fiber_stack_pool_desc* desc);
+SX_API void sx_fiber_stack_pool_destroy(sx_fiber_stack_pool* pool, const sx_alloc* alloc);
+SX_API bool sx_fiber_stack_pool_get(sx_fiber_stack_pool* pool, int size, sx_fiber_stack* fstack);
+SX_API void sx_fiber_stack_pool_put(sx_fiber_stack_pool* pool, sx_fiber_stack* fstack);
+SX_API void sx_fiber_stack_pool_trim(sx_fiber_stack_pool* pool, int keep);
+SX_API int sx_fiber_stack_pool_usage(sx_fiber_stack_pool* pool, const sx_fiber_stack* fstack);
+SX_API void sx_fiber_stack_pool_get_info(sx_fiber_stack_pool* pool, sx_fiber_stack_pool_info* info);
+
 SX_API sx_fiber_t sx_fiber_create(const sx_fiber_stack stack, sx_fiber_cb* fiber_cb);
 SX_API sx_fiber_transfer sx_fiber_switch(const sx_fiber_t to, void* user);
@@ -38,6 +38,28 @@
 //          sx_handle_gen               use this macro to fetch generation from the handle. Mainly
 //                                      for debugging purposes
 //
+//  sx_handle_pool_mt: Thread-safe variant of sx_handle_pool, same index/generation encoding
+//                  new/del can be called from any thread, validation is wait-free
+//                  Free slots are kept in a lock-free stack, the head is tagged with a 32bit
+//                  counter next to the slot index (64bit CAS) to avoid ABA problems
+//                  Slots are allocated in fixed-size blocks that never move, so growing does not
+//                  invalidate anything that is being read by other threads. Data arrays indexed
+//                  by these handles should either be pre-allocated for `max_capacity` or be paged
+//                  with the same block size (sx_handle_block_size_mt)
+//                  There is no dense array, iterate over [0..sx_handle_num_slots_mt] instead and
+//                  skip the dead slots (sx_handle_at_mt returns SX_INVALID_HANDLE for them)
+//          sx_handle_create_pool_mt    create the pool, `capacity` is the initial capacity and is
+//                                      also used as the block size (rounded up to power-of-two)
+//          sx_handle_destroy_pool_mt   destroy handle pool, no other thread should be using it
+//          sx_handle_new_mt            returns a new handle, grows the pool if needed
+//                                      returns SX_INVALID_HANDLE if index bits are exhausted
+//          sx_handle_del_mt            deletes the handle and puts it back to the pool
+//          sx_handle_valid_mt          checks if handle is alive (wait-free)
+//          sx_handle_at_mt             returns the alive handle of the slot, or SX_INVALID_HANDLE
+//          sx_handle_count_mt          number of alive handles (snapshot)
+//          sx_handle_num_slots_mt      number of slots ever handed out, upper bound for iteration
+//          sx_handle_block_size_mt     number of slots in each block
+//
 //  CAUTION: In case you have to grow the handle-pool, make sure NOT to have multiple pointers
 //           to the pool object.
 //           Because on grow, it may change the pointer to the handle_pool itself and
@@ -69,6 +91,7 @@
 #pragma once
 
 #include "sx.h"
+#include "atomic.h"
 
 typedef struct sx_alloc sx_alloc;
 
@@ -158,3 +181,61 @@ static inline bool sx_handle_full(const sx_handle_pool* pool)
 
 #define sx_handle_new_and_grow(_pool, _alloc) \
     (sx_handle_full(_pool) ? sx_handle_grow_pool(&(_pool), _alloc) : 0, sx_handle_new(_pool))
+
+typedef struct sx_handle_pool_mt_slot {
+    sx_handle_t volatile handle;    // alive handle, SX_INVALID_HANDLE if the slot is free
+    int volatile next;              // free-list link
+    int gen;
+} sx_handle_pool_mt_slot;
+
+typedef struct sx_handle_pool_mt {
+    sx_atomic_int64 free_head;    // (ABA tag << 32) | index of the first free slot
+    sx_atomic_int num_slots;      // slots that are ever handed out, upper bound for iteration
+    sx_atomic_int count;
+    int block_shift;
+    int block_mask;
+    int max_blocks;
+    sx_lock_t grow_lk;
+    const sx_alloc* alloc;
+    sx_handle_pool_mt_slot* volatile* blocks;    // [max_blocks], blocks are never moved
+} sx_handle_pool_mt;
+
+SX_API sx_handle_pool_mt* sx_handle_create_pool_mt(const sx_alloc* alloc, int capacity);
+SX_API void sx_handle_destroy_pool_mt(sx_handle_pool_mt* pool);
+SX_API sx_handle_t sx_handle_new_mt(sx_handle_pool_mt* pool);
+SX_API void sx_handle_del_mt(sx_handle_pool_mt* pool, sx_handle_t handle);
+
+static inline sx_handle_pool_mt_slot* sx__handle_slot_mt(const sx_handle_pool_mt* pool, int index)
+{
+    int block = index >> pool->block_shift;
+    sx_handle_pool_mt_slot* slots = block < pool->max_blocks ? pool->blocks[block] : NULL;
+    return slots ? &slots[index & pool->block_mask] : NULL;
+}
+
+static inline int sx_handle_count_mt(const sx_handle_pool_mt* pool)
+{
+    return pool->count;
+}
+
+static inline int sx_handle_num_slots_mt(const sx_handle_pool_mt* pool)
+{
+    return pool->num_slots;
+}
+
+static inline int sx_handle_block_size_mt(const sx_handle_pool_mt* pool)
+{
+    return pool->block_mask + 1;
+}
+
+static inline bool sx_handle_valid_mt(const sx_handle_pool_mt* pool, sx_handle_t handle)
+{
+    sx_assert(handle);
+    const sx_handle_pool_mt_slot* slot = sx__handle_slot_mt(pool, sx_handle_index(handle));
+    return slot && slot->handle == handle;
+}
+
+static inline sx_handle_t sx_handle_at_mt(const sx_handle_pool_mt* pool, int index)
+{
+    const sx_handle_pool_mt_slot* slot = sx__handle_slot_mt(pool, index);
+    return slot ? slot->handle : SX_INVALID_HANDLE;
+}
@@ -100,6 +100,7 @@
 #include <stdbool.h>
 
 typedef struct sx_alloc sx_alloc;
+typedef struct sx_fiber_stack_pool sx_fiber_stack_pool;
 typedef struct sx_job_context sx_job_context;
 typedef volatile int* sx_job_t;
 
@@ -126,6 +127,8 @@ typedef struct sx_job_context_desc {
     sx_job_thread_shutdown_cb* thread_shutdown_cb;    // callback functions that will be called on
                                                       // the shutdown of each worker thread
     void* thread_user_data;    // user-data to be passed to callback functions above
+    sx_fiber_stack_pool* stack_pool;    // optional: take fiber stacks from a shared pool, the pool
+                                        // must fit `max_fibers` stacks of `fiber_stack_sz`
 } sx_job_context_desc;
 
 SX_API sx_job_context* sx_job_create_context(const sx_alloc* alloc,
@@ -21,4 +21,46 @@ SX_API bool sx_queue_spsc_full(const sx_queue_spsc* queue);
             sx_queue_spsc_produce((_queue), (_data));         \
     }
 
+// multi-producer / multi-consumer
+// bounded: capacity is rounded up to power-of-two and can not grow
+// Reference: http://www.1024cores.net/home/lock-free-algorithms/queues/bounded-mpmc-queue
+typedef struct sx_queue_mpmc sx_queue_mpmc;
+SX_API sx_queue_mpmc* sx_queue_mpmc_create(const sx_alloc* alloc, int item_sz, int capacity);
+SX_API void sx_queue_mpmc_destroy(sx_queue_mpmc* queue, const sx_alloc* alloc);
 
+SX_API bool sx_queue_mpmc_produce(sx_queue_mpmc* queue, const void* data);
+SX_API bool sx_queue_mpmc_consume(sx_queue_mpmc* queue, void* data);
+SX_API bool sx_queue_mpmc_full(const sx_queue_mpmc* queue);
+
+// batch versions: 'data' is an array of items, returns the number of items produced/consumed
+// the whole batch is claimed with a single CAS, so it may be less than requested if the queue is
+// (nearly) full/empty or other threads are in the middle of producing/consuming
+SX_API int sx_queue_mpmc_produce_batch(sx_queue_mpmc* queue, const void* data, int count);
+SX_API int sx_queue_mpmc_consume_batch(sx_queue_mpmc* queue, void* data, int max_count);
+
+// multi-producer / single-consumer
+// unbounded and intrusive: embed sx_queue_mpsc_node in your own data and get it back with
+// sx_queue_mpsc_data. queue does not allocate anything after creation and never fails to produce
+// nodes must stay valid until they are consumed
+// Reference:
+// http://www.1024cores.net/home/lock-free-algorithms/queues/intrusive-mpsc-node-based-queue
+typedef struct sx_queue_mpsc_node {
+    struct sx_queue_mpsc_node* volatile next;
+} sx_queue_mpsc_node;
+
+typedef struct sx_queue_mpsc sx_queue_mpsc;
+SX_API sx_queue_mpsc* sx_queue_mpsc_create(const sx_alloc* alloc);
+SX_API void sx_queue_mpsc_destroy(sx_queue_mpsc* queue, const sx_alloc* alloc);
+
+SX_API void sx_queue_mpsc_produce(sx_queue_mpsc* queue, sx_queue_mpsc_node* node);
+SX_API sx_queue_mpsc_node* sx_queue_mpsc_consume(sx_queue_mpsc* queue);
+
+// batch versions: batch produce links the nodes together and pushes them with one atomic op
+//                 batch consume walks the list and moves the tail once
+SX_API void sx_queue_mpsc_produce_batch(sx_queue_mpsc* queue, sx_queue_mpsc_node** nodes,
+                                        int count);
+SX_API int sx_queue_mpsc_consume_batch(sx_queue_mpsc* queue, sx_queue_mpsc_node** nodes,
+                                       int max_count);
+
+#define sx_queue_mpsc_data(_node, _type, _member) \
+    ((_type*)((uint8_t*)(_node) - offsetof(_type, _member)))
@@ -254,6 +254,29 @@ SX_API sx_mat3 sx_mat3_mul(const sx_mat3* _a, const sx_mat3* _b);
 
 SX_API sx_mat4 sx_quat_mat4(const sx_quat quat);
 
+// batch (array) kernels: SSE2/AVX2 (selected at runtime) or NEON, with scalar fallbacks
+// dst can be the same array as the source (in-place), but must not partially overlap it
+SX_API void sx_mat4_mul_batch(sx_mat4* dst, const sx_mat4* a, const sx_mat4* b, int count);
+SX_API void sx_mat4_mul_vec3_batch(sx_vec3* dst, const sx_mat4* mat, const sx_vec3* src,
+                                   int count);
+SX_API void sx_mat3_mul_vec2_batch(sx_vec2* dst, const sx_mat3* mat, const sx_vec2* src,
+                                   int count);
+SX_API sx_aabb sx_aabb_transform(const sx_aabb* box, const sx_mat4* mat);
+SX_API void sx_aabb_transform_batch(sx_aabb* dst, const sx_mat4* mat, const sx_aabb* src,
+                                    int count);
+SX_API void sx_quat_mat4_batch(sx_mat4* dst, const sx_quat* src, int count);
+SX_API const char* sx_math_batch_backend(void);
+
+// 2x2 box filter of RGBA texel rows (mip generation), SSE2 or NEON with a scalar tail
+// dst[x] = rounded average of the 2x2 texels of rows r0/r1 under it. r1 can be r0 (single row
+// source), odd and 1 texel source widths are clamped to the last texel
+// dst can be in the same buffer as the sources, if it starts at or before them (in-place
+// downsampling). 16bit texels must be 14bit or less, so the sum of four doesn't overflow
+SX_API void sx_rgba8_box_batch(uint8_t* dst, const uint8_t* r0, const uint8_t* r1, int dst_w,
+                               int src_w);
+SX_API void sx_rgba16_box_batch(uint16_t* dst, const uint16_t* r0, const uint16_t* r1, int dst_w,
+                                int src_w);
+
 SX_API void sx_color_RGBtoHSV(float _hsv[3], const float _rgb[3]);
 SX_API void sx_color_HSVtoRGB(float _rgb[3], const float _hsv[3]);
 
@@ -22,7 +22,7 @@
 #        include <xmmintrin.h>    // __m128
 #        undef SX_SIMD_SSE
 #        define SX_SIMD_SSE 1
-#    elif defined(__ARM_NEON__)
+#    elif defined(__ARM_NEON__) && SX_CONFIG_SIMD_NEON    // see config.h
 #        include <arm_neon.h>
 #        undef SX_SIMD_NEON
 #        define SX_SIMD_NEON 1
@@ -347,7 +347,7 @@ SX_SIMD_INLINE sx_simd_t sx_simd_xor(sx_simd_t _a, sx_simd_t _b)
 // Neon
 typedef float32x4_t sx_simd_t;
 
-#    error "TODO"
+#    error "NEON backend is not implemented, set SX_CONFIG_SIMD_NEON=0 to use the reference backend"
 
 #else
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -10,6 +10,7 @@
 //
 //      sx_thread       Portable thread
 //      sx_tls          Portable thread-local-storage which you can store a user_data per Tls
+//                      sx_tls_create returns NULL on failure
 //      sx_mutex        Portable OS mutex, use for long-time data locks, for short-time locks use
 //                      sx_lock_t in atomics.h
 //      sx_sem          Portable OS semaphore. 'post' increases the count. 'wait' waits on semaphore
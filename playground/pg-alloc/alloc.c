@@ -0,0 +1,255 @@
+//
+// heap allocator benchmark: allocation throughput of libc (proxy) heap and thread-caching TLSF
+// heaps (rizz_config.heap_tlsf_mask) with 1, 2, 4 and N (number of cores) threads. quits by itself
+//
+//      rizz --run pg-alloc --headless
+//
+//  - local: every thread allocates and frees it's own blocks, random sizes in a window of live
+//           blocks (mostly small, some up to 16kb)
+//  - remote: every thread allocates a batch and the next thread frees it, so the TLSF heaps go
+//            through their remote free lists (batches are big, so the barriers between them
+//            don't dominate when there are more threads than cores)
+//  - every block is tagged on allocation and checked before it is freed
+// RIZZ_MEMID_GAME uses TLSF heaps and RIZZ_MEMID_OTHER uses libc, the memory profiler samples
+// very rarely (debug builds), so the numbers are close to the heaps themselves
+//
+#include "sx/allocator.h"
+#include "sx/atomic.h"
+#include "sx/os.h"
+#include "sx/string.h"
+#include "sx/threads.h"
+#include "sx/timer.h"
+
+#include "rizz/app.h"
+#include "rizz/core.h"
+#include "rizz/entry.h"
+#include "rizz/plugin.h"
+
+#include <stdio.h>
+
+#define WINDOW_SIZE 256      // live blocks per thread (local)
+#define NUM_OPS 200000       // alloc+free pairs per thread (local)
+#define BATCH_SIZE 8192      // blocks per thread in each round (remote)
+#define NUM_ROUNDS 25        // rounds per thread (remote)
+#define NUM_RUNS 3
+#define MAX_THREADS 64
+
+RIZZ_STATE static rizz_api_core* the_core;
+RIZZ_STATE static rizz_api_app* the_app;
+
+typedef struct alloc_bench {
+    const sx_alloc* alloc;
+    int num_threads;
+    bool remote;
+    void** blocks;    // [num_threads][BATCH_SIZE]
+    sx_atomic_int barrier;
+    sx_atomic_int num_errors;
+} alloc_bench;
+
+typedef struct thread_data {
+    alloc_bench* bench;
+    int index;
+} thread_data;
+
+static inline uint32_t rand_next(uint32_t* seed)
+{
+    *seed = *seed * 1664525u + 1013904223u;
+    return *seed >> 8;
+}
+
+static inline size_t rand_size(uint32_t* seed)
+{
+    uint32_t r = rand_next(seed);
+    return (r & 15) == 0 ? (size_t)(16 + (r >> 4) % 16384) : (size_t)(16 + (r >> 4) % 1024);
+}
+
+static inline void* alloc_block(const sx_alloc* alloc, size_t size, uint32_t tag)
+{
+    uint32_t* p = sx_malloc(alloc, size);
+    if (p)
+        p[0] = tag;
+    return p;
+}
+
+static inline void free_block(alloc_bench* b, void* p, uint32_t tag)
+{
+    if (p && *(uint32_t*)p != tag)
+        sx_atomic_incr(&b->num_errors);
+    sx_free(b->alloc, p);
+}
+
+// spins until all threads have arrived at barrier number `n` (1-based)
+static void barrier_wait(alloc_bench* b, int n)
+{
+    sx_atomic_incr(&b->barrier);
+    while (b->barrier < n * b->num_threads)
+        sx_thread_yield();
+}
+
+static int bench_local_cb(void* user_data1, void* user_data2)
+{
+    sx_unused(user_data2);
+    thread_data* td = user_data1;
+    alloc_bench* b = td->bench;
+    void** blocks = &b->blocks[td->index * BATCH_SIZE];
+    uint32_t seed = (uint32_t)td->index + 1;
+
+    for (int i = 0; i < NUM_OPS; i++) {
+        int slot = (int)(rand_next(&seed) % WINDOW_SIZE);
+        free_block(b, blocks[slot], (uint32_t)slot);
+        blocks[slot] = alloc_block(b->alloc, rand_size(&seed), (uint32_t)slot);
+    }
+    for (int i = 0; i < WINDOW_SIZE; i++) {
+        free_block(b, blocks[i], (uint32_t)i);
+        blocks[i] = NULL;
+    }
+
+    the_core->thread_exit();
+    return 0;
+}
+
+static int bench_remote_cb(void* user_data1, void* user_data2)
+{
+    sx_unused(user_data2);
+    thread_data* td = user_data1;
+    alloc_bench* b = td->bench;
+    void** blocks = &b->blocks[td->index * BATCH_SIZE];
+    void** next_blocks = &b->blocks[((td->index + 1) % b->num_threads) * BATCH_SIZE];
+    uint32_t seed = (uint32_t)td->index + 1;
+
+    for (int r = 0; r < NUM_ROUNDS; r++) {
+        for (int i = 0; i < BATCH_SIZE; i++)
+            blocks[i] = alloc_block(b->alloc, rand_size(&seed), (uint32_t)i);
+        barrier_wait(b, r * 2 + 1);
+
+        for (int i = 0; i < BATCH_SIZE; i++)
+            free_block(b, next_blocks[i], (uint32_t)i);
+        barrier_wait(b, r * 2 + 2);
+    }
+
+    the_core->thread_exit();
+    return 0;
+}
+
+// returns alloc+free pairs per second, or negative value on failure
+static double bench_alloc(const sx_alloc* alloc, int num_threads, bool remote)
+{
+    const sx_alloc* heap = the_core->heap_alloc();
+    alloc_bench b = { .alloc = alloc, .num_threads = num_threads, .remote = remote };
+    b.blocks = sx_malloc(heap, sizeof(void*) * BATCH_SIZE * num_threads);
+    if (!b.blocks)
+        return -1.0;
+    sx_memset(b.blocks, 0x0, sizeof(void*) * BATCH_SIZE * num_threads);
+
+    thread_data tds[MAX_THREADS];
+    sx_thread* thrds[MAX_THREADS];
+    uint64_t start = sx_tm_now();
+    for (int i = 0; i < num_threads; i++) {
+        tds[i] = (thread_data){ .bench = &b, .index = i };
+        thrds[i] = sx_thread_create(heap, remote ? bench_remote_cb : bench_local_cb, &tds[i], 0,
+                                    "alloc", NULL);
+    }
+    int num_failed = 0;
+    for (int i = 0; i < num_threads; i++)
+        num_failed += (!thrds[i] || sx_thread_destroy(thrds[i], heap) != 0) ? 1 : 0;
+    double elapsed = sx_tm_sec(sx_tm_since(start));
+
+    sx_free(heap, b.blocks);
+    if (num_failed || b.num_errors)
+        return -1.0;
+    int64_t num_ops = remote ? (int64_t)NUM_ROUNDS * BATCH_SIZE : NUM_OPS;
+    return (double)(num_ops * num_threads) / elapsed;
+}
+
+static int run_benchmarks()
+{
+    int thread_counts[4] = { 1, 2, 4, sx_clamp(sx_os_numcores(), 1, MAX_THREADS) };
+    int num_counts = thread_counts[3] > 4 ? 4 : 3;
+
+    struct {
+        const char* name;
+        rizz_mem_id mem_id;
+        bool remote;
+    } tests[] = { { "libc, local", RIZZ_MEMID_OTHER, false },
+                  { "tlsf, local", RIZZ_MEMID_GAME, false },
+                  { "libc, remote", RIZZ_MEMID_OTHER, true },
+                  { "tlsf, remote", RIZZ_MEMID_GAME, true } };
+
+    // rows are printed as a whole, so they don't mix with the log output
+    char row[256];
+    int len = sx_snprintf(row, sizeof(row), "%-14s", "M alloc+free/s");
+    for (int c = 0; c < num_counts; c++)
+        len += sx_snprintf(row + len, sizeof(row) - len, "  %6d thrd", thread_counts[c]);
+    printf("local: %d blocks x %d ops, remote: %d blocks x %d rounds, best of %d runs\n%s\n",
+           WINDOW_SIZE, NUM_OPS, BATCH_SIZE, NUM_ROUNDS, NUM_RUNS, row);
+
+    int num_failed = 0;
+    for (int i = 0; i < (int)(sizeof(tests) / sizeof(tests[0])); i++) {
+        len = sx_snprintf(row, sizeof(row), "%-14s", tests[i].name);
+        for (int c = 0; c < num_counts; c++) {
+            double best = 0;
+            for (int r = 0; r < NUM_RUNS && best >= 0; r++) {
+                double ops = bench_alloc(the_core->alloc(tests[i].mem_id), thread_counts[c],
+                                         tests[i].remote);
+                best = ops < 0 ? -1.0 : sx_max(best, ops);
+            }
+            if (best < 0) {
+                len += sx_snprintf(row + len, sizeof(row) - len, "  %11s", "FAILED");
+                ++num_failed;
+            } else {
+                len += sx_snprintf(row + len, sizeof(row) - len, "  %11.2f", best / 1000000.0);
+            }
+        }
+        puts(row);
+    }
+
+    return num_failed;
+}
+
+rizz_plugin_decl_main(alloc, plugin, e)
+{
+    switch (e) {
+    case RIZZ_PLUGIN_EVENT_STEP:
+        the_app->quit();
+        break;
+
+    case RIZZ_PLUGIN_EVENT_INIT: {
+        the_core = plugin->api->get_api(RIZZ_API_CORE, 0);
+        the_app = plugin->api->get_api(RIZZ_API_APP, 0);
+        int num_failed = run_benchmarks();
+        if (num_failed == 0) {
+            puts("pg-alloc: all tests passed");
+        } else {
+            rizz_log_error(the_core, "pg-alloc: %d tests failed", num_failed);
+        }
+        break;
+    }
+
+    case RIZZ_PLUGIN_EVENT_LOAD:
+        break;
+
+    case RIZZ_PLUGIN_EVENT_UNLOAD:
+        break;
+
+    case RIZZ_PLUGIN_EVENT_SHUTDOWN:
+        break;
+    }
+
+    return 0;
+}
+
+rizz_plugin_decl_event_handler(alloc, e)
+{
+    sx_unused(e);
+}
+
+rizz_game_decl_config(conf)
+{
+    conf->app_name = "pg-alloc";
+    conf->app_version = 1000;
+    conf->app_title = "pg-alloc";
+    conf->app_flags |= RIZZ_APP_FLAG_HEADLESS;
+    conf->core_flags |= RIZZ_CORE_FLAG_VERBOSE;
+    conf->heap_tlsf_mask = 1u << RIZZ_MEMID_GAME;
+    conf->mem_sample_rate = 1000000;
+}
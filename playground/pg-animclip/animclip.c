@@ -0,0 +1,269 @@
+//
+// anim-clip update benchmark: clips per millisecond of rizz_api_sprite.animclip_update (one clip at
+// a time) and animclip_update_batch (SoA/SIMD kernel), inline and dispatched to jobs. quits by
+// itself
+//
+//      rizz --run pg-animclip --headless
+//
+//  - small sets are updated inline, sets of ANIMCLIP_JOB_THRESHOLD clips or more are split
+//    between job threads (sprite.c)
+//  - updates run for a number of frames, because the event stream is cleared on each frame
+//  - clips of each test are created before it starts and destroyed after it ends, sprite handle
+//    pools can't grow beyond 32k clips
+//  - every clip triggers a frame event and an end event, one-by-one and batch updates of the same
+//    clips with the same delta-times must trigger the same number of events
+//  - clips are also updated one-by-one from jobs of the game, events are written concurrently
+//
+#include "sx/allocator.h"
+#include "sx/os.h"
+#include "sx/string.h"
+#include "sx/timer.h"
+
+#include "rizz/app.h"
+#include "rizz/asset.h"
+#include "rizz/core.h"
+#include "rizz/entry.h"
+#include "rizz/plugin.h"
+#include "rizz/sprite.h"
+#include "rizz/vfs.h"
+
+#include <stdio.h>
+
+#define NUM_FRAMES 20
+#define UPDATES_PER_FRAME 10
+#define SMALL_BATCH 1024
+#define LARGE_BATCH 16384    // larger than ANIMCLIP_JOB_THRESHOLD of sprite.c
+#define DT (1.0f / 60.0f)
+#define NUM_TESTS 5
+
+RIZZ_STATE static rizz_api_core* the_core;
+RIZZ_STATE static rizz_api_app* the_app;
+RIZZ_STATE static rizz_api_asset* the_asset;
+RIZZ_STATE static rizz_api_vfs* the_vfs;
+RIZZ_STATE static rizz_api_sprite* the_sprite;
+
+typedef struct animclip_test {
+    const char* name;
+    int num_clips;
+    bool batch;
+    bool jobs;    // one-by-one updates from jobs of the game
+    rizz_sprite_animclip* clips;
+    double elapsed;
+    int64_t num_events;
+} animclip_test;
+
+typedef struct animclip_bench {
+    rizz_asset atlas;
+    animclip_test tests[NUM_TESTS];
+    int cur_test;
+    int cur_frame;
+    int num_failed;
+} animclip_bench;
+
+RIZZ_STATE static animclip_bench g_bench;
+
+static const rizz_sprite_animclip_frame_desc k_walk_frames[] = {
+    { .name = "test/boy_motion_walk_000.png" },
+    { .name = "test/boy_motion_walk_001.png" },
+    { .name = "test/boy_motion_walk_002.png" },
+    { .name = "test/boy_motion_walk_003.png", .event = 1, .trigger_event = true },
+    { .name = "test/boy_motion_walk_004.png" },
+    { .name = "test/boy_motion_walk_005.png" },
+    { .name = "test/boy_motion_walk_006.png" }
+};
+
+static bool create_clips(animclip_test* t)
+{
+    t->clips = sx_malloc(the_core->heap_alloc(), sizeof(rizz_sprite_animclip) * t->num_clips);
+    if (!t->clips)
+        return false;
+    sx_memset(t->clips, 0x0, sizeof(rizz_sprite_animclip) * t->num_clips);
+
+    // clips have different speeds, so they end and trigger events on different updates
+    for (int i = 0; i < t->num_clips; i++) {
+        t->clips[i] = the_sprite->animclip_create(&(rizz_sprite_animclip_desc){
+            .atlas = g_bench.atlas,
+            .frames = k_walk_frames,
+            .num_frames = sizeof(k_walk_frames) / sizeof(rizz_sprite_animclip_frame_desc),
+            .fps = 8.0f + (float)(i % 17),
+            .trigger_end_event = true,
+            .end_event = 2 });
+        if (!t->clips[i].id)
+            return false;
+    }
+    return true;
+}
+
+static void destroy_clips(animclip_test* t)
+{
+    if (!t->clips)
+        return;
+    for (int i = 0; i < t->num_clips; i++) {
+        if (t->clips[i].id)
+            the_sprite->animclip_destroy(t->clips[i]);
+    }
+    sx_free(the_core->heap_alloc(), t->clips);
+    t->clips = NULL;
+}
+
+static bool init_benchmark()
+{
+    char asset_dir[RIZZ_MAX_PATH];
+    sx_os_path_join(asset_dir, sizeof(asset_dir), EXAMPLES_ROOT, "assets");
+    the_vfs->mount(asset_dir, "/assets");
+
+    rizz_atlas_load_params aparams = { .min_filter = SG_FILTER_LINEAR,
+                                       .mag_filter = SG_FILTER_LINEAR };
+    g_bench.atlas = the_asset->load("atlas", "/assets/textures/boy.json", &aparams,
+                                    RIZZ_ASSET_LOAD_FLAG_WAIT_ON_LOAD, NULL, 0);
+    if (the_asset->state(g_bench.atlas) != RIZZ_ASSET_STATE_OK) {
+        rizz_log_error(the_core, "pg-animclip: loading atlas failed");
+        return false;
+    }
+
+    g_bench.tests[0] = (animclip_test){ .name = "single", .num_clips = SMALL_BATCH };
+    g_bench.tests[1] = (animclip_test){ .name = "batch", .num_clips = SMALL_BATCH, .batch = true };
+    g_bench.tests[2] = (animclip_test){ .name = "single", .num_clips = LARGE_BATCH };
+    g_bench.tests[3] = (animclip_test){ .name = "batch (jobs)",
+                                        .num_clips = LARGE_BATCH,
+                                        .batch = true };
+    g_bench.tests[4] = (animclip_test){ .name = "single (jobs)",
+                                        .num_clips = LARGE_BATCH,
+                                        .jobs = true };
+    printf("%d updates (dt: %.1f ms) in %d frames, %d frames/clip\n",
+           NUM_FRAMES * UPDATES_PER_FRAME, DT * 1000.0f, NUM_FRAMES,
+           (int)(sizeof(k_walk_frames) / sizeof(rizz_sprite_animclip_frame_desc)));
+    return true;
+}
+
+static void report()
+{
+    // rows are printed as a whole, so they don't mix with the log output
+    char row[128];
+    for (int i = 0; i < NUM_TESTS; i++) {
+        const animclip_test* t = &g_bench.tests[i];
+        double num_updates = (double)t->num_clips * NUM_FRAMES * UPDATES_PER_FRAME;
+        sx_snprintf(row, sizeof(row), "%-13s %6d clips  %10.0f clips/ms  %8d events", t->name,
+                    t->num_clips, num_updates / (t->elapsed * 1000.0), (int)t->num_events);
+        puts(row);
+    }
+
+    // compare with the first test of the same number of clips
+    for (int i = 1; i < NUM_TESTS; i++) {
+        const animclip_test* t = &g_bench.tests[i];
+        const animclip_test* ref = g_bench.tests;
+        while (ref->num_clips != t->num_clips)
+            ++ref;
+        if (ref != t && ref->num_events != t->num_events) {
+            rizz_log_error(the_core, "pg-animclip: %d clips: '%s' triggered %d events, not %d",
+                           t->num_clips, t->name, (int)t->num_events, (int)ref->num_events);
+            ++g_bench.num_failed;
+        }
+    }
+}
+
+static void update_job_cb(int start, int end, int thrd_index, void* user)
+{
+    sx_unused(thrd_index);
+    const rizz_sprite_animclip* clips = user;
+    for (int i = start; i < end; i++)
+        the_sprite->animclip_update(clips[i], DT);
+}
+
+// runs updates of the current test, events of them are in the stream until the next frame
+static void step_benchmark()
+{
+    animclip_test* t = &g_bench.tests[g_bench.cur_test];
+    if (!t->clips && !create_clips(t)) {
+        rizz_log_error(the_core, "pg-animclip: creating clips failed");
+        ++g_bench.num_failed;
+        return;
+    }
+
+    uint64_t start = sx_tm_now();
+    for (int u = 0; u < UPDATES_PER_FRAME; u++) {
+        if (t->batch) {
+            the_sprite->animclip_update_batch(t->clips, t->num_clips, DT);
+        } else if (t->jobs) {
+            sx_job_t job = the_core->job_dispatch(t->num_clips, update_job_cb, t->clips,
+                                                  SX_JOB_PRIORITY_HIGH, 0);
+            the_core->job_wait_and_del(job);
+        } else {
+            for (int i = 0; i < t->num_clips; i++)
+                the_sprite->animclip_update(t->clips[i], DT);
+        }
+    }
+    t->elapsed += sx_tm_sec(sx_tm_since(start));
+
+    int num_events;
+    the_sprite->events(&num_events);
+    t->num_events += num_events;
+
+    if (++g_bench.cur_frame == NUM_FRAMES) {
+        g_bench.cur_frame = 0;
+        ++g_bench.cur_test;
+        destroy_clips(t);
+    }
+}
+
+rizz_plugin_decl_main(animclip, plugin, e)
+{
+    switch (e) {
+    case RIZZ_PLUGIN_EVENT_STEP:
+        if (g_bench.num_failed == 0 && g_bench.cur_test < NUM_TESTS) {
+            step_benchmark();
+            if (g_bench.cur_test == NUM_TESTS) {
+                report();
+            }
+        } else {
+            if (g_bench.num_failed == 0) {
+                puts("pg-animclip: all tests passed");
+            } else {
+                rizz_log_error(the_core, "pg-animclip: %d tests failed", g_bench.num_failed);
+            }
+            the_app->quit();
+        }
+        break;
+
+    case RIZZ_PLUGIN_EVENT_INIT:
+        the_core = plugin->api->get_api(RIZZ_API_CORE, 0);
+        the_app = plugin->api->get_api(RIZZ_API_APP, 0);
+        the_asset = plugin->api->get_api(RIZZ_API_ASSET, 0);
+        the_vfs = plugin->api->get_api(RIZZ_API_VFS, 0);
+        the_sprite = plugin->api->get_api_byname("sprite", 0);
+        if (!init_benchmark())
+            ++g_bench.num_failed;
+        break;
+
+    case RIZZ_PLUGIN_EVENT_LOAD:
+        break;
+
+    case RIZZ_PLUGIN_EVENT_UNLOAD:
+        break;
+
+    case RIZZ_PLUGIN_EVENT_SHUTDOWN:
+        for (int i = 0; i < NUM_TESTS; i++)
+            destroy_clips(&g_bench.tests[i]);
+        if (g_bench.atlas.id)
+            the_asset->unload(g_bench.atlas);
+        break;
+    }
+
+    return 0;
+}
+
+rizz_plugin_decl_event_handler(animclip, e)
+{
+    sx_unused(e);
+}
+
+rizz_game_decl_config(conf)
+{
+    conf->app_name = "pg-animclip";
+    conf->app_version = 1000;
+    conf->app_title = "pg-animclip";
+    conf->app_flags |= RIZZ_APP_FLAG_HEADLESS;
+    conf->core_flags |= RIZZ_CORE_FLAG_VERBOSE;
+    conf->plugins[0] = "imgui";
+    conf->plugins[1] = "sprite";
+}
@@ -0,0 +1,398 @@
+//
+// atlas load-time benchmark: loads the same atlas from json and binary (rizz_api_sprite
+// atlas_save_binary) formats and reports the time of each. quits by itself
+//
+//      rizz --run pg-atlas --headless
+//
+//  - a synthetic atlas with NUM_SPRITES sprites (half quads, half meshes) is written as json to
+//    .cache/pg-atlas of the working directory, next to a copy of it's image
+//  - every load is a cold load (separate file), so the metadata pass is included as well
+//  - the texture is kept loaded during the runs, so only the atlas itself is measured
+//  - draw-data of all sprites must be the same for json and binary atlases
+//  - instanced draw-data of mixed quads and meshes must keep the input order
+//
+#include "sx/allocator.h"
+#include "sx/io.h"
+#include "sx/math.h"
+#include "sx/os.h"
+#include "sx/string.h"
+#include "sx/timer.h"
+
+#include "rizz/app.h"
+#include "rizz/asset.h"
+#include "rizz/core.h"
+#include "rizz/entry.h"
+#include "rizz/graphics.h"
+#include "rizz/plugin.h"
+#include "rizz/sprite.h"
+#include "rizz/vfs.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+
+#define NUM_SPRITES 4000
+#define NUM_RUNS 5
+#define MESH_VERTS 8    // mesh sprites are a fan of MESH_VERTS vertices
+#define IMAGE_NAME "handicraft.png"
+#define IMAGE_WIDTH 1160
+#define IMAGE_HEIGHT 208
+
+RIZZ_STATE static rizz_api_core* the_core;
+RIZZ_STATE static rizz_api_app* the_app;
+RIZZ_STATE static rizz_api_asset* the_asset;
+RIZZ_STATE static rizz_api_vfs* the_vfs;
+RIZZ_STATE static rizz_api_sprite* the_sprite;
+
+static bool write_text(sx_file_writer* writer, const char* fmt, ...)
+{
+    char text[256];
+    va_list args;
+    va_start(args, fmt);
+    int len = sx_vsnprintf(text, sizeof(text), fmt, args);
+    va_end(args);
+    return sx_file_write(writer, text, len) == len;
+}
+
+// json atlas in the same format as atlasc outputs
+static bool write_json_atlas(const char* filepath)
+{
+    sx_file_writer writer;
+    if (!sx_file_open_writer(&writer, filepath, 0))
+        return false;
+
+    bool r = write_text(&writer,
+                        "{\"image\":\"%s\",\"image_width\":%d,\"image_height\":%d,\"sprites\":[",
+                        IMAGE_NAME, IMAGE_WIDTH, IMAGE_HEIGHT);
+    for (int i = 0; i < NUM_SPRITES && r; i++) {
+        int x = (i * 37) % (IMAGE_WIDTH - 64), y = (i * 13) % (IMAGE_HEIGHT - 64);
+        int w = 16 + i % 48, h = 16 + (i / 48) % 48;
+        r = write_text(&writer,
+                       "%s{\"name\":\"bench/sprite_%d.png\",\"size\":[%d,%d],"
+                       "\"sprite_rect\":[%d,%d,%d,%d],\"sheet_rect\":[%d,%d,%d,%d]",
+                       i > 0 ? "," : "", i, w + 8, h + 8, 4, 4, w + 4, h + 4, x, y, x + w, y + h);
+        if (r && (i & 1)) {
+            // fan around the center of the rect
+            r = write_text(&writer, ",\"mesh\":{\"num_tris\":%d,\"num_vertices\":%d,\"indices\":[",
+                           MESH_VERTS - 2, MESH_VERTS);
+            for (int t = 0; t < MESH_VERTS - 2 && r; t++)
+                r = write_text(&writer, "%s%d,%d,%d", t > 0 ? "," : "", 0, t + 1, t + 2);
+            r = r && write_text(&writer, "],\"positions\":[");
+            for (int v = 0; v < MESH_VERTS && r; v++) {
+                float a = SX_PI2 * (float)v / (float)MESH_VERTS;
+                int px = 4 + w / 2 + (int)(sx_cos(a) * (float)(w / 2));
+                int py = 4 + h / 2 + (int)(sx_sin(a) * (float)(h / 2));
+                r = write_text(&writer, "%s[%d,%d]", v > 0 ? "," : "", px, py);
+            }
+            r = r && write_text(&writer, "],\"uvs\":[");
+            for (int v = 0; v < MESH_VERTS && r; v++) {
+                float a = SX_PI2 * (float)v / (float)MESH_VERTS;
+                int u = x + w / 2 + (int)(sx_cos(a) * (float)(w / 2));
+                int uv = y + h / 2 + (int)(sx_sin(a) * (float)(h / 2));
+                r = write_text(&writer, "%s[%d,%d]", v > 0 ? "," : "", u, uv);
+            }
+            r = r && write_text(&writer, "]}");
+        }
+        r = r && write_text(&writer, "}");
+    }
+    r = r && write_text(&writer, "]}");
+    sx_file_close_writer(&writer);
+    return r;
+}
+
+static bool copy_file(const char* src, const char* dst)
+{
+    sx_mem_block* mem = sx_file_load_bin(the_core->heap_alloc(), src);
+    if (!mem)
+        return false;
+    sx_file_writer writer;
+    bool r = sx_file_open_writer(&writer, dst, 0);
+    if (r) {
+        r = sx_file_write(&writer, mem->data, (int)mem->size) == (int)mem->size;
+        sx_file_close_writer(&writer);
+    }
+    sx_mem_destroy_block(mem);
+    return r;
+}
+
+static int64_t file_size(const char* filepath)
+{
+    return (int64_t)sx_os_stat(filepath).size;
+}
+
+static const rizz_atlas_load_params k_atlas_params = { .min_filter = SG_FILTER_LINEAR,
+                                                       .mag_filter = SG_FILTER_LINEAR };
+
+// loads every file once, returns the best and average time in seconds
+static bool load_atlases(const char* paths[NUM_RUNS], rizz_asset atlases[NUM_RUNS], double* best,
+                         double* avg)
+{
+    *best = 1e9;
+    *avg = 0;
+    for (int i = 0; i < NUM_RUNS; i++) {
+        uint64_t start = sx_tm_now();
+        atlases[i] = the_asset->load("atlas", paths[i], &k_atlas_params,
+                                     RIZZ_ASSET_LOAD_FLAG_WAIT_ON_LOAD, NULL, 0);
+        double elapsed = sx_tm_sec(sx_tm_since(start));
+        if (the_asset->state(atlases[i]) != RIZZ_ASSET_STATE_OK)
+            return false;
+        *best = sx_min(*best, elapsed);
+        *avg += elapsed / (double)NUM_RUNS;
+    }
+    return true;
+}
+
+static bool same_drawdata(const rizz_sprite_drawdata* a, const rizz_sprite_drawdata* b)
+{
+    return a->num_verts == b->num_verts && a->num_indices == b->num_indices &&
+           sx_memcmp(a->verts, b->verts, sizeof(rizz_sprite_vertex) * a->num_verts) == 0 &&
+           sx_memcmp(a->indices, b->indices, sizeof(uint16_t) * a->num_indices) == 0;
+}
+
+// creates all sprites from both atlases and compares their geometry
+static int compare_atlases(rizz_asset json_atlas, rizz_asset bin_atlas)
+{
+    const sx_alloc* alloc = the_core->heap_alloc();
+    int num_errors = 0;
+    for (int i = 0; i < NUM_SPRITES; i++) {
+        char name[64];
+        sx_snprintf(name, sizeof(name), "bench/sprite_%d.png", i);
+        rizz_sprite sprs[2] = {
+            the_sprite->create(&(rizz_sprite_desc){ .name = name,
+                                                    .atlas = json_atlas,
+                                                    .size = sx_vec2f(1.0f, 1.0f),
+                                                    .color = sx_colorn(0xffffffff) }),
+            the_sprite->create(&(rizz_sprite_desc){ .name = name,
+                                                    .atlas = bin_atlas,
+                                                    .size = sx_vec2f(1.0f, 1.0f),
+                                                    .color = sx_colorn(0xffffffff) })
+        };
+        rizz_sprite_drawdata* dds[2] = { the_sprite->make_drawdata(sprs[0], alloc),
+                                         the_sprite->make_drawdata(sprs[1], alloc) };
+        if (!dds[0] || !dds[1] || !same_drawdata(dds[0], dds[1]))
+            ++num_errors;
+        for (int k = 0; k < 2; k++) {
+            if (dds[k])
+                the_sprite->free_drawdata(dds[k], alloc);
+            the_sprite->destroy(sprs[k]);
+        }
+    }
+    return num_errors;
+}
+
+// position of a sprite in the draw sequence of `make_drawdata_instanced_batch`: each instance
+// batch is drawn after `batches[0..batch_index)` and before the rest of the vertex batches
+static int64_t draw_position(const rizz_sprite_drawdata* dd, int index)
+{
+    const rizz_sprite_drawsprite* dspr = &dd->sprites[index];
+    int step = 0;
+    if (dspr->instance >= 0) {
+        for (int ib = 0; ib < dd->num_instance_batches; ib++) {
+            const rizz_sprite_instbatch* ibatch = &dd->instance_batches[ib];
+            if (dspr->instance >= ibatch->instance_start &&
+                dspr->instance < ibatch->instance_start + ibatch->instance_count) {
+                step = ibatch->batch_index + ib;
+                break;
+            }
+        }
+        return ((int64_t)step << 32) | dspr->instance;
+    }
+
+    for (int b = 0; b < dd->num_batches; b++) {
+        const rizz_sprite_drawbatch* batch = &dd->batches[b];
+        if (dspr->start_index >= batch->index_start &&
+            dspr->start_index < batch->index_start + batch->index_count) {
+            step = b;
+            for (int ib = 0; ib < dd->num_instance_batches; ib++)
+                step += dd->instance_batches[ib].batch_index <= b ? 1 : 0;
+            break;
+        }
+    }
+    return ((int64_t)step << 32) | dspr->start_index;
+}
+
+// quads and meshes of the same atlas are mixed in runs of different lengths, all of them must be
+// drawn in input order
+static bool check_draw_order(rizz_asset atlas)
+{
+    const sx_alloc* alloc = the_core->heap_alloc();
+    rizz_sprite sprs[64];
+    const int num_sprites = sizeof(sprs) / sizeof(rizz_sprite);
+    for (int i = 0; i < num_sprites; i++) {
+        char name[64];
+        sx_snprintf(name, sizeof(name), "bench/sprite_%d.png", 2 * i + ((i / 2 + i / 3) & 1));
+        sprs[i] = the_sprite->create(&(rizz_sprite_desc){ .name = name,
+                                                          .atlas = atlas,
+                                                          .size = sx_vec2f(1.0f, 1.0f),
+                                                          .color = sx_colorn(0xffffffff) });
+    }
+
+    rizz_sprite_drawdata* dd = the_sprite->make_drawdata_instanced_batch(sprs, num_sprites, alloc);
+    bool r = dd != NULL && dd->num_instances > 0 && dd->num_indices > 0;
+    for (int i = 1; i < num_sprites && r; i++)
+        r = draw_position(dd, i - 1) < draw_position(dd, i);
+
+    if (dd)
+        the_sprite->free_drawdata(dd, alloc);
+    for (int i = 0; i < num_sprites; i++)
+        the_sprite->destroy(sprs[i]);
+    return r;
+}
+
+static int run_benchmark()
+{
+    char cwd[RIZZ_MAX_PATH], dir[RIZZ_MAX_PATH], path[RIZZ_MAX_PATH], src_path[RIZZ_MAX_PATH];
+    sx_os_path_pwd(cwd, sizeof(cwd));
+    sx_os_path_join(dir, sizeof(dir), cwd, ".cache");
+    sx_os_mkdir(dir);
+    sx_os_path_join(dir, sizeof(dir), dir, "pg-atlas");
+    sx_os_mkdir(dir);
+
+    sx_os_path_join(src_path, sizeof(src_path), EXAMPLES_ROOT, "assets/textures/" IMAGE_NAME);
+    sx_os_path_join(path, sizeof(path), dir, IMAGE_NAME);
+    if (!copy_file(src_path, path)) {
+        rizz_log_error(the_core, "pg-atlas: copying '%s' failed", src_path);
+        return 1;
+    }
+    sx_os_path_join(path, sizeof(path), dir, "atlas.json");
+    if (!write_json_atlas(path)) {
+        rizz_log_error(the_core, "pg-atlas: writing '%s' failed", path);
+        return 1;
+    }
+    int64_t json_size = file_size(path);
+    for (int i = 0; i < NUM_RUNS; i++) {
+        char copy_path[RIZZ_MAX_PATH], name[32];
+        sx_snprintf(name, sizeof(name), "atlas-%d.json", i);
+        sx_os_path_join(copy_path, sizeof(copy_path), dir, name);
+        if (!copy_file(path, copy_path))
+            return 1;
+    }
+    the_vfs->mount(dir, "/bench");
+
+    rizz_texture_load_params tparams = { .min_filter = SG_FILTER_LINEAR,
+                                         .mag_filter = SG_FILTER_LINEAR,
+                                         .wrap_u = SG_WRAP_CLAMP_TO_EDGE,
+                                         .wrap_v = SG_WRAP_CLAMP_TO_EDGE };
+    rizz_asset tex = the_asset->load("texture", "/bench/" IMAGE_NAME, &tparams,
+                                     RIZZ_ASSET_LOAD_FLAG_WAIT_ON_LOAD, NULL, 0);
+
+    char json_paths[NUM_RUNS][64], bin_paths[NUM_RUNS][64];
+    const char* json_ptrs[NUM_RUNS];
+    const char* bin_ptrs[NUM_RUNS];
+    for (int i = 0; i < NUM_RUNS; i++) {
+        sx_snprintf(json_paths[i], sizeof(json_paths[i]), "/bench/atlas-%d.json", i);
+        sx_snprintf(bin_paths[i], sizeof(bin_paths[i]), "/bench/atlas-%d.atlas", i);
+        json_ptrs[i] = json_paths[i];
+        bin_ptrs[i] = bin_paths[i];
+    }
+
+    int num_failed = 0;
+    rizz_asset json_atlases[NUM_RUNS] = { { 0 } }, bin_atlases[NUM_RUNS] = { { 0 } };
+    double json_best, json_avg, bin_best, bin_avg;
+    int64_t bin_size = 0;
+    if (!load_atlases(json_ptrs, json_atlases, &json_best, &json_avg)) {
+        rizz_log_error(the_core, "pg-atlas: loading json atlas failed");
+        ++num_failed;
+    } else {
+        for (int i = 0; i < NUM_RUNS && num_failed == 0; i++) {
+            char name[32];
+            sx_snprintf(name, sizeof(name), "atlas-%d.atlas", i);
+            sx_os_path_join(path, sizeof(path), dir, name);
+            if (!the_sprite->atlas_save_binary(json_atlases[0], path)) {
+                rizz_log_error(the_core, "pg-atlas: writing '%s' failed", path);
+                ++num_failed;
+            }
+        }
+        bin_size = file_size(path);
+    }
+
+    if (num_failed == 0 && !load_atlases(bin_ptrs, bin_atlases, &bin_best, &bin_avg)) {
+        rizz_log_error(the_core, "pg-atlas: loading binary atlas failed");
+        ++num_failed;
+    }
+
+    if (num_failed == 0) {
+        int num_errors = compare_atlases(json_atlases[0], bin_atlases[0]);
+        if (num_errors > 0) {
+            rizz_log_error(the_core, "pg-atlas: %d sprites are different in binary atlas",
+                           num_errors);
+            ++num_failed;
+        }
+        if (!check_draw_order(bin_atlases[0])) {
+            rizz_log_error(the_core, "pg-atlas: quads and meshes are not drawn in input order");
+            ++num_failed;
+        }
+
+        // rows are printed as a whole, so they don't mix with the log output
+        char row[128];
+        sx_snprintf(row, sizeof(row),
+                    "atlas: %d sprites (%d meshes), json: %$.2d, binary: %$.2d, best/avg of %d",
+                    NUM_SPRITES, NUM_SPRITES / 2, (int)json_size, (int)bin_size, NUM_RUNS);
+        puts(row);
+        sx_snprintf(row, sizeof(row), "%-8s %10.3f ms %10.3f ms", "json", json_best * 1000.0,
+                    json_avg * 1000.0);
+        puts(row);
+        sx_snprintf(row, sizeof(row), "%-8s %10.3f ms %10.3f ms  (%.1fx)", "binary",
+                    bin_best * 1000.0, bin_avg * 1000.0, json_best / sx_max(bin_best, 1e-9));
+        puts(row);
+    }
+
+    for (int i = 0; i < NUM_RUNS; i++) {
+        if (json_atlases[i].id)
+            the_asset->unload(json_atlases[i]);
+        if (bin_atlases[i].id)
+            the_asset->unload(bin_atlases[i]);
+    }
+    the_asset->unload(tex);
+    return num_failed;
+}
+
+rizz_plugin_decl_main(atlas, plugin, e)
+{
+    switch (e) {
+    case RIZZ_PLUGIN_EVENT_STEP:
+        the_app->quit();
+        break;
+
+    case RIZZ_PLUGIN_EVENT_INIT: {
+        the_core = plugin->api->get_api(RIZZ_API_CORE, 0);
+        the_app = plugin->api->get_api(RIZZ_API_APP, 0);
+        the_asset = plugin->api->get_api(RIZZ_API_ASSET, 0);
+        the_vfs = plugin->api->get_api(RIZZ_API_VFS, 0);
+        the_sprite = plugin->api->get_api_byname("sprite", 0);
+        int num_failed = run_benchmark();
+        if (num_failed == 0) {
+            puts("pg-atlas: all tests passed");
+        } else {
+            rizz_log_error(the_core, "pg-atlas: %d tests failed", num_failed);
+        }
+        break;
+    }
+
+    case RIZZ_PLUGIN_EVENT_LOAD:
+        break;
+
+    case RIZZ_PLUGIN_EVENT_UNLOAD:
+        break;
+
+    case RIZZ_PLUGIN_EVENT_SHUTDOWN:
+        break;
+    }
+
+    return 0;
+}
+
+rizz_plugin_decl_event_handler(atlas, e)
+{
+    sx_unused(e);
+}
+
+rizz_game_decl_config(conf)
+{
+    conf->app_name = "pg-atlas";
+    conf->app_version = 1000;
+    conf->app_title = "pg-atlas";
+    conf->app_flags |= RIZZ_APP_FLAG_HEADLESS;
+    conf->core_flags |= RIZZ_CORE_FLAG_VERBOSE;
+    conf->plugins[0] = "imgui";
+    conf->plugins[1] = "sprite";
+}
@@ -0,0 +1,600 @@
+//
+// http client driver: runs a small http/1.1 server on a loopback socket and checks the responses
+// of rizz_api_http against it. quits by itself when all requests are finished
+//
+//      rizz --run pg-http --headless
+//
+//  - host names are resolved on the resolver thread: requests to an unresolvable host must fail
+//    without stalling the requests to the loopback server
+//  - keep-alive: sequential requests after the others are finished must not open new connections
+//  - chunked, streamed and empty responses, post data
+//  - remote vfs: fetch, revalidation with etag (304), content changed to empty on the server
+//    must replace the cached one. a fetch is left in flight at exit, it must not leak
+//
+#include "sx/allocator.h"
+#include "sx/atomic.h"
+#include "sx/io.h"
+#include "sx/string.h"
+#include "sx/threads.h"
+#include "sx/timer.h"
+
+#include "rizz/app.h"
+#include "rizz/core.h"
+#include "rizz/entry.h"
+#include "rizz/http.h"
+#include "rizz/plugin.h"
+#include "rizz/vfs.h"
+
+#if SX_PLATFORM_WINDOWS
+#    include <winsock2.h>
+#    include <ws2tcpip.h>
+#    pragma comment(lib, "ws2_32.lib")
+typedef SOCKET server_socket;
+#    define SERVER_INVALID_SOCKET INVALID_SOCKET
+#    define server_poll(_fds, _n, _msecs) WSAPoll((_fds), (ULONG)(_n), (_msecs))
+#    define server_close_socket(_sock) closesocket(_sock)
+#else
+#    include <netinet/in.h>
+#    include <poll.h>
+#    include <sys/socket.h>
+#    include <unistd.h>
+typedef int server_socket;
+#    define SERVER_INVALID_SOCKET -1
+#    define server_poll(_fds, _n, _msecs) poll((_fds), (nfds_t)(_n), (_msecs))
+#    define server_close_socket(_sock) close(_sock)
+#endif
+
+#include <stdio.h>
+
+#define MAX_CLIENTS 16
+#define BIG_SIZE (1024 * 1024)
+#define TIMEOUT 10.0    // seconds
+
+RIZZ_STATE static rizz_api_core* the_core;
+RIZZ_STATE static rizz_api_app* the_app;
+RIZZ_STATE static rizz_api_http* the_http;
+RIZZ_STATE static rizz_api_vfs* the_vfs;
+
+typedef struct server_client {
+    server_socket sock;
+    char* buff;    // received request data
+    int size;
+    int capacity;
+} server_client;
+
+typedef struct {
+    server_socket listen_sock;
+    uint16_t port;
+    sx_thread* thrd;
+    int quit;
+    sx_atomic_int num_accepted;    // number of connections accepted by the server
+    sx_atomic_int remote_version;        // content of "/remote/file": 1: text, 2: empty
+    sx_atomic_int num_not_modified;      // 304 responses of "/remote/file"
+    server_client clients[MAX_CLIENTS];
+} server;
+
+typedef struct {
+    const char* name;
+    int expected_status_code;    // -1: request must fail
+    const char* expected_body;   // NULL: don't check
+    size_t expected_size;
+    bool finished;
+    bool passed;
+    size_t stream_size;
+    bool stream_ok;
+} http_test;
+
+typedef struct {
+    server srv;
+    http_test tests[16];
+    int num_tests;
+    int num_finished;
+    uint64_t start_tick;
+    bool reported;
+    http_test* keepalive;
+    int keepalive_count;       // finished requests of the keep-alive test, -1: not started
+    int keepalive_accepted;    // accepted connections before the keep-alive test started
+    http_test* remote[4];      // remote vfs tests, run one after another
+    int remote_step;
+    rizz_vfs_async_callbacks prev_vfs_callbacks;
+} http_driver;
+
+RIZZ_STATE static http_driver g_http;
+
+// server
+static void server_send(server_socket sock, const void* data, int size)
+{
+    const char* ptr = (const char*)data;
+    while (size > 0) {
+        int r = (int)send(sock, ptr, size, 0);
+        if (r <= 0)
+            return;
+        ptr += r;
+        size -= r;
+    }
+}
+
+static void server_respond(server_socket sock, const char* status, const char* extra_headers,
+                           const void* body, int body_size)
+{
+    char header[512];
+    sx_snprintf(header, sizeof(header),
+                "HTTP/1.1 %s\r\nContent-Length: %d\r\nContent-Type: text/plain\r\n%s\r\n", status,
+                body_size, extra_headers ? extra_headers : "");
+    server_send(sock, header, sx_strlen(header));
+    if (body_size > 0)
+        server_send(sock, body, body_size);
+}
+
+// vfs remote file, etag is the version of the content
+static void server_handle_remote(server* srv, server_socket sock, const char* headers)
+{
+    int version = srv->remote_version;
+    char etag[32];
+    char etag_header[64];
+    sx_snprintf(etag, sizeof(etag), "\"v%d\"", version);
+    sx_snprintf(etag_header, sizeof(etag_header), "ETag: %s\r\n", etag);
+
+    const char* if_none_match = sx_strstr(headers, "If-None-Match:");
+    if (if_none_match && sx_strnequal(sx_skip_whitespace(if_none_match + 14), etag,
+                                      sx_strlen(etag))) {
+        sx_atomic_incr(&srv->num_not_modified);
+        server_respond(sock, "304 Not Modified", etag_header, NULL, 0);
+    } else if (version == 1) {
+        server_respond(sock, "200 OK", etag_header, "remote content", 14);
+    } else {
+        server_respond(sock, "200 OK", etag_header, NULL, 0);
+    }
+}
+
+static void server_handle_request(server* srv, server_client* client, const char* path,
+                                  const char* headers, const char* body, int body_size)
+{
+    server_socket sock = client->sock;
+    if (sx_strequal(path, "/remote/file")) {
+        server_handle_remote(srv, sock, headers);
+    } else if (sx_strequal(path, "/remote/hang")) {
+        // never responds, the request is still in flight when the app quits
+    } else if (sx_strequal(path, "/hello")) {
+        server_respond(sock, "200 OK", NULL, "hello world", 11);
+    } else if (sx_strequal(path, "/empty")) {
+        server_respond(sock, "200 OK", NULL, NULL, 0);
+    } else if (sx_strequal(path, "/echo")) {
+        server_respond(sock, "200 OK", NULL, body, body_size);
+    } else if (sx_strequal(path, "/chunked")) {
+        static const char chunked[] = "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n"
+                                      "3\r\nabc\r\n4\r\ndefg\r\n0\r\n\r\n";
+        server_send(sock, chunked, sizeof(chunked) - 1);
+    } else if (sx_strequal(path, "/big")) {
+        char* big = sx_malloc(sx_alloc_malloc(), BIG_SIZE);
+        if (big) {
+            for (int i = 0; i < BIG_SIZE; i++)
+                big[i] = (char)(i % 251);
+            server_respond(sock, "200 OK", NULL, big, BIG_SIZE);
+            sx_free(sx_alloc_malloc(), big);
+        }
+    } else {
+        server_respond(sock, "404 Not Found", NULL, "not found", 9);
+    }
+}
+
+// parses complete requests from the client's buffer, returns false if the client must be closed
+static bool server_process(server* srv, server_client* client)
+{
+    for (;;) {
+        if (client->size == 0)
+            return true;
+        client->buff[client->size] = '\0';
+        char* header_end = (char*)sx_strstr(client->buff, "\r\n\r\n");
+        if (!header_end)
+            return true;
+
+        int content_len = 0;
+        const char* cl = sx_strstr(client->buff, "Content-Length:");
+        if (cl && cl < header_end)
+            content_len = sx_toint(sx_skip_whitespace(cl + 15));
+        int header_size = (int)(intptr_t)(header_end - client->buff) + 4;
+        if (client->size < header_size + content_len)
+            return true;
+
+        // request line: METHOD path HTTP/1.1
+        char path[256];
+        const char* path_start = sx_skip_whitespace(sx_skip_word(client->buff));
+        const char* path_end = sx_strchar(path_start, ' ');
+        if (!path_end)
+            return false;
+        sx_strncpy(path, sizeof(path), path_start, (int)(intptr_t)(path_end - path_start));
+        header_end[2] = '\0';    // headers end with the last "\r\n"
+        server_handle_request(srv, client, path, client->buff, client->buff + header_size,
+                              content_len);
+
+        int consumed = header_size + content_len;
+        sx_memmove(client->buff, client->buff + consumed, client->size - consumed);
+        client->size -= consumed;
+    }
+}
+
+static void server_close_client(server_client* client)
+{
+    server_close_socket(client->sock);
+    sx_free(sx_alloc_malloc(), client->buff);
+    sx_memset(client, 0x0, sizeof(server_client));
+    client->sock = SERVER_INVALID_SOCKET;
+}
+
+static int server_thread(void* user1, void* user2)
+{
+    sx_unused(user2);
+    server* srv = user1;
+
+    while (!srv->quit) {
+        struct pollfd fds[MAX_CLIENTS + 1];
+        int indices[MAX_CLIENTS + 1];
+        int num_fds = 0;
+        fds[num_fds++] = (struct pollfd){ .fd = srv->listen_sock, .events = POLLIN };
+        for (int i = 0; i < MAX_CLIENTS; i++) {
+            if (srv->clients[i].sock != SERVER_INVALID_SOCKET) {
+                indices[num_fds] = i;
+                fds[num_fds++] = (struct pollfd){ .fd = srv->clients[i].sock, .events = POLLIN };
+            }
+        }
+
+        if (server_poll(fds, num_fds, 100) <= 0)
+            continue;
+
+        if (fds[0].revents & POLLIN) {
+            server_socket sock = accept(srv->listen_sock, NULL, NULL);
+            if (sock != SERVER_INVALID_SOCKET) {
+                int slot = -1;
+                for (int i = 0; i < MAX_CLIENTS && slot == -1; i++) {
+                    if (srv->clients[i].sock == SERVER_INVALID_SOCKET)
+                        slot = i;
+                }
+                if (slot != -1) {
+                    srv->clients[slot].sock = sock;
+                    sx_atomic_incr(&srv->num_accepted);
+                } else {
+                    server_close_socket(sock);
+                }
+            }
+        }
+
+        for (int i = 1; i < num_fds; i++) {
+            if (!fds[i].revents)
+                continue;
+            server_client* client = &srv->clients[indices[i]];
+            if (client->capacity - client->size < 4097) {
+                int capacity = client->capacity + 0x10000;
+                char* buff = sx_realloc(sx_alloc_malloc(), client->buff, capacity);
+                if (!buff) {
+                    server_close_client(client);
+                    continue;
+                }
+                client->buff = buff;
+                client->capacity = capacity;
+            }
+            int r = (int)recv(client->sock, client->buff + client->size, 4096, 0);
+            if (r <= 0) {
+                server_close_client(client);
+                continue;
+            }
+            client->size += r;
+            if (!server_process(srv, client))
+                server_close_client(client);
+        }
+    }
+
+    for (int i = 0; i < MAX_CLIENTS; i++) {
+        if (srv->clients[i].sock != SERVER_INVALID_SOCKET)
+            server_close_client(&srv->clients[i]);
+    }
+    return 0;
+}
+
+static bool server_start(server* srv)
+{
+    for (int i = 0; i < MAX_CLIENTS; i++)
+        srv->clients[i].sock = SERVER_INVALID_SOCKET;
+
+    srv->listen_sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (srv->listen_sock == SERVER_INVALID_SOCKET)
+        return false;
+
+    // port 0: any free port
+    struct sockaddr_in addr = { .sin_family = AF_INET };
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t addr_len = sizeof(addr);
+    if (bind(srv->listen_sock, (const struct sockaddr*)&addr, sizeof(addr)) != 0 ||
+        listen(srv->listen_sock, MAX_CLIENTS) != 0 ||
+        getsockname(srv->listen_sock, (struct sockaddr*)&addr, &addr_len) != 0) {
+        server_close_socket(srv->listen_sock);
+        return false;
+    }
+    srv->port = ntohs(addr.sin_port);
+
+    srv->thrd = sx_thread_create(sx_alloc_malloc(), server_thread, srv, 0, "http_server", NULL);
+    return srv->thrd != NULL;
+}
+
+static void server_stop(server* srv)
+{
+    if (srv->thrd) {
+        srv->quit = 1;
+        sx_thread_destroy(srv->thrd, sx_alloc_malloc());
+        server_close_socket(srv->listen_sock);
+    }
+}
+
+// client
+static void test_finish(http_test* test, bool passed)
+{
+    test->finished = true;
+    test->passed = passed;
+    ++g_http.num_finished;
+}
+
+static void test_http_cb(const rizz_http_state* http, void* user)
+{
+    http_test* test = user;
+    bool passed;
+    if (test->expected_status_code < 0) {
+        passed = http->status == RIZZ_HTTP_FAILED;
+    } else {
+        size_t size = test->stream_size > 0 ? test->stream_size : http->response_size;
+        passed = http->status == RIZZ_HTTP_COMPLETED &&
+                 http->status_code == test->expected_status_code &&
+                 size == test->expected_size &&
+                 (!test->expected_body ||
+                  sx_strnequal((const char*)http->response_data, test->expected_body,
+                               (int)test->expected_size));
+        if (test->stream_size > 0)
+            passed = passed && test->stream_ok;
+    }
+    test_finish(test, passed);
+}
+
+static void test_stream_cb(const void* data, size_t size, void* user)
+{
+    http_test* test = user;
+    const uint8_t* bytes = data;
+    for (size_t i = 0; i < size; i++) {
+        if (bytes[i] != (uint8_t)((test->stream_size + i) % 251))
+            test->stream_ok = false;
+    }
+    test->stream_size += size;
+}
+
+static void test_keepalive_cb(const rizz_http_state* http, void* user);
+
+static void test_keepalive_next(http_test* test)
+{
+    char url[128];
+    sx_snprintf(url, sizeof(url), "http://127.0.0.1:%u/hello", g_http.srv.port);
+    the_http->get_cb(url, test_keepalive_cb, test);
+}
+
+static void test_keepalive_cb(const rizz_http_state* http, void* user)
+{
+    http_test* test = user;
+    if (http->status != RIZZ_HTTP_COMPLETED || http->status_code != 200) {
+        test_finish(test, false);
+    } else if (++g_http.keepalive_count < 3) {
+        test_keepalive_next(test);
+    } else {
+        test_finish(test, g_http.srv.num_accepted == g_http.keepalive_accepted);
+    }
+}
+
+// remote vfs: steps are started one after another, every one checks the previous result
+static void test_remote_next(void)
+{
+    http_test* test = g_http.remote[g_http.remote_step];
+    switch (g_http.remote_step) {
+    case 0:    // not cached: fetched from the server
+    case 1:    // cached, but max_age is 0: revalidated with the etag, server responds 304
+        the_vfs->read_async("/remote/file", RIZZ_VFS_FLAG_TEXT_FILE, NULL);
+        break;
+    case 2:    // server content is changed to empty, the cache must be updated
+        g_http.srv.remote_version = 2;
+        the_vfs->read_async("/remote/file", RIZZ_VFS_FLAG_TEXT_FILE, NULL);
+        break;
+    case 3: {    // synchronous reads are served from the cache only
+        sx_mem_block* mem = the_vfs->read("/remote/file", RIZZ_VFS_FLAG_TEXT_FILE, NULL);
+        test_finish(test, mem && mem->size == 1 && ((char*)mem->data)[0] == '\0');
+        if (mem)
+            sx_mem_destroy_block(mem);
+        break;
+    }
+    }
+}
+
+static void test_remote_read_complete(const char* path, sx_mem_block* mem)
+{
+    if (!sx_strequal(path, "/remote/file")) {
+        if (!sx_strnequal(path, "/remote/", 8))
+            g_http.prev_vfs_callbacks.on_read_complete(path, mem);
+        else
+            sx_mem_destroy_block(mem);
+        return;
+    }
+
+    http_test* test = g_http.remote[g_http.remote_step];
+    int num_not_modified = g_http.srv.num_not_modified;
+    // text files are null-terminated
+    bool passed = mem->size == (int)test->expected_size + 1 &&
+                  sx_strequal((const char*)mem->data, test->expected_body) &&
+                  (g_http.remote_step != 1 || num_not_modified == 1);
+    sx_mem_destroy_block(mem);
+
+    test_finish(test, passed);
+    if (passed && ++g_http.remote_step < (int)(sizeof(g_http.remote) / sizeof(g_http.remote[0])))
+        test_remote_next();
+}
+
+static void test_remote_read_error(const char* path)
+{
+    if (!sx_strequal(path, "/remote/file")) {
+        if (!sx_strnequal(path, "/remote/", 8))
+            g_http.prev_vfs_callbacks.on_read_error(path);
+        return;
+    }
+    test_finish(g_http.remote[g_http.remote_step], false);
+}
+
+static http_test* test_add(const char* name, int expected_status_code, const char* expected_body,
+                           size_t expected_size)
+{
+    sx_assert(g_http.num_tests < (int)(sizeof(g_http.tests) / sizeof(g_http.tests[0])));
+    http_test* test = &g_http.tests[g_http.num_tests++];
+    *test = (http_test){ .name = name,
+                         .expected_status_code = expected_status_code,
+                         .expected_body = expected_body,
+                         .expected_size = expected_size,
+                         .stream_ok = true };
+    return test;
+}
+
+static bool init()
+{
+    if (!server_start(&g_http.srv)) {
+        rizz_log_error(the_core, "pg-http: starting the loopback server failed");
+        return false;
+    }
+
+    char url[128];
+    uint16_t port = g_http.srv.port;
+
+    // the unresolvable host goes first, it must not hold the other requests back
+    sx_snprintf(url, sizeof(url), "http://host.invalid:%u/hello", port);
+    the_http->get_cb(url, test_http_cb, test_add("unresolvable host", -1, NULL, 0));
+
+    sx_snprintf(url, sizeof(url), "http://localhost:%u/hello", port);
+    the_http->get_cb(url, test_http_cb, test_add("get (localhost)", 200, "hello world", 11));
+
+    sx_snprintf(url, sizeof(url), "http://127.0.0.1:%u/chunked", port);
+    the_http->get_cb(url, test_http_cb, test_add("chunked", 200, "abcdefg", 7));
+
+    sx_snprintf(url, sizeof(url), "http://127.0.0.1:%u/empty", port);
+    the_http->get_cb(url, test_http_cb, test_add("empty", 200, NULL, 0));
+
+    static const char post_data[] = "some post data";
+    sx_snprintf(url, sizeof(url), "http://127.0.0.1:%u/echo", port);
+    the_http->post_cb(url, post_data, sizeof(post_data) - 1, test_http_cb,
+                      test_add("post", 200, post_data, sizeof(post_data) - 1));
+
+    sx_snprintf(url, sizeof(url), "http://127.0.0.1:%u/big", port);
+    the_http->get_stream(url, test_stream_cb, test_http_cb,
+                         test_add("stream", 200, NULL, BIG_SIZE));
+
+    sx_snprintf(url, sizeof(url), "http://127.0.0.1:%u/missing", port);
+    the_http->get_cb(url, test_http_cb, test_add("not found", 404, "not found", 9));
+
+    // remote vfs, a new port every run, so the cache entries of the url are always new
+    sx_snprintf(url, sizeof(url), "http://127.0.0.1:%u/remote", port);
+    if (!the_vfs->mount_remote(url, "/remote", 0)) {
+        rizz_log_error(the_core, "pg-http: mounting remote vfs failed");
+        return false;
+    }
+    g_http.srv.remote_version = 1;
+    g_http.remote[0] = test_add("vfs remote fetch", 200, "remote content", 14);
+    g_http.remote[1] = test_add("vfs remote 304", 304, "remote content", 14);
+    g_http.remote[2] = test_add("vfs remote empty", 200, "", 0);
+    g_http.remote[3] = test_add("vfs remote cached", 200, "", 0);
+    rizz_vfs_async_callbacks cbs = the_vfs->set_async_callbacks(NULL);
+    g_http.prev_vfs_callbacks = cbs;
+    cbs.on_read_complete = test_remote_read_complete;
+    cbs.on_read_error = test_remote_read_error;
+    the_vfs->set_async_callbacks(&cbs);
+    test_remote_next();
+    the_vfs->read_async("/remote/hang", 0, NULL);
+
+    // started after all the others are finished, see `update`
+    g_http.keepalive = test_add("keep-alive", 200, NULL, 0);
+    g_http.keepalive_count = -1;
+
+    g_http.start_tick = sx_tm_now();
+    return true;
+}
+
+static void report()
+{
+    int num_passed = 0;
+    for (int i = 0; i < g_http.num_tests; i++) {
+        http_test* test = &g_http.tests[i];
+        const char* result = !test->finished ? "TIMEOUT" : (test->passed ? "ok" : "FAILED");
+        printf("%-20s %s\n", test->name, result);
+        num_passed += test->passed ? 1 : 0;
+    }
+
+    printf("connections: %d\n", g_http.srv.num_accepted);
+    if (num_passed == g_http.num_tests) {
+        printf("pg-http: all %d tests passed\n", g_http.num_tests);
+    } else {
+        rizz_log_error(the_core, "pg-http: %d of %d tests failed", g_http.num_tests - num_passed,
+                       g_http.num_tests);
+    }
+}
+
+static void update()
+{
+    if (g_http.reported)
+        return;
+
+    if (g_http.keepalive_count == -1 && g_http.num_finished == g_http.num_tests - 1) {
+        g_http.keepalive_count = 0;
+        g_http.keepalive_accepted = g_http.srv.num_accepted;
+        test_keepalive_next(g_http.keepalive);
+    }
+
+    bool timeout = sx_tm_sec(sx_tm_since(g_http.start_tick)) > TIMEOUT;
+    if (g_http.num_finished == g_http.num_tests || timeout) {
+        report();
+        g_http.reported = true;
+        the_app->quit();
+    }
+}
+
+rizz_plugin_decl_main(http, plugin, e)
+{
+    switch (e) {
+    case RIZZ_PLUGIN_EVENT_STEP:
+        update();
+        break;
+
+    case RIZZ_PLUGIN_EVENT_INIT:
+        the_core = plugin->api->get_api(RIZZ_API_CORE, 0);
+        the_app = plugin->api->get_api(RIZZ_API_APP, 0);
+        the_http = plugin->api->get_api(RIZZ_API_HTTP, 0);
+        the_vfs = plugin->api->get_api(RIZZ_API_VFS, 0);
+        if (!init())
+            return -1;
+        break;
+
+    case RIZZ_PLUGIN_EVENT_LOAD:
+        break;
+
+    case RIZZ_PLUGIN_EVENT_UNLOAD:
+        break;
+
+    case RIZZ_PLUGIN_EVENT_SHUTDOWN:
+        the_vfs->set_async_callbacks(&g_http.prev_vfs_callbacks);
+        server_stop(&g_http.srv);
+        break;
+    }
+
+    return 0;
+}
+
+rizz_plugin_decl_event_handler(http, e)
+{
+    sx_unused(e);
+}
+
+rizz_game_decl_config(conf)
+{
+    conf->app_name = "pg-http";
+    conf->app_version = 1000;
+    conf->app_title = "pg-http";
+    conf->app_flags |= RIZZ_APP_FLAG_HEADLESS;
+    conf->core_flags |= RIZZ_CORE_FLAG_VERBOSE;
+}
@@ -0,0 +1,548 @@
+//
+// reflection serializer driver: checks that corrupt binary data is rejected and benchmarks the
+// serializers against the per-field reflection path of the asset database. quits by itself
+//
+//      rizz --run pg-refl --headless
+//
+//  - corrupt binary data (negative packed size, fields out of the items, number fields with a
+//    wrong size, truncated data) must be rejected by deserialize_bin (-1)
+//  - data of an older layout is remapped by the field names, numbers are converted
+//  - benchmark: structs per second, reference is the json path of the asset database before the
+//    serializers (get_fields + meta_read_item/meta_write_item), then serializer json and binary
+//
+#include "sx/allocator.h"
+#include "sx/io.h"
+#include "sx/string.h"
+#include "sx/timer.h"
+
+#include "rizz/app.h"
+#include "rizz/core.h"
+#include "rizz/entry.h"
+#include "rizz/json.h"
+#include "rizz/plugin.h"
+#include "rizz/reflect.h"
+
+#include <stdio.h>
+
+#define NUM_ITEMS 10000
+#define NUM_RUNS 5
+
+RIZZ_STATE static rizz_api_core* the_core;
+RIZZ_STATE static rizz_api_app* the_app;
+RIZZ_STATE static rizz_api_refl* the_refl;
+
+typedef enum bench_mode { BENCH_MODE_NONE = 0, BENCH_MODE_ADD, BENCH_MODE_MUL } bench_mode;
+
+typedef struct bench_point {
+    int x;
+    int y;
+    float weight;
+} bench_point;
+
+typedef struct bench_item {
+    int id;
+    int flags;
+    float scale;
+    float bias;
+    bool enabled;
+    bool visible;
+    bench_mode mode;
+    char name[32];
+    bench_point origin;
+    bench_point points[4];
+    int width;
+    int height;
+    float alpha;
+    int layer;
+} bench_item;
+
+// older layout of bench_item: `scale` is double and `id` is 64bit, other fields are missing
+typedef struct bench_item_old {
+    double scale;
+    int64_t id;
+    char name[32];
+} bench_item_old;
+
+// same as rizz__refl_bin_header and rizz__refl_bin_field of reflect.c, used to corrupt the data
+typedef struct bin_header {
+    uint32_t sign;
+    uint32_t format;
+    uint32_t version;
+    uint32_t schema_hash;
+    int32_t num_fields;
+    int32_t packed_size;
+    int32_t count;
+    uint32_t _reserved;
+} bin_header;
+
+typedef struct bin_field {
+    uint32_t name_hash;
+    uint32_t kind;
+    int32_t size;
+    int32_t count;
+} bin_field;
+
+typedef struct {
+    rizz_refl_serializer* srz;
+    rizz_refl_serializer* srz_old;
+    bench_item* items;
+    bench_item* read_items;
+    int num_failed;
+} refl_driver;
+
+RIZZ_STATE static refl_driver g_refl;
+
+// reference: rizz__asset_meta_read_item and rizz__asset_meta_write_item of asset.c, before the
+// serializers replaced them. strings are copied with sx_strcpy instead of a memcpy of the field
+// size, which could read past the end of the json string
+static void meta_read_item(const rizz_refl_field* f, sjson_node* jmeta)
+{
+    const rizz_refl_info* r = &f->info;
+    void* value = f->value;
+    rizz_refl_field fields[32];
+
+    sjson_node* jfield = sjson_find_member(jmeta, r->name);
+    if (jfield) {
+        if (r->flags & RIZZ_REFL_FLAG_IS_ENUM) {
+            int eval = the_refl->get_enum(jfield->string_, 0);
+            sx_memcpy(value, &eval, r->size);
+        } else if (r->flags & RIZZ_REFL_FLAG_IS_STRUCT) {
+            if (r->flags & RIZZ_REFL_FLAG_IS_ARRAY) {
+                for (int i = 0; i < r->array_size; i++) {
+                    int num_fields = the_refl->get_fields(
+                        r->type, (uint8_t*)value + (size_t)i * (size_t)r->stride, fields,
+                        sizeof(fields) / sizeof(rizz_refl_field));
+                    for (int fi = 0; fi < num_fields; fi++) {
+                        meta_read_item(&fields[fi], sjson_find_element(jfield, i));
+                    }
+                }
+            } else {
+                int num_fields = the_refl->get_fields(r->type, value, fields,
+                                                      sizeof(fields) / sizeof(rizz_refl_field));
+                for (int fi = 0; fi < num_fields; fi++) {
+                    meta_read_item(&fields[fi], jfield);
+                }
+            }
+        } else {
+            if (sx_strequal(r->type, "int")) {
+                int n = (int)jfield->number_;
+                sx_memcpy(value, &n, r->size);
+            } else if (sx_strequal(r->type, "float")) {
+                float n = (float)jfield->number_;
+                sx_memcpy(value, &n, r->size);
+            } else if (sx_strequal(r->type, "bool")) {
+                sx_memcpy(value, &jfield->bool_, r->size);
+            } else if (the_refl->is_cstring(r)) {
+                sx_strcpy(value, r->size, jfield->string_);
+            }
+        }
+    }
+}
+
+static void meta_write_item(const rizz_refl_field* field, sjson_context* jctx, sjson_node* jmeta)
+{
+    const rizz_refl_info* r = &field->info;
+    void* value = field->value;
+    rizz_refl_field fields[32];
+
+    if (r->flags & RIZZ_REFL_FLAG_IS_ENUM) {
+        int _e = *(int*)value;
+        sjson_put_string(jctx, jmeta, r->name, the_refl->get_enum_name(r->type, _e));
+    } else if (r->flags & RIZZ_REFL_FLAG_IS_STRUCT) {
+        if (r->flags & RIZZ_REFL_FLAG_IS_ARRAY) {
+            sjson_node* js = sjson_put_array(jctx, jmeta, r->name);
+            for (int i = 0; i < r->array_size; i++) {
+                sjson_node* jitem = sjson_mkobject(jctx);
+                int num_fields =
+                    the_refl->get_fields(r->type, (uint8_t*)value + (size_t)i * (size_t)r->stride,
+                                         fields, sizeof(fields) / sizeof(rizz_refl_field));
+                for (int fi = 0; fi < num_fields; fi++) {
+                    meta_write_item(&fields[fi], jctx, jitem);
+                }
+                sjson_append_element(js, jitem);
+            }
+        } else {
+            sjson_node* js = sjson_put_obj(jctx, jmeta, r->name);
+            int num_fields = the_refl->get_fields(r->type, value, fields,
+                                                  sizeof(fields) / sizeof(rizz_refl_field));
+            for (int fi = 0; fi < num_fields; fi++) {
+                meta_write_item(&fields[fi], jctx, js);
+            }
+        }
+    } else {
+        if (sx_strequal(r->type, "int")) {
+            sjson_put_int(jctx, jmeta, r->name, *(int*)value);
+        } else if (sx_strequal(r->type, "float")) {
+            sjson_put_float(jctx, jmeta, r->name, *(float*)value);
+        } else if (sx_strequal(r->type, "bool")) {
+            sjson_put_bool(jctx, jmeta, r->name, *(bool*)value);
+        } else if (the_refl->is_cstring(r)) {
+            sjson_put_string(jctx, jmeta, r->name, (const char*)value);
+        }
+    }
+}
+
+static char* meta_write(const bench_item* items, int count)
+{
+    sjson_context* jctx = sjson_create_context(0, 0, (void*)the_core->heap_alloc());
+    if (!jctx)
+        return NULL;
+
+    rizz_refl_field fields[32];
+    sjson_node* jroot = sjson_mkarray(jctx);
+    for (int i = 0; i < count; i++) {
+        sjson_node* jitem = sjson_mkobject(jctx);
+        int num_fields = the_refl->get_fields("bench_item", (void*)&items[i], fields,
+                                              sizeof(fields) / sizeof(rizz_refl_field));
+        for (int fi = 0; fi < num_fields; fi++) {
+            meta_write_item(&fields[fi], jctx, jitem);
+        }
+        sjson_append_element(jroot, jitem);
+    }
+
+    // string is allocated by the heap allocator (user of the context), like serialize_json
+    char* json = sjson_encode(jctx, jroot);
+    sjson_destroy_context(jctx);
+    return json;
+}
+
+static int meta_read(const char* json, bench_item* items, int max_count)
+{
+    sjson_context* jctx = sjson_create_context(0, 0, (void*)the_core->heap_alloc());
+    if (!jctx)
+        return -1;
+
+    int count = 0;
+    rizz_refl_field fields[32];
+    sjson_node* jroot = sjson_decode(jctx, json);
+    sjson_node* jitem;
+    sjson_foreach(jitem, jroot)
+    {
+        if (count == max_count)
+            break;
+        int num_fields = the_refl->get_fields("bench_item", &items[count], fields,
+                                              sizeof(fields) / sizeof(rizz_refl_field));
+        for (int fi = 0; fi < num_fields; fi++) {
+            meta_read_item(&fields[fi], jitem);
+        }
+        ++count;
+    }
+
+    sjson_destroy_context(jctx);
+    return count;
+}
+
+static void check(bool passed, const char* name)
+{
+    printf("%-40s %s\n", name, passed ? "ok" : "FAILED");
+    g_refl.num_failed += passed ? 0 : 1;
+}
+
+static void register_types(void)
+{
+    rizz_refl_enum(the_refl, bench_mode, BENCH_MODE_NONE);
+    rizz_refl_enum(the_refl, bench_mode, BENCH_MODE_ADD);
+    rizz_refl_enum(the_refl, bench_mode, BENCH_MODE_MUL);
+
+    rizz_refl_field(the_refl, bench_point, int, x, "x");
+    rizz_refl_field(the_refl, bench_point, int, y, "y");
+    rizz_refl_field(the_refl, bench_point, float, weight, "weight");
+
+    rizz_refl_field(the_refl, bench_item, int, id, "id");
+    rizz_refl_field(the_refl, bench_item, int, flags, "flags");
+    rizz_refl_field(the_refl, bench_item, float, scale, "scale");
+    rizz_refl_field(the_refl, bench_item, float, bias, "bias");
+    rizz_refl_field(the_refl, bench_item, bool, enabled, "enabled");
+    rizz_refl_field(the_refl, bench_item, bool, visible, "visible");
+    rizz_refl_field(the_refl, bench_item, bench_mode, mode, "mode");
+    rizz_refl_field(the_refl, bench_item, char[32], name, "name");
+    rizz_refl_field(the_refl, bench_item, bench_point, origin, "origin");
+    rizz_refl_field(the_refl, bench_item, bench_point[4], points, "points");
+    rizz_refl_field(the_refl, bench_item, int, width, "width");
+    rizz_refl_field(the_refl, bench_item, int, height, "height");
+    rizz_refl_field(the_refl, bench_item, float, alpha, "alpha");
+    rizz_refl_field(the_refl, bench_item, int, layer, "layer");
+
+    rizz_refl_field(the_refl, bench_item_old, double, scale, "scale");
+    rizz_refl_field(the_refl, bench_item_old, int64_t, id, "id");
+    rizz_refl_field(the_refl, bench_item_old, char[32], name, "name");
+}
+
+static void make_items(bench_item* items, int count)
+{
+    sx_memset(items, 0x0, sizeof(bench_item) * count);
+    for (int i = 0; i < count; i++) {
+        bench_item* item = &items[i];
+        item->id = i;
+        item->flags = i * 7;
+        item->scale = (float)i * 0.5f;
+        item->bias = -(float)i;
+        item->enabled = (i & 1) != 0;
+        item->visible = (i & 2) != 0;
+        item->mode = (bench_mode)(i % 3);
+        sx_snprintf(item->name, sizeof(item->name), "item_%d", i);
+        item->origin = (bench_point){ i, -i, 0.25f };
+        for (int k = 0; k < 4; k++)
+            item->points[k] = (bench_point){ i + k, i - k, (float)k };
+        item->width = 100 + i;
+        item->height = 200 + i;
+        item->alpha = 0.75f;
+        item->layer = i % 16;
+    }
+}
+
+// returns deserialize_bin of the data after `corrupt` is applied to its header and field table
+static int read_corrupted(const sx_mem_writer* writer, const rizz_refl_serializer* srz,
+                          void (*corrupt)(bin_header* header, bin_field* fields))
+{
+    const sx_alloc* alloc = the_core->heap_alloc();
+    uint8_t* data = sx_malloc(alloc, (size_t)writer->pos);
+    if (!data)
+        return -2;
+    sx_memcpy(data, writer->data, (size_t)writer->pos);
+    corrupt((bin_header*)data, (bin_field*)(data + sizeof(bin_header)));
+
+    sx_mem_reader reader;
+    sx_mem_init_reader(&reader, data, writer->pos);
+    int r = the_refl->deserialize_bin(srz, &reader, g_refl.read_items, NUM_ITEMS, NULL);
+    sx_free(alloc, data);
+    return r;
+}
+
+static void corrupt_packed_size(bin_header* header, bin_field* fields)
+{
+    sx_unused(fields);
+    header->packed_size = -header->packed_size;
+}
+
+static void corrupt_field_count(bin_header* header, bin_field* fields)
+{
+    fields[header->num_fields - 1].count = 0x10000000;
+}
+
+static void corrupt_field_offset(bin_header* header, bin_field* fields)
+{
+    // a field with a bigger size moves the ones after it out of the packed item
+    fields[0].size += header->packed_size;
+}
+
+// `scale` of bench_item_old: double declared with one byte, converted to the float of bench_item
+static void corrupt_number_size(bin_header* header, bin_field* fields)
+{
+    sx_unused(header);
+    fields[0].size = 1;
+}
+
+static void corrupt_truncated(bin_header* header, bin_field* fields)
+{
+    sx_unused(fields);
+    header->count += 1;
+}
+
+static void test_corrupt_data(void)
+{
+    const sx_alloc* alloc = the_core->heap_alloc();
+    sx_mem_writer writer;
+    sx_mem_writer writer_old;
+    sx_mem_init_writer(&writer, alloc, 0);
+    sx_mem_init_writer(&writer_old, alloc, 0);
+
+    bench_item_old old_items[16];
+    sx_memset(old_items, 0x0, sizeof(old_items));
+    for (int i = 0; i < 16; i++) {
+        old_items[i].scale = (double)i * 1.5;
+        old_items[i].id = (int64_t)i + 1000;
+        sx_snprintf(old_items[i].name, sizeof(old_items[i].name), "old_%d", i);
+    }
+
+    if (!the_refl->serialize_bin(g_refl.srz, &writer, g_refl.items, 16) ||
+        !the_refl->serialize_bin(g_refl.srz_old, &writer_old, old_items, 16)) {
+        check(false, "serialize_bin");
+        return;
+    }
+
+    // data of the older layout is remapped and converted
+    sx_mem_reader reader;
+    sx_mem_init_reader(&reader, writer_old.data, writer_old.pos);
+    sx_memset(g_refl.read_items, 0x0, sizeof(bench_item) * 16);
+    int count = the_refl->deserialize_bin(g_refl.srz, &reader, g_refl.read_items, 16, NULL);
+    bool remapped = count == 16;
+    for (int i = 0; i < count && remapped; i++) {
+        const bench_item* item = &g_refl.read_items[i];
+        remapped = item->scale == (float)old_items[i].scale && item->id == old_items[i].id &&
+                   sx_strequal(item->name, old_items[i].name) && item->width == 0;
+    }
+    check(remapped, "remap older layout");
+
+    check(read_corrupted(&writer, g_refl.srz, corrupt_packed_size) == -1, "negative packed size");
+    check(read_corrupted(&writer, g_refl.srz_old, corrupt_field_count) == -1,
+          "field count out of the item");
+    check(read_corrupted(&writer, g_refl.srz_old, corrupt_field_offset) == -1,
+          "field offset out of the item");
+    check(read_corrupted(&writer_old, g_refl.srz, corrupt_number_size) == -1,
+          "number field with a wrong size");
+    check(read_corrupted(&writer, g_refl.srz, corrupt_truncated) == -1, "truncated data");
+
+    sx_mem_release_writer(&writer);
+    sx_mem_release_writer(&writer_old);
+}
+
+static bool items_equal(const bench_item* a, const bench_item* b, int count)
+{
+    return sx_memcmp(a, b, sizeof(bench_item) * count) == 0;
+}
+
+static void report_bench(const char* name, double write_tm, double read_tm, bool roundtrip)
+{
+    printf("%-40s write: %8.2f k/s  read: %8.2f k/s  %s\n", name,
+           (double)NUM_ITEMS / write_tm / 1000.0, (double)NUM_ITEMS / read_tm / 1000.0,
+           roundtrip ? "" : "(roundtrip FAILED)");
+    g_refl.num_failed += roundtrip ? 0 : 1;
+}
+
+static void bench_json(bool reference)
+{
+    const sx_alloc* alloc = the_core->heap_alloc();
+    double write_tm = 0, read_tm = 0;
+    bool roundtrip = true;
+    for (int r = 0; r < NUM_RUNS; r++) {
+        uint64_t start = sx_tm_now();
+        char* json = reference ? meta_write(g_refl.items, NUM_ITEMS)
+                               : the_refl->serialize_json(g_refl.srz, g_refl.items, NUM_ITEMS,
+                                                          alloc);
+        double wtm = sx_tm_sec(sx_tm_since(start));
+        if (!json) {
+            roundtrip = false;
+            break;
+        }
+
+        sx_memset(g_refl.read_items, 0x0, sizeof(bench_item) * NUM_ITEMS);
+        start = sx_tm_now();
+        int count = reference ? meta_read(json, g_refl.read_items, NUM_ITEMS)
+                              : the_refl->deserialize_json(g_refl.srz, json, g_refl.read_items,
+                                                           NUM_ITEMS);
+        double rtm = sx_tm_sec(sx_tm_since(start));
+        sx_free(alloc, json);
+
+        roundtrip = roundtrip && count == NUM_ITEMS &&
+                    items_equal(g_refl.items, g_refl.read_items, NUM_ITEMS);
+        write_tm = r == 0 ? wtm : sx_min(write_tm, wtm);
+        read_tm = r == 0 ? rtm : sx_min(read_tm, rtm);
+    }
+
+    report_bench(reference ? "json: get_fields + meta_read_item" : "json: serializer", write_tm,
+                 read_tm, roundtrip);
+}
+
+static void bench_bin(void)
+{
+    sx_mem_writer writer;
+    sx_mem_init_writer(&writer, the_core->heap_alloc(), 0);
+
+    double write_tm = 0, read_tm = 0;
+    bool roundtrip = true;
+    for (int r = 0; r < NUM_RUNS; r++) {
+        sx_mem_seekw(&writer, 0, SX_WHENCE_BEGIN);
+        uint64_t start = sx_tm_now();
+        bool written = the_refl->serialize_bin(g_refl.srz, &writer, g_refl.items, NUM_ITEMS);
+        double wtm = sx_tm_sec(sx_tm_since(start));
+
+        sx_memset(g_refl.read_items, 0x0, sizeof(bench_item) * NUM_ITEMS);
+        sx_mem_reader reader;
+        sx_mem_init_reader(&reader, writer.data, writer.pos);
+        start = sx_tm_now();
+        int count =
+            the_refl->deserialize_bin(g_refl.srz, &reader, g_refl.read_items, NUM_ITEMS, NULL);
+        double rtm = sx_tm_sec(sx_tm_since(start));
+
+        roundtrip = roundtrip && written && count == NUM_ITEMS &&
+                    items_equal(g_refl.items, g_refl.read_items, NUM_ITEMS);
+        write_tm = r == 0 ? wtm : sx_min(write_tm, wtm);
+        read_tm = r == 0 ? rtm : sx_min(read_tm, rtm);
+    }
+
+    sx_mem_release_writer(&writer);
+    report_bench("binary: serializer", write_tm, read_tm, roundtrip);
+}
+
+static bool init()
+{
+    register_types();
+
+    const sx_alloc* alloc = the_core->heap_alloc();
+    g_refl.srz = the_refl->create_serializer("bench_item", 1);
+    g_refl.srz_old = the_refl->create_serializer("bench_item_old", 0);
+    g_refl.items = sx_malloc(alloc, sizeof(bench_item) * NUM_ITEMS);
+    g_refl.read_items = sx_malloc(alloc, sizeof(bench_item) * NUM_ITEMS);
+    if (!g_refl.srz || !g_refl.srz_old || !g_refl.items || !g_refl.read_items) {
+        rizz_log_error(the_core, "pg-refl: init failed");
+        return false;
+    }
+    make_items(g_refl.items, NUM_ITEMS);
+
+    test_corrupt_data();
+
+    printf("items: %d, best of %d runs\n", NUM_ITEMS, NUM_RUNS);
+    bench_json(true);
+    bench_json(false);
+    bench_bin();
+
+    if (g_refl.num_failed == 0) {
+        puts("pg-refl: all tests passed");
+    } else {
+        rizz_log_error(the_core, "pg-refl: %d tests failed", g_refl.num_failed);
+    }
+    return true;
+}
+
+static void shutdown()
+{
+    const sx_alloc* alloc = the_core->heap_alloc();
+    the_refl->destroy_serializer(g_refl.srz);
+    the_refl->destroy_serializer(g_refl.srz_old);
+    sx_free(alloc, g_refl.items);
+    sx_free(alloc, g_refl.read_items);
+}
+
+rizz_plugin_decl_main(refl, plugin, e)
+{
+    switch (e) {
+    case RIZZ_PLUGIN_EVENT_STEP:
+        the_app->quit();
+        break;
+
+    case RIZZ_PLUGIN_EVENT_INIT:
+        the_core = plugin->api->get_api(RIZZ_API_CORE, 0);
+        the_app = plugin->api->get_api(RIZZ_API_APP, 0);
+        the_refl = plugin->api->get_api(RIZZ_API_REFLECT, 0);
+        if (!init())
+            return -1;
+        break;
+
+    case RIZZ_PLUGIN_EVENT_LOAD:
+        break;
+
+    case RIZZ_PLUGIN_EVENT_UNLOAD:
+        break;
+
+    case RIZZ_PLUGIN_EVENT_SHUTDOWN:
+        shutdown();
+        break;
+    }
+
+    return 0;
+}
+
+rizz_plugin_decl_event_handler(refl, e)
+{
+    sx_unused(e);
+}
+
+rizz_game_decl_config(conf)
+{
+    conf->app_name = "pg-refl";
+    conf->app_version = 1000;
+    conf->app_title = "pg-refl";
+    conf->app_flags |= RIZZ_APP_FLAG_HEADLESS;
+    conf->core_flags |= RIZZ_CORE_FLAG_VERBOSE;
+}
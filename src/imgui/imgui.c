@@ -9,6 +9,7 @@
 #include "imguizmo/ImGuizmo.h"
 
 #include "rizz/app.h"
+#include "rizz/asset.h"
 #include "rizz/core.h"
 #include "rizz/graphics.h"
 #include "rizz/plugin.h"
@@ -1231,6 +1232,11 @@ static void imgui__graphics_debugger(const rizz_gfx_trace_info* info, bool* p_op
                 the__imgui.LabelText("Images", "%d", info->num_images);
                 the__imgui.LabelText("Buffers", "%d", info->num_buffers);
                 the__imgui.Separator();
+                the__imgui.LabelText("Pipeline cache", "%d hits / %d misses",
+                                     info->pip_cache_hits, info->pip_cache_misses);
+                the__imgui.LabelText("Shader cache", "%d hits / %d misses",
+                                     info->shader_cache_hits, info->shader_cache_misses);
+                the__imgui.Separator();
 
                 char size_text[32];
                 char peak_text[32];
@@ -1361,23 +1367,31 @@ static void imgui__memory_debugger(const rizz_mem_info* info, bool* p_open)
 
                 if (num_items) {
                     the__imgui.Separator();
-                    the__imgui.Columns(6, NULL, false);
+                    if (info->track_sample_rate > 1 || info->track_dropped_events > 0) {
+                        the__imgui.Text("Sample rate: 1/%d, Dropped events: %d",
+                                        info->track_sample_rate, info->track_dropped_events);
+                    }
+                    the__imgui.Separator();
+                    the__imgui.Columns(7, NULL, false);
                     the__imgui.SetColumnWidth(0, 35.0f);
                     the__imgui.Text("#");
                     the__imgui.NextColumn();
-                    the__imgui.SetColumnWidth(1, 150.0f);
-                    the__imgui.Text("Ptr");
-                    the__imgui.NextColumn();
-                    the__imgui.SetColumnWidth(2, 50.0f);
+                    the__imgui.SetColumnWidth(1, 60.0f);
                     the__imgui.Text("Size");
                     the__imgui.NextColumn();
-                    the__imgui.SetColumnWidth(3, 100.0f);
+                    the__imgui.SetColumnWidth(2, 60.0f);
+                    the__imgui.Text("Count");
+                    the__imgui.NextColumn();
+                    the__imgui.SetColumnWidth(3, 60.0f);
+                    the__imgui.Text("Peak");
+                    the__imgui.NextColumn();
+                    the__imgui.SetColumnWidth(4, 100.0f);
                     the__imgui.Text("File");
                     the__imgui.NextColumn();
-                    the__imgui.SetColumnWidth(4, 200.0f);
+                    the__imgui.SetColumnWidth(5, 200.0f);
                     the__imgui.Text("Function");
                     the__imgui.NextColumn();
-                    the__imgui.SetColumnWidth(5, 35.0f);
+                    the__imgui.SetColumnWidth(6, 35.0f);
                     the__imgui.Text("Line");
                     the__imgui.NextColumn();
                     the__imgui.Separator();
@@ -1386,7 +1400,7 @@ static void imgui__memory_debugger(const rizz_mem_info* info, bool* p_open)
                     the__imgui.BeginChild("AllocationList",
                                           sx_vec2f(the__imgui.GetWindowContentRegionWidth(), -1.0f),
                                           false, 0);
-                    the__imgui.Columns(6, NULL, false);
+                    the__imgui.Columns(7, NULL, false);
                     the__imgui.ImGuiListClipper_Begin(&clipper, num_items, -1.0f);
                     while (the__imgui.ImGuiListClipper_Step(&clipper)) {
                         int start = num_items - clipper.DisplayStart - 1;
@@ -1399,25 +1413,30 @@ static void imgui__memory_debugger(const rizz_mem_info* info, bool* p_open)
                             the__imgui.Text(text);
                             the__imgui.NextColumn();
 
-                            sx_snprintf(text, sizeof(text), "0x%p", mitem->ptr);
-                            the__imgui.SetColumnWidth(1, 150.0f);
+                            sx_snprintf(text, sizeof(text), "%$.2d", mitem->size);
+                            the__imgui.SetColumnWidth(1, 60.0f);
                             the__imgui.Text(text);
                             the__imgui.NextColumn();
 
-                            sx_snprintf(text, sizeof(text), "%$.2d", mitem->size);
-                            the__imgui.SetColumnWidth(2, 50.0f);
+                            sx_snprintf(text, sizeof(text), "%d", mitem->num_allocs);
+                            the__imgui.SetColumnWidth(2, 60.0f);
+                            the__imgui.Text(text);
+                            the__imgui.NextColumn();
+
+                            sx_snprintf(text, sizeof(text), "%$.2d", mitem->peak);
+                            the__imgui.SetColumnWidth(3, 60.0f);
                             the__imgui.Text(text);
                             the__imgui.NextColumn();
 
-                            the__imgui.SetColumnWidth(3, 100.0f);
+                            the__imgui.SetColumnWidth(4, 100.0f);
                             the__imgui.Text(mitem->file);
                             the__imgui.NextColumn();
 
-                            the__imgui.SetColumnWidth(4, 200.0f);
+                            the__imgui.SetColumnWidth(5, 200.0f);
                             the__imgui.Text(mitem->func);
                             the__imgui.NextColumn();
 
-                            the__imgui.SetColumnWidth(5, 35.0f);
+                            the__imgui.SetColumnWidth(6, 35.0f);
                             sx_snprintf(text, sizeof(text), "%d", mitem->line);
                             the__imgui.Text(text);
                             the__imgui.NextColumn();
@@ -1438,12 +1457,60 @@ static void imgui__memory_debugger(const rizz_mem_info* info, bool* p_open)
                 const rizz_linalloc_info* l = &info->temp_allocs[i];
                 sx_snprintf(text, sizeof(text), "Temp #%d", i + 1);
                 sx_snprintf(size_text, sizeof(size_text), "%$.2d", l->offset);
-                sx_snprintf(peak_text, sizeof(peak_text), "%$.2d", l->peak);
-                float o = (float)l->offset / (float)l->size;
-                float p = (float)l->peak / (float)l->size;
+                sx_snprintf(peak_text, sizeof(peak_text), "%$.2d", l->frame_peak);
+                // progress is relative to the committed memory, which grows/shrinks on demand
+                float committed = (float)sx_max(l->committed, 1);
+                float o = (float)l->offset / committed;
+                float p = (float)l->frame_peak / committed;
                 the__imgui.Text(text);
                 the__imgui.SameLine(100.0f, -1);
                 imgui__dual_progress_bar(o, p, sx_vec2f(-1.0f, 14.0f), size_text, peak_text);
+                if (the__imgui.IsItemHovered(0)) {
+                    char tooltip[128];
+                    sx_snprintf(tooltip, sizeof(tooltip),
+                                "Committed: %$.2d\nReserved: %$.2d\nPeak: %$.2d\n"
+                                "Heap fallback: %$.2d",
+                                l->committed, l->size, l->peak, l->fallback);
+                    the__imgui.SetTooltip("%s", tooltip);
+                }
+            }
+        }
+
+        if (the__imgui.CollapsingHeader("Fiber Stacks", 0)) {
+            const sx_fiber_stack_pool_class_info* classes[2] = { &info->fiber_stacks.small,
+                                                                 &info->fiber_stacks.large };
+            const char* names[2] = { "Small", "Large" };
+            char text[32];
+            char size_text[32];
+            char peak_text[32];
+            for (int i = 0; i < 2; i++) {
+                const sx_fiber_stack_pool_class_info* c = classes[i];
+                if (c->max_stacks == 0)
+                    continue;
+                // stacks: used and committed (used + warm) out of the maximum
+                sx_snprintf(text, sizeof(text), "%s (%$d)", names[i], c->stack_sz);
+                sx_snprintf(size_text, sizeof(size_text), "%d", c->num_used);
+                sx_snprintf(peak_text, sizeof(peak_text), "%d", c->num_committed);
+                the__imgui.Text(text);
+                the__imgui.SameLine(100.0f, -1);
+                imgui__dual_progress_bar((float)c->num_used / (float)c->max_stacks,
+                                         (float)c->num_committed / (float)c->max_stacks,
+                                         sx_vec2f(-1.0f, 14.0f), size_text, peak_text);
+                if (the__imgui.IsItemHovered(0)) {
+                    char tooltip[128];
+                    sx_snprintf(tooltip, sizeof(tooltip),
+                                "Used: %d\nCommitted: %d (%$.2d)\nMax: %d\nPeak usage: %$.2d",
+                                c->num_used, c->num_committed, c->committed_sz, c->max_stacks,
+                                c->peak_usage);
+                    the__imgui.SetTooltip("%s", tooltip);
+                }
+
+                // high-water mark of all stacks relative to the stack size
+                sx_snprintf(size_text, sizeof(size_text), "%$.2d", c->peak_usage);
+                the__imgui.Text("Peak");
+                the__imgui.SameLine(100.0f, -1);
+                the__imgui.ProgressBar((float)c->peak_usage / (float)c->stack_sz,
+                                       sx_vec2f(-1.0f, 14.0f), size_text);
             }
         }
     }
@@ -1451,9 +1518,56 @@ static void imgui__memory_debugger(const rizz_mem_info* info, bool* p_open)
     the__imgui.End();
 }
 
+static void imgui__asset_cache_debugger(const rizz_asset_cache_info* info, bool* p_open)
+{
+    static const char* k_memid_names[_RIZZ_MEMID_COUNT] = { "Core",  "Graphics", "Audio",
+                                                            "VFS",   "Reflect",  "Other",
+                                                            "Debug", "Toolset",  "Input",
+                                                            "Game" };
+
+    the__imgui.SetNextWindowSizeConstraints(sx_vec2f(400.0f, 100.0f), sx_vec2f(FLT_MAX, FLT_MAX),
+                                            NULL, NULL);
+    if (the__imgui.Begin("Asset Cache", p_open, 0)) {
+        int total = info->hits + info->misses;
+        float hit_rate = total > 0 ? (float)info->hits / (float)total : 0;
+
+        the__imgui.Columns(2, NULL, false);
+        the__imgui.LabelText("Resident", "%d", info->num_resident);
+        the__imgui.LabelText("Hit rate", "%.1f%%", hit_rate * 100.0f);
+        the__imgui.NextColumn();
+        the__imgui.LabelText("Hits/Misses", "%d/%d", info->hits, info->misses);
+        the__imgui.LabelText("Evictions", "%d", info->evictions);
+        the__imgui.Columns(1, NULL, false);
+        the__imgui.Separator();
+
+        char size_text[64];
+        char resident_text[32];
+        char budget_text[32];
+        const sx_vec2 progress_size = sx_vec2f(-1.0f, 14.0f);
+        for (int i = 0; i < _RIZZ_MEMID_COUNT; i++) {
+            int64_t budget = info->budget_bytes[i];
+            int64_t resident = info->resident_bytes[i];
+            if (budget <= 0 && resident == 0) {
+                continue;
+            }
+
+            sx_snprintf(resident_text, sizeof(resident_text), "%$.2d", resident);
+            sx_snprintf(budget_text, sizeof(budget_text), "%$.2d", budget);
+            sx_snprintf(size_text, sizeof(size_text), "%s / %s", resident_text, budget_text);
+
+            the__imgui.Text("%s", k_memid_names[i]);
+            the__imgui.SameLine(100.0f, -1);
+            the__imgui.ProgressBar(budget > 0 ? (float)resident / (float)budget : 0,
+                                   progress_size, size_text);
+        }
+    }
+    the__imgui.End();
+}
+
 static rizz_api_imgui_extra the__imgui_debug_tools = {
     .memory_debugger = imgui__memory_debugger,
     .graphics_debugger = imgui__graphics_debugger,
+    .asset_cache_debugger = imgui__asset_cache_debugger,
     .begin_fullscreen_draw = imgui__begin_fullscreen_draw,
     .draw_cursor = imgui__draw_cursor,
     .project_to_screen = imgui__project_to_screen,
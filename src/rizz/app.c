@@ -11,11 +11,15 @@
 #include "rizz/ios.h"
 
 #include "sx/allocator.h"
+#include "sx/array.h"
 #include "sx/cmdline.h"
+#include "sx/io.h"
 #include "sx/os.h"
 #include "sx/string.h"
+#include "sx/timer.h"
 
 #include <stdio.h>
+#include <stdlib.h>
 
 #include "Remotery.h"
 
@@ -38,12 +42,77 @@
 #    include "plugin_bundle.h"
 #endif
 
+// record/replay log: header, followed by records. each record starts with a
+// `rizz__replay_record_type` byte:
+//      FRAME: uint64_t delta time of the frame in nanoseconds
+//      EVENT: rizz__replay_event, touch points, native event payload (platform specific)
+// events are written in the order they are received, so they are replayed before the same frame
+#define RIZZ__REPLAY_SIGN 0x50525a52    // "RZRP"
+#define RIZZ__REPLAY_VERSION 1
+
+typedef enum {
+    RIZZ__REPLAY_RECORD_FRAME = 1,
+    RIZZ__REPLAY_RECORD_EVENT
+} rizz__replay_record_type;
+
+typedef struct {
+    uint32_t sign;
+    uint32_t version;
+    uint32_t native_event_size;    // size of native event payloads on the recording platform
+    uint32_t rng_seed;
+    int32_t window_width;
+    int32_t window_height;
+} rizz__replay_header;
+
+typedef struct {
+    uint16_t type;
+    uint16_t key_code;
+    uint32_t char_code;
+    uint8_t key_repeat;
+    uint8_t modkeys;
+    int8_t mouse_button;
+    uint8_t num_touches;
+    float mouse_x;
+    float mouse_y;
+    float scroll_x;
+    float scroll_y;
+    int32_t window_width;
+    int32_t window_height;
+    int32_t framebuffer_width;
+    int32_t framebuffer_height;
+    uint32_t native_size;    // 0 if the event doesn't have a native payload
+} rizz__replay_event;
+
+typedef struct {
+    bool recording;
+    bool replaying;
+    bool finished;    // replay: end of the log is reached
+    sx_file_writer writer;
+    sx_file_reader reader;
+    int64_t read_remain;    // replay: unread bytes of the file
+    char filepath[RIZZ_MAX_PATH];
+} rizz__replay;
+
+// headless: the app runs its own loop instead of sokol_app (no window and no gpu device)
+typedef struct {
+    bool enabled;
+    int max_frames;         // =0: no limit
+    double timestep;        // command-line (ms), converted to `fixed_tick` on init
+    double max_time;        // command-line (seconds), converted to `max_tick` on init
+    uint64_t fixed_tick;    // fixed timestep, =0: unlocked (measured) timestep
+    uint64_t max_tick;      // limit of app time (sum of timesteps), =0: no limit
+} rizz__headless;
+
 typedef struct {
     rizz_config conf;
     const sx_alloc* alloc;
     char game_filepath[RIZZ_MAX_PATH];
     sx_vec2 window_size;
     bool keys_pressed[RIZZ_APP_MAX_KEYCODES];
+    rizz__replay replay;
+    rizz__headless headless;
+    float* frame_times;    // sx_array: replay/headless: cpu time of each frame (ms)
+    uint64_t start_tick;
 } rizz__app;
 
 static rizz__app g_app;
@@ -89,6 +158,234 @@ SX_PRAGMA_DIAGNOSTIC_POP();
 RIZZ_PLUGIN_EXPORT void rizz_game_config(rizz_config*, int argc, char* argv[]);
 #endif
 
+// native events are passed to plugins (input), so they are also recorded. window handles inside
+// them are patched with the current ones on replay
+#if SX_PLATFORM_WINDOWS
+#    define RIZZ__REPLAY_NATIVE_EVENT_SIZE sizeof(MSG)
+#elif SX_PLATFORM_LINUX
+#    define RIZZ__REPLAY_NATIVE_EVENT_SIZE sizeof(XEvent)
+#else
+#    define RIZZ__REPLAY_NATIVE_EVENT_SIZE 0
+#endif
+
+static void rizz__app_dispatch_event(const rizz_app_event* e);
+
+static void rizz__replay_patch_native_event(void* native_event)
+{
+#if SX_PLATFORM_WINDOWS
+    ((MSG*)native_event)->hwnd = _sapp_win32_hwnd;
+#elif SX_PLATFORM_LINUX
+    ((XEvent*)native_event)->xany.display = _sapp_x11_display;
+    ((XEvent*)native_event)->xany.window = _sapp_x11_window;
+#else
+    sx_unused(native_event);
+#endif
+}
+
+// reading past the end of the file is a normal case (end of the replay), so it's checked before
+// reading, instead of hitting truncation asserts of `sx_file_read`
+static bool rizz__replay_read(void* data, int size)
+{
+    rizz__replay* r = &g_app.replay;
+    if (r->read_remain < size)
+        return false;
+    r->read_remain -= size;
+    return sx_file_read(&r->reader, data, size) == size;
+}
+
+static bool rizz__replay_open(const char* filepath, bool record)
+{
+    rizz__replay* r = &g_app.replay;
+    sx_strcpy(r->filepath, sizeof(r->filepath), filepath);
+
+    if (record) {
+        if (!sx_file_open_writer(&r->writer, filepath, 0)) {
+            rizz_log_error("replay: could not open '%s' for recording", filepath);
+            return false;
+        }
+        rizz__replay_header header = { .sign = RIZZ__REPLAY_SIGN,
+                                       .version = RIZZ__REPLAY_VERSION,
+                                       .native_event_size = RIZZ__REPLAY_NATIVE_EVENT_SIZE,
+                                       .rng_seed = rizz__core_rng_seed(),
+                                       .window_width = g_app.conf.window_width,
+                                       .window_height = g_app.conf.window_height };
+        sx_file_write_var(&r->writer, header);
+        r->recording = true;
+        rizz_log_info("replay: recording to '%s'", filepath);
+    } else {
+        rizz__replay_header header;
+        if (!sx_file_open_reader(&r->reader, filepath)) {
+            rizz_log_error("replay: could not open '%s'", filepath);
+            return false;
+        }
+        r->read_remain = sx_file_seekr(&r->reader, 0, SX_WHENCE_END);
+        sx_file_seekr(&r->reader, 0, SX_WHENCE_BEGIN);
+        if (!rizz__replay_read(&header, sizeof(header)) || header.sign != RIZZ__REPLAY_SIGN ||
+            header.version != RIZZ__REPLAY_VERSION) {
+            rizz_log_error("replay: invalid file or version: %s", filepath);
+            sx_file_close_reader(&r->reader);
+            return false;
+        }
+        if (header.native_event_size != RIZZ__REPLAY_NATIVE_EVENT_SIZE) {
+            rizz_log_error("replay: '%s' is recorded on another platform", filepath);
+            sx_file_close_reader(&r->reader);
+            return false;
+        }
+        if (header.window_width != g_app.conf.window_width ||
+            header.window_height != g_app.conf.window_height) {
+            rizz_log_warn("replay: recorded window size is different (%dx%d)",
+                          header.window_width, header.window_height);
+        }
+
+        rizz__core_set_rng_seed(header.rng_seed);
+        r->replaying = true;
+        g_app.start_tick = sx_tm_now();
+        rizz_log_info("replay: replaying '%s'", filepath);
+    }
+    return true;
+}
+
+static void rizz__replay_record_event(const rizz_app_event* e)
+{
+    rizz__replay* r = &g_app.replay;
+    uint32_t native_size = e->native_event ? (uint32_t)RIZZ__REPLAY_NATIVE_EVENT_SIZE : 0;
+    rizz__replay_event re = { .type = (uint16_t)e->type,
+                              .key_code = (uint16_t)e->key_code,
+                              .char_code = e->char_code,
+                              .key_repeat = e->key_repeat ? 1 : 0,
+                              .modkeys = (uint8_t)e->modkeys,
+                              .mouse_button = (int8_t)e->mouse_button,
+                              .num_touches = (uint8_t)e->num_touches,
+                              .mouse_x = e->mouse_x,
+                              .mouse_y = e->mouse_y,
+                              .scroll_x = e->scroll_x,
+                              .scroll_y = e->scroll_y,
+                              .window_width = e->window_width,
+                              .window_height = e->window_height,
+                              .framebuffer_width = e->framebuffer_width,
+                              .framebuffer_height = e->framebuffer_height,
+                              .native_size = native_size };
+
+    uint8_t type = RIZZ__REPLAY_RECORD_EVENT;
+    sx_file_write_var(&r->writer, type);
+    sx_file_write_var(&r->writer, re);
+    if (e->num_touches > 0) {
+        sx_file_write(&r->writer, e->touches, e->num_touches * (int)sizeof(rizz_touch_point));
+    }
+    if (native_size > 0) {
+        sx_file_write(&r->writer, e->native_event, (int)native_size);
+    }
+}
+
+static void rizz__replay_record_frame(uint64_t delta_tick)
+{
+    uint8_t type = RIZZ__REPLAY_RECORD_FRAME;
+    uint64_t delta_ns = (uint64_t)sx_tm_ns(delta_tick);
+    sx_file_write_var(&g_app.replay.writer, type);
+    sx_file_write_var(&g_app.replay.writer, delta_ns);
+}
+
+// reads and dispatches the events of the next frame, returns false if end of the log is reached
+static bool rizz__replay_next_frame(uint64_t* delta_tick)
+{
+    rizz__replay* r = &g_app.replay;
+    uint8_t type;
+    while (rizz__replay_read(&type, sizeof(type))) {
+        if (type == RIZZ__REPLAY_RECORD_FRAME) {
+            uint64_t delta_ns;
+            if (!rizz__replay_read(&delta_ns, sizeof(delta_ns)))
+                break;
+            *delta_tick = (uint64_t)((double)delta_ns / sx_tm_ns(1) + 0.5);
+            return true;
+        } else if (type == RIZZ__REPLAY_RECORD_EVENT) {
+            rizz__replay_event re;
+            if (!rizz__replay_read(&re, sizeof(re)) ||
+                re.num_touches > RIZZ_APP_MAX_TOUCHPOINTS ||
+                re.native_size != RIZZ__REPLAY_NATIVE_EVENT_SIZE * (re.native_size ? 1 : 0)) {
+                break;
+            }
+
+            rizz_app_event e = { .frame_count = (uint64_t)the__core.frame_index(),
+                                 .type = (rizz_app_event_type)re.type,
+                                 .key_code = (rizz_keycode)re.key_code,
+                                 .char_code = re.char_code,
+                                 .key_repeat = re.key_repeat != 0,
+                                 .modkeys = (rizz_modifier_keys)re.modkeys,
+                                 .mouse_button = (rizz_mouse_btn)re.mouse_button,
+                                 .mouse_x = re.mouse_x,
+                                 .mouse_y = re.mouse_y,
+                                 .scroll_x = re.scroll_x,
+                                 .scroll_y = re.scroll_y,
+                                 .num_touches = re.num_touches,
+                                 .window_width = re.window_width,
+                                 .window_height = re.window_height,
+                                 .framebuffer_width = re.framebuffer_width,
+                                 .framebuffer_height = re.framebuffer_height };
+            int touches_size = re.num_touches * (int)sizeof(rizz_touch_point);
+            if (touches_size > 0 && !rizz__replay_read(e.touches, touches_size))
+                break;
+
+            // there is no native window in headless mode, so native events are not passed
+            sx_align_decl(16, uint8_t) native_event[RIZZ__REPLAY_NATIVE_EVENT_SIZE + 1];
+            if (re.native_size > 0) {
+                if (!rizz__replay_read(native_event, (int)re.native_size))
+                    break;
+                if (!g_app.headless.enabled) {
+                    rizz__replay_patch_native_event(native_event);
+                    e.native_event = native_event;
+                }
+            }
+
+            rizz__app_dispatch_event(&e);
+        } else {
+            rizz_log_error("replay: corrupt file: %s", r->filepath);
+            break;
+        }
+    }
+    return false;
+}
+
+static int rizz__app_frame_time_sort_cb(const void* a, const void* b)
+{
+    float fa = *(const float*)a;
+    float fb = *(const float*)b;
+    return fa < fb ? -1 : (fa > fb ? 1 : 0);
+}
+
+// timing summary of replay/headless runs, frame times are sorted in place
+static void rizz__app_report_frame_times()
+{
+    int num_frames = sx_array_count(g_app.frame_times);
+    if (num_frames == 0)
+        return;
+
+    float* frame_times = g_app.frame_times;
+    double total = 0;
+    for (int i = 0; i < num_frames; i++)
+        total += frame_times[i];
+    qsort(frame_times, (size_t)num_frames, sizeof(float), rizz__app_frame_time_sort_cb);
+
+    rizz_log_info("\tframes: %d, total: %.1f ms (wall: %.1f ms)", num_frames, total,
+                  sx_tm_ms(sx_tm_since(g_app.start_tick)));
+    rizz_log_info("\tframe (ms): avg: %.3f, min: %.3f, max: %.3f", total / (double)num_frames,
+                  frame_times[0], frame_times[num_frames - 1]);
+    rizz_log_info("\tframe (ms): p50: %.3f, p95: %.3f, p99: %.3f", frame_times[num_frames / 2],
+                  frame_times[num_frames * 95 / 100], frame_times[num_frames * 99 / 100]);
+}
+
+static void rizz__replay_close()
+{
+    rizz__replay* r = &g_app.replay;
+    if (r->recording) {
+        sx_file_close_writer(&r->writer);
+        r->recording = false;
+    }
+    if (r->replaying) {
+        sx_file_close_reader(&r->reader);
+        r->replaying = false;
+    }
+}
+
 static void rizz__app_init(void)
 {
 #if SX_PLATFORM_ANDROID
@@ -143,35 +440,89 @@ static void rizz__app_init(void)
     }
 #endif
 
+    // open record/replay log before plugins are initialized, so they get the recorded rng seed
+    if (g_app.replay.filepath[0]) {
+        if (!rizz__replay_open(g_app.replay.filepath, g_app.replay.recording)) {
+            exit(-1);
+        }
+    }
+
     // initialize all plugins
     if (!rizz__plugin_init_plugins()) {
         rizz_log_error("initializing plugins failed");
         exit(-1);
     }
+
+    if (g_app.headless.enabled) {
+        // timer is initialized by core
+        rizz__headless* h = &g_app.headless;
+        h->fixed_tick = h->timestep > 0 ? (uint64_t)(h->timestep * 1e6 / sx_tm_ns(1) + 0.5) : 0;
+        h->max_tick = h->max_time > 0 ? (uint64_t)(h->max_time * 1e9 / sx_tm_ns(1) + 0.5) : 0;
+        if (!g_app.replay.replaying)
+            g_app.start_tick = sx_tm_now();
+    }
 }
 
 static void rizz__app_frame(void)
 {
-    rizz__core_frame();
+    rizz__replay* r = &g_app.replay;
+    rizz__headless* h = &g_app.headless;
+    if (r->replaying) {
+        if (r->finished)
+            return;
+
+        uint64_t delta_tick;
+        if (rizz__replay_next_frame(&delta_tick)) {
+            uint64_t start_tick = sx_tm_now();
+            rizz__core_frame_with_delta(delta_tick);
+            sx_array_push(g_app.alloc, g_app.frame_times,
+                          (float)sx_tm_ms(sx_tm_since(start_tick)));
+        } else {
+            r->finished = true;
+            rizz_log_info("replay: finished '%s'", r->filepath);
+            rizz__app_report_frame_times();
+            sapp_quit();
+        }
+    } else if (h->enabled) {
+        uint64_t start_tick = sx_tm_now();
+        if (h->fixed_tick > 0) {
+            rizz__core_frame_with_delta(h->fixed_tick);
+        } else {
+            rizz__core_frame();
+        }
+        sx_array_push(g_app.alloc, g_app.frame_times, (float)sx_tm_ms(sx_tm_since(start_tick)));
+        if (r->recording)
+            rizz__replay_record_frame(the__core.delta_tick());
+    } else {
+        rizz__core_frame();
+        if (r->recording)
+            rizz__replay_record_frame(the__core.delta_tick());
+    }
+
+    if (h->enabled) {
+        if ((h->max_frames > 0 && sx_array_count(g_app.frame_times) >= h->max_frames) ||
+            (h->max_tick > 0 && the__core.elapsed_tick() >= h->max_tick)) {
+            sapp_quit();
+        }
+    }
 }
 
 static void rizz__app_cleanup(void)
 {
+    // replay reports its own timing when it reaches the end
+    if (g_app.headless.enabled && !g_app.replay.finished) {
+        rizz_log_info("headless: finished (%s timestep)",
+                      g_app.headless.fixed_tick > 0 ? "fixed" : "unlocked");
+        rizz__app_report_frame_times();
+    }
+    sx_array_free(g_app.alloc, g_app.frame_times);
+
+    rizz__replay_close();
     rizz__core_release();
 }
 
-static void rizz__app_event(const sapp_event* e)
+static void rizz__app_dispatch_event(const rizz_app_event* e)
 {
-    static_assert(sizeof(rizz_app_event) == sizeof(sapp_event),
-                  "sapp_event is not identical to rizz_app_event");
-    static_assert(_RIZZ_APP_EVENTTYPE_NUM == _SAPP_EVENTTYPE_NUM,
-                  "rizz_app_event_type does not match sokol");
-    static_assert(offsetof(sapp_event, framebuffer_height) ==
-                      offsetof(rizz_app_event, framebuffer_height),
-                  "sapp_event is not identical to rizz_app_event");
-    static_assert(sizeof(sapp_event) == sizeof(rizz_app_event),
-                  "sapp_event is not identical to rizz_app_event");
-
     switch (e->type) {
     case RIZZ_APP_EVENTTYPE_RESIZED:
         g_app.conf.window_width = e->window_width;
@@ -193,7 +544,28 @@ static void rizz__app_event(const sapp_event* e)
     }
 
     // broadcast to plugins
-    rizz__plugin_broadcast_event((const rizz_app_event*)e);
+    rizz__plugin_broadcast_event(e);
+}
+
+static void rizz__app_event(const sapp_event* e)
+{
+    static_assert(sizeof(rizz_app_event) == sizeof(sapp_event),
+                  "sapp_event is not identical to rizz_app_event");
+    static_assert(_RIZZ_APP_EVENTTYPE_NUM == _SAPP_EVENTTYPE_NUM,
+                  "rizz_app_event_type does not match sokol");
+    static_assert(offsetof(sapp_event, framebuffer_height) ==
+                      offsetof(rizz_app_event, framebuffer_height),
+                  "sapp_event is not identical to rizz_app_event");
+    static_assert(sizeof(sapp_event) == sizeof(rizz_app_event),
+                  "sapp_event is not identical to rizz_app_event");
+
+    // live events are ignored while replaying, except closing the window
+    if (g_app.replay.replaying && e->type != SAPP_EVENTTYPE_QUIT_REQUESTED)
+        return;
+    if (g_app.replay.recording)
+        rizz__replay_record_event((const rizz_app_event*)e);
+
+    rizz__app_dispatch_event((const rizz_app_event*)e);
 }
 
 static void rizz__app_fail(const char* msg)
@@ -201,6 +573,24 @@ static void rizz__app_fail(const char* msg)
     rizz_log_error(msg);
 }
 
+// runs the same callbacks as sokol_app, but without creating a window or a graphics context
+// quit requests are handled the same way as sokol_app's event loop
+static int rizz__app_run_headless(const sapp_desc* desc)
+{
+    _sapp_init_state(desc);
+    while (!_sapp.quit_ordered) {
+        _sapp_frame();
+        if (_sapp.quit_requested) {
+            _sapp_init_event(SAPP_EVENTTYPE_QUIT_REQUESTED);
+            _sapp_call_event(&_sapp.event);
+            if (_sapp.quit_requested)
+                _sapp.quit_ordered = true;
+        }
+    }
+    _sapp_call_cleanup();
+    return 0;
+}
+
 static void rizz__app_show_help(sx_cmdline_context* cmdline)
 {
     char buff[4096];
@@ -213,7 +603,11 @@ sapp_desc sokol_main(int argc, char* argv[])
 {
     g_app.alloc = sx_alloc_malloc();
 
-    int profile_gpu = 0, dump_unused_assets = 0;
+    int profile_gpu = 0, dump_unused_assets = 0, headless = 0;
+    int max_frames = 0;
+    double max_time = 0, timestep = 0;
+    const char* record_filepath = NULL;
+    const char* replay_filepath = NULL;
 
 #ifndef RIZZ_BUNDLE
     int version = 0, show_help = 0;
@@ -224,6 +618,19 @@ sapp_desc sokol_main(int argc, char* argv[])
           0x0 },
         { "dump-unused-assets", 'U', SX_CMDLINE_OPTYPE_FLAG_SET, &dump_unused_assets, 1,
           "Dump unused assets into `unused-assets.json`", 0x0 },
+        { "record", 'R', SX_CMDLINE_OPTYPE_REQUIRED, 0x0, 'R',
+          "Record app events and frame times to file", "filepath" },
+        { "replay", 'P', SX_CMDLINE_OPTYPE_REQUIRED, 0x0, 'P',
+          "Replay recorded events and frame times from file, prints timing at the end",
+          "filepath" },
+        { "headless", 'H', SX_CMDLINE_OPTYPE_FLAG_SET, &headless, 1,
+          "Run without a window, gpu and audio device (dummy graphics backend)", 0x0 },
+        { "frames", 'n', SX_CMDLINE_OPTYPE_REQUIRED, 0x0, 'n', "Headless: quit after N frames",
+          "count" },
+        { "time", 't', SX_CMDLINE_OPTYPE_REQUIRED, 0x0, 't',
+          "Headless: quit after N seconds of app time", "seconds" },
+        { "timestep", 's', SX_CMDLINE_OPTYPE_REQUIRED, 0x0, 's',
+          "Headless: fixed timestep in milliseconds (default: unlocked)", "msecs" },
         { "help", 'h', SX_CMDLINE_OPTYPE_FLAG_SET, &show_help, 1, "Show this help message", 0x0 },
         SX_CMDLINE_OPT_END
     };
@@ -250,6 +657,21 @@ sapp_desc sokol_main(int argc, char* argv[])
         case 'r':
             game_filepath = arg;
             break;
+        case 'R':
+            record_filepath = arg;
+            break;
+        case 'P':
+            replay_filepath = arg;
+            break;
+        case 'n':
+            max_frames = sx_toint(arg);
+            break;
+        case 't':
+            max_time = sx_todouble(arg);
+            break;
+        case 's':
+            timestep = sx_todouble(arg);
+            break;
         default:
             break;
         }
@@ -264,6 +686,24 @@ sapp_desc sokol_main(int argc, char* argv[])
         puts("provide a game module to run (--run)");
         exit(-1);
     }
+
+    if (record_filepath && replay_filepath) {
+        puts("--record and --replay cannot be used together");
+        exit(-1);
+    }
+
+    if (!headless && (max_frames > 0 || max_time > 0 || timestep > 0)) {
+        puts("--frames, --time and --timestep are only used with --headless");
+    }
+
+    // paths are kept before the command-line is destroyed, the file is opened on app init
+    if (record_filepath || replay_filepath) {
+        const char* filepath = record_filepath ? record_filepath : replay_filepath;
+        // abspath fails for files that don't exist yet (recording), keep the path as it is
+        if (!sx_os_path_abspath(g_app.replay.filepath, sizeof(g_app.replay.filepath), filepath)[0])
+            sx_strcpy(g_app.replay.filepath, sizeof(g_app.replay.filepath), filepath);
+        g_app.replay.recording = record_filepath != NULL;
+    }
     if (!sx_os_path_isfile(game_filepath)) {
         printf("Game module '%s' does not exist\n", game_filepath);
         exit(-1);
@@ -323,6 +763,7 @@ sapp_desc sokol_main(int argc, char* argv[])
                          .job_stack_size = 1024,
                          .coro_max_fibers = 64,
                          .coro_stack_size = 2048,
+                         .mem_sample_rate = 1,
                          .profiler_listen_port = 17815,    // default remotery port
                          .profiler_update_interval_ms = 10 };
 
@@ -330,9 +771,15 @@ sapp_desc sokol_main(int argc, char* argv[])
         conf.core_flags |= RIZZ_CORE_FLAG_PROFILE_GPU;
     if (dump_unused_assets)
         conf.core_flags |= RIZZ_CORE_FLAG_DUMP_UNUSED_ASSETS;
+    if (headless)
+        conf.app_flags |= RIZZ_APP_FLAG_HEADLESS;
 
     game_config_fn(&conf, argc, argv);
 
+    // game config can't turn off headless mode that is requested from command-line
+    if (headless)
+        conf.app_flags |= RIZZ_APP_FLAG_HEADLESS;
+
     // create .cache directory if it doesn't exist
     if (!conf.cache_path && !sx_os_path_isdir(default_cache_path))
         sx_os_mkdir(default_cache_path);
@@ -358,7 +805,7 @@ sapp_desc sokol_main(int argc, char* argv[])
     sx_strcpy(g_app.game_filepath, sizeof(g_app.game_filepath), game_filepath);
     g_app.window_size = sx_vec2f((float)conf.window_width, (float)conf.window_height);
 
-    return (
+    sapp_desc desc = (
         sapp_desc){ .init_cb = rizz__app_init,
                     .frame_cb = rizz__app_frame,
                     .cleanup_cb = rizz__app_cleanup,
@@ -377,6 +824,17 @@ sapp_desc sokol_main(int argc, char* argv[])
                         (conf.app_flags & RIZZ_APP_FLAG_IOS_KEYBOARD_RESIZES_CANVAS) ? true : false,
                     .user_cursor = (conf.app_flags & RIZZ_APP_FLAG_USER_CURSOR) ? true : false,
                     .gl_force_gles2 = (conf.app_flags & RIZZ_APP_FLAG_FORCE_GLES2) ? true : false };
+
+    if (conf.app_flags & RIZZ_APP_FLAG_HEADLESS) {
+        rizz__headless* h = &g_app.headless;
+        h->enabled = true;
+        h->max_frames = max_frames;
+        h->timestep = timestep;
+        h->max_time = max_time;
+        exit(rizz__app_run_headless(&desc));
+    }
+
+    return desc;
 }
 
 static sx_vec2 rizz__app_sizef()
@@ -394,11 +852,18 @@ static bool rizz__app_key_pressed(rizz_keycode key)
     return g_app.keys_pressed[key];
 }
 
-void rizz__app_init_gfx_desc(sg_desc* desc)
+static bool rizz__app_headless()
 {
-    sx_assert(sapp_isvalid());
+    return g_app.headless.enabled;
+}
 
+void rizz__app_init_gfx_desc(sg_desc* desc)
+{
     sx_memset(desc, 0x0, sizeof(sg_desc));
+    if (g_app.headless.enabled)
+        return;    // dummy graphics backend doesn't need any bindings
+
+    sx_assert(sapp_isvalid());
     desc->gl_force_gles2 = sapp_gles2();
     desc->mtl_device = sapp_metal_get_device();
     desc->mtl_renderpass_descriptor_cb = sapp_metal_get_renderpass_descriptor;
@@ -441,4 +906,5 @@ rizz_api_app the__app = { .width = sapp_width,
                           .request_quit = sapp_request_quit,
                           .cancel_quit = sapp_cancel_quit,
                           .show_mouse = sapp_show_mouse,
-                          .mouse_shown = sapp_mouse_shown };
+                          .mouse_shown = sapp_mouse_shown,
+                          .headless = rizz__app_headless };
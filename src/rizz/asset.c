@@ -38,6 +38,7 @@ typedef struct {
     rizz_asset_obj async_obj;
     uint8_t* params_buff;                  // sx_array (byte-array, item-size: params_size)
     uint8_t* metadata_buff;                // sx_array (byte-array, item-size: metadata_size)
+    rizz_refl_serializer* metadata_srz;    // created on first use (asset database)
     rizz_asset_load_flags forced_flags;    // these flags are foced upon every load-call
     bool unreg;
 } rizz__asset_mgr;
@@ -58,6 +59,11 @@ typedef struct {
     uint32_t tags;
     rizz_asset_load_flags load_flags;
     rizz_asset_state state;
+    int64_t cache_size;    // size reported by `on_get_size`, when the asset is cached
+    int lru_prev;          // index-to: rizz__asset_lib.assets (LRU links, -1 if none)
+    int lru_next;
+    uint8_t cache_memid;
+    bool cached;    // zero refcount, but resident in asset cache
 } rizz__asset;
 
 // Resources are the actual files on the file-system
@@ -101,10 +107,45 @@ typedef sx_align_decl(8, struct) rizz__asset_async_job
 }
 rizz__asset_async_job;
 
+// Synchronous loads (WAIT_ON_LOAD and reloads) are processed in batches:
+// files are read and decoded (`on_load`) on worker threads in parallel, but metadata, `on_prepare`
+// and `on_finalize` run on the main thread in the order of the batch
+typedef struct {
+    uint32_t name_hash;
+    char path[RIZZ_MAX_PATH];
+    const void* params;    // points to a copy that is owned by the batch
+    const sx_alloc* alloc;
+    uint32_t tags;
+    rizz_asset_load_flags flags;
+    rizz_asset asset;    // result
+    int asset_mgr_id;
+    char real_path[RIZZ_MAX_PATH];
+    rizz_asset_load_data load_data;
+    sx_mem_block* mem;
+    bool done;      // asset is already loaded, only the refcount is added
+    bool loaded;    // result of `on_load`
+} rizz__asset_batch_item;
+
+typedef struct {
+    rizz__asset_batch_item* items;
+    int count;
+} rizz__asset_batch;
+
 typedef struct {
     rizz_asset* assets;    // sx_array
 } rizz__asset_group;
 
+typedef struct {
+    int64_t budget_bytes[_RIZZ_MEMID_COUNT];
+    int64_t resident_bytes[_RIZZ_MEMID_COUNT];
+    int first[_RIZZ_MEMID_COUNT];    // oldest entry (evicted first), index-to: assets
+    int last[_RIZZ_MEMID_COUNT];     // newest entry
+    int num_resident;
+    int hits;
+    int misses;
+    int evictions;
+} rizz__asset_cache;
+
 typedef struct {
     const sx_alloc* alloc;    // allocator passed on init
     char asset_db_file[RIZZ_MAX_PATH];
@@ -127,6 +168,7 @@ typedef struct {
     sx_handle_pool* group_handles;
     rizz_asset_group cur_group;
     sx_lock_t assets_lk;    // used for locking assets-array
+    rizz__asset_cache cache;
 } rizz__asset_lib;
 
 static rizz__asset_lib g_asset;
@@ -294,6 +336,25 @@ static void rizz__asset_on_write_complete(const char* path, int bytes_written, s
     sx_unused(mem);
 }
 
+static void rizz__asset_load_batch_items(rizz__asset_batch_item* items, int count);
+static int rizz__asset_reload_batch(bool (*filter_cb)(const rizz__asset* a, uintptr_t value),
+                                    uintptr_t value);
+
+static bool rizz__asset_filter_resource(const rizz__asset* a, uintptr_t resource_id)
+{
+    return a->resource_id == (uint32_t)resource_id;
+}
+
+static bool rizz__asset_filter_type(const rizz__asset* a, uintptr_t asset_mgr_id)
+{
+    return a->asset_mgr_id == (int)asset_mgr_id;
+}
+
+static bool rizz__asset_filter_tags(const rizz__asset* a, uintptr_t tags)
+{
+    return (a->tags & (uint32_t)tags) != 0;
+}
+
 static void rizz__asset_on_modified(const char* path)
 {
     sx_assert(RIZZ_CONFIG_HOT_LOADING);
@@ -307,22 +368,8 @@ static void rizz__asset_on_modified(const char* path)
         if (g_asset.resources[i].path_hash == path_hash) {
             g_asset.resources[i].last_modified = the__vfs.last_modified(path);
 
-            uint32_t resource_id = rizz_to_id(i);
-            // find any asset that have this resource and reload it
-            for (int k = 0, kc = g_asset.asset_handles->count; k < kc; k++) {
-                sx_handle_t handle = sx_handle_at(g_asset.asset_handles, k);
-                rizz__asset* a = &g_asset.assets[sx_handle_index(handle)];
-                if (a->resource_id == resource_id) {
-                    rizz__asset_mgr* amgr = &g_asset.asset_mgrs[a->asset_mgr_id];
-                    const void* params_ptr = NULL;
-                    if (a->params_id)
-                        params_ptr = &amgr->params_buff[rizz_to_index(a->params_id)];
-
-                    // always reloads in `blocking` mode
-                    rizz__asset_load_hashed(amgr->name_hash, unixpath, params_ptr,
-                                            RIZZ_ASSET_LOAD_FLAG_RELOAD, a->alloc, a->tags);
-                }
-            }
+            // find any asset that have this resource and reload it (always in `blocking` mode)
+            rizz__asset_reload_batch(rizz__asset_filter_resource, rizz_to_id(i));
 
             break;
         }
@@ -351,94 +398,11 @@ static inline int rizz__asset_find_asset_mgr(uint32_t name_hash)
 }
 
 // asset database
-static void rizz__asset_meta_read_item(const rizz_refl_field* f, sjson_node* jmeta)
-{
-    const rizz_refl_info* r = &f->info;
-    void* value = f->value;
-    rizz_refl_field fields[32];
-
-    sjson_node* jfield = sjson_find_member(jmeta, r->name);
-    if (jfield) {
-        sx_assert(!(r->flags & RIZZ_REFL_FLAG_IS_PTR));
-
-        if (r->flags & RIZZ_REFL_FLAG_IS_ENUM) {
-            int eval = the__refl.get_enum(jfield->string_, 0);
-            sx_memcpy(value, &eval, r->size);
-        } else if (r->flags & RIZZ_REFL_FLAG_IS_STRUCT) {
-            if (r->flags & RIZZ_REFL_FLAG_IS_ARRAY) {
-                for (int i = 0; i < r->array_size; i++) {
-                    int num_fields = the__refl.get_fields(
-                        r->type, (uint8_t*)value + (size_t)i * (size_t)r->stride, fields,
-                        sizeof(fields) / sizeof(rizz_refl_field));
-                    for (int fi = 0; fi < num_fields; fi++) {
-                        rizz__asset_meta_read_item(&fields[fi], sjson_find_element(jfield, i));
-                    }
-                }
-            } else {
-                int num_fields = the__refl.get_fields(r->type, value, fields,
-                                                      sizeof(fields) / sizeof(rizz_refl_field));
-                for (int fi = 0; fi < num_fields; fi++) {
-                    rizz__asset_meta_read_item(&fields[fi], jfield);
-                }
-            }
-        } else {
-            if (sx_strequal(r->type, "int")) {
-                int n = (int)jfield->number_;
-                sx_memcpy(value, &n, r->size);
-            } else if (sx_strequal(r->type, "float")) {
-                float n = (float)jfield->number_;
-                sx_memcpy(value, &n, r->size);
-            } else if (sx_strequal(r->type, "bool")) {
-                sx_memcpy(value, &jfield->bool_, r->size);
-            } else if (the__refl.is_cstring(r)) {
-                sx_memcpy(value, jfield->string_, r->size);
-            }
-        }
-    }
-}
-
-static void rizz__asset_meta_write_item(const rizz_refl_field* field, sjson_context* jctx,
-                                        sjson_node* jmeta)
+static rizz_refl_serializer* rizz__asset_meta_serializer(rizz__asset_mgr* amgr)
 {
-    const rizz_refl_info* r = &field->info;
-    void* value = field->value;
-    rizz_refl_field fields[32];
-
-    if (r->flags & RIZZ_REFL_FLAG_IS_ENUM) {
-        int _e = *(int*)value;
-        sjson_put_string(jctx, jmeta, r->name, the__refl.get_enum_name(r->type, _e));
-    } else if (r->flags & RIZZ_REFL_FLAG_IS_STRUCT) {
-        if (r->flags & RIZZ_REFL_FLAG_IS_ARRAY) {
-            sjson_node* js = sjson_put_array(jctx, jmeta, r->name);
-            for (int i = 0; i < r->array_size; i++) {
-                sjson_node* jitem = sjson_mkobject(jctx);
-                int num_fields =
-                    the__refl.get_fields(r->type, (uint8_t*)value + (size_t)i * (size_t)r->stride,
-                                         fields, sizeof(fields) / sizeof(rizz_refl_field));
-                for (int fi = 0; fi < num_fields; fi++) {
-                    rizz__asset_meta_write_item(&fields[fi], jctx, jitem);
-                }
-                sjson_append_element(js, jitem);
-            }
-        } else {
-            sjson_node* js = sjson_put_obj(jctx, jmeta, r->name);
-            int num_fields = the__refl.get_fields(r->type, value, fields,
-                                                  sizeof(fields) / sizeof(rizz_refl_field));
-            for (int fi = 0; fi < num_fields; fi++) {
-                rizz__asset_meta_write_item(&fields[fi], jctx, js);
-            }
-        }
-    } else {
-        if (sx_strequal(r->type, "int")) {
-            sjson_put_int(jctx, jmeta, r->name, *(int*)value);
-        } else if (sx_strequal(r->type, "float")) {
-            sjson_put_float(jctx, jmeta, r->name, *(float*)value);
-        } else if (sx_strequal(r->type, "bool")) {
-            sjson_put_bool(jctx, jmeta, r->name, *(bool*)value);
-        } else if (the__refl.is_cstring(r)) {
-            sjson_put_string(jctx, jmeta, r->name, (const char*)value);
-        }
-    }
+    if (!amgr->metadata_srz && amgr->metadata_type_name[0])
+        amgr->metadata_srz = the__refl.create_serializer(amgr->metadata_type_name, 0);
+    return amgr->metadata_srz;
 }
 
 static bool rizz__asset_load_meta_cache()
@@ -458,7 +422,6 @@ static bool rizz__asset_load_meta_cache()
     }
 
     sjson_node* jitem;
-    rizz_refl_field meta_fields[32];
     sjson_foreach(jitem, jroot)
     {
         const char* name = sjson_get_string(jitem, "name", "");
@@ -497,12 +460,9 @@ static bool rizz__asset_load_meta_cache()
                     sx_array_add(g_asset.alloc, amgr->metadata_buff, amgr->metadata_size);
                 sx_memset(meta_buff, 0x0, amgr->metadata_size);
 
-                int num_fields =
-                    the__refl.get_fields(amgr->metadata_type_name, meta_buff, meta_fields,
-                                         sizeof(meta_fields) / sizeof(rizz_refl_field));
-                for (int fi = 0; fi < num_fields; fi++) {
-                    rizz__asset_meta_read_item(&meta_fields[fi], jmeta);
-                }
+                rizz_refl_serializer* srz = rizz__asset_meta_serializer(amgr);
+                if (srz)
+                    rizz__refl_read_json(srz, jmeta, meta_buff);
 
                 int res_idx = sx_array_count(g_asset.resources);
                 sx_array_push(g_asset.alloc, g_asset.resources, rs);
@@ -522,7 +482,6 @@ bool rizz__asset_save_meta_cache()
     if (!jctx)
         return false;
 
-    rizz_refl_field meta_fields[32];
     sjson_node* jroot = sjson_mkarray(jctx);
 
     for (int i = 0, c = sx_array_count(g_asset.resources); i < c; i++) {
@@ -534,19 +493,15 @@ bool rizz__asset_save_meta_cache()
             sjson_put_string(jctx, jitem, "path", rs->real_path);
 
         sx_assert(rs->asset_mgr_id >= 0 && rs->asset_mgr_id < sx_array_count(g_asset.asset_mgrs));
-        const rizz__asset_mgr* amgr = &g_asset.asset_mgrs[rs->asset_mgr_id];
+        rizz__asset_mgr* amgr = &g_asset.asset_mgrs[rs->asset_mgr_id];
         sjson_put_string(jctx, jitem, "type_name", amgr->name);
 
         // metadata
-        if (rs->metadata_id && amgr->metadata_size) {
+        rizz_refl_serializer* srz = amgr->metadata_size ? rizz__asset_meta_serializer(amgr) : NULL;
+        if (rs->metadata_id && srz) {
             sjson_node* jmeta = sjson_mkobject(jctx);
-            uint8_t* meta_buff = &amgr->metadata_buff[rizz_to_index(rs->metadata_id)];
-
-            int num_fields = the__refl.get_fields(amgr->metadata_type_name, meta_buff, meta_fields,
-                                                  sizeof(meta_fields) / sizeof(rizz_refl_field));
-            for (int fi = 0; fi < num_fields; fi++) {
-                rizz__asset_meta_write_item(&meta_fields[fi], jctx, jmeta);
-            }
+            const uint8_t* meta_buff = &amgr->metadata_buff[rizz_to_index(rs->metadata_id)];
+            rizz__refl_write_json(srz, jctx, jmeta, meta_buff);
             sjson_append_member(jctx, jitem, "metadata", jmeta);
         }
 
@@ -646,7 +601,13 @@ static rizz_asset rizz__asset_create_new(const char* path, const void* params, r
                        .hash = rizz__asset_hash(path, params, params_size, obj_alloc),
                        .tags = tags,
                        .load_flags = flags,
-                       .state = RIZZ_ASSET_STATE_ZOMBIE };
+                       .state = RIZZ_ASSET_STATE_ZOMBIE,
+                       .lru_prev = -1,
+                       .lru_next = -1 };
+
+    if (amgr->callbacks.on_get_size) {
+        ++g_asset.cache.misses;
+    }
 
     // have to protected this block of code with a lock
     // because we may regrow the asset-array
@@ -700,6 +661,108 @@ static void rizz__asset_destroy_delete(rizz_asset a, rizz__asset_mgr* amgr)
     sx_handle_del(g_asset.asset_handles, a.id);
 }
 
+// asset cache (LRU): entries are linked by asset index, newest ones are added to the end
+static void rizz__asset_cache_unlink(rizz__asset* a, int index)
+{
+    rizz__asset_cache* cache = &g_asset.cache;
+    int memid = a->cache_memid;
+    if (a->lru_prev != -1)
+        g_asset.assets[a->lru_prev].lru_next = a->lru_next;
+    else
+        cache->first[memid] = a->lru_next;
+    if (a->lru_next != -1)
+        g_asset.assets[a->lru_next].lru_prev = a->lru_prev;
+    else
+        cache->last[memid] = a->lru_prev;
+
+    sx_assert(cache->first[memid] != index && cache->last[memid] != index);
+    cache->resident_bytes[memid] -= a->cache_size;
+    --cache->num_resident;
+    a->lru_prev = a->lru_next = -1;
+    a->cached = false;
+}
+
+static void rizz__asset_cache_evict(int memid, int64_t budget)
+{
+    rizz__asset_cache* cache = &g_asset.cache;
+    while (cache->first[memid] != -1 && cache->resident_bytes[memid] > budget) {
+        int index = cache->first[memid];
+        rizz__asset* a = &g_asset.assets[index];
+        rizz__asset_cache_unlink(a, index);
+        rizz__asset_destroy_delete((rizz_asset){ a->handle }, &g_asset.asset_mgrs[a->asset_mgr_id]);
+        ++cache->evictions;
+    }
+}
+
+// evicts all cached assets that pass the filter, or all of them if filter_cb = NULL
+static void rizz__asset_cache_flush(bool (*filter_cb)(const rizz__asset* a, uintptr_t value),
+                                    uintptr_t value)
+{
+    for (int memid = 0; memid < _RIZZ_MEMID_COUNT; memid++) {
+        int index = g_asset.cache.first[memid];
+        while (index != -1) {
+            rizz__asset* a = &g_asset.assets[index];
+            if (!filter_cb || filter_cb(a, value)) {
+                rizz__asset_cache_unlink(a, index);
+                rizz__asset_destroy_delete((rizz_asset){ a->handle },
+                                           &g_asset.asset_mgrs[a->asset_mgr_id]);
+                // releasing the object may unload (cache/evict) other assets, so start over
+                index = g_asset.cache.first[memid];
+            } else {
+                index = a->lru_next;
+            }
+        }
+    }
+}
+
+// keeps the zero-ref asset resident, returns false if the asset is not cacheable
+static bool rizz__asset_cache_put(rizz__asset* a, rizz__asset_mgr* amgr)
+{
+    if (!amgr->callbacks.on_get_size || amgr->unreg || a->state != RIZZ_ASSET_STATE_OK) {
+        return false;
+    }
+
+    const rizz__asset_resource* res = &g_asset.resources[rizz_to_index(a->resource_id)];
+    const void* metadata =
+        res->metadata_id ? &amgr->metadata_buff[rizz_to_index(res->metadata_id)] : NULL;
+    rizz_mem_id memid = RIZZ_MEMID_OTHER;
+    int64_t size = amgr->callbacks.on_get_size(a->obj, metadata, &memid);
+    sx_assert(memid >= 0 && memid < _RIZZ_MEMID_COUNT);
+
+    rizz__asset_cache* cache = &g_asset.cache;
+    int64_t budget = cache->budget_bytes[memid];
+    if (size > budget) {
+        return false;
+    }
+
+    int index = sx_handle_index(a->handle);
+    a->cached = true;
+    a->cache_memid = (uint8_t)memid;
+    a->cache_size = size;
+    a->lru_next = -1;
+    a->lru_prev = cache->last[memid];
+    if (cache->last[memid] != -1)
+        g_asset.assets[cache->last[memid]].lru_next = index;
+    else
+        cache->first[memid] = index;
+    cache->last[memid] = index;
+    cache->resident_bytes[memid] += size;
+    ++cache->num_resident;
+
+    // `a` is the newest entry, so it is evicted last and only if the budget can't hold it
+    rizz__asset_cache_evict(memid, budget);
+    return true;
+}
+
+// takes a cached asset out of the cache, when it is being loaded (referenced) again
+static inline void rizz__asset_cache_take(rizz__asset* a)
+{
+    if (a->cached) {
+        rizz__asset_cache_unlink(a, sx_handle_index(a->handle));
+        ++g_asset.cache.hits;
+    }
+}
+
 static rizz_asset rizz__asset_add(const char* path, const void* params, rizz_asset_obj obj,
                                   uint32_t name_hash, const sx_alloc* obj_alloc,
                                   rizz_asset_load_flags flags, uint32_t tags,
@@ -729,6 +792,254 @@ static rizz_asset rizz__asset_add(const char* path, const void* params, rizz_ass
     return asset;
 }
 
+static void rizz__asset_batch_read_job_cb(int start, int end, int thrd_index, void* user)
+{
+    sx_unused(thrd_index);
+    rizz__asset_batch* batch = user;
+    for (int i = start; i < end; i++) {
+        rizz__asset_batch_item* item = &batch->items[i];
+        if (!item->done) {
+            rizz_vfs_flags flags = (item->flags & RIZZ_ASSET_LOAD_FLAG_ABSOLUTE_PATH)
+                                       ? RIZZ_VFS_FLAG_ABSOLUTE_PATH
+                                       : 0;
+            item->mem = the__vfs.read(item->real_path, flags, the__core.alloc(RIZZ_MEMID_CORE));
+        }
+    }
+}
+
+static void rizz__asset_batch_load_job_cb(int start, int end, int thrd_index, void* user)
+{
+    sx_unused(thrd_index);
+    rizz__asset_batch* batch = user;
+    for (int i = start; i < end; i++) {
+        rizz__asset_batch_item* item = &batch->items[i];
+        if (item->load_data.obj.id) {    // prepared
+            rizz__asset_mgr* amgr = &g_asset.asset_mgrs[item->asset_mgr_id];
+            rizz_asset_load_params aparams = { .path = item->path,
+                                               .params = item->params,
+                                               .alloc = item->alloc,
+                                               .tags = item->tags,
+                                               .flags = item->flags };
+            item->loaded = amgr->callbacks.on_load(&item->load_data, &aparams, item->mem);
+        }
+    }
+}
+
+// runs the job callback on workers, or on the calling thread if there is only one item to process
+static void rizz__asset_batch_run(rizz__asset_batch* batch, int num_pending,
+                                  void (*job_cb)(int start, int end, int thrd_index, void* user))
+{
+    if (num_pending > 1) {
+        sx_job_t job =
+            the__core.job_dispatch(batch->count, job_cb, batch, SX_JOB_PRIORITY_HIGH, 0);
+        the__core.job_wait_and_del(job);
+    } else if (num_pending == 1) {
+        job_cb(0, batch->count, 0, batch);
+    }
+}
+
+// loads all items of the batch in blocking mode, results are written to `items[i].asset`
+static void rizz__asset_load_batch_items(rizz__asset_batch_item* items, int count)
+{
+    // copy params first, because the params buffers may grow by loading dependencies
+    int params_size = 0;
+    for (int i = 0; i < count; i++) {
+        int amgr_id = rizz__asset_find_asset_mgr(items[i].name_hash);
+        sx_assert(amgr_id != -1 && "asset type is not registered");
+        items[i].asset_mgr_id = amgr_id;
+        params_size += sx_align_mask(g_asset.asset_mgrs[amgr_id].params_size, 7);
+    }
+    uint8_t* params_buff = NULL;
+    if (params_size > 0) {
+        params_buff = sx_malloc(g_asset.alloc, params_size);
+        if (!params_buff) {
+            sx_out_of_memory();
+            return;
+        }
+    }
+
+    rizz__asset_batch batch = { .items = items, .count = count };
+    int num_pending = 0;
+    uint8_t* params_ptr = params_buff;
+    for (int i = 0; i < count; i++) {
+        rizz__asset_batch_item* item = &items[i];
+        rizz__asset_mgr* amgr = &g_asset.asset_mgrs[item->asset_mgr_id];
+        if (item->params && amgr->params_size > 0) {
+            sx_memcpy(params_ptr, item->params, amgr->params_size);
+            item->params = params_ptr;
+            params_ptr += sx_align_mask(amgr->params_size, 7);
+        }
+
+        if (item->flags & RIZZ_ASSET_LOAD_FLAG_RELOAD)
+            item->flags |= RIZZ_ASSET_LOAD_FLAG_WAIT_ON_LOAD;
+        item->flags |= amgr->forced_flags;
+
+        // find if asset is already loaded
+        rizz_asset asset = (rizz_asset){ sx_hashtbl_find_get(
+            g_asset.asset_tbl,
+            rizz__asset_hash(item->path, item->params, amgr->params_size, item->alloc), 0) };
+        if (asset.id && !(item->flags & RIZZ_ASSET_LOAD_FLAG_RELOAD)) {
+            rizz__asset* a = &g_asset.assets[sx_handle_index(asset.id)];
+            rizz__asset_cache_take(a);
+            ++a->ref_count;
+            item->asset = asset;
+            item->done = true;
+            continue;
+        }
+
+        // find resource and resolve the real file path
+        int res_idx =
+            sx_hashtbl_find_get(g_asset.resource_tbl, sx_hash_fnv32_str(item->path), -1);
+        sx_strcpy(item->real_path, sizeof(item->real_path),
+                  res_idx != -1 ? g_asset.resources[res_idx].real_path : item->path);
+
+        item->asset = rizz__asset_add(
+            item->path, item->params, amgr->failed_obj, item->name_hash, item->alloc, item->flags,
+            item->tags, (item->flags & RIZZ_ASSET_LOAD_FLAG_RELOAD) ? asset : (rizz_asset){ 0 });
+        ++num_pending;
+    }
+
+    // read all files
+    rizz__asset_batch_run(&batch, num_pending, rizz__asset_batch_read_job_cb);
+
+    // metadata and `on_prepare`, dependencies may be loaded here, so don't keep any pointers
+    num_pending = 0;
+    for (int i = 0; i < count; i++) {
+        rizz__asset_batch_item* item = &items[i];
+        if (item->done)
+            continue;
+
+        if (!item->mem) {
+            rizz__asset_errmsg(item->path, item->real_path, "opening");
+            continue;
+        }
+
+        rizz__asset_mgr* amgr = &g_asset.asset_mgrs[item->asset_mgr_id];
+        rizz__asset* a = &g_asset.assets[sx_handle_index(item->asset.id)];
+        sx_assert(a->resource_id);
+        rizz__asset_resource* res = &g_asset.resources[rizz_to_index(a->resource_id)];
+
+        rizz_asset_load_params aparams = { .path = item->path,
+                                           .params = item->params,
+                                           .alloc = item->alloc,
+                                           .tags = item->tags,
+                                           .flags = item->flags };
+
+        // we don't have the metadata, allocate space and fetch it from the asset-loader
+        if (!res->metadata_id) {
+            res->metadata_id = rizz_to_id(sx_array_count(amgr->metadata_buff));
+            amgr->callbacks.on_read_metadata(
+                sx_array_add(g_asset.alloc, amgr->metadata_buff, amgr->metadata_size), &aparams,
+                item->mem);
+        } else if (item->flags & RIZZ_ASSET_LOAD_FLAG_RELOAD) {
+            amgr->callbacks.on_read_metadata(&amgr->metadata_buff[rizz_to_index(res->metadata_id)],
+                                             &aparams, item->mem);
+        }
+
+        item->load_data = amgr->callbacks.on_prepare(
+            &aparams, &amgr->metadata_buff[rizz_to_index(res->metadata_id)]);
+        if (item->load_data.obj.id)
+            ++num_pending;
+    }
+
+    // `on_load`
+    rizz__asset_batch_run(&batch, num_pending, rizz__asset_batch_load_job_cb);
+
+    // finalize in the order of the batch
+    for (int i = 0; i < count; i++) {
+        rizz__asset_batch_item* item = &items[i];
+        if (item->done)
+            continue;
+
+        rizz__asset_mgr* amgr = &g_asset.asset_mgrs[item->asset_mgr_id];
+        rizz__asset* a = &g_asset.assets[sx_handle_index(item->asset.id)];
+        rizz_asset_load_params aparams = { .path = item->path,
+                                           .params = item->params,
+                                           .alloc = item->alloc,
+                                           .tags = item->tags,
+                                           .flags = item->flags };
+
+        if (item->loaded) {
+            amgr->callbacks.on_finalize(&item->load_data, &aparams, item->mem);
+            a = &g_asset.assets[sx_handle_index(item->asset.id)];
+            a->state = RIZZ_ASSET_STATE_OK;
+            a->obj = item->load_data.obj;
+        } else {
+            if (item->load_data.obj.id)
+                amgr->callbacks.on_release(item->load_data.obj, a->alloc);
+            if (item->mem)
+                rizz__asset_errmsg(item->path, item->real_path, "loading");
+            if (a->obj.id && !a->dead_obj.id) {
+                a->state = RIZZ_ASSET_STATE_FAILED;
+            } else {
+                a->obj = a->dead_obj;    // rollback
+                a->dead_obj = (rizz_asset_obj){ .id = 0 };
+            }
+        }
+
+        if (item->mem) {
+            sx_mem_destroy_block(item->mem);
+            item->mem = NULL;
+        }
+
+        // do we have extra work in reload?
+        if (item->flags & RIZZ_ASSET_LOAD_FLAG_RELOAD) {
+            amgr->callbacks.on_reload(item->asset, a->dead_obj, item->alloc);
+            a = &g_asset.assets[sx_handle_index(item->asset.id)];
+            if (a->dead_obj.id) {
+                amgr->callbacks.on_release(a->dead_obj, item->alloc);
+                a->dead_obj = (rizz_asset_obj){ .id = 0 };
+            }
+        }
+    }
+
+    sx_free(g_asset.alloc, params_buff);
+}
+
+// reloads all assets that pass the filter in a single batch, returns number of reloaded assets
+static int rizz__asset_reload_batch(bool (*filter_cb)(const rizz__asset* a, uintptr_t value),
+                                    uintptr_t value)
+{
+    int count = 0;
+    for (int i = 0, c = g_asset.asset_handles->count; i < c; i++) {
+        sx_handle_t handle = sx_handle_at(g_asset.asset_handles, i);
+        if (filter_cb(&g_asset.assets[sx_handle_index(handle)], value))
+            ++count;
+    }
+    if (count == 0)
+        return 0;
+
+    rizz__asset_batch_item* items =
+        sx_malloc(g_asset.alloc, sizeof(rizz__asset_batch_item) * count);
+    if (!items) {
+        sx_out_of_memory();
+        return 0;
+    }
+    sx_memset(items, 0x0, sizeof(rizz__asset_batch_item) * count);
+
+    int index = 0;
+    for (int i = 0, c = g_asset.asset_handles->count; i < c; i++) {
+        sx_handle_t handle = sx_handle_at(g_asset.asset_handles, i);
+        rizz__asset* a = &g_asset.assets[sx_handle_index(handle)];
+        if (filter_cb(a, value)) {
+            sx_assert(a->resource_id);
+            rizz__asset_mgr* amgr = &g_asset.asset_mgrs[a->asset_mgr_id];
+            rizz__asset_batch_item* item = &items[index++];
+            item->name_hash = amgr->name_hash;
+            sx_strcpy(item->path, sizeof(item->path),
+                      g_asset.resources[rizz_to_index(a->resource_id)].path);
+            item->params = a->params_id ? &amgr->params_buff[rizz_to_index(a->params_id)] : NULL;
+            item->alloc = a->alloc;
+            item->tags = a->tags;
+            item->flags = a->load_flags | RIZZ_ASSET_LOAD_FLAG_RELOAD;
+        }
+    }
+
+    rizz__asset_load_batch_items(items, count);
+    sx_free(g_asset.alloc, items);
+    return count;
+}
+
 static rizz_asset rizz__asset_load_hashed(uint32_t name_hash, const char* path, const void* params,
                                           rizz_asset_load_flags flags, const sx_alloc* obj_alloc,
                                           uint32_t tags)
@@ -746,114 +1057,45 @@ static rizz_asset rizz__asset_load_hashed(uint32_t name_hash, const char* path,
     rizz__asset_mgr* amgr = &g_asset.asset_mgrs[amgr_id];
     flags |= amgr->forced_flags;
 
+    if (flags & RIZZ_ASSET_LOAD_FLAG_WAIT_ON_LOAD) {
+        // Blocking load (+ reloads)
+        rizz__asset_batch_item item = { .name_hash = name_hash,
+                                        .params = params,
+                                        .alloc = obj_alloc,
+                                        .tags = tags,
+                                        .flags = flags };
+        sx_strcpy(item.path, sizeof(item.path), path);
+        rizz__asset_load_batch_items(&item, 1);
+        return item.asset;
+    }
+
     // find if asset is already loaded
     rizz_asset asset = (rizz_asset){ sx_hashtbl_find_get(
         g_asset.asset_tbl, rizz__asset_hash(path, params, amgr->params_size, obj_alloc), 0) };
-    if (asset.id && !(flags & RIZZ_ASSET_LOAD_FLAG_RELOAD)) {
-        ++g_asset.assets[sx_handle_index(asset.id)].ref_count;
+    if (asset.id) {
+        rizz__asset* a = &g_asset.assets[sx_handle_index(asset.id)];
+        rizz__asset_cache_take(a);
+        ++a->ref_count;
     } else {
+        // Async load
         // find resource and resolve the real file path
         int res_idx = sx_hashtbl_find_get(g_asset.resource_tbl, sx_hash_fnv32_str(path), -1);
-        const char* real_path = path;
-        rizz__asset_resource* res = NULL;
-        if (res_idx != -1) {
-            res = &g_asset.resources[res_idx];
-            real_path = res->real_path;
-        }
-
-        if (!(flags & RIZZ_ASSET_LOAD_FLAG_WAIT_ON_LOAD)) {
-            // Async load
-            asset = rizz__asset_create_new(path, params, amgr->async_obj, name_hash, obj_alloc,
-                                           flags, tags);
-            rizz__asset* a = &g_asset.assets[sx_handle_index(asset.id)];
-            a->state = RIZZ_ASSET_STATE_LOADING;
-
-            rizz__asset_async_load_req req =
-                (rizz__asset_async_load_req){ .path_hash = sx_hash_fnv32_str(real_path),
-                                              .asset = asset };
-            sx_array_push(g_asset.alloc, g_asset.async_reqs, req);
+        const char* real_path = res_idx != -1 ? g_asset.resources[res_idx].real_path : path;
 
-            the__vfs.read_async(
-                real_path,
-                (flags & RIZZ_ASSET_LOAD_FLAG_ABSOLUTE_PATH) ? RIZZ_VFS_FLAG_ABSOLUTE_PATH : 0,
-                the__core.alloc(RIZZ_MEMID_CORE));
-        } else {
-            // Blocking load (+ reloads)
-            asset =
-                rizz__asset_add(path, params, amgr->failed_obj, name_hash, obj_alloc, flags, tags,
-                                (flags & RIZZ_ASSET_LOAD_FLAG_RELOAD) ? asset : (rizz_asset){ 0 });
-
-            sx_mem_block* mem = the__vfs.read(
-                real_path,
-                (flags & RIZZ_ASSET_LOAD_FLAG_ABSOLUTE_PATH) ? RIZZ_VFS_FLAG_ABSOLUTE_PATH : 0,
-                the__core.alloc(RIZZ_MEMID_CORE));
-
-            if (!mem) {
-                rizz__asset_errmsg(path, real_path, "opening");
-                return asset;
-            }
-
-            rizz__asset* a = &g_asset.assets[sx_handle_index(asset.id)];
-
-            if (!res) {
-                sx_assert(a->resource_id);
-                res = &g_asset.resources[rizz_to_index(a->resource_id)];
-            }
-
-            rizz_asset_load_params aparams = (rizz_asset_load_params){
-                .path = path, .params = params, .alloc = obj_alloc, .tags = tags, .flags = flags
-            };
-
-            // we don't have the metadata, allocate space and fetch it from the asset-loader
-            if (!res->metadata_id) {
-                res->metadata_id = rizz_to_id(sx_array_count(amgr->metadata_buff));
-                amgr->callbacks.on_read_metadata(
-                    sx_array_add(g_asset.alloc, amgr->metadata_buff, amgr->metadata_size), &aparams,
-                    mem);
-            } else if (flags & RIZZ_ASSET_LOAD_FLAG_RELOAD) {
-                amgr->callbacks.on_read_metadata(
-                    &amgr->metadata_buff[rizz_to_index(res->metadata_id)], &aparams, mem);
-            }
-
-            bool success = false;
-            rizz_asset_load_data load_data = amgr->callbacks.on_prepare(
-                &aparams, &amgr->metadata_buff[rizz_to_index(res->metadata_id)]);
-
-            // revive pointer to asset, because during `on_prepare` some resource dependencies
-            // may be loaded and `assets` array may be resized
-            a = &g_asset.assets[sx_handle_index(asset.id)];
-            if (load_data.obj.id) {
-                if (amgr->callbacks.on_load(&load_data, &aparams, mem)) {
-                    amgr->callbacks.on_finalize(&load_data, &aparams, mem);
-                    success = true;
-                }
-            }
+        asset = rizz__asset_create_new(path, params, amgr->async_obj, name_hash, obj_alloc, flags,
+                                       tags);
+        rizz__asset* a = &g_asset.assets[sx_handle_index(asset.id)];
+        a->state = RIZZ_ASSET_STATE_LOADING;
 
-            sx_mem_destroy_block(mem);
-            if (success) {
-                a->state = RIZZ_ASSET_STATE_OK;
-                a->obj = load_data.obj;
-            } else {
-                if (load_data.obj.id)
-                    amgr->callbacks.on_release(load_data.obj, a->alloc);
-                rizz__asset_errmsg(path, real_path, "loading");
-                if (a->obj.id && !a->dead_obj.id) {
-                    a->state = RIZZ_ASSET_STATE_FAILED;
-                } else {
-                    a->obj = a->dead_obj;    // rollback
-                    a->dead_obj = (rizz_asset_obj){ .id = 0 };
-                }
-            }
+        rizz__asset_async_load_req req =
+            (rizz__asset_async_load_req){ .path_hash = sx_hash_fnv32_str(real_path),
+                                          .asset = asset };
+        sx_array_push(g_asset.alloc, g_asset.async_reqs, req);
 
-            // do we have extra work in reload?
-            if (flags & RIZZ_ASSET_LOAD_FLAG_RELOAD) {
-                amgr->callbacks.on_reload(asset, a->dead_obj, obj_alloc);
-                if (a->dead_obj.id) {
-                    amgr->callbacks.on_release(a->dead_obj, obj_alloc);
-                    a->dead_obj = (rizz_asset_obj){ .id = 0 };
-                }
-            }
-        }
+        the__vfs.read_async(
+            real_path,
+            (flags & RIZZ_ASSET_LOAD_FLAG_ABSOLUTE_PATH) ? RIZZ_VFS_FLAG_ABSOLUTE_PATH : 0,
+            the__core.alloc(RIZZ_MEMID_CORE));
     }
 
     return asset;
@@ -888,6 +1130,10 @@ bool rizz__asset_init(const sx_alloc* alloc, const char* dbfile, const char* var
     g_asset.hasher = sx_hash_create_xxh32(alloc);
     sx_assert(g_asset.hasher);
 
+    for (int i = 0; i < _RIZZ_MEMID_COUNT; i++) {
+        g_asset.cache.first[i] = g_asset.cache.last[i] = -1;
+    }
+
     return true;
 }
 
@@ -899,6 +1145,10 @@ void rizz__asset_release()
     const sx_alloc* alloc = g_asset.alloc;
 
     if (g_asset.asset_handles) {
+        // zero budgets, so dependencies that are released by cached objects are not cached again
+        sx_memset(g_asset.cache.budget_bytes, 0x0, sizeof(g_asset.cache.budget_bytes));
+        rizz__asset_cache_flush(NULL, 0);
+
         for (int i = 0; i < g_asset.asset_handles->count; i++) {
             sx_handle_t handle = sx_handle_at(g_asset.asset_handles, i);
             rizz__asset* a = &g_asset.assets[sx_handle_index(handle)];
@@ -919,6 +1169,7 @@ void rizz__asset_release()
         rizz__asset_mgr* amgr = &g_asset.asset_mgrs[i];
         sx_array_free(alloc, amgr->params_buff);
         sx_array_free(alloc, amgr->metadata_buff);
+        the__refl.destroy_serializer(amgr->metadata_srz);
     }
 
     for (int i = 0; i < sx_array_count(g_asset.groups); i++) {
@@ -1015,6 +1266,59 @@ static rizz_asset rizz__asset_load(const char* name, const char* path, const voi
     return asset;
 }
 
+static int rizz__asset_load_batch(const char* name, const char** paths, int count,
+                                  const void* params, rizz_asset_load_flags flags,
+                                  const sx_alloc* alloc, uint32_t tags, rizz_asset* out_handles)
+{
+    sx_assert(!(flags & RIZZ_ASSET_LOAD_FLAG_RELOAD) && "use reload functions for reloading");
+    if (count <= 0)
+        return 0;
+
+    rizz__asset_batch_item* items =
+        sx_malloc(g_asset.alloc, sizeof(rizz__asset_batch_item) * count);
+    if (!items) {
+        sx_out_of_memory();
+        return 0;
+    }
+    sx_memset(items, 0x0, sizeof(rizz__asset_batch_item) * count);
+
+    uint32_t name_hash = sx_hash_fnv32_str(name);
+    int num_items = 0;
+    for (int i = 0; i < count; i++) {
+        if (!paths[i][0]) {
+            rizz_log_warn("empty path for asset");
+            continue;
+        }
+        rizz__asset_batch_item* item = &items[num_items++];
+        item->name_hash = name_hash;
+        sx_strcpy(item->path, sizeof(item->path), paths[i]);
+        item->params = params;
+        item->alloc = alloc;
+        item->tags = tags;
+        item->flags = flags | RIZZ_ASSET_LOAD_FLAG_WAIT_ON_LOAD;
+    }
+
+    rizz__asset_load_batch_items(items, num_items);
+
+    int num_loaded = 0;
+    rizz__asset_group* g =
+        g_asset.cur_group.id ? &g_asset.groups[sx_handle_index(g_asset.cur_group.id)] : NULL;
+    for (int i = 0, k = 0; i < count; i++) {
+        rizz_asset asset = paths[i][0] ? items[k++].asset : (rizz_asset){ 0 };
+        if (asset.id) {
+            if (g_asset.assets[sx_handle_index(asset.id)].state == RIZZ_ASSET_STATE_OK)
+                ++num_loaded;
+            if (g)
+                sx_array_push(g_asset.alloc, g->assets, asset);
+        }
+        if (out_handles)
+            out_handles[i] = asset;
+    }
+
+    sx_free(g_asset.alloc, items);
+    return num_loaded;
+}
+
 static rizz_asset rizz__asset_load_from_mem(const char* name, const char* path_alias,
                                             sx_mem_block* mem, const void* params,
                                             rizz_asset_load_flags flags, const sx_alloc* alloc,
@@ -1035,7 +1339,9 @@ static rizz_asset rizz__asset_load_from_mem(const char* name, const char* path_a
         g_asset.asset_tbl, rizz__asset_hash(path_alias, params, amgr->params_size, alloc), 0) };
 
     if (asset.id && !(flags & RIZZ_ASSET_LOAD_FLAG_RELOAD)) {
-        ++g_asset.assets[sx_handle_index(asset.id)].ref_count;
+        rizz__asset* a = &g_asset.assets[sx_handle_index(asset.id)];
+        rizz__asset_cache_take(a);
+        ++a->ref_count;
     } else {
         // find resource and resolve the real file path
         int res_idx = sx_hashtbl_find_get(g_asset.resource_tbl, sx_hash_fnv32_str(path_alias), -1);
@@ -1154,9 +1460,11 @@ static void rizz__asset_unload(rizz_asset asset)
             }
         }
 
-        // release internal object
+        // keep it in the cache, or release internal object
         rizz__asset_mgr* amgr = &g_asset.asset_mgrs[a->asset_mgr_id];
-        rizz__asset_destroy_delete(asset, amgr);
+        if (!rizz__asset_cache_put(a, amgr)) {
+            rizz__asset_destroy_delete(asset, amgr);
+        }
     }
 }
 
@@ -1196,7 +1504,14 @@ static void rizz__unregister_asset_type(const char* name)
     int amgr_id = rizz__asset_find_asset_mgr(sx_hash_fnv32_str(name));
     sx_assert(amgr_id != -1 && "asset type is not registered");
     rizz__asset_mgr* amgr = &g_asset.asset_mgrs[amgr_id];
+
+    // cached objects must be released while the asset-mgr's code is still around
+    rizz__asset_cache_flush(rizz__asset_filter_type, (uintptr_t)amgr_id);
     amgr->unreg = true;
+
+    // metadata type can change with the plugin that registered it
+    the__refl.destroy_serializer(amgr->metadata_srz);
+    amgr->metadata_srz = NULL;
 }
 
 static rizz_asset_state rizz__asset_state(rizz_asset asset)
@@ -1288,18 +1603,7 @@ static void rizz__asset_reload_by_type(const char* name)
     }
 
     if (asset_mgr_id != -1) {
-        rizz__asset_mgr* amgr = &g_asset.asset_mgrs[asset_mgr_id];
-        for (int i = 0, c = g_asset.asset_handles->count; i < c; i++) {
-            sx_handle_t handle = sx_handle_at(g_asset.asset_handles, i);
-            rizz__asset* a = &g_asset.assets[sx_handle_index(handle)];
-            if (a->asset_mgr_id == asset_mgr_id) {
-                sx_assert(a->resource_id);
-                rizz__asset_load_hashed(
-                    name_hash, g_asset.resources[rizz_to_index(a->resource_id)].path,
-                    a->params_id ? &amgr->params_buff[rizz_to_index(a->params_id)] : NULL,
-                    a->load_flags, a->alloc, a->tags);
-            }
-        }
+        rizz__asset_reload_batch(rizz__asset_filter_type, (uintptr_t)asset_mgr_id);
     }
 }
 
@@ -1343,6 +1647,9 @@ static void rizz__asset_unload_by_type(const char* name)
     }
 
     if (asset_mgr_id != -1) {
+        // zero-ref (cached) assets are deleted, instead of becoming zombies that can be revived
+        rizz__asset_cache_flush(rizz__asset_filter_type, (uintptr_t)asset_mgr_id);
+
         rizz__asset_mgr* amgr = &g_asset.asset_mgrs[asset_mgr_id];
         for (int i = 0, c = g_asset.asset_handles->count; i < c; i++) {
             sx_handle_t handle = sx_handle_at(g_asset.asset_handles, i);
@@ -1360,18 +1667,7 @@ static void rizz__asset_unload_by_type(const char* name)
 
 static void rizz__asset_reload_by_tags(uint32_t tags)
 {
-    for (int i = 0, c = g_asset.asset_handles->count; i < c; i++) {
-        sx_handle_t handle = sx_handle_at(g_asset.asset_handles, i);
-        rizz__asset* a = &g_asset.assets[sx_handle_index(handle)];
-        if (a->tags & tags) {
-            sx_assert(a->resource_id);
-            rizz__asset_mgr* amgr = &g_asset.asset_mgrs[a->asset_mgr_id];
-            rizz__asset_load_hashed(
-                amgr->name_hash, g_asset.resources[rizz_to_index(a->resource_id)].path,
-                a->params_id ? &amgr->params_buff[rizz_to_index(a->params_id)] : NULL,
-                a->load_flags, a->alloc, a->tags);
-        }
-    }
+    rizz__asset_reload_batch(rizz__asset_filter_tags, tags);
 }
 
 static int rizz__asset_gather_by_tags(uint32_t tags, rizz_asset* out_handles, int max_handles)
@@ -1392,6 +1688,8 @@ static int rizz__asset_gather_by_tags(uint32_t tags, rizz_asset* out_handles, in
 
 static void rizz__asset_unload_by_tags(uint32_t tags)
 {
+    rizz__asset_cache_flush(rizz__asset_filter_tags, (uintptr_t)tags);
+
     for (int i = 0, c = g_asset.asset_handles->count; i < c; i++) {
         sx_handle_t handle = sx_handle_at(g_asset.asset_handles, i);
         rizz__asset* a = &g_asset.assets[sx_handle_index(handle)];
@@ -1512,9 +1810,30 @@ static int rizz__asset_group_gather(rizz_asset_group group, rizz_asset* out_hand
     return count;
 }
 
+static void rizz__asset_set_cache_budget(rizz_mem_id memid, int64_t budget_bytes)
+{
+    sx_assert(memid >= 0 && memid < _RIZZ_MEMID_COUNT);
+    sx_assert(budget_bytes >= 0);
+
+    g_asset.cache.budget_bytes[memid] = budget_bytes;
+    rizz__asset_cache_evict(memid, budget_bytes);
+}
+
+static void rizz__asset_cache_info(rizz_asset_cache_info* info)
+{
+    const rizz__asset_cache* cache = &g_asset.cache;
+    sx_memcpy(info->resident_bytes, cache->resident_bytes, sizeof(cache->resident_bytes));
+    sx_memcpy(info->budget_bytes, cache->budget_bytes, sizeof(cache->budget_bytes));
+    info->num_resident = cache->num_resident;
+    info->hits = cache->hits;
+    info->misses = cache->misses;
+    info->evictions = cache->evictions;
+}
+
 rizz_api_asset the__asset = { .register_asset_type = rizz__register_asset_type,
                               .unregister_asset_type = rizz__unregister_asset_type,
                               .load = rizz__asset_load,
+                              .load_batch = rizz__asset_load_batch,
                               .load_from_mem = rizz__asset_load_from_mem,
                               .unload = rizz__asset_unload,
                               .load_meta_cache = rizz__asset_load_meta_cache,
@@ -1539,4 +1858,6 @@ rizz_api_asset the__asset = { .register_asset_type = rizz__register_asset_type,
                               .group_loaded = rizz__asset_group_loaded,
                               .group_delete = rizz__asset_group_delete,
                               .group_unload = rizz__asset_group_unload,
-                              .group_gather = rizz__asset_group_gather };
+                              .group_gather = rizz__asset_group_gather,
+                              .set_cache_budget = rizz__asset_set_cache_budget,
+                              .cache_info = rizz__asset_cache_info };
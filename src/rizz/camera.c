@@ -74,37 +74,25 @@ static void rizz__calc_frustum_points_range(const rizz_camera* cam, sx_vec3 frus
     const float h = cam->viewport.ymax - cam->viewport.ymin;
     const float aspect = w / h;
 
-    sx_vec3 xaxis = cam->right;
-    sx_vec3 yaxis = cam->up;
-    sx_vec3 zaxis = cam->forward;
-    sx_vec3 pos = cam->pos;
-
     float near_plane_h = sx_tan(fov * 0.5f) * fnear;
     float near_plane_w = near_plane_h * aspect;
 
     float far_plane_h = sx_tan(fov * 0.5f) * ffar;
     float far_plane_w = far_plane_h * aspect;
 
-    sx_vec3 center_near = sx_vec3_add(sx_vec3_mulf(zaxis, fnear), pos);
-    sx_vec3 center_far = sx_vec3_add(sx_vec3_mulf(zaxis, ffar), pos);
-
-    // scaled axises
-    sx_vec3 xnear_scaled = sx_vec3_mulf(xaxis, near_plane_w);
-    sx_vec3 xfar_scaled = sx_vec3_mulf(xaxis, far_plane_w);
-    sx_vec3 ynear_scaled = sx_vec3_mulf(yaxis, near_plane_h);
-    sx_vec3 yfar_scaled = sx_vec3_mulf(yaxis, far_plane_h);
-
-    // near quad (normal inwards)
-    frustum[0] = sx_vec3_sub(center_near, sx_vec3_add(xnear_scaled, ynear_scaled));
-    frustum[1] = sx_vec3_add(center_near, sx_vec3_sub(xnear_scaled, ynear_scaled));
-    frustum[2] = sx_vec3_add(center_near, sx_vec3_add(xnear_scaled, ynear_scaled));
-    frustum[3] = sx_vec3_sub(center_near, sx_vec3_sub(xnear_scaled, ynear_scaled));
-
-    // far quad (normal inwards)
-    frustum[4] = sx_vec3_sub(center_far, sx_vec3_add(xfar_scaled, yfar_scaled));
-    frustum[5] = sx_vec3_sub(center_far, sx_vec3_sub(xfar_scaled, yfar_scaled));
-    frustum[6] = sx_vec3_add(center_far, sx_vec3_sub(xfar_scaled, yfar_scaled));
-    frustum[7] = sx_vec3_add(center_far, sx_vec3_add(xfar_scaled, yfar_scaled));
+    // corners in camera space (x: right, y: up, z: forward), normals of the quads point inwards
+    // clang-format off
+    const sx_vec3 corners[8] = {
+        {{ -near_plane_w, -near_plane_h, fnear }}, {{ near_plane_w, -near_plane_h, fnear }},
+        {{  near_plane_w,  near_plane_h, fnear }}, {{ -near_plane_w, near_plane_h, fnear }},
+        {{ -far_plane_w,  -far_plane_h,  ffar }},  {{ -far_plane_w,  far_plane_h,  ffar }},
+        {{  far_plane_w,  -far_plane_h,  ffar }},  {{  far_plane_w,  far_plane_h,  ffar }}
+    };
+    // clang-format on
+
+    sx_mat4 world = sx_mat4v(sx_vec4v3(cam->right, 0), sx_vec4v3(cam->up, 0),
+                             sx_vec4v3(cam->forward, 0), sx_vec4v3(cam->pos, 1.0f));
+    sx_mat4_mul_vec3_batch(frustum, &world, corners, 8);
 }
 
 static void rizz__calc_frustum_points(const rizz_camera* cam, sx_vec3 frustum[8])
@@ -26,10 +26,25 @@
 #    define RIZZ_CONFIG_ASSET_POOL_SIZE 256
 #endif
 
+// Maximum number of http requests that are processed at the same time, the rest are queued
 #ifndef RIZZ_CONFIG_MAX_HTTP_REQUESTS
 #    define RIZZ_CONFIG_MAX_HTTP_REQUESTS 32
 #endif
 
+#ifndef RIZZ_CONFIG_HTTP_MAX_CONNECTIONS_PER_HOST
+#    define RIZZ_CONFIG_HTTP_MAX_CONNECTIONS_PER_HOST 6
+#endif
+
+// Seconds, idle keep-alive connections are closed after this time
+#ifndef RIZZ_CONFIG_HTTP_KEEPALIVE_TIMEOUT
+#    define RIZZ_CONFIG_HTTP_KEEPALIVE_TIMEOUT 30.0
+#endif
+
+// Seconds, requests fail if their connection is inactive for this time
+#ifndef RIZZ_CONFIG_HTTP_TIMEOUT
+#    define RIZZ_CONFIG_HTTP_TIMEOUT 30.0
+#endif
+
 #ifndef RIZZ_CONFIG_MAX_DEBUG_VERTICES
 #    define RIZZ_CONFIG_MAX_DEBUG_VERTICES 10000
 #endif
@@ -45,3 +60,13 @@
 #        define RIZZ_CONFIG_DEBUG_MEMORY 0
 #    endif
 #endif
+
+// builds a second graphics module with sokol's dummy backend (graphics-headless.c)
+// that is used instead of the platform backend when the app runs in headless mode (--headless)
+#ifndef RIZZ_CONFIG_HEADLESS
+#    if SX_PLATFORM_WINDOWS || SX_PLATFORM_LINUX || SX_PLATFORM_OSX
+#        define RIZZ_CONFIG_HEADLESS 1
+#    else
+#        define RIZZ_CONFIG_HEADLESS 0
+#    endif
+#endif
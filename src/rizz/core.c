@@ -21,13 +21,14 @@
 #include "sx/jobs.h"
 #include "sx/os.h"
 #include "sx/rng.h"
-#include "sx/stack-alloc.h"
 #include "sx/string.h"
 #include "sx/threads.h"
 #include "sx/timer.h"
+#include "sx/tlsf-alloc.h"
 #include "sx/virtual-alloc.h"
 
 #include <alloca.h>
+#include <inttypes.h>
 #include <stdio.h>
 #include <time.h>
 
@@ -59,7 +60,21 @@ __declspec(dllimport) void __stdcall OutputDebugStringA(const char* lpOutputStri
 #define SJSON_IMPLEMENT
 #include "sjson/sjson.h"
 
-#define DEFAULT_TMP_SIZE    0x500000    // 5mb
+#if SX_ARCH_64BIT
+#   define DEFAULT_TMP_SIZE     0x10000000  // 256mb (reserved address space, per-thread)
+#else
+#   define DEFAULT_TMP_SIZE     0x2000000   // 32mb (reserved address space, per-thread)
+#endif
+#define TMP_COMMIT_CHUNK_SIZE   0x10000     // 64kb: temp memory is committed in these chunks
+#define MEM_PROFILER_EVENTS_PER_THREAD  4096    // must be power of two
+#define MEM_PROFILER_MAX_CALLSITES      8192    // must be power of two
+#define HEAP_TLSF_POOL_SIZE     0x400000    // 4mb: thread heaps grow with pools of this size
+#define HEAP_TLSF_MAX_BLOCK     0x40000     // 256kb: bigger blocks are allocated from libc heap
+#define LOG_BUFFER_SIZE         0x10000     // 64kb: per-thread log ring-buffer (pow2, max 64kb)
+#define LOG_FLUSH_INTERVAL      10          // ms: pending logs are written at least this often
+#define LOG_MAX_TEXT            1024
+#define FIBER_STACKS_KEEP_WARM  8           // free fiber stacks of each class that stay committed
+#define FIBER_STACKS_TRIM_INTERVAL 1.0      // seconds: unused fiber stacks are decommitted
 
 #if SX_PLATFORM_WINDOWS || SX_PLATFORM_IOS || SX_PLATFORM_ANDROID
 #   define TERM_COLOR_RESET     ""
@@ -81,9 +96,42 @@ static const char* k__memid_names[_RIZZ_MEMID_COUNT] = { "Core",  "Graphics",
                                                          "Debug", "Toolset",    "Game" };
 
 
+// temp allocator: stack based allocator that reserves a large virtual address range and commits
+// memory on demand. At the end of each frame, committed memory is trimmed back to the frame's
+// high-water mark. If the reserved range is exhausted, allocations fall back to heap and are
+// released on pop()/frame reset.
+typedef struct rizz__core_tmpalloc_hdr {
+    size_t size;             // size of buffer that is requested upon allocation
+    size_t internal_size;    // actual size that is allocated (with headers and alignment)
+    size_t prev_offset;      // last_ptr_offset before this allocation
+    uint32_t padding;        // number of bytes padded before the pointer
+    uint32_t _reserved;
+} rizz__core_tmpalloc_hdr;
+
+typedef struct rizz__core_tmpalloc_fallback {
+    void* ptr;    // NULL if freed
+    size_t size;
+} rizz__core_tmpalloc_fallback;
+
+typedef struct rizz__core_tmpalloc_mark {
+    size_t offset;
+    int num_fallbacks;
+} rizz__core_tmpalloc_mark;
+
 typedef struct rizz__core_tmpalloc {
-    sx_stackalloc stack_alloc;
-    int* offset_stack;    // sx_array - keep offsets in a stack for push()/pop()
+    sx_alloc alloc;
+    uint8_t* ptr;              // start of reserved address range
+    size_t reserve_sz;         // reserved size (without the trailing guard page)
+    size_t commit_sz;          // committed bytes from the start of `ptr`
+    size_t offset;
+    size_t last_ptr_offset;
+    size_t peak;
+    size_t frame_peak;         // peak offset in the current frame, used for trimming on reset
+    size_t last_frame_peak;    // peak offset of the previous frame
+    size_t fallback_sz;        // bytes currently allocated from the heap (overflow)
+    rizz__core_tmpalloc_fallback* fallbacks;    // sx_array: heap allocs, after reserve is exhausted
+    rizz__core_tmpalloc_mark* marks;            // sx_array: offsets stack for push()/pop()
+    bool guard;                                 // RIZZ_CORE_FLAG_TEMP_GUARD_PAGES
 } rizz__core_tmpalloc;
 
 typedef struct rizz__core_cmd {
@@ -94,19 +142,136 @@ typedef struct rizz__core_cmd {
 typedef struct rizz__proxy_alloc_header {
     intptr_t size;
     uint32_t ptr_offset;
-    int track_item_idx;
+    uint32_t callsite;    // memory profiler: call-site key, 0 if the allocation is not sampled
+    union {
+        struct rizz__heap_thread* owner;    // thread heap that allocated the block, NULL for libc
+        struct rizz__proxy_alloc_header* next_free;    // remote free list (owner is implied)
+    };
 } rizz__proxy_alloc_header;
 
+// thread-caching heap: each thread allocates from it's own TLSF heap without any locks
+// blocks that are freed by other threads are pushed into the owner's `remote_frees` list and
+// the owner releases them on it's next allocation
+// when a thread exits (`rizz__core_thread_exit`), it's heap goes to the free list and is adopted
+// by the next new thread, blocks that are still alive stay valid and are freed as remote blocks
+// heaps are only destroyed on shutdown
+typedef struct rizz__heap_thread {
+    sx_alloc tlsf;
+    void** pools;    // sx_array: memory blocks given to tlsf (first one also holds tlsf control)
+    sx_align_decl(64, sx_atomic_ptr) remote_frees;    // rizz__proxy_alloc_header*
+    struct rizz__heap_thread* next;         // all heaps
+    struct rizz__heap_thread* next_free;    // heaps of exited threads (rizz__heap_tlsf.free_list)
+} rizz__heap_thread;
+
+typedef struct rizz__heap_tlsf {
+    sx_alloc alloc;
+    sx_tls thread_tls;       // rizz__heap_thread*
+    sx_atomic_ptr threads;   // rizz__heap_thread* (linked-list)
+    rizz__heap_thread* free_list;
+    sx_lock_t free_lock;     // only taken on thread creation/exit
+} rizz__heap_tlsf;
+
+// memory profiler: each thread pushes alloc/free events into it's own ring-buffer without locks and
+// the main thread consumes them in `rizz__mem_profiler_update` and aggregates them by call-site
+// call-sites are interned by the allocating threads into a fixed insert-only open-addressing table,
+// so the key stored in the allocation header is the (unique) slot index and not just a hash
+// slots are keyed by a copy of the call-site's content and never point into the caller's module,
+// so a hot-reloaded (or unloaded) plugin doesn't leave dangling strings behind, and a reloaded
+// module's call-sites land in the slots of it's previous instance instead of filling the table
+typedef enum rizz__mem_callsite_state {
+    RIZZ__MEM_CALLSITE_EMPTY = 0,
+    RIZZ__MEM_CALLSITE_WRITING,
+    RIZZ__MEM_CALLSITE_READY
+} rizz__mem_callsite_state;
+
+typedef struct rizz__mem_callsite_key {
+    char file[32];    // base name
+    char func[64];
+    uint32_t line;
+    int mem_id;
+} rizz__mem_callsite_key;
+
+typedef struct rizz__mem_callsite {
+    rizz__mem_callsite_key key;
+    sx_atomic_int state;    // rizz__mem_callsite_state
+    int item;               // (mem_id << 24) | index-to-items, -1 if not aggregated (main thread)
+} rizz__mem_callsite;
+
+typedef struct rizz__mem_event {
+    int64_t size;        // negative for free events
+    uint32_t callsite;   // index-to-callsites + 1
+    uint32_t mem_id;
+} rizz__mem_event;
+
+typedef struct rizz__mem_thread {
+    rizz__mem_event events[MEM_PROFILER_EVENTS_PER_THREAD];
+    sx_align_decl(64, sx_atomic_int) head;    // written by the producer (owner thread)
+    sx_align_decl(64, sx_atomic_int) tail;    // written by the consumer (main thread)
+    int sample_counter;
+    struct rizz__mem_thread* next;
+} rizz__mem_thread;
+
 typedef struct rizz__track_alloc {
     sx_alloc alloc;
     int mem_id;
     const char* name;
-    int64_t size;
-    int64_t peak;
-    sx_lock_t _lk;
-    rizz_track_alloc_item* items;    // sx_array
+    sx_atomic_int64 size;
+    sx_atomic_int64 peak;
+    const sx_alloc* heap;            // redirecting allocator: heap_proxy_alloc or heap_tlsf
+    rizz_track_alloc_item* items;    // sx_array: aggregated call-sites (main thread only)
 } rizz__track_alloc;
 
+typedef struct rizz__mem_profiler {
+    sx_tls thread_tls;         // rizz__mem_thread*
+    sx_atomic_ptr threads;     // rizz__mem_thread* (linked-list)
+    rizz__mem_callsite* callsites;    // [MEM_PROFILER_MAX_CALLSITES]
+    sx_atomic_int dropped;     // number of dropped events, because a ring-buffer was full
+    int sample_rate;
+} rizz__mem_profiler;
+
+// logger: each thread pushes log entries into it's own ring-buffer without locks and the logger
+// thread merges them by time, writes them to console/file/profiler and flushes once per batch
+typedef enum rizz__log_type {
+    RIZZ__LOG_TYPE_INFO = 0,
+    RIZZ__LOG_TYPE_DEBUG,
+    RIZZ__LOG_TYPE_VERBOSE,
+    RIZZ__LOG_TYPE_ERROR,
+    RIZZ__LOG_TYPE_WARNING
+} rizz__log_type;
+
+enum rizz__log_entry_flags_ {
+    RIZZ__LOG_ENTRY_PAD = 0x1,         // skip to the start of the ring-buffer (no data)
+    RIZZ__LOG_ENTRY_DEFERRED = 0x2     // data is format string + packed arguments, not text
+};
+
+typedef struct rizz__log_entry {
+    uint64_t tick;
+    uint32_t tid;
+    uint16_t size;    // total size in bytes, including the header (multiple of 16)
+    uint8_t type;     // rizz__log_type
+    uint8_t flags;    // rizz__log_entry_flags_
+} rizz__log_entry;
+
+typedef struct rizz__log_thread {
+    uint8_t buff[LOG_BUFFER_SIZE];
+    sx_align_decl(64, volatile uint32_t) head;    // bytes, written by the producer (owner thread)
+    sx_align_decl(64, volatile uint32_t) tail;    // bytes, written by the logger thread
+    struct rizz__log_thread* next;
+} rizz__log_thread;
+
+typedef struct rizz__logger {
+    sx_tls thread_tls;        // rizz__log_thread*
+    sx_atomic_ptr threads;    // rizz__log_thread* (linked-list)
+    sx_thread* thread;        // NULL if not running, logs are written synchronously in that case
+    sx_sem sem;
+    sx_lock_t lk;             // serializes writes to the sinks (console, file, ...)
+    FILE* file;
+    sx_atomic_int dropped;    // number of dropped entries, because a ring-buffer was full
+    int reported_dropped;
+    volatile int quit;
+    uint64_t start_tick;      // log timestamps are relative to this (app start)
+} rizz__logger;
+
 typedef struct rizz__tls_var {
     uint32_t name_hash;
     void* user;
@@ -117,16 +282,23 @@ typedef struct rizz__tls_var {
 typedef struct rizz__core {
     const sx_alloc* heap_alloc;
     sx_alloc heap_proxy_alloc;
+    rizz__heap_tlsf heap_tlsf;
+    const sx_alloc* mem_heaps[_RIZZ_MEMID_COUNT];    // base heap for each mem-id (libc or tlsf)
     rizz__track_alloc track_allocs[_RIZZ_MEMID_COUNT];
+    rizz__mem_profiler mem_profiler;
     sx_atomic_int heap_count;
     sx_atomic_size heap_size;
     sx_atomic_size heap_max;
 
     sx_rng rng;
+    uint32_t rng_seed;
     sx_job_context* jobs;
     sx_coro_context* coro;
+    sx_fiber_stack_pool* fiber_stacks;    // shared between jobs and coroutines
+    uint64_t fiber_stacks_trim_tick;
 
     uint32_t flags;    // sx_core_flags
+    bool headless;     // RIZZ_APP_FLAG_HEADLESS: graphics runs on the dummy backend
 
     int64_t frame_idx;
     uint64_t elapsed_tick;
@@ -137,6 +309,8 @@ typedef struct rizz__core {
 
     char app_name[32];
     char logfile[32];
+    char cache_dir[RIZZ_MAX_PATH];
+    rizz__logger log;
     uint32_t app_ver;
 
     rizz__core_tmpalloc* tmp_allocs;         // count: num_workers
@@ -163,70 +337,592 @@ static rizz_api_imgui* the_imgui;
 #    define EOL "\n"
 #endif
 
-static void rizz__log_to_file(const char* logfile, const char* text)
+// writes a single log line to all sinks, caller must hold `g_core.log.lk`
+static void rizz__log_write(rizz__log_type type, uint64_t tick, uint32_t tid, const char* text)
 {
-    FILE* f = fopen(logfile, "at");
-    if (f) {
-        fprintf(f, "%s%s", text, EOL);
-        fclose(f);
+    switch (type) {
+    case RIZZ__LOG_TYPE_INFO:
+        puts(text);
+        break;
+    case RIZZ__LOG_TYPE_DEBUG:
+    case RIZZ__LOG_TYPE_VERBOSE:
+        printf("%s%s%s\n", TERM_COLOR_DIM, text, TERM_COLOR_RESET);
+        break;
+    case RIZZ__LOG_TYPE_ERROR:
+        printf("%s%s%s\n", TERM_COLOR_RED, text, TERM_COLOR_RESET);
+        break;
+    case RIZZ__LOG_TYPE_WARNING:
+        printf("%s%s%s\n", TERM_COLOR_YELLOW, text, TERM_COLOR_RESET);
+        break;
     }
-}
 
-static void rizz__print_info(const char* fmt, ...)
-{
-    char text[1024];
-    va_list args;
-    va_start(args, fmt);
-    sx_vsnprintf(text, sizeof(text), fmt, args);
-    va_end(args);
-    puts(text);
-
-    if (g_core.flags & RIZZ_CORE_FLAG_LOG_TO_FILE)
-        rizz__log_to_file(g_core.logfile, text);
+    if ((g_core.flags & RIZZ_CORE_FLAG_LOG_TO_FILE) && g_core.log.file) {
+        double t = sx_tm_sec(tick > g_core.log.start_tick ? (tick - g_core.log.start_tick) : 0);
+        fprintf(g_core.log.file, "%10.3f [%6u] %s%s", t, tid, text, EOL);
+    }
     if (g_core.flags & RIZZ_CORE_FLAG_LOG_TO_PROFILER) {
         rmt_LogText(text);
     }
 
 #if SX_COMPILER_MSVC && defined(_DEBUG)
-    sx_strcat(text, sizeof(text), "\n");
     OutputDebugStringA(text);
+    OutputDebugStringA("\n");
 #endif
 
 #if SX_PLATFORM_ANDROID
-    __android_log_write(ANDROID_LOG_INFO, g_core.app_name, text);
+    static const android_LogPriority k_priorities[] = { ANDROID_LOG_INFO, ANDROID_LOG_DEBUG,
+                                                        ANDROID_LOG_VERBOSE, ANDROID_LOG_ERROR,
+                                                        ANDROID_LOG_WARN };
+    __android_log_write(k_priorities[type], g_core.app_name, text);
 #endif
 }
 
+// deferred formatting: arguments are packed by the calling thread (strings are copied) and the
+// text is formatted by the logger thread. only the conversions that sx_snprintf knows are packed
+typedef enum rizz__log_arg {
+    RIZZ__LOG_ARG_INT32 = 0,
+    RIZZ__LOG_ARG_INT64,
+    RIZZ__LOG_ARG_DOUBLE,
+    RIZZ__LOG_ARG_PTR,
+    RIZZ__LOG_ARG_STR
+} rizz__log_arg;
+
+typedef struct rizz__log_spec {
+    int len;           // number of characters after '%'
+    int num_stars;     // '*' width and precision, each one takes an extra int argument
+    int precision;     // -1 if not set or if it's a '*' (star_precision)
+    bool star_precision;
+    rizz__log_arg arg;
+} rizz__log_spec;
+
+// parses the conversion spec after '%', mirroring stb_sprintf rules for argument sizes
+// returns false if the conversion can't be deferred
+static bool rizz__log_parse_spec(const char* fmt, rizz__log_spec* spec)
+{
+    const char* f = fmt;
+    bool intmax = false;
+
+    spec->num_stars = 0;
+    spec->precision = -1;
+    spec->star_precision = false;
+    while (*f == '-' || *f == '+' || *f == ' ' || *f == '#' || *f == '\'' || *f == '$' ||
+           *f == '_' || *f == '0') {
+        ++f;
+    }
+    if (*f == '*') {
+        ++spec->num_stars;
+        ++f;
+    } else {
+        while (*f >= '0' && *f <= '9')
+            ++f;
+    }
+    if (*f == '.') {
+        ++f;
+        if (*f == '*') {
+            ++spec->num_stars;
+            spec->star_precision = true;
+            ++f;
+        } else {
+            spec->precision = 0;
+            while (*f >= '0' && *f <= '9') {
+                spec->precision = spec->precision * 10 + (*f - '0');
+                ++f;
+            }
+        }
+    }
+
+    switch (*f) {
+    case 'h':
+        ++f;
+        break;
+    case 'l':
+        ++f;
+        if (*f == 'l') {
+            intmax = true;
+            ++f;
+        }
+        break;
+    case 'j':
+        intmax = true;
+        ++f;
+        break;
+    case 'z':
+    case 't':
+        intmax = sizeof(void*) == 8;
+        ++f;
+        break;
+    case 'I':
+        if (f[1] == '6' && f[2] == '4') {
+            intmax = true;
+            f += 3;
+        } else if (f[1] == '3' && f[2] == '2') {
+            f += 3;
+        } else {
+            intmax = sizeof(void*) == 8;
+            ++f;
+        }
+        break;
+    default:
+        break;
+    }
+
+    switch (*f) {
+    case 's':
+        spec->arg = RIZZ__LOG_ARG_STR;
+        break;
+    case 'c':
+        spec->arg = RIZZ__LOG_ARG_INT32;
+        break;
+    case 'd':
+    case 'i':
+    case 'u':
+    case 'b':
+    case 'B':
+    case 'o':
+    case 'x':
+    case 'X':
+        spec->arg = intmax ? RIZZ__LOG_ARG_INT64 : RIZZ__LOG_ARG_INT32;
+        break;
+    case 'p':
+        spec->arg = RIZZ__LOG_ARG_PTR;
+        break;
+    case 'a':
+    case 'A':
+    case 'e':
+    case 'E':
+    case 'f':
+    case 'g':
+    case 'G':
+        spec->arg = RIZZ__LOG_ARG_DOUBLE;
+        break;
+    default:
+        return false;
+    }
+
+    spec->len = (int)(intptr_t)(f + 1 - fmt);
+    return true;
+}
+
+// packs the arguments into 8 byte slots, strings are stored as length + characters
+// returns the number of bytes written to `buff` or -1 if the arguments can't be deferred
+static int rizz__log_pack_args(uint8_t* buff, int max_size, const char* fmt, va_list args)
+{
+    int offset = 0;
+    for (const char* f = fmt; *f; f++) {
+        if (*f != '%')
+            continue;
+        if (f[1] == '%') {
+            ++f;
+            continue;
+        }
+
+        rizz__log_spec spec;
+        if (!rizz__log_parse_spec(f + 1, &spec))
+            return -1;
+        f += spec.len;
+
+        if (offset + (spec.num_stars + 1) * (int)sizeof(uint64_t) > max_size)
+            return -1;
+        int precision = spec.precision;
+        for (int i = 0; i < spec.num_stars; i++) {
+            uint32_t star32 = va_arg(args, uint32_t);
+            uint64_t star = star32;
+            sx_memcpy(buff + offset, &star, sizeof(star));
+            offset += sizeof(star);
+            // precision is the last star, negative value means no precision
+            if (spec.star_precision && i == spec.num_stars - 1)
+                precision = (int)star32;
+        }
+
+        uint64_t value = 0;
+        switch (spec.arg) {
+        case RIZZ__LOG_ARG_INT32:
+            value = (uint64_t)va_arg(args, uint32_t);
+            break;
+        case RIZZ__LOG_ARG_INT64:
+            value = va_arg(args, uint64_t);
+            break;
+        case RIZZ__LOG_ARG_DOUBLE: {
+            double d = va_arg(args, double);
+            sx_memcpy(&value, &d, sizeof(d));
+        } break;
+        case RIZZ__LOG_ARG_PTR:
+            value = (uint64_t)(uintptr_t)va_arg(args, void*);
+            break;
+        case RIZZ__LOG_ARG_STR: {
+            const char* str = va_arg(args, const char*);
+            int len = -1;
+            if (str) {
+                // with precision, the string doesn't have to be null-terminated
+                const char* end = precision >= 0 ? memchr(str, '\0', (size_t)precision) : NULL;
+                len = precision >= 0 ? (end ? (int)(intptr_t)(end - str) : precision)
+                                     : sx_strlen(str);
+            }
+            value = (uint64_t)(int64_t)len;
+            if (len > 0) {
+                if (offset + (int)sizeof(value) + sx_align_mask(len, 7) > max_size)
+                    return -1;
+                sx_memcpy(buff + offset + sizeof(value), str, len);
+            }
+        } break;
+        }
+
+        sx_memcpy(buff + offset, &value, sizeof(value));
+        offset += sizeof(value);
+        if (spec.arg == RIZZ__LOG_ARG_STR && (int64_t)value > 0)
+            offset += sx_align_mask((int)value, 7);
+    }
+    return offset;
+}
+
+static void rizz__log_format_deferred(char* text, int text_size, const char* fmt,
+                                      const uint8_t* args)
+{
+    int pos = 0;
+    const char* f = fmt;
+    while (*f && pos < text_size - 1) {
+        if (*f != '%' || f[1] == '%') {
+            text[pos++] = *f;
+            f += (*f == '%') ? 2 : 1;
+            continue;
+        }
+
+        rizz__log_spec spec;
+        bool r = rizz__log_parse_spec(f + 1, &spec);
+        sx_assert(r && "format string is not the one that is packed");
+        sx_unused(r);
+
+        // rebuild the spec, with '*' values written as numbers
+        char spec_str[64];
+        int spec_pos = 0;
+        const char* spec_end = f + spec.len;
+        for (const char* sf = f; sf <= spec_end && spec_pos < (int)sizeof(spec_str) - 12; sf++) {
+            if (*sf == '*') {
+                uint64_t star;
+                sx_memcpy(&star, args, sizeof(star));
+                args += sizeof(star);
+                spec_pos += sx_snprintf(spec_str + spec_pos, 12, "%u", (uint32_t)star);
+            } else {
+                spec_str[spec_pos++] = *sf;
+            }
+        }
+        spec_str[spec_pos] = '\0';
+        f += spec.len + 1;
+
+        uint64_t value;
+        sx_memcpy(&value, args, sizeof(value));
+        args += sizeof(value);
+
+        char* dst = text + pos;
+        int dst_size = text_size - pos;
+        switch (spec.arg) {
+        case RIZZ__LOG_ARG_INT32:
+            sx_snprintf(dst, dst_size, spec_str, (uint32_t)value);
+            break;
+        case RIZZ__LOG_ARG_INT64:
+            sx_snprintf(dst, dst_size, spec_str, value);
+            break;
+        case RIZZ__LOG_ARG_DOUBLE: {
+            double d;
+            sx_memcpy(&d, &value, sizeof(d));
+            sx_snprintf(dst, dst_size, spec_str, d);
+        } break;
+        case RIZZ__LOG_ARG_PTR:
+            sx_snprintf(dst, dst_size, spec_str, (void*)(uintptr_t)value);
+            break;
+        case RIZZ__LOG_ARG_STR: {
+            int len = (int)(int64_t)value;
+            if (len > 0) {
+                // strings are not null-terminated in the buffer, so copy it out
+                char* str = alloca(len + 1);
+                sx_memcpy(str, args, len);
+                str[len] = '\0';
+                args += sx_align_mask(len, 7);
+                sx_snprintf(dst, dst_size, spec_str, str);
+            } else {
+                sx_snprintf(dst, dst_size, spec_str, len == 0 ? "" : NULL);
+            }
+        } break;
+        }
+        pos += sx_strlen(dst);
+    }
+    text[pos] = '\0';
+}
+
+static rizz__log_thread* rizz__log_get_thread()
+{
+    rizz__logger* log = &g_core.log;
+    rizz__log_thread* lt = (rizz__log_thread*)sx_tls_get(log->thread_tls);
+    if (!lt) {
+        // first log on this thread: create the buffer and add it to the list (lock-free)
+        lt = (rizz__log_thread*)sx_malloc(g_core.heap_alloc, sizeof(rizz__log_thread));
+        if (!lt) {
+            sx_out_of_memory();
+            return NULL;
+        }
+        lt->head = lt->tail = 0;
+
+        void* head;
+        do {
+            head = log->threads;
+            lt->next = (rizz__log_thread*)head;
+        } while (sx_atomic_cas_ptr(&log->threads, lt, head) != head);
+
+        sx_tls_set(log->thread_tls, lt);
+    }
+    return lt;
+}
+
+static void rizz__log_push(rizz__log_thread* lt, const rizz__log_entry* e, bool wake)
+{
+    rizz__logger* log = &g_core.log;
+    uint32_t size = e->size;
+    uint32_t head = lt->head;
+    uint32_t used = head - lt->tail;
+    uint32_t offset = head & (LOG_BUFFER_SIZE - 1);
+    uint32_t contiguous = LOG_BUFFER_SIZE - offset;
+    uint32_t needed = size <= contiguous ? size : (size + contiguous);
+
+    if (LOG_BUFFER_SIZE - used < needed) {
+        sx_atomic_incr(&log->dropped);
+        sx_semaphore_post(&log->sem, 1);
+        return;
+    }
+
+    if (size > contiguous) {
+        *((rizz__log_entry*)&lt->buff[offset]) =
+            (rizz__log_entry){ .size = (uint16_t)contiguous, .flags = RIZZ__LOG_ENTRY_PAD };
+        head += contiguous;
+        offset = 0;
+    }
+    sx_memcpy(&lt->buff[offset], e, size);
+    sx_memory_write_barrier();
+    lt->head = head + size;
+
+    // wake up the logger thread for errors, or when the buffer is getting full
+    if (wake || (used < LOG_BUFFER_SIZE / 2 && used + needed >= LOG_BUFFER_SIZE / 2)) {
+        sx_semaphore_post(&log->sem, 1);
+    }
+}
+
+// returns the oldest entry of the thread, skipping the padding entries
+static const rizz__log_entry* rizz__log_peek(rizz__log_thread* lt)
+{
+    uint32_t tail = lt->tail;
+    while (tail != lt->head) {
+        sx_memory_read_barrier();
+        const rizz__log_entry* e = (const rizz__log_entry*)&lt->buff[tail & (LOG_BUFFER_SIZE - 1)];
+        if (!(e->flags & RIZZ__LOG_ENTRY_PAD))
+            return e;
+        tail += e->size;
+        lt->tail = tail;
+    }
+    return NULL;
+}
+
+// writes all pending entries of all threads, ordered by time, caller must hold `g_core.log.lk`
+static void rizz__log_write_pending(char* text, int text_size)
+{
+    rizz__logger* log = &g_core.log;
+    for (;;) {
+        rizz__log_thread* oldest = NULL;
+        const rizz__log_entry* oldest_e = NULL;
+        for (rizz__log_thread* lt = (rizz__log_thread*)log->threads; lt; lt = lt->next) {
+            const rizz__log_entry* e = rizz__log_peek(lt);
+            if (e && (!oldest_e || e->tick < oldest_e->tick)) {
+                oldest = lt;
+                oldest_e = e;
+            }
+        }
+        if (!oldest)
+            break;
+
+        const char* data = (const char*)(oldest_e + 1);
+        if (oldest_e->flags & RIZZ__LOG_ENTRY_DEFERRED) {
+            int args_offset = sx_align_mask((int)sizeof(rizz__log_entry) + sx_strlen(data) + 1, 7);
+            rizz__log_format_deferred(text, text_size, data,
+                                      (const uint8_t*)oldest_e + args_offset);
+            data = text;
+        }
+        rizz__log_write((rizz__log_type)oldest_e->type, oldest_e->tick, oldest_e->tid, data);
+
+        sx_memory_barrier();
+        oldest->tail += oldest_e->size;
+    }
+}
+
+// writes all pending entries and flushes the sinks
+static void rizz__log_flush()
+{
+    rizz__logger* log = &g_core.log;
+    char text[LOG_MAX_TEXT];
+
+    sx_lock(&log->lk, 1);
+    rizz__log_write_pending(text, sizeof(text));
+
+    int dropped = log->dropped;
+    if (dropped != log->reported_dropped) {
+        sx_snprintf(text, sizeof(text), "WARNING: logger fell behind, %d messages dropped",
+                    dropped - log->reported_dropped);
+        rizz__log_write(RIZZ__LOG_TYPE_WARNING, sx_tm_now(), sx_thread_tid(), text);
+        log->reported_dropped = dropped;
+    }
+
+    fflush(stdout);
+    if (log->file)
+        fflush(log->file);
+    sx_unlock(&log->lk);
+}
+
+static int rizz__log_thread_cb(void* user_data1, void* user_data2)
+{
+    sx_unused(user_data2);
+    rizz__logger* log = user_data1;
+
+    while (!log->quit) {
+        sx_semaphore_wait(&log->sem, LOG_FLUSH_INTERVAL);
+        rizz__log_flush();
+    }
+    rizz__log_flush();
+    rizz__core_thread_exit();
+    return 0;
+}
+
+static void rizz__log_vprint(rizz__log_type type, const char* fmt, va_list args)
+{
+    rizz__logger* log = &g_core.log;
+    rizz__log_thread* lt = log->thread ? rizz__log_get_thread() : NULL;
+    if (!lt || type == RIZZ__LOG_TYPE_ERROR) {
+        // logger thread is not running, or it's an error that must be on disk before the app
+        // goes down: write directly, after the pending logs of all threads
+        char text[LOG_MAX_TEXT];
+        uint64_t tick = sx_tm_now();
+        sx_vsnprintf(text, sizeof(text), fmt, args);
+        sx_lock(&log->lk, 1);
+        if (lt) {
+            char pending_text[LOG_MAX_TEXT];
+            rizz__log_write_pending(pending_text, sizeof(pending_text));
+        }
+        rizz__log_write(type, tick, sx_thread_tid(), text);
+        fflush(stdout);
+        if (log->file)
+            fflush(log->file);
+        sx_unlock(&log->lk);
+        return;
+    }
+
+    sx_align_decl(16, uint8_t data[sizeof(rizz__log_entry) + LOG_MAX_TEXT]);
+    rizz__log_entry* e = (rizz__log_entry*)data;
+    *e = (rizz__log_entry){ .tick = sx_tm_now(), .tid = sx_thread_tid(), .type = (uint8_t)type };
+
+    int size = 0;
+    if (g_core.flags & RIZZ_CORE_FLAG_LOG_DEFER_FORMAT) {
+        int fmt_len = sx_strlen(fmt) + 1;
+        int args_offset = sx_align_mask((int)sizeof(rizz__log_entry) + fmt_len, 7);
+        if (args_offset < (int)sizeof(data)) {
+            va_list args_copy;
+            va_copy(args_copy, args);
+            int args_size = rizz__log_pack_args(data + args_offset, sizeof(data) - args_offset,
+                                                fmt, args_copy);
+            va_end(args_copy);
+            if (args_size >= 0) {
+                sx_memcpy(e + 1, fmt, fmt_len);
+                e->flags = RIZZ__LOG_ENTRY_DEFERRED;
+                size = args_offset + args_size;
+            }
+        }
+    }
+
+    if (size == 0) {
+        char* text = (char*)(e + 1);
+        sx_vsnprintf(text, LOG_MAX_TEXT, fmt, args);
+        size = (int)sizeof(rizz__log_entry) + sx_strlen(text) + 1;
+    }
+
+    e->size = (uint16_t)sx_align_mask(size, 15);
+    rizz__log_push(lt, e, false);
+}
+
+// exit() can be called anywhere (init failures), write what's left in the buffers
+static void rizz__log_atexit(void)
+{
+    if (g_core.log.threads) {
+        rizz__log_flush();
+    }
+}
+
+static bool rizz__log_init()
+{
+    static bool atexit_registered = false;
+    if (!atexit_registered) {
+        atexit(rizz__log_atexit);
+        atexit_registered = true;
+    }
+
+    rizz__logger* log = &g_core.log;
+    log->thread_tls = sx_tls_create();
+    if (!log->thread_tls) {
+        sx_out_of_memory();
+        return false;
+    }
+
+    sx_semaphore_init(&log->sem);
+    log->thread =
+        sx_thread_create(g_core.heap_alloc, rizz__log_thread_cb, log, 0, "rizz_log", NULL);
+    if (!log->thread) {
+        sx_semaphore_release(&log->sem);
+        return false;
+    }
+    return true;
+}
+
+// stops the logger thread and writes remaining logs, logs are written synchronously after this
+static void rizz__log_release()
+{
+    rizz__logger* log = &g_core.log;
+    if (log->thread) {
+        log->quit = 1;
+        sx_semaphore_post(&log->sem, 1);
+        sx_thread_destroy(log->thread, g_core.heap_alloc);
+        log->thread = NULL;
+        sx_semaphore_release(&log->sem);
+    }
+
+    rizz__log_flush();
+
+    rizz__log_thread* lt = (rizz__log_thread*)log->threads;
+    while (lt) {
+        rizz__log_thread* next = lt->next;
+        sx_free(g_core.heap_alloc, lt);
+        lt = next;
+    }
+    log->threads = NULL;
+
+    if (log->thread_tls) {
+        sx_tls_destroy(log->thread_tls);
+        log->thread_tls = NULL;
+    }
+}
+
+static void rizz__print_info(const char* fmt, ...)
+{
+    va_list args;
+    va_start(args, fmt);
+    rizz__log_vprint(RIZZ__LOG_TYPE_INFO, fmt, args);
+    va_end(args);
+}
+
 static void rizz__print_debug(const char* fmt, ...)
 {
 #ifdef _DEBUG
-    char text[1024];
     char new_fmt[1024];
-
     sx_strcpy(new_fmt, sizeof(new_fmt), "DEBUG: ");
     sx_strcat(new_fmt, sizeof(new_fmt), fmt);
 
     va_list args;
     va_start(args, fmt);
-    sx_vsnprintf(text, sizeof(text), new_fmt, args);
+    rizz__log_vprint(RIZZ__LOG_TYPE_DEBUG, new_fmt, args);
     va_end(args);
-    printf("%s%s%s\n", TERM_COLOR_DIM, text, TERM_COLOR_RESET);
-
-    if (g_core.flags & RIZZ_CORE_FLAG_LOG_TO_FILE)
-        rizz__log_to_file(g_core.logfile, text);
-
-    if (g_core.flags & RIZZ_CORE_FLAG_LOG_TO_PROFILER) {
-        rmt_LogText(text);
-    }
-
-#    if SX_COMPILER_MSVC
-    sx_strcat(text, sizeof(text), "\n");
-    OutputDebugStringA(text);
-#    endif
-
-#    if SX_PLATFORM_ANDROID
-    __android_log_write(ANDROID_LOG_DEBUG, g_core.app_name, text);
-#    endif
 #else
     sx_unused(fmt);
 #endif
@@ -235,64 +931,31 @@ static void rizz__print_debug(const char* fmt, ...)
 static void rizz__print_verbose(const char* fmt, ...)
 {
     if (g_core.flags & RIZZ_CORE_FLAG_VERBOSE) {
-        char text[1024];
         char new_fmt[1024];
         sx_strcpy(new_fmt, sizeof(new_fmt), "-- ");
         sx_strcat(new_fmt, sizeof(new_fmt), fmt);
+
         va_list args;
         va_start(args, fmt);
-        sx_vsnprintf(text, sizeof(text), new_fmt, args);
+        rizz__log_vprint(RIZZ__LOG_TYPE_VERBOSE, new_fmt, args);
         va_end(args);
-
-        printf("%s%s%s\n", TERM_COLOR_DIM, text, TERM_COLOR_RESET);
-        if (g_core.flags & RIZZ_CORE_FLAG_LOG_TO_FILE)
-            rizz__log_to_file(g_core.logfile, text);
-        if (g_core.flags & RIZZ_CORE_FLAG_LOG_TO_PROFILER) {
-            rmt_LogText(text);
-        }
-
-#if SX_COMPILER_MSVC && defined(_DEBUG)
-        sx_strcat(text, sizeof(text), "\n");
-        OutputDebugStringA(text);
-#endif
-
-#if SX_PLATFORM_ANDROID
-        __android_log_write(ANDROID_LOG_VERBOSE, g_core.app_name, text);
-#endif
     }
 }
 
 static void rizz__print_error(const char* fmt, ...)
 {
-    char text[1024];
     char new_fmt[1024];
     sx_strcpy(new_fmt, sizeof(new_fmt), "ERROR: ");
     sx_strcat(new_fmt, sizeof(new_fmt), fmt);
 
     va_list args;
     va_start(args, fmt);
-    sx_vsnprintf(text, sizeof(text), new_fmt, args);
+    rizz__log_vprint(RIZZ__LOG_TYPE_ERROR, new_fmt, args);
     va_end(args);
-    printf("%s%s%s\n", TERM_COLOR_RED, text, TERM_COLOR_RESET);
-
-    if (g_core.flags & RIZZ_CORE_FLAG_LOG_TO_FILE)
-        rizz__log_to_file(g_core.logfile, text);
-    if (g_core.flags & RIZZ_CORE_FLAG_LOG_TO_PROFILER) {
-        rmt_LogText(text);
-    }
-#if SX_COMPILER_MSVC && defined(_DEBUG)
-    sx_strcat(text, sizeof(text), "\n");
-    OutputDebugStringA(text);
-#endif
-
-#if SX_PLATFORM_ANDROID
-    __android_log_write(ANDROID_LOG_ERROR, g_core.app_name, text);
-#endif
 }
 
 static void rizz__print_error_trace(const char* source_file, int line, const char* fmt, ...)
 {
-    char text[1024];
     char new_fmt[1024];
 
 #ifdef _DEBUG
@@ -309,54 +972,20 @@ static void rizz__print_error_trace(const char* source_file, int line, const cha
 
     va_list args;
     va_start(args, fmt);
-    sx_vsnprintf(text, sizeof(text), new_fmt, args);
+    rizz__log_vprint(RIZZ__LOG_TYPE_ERROR, new_fmt, args);
     va_end(args);
-    printf("%s%s%s\n", TERM_COLOR_RED, text, TERM_COLOR_RESET);
-
-    if (g_core.flags & RIZZ_CORE_FLAG_LOG_TO_FILE)
-        rizz__log_to_file(g_core.logfile, text);
-    if (g_core.flags & RIZZ_CORE_FLAG_LOG_TO_PROFILER) {
-        rmt_LogText(text);
-    }
-
-#if SX_COMPILER_MSVC && defined(_DEBUG)
-    sx_strcat(text, sizeof(text), "\n");
-    OutputDebugStringA(text);
-#endif
-
-#if SX_PLATFORM_ANDROID
-    __android_log_write(ANDROID_LOG_ERROR, g_core.app_name, text);
-#endif
 }
 
 static void rizz__print_warning(const char* fmt, ...)
 {
-    char text[1024];
     char new_fmt[1024];
-
     sx_strcpy(new_fmt, sizeof(new_fmt), "WARNING: ");
     sx_strcat(new_fmt, sizeof(new_fmt), fmt);
 
     va_list args;
     va_start(args, fmt);
-    sx_vsnprintf(text, sizeof(text), new_fmt, args);
+    rizz__log_vprint(RIZZ__LOG_TYPE_WARNING, new_fmt, args);
     va_end(args);
-    printf("%s%s%s\n", TERM_COLOR_YELLOW, text, TERM_COLOR_RESET);
-
-    if (g_core.flags & RIZZ_CORE_FLAG_LOG_TO_FILE)
-        rizz__log_to_file(g_core.logfile, text);
-    if (g_core.flags & RIZZ_CORE_FLAG_LOG_TO_PROFILER) {
-        rmt_LogText(text);
-    }
-
-#if SX_COMPILER_MSVC && defined(_DEBUG)
-    sx_strcat(text, sizeof(text), "\n");
-    OutputDebugStringA(text);
-#endif
-
-#if SX_PLATFORM_ANDROID
-    __android_log_write(ANDROID_LOG_WARN, g_core.app_name, text);
-#endif
 }
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
@@ -407,12 +1036,15 @@ int64_t rizz__frame_index()
 
 void rizz__set_cache_dir(const char* path)
 {
-    sx_unused(path);
+    sx_assert(path);
+    sx_os_path_normpath(g_core.cache_dir, sizeof(g_core.cache_dir), path);
+    if (!sx_os_path_isdir(g_core.cache_dir) && !sx_os_mkdir(g_core.cache_dir))
+        rizz_log_warn("could not create cache directory: %s", g_core.cache_dir);
 }
 
 const char* rizz__cache_dir()
 {
-    return NULL;
+    return g_core.cache_dir[0] ? g_core.cache_dir : NULL;
 }
 
 const char* rizz__data_dir()
@@ -425,11 +1057,19 @@ sx_job_context* rizz__job_ctx()
     return g_core.jobs;
 }
 
-static const char* k__gfx_driver_names[RIZZ_GFX_BACKEND_DUMMY] = { "OpenGL 3.3",  "OpenGL-ES 2",
-                                                                   "OpenGL-ES 3", "Direct3D11",
-                                                                   "Metal IOS",   "Metal MacOS",
-                                                                   "Metal Sim" };
+static const char* k__gfx_driver_names[RIZZ_GFX_BACKEND_DUMMY + 1] = {
+    "OpenGL 3.3", "OpenGL-ES 2", "OpenGL-ES 3", "Direct3D11",
+    "Metal IOS",  "Metal MacOS", "Metal Sim",   "Dummy"
+};
 
+// headless mode uses the graphics module that is built with sokol's dummy backend
+#if RIZZ_CONFIG_HEADLESS
+#    define rizz__gfx_fn(_name) (g_core.headless ? rizz__gfx_headless_##_name : rizz__gfx_##_name)
+#else
+#    define rizz__gfx_fn(_name) rizz__gfx_##_name
+#endif
+
+// the file is kept open and written by the logger, until the core is released
 static void rizz__init_log(const char* logfile)
 {
     FILE* f = fopen(logfile, "wt");
@@ -440,283 +1080,898 @@ static void rizz__init_log(const char* logfile)
                 rizz_version_major(g_core.app_ver), rizz_version_minor(g_core.app_ver),
                 rizz_version_bugfix(g_core.app_ver), rizz_version_major(RIZZ_VERSION),
                 rizz_version_minor(RIZZ_VERSION), rizz_version_bugfix(RIZZ_VERSION), EOL, EOL);
-        fclose(f);
+        g_core.log.file = f;
     } else {
         sx_assert(0 && "could not write to log file");
         g_core.flags &= ~RIZZ_CORE_FLAG_LOG_TO_FILE;
     }
 }
 
-static void rizz__job_thread_init_cb(sx_job_context* ctx, int thread_index, uint32_t thread_id,
-                                     void* user)
+static void rizz__job_thread_init_cb(sx_job_context* ctx, int thread_index, uint32_t thread_id,
+                                     void* user)
+{
+    sx_unused(thread_id);
+    sx_unused(user);
+    sx_unused(ctx);
+
+    int worker_index = thread_index + 1;    // 0 is rreserved for main-thread
+    sx_tls_set(g_core.tmp_allocs_tls, &g_core.tmp_allocs[worker_index]);
+    sx_tls_set(g_core.cmdbuffer_tls, g_core.gfx_cmdbuffers[worker_index]);
+
+    char name[32];
+    sx_snprintf(name, sizeof(name), "Thread #%d", worker_index);
+    rmt_SetCurrentThreadName(name);
+}
+
+static void rizz__job_thread_shutdown_cb(sx_job_context* ctx, int thread_index, uint32_t thread_id,
+                                         void* user)
+{
+    sx_unused(ctx);
+    sx_unused(thread_index);
+    sx_unused(thread_id);
+    sx_unused(user);
+
+    rizz__core_thread_exit();
+}
+
+static void rizz__rmt_input_handler(const char* text, void* context)
+{
+    sx_unused(context);
+
+    // parse text into argc/argv
+    int argc = 0;
+    char arg[256];
+
+    const char* cline = sx_skip_whitespace(text);
+    while (cline && *cline) {
+        for (char c = *cline; !sx_isspace(c) && *cline; c = *(++cline)) {
+        }
+        cline = sx_skip_whitespace(cline);
+        argc++;
+    }
+    if (argc == 0)
+        return;
+
+    const sx_alloc* tmp_alloc = the__core.tmp_alloc_push();
+    char** argv = sx_malloc(tmp_alloc, sizeof(char*) * argc);
+    sx_assert(argv);
+
+    cline = sx_skip_whitespace(text);
+    int arg_idx = 0;
+    while (cline && *cline) {
+        int char_idx = 0;
+        for (char c = *cline; !sx_isspace(c) && *cline && char_idx < (int)sizeof(arg);
+             c = *(++cline), ++char_idx) {
+            arg[char_idx] = c;
+        }
+        arg[char_idx] = '\0';
+        cline = sx_skip_whitespace(cline);
+        argv[arg_idx] = sx_malloc(tmp_alloc, (size_t)strlen(arg) + 1);
+        sx_assert(argv);
+        sx_strcpy(argv[arg_idx++], sizeof(arg), arg);
+    }
+
+    for (int i = 0; i < sx_array_count(g_core.console_cmds); i++) {
+        if (sx_strequal(g_core.console_cmds[i].name, argv[0])) {
+            int r;
+            if ((r = g_core.console_cmds[i].callback(argc, argv)) < 0) {
+                char err_msg[256];
+                sx_snprintf(err_msg, sizeof(err_msg), "command '%s' failed with error: %d", argv[0],
+                            r);
+                rmt_LogText(err_msg);
+            }
+            break;
+        }
+    }
+
+    the__core.tmp_alloc_pop();
+}
+
+static const sx_alloc* rizz__alloc(rizz_mem_id id)
+{
+#if RIZZ_CONFIG_DEBUG_MEMORY
+    sx_assert(id < _RIZZ_MEMID_COUNT);
+    return &g_core.track_allocs[id].alloc;
+#else
+    sx_assert(id < _RIZZ_MEMID_COUNT);
+    return g_core.mem_heaps[id];
+#endif
+}
+
+static void rizz__core_register_console_command(const char* cmd, rizz_core_cmd_cb* callback)
+{
+    sx_assert(cmd);
+    sx_assert(cmd[0]);
+    sx_assert(callback);
+
+    rizz__core_cmd c;
+    sx_strcpy(c.name, sizeof(c.name), cmd);
+    c.callback = callback;
+    sx_array_push(rizz__alloc(RIZZ_MEMID_CORE), g_core.console_cmds, c);
+}
+
+static inline void rizz__atomic_max(sx_atomic_size* _max, intptr_t val)
+{
+    intptr_t cur_max = *_max;
+    while (cur_max < val && sx_atomic_cas_size(_max, val, cur_max) != cur_max) {
+        cur_max = *_max;
+    }
+}
+
+static rizz__heap_thread* rizz__heap_thread_create()
+{
+    rizz__heap_tlsf* heap = &g_core.heap_tlsf;
+    const sx_alloc* alloc = g_core.heap_alloc;
+
+    // reuse the heap of an exited thread
+    sx_lock(&heap->free_lock, 1);
+    rizz__heap_thread* free_ht = heap->free_list;
+    if (free_ht)
+        heap->free_list = free_ht->next_free;
+    sx_unlock(&heap->free_lock);
+    if (free_ht) {
+        free_ht->next_free = NULL;
+        sx_tls_set(heap->thread_tls, free_ht);
+        return free_ht;
+    }
+
+    rizz__heap_thread* ht = sx_malloc(alloc, sizeof(rizz__heap_thread));
+    void* pool = sx_malloc(alloc, HEAP_TLSF_POOL_SIZE);
+    if (!ht || !pool) {
+        sx_free(alloc, ht);
+        sx_free(alloc, pool);
+        sx_out_of_memory();
+        return NULL;
+    }
+    sx_memset(ht, 0x0, sizeof(rizz__heap_thread));
+
+    if (!sx_tlsfalloc_init(&ht->tlsf, pool, HEAP_TLSF_POOL_SIZE)) {
+        sx_free(alloc, pool);
+        sx_free(alloc, ht);
+        return NULL;
+    }
+    sx_array_push(alloc, ht->pools, pool);
+
+    void* head;
+    do {
+        head = heap->threads;
+        ht->next = (rizz__heap_thread*)head;
+    } while (sx_atomic_cas_ptr(&heap->threads, ht, head) != head);
+
+    sx_tls_set(heap->thread_tls, ht);
+    return ht;
+}
+
+// heap stats are shared by libc and thread heaps, the peak is taken from the exact sum after each
+// change, so `heap_max` is never missed between two `get_mem_info` calls
+static inline void rizz__heap_account(intptr_t size, int count)
+{
+    intptr_t cur = (intptr_t)sx_atomic_add_fetch_size(&g_core.heap_size, size);
+    if (size > 0)
+        rizz__atomic_max(&g_core.heap_max, cur);
+    if (count)
+        sx_atomic_fetch_add(&g_core.heap_count, count);
+}
+
+// releases the blocks that other threads have freed (owner thread only)
+static void rizz__heap_thread_collect(rizz__heap_thread* ht)
+{
+    rizz__proxy_alloc_header* header =
+        (rizz__proxy_alloc_header*)sx_atomic_xchg_ptr(&ht->remote_frees, NULL);
+    while (header) {
+        rizz__proxy_alloc_header* next = header->next_free;
+        rizz__heap_account(-header->size, -1);
+        sx_free(&ht->tlsf, (uint8_t*)(header + 1) - header->ptr_offset);
+        header = next;
+    }
+}
+
+static void* rizz__heap_thread_malloc(rizz__heap_thread* ht, size_t size, const char* file,
+                                      const char* func, uint32_t line)
+{
+    void* ptr = sx__malloc(&ht->tlsf, size, 0, file, func, line);
+    if (!ptr) {
+        // grow with a new pool, blocks are limited to HEAP_TLSF_MAX_BLOCK, so it always fits
+        void* pool = sx_malloc(g_core.heap_alloc, HEAP_TLSF_POOL_SIZE);
+        if (!pool)
+            return NULL;
+        sx_tlsfalloc_add_pool(&ht->tlsf, pool, HEAP_TLSF_POOL_SIZE);
+        sx_array_push(g_core.heap_alloc, ht->pools, pool);
+        ptr = sx__malloc(&ht->tlsf, size, 0, file, func, line);
+    }
+    return ptr;
+}
+
+static void rizz__heap_thread_destroy(rizz__heap_thread* ht)
+{
+    const sx_alloc* alloc = g_core.heap_alloc;
+    sx_tlsfalloc_release(&ht->tlsf);
+    for (int i = 0; i < sx_array_count(ht->pools); i++) {
+        sx_free(alloc, ht->pools[i]);
+    }
+    sx_array_free(alloc, ht->pools);
+    sx_free(alloc, ht);
+}
+
+// called by the thread itself before it exits, the heap is put into the free list
+static void rizz__heap_thread_exit()
+{
+    rizz__heap_tlsf* heap = &g_core.heap_tlsf;
+    if (!heap->thread_tls)
+        return;
+
+    rizz__heap_thread* ht = (rizz__heap_thread*)sx_tls_get(heap->thread_tls);
+    if (ht) {
+        rizz__heap_thread_collect(ht);
+        sx_tls_set(heap->thread_tls, NULL);
+
+        sx_lock(&heap->free_lock, 1);
+        ht->next_free = heap->free_list;
+        heap->free_list = ht;
+        sx_unlock(&heap->free_lock);
+    }
+}
+
+static inline rizz__heap_thread* rizz__heap_thread_get()
+{
+    rizz__heap_thread* ht = (rizz__heap_thread*)sx_tls_get(g_core.heap_tlsf.thread_tls);
+    return ht ? ht : rizz__heap_thread_create();
+}
+
+// allocates a block with `rizz__proxy_alloc_header` from the calling thread's tlsf heap (use_tlsf)
+// or from libc heap. blocks can be freed from any thread
+static void* rizz__proxy_malloc(size_t size, uint32_t align, bool use_tlsf, const char* file,
+                                const char* func, uint32_t line)
+{
+    align = sx_max((int)align, SX_CONFIG_ALLOCATOR_NATURAL_ALIGNMENT);
+
+    // do the alignment ourselves
+    intptr_t total = (intptr_t)size + sizeof(rizz__proxy_alloc_header) + align;
+    rizz__heap_thread* ht = NULL;
+    uint8_t* _ptr;
+    if (use_tlsf && total <= HEAP_TLSF_MAX_BLOCK && (ht = rizz__heap_thread_get()) != NULL) {
+        rizz__heap_thread_collect(ht);
+        _ptr = rizz__heap_thread_malloc(ht, total, file, func, line);
+    } else {
+        ht = NULL;
+        _ptr = sx__malloc(g_core.heap_alloc, total, 0, file, func, line);
+    }
+
+    if (!_ptr) {
+        sx_out_of_memory();
+        return NULL;
+    }
+
+    uint8_t* aligned = (uint8_t*)sx_align_ptr(_ptr, sizeof(rizz__proxy_alloc_header), align);
+    rizz__proxy_alloc_header* header = (rizz__proxy_alloc_header*)aligned - 1;
+    header->size = total;
+    header->ptr_offset = (uint32_t)(uintptr_t)(aligned - _ptr);
+    header->callsite = 0;
+    header->owner = ht;
+
+    rizz__heap_account(total, 1);
+
+    return aligned;
+}
+
+static void rizz__proxy_free(void* ptr, const char* file, const char* func, uint32_t line)
+{
+    rizz__proxy_alloc_header* header = (rizz__proxy_alloc_header*)ptr - 1;
+    rizz__heap_thread* owner = header->owner;
+    void* _ptr = (uint8_t*)ptr - header->ptr_offset;
+
+    if (!owner) {
+        rizz__heap_account(-header->size, -1);
+        sx__free(g_core.heap_alloc, _ptr, 0, file, func, line);
+    } else if (owner == (rizz__heap_thread*)sx_tls_get(g_core.heap_tlsf.thread_tls)) {
+        rizz__heap_account(-header->size, -1);
+        sx__free(&owner->tlsf, _ptr, 0, file, func, line);
+    } else {
+        // block belongs to another thread, push it to the owner's lock-free list
+        void* head;
+        do {
+            head = owner->remote_frees;
+            header->next_free = (rizz__proxy_alloc_header*)head;
+        } while (sx_atomic_cas_ptr(&owner->remote_frees, header, head) != head);
+    }
+}
+
+static void* rizz__proxy_realloc(void* ptr, size_t size, uint32_t align, bool use_tlsf,
+                                 const char* file, const char* func, uint32_t line)
+{
+    rizz__proxy_alloc_header* header = (rizz__proxy_alloc_header*)ptr - 1;
+    rizz__heap_thread* owner = header->owner;
+    align = sx_max((int)align, SX_CONFIG_ALLOCATOR_NATURAL_ALIGNMENT);
+    intptr_t total = (intptr_t)size + sizeof(rizz__proxy_alloc_header) + align;
+
+    // resize in-place only if the block stays in the same heap, otherwise move it
+    const sx_alloc* alloc = NULL;
+    if (!owner) {
+        if (!use_tlsf || total > HEAP_TLSF_MAX_BLOCK)
+            alloc = g_core.heap_alloc;
+    } else if (total <= HEAP_TLSF_MAX_BLOCK &&
+               owner == (rizz__heap_thread*)sx_tls_get(g_core.heap_tlsf.thread_tls)) {
+        alloc = &owner->tlsf;
+    }
+
+    if (alloc) {
+        uint8_t* aligned = (uint8_t*)ptr;
+        uint32_t offset = header->ptr_offset;
+        intptr_t prev_size = header->size;
+        uint8_t* _ptr = sx__realloc(alloc, aligned - offset, total, 0, file, func, line);
+        if (_ptr) {
+            rizz__heap_account(total - prev_size, 0);
+
+            uint8_t* new_aligned =
+                (uint8_t*)sx_align_ptr(_ptr, sizeof(rizz__proxy_alloc_header), align);
+            aligned = _ptr + offset;
+            if (new_aligned != aligned)
+                sx_memmove(new_aligned, aligned, size);
+            header = (rizz__proxy_alloc_header*)new_aligned - 1;
+            header->size = total;
+            header->ptr_offset = (uint32_t)(uintptr_t)(new_aligned - _ptr);
+            header->owner = owner;
+            return new_aligned;
+        } else if (!owner) {
+            sx_out_of_memory();
+            return NULL;
+        }
+        // thread heap is full, the block is left intact, so move it to a new pool
+    }
+
+    void* new_ptr = rizz__proxy_malloc(size, align, use_tlsf, file, func, line);
+    if (!new_ptr)
+        return NULL;
+    sx_memcpy(new_ptr, ptr, sx_min((intptr_t)size, header->size - header->ptr_offset));
+    rizz__proxy_free(ptr, file, func, line);
+    return new_ptr;
+}
+
+// user_data: non-NULL if new allocations should go to thread heaps (tlsf)
+static void* rizz__proxy_alloc_cb(void* ptr, size_t size, uint32_t align, const char* file,
+                                  const char* func, uint32_t line, void* user_data)
+{
+    bool use_tlsf = user_data != NULL;
+    if (size == 0) {
+        if (ptr)
+            rizz__proxy_free(ptr, file, func, line);
+        return NULL;
+    } else if (ptr == NULL) {
+        return rizz__proxy_malloc(size, align, use_tlsf, file, func, line);
+    } else {
+        return rizz__proxy_realloc(ptr, size, align, use_tlsf, file, func, line);
+    }
+}
+
+static inline void rizz__atomic_max64(sx_atomic_int64* _max, int64_t val)
+{
+    int64_t cur_max = *_max;
+    while (cur_max < val && sx_atomic_cas64(_max, val, cur_max) != cur_max) {
+        cur_max = *_max;
+    }
+}
+
+static rizz__mem_thread* rizz__mem_profiler_thread()
+{
+    rizz__mem_profiler* prof = &g_core.mem_profiler;
+    if (prof->sample_rate == 0)    // profiler is not initialized or released
+        return NULL;
+
+    rizz__mem_thread* mt = (rizz__mem_thread*)sx_tls_get(prof->thread_tls);
+    if (!mt) {
+        // first allocation on this thread: create the buffer and add it to the list (lock-free)
+        // this memory is taken directly from the heap, so it won't be tracked itself
+        mt = (rizz__mem_thread*)sx_malloc(g_core.heap_alloc, sizeof(rizz__mem_thread));
+        if (!mt) {
+            sx_out_of_memory();
+            return NULL;
+        }
+        sx_memset(mt, 0x0, sizeof(rizz__mem_thread));
+
+        void* head;
+        do {
+            head = prof->threads;
+            mt->next = (rizz__mem_thread*)head;
+        } while (sx_atomic_cas_ptr(&prof->threads, mt, head) != head);
+
+        sx_tls_set(prof->thread_tls, mt);
+    }
+    return mt;
+}
+
+static inline bool rizz__mem_profiler_push(rizz__mem_thread* mt, const rizz__mem_event* e)
+{
+    int head = mt->head;
+    if (head - mt->tail < MEM_PROFILER_EVENTS_PER_THREAD) {
+        mt->events[head & (MEM_PROFILER_EVENTS_PER_THREAD - 1)] = *e;
+        sx_memory_write_barrier();
+        mt->head = head + 1;
+        return true;
+    } else {
+        sx_atomic_incr(&g_core.mem_profiler.dropped);
+        return false;
+    }
+}
+
+// returns the call-site key (slot index + 1) or 0 if the table is full
+static uint32_t rizz__mem_profiler_callsite(int mem_id, const char* file, const char* func,
+                                            uint32_t line)
+{
+    // only sampled allocations get here, so copying the strings into the key is affordable
+    rizz__mem_callsite_key key;
+    sx_memset(&key, 0x0, sizeof(key));
+    sx_os_path_basename(key.file, sizeof(key.file), file);
+    sx_strcpy(key.func, sizeof(key.func), func);
+    key.line = line;
+    key.mem_id = mem_id;
+    uint32_t hash = sx_hash_fnv32(&key, sizeof(key));
+
+    rizz__mem_callsite* callsites = g_core.mem_profiler.callsites;
+    for (uint32_t i = 0; i < MEM_PROFILER_MAX_CALLSITES; i++) {
+        uint32_t index = (hash + i) & (MEM_PROFILER_MAX_CALLSITES - 1);
+        rizz__mem_callsite* c = &callsites[index];
+        int state = c->state;
+        if (state == RIZZ__MEM_CALLSITE_EMPTY) {
+            state = sx_atomic_cas(&c->state, RIZZ__MEM_CALLSITE_WRITING, RIZZ__MEM_CALLSITE_EMPTY);
+            if (state == RIZZ__MEM_CALLSITE_EMPTY) {
+                sx_memcpy(&c->key, &key, sizeof(key));
+                sx_memory_write_barrier();
+                c->state = RIZZ__MEM_CALLSITE_READY;
+                return index + 1;
+            }
+        }
+
+        // another thread is writing this slot, wait for the key to compare
+        while (state == RIZZ__MEM_CALLSITE_WRITING) {
+            sx_yield_cpu();
+            state = c->state;
+        }
+        sx_memory_read_barrier();
+        if (sx_memcmp(&c->key, &key, sizeof(key)) == 0)
+            return index + 1;
+    }
+    return 0;
+}
+
+static void rizz__mem_profiler_track_alloc(rizz__track_alloc* talloc,
+                                           rizz__proxy_alloc_header* header, const char* file,
+                                           const char* func, uint32_t line)
+{
+    int64_t size = sx_atomic_add_fetch64(&talloc->size, header->size);
+    rizz__atomic_max64(&talloc->peak, size);
+
+    header->callsite = 0;
+    rizz__mem_thread* mt = rizz__mem_profiler_thread();
+    if (!mt || ++mt->sample_counter < g_core.mem_profiler.sample_rate)
+        return;
+    mt->sample_counter = 0;
+
+    uint32_t callsite =
+        rizz__mem_profiler_callsite(talloc->mem_id, file ? file : "", func ? func : "", line);
+    if (!callsite) {
+        sx_atomic_incr(&g_core.mem_profiler.dropped);
+        return;
+    }
+
+    // only keep the key if the event is recorded, so the free won't be subtracted from the
+    // call-site without it's allocation
+    if (rizz__mem_profiler_push(mt, &(rizz__mem_event){ .size = header->size,
+                                                        .callsite = callsite,
+                                                        .mem_id = (uint32_t)talloc->mem_id })) {
+        header->callsite = callsite;
+    }
+}
+
+static void rizz__mem_profiler_track_free(rizz__track_alloc* talloc,
+                                          const rizz__proxy_alloc_header* header)
+{
+    sx_atomic_fetch_add64(&talloc->size, -header->size);
+
+    if (header->callsite) {
+        rizz__mem_thread* mt = rizz__mem_profiler_thread();
+        if (mt) {
+            rizz__mem_profiler_push(mt, &(rizz__mem_event){ .size = -header->size,
+                                                            .callsite = header->callsite,
+                                                            .mem_id = (uint32_t)talloc->mem_id });
+        }
+    }
+}
+
+static int rizz__mem_profiler_add_callsite(const rizz__mem_callsite* c)
+{
+    // slots are unique by content, so every slot gets it's own item
+    rizz_track_alloc_item item = { .line = (int)c->key.line, .mem_id = c->key.mem_id };
+    sx_strcpy(item.file, sizeof(item.file), c->key.file);
+    sx_strcpy(item.func, sizeof(item.func), c->key.func);
+
+    rizz__track_alloc* talloc = &g_core.track_allocs[c->key.mem_id];
+    int value = (c->key.mem_id << 24) | sx_array_count(talloc->items);
+    sx_array_push(g_core.heap_alloc, talloc->items, item);
+    return value;
+}
+
+// consumes all pending events of all threads and aggregates them by call-site (main thread only)
+static void rizz__mem_profiler_update()
+{
+    rizz__mem_profiler* prof = &g_core.mem_profiler;
+    if (!prof->callsites)
+        return;
+
+    int rate = prof->sample_rate;
+    for (rizz__mem_thread* mt = (rizz__mem_thread*)prof->threads; mt; mt = mt->next) {
+        int head = mt->head;
+        sx_memory_read_barrier();
+        for (int tail = mt->tail; tail != head; tail++) {
+            const rizz__mem_event* e = &mt->events[tail & (MEM_PROFILER_EVENTS_PER_THREAD - 1)];
+            rizz__mem_callsite* c = &prof->callsites[e->callsite - 1];
+            if (c->item == -1) {
+                // free event without any allocations recorded, ignore
+                if (e->size < 0)
+                    continue;
+                c->item = rizz__mem_profiler_add_callsite(c);
+            }
+            int value = c->item;
+
+            // sampled allocations are scaled by the sample rate, so the results are estimates
+            rizz__track_alloc* talloc = &g_core.track_allocs[value >> 24];
+            rizz_track_alloc_item* item = &talloc->items[value & 0xffffff];
+            if (e->size > 0) {
+                item->num_allocs += rate;
+                item->total_allocs += rate;
+                item->size += e->size * rate;
+                item->peak = sx_max(item->peak, item->size);
+            } else {
+                // sampled estimates can undershoot, never report negative live memory
+                item->num_allocs = sx_max(0, item->num_allocs - rate);
+                item->size = sx_max((int64_t)0, item->size + e->size * rate);
+            }
+        }
+        sx_memory_barrier();
+        mt->tail = head;
+    }
+}
+
+// NOTE: this special tracker alloc, always assumes that the redirecting allocator is
+// proxy-allocator
+//       Thus is assumes that all our pointers have rizz__proxy_alloc_header
+//       Allocations are recorded as events in per-thread buffers, so there are no locks involved.
+//       Also the header of each allocation is only touched by the thread that is calling the
+//       allocator for that pointer, so concurrent malloc/realloc calls on different pointers
+//       won't conflict
+static void* rizz__track_alloc_cb(void* ptr, size_t size, uint32_t align, const char* file,
+                                  const char* func, uint32_t line, void* user_data)
 {
-    sx_unused(thread_id);
-    sx_unused(user);
-    sx_unused(ctx);
+    rizz__track_alloc* talloc = user_data;
+    const sx_alloc* proxy_alloc = talloc->heap;
 
-    int worker_index = thread_index + 1;    // 0 is rreserved for main-thread
-    sx_tls_set(g_core.tmp_allocs_tls, &g_core.tmp_allocs[worker_index]);
-    sx_tls_set(g_core.cmdbuffer_tls, g_core.gfx_cmdbuffers[worker_index]);
+    if (size == 0) {
+        // free
+        if (ptr) {
+            const rizz__proxy_alloc_header* header = (rizz__proxy_alloc_header*)ptr - 1;
+            rizz__mem_profiler_track_free(talloc, header);
+            sx__free(proxy_alloc, ptr, align, file, func, line);
+        }
 
-    char name[32];
-    sx_snprintf(name, sizeof(name), "Thread #%d", worker_index);
-    rmt_SetCurrentThreadName(name);
+        return NULL;
+    } else if (ptr == NULL) {
+        // malloc
+        ptr = sx__malloc(proxy_alloc, size, align, file, func, line);
+        if (!ptr)
+            return NULL;
+        rizz__mem_profiler_track_alloc(talloc, (rizz__proxy_alloc_header*)ptr - 1, file, func,
+                                       line);
+        return ptr;
+    } else {
+        // realloc: keep a copy of the previous header, because the block may move
+        rizz__proxy_alloc_header prev_header = *((rizz__proxy_alloc_header*)ptr - 1);
+
+        ptr = sx__realloc(proxy_alloc, ptr, size, align, file, func, line);
+        if (!ptr)
+            return NULL;
+        rizz__mem_profiler_track_free(talloc, &prev_header);
+        rizz__mem_profiler_track_alloc(talloc, (rizz__proxy_alloc_header*)ptr - 1, file, func,
+                                       line);
+        return ptr;
+    }
 }
 
-static void rizz__job_thread_shutdown_cb(sx_job_context* ctx, int thread_index, uint32_t thread_id,
-                                         void* user)
+static int rizz__mem_profiler_sort_cb(const void* a, const void* b)
 {
-    sx_unused(ctx);
-    sx_unused(thread_index);
-    sx_unused(thread_id);
-    sx_unused(user);
+    int64_t sa = ((const rizz_track_alloc_item*)a)->size;
+    int64_t sb = ((const rizz_track_alloc_item*)b)->size;
+    return sa < sb ? 1 : (sa > sb ? -1 : 0);
 }
 
-static void rizz__rmt_input_handler(const char* text, void* context)
+// writes aggregated call-sites to a CSV file, sorted by size (main thread only)
+static bool rizz__dump_mem_profile(const char* filepath)
 {
-    sx_unused(context);
-
-    // parse text into argc/argv
-    int argc = 0;
-    char arg[256];
-
-    const char* cline = sx_skip_whitespace(text);
-    while (cline && *cline) {
-        for (char c = *cline; !sx_isspace(c) && *cline; c = *(++cline)) {
-        }
-        cline = sx_skip_whitespace(cline);
-        argc++;
+    if (!RIZZ_CONFIG_DEBUG_MEMORY) {
+        rizz_log_warn("memory profiler is not enabled (RIZZ_CONFIG_DEBUG_MEMORY=0)");
+        return false;
     }
-    if (argc == 0)
-        return;
 
-    const sx_alloc* tmp_alloc = the__core.tmp_alloc_push();
-    char** argv = sx_malloc(tmp_alloc, sizeof(char*) * argc);
-    sx_assert(argv);
+    rizz__mem_profiler_update();
 
-    cline = sx_skip_whitespace(text);
-    int arg_idx = 0;
-    while (cline && *cline) {
-        int char_idx = 0;
-        for (char c = *cline; !sx_isspace(c) && *cline && char_idx < (int)sizeof(arg);
-             c = *(++cline), ++char_idx) {
-            arg[char_idx] = c;
-        }
-        arg[char_idx] = '\0';
-        cline = sx_skip_whitespace(cline);
-        argv[arg_idx] = sx_malloc(tmp_alloc, (size_t)strlen(arg) + 1);
-        sx_assert(argv);
-        sx_strcpy(argv[arg_idx++], sizeof(arg), arg);
+    FILE* f = fopen(filepath, "wt");
+    if (!f) {
+        rizz_log_warn("could not open file '%s' for writing", filepath);
+        return false;
     }
 
-    for (int i = 0; i < sx_array_count(g_core.console_cmds); i++) {
-        if (sx_strequal(g_core.console_cmds[i].name, argv[0])) {
-            int r;
-            if ((r = g_core.console_cmds[i].callback(argc, argv)) < 0) {
-                char err_msg[256];
-                sx_snprintf(err_msg, sizeof(err_msg), "command '%s' failed with error: %d", argv[0],
-                            r);
-                rmt_LogText(err_msg);
-            }
+    fprintf(f, "mem_id,file,line,func,size,peak,num_allocs,total_allocs%s", EOL);
+    const sx_alloc* alloc = g_core.heap_alloc;
+    for (int i = 0; i < _RIZZ_MEMID_COUNT; i++) {
+        const rizz__track_alloc* talloc = &g_core.track_allocs[i];
+        int num_items = sx_array_count(talloc->items);
+        if (num_items == 0)
+            continue;
+
+        rizz_track_alloc_item* items = sx_malloc(alloc, sizeof(rizz_track_alloc_item) * num_items);
+        if (!items) {
+            sx_out_of_memory();
             break;
         }
+        sx_memcpy(items, talloc->items, sizeof(rizz_track_alloc_item) * num_items);
+        qsort(items, (size_t)num_items, sizeof(rizz_track_alloc_item), rizz__mem_profiler_sort_cb);
+        for (int k = 0; k < num_items; k++) {
+            const rizz_track_alloc_item* item = &items[k];
+            fprintf(f, "%s,%s,%d,%s,%" PRId64 ",%" PRId64 ",%d,%" PRId64 "%s", talloc->name,
+                    item->file, item->line, item->func, item->size, item->peak, item->num_allocs,
+                    item->total_allocs, EOL);
+        }
+        sx_free(alloc, items);
     }
 
-    the__core.tmp_alloc_pop();
+    fclose(f);
+    rizz_log_info("memory profile (sample rate: %d, dropped events: %d) written to: %s",
+                  g_core.mem_profiler.sample_rate, g_core.mem_profiler.dropped, filepath);
+    return true;
 }
 
-static const sx_alloc* rizz__alloc(rizz_mem_id id)
+static int rizz__dump_mem_profile_cmd(int argc, char* argv[])
 {
-#if RIZZ_CONFIG_DEBUG_MEMORY
-    sx_assert(id < _RIZZ_MEMID_COUNT);
-    return &g_core.track_allocs[id].alloc;
-#else
-    sx_unused(id);
-    return &g_core.heap_proxy_alloc;
-#endif
+    return rizz__dump_mem_profile(argc > 1 ? argv[1] : "mem-profile.csv") ? 0 : -1;
 }
 
-static void rizz__core_register_console_command(const char* cmd, rizz_core_cmd_cb* callback)
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// Temp allocator
+static inline bool rizz__tmpalloc_owns(const rizz__core_tmpalloc* t, const void* ptr)
 {
-    sx_assert(cmd);
-    sx_assert(cmd[0]);
-    sx_assert(callback);
-
-    rizz__core_cmd c;
-    sx_strcpy(c.name, sizeof(c.name), cmd);
-    c.callback = callback;
-    sx_array_push(rizz__alloc(RIZZ_MEMID_CORE), g_core.console_cmds, c);
+    return (const uint8_t*)ptr >= t->ptr && (const uint8_t*)ptr < t->ptr + t->reserve_sz;
 }
 
-static inline void rizz__atomic_max(sx_atomic_size* _max, intptr_t val)
+static inline size_t rizz__tmpalloc_commit_granularity(const rizz__core_tmpalloc* t)
 {
-    intptr_t cur_max = *_max;
-    while (cur_max < val && sx_atomic_cas_size(_max, val, cur_max) != cur_max) {
-        cur_max = *_max;
-    }
+    return t->guard ? sx_os_pagesz() : TMP_COMMIT_CHUNK_SIZE;
 }
 
-static void* rizz__proxy_alloc_cb(void* ptr, size_t size, uint32_t align, const char* file,
-                                  const char* func, uint32_t line, void* user_data)
+static bool rizz__tmpalloc_commit(rizz__core_tmpalloc* t, size_t end)
 {
-    sx_unused(ptr);
-
-    const sx_alloc* heap_alloc = (const sx_alloc*)user_data;
-    if (size == 0) {
-        // free
-        if (ptr) {
-            uint8_t* aligned = (uint8_t*)ptr;
-            rizz__proxy_alloc_header* header = (rizz__proxy_alloc_header*)ptr - 1;
-            ptr = aligned - header->ptr_offset;
+    if (end <= t->commit_sz)
+        return true;
 
-            sx_atomic_fetch_add_size(&g_core.heap_size, -header->size);
-            sx_atomic_decr(&g_core.heap_count);
+    size_t granularity = rizz__tmpalloc_commit_granularity(t);
+    size_t commit_sz = sx_min(sx_align_mask(end, granularity - 1), t->reserve_sz);
+    if (!sx_virtual_commit(t->ptr + t->commit_sz, commit_sz - t->commit_sz))
+        return false;
+    t->commit_sz = commit_sz;
+    return true;
+}
 
-            sx__free(heap_alloc, ptr, 0, file, func, line);
-        }
+// guard mode: commits only the pages of a single allocation (from the page of its header to
+// `end`), leaving the gap page of the previous allocation untouched
+static bool rizz__tmpalloc_commit_guarded(rizz__core_tmpalloc* t, const uint8_t* aligned,
+                                          size_t end)
+{
+    size_t page_sz = sx_os_pagesz();
+    size_t begin = (size_t)(aligned - sizeof(rizz__core_tmpalloc_hdr) - t->ptr) & ~(page_sz - 1);
+    if (!sx_virtual_commit(t->ptr + begin, end - begin))
+        return false;
+    t->commit_sz = sx_max(t->commit_sz, end);
+    return true;
+}
 
-        return NULL;
-    } else if (ptr == NULL) {
-        // malloc
-        align = sx_max((int)align, SX_CONFIG_ALLOCATOR_NATURAL_ALIGNMENT);
+static void rizz__tmpalloc_decommit(rizz__core_tmpalloc* t, size_t end)
+{
+    size_t granularity = rizz__tmpalloc_commit_granularity(t);
+    end = sx_align_mask(end, granularity - 1);
+    if (end < t->commit_sz) {
+        sx_virtual_decommit(t->ptr + end, t->commit_sz - end);
+        t->commit_sz = end;
+    }
+}
 
-        // do the alignment ourselves
-        intptr_t total = (intptr_t)size + sizeof(rizz__proxy_alloc_header) + align;
-        uint8_t* _ptr = sx__malloc(heap_alloc, total, 0, file, func, line);
-        if (!_ptr) {
-            sx_out_of_memory();
-            return NULL;
+// releases all heap (overflow) allocations, starting from index `start`
+static void rizz__tmpalloc_free_fallbacks(rizz__core_tmpalloc* t, int start)
+{
+    for (int i = start, c = sx_array_count(t->fallbacks); i < c; i++) {
+        rizz__core_tmpalloc_fallback* f = &t->fallbacks[i];
+        if (f->ptr) {
+            sx_free(&g_core.heap_proxy_alloc, f->ptr);
+            t->fallback_sz -= f->size;
         }
+    }
+    if (start < sx_array_count(t->fallbacks))
+        sx_array_pop_lastn(t->fallbacks, sx_array_count(t->fallbacks) - start);
+}
 
-        uint8_t* aligned = (uint8_t*)sx_align_ptr(_ptr, sizeof(rizz__proxy_alloc_header), align);
-        rizz__proxy_alloc_header* header = (rizz__proxy_alloc_header*)aligned - 1;
-        header->size = total;
-        header->ptr_offset = (uint32_t)(uintptr_t)(aligned - _ptr);
-        header->track_item_idx = -1;
-
-        sx_atomic_fetch_add_size(&g_core.heap_size, total);
-        rizz__atomic_max(&g_core.heap_max, g_core.heap_size);
-        sx_atomic_incr(&g_core.heap_count);
+static rizz__core_tmpalloc_fallback* rizz__tmpalloc_find_fallback(rizz__core_tmpalloc* t,
+                                                                  const void* ptr)
+{
+    for (int i = sx_array_count(t->fallbacks) - 1; i >= 0; i--) {
+        if (t->fallbacks[i].ptr == ptr)
+            return &t->fallbacks[i];
+    }
+    return NULL;
+}
 
-        return aligned;
+static void* rizz__tmpalloc_malloc(rizz__core_tmpalloc* t, size_t size, uint32_t align,
+                                   const char* file, const char* func, uint32_t line)
+{
+    align = sx_max((int)align, SX_CONFIG_ALLOCATOR_NATURAL_ALIGNMENT);
+    size_t start = t->offset;
+    size_t end;
+    size_t next_offset;
+    uint8_t* aligned;
+    bool committed;
+
+    if (!t->guard) {
+        aligned = (uint8_t*)sx_align_ptr(t->ptr + start, sizeof(rizz__core_tmpalloc_hdr), align);
+        end = (size_t)(aligned - t->ptr) + size;
+        next_offset = end;
+        committed = end <= t->reserve_sz && rizz__tmpalloc_commit(t, end);
     } else {
-        // realloc
-        uint8_t* aligned = (uint8_t*)ptr;
-        rizz__proxy_alloc_header* header = (rizz__proxy_alloc_header*)ptr - 1;
-        uint32_t offset = header->ptr_offset;
-        intptr_t prev_size = header->size;
-        ptr = aligned - offset;
-        sx_atomic_fetch_add_size(&g_core.heap_size, -header->size);
+        // place the end of the buffer on the page boundary and skip one page after it, that gap
+        // page is never committed, so writing past any buffer (not just the last one) triggers an
+        // access violation
+        size_t page_sz = sx_os_pagesz();
+        end = sx_align_mask(start + sizeof(rizz__core_tmpalloc_hdr) + align + size, page_sz - 1);
+        aligned = (uint8_t*)((uintptr_t)(t->ptr + end - size) & ~((uintptr_t)align - 1));
+        next_offset = end + page_sz;
+        committed = end <= t->reserve_sz && rizz__tmpalloc_commit_guarded(t, aligned, end);
+    }
 
-        align = sx_max((int)align, SX_CONFIG_ALLOCATOR_NATURAL_ALIGNMENT);
-        intptr_t total = (intptr_t)size + sizeof(rizz__proxy_alloc_header) + align;
-        ptr = sx__realloc(heap_alloc, ptr, total, 0, file, func, line);
+    if (!committed) {
+        // overflow: reserved range is exhausted, fallback to heap
+        void* ptr = sx__malloc(&g_core.heap_proxy_alloc, size, align, file, func, line);
         if (!ptr) {
             sx_out_of_memory();
             return NULL;
         }
-        uint8_t* new_aligned = (uint8_t*)sx_align_ptr(ptr, sizeof(rizz__proxy_alloc_header), align);
-        if (new_aligned == aligned) {
-            header->size = total;
-            return aligned;
-        }
+        rizz__core_tmpalloc_fallback f = { .ptr = ptr, .size = size };
+        sx_array_push(&g_core.heap_proxy_alloc, t->fallbacks, f);
+        t->fallback_sz += size;
+        return ptr;
+    }
 
-        aligned = (uint8_t*)ptr + offset;
-        sx_memmove(new_aligned, aligned, size);
-        header = (rizz__proxy_alloc_header*)new_aligned - 1;
-        header->size = total;
-        header->ptr_offset = (uint32_t)(uintptr_t)(new_aligned - (uint8_t*)ptr);
+    rizz__core_tmpalloc_hdr* hdr = (rizz__core_tmpalloc_hdr*)aligned - 1;
+    hdr->size = size;
+    hdr->internal_size = next_offset - start;
+    hdr->prev_offset = t->last_ptr_offset;
+    hdr->padding = (uint32_t)(uintptr_t)(aligned - (t->ptr + start));
 
-        intptr_t size_diff = total - prev_size;
-        sx_atomic_fetch_add_size(&g_core.heap_size, size_diff);
-        if (size_diff > 0)
-            rizz__atomic_max(&g_core.heap_max, g_core.heap_size);
-        return new_aligned;
-    }
+    t->offset = next_offset;
+    t->last_ptr_offset = (size_t)(aligned - t->ptr);
+    t->peak = sx_max(t->peak, end);
+    t->frame_peak = sx_max(t->frame_peak, end);
+
+    return aligned;
 }
 
-// NOTE: this special tracker alloc, always assumes that the redirecting allocator is
-// proxy-allocator
-//       Thus is assumes that all our pointers have rizz__proxy_alloc_header
-// TODO: There is a catch and a possible bug:
-//       malloc and realloc can conflict in multi-threaded environment, where it is called on the
-//       same pointer on different threads
-static void* rizz__track_alloc_cb(void* ptr, size_t size, uint32_t align, const char* file,
-                                  const char* func, uint32_t line, void* user_data)
+static void* rizz__tmpalloc_cb(void* ptr, size_t size, uint32_t align, const char* file,
+                               const char* func, uint32_t line, void* user_data)
 {
-
-    rizz__track_alloc* talloc = user_data;
-    const sx_alloc* proxy_alloc = &g_core.heap_proxy_alloc;
+    rizz__core_tmpalloc* t = (rizz__core_tmpalloc*)user_data;
+    void* last_ptr = t->ptr + t->last_ptr_offset;
 
     if (size == 0) {
-        // free
+        // free: like stack allocators, the memory is only reclaimed if it's the last allocation
         if (ptr) {
-            const rizz__proxy_alloc_header* header = (rizz__proxy_alloc_header*)ptr - 1;
-            sx_lock(&talloc->_lk, 1);
-            sx_assert(header->track_item_idx >= 0 &&
-                      header->track_item_idx < sx_array_count(talloc->items));
-            talloc->size -= header->size;
-            rizz_track_alloc_item* mem_item = &talloc->items[header->track_item_idx];
-            sx_assert(mem_item->ptr == ptr && "memory corruption");
-            mem_item->ptr = NULL;    // invalidate memory item pointer
-
-            if (header->track_item_idx != sx_array_count(talloc->items) - 1) {
-                void* last_ptr = sx_array_last(talloc->items).ptr;
-                sx_assert(last_ptr);
-                rizz__proxy_alloc_header* last_header = (rizz__proxy_alloc_header*)last_ptr - 1;
-                last_header->track_item_idx = header->track_item_idx;
-                sx_array_pop(talloc->items, header->track_item_idx);
-            } else {
-                sx_array_pop_last(talloc->items);
+            if (ptr == last_ptr) {
+                rizz__core_tmpalloc_hdr* hdr = (rizz__core_tmpalloc_hdr*)ptr - 1;
+                sx_assert(t->offset >= hdr->internal_size);
+                t->offset -= hdr->internal_size;
+                t->last_ptr_offset = hdr->prev_offset;
+                if (t->guard)
+                    rizz__tmpalloc_decommit(t, t->offset);
+            } else if (!rizz__tmpalloc_owns(t, ptr)) {
+                rizz__core_tmpalloc_fallback* f = rizz__tmpalloc_find_fallback(t, ptr);
+                sx_assert(f && "pointer is not allocated by temp allocator");
+                if (f) {
+                    sx_free(&g_core.heap_proxy_alloc, f->ptr);
+                    t->fallback_sz -= f->size;
+                    f->ptr = NULL;
+                }
             }
-            sx_unlock(&talloc->_lk);
-            sx__free(proxy_alloc, ptr, align, file, func, line);
         }
-
         return NULL;
     } else if (ptr == NULL) {
         // malloc
-        ptr = sx__malloc(proxy_alloc, size, align, file, func, line);
-        sx_assert(ptr);
-        rizz__proxy_alloc_header* header = (rizz__proxy_alloc_header*)ptr - 1;
-        rizz_track_alloc_item mem_item = { .ptr = ptr, .line = line, .size = header->size };
-        sx_os_path_basename(mem_item.file, sizeof(mem_item.file), file);
-        sx_strcpy(mem_item.func, sizeof(mem_item.func), func);
-
-        sx_lock(&talloc->_lk, 1);
-        talloc->size += header->size;
-        talloc->peak = sx_max(talloc->peak, talloc->size);
-        header->track_item_idx = sx_array_count(talloc->items);
-        sx_array_push(g_core.heap_alloc, talloc->items, mem_item);
-        sx_unlock(&talloc->_lk);
+        return rizz__tmpalloc_malloc(t, size, align, file, func, line);
+    } else if (!rizz__tmpalloc_owns(t, ptr)) {
+        // realloc: heap fallback
+        rizz__core_tmpalloc_fallback* f = rizz__tmpalloc_find_fallback(t, ptr);
+        sx_assert(f && "pointer is not allocated by temp allocator");
+        if (!f)
+            return NULL;
+        void* new_ptr = sx__realloc(&g_core.heap_proxy_alloc, ptr, size, align, file, func, line);
+        if (!new_ptr) {
+            sx_out_of_memory();
+            return NULL;
+        }
+        t->fallback_sz += size - f->size;
+        f->ptr = new_ptr;
+        f->size = size;
+        return new_ptr;
+    } else if (ptr == last_ptr && !t->guard) {
+        // realloc: the memory is continous so we can just grow the buffer without any new
+        // allocations
+        rizz__core_tmpalloc_hdr* hdr = (rizz__core_tmpalloc_hdr*)ptr - 1;
+        size_t start = t->offset - hdr->internal_size;
+        size_t end = t->last_ptr_offset + size;
+        if (end <= t->reserve_sz && rizz__tmpalloc_commit(t, end)) {
+            hdr->size = size;
+            hdr->internal_size = end - start;
+            t->offset = end;
+            t->peak = sx_max(t->peak, end);
+            t->frame_peak = sx_max(t->frame_peak, end);
+            return ptr;
+        }
+    }
 
-        return ptr;
-    } else {
-        // realloc
-        const rizz__proxy_alloc_header* prev_header = (rizz__proxy_alloc_header*)ptr - 1;
-        int64_t prev_size = prev_header->size;
+    // realloc: generic, create new allocation and copy the previous data into the beginning
+    size_t prev_size = ((rizz__core_tmpalloc_hdr*)ptr - 1)->size;
+    void* new_ptr = rizz__tmpalloc_malloc(t, size, align, file, func, line);
+    if (new_ptr)
+        sx_memcpy(new_ptr, ptr, sx_min(size, prev_size));
+    return new_ptr;
+}
 
-        ptr = sx__realloc(proxy_alloc, ptr, size, align, file, func, line);
-        sx_assert(ptr);
-        const rizz__proxy_alloc_header* header = (rizz__proxy_alloc_header*)ptr - 1;
-
-        sx_lock(&talloc->_lk, 1);
-        sx_assert(header->track_item_idx >= 0 &&
-                  header->track_item_idx < sx_array_count(talloc->items));
-        int64_t size_diff = header->size - prev_size;
-        talloc->size += size_diff;
-        if (size_diff > 0)
-            talloc->peak = sx_max(talloc->peak, talloc->size);
-        rizz_track_alloc_item* mem_item = &talloc->items[header->track_item_idx];
-        sx_os_path_basename(mem_item->file, sizeof(mem_item->file), file);
-        sx_strcpy(mem_item->func, sizeof(mem_item->func), func);
-        mem_item->ptr = ptr;
-        mem_item->line = line;
-        mem_item->size = header->size;
-        sx_unlock(&talloc->_lk);
+static bool rizz__tmpalloc_init(rizz__core_tmpalloc* t, size_t reserve_sz, bool guard)
+{
+    sx_memset(t, 0x0, sizeof(*t));
 
-        return ptr;
+    // reserve an extra page at the end of the range that is never committed, so overflows trap
+    size_t page_sz = sx_os_pagesz();
+    t->ptr = (uint8_t*)sx_virtual_reserve(reserve_sz + page_sz);
+    if (!t->ptr)
+        return false;
+
+    t->alloc = (sx_alloc){ .alloc_cb = rizz__tmpalloc_cb, .user_data = t };
+    t->reserve_sz = reserve_sz;
+    t->guard = guard;
+    return true;
+}
+
+static void rizz__tmpalloc_release(rizz__core_tmpalloc* t, const sx_alloc* alloc)
+{
+    rizz__tmpalloc_free_fallbacks(t, 0);
+    sx_array_free(&g_core.heap_proxy_alloc, t->fallbacks);
+    sx_array_free(alloc, t->marks);
+    if (t->ptr)
+        sx_virtual_release(t->ptr, t->reserve_sz + sx_os_pagesz());
+}
+
+// called at the beginning of each frame: trim the committed memory to the frame's high-water mark
+static void rizz__tmpalloc_reset(rizz__core_tmpalloc* t)
+{
+    rizz__tmpalloc_free_fallbacks(t, 0);
+
+    if (t->guard) {
+        rizz__tmpalloc_decommit(t, 0);
+    } else {
+        // high-water mark of the last two frames, and only decommit if we are using less than
+        // half of the committed memory, so we won't commit/decommit on every frame
+        size_t keep =
+            sx_align_mask(sx_max(t->frame_peak, t->last_frame_peak), TMP_COMMIT_CHUNK_SIZE - 1);
+        if (t->commit_sz > keep * 2)
+            rizz__tmpalloc_decommit(t, keep);
     }
+
+    t->offset = 0;
+    t->last_ptr_offset = 0;
+    t->last_frame_peak = t->frame_peak;
+    t->frame_peak = 0;
 }
 
 bool rizz__core_init(const rizz_config* conf)
@@ -727,11 +1982,34 @@ bool rizz__core_init(const rizz_config* conf)
     g_core.heap_alloc = sx_alloc_malloc();
 #endif
 
+    // thread-caching tlsf heap for selected mem-ids, the rest go to libc heap
+    if (conf->heap_tlsf_mask) {
+        g_core.heap_tlsf.thread_tls = sx_tls_create();
+        if (!g_core.heap_tlsf.thread_tls) {
+            sx_out_of_memory();
+            return false;
+        }
+        g_core.heap_tlsf.alloc =
+            (sx_alloc){ .alloc_cb = rizz__proxy_alloc_cb, .user_data = &g_core.heap_tlsf };
+    }
+
     if (RIZZ_CONFIG_DEBUG_MEMORY) {
-        g_core.heap_proxy_alloc =
-            (sx_alloc){ .alloc_cb = rizz__proxy_alloc_cb, .user_data = (void*)g_core.heap_alloc };
+        g_core.heap_proxy_alloc = (sx_alloc){ .alloc_cb = rizz__proxy_alloc_cb };
+
+        // initialize memory profiler and track allocators
+        rizz__mem_profiler* prof = &g_core.mem_profiler;
+        prof->thread_tls = sx_tls_create();
+        prof->callsites = sx_malloc(g_core.heap_alloc,
+                                    sizeof(rizz__mem_callsite) * MEM_PROFILER_MAX_CALLSITES);
+        if (!prof->thread_tls || !prof->callsites) {
+            sx_out_of_memory();
+            return false;
+        }
+        sx_memset(prof->callsites, 0x0, sizeof(rizz__mem_callsite) * MEM_PROFILER_MAX_CALLSITES);
+        for (int i = 0; i < MEM_PROFILER_MAX_CALLSITES; i++)
+            prof->callsites[i].item = -1;
+        prof->sample_rate = sx_max(1, conf->mem_sample_rate);    // enables the profiler
 
-        // initialize track allocators
         for (int i = 0; i < _RIZZ_MEMID_COUNT; i++) {
             g_core.track_allocs[i] =
                 (rizz__track_alloc){ .alloc = { .alloc_cb = rizz__track_alloc_cb,
@@ -743,26 +2021,39 @@ bool rizz__core_init(const rizz_config* conf)
         g_core.heap_proxy_alloc = *g_core.heap_alloc;
     }
 
+    for (int i = 0; i < _RIZZ_MEMID_COUNT; i++) {
+        g_core.mem_heaps[i] = (conf->heap_tlsf_mask & (1u << i)) ? &g_core.heap_tlsf.alloc
+                                                                   : &g_core.heap_proxy_alloc;
+        g_core.track_allocs[i].heap = g_core.mem_heaps[i];
+    }
+
     const sx_alloc* alloc = rizz__alloc(RIZZ_MEMID_CORE);
     sx_strcpy(g_core.app_name, sizeof(g_core.app_name), conf->app_name);
     g_core.app_ver = conf->app_version;
     g_core.flags = conf->core_flags;
+    g_core.headless = (conf->app_flags & RIZZ_APP_FLAG_HEADLESS) ? true : false;
 
 #if SX_PLATFORM_ANDROID || SX_PLATFORM_IOS
     // remove log to file flag on mobile
     g_core.flags &= ~RIZZ_CORE_FLAG_LOG_TO_FILE;
 #endif
 
+    sx_tm_init();
+    g_core.log.start_tick = sx_tm_now();
+
     if (g_core.flags & RIZZ_CORE_FLAG_LOG_TO_FILE) {
         sx_strcpy(g_core.logfile, sizeof(g_core.logfile), conf->app_name);
         sx_strcat(g_core.logfile, sizeof(g_core.logfile), ".log");
         rizz__init_log(g_core.logfile);
     }
 
-    sx_tm_init();
-    sx_rng_seed(&g_core.rng, sizeof(time_t) == sizeof(uint64_t)
-                                 ? sx_hash_u64_to_u32((uint64_t)time(NULL))
-                                 : (uint32_t)time(NULL));
+    // logs are written synchronously if the logger thread can't be created
+    if (!rizz__log_init()) {
+        rizz_log_warn("initializing logger thread failed");
+    }
+    rizz__core_set_rng_seed(sizeof(time_t) == sizeof(uint64_t)
+                                ? sx_hash_u64_to_u32((uint64_t)time(NULL))
+                                : (uint32_t)time(NULL));
 
     // disk-io (virtual file system)
     if (!rizz__vfs_init(rizz__alloc(RIZZ_MEMID_VFS))) {
@@ -783,24 +2074,25 @@ bool rizz__core_init(const rizz_config* conf)
         sx_out_of_memory();
         return false;
     }
-    int tmp_size = (int)sx_align_mask(
-        conf->tmp_mem_max > 0 ? conf->tmp_mem_max * 1024 : DEFAULT_TMP_SIZE, sx_os_pagesz() - 1);
+    sx_memset(g_core.tmp_allocs, 0x0, sizeof(rizz__core_tmpalloc) * g_core.num_workers);
+    // reserved size should fit into `rizz_linalloc_info` fields
+    int64_t tmp_size = conf->tmp_mem_max > 0 ? (int64_t)conf->tmp_mem_max * 1024 : DEFAULT_TMP_SIZE;
+    tmp_size = sx_align_mask(sx_min(tmp_size, (int64_t)INT32_MAX - TMP_COMMIT_CHUNK_SIZE),
+                             TMP_COMMIT_CHUNK_SIZE - 1);
+    bool tmp_guard = (conf->core_flags & RIZZ_CORE_FLAG_TEMP_GUARD_PAGES) ? true : false;
 
     g_core.tmp_allocs_tls = sx_tls_create();
     sx_assert(g_core.tmp_allocs_tls);
 
     for (int i = 0; i < g_core.num_workers; i++) {
-        rizz__core_tmpalloc* t = &g_core.tmp_allocs[i];
-        void* mem = sx_virtual_commit(sx_virtual_reserve(tmp_size), tmp_size);
-        if (!mem) {
+        if (!rizz__tmpalloc_init(&g_core.tmp_allocs[i], (size_t)tmp_size, tmp_guard)) {
             sx_out_of_memory();
             return false;
         }
-        sx_stackalloc_init(&t->stack_alloc, mem, tmp_size);
-        t->offset_stack = NULL;
     }
     sx_tls_set(g_core.tmp_allocs_tls, &g_core.tmp_allocs[0]);
-    rizz_log_info("(init) temp memory: %dx%d kb", g_core.num_workers, tmp_size / 1024);
+    rizz_log_info("(init) temp memory: %dx%d kb (reserved)%s", g_core.num_workers,
+                  (int)(tmp_size / 1024), tmp_guard ? ", guard-pages" : "");
 
     // reflection
     if (!rizz__refl_init(rizz__alloc(RIZZ_MEMID_REFLECT), 0)) {
@@ -848,6 +2140,15 @@ bool rizz__core_init(const rizz_config* conf)
     }
 
     // graphics
+    if (g_core.headless) {
+#if RIZZ_CONFIG_HEADLESS
+        // the api is copied, so plugins that fetch the api, end up in the dummy backend
+        the__gfx = the__gfx_headless;
+#else
+        rizz_log_error("headless mode is not supported on this platform");
+        return false;
+#endif
+    }
     sg_desc gfx_desc;
     rizz__app_init_gfx_desc(&gfx_desc);    // fill initial bindings for graphics/app
     // TODO:
@@ -859,8 +2160,8 @@ bool rizz__core_init(const rizz_config* conf)
     // .pipeline_pool_size:    64
     // .pass_pool_size:        16
     // .context_pool_size:     16
-    if (!rizz__gfx_init(rizz__alloc(RIZZ_MEMID_GRAPHICS), &gfx_desc,
-                        (conf->core_flags & RIZZ_CORE_FLAG_PROFILE_GPU) ? true : false)) {
+    bool profile_gpu = (conf->core_flags & RIZZ_CORE_FLAG_PROFILE_GPU) && !g_core.headless;
+    if (!rizz__gfx_fn(init)(rizz__alloc(RIZZ_MEMID_GRAPHICS), &gfx_desc, profile_gpu)) {
         rizz_log_error("initializing graphics failed");
         return false;
     }
@@ -875,19 +2176,47 @@ bool rizz__core_init(const rizz_config* conf)
     }
     for (int i = 0; i < g_core.num_workers; i++) {
         g_core.gfx_cmdbuffers[i] =
-            rizz__gfx_create_command_buffer(rizz__alloc(RIZZ_MEMID_GRAPHICS));
+            rizz__gfx_fn(create_command_buffer)(rizz__alloc(RIZZ_MEMID_GRAPHICS));
         sx_assert(g_core.gfx_cmdbuffers[i]);
     }
     sx_tls_set(g_core.cmdbuffer_tls, g_core.gfx_cmdbuffers[0]);
     rizz_log_info("(init) graphics: %s", k__gfx_driver_names[the__gfx.backend()]);
 
+    // fiber stacks for jobs and coroutines, smaller stack size goes to the small class
+    {
+        int job_stack_sz = conf->job_stack_size * 1024;
+        int coro_stack_sz = conf->coro_stack_size * 1024;
+        sx_fiber_stack_pool_desc desc;
+        if (job_stack_sz == coro_stack_sz) {
+            desc = (sx_fiber_stack_pool_desc){ .small_stack_sz = job_stack_sz,
+                                               .max_small =
+                                                   conf->job_max_fibers + conf->coro_max_fibers };
+        } else if (job_stack_sz < coro_stack_sz) {
+            desc = (sx_fiber_stack_pool_desc){ .small_stack_sz = job_stack_sz,
+                                               .max_small = conf->job_max_fibers,
+                                               .large_stack_sz = coro_stack_sz,
+                                               .max_large = conf->coro_max_fibers };
+        } else {
+            desc = (sx_fiber_stack_pool_desc){ .small_stack_sz = coro_stack_sz,
+                                               .max_small = conf->coro_max_fibers,
+                                               .large_stack_sz = job_stack_sz,
+                                               .max_large = conf->job_max_fibers };
+        }
+        g_core.fiber_stacks = sx_fiber_stack_pool_create(alloc, &desc);
+        if (!g_core.fiber_stacks) {
+            rizz_log_error("initializing fiber stacks failed");
+            return false;
+        }
+    }
+
     // job dispatcher
     g_core.jobs = sx_job_create_context(
         alloc, &(sx_job_context_desc){ .num_threads = num_worker_threads,
                                        .max_fibers = conf->job_max_fibers,
                                        .fiber_stack_sz = conf->job_stack_size * 1024,
                                        .thread_init_cb = rizz__job_thread_init_cb,
-                                       .thread_shutdown_cb = rizz__job_thread_shutdown_cb });
+                                       .thread_shutdown_cb = rizz__job_thread_shutdown_cb,
+                                       .stack_pool = g_core.fiber_stacks });
     if (!g_core.jobs) {
         rizz_log_error("initializing job dispatcher failed");
         return false;
@@ -897,8 +2226,8 @@ bool rizz__core_init(const rizz_config* conf)
                   conf->job_stack_size);
 
     // coroutines
-    g_core.coro =
-        sx_coro_create_context(alloc, conf->coro_max_fibers, conf->coro_stack_size * 1024);
+    g_core.coro = sx_coro_create_context_with_pool(
+        alloc, conf->coro_max_fibers, conf->coro_stack_size * 1024, g_core.fiber_stacks);
     if (!g_core.coro) {
         rizz_log_error("initializing coroutines failed");
         return false;
@@ -919,10 +2248,14 @@ bool rizz__core_init(const rizz_config* conf)
         return false;
     }
 
+    if (RIZZ_CONFIG_DEBUG_MEMORY)
+        rizz__core_register_console_command("mem_dump", rizz__dump_mem_profile_cmd);
+
     // initialize cache-dir and load asset database
+    if (!sx_os_path_isdir(conf->cache_path))
+        sx_os_mkdir(conf->cache_path);
     the__vfs.mount(conf->cache_path, "/cache");
-    if (!the__vfs.is_dir(conf->cache_path))
-        the__vfs.mkdir(conf->cache_path);
+    rizz__set_cache_dir(conf->cache_path);
 
     return true;
 }
@@ -961,9 +2294,12 @@ void rizz__core_release()
     if (g_core.coro)
         sx_coro_destroy_context(g_core.coro, alloc);
 
+    if (g_core.fiber_stacks)
+        sx_fiber_stack_pool_destroy(g_core.fiber_stacks, alloc);
+
     // destroy gfx command-buffers (per-thread)
     for (int i = 0; i < g_core.num_workers; i++) {
-        rizz__gfx_destroy_command_buffer(g_core.gfx_cmdbuffers[i]);
+        rizz__gfx_fn(destroy_command_buffer)(g_core.gfx_cmdbuffers[i]);
     }
     sx_free(alloc, g_core.gfx_cmdbuffers);
 
@@ -977,21 +2313,21 @@ void rizz__core_release()
     // Release native subsystems
     rizz__http_release();
     rizz__asset_release();
-    rizz__gfx_release();
+    rizz__gfx_fn(release)();
     rizz__vfs_release();
     rizz__refl_release();
 
+    // stop the logger thread before the profiler, logs are written synchronously from now on
+    rizz__log_release();
     if (g_core.rmt) {
         rmt_DestroyGlobalInstance(g_core.rmt);
+        g_core.flags &= ~RIZZ_CORE_FLAG_LOG_TO_PROFILER;
     }
     sx_array_free(alloc, g_core.console_cmds);
 
     if (g_core.tmp_allocs) {
         for (int i = 0; i < g_core.num_workers; i++) {
-            void* mem = g_core.tmp_allocs[i].stack_alloc.ptr;
-            if (mem)
-                sx_virtual_release(mem, g_core.tmp_allocs[i].stack_alloc.size);
-            sx_array_free(alloc, g_core.tmp_allocs[i].offset_stack);
+            rizz__tmpalloc_release(&g_core.tmp_allocs[i], alloc);
         }
         sx_free(alloc, g_core.tmp_allocs);
     }
@@ -1002,9 +2338,21 @@ void rizz__core_release()
         sx_tls_destroy(g_core.cmdbuffer_tls);
 
     if (RIZZ_CONFIG_DEBUG_MEMORY) {
+        rizz__mem_profiler* prof = &g_core.mem_profiler;
+        prof->sample_rate = 0;
         for (int i = 0; i < _RIZZ_MEMID_COUNT; i++) {
             sx_array_free(g_core.heap_alloc, g_core.track_allocs[i].items);
         }
+
+        rizz__mem_thread* mt = (rizz__mem_thread*)prof->threads;
+        while (mt) {
+            rizz__mem_thread* next = mt->next;
+            sx_free(g_core.heap_alloc, mt);
+            mt = next;
+        }
+        sx_free(g_core.heap_alloc, prof->callsites);
+        if (prof->thread_tls)
+            sx_tls_destroy(prof->thread_tls);
     }
 
     for (int i = 0; i < sx_array_count(g_core.tls_vars); i++) {
@@ -1014,7 +2362,19 @@ void rizz__core_release()
     }
     sx_array_free(&g_core.heap_proxy_alloc, g_core.tls_vars);
 
+    // thread heaps: any block that is still alive at this point is a leak and is released too
+    rizz__heap_thread* ht = (rizz__heap_thread*)g_core.heap_tlsf.threads;
+    while (ht) {
+        rizz__heap_thread* next = ht->next;
+        rizz__heap_thread_destroy(ht);
+        ht = next;
+    }
+    if (g_core.heap_tlsf.thread_tls)
+        sx_tls_destroy(g_core.heap_tlsf.thread_tls);
+
     rizz_log_info("shutdown");
+    if (g_core.log.file)
+        fclose(g_core.log.file);
 
 #ifdef _DEBUG
     sx_dump_leaks(rizz__core_dump_leak);
@@ -1022,13 +2382,36 @@ void rizz__core_release()
     sx_memset(&g_core, 0x0, sizeof(g_core));
 }
 
+static void rizz__coro_job_cb(int start, int end, int thrd_index, void* user)
+{
+    sx_unused(thrd_index);
+    for (int i = start; i < end; i++) {
+        sx_coro_resume((sx_coro_context*)user, i);
+    }
+}
+
+void rizz__core_set_rng_seed(uint32_t seed)
+{
+    g_core.rng_seed = seed;
+    sx_rng_seed(&g_core.rng, seed);
+}
+
+uint32_t rizz__core_rng_seed()
+{
+    return g_core.rng_seed;
+}
+
 void rizz__core_frame()
+{
+    rizz__core_frame_with_delta(sx_tm_laptime(&g_core.last_tick));
+}
+
+void rizz__core_frame_with_delta(uint64_t delta_tick)
 {
     // Measure timing and fps
-    g_core.delta_tick = sx_tm_laptime(&g_core.last_tick);
-    g_core.elapsed_tick += g_core.delta_tick;
+    g_core.delta_tick = delta_tick;
+    g_core.elapsed_tick += delta_tick;
 
-    uint64_t delta_tick = g_core.delta_tick;
     float dt = (float)sx_tm_sec(delta_tick);
 
     if (delta_tick > 0) {
@@ -1043,30 +2426,51 @@ void rizz__core_frame()
     // submit render commands to the gpu
     // currently, we are submitting the calls from the previous frame
     // because submitting commands
-    rizz__gfx_trace_reset_frame_stats();
+    rizz__gfx_fn(trace_reset_frame_stats)();
 
     // reset temp allocators
     for (int i = 0, c = g_core.num_workers; i < c; i++) {
-        sx_stackalloc_reset(&g_core.tmp_allocs[i].stack_alloc);
+        rizz__tmpalloc_reset(&g_core.tmp_allocs[i]);
     }
 
+    if (RIZZ_CONFIG_DEBUG_MEMORY)
+        rizz__mem_profiler_update();
+
     // update internal sub-systems
     rizz__http_update();
     rizz__vfs_async_update();
     rizz__asset_update();
-    rizz__gfx_update();
-    sx_coro_update(g_core.coro, dt);
+    rizz__gfx_fn(update)();
+    if (g_core.flags & RIZZ_CORE_FLAG_CORO_JOBS) {
+        // due coroutines are resumed on job threads, main-thread ones after the jobs are done
+        int num_due = sx_coro_update_begin(g_core.coro, dt);
+        if (num_due > 0) {
+            sx_job_t job = sx_job_dispatch(g_core.jobs, num_due, rizz__coro_job_cb, g_core.coro,
+                                           SX_JOB_PRIORITY_HIGH, 0);
+            sx_job_wait_and_del(g_core.jobs, job);
+        }
+        sx_coro_update_end(g_core.coro);
+    } else {
+        sx_coro_update(g_core.coro, dt);
+    }
+
+    // jobs and coroutines share the stack pool, so it's trimmed here instead of their contexts
+    if (sx_tm_sec(g_core.elapsed_tick - g_core.fiber_stacks_trim_tick) >=
+        FIBER_STACKS_TRIM_INTERVAL) {
+        sx_fiber_stack_pool_trim(g_core.fiber_stacks, FIBER_STACKS_KEEP_WARM);
+        g_core.fiber_stacks_trim_tick = g_core.elapsed_tick;
+    }
 
     // update plugins and application
     rizz__plugin_update(dt);
 
-    rizz__gfx_execute_command_buffers();    // TEMP
+    rizz__gfx_fn(execute_command_buffers)();    // TEMP
     the_imgui = the__plugin.get_api_byname("imgui", 0);
     if (the_imgui) {
         the_imgui->Render();
     }
 
-    rizz__gfx_commit();
+    rizz__gfx_fn(commit)();
 
     ++g_core.frame_idx;
 }
@@ -1074,18 +2478,23 @@ void rizz__core_frame()
 static const sx_alloc* rizz__core_tmp_alloc_push()
 {
     rizz__core_tmpalloc* talloc = sx_tls_get(g_core.tmp_allocs_tls);
-    sx_array_push(rizz__alloc(RIZZ_MEMID_CORE), talloc->offset_stack, talloc->stack_alloc.offset);
-    return &talloc->stack_alloc.alloc;
+    rizz__core_tmpalloc_mark mark = { .offset = talloc->offset,
+                                      .num_fallbacks = sx_array_count(talloc->fallbacks) };
+    sx_array_push(rizz__alloc(RIZZ_MEMID_CORE), talloc->marks, mark);
+    return &talloc->alloc;
 }
 
 static void rizz__core_tmp_alloc_pop()
 {
     rizz__core_tmpalloc* talloc = sx_tls_get(g_core.tmp_allocs_tls);
-    if (sx_array_count(talloc->offset_stack)) {
-        int last_offset = sx_array_last(talloc->offset_stack);
-        sx_array_pop_last(talloc->offset_stack);
-        talloc->stack_alloc.offset = last_offset;
-        talloc->stack_alloc.last_ptr_offset = 0;
+    if (sx_array_count(talloc->marks)) {
+        rizz__core_tmpalloc_mark mark = sx_array_last(talloc->marks);
+        sx_array_pop_last(talloc->marks);
+        rizz__tmpalloc_free_fallbacks(talloc, mark.num_fallbacks);
+        talloc->offset = mark.offset;
+        talloc->last_ptr_offset = 0;
+        if (talloc->guard)
+            rizz__tmpalloc_decommit(talloc, talloc->offset);
     }
 }
 
@@ -1094,6 +2503,11 @@ rizz_gfx_cmdbuffer* rizz__core_gfx_cmdbuffer()
     return (rizz_gfx_cmdbuffer*)sx_tls_get(g_core.cmdbuffer_tls);
 }
 
+void rizz__core_thread_exit()
+{
+    rizz__heap_thread_exit();
+}
+
 static uint32_t rizz__rand()
 {
     return sx_rng_gen(&g_core.rng);
@@ -1149,6 +2563,9 @@ static void rizz__end_profile_sample()
 
 static void rizz__get_mem_info(rizz_mem_info* info)
 {
+    if (RIZZ_CONFIG_DEBUG_MEMORY)
+        rizz__mem_profiler_update();
+
     for (int i = 0; i < _RIZZ_MEMID_COUNT; i++) {
         rizz__track_alloc* t = &g_core.track_allocs[i];
         info->trackers[i] = (rizz_trackalloc_info){ .name = t->name,
@@ -1160,17 +2577,23 @@ static void rizz__get_mem_info(rizz_mem_info* info)
     }
 
     int num_temp_allocs = sx_min(g_core.num_workers, RIZZ_MAX_TEMP_ALLOCS);
-    for (int i = 0; i < g_core.num_workers && i < num_temp_allocs; i++) {
-        info->temp_allocs[i] =
-            (rizz_linalloc_info){ .offset = g_core.tmp_allocs[i].stack_alloc.offset,
-                                  .size = g_core.tmp_allocs[i].stack_alloc.size,
-                                  .peak = g_core.tmp_allocs[i].stack_alloc.peak };
+    for (int i = 0; i < num_temp_allocs; i++) {
+        const rizz__core_tmpalloc* t = &g_core.tmp_allocs[i];
+        info->temp_allocs[i] = (rizz_linalloc_info){ .offset = (int)t->offset,
+                                                     .size = (int)t->reserve_sz,
+                                                     .peak = (int)t->peak,
+                                                     .frame_peak = (int)t->last_frame_peak,
+                                                     .committed = (int)t->commit_sz,
+                                                     .fallback = (int)t->fallback_sz };
     }
 
-    info->num_temp_allocs = g_core.num_workers;
+    info->num_temp_allocs = num_temp_allocs;
     info->heap = g_core.heap_size;
     info->heap_max = g_core.heap_max;
     info->heap_count = g_core.heap_count;
+    info->track_sample_rate = g_core.mem_profiler.sample_rate;
+    info->track_dropped_events = g_core.mem_profiler.dropped;
+    sx_fiber_stack_pool_get_info(g_core.fiber_stacks, &info->fiber_stacks);
 }
 
 static void rizz__coro_invoke(void (*coro_cb)(sx_fiber_transfer), void* user)
@@ -1178,6 +2601,20 @@ static void rizz__coro_invoke(void (*coro_cb)(sx_fiber_transfer), void* user)
     sx__coro_invoke(g_core.coro, coro_cb, user);
 }
 
+static void rizz__coro_invoke_with_flags(void (*coro_cb)(sx_fiber_transfer), void* user,
+                                         uint32_t flags)
+{
+    sx__coro_invoke_with_flags(g_core.coro, coro_cb, user, flags);
+}
+
+static void rizz__coro_wait_job(void* pfrom, sx_job_t job)
+{
+    sx__coro_wait_counter(g_core.coro, pfrom, job);
+    bool done = sx_job_test_and_del(g_core.jobs, job);
+    sx_assert(done);
+    sx_unused(done);
+}
+
 static void rizz__coro_end(void* pfrom)
 {
     sx__coro_end(g_core.coro, pfrom);
@@ -1249,8 +2686,10 @@ rizz_api_core the__core = { .heap_alloc = rizz__heap_alloc,
                             .tmp_alloc_pop = rizz__core_tmp_alloc_pop,
                             .tls_register = rizz__core_tls_register,
                             .tls_var = rizz__core_tls_var,
+                            .thread_exit = rizz__core_thread_exit,
                             .alloc = rizz__alloc,
                             .get_mem_info = rizz__get_mem_info,
+                            .dump_mem_profile = rizz__dump_mem_profile,
                             .rand = rizz__rand,
                             .randf = rizz__randf,
                             .rand_range = rizz__rand_range,
@@ -1270,6 +2709,8 @@ rizz_api_core the__core = { .heap_alloc = rizz__heap_alloc,
                             .coro_end = rizz__coro_end,
                             .coro_wait = rizz__coro_wait,
                             .coro_yield = rizz__coro_yield,
+                            .coro_invoke_with_flags = rizz__coro_invoke_with_flags,
+                            .coro_wait_job = rizz__coro_wait_job,
                             .print_info = rizz__print_info,
                             .print_debug = rizz__print_debug,
                             .print_verbose = rizz__print_verbose,
@@ -0,0 +1,40 @@
+//
+// Copyright 2019 Sepehr Taghdisian (septag@github). All rights reserved.
+// License: https://github.com/septag/rizz#license-bsd-2-clause
+//
+// graphics.c is built a second time with sokol's dummy backend, so the same executable can run
+// without a window or a gpu device (--headless). all exported symbols get `_headless` suffix and
+// core chooses between the two modules on init
+#include "config.h"
+
+#if RIZZ_CONFIG_HEADLESS
+#    include "rizz/types.h"
+
+#    undef RIZZ_GRAPHICS_API_D3D
+#    undef RIZZ_GRAPHICS_API_METAL
+#    undef RIZZ_GRAPHICS_API_GL
+#    undef RIZZ_GRAPHICS_API_GLES
+#    undef RIZZ_GRAPHICS_API_DUMMY
+#    define RIZZ_GRAPHICS_API_D3D 0
+#    define RIZZ_GRAPHICS_API_METAL 0
+#    define RIZZ_GRAPHICS_API_GL 0
+#    define RIZZ_GRAPHICS_API_GLES 0
+#    define RIZZ_GRAPHICS_API_DUMMY 1
+
+// clang-format off
+#    define rizz__gfx_init                      rizz__gfx_headless_init
+#    define rizz__gfx_release                   rizz__gfx_headless_release
+#    define rizz__gfx_trace_reset_frame_stats   rizz__gfx_headless_trace_reset_frame_stats
+#    define rizz__gfx_create_command_buffer     rizz__gfx_headless_create_command_buffer
+#    define rizz__gfx_destroy_command_buffer    rizz__gfx_headless_destroy_command_buffer
+#    define rizz__gfx_execute_command_buffers   rizz__gfx_headless_execute_command_buffers
+#    define rizz__gfx_update                    rizz__gfx_headless_update
+#    define rizz__gfx_commit                    rizz__gfx_headless_commit
+#    define the__gfx                            the__gfx_headless
+// also renames the sort functions, which are generated with SORT_NAME=rizz__gfx
+#    define rizz__gfx                           rizz__gfx_headless
+#    define rizz__gfx_tim_sort                  rizz__gfx_headless_tim_sort
+// clang-format on
+
+#    include "graphics.c"
+#endif    // RIZZ_CONFIG_HEADLESS
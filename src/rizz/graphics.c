@@ -43,7 +43,11 @@
 static const sx_alloc*      g_gfx_alloc = NULL;
 
 // Choose api based on the platform
-#if RIZZ_GRAPHICS_API_D3D==11
+#if RIZZ_GRAPHICS_API_DUMMY==1
+#   define SOKOL_DUMMY_BACKEND
+#   define rmt__begin_gpu_sample(_name, _hash)
+#   define rmt__end_gpu_sample()
+#elif RIZZ_GRAPHICS_API_D3D==11
 #   define SOKOL_D3D11
 #   define rmt__begin_gpu_sample(_name, _hash)  \
     (g_gfx.enable_profile ? RMT_OPTIONAL(RMT_USE_D3D11, _rmt_BeginD3D11Sample(_name, _hash)) : 0)
@@ -145,6 +149,8 @@ typedef struct rizz__gfx_texture_mgr {
     rizz_texture white_tex;
     rizz_texture black_tex;
     rizz_texture checker_tex;
+    uint16_t srgb_to_linear[256];      // LUTs for sRGB-correct mip generation
+    uint8_t linear_to_srgb[1 << 14];
 } rizz__gfx_texture_mgr;
 
 typedef enum rizz__gfx_command {
@@ -250,12 +256,33 @@ typedef struct rizz__gfx_debug {
     sx_mat4 vp;
 } rizz__gfx_debug;
 
-#ifdef SOKOL_METAL
-typedef struct rizz__pip_mtl {
+// pipelines and shaders are deduplicated by their descriptor contents, so identical make calls
+// return the same (ref-counted) object. entries are indexed by sokol's pool slot index
+// objects that failed to create and shaders created with `init_shader` (shader assets, which
+// are swapped on hot-reload) are tracked, but never shared
+typedef struct rizz__pip_cache_entry {
     sg_pipeline pip;
-    sg_pipeline_desc desc;
-} rizz__pip_mtl;
-#endif
+    sg_pipeline_desc desc;    // normalized: defaults resolved, label and padding cleared
+    uint32_t hash;
+    int ref_count;
+    bool cached;    // entry owns the `hash` key in the lookup table
+} rizz__pip_cache_entry;
+
+typedef struct rizz__shader_cache_entry {
+    sg_shader shd;
+    uint64_t hash;
+    int ref_count;
+    bool cached;
+} rizz__shader_cache_entry;
+
+typedef struct rizz__gfx_cache {
+    rizz__pip_cache_entry* pips;          // count = pipeline pool size
+    rizz__shader_cache_entry* shaders;    // count = shader pool size
+    sx_hashtbl* pip_tbl;                  // key: desc hash, value: slot index
+    sx_hashtbl* shader_tbl;
+    int num_pip_slots;
+    int num_shader_slots;
+} rizz__gfx_cache;
 
 typedef struct rizz__trace_gfx {
     rizz_gfx_trace_info t;
@@ -268,11 +295,7 @@ typedef struct rizz__gfx {
     rizz__gfx_cmdbuffer** cmd_buffers;    // sx_array
     sx_lock_t stage_lk;
     rizz__gfx_texture_mgr tex_mgr;
-#ifdef SOKOL_METAL
-    rizz__pip_mtl* pips;    // sx_array: keep track of pipelines for shader hot-reloads
-#else
-    sg_pipeline* pips;
-#endif
+    rizz__gfx_cache cache;    // also keeps track of pipelines for shader hot-reloads
     rizz__gfx_stream_buffer* stream_buffs;    // sx_array: streaming buffers for append_buffers
     rizz__gfx_debug dbg;
 
@@ -426,6 +449,18 @@ _SOKOL_PRIVATE void _sg_set_pipeline_shader(_sg_pipeline_t* pip, sg_shader shade
         }
     }
 }
+#elif defined(SOKOL_DUMMY_BACKEND)
+_SOKOL_PRIVATE void _sg_set_pipeline_shader(_sg_pipeline_t* pip, sg_shader shader_id,
+                                            _sg_shader_t* shd, const rizz_shader_info* info,
+                                            const sg_pipeline_desc* desc)
+{
+    SOKOL_ASSERT(shd->slot.state == SG_RESOURCESTATE_VALID);
+    sx_unused(info);
+    sx_unused(desc);
+
+    pip->shader = shd;
+    pip->shader_id = shader_id;
+}
 #endif
 
 static void sg_set_pipeline_shader(sg_pipeline pip_id, sg_shader prev_shader_id,
@@ -474,6 +509,292 @@ static void sg_map_buffer(sg_buffer buf_id, int offset, const void* data, int nu
     }
 }
 
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// @cache
+static bool rizz__cache_init(const sx_alloc* alloc)
+{
+    rizz__gfx_cache* cache = &g_gfx.cache;
+
+    cache->num_pip_slots = _sg.pools.pipeline_pool.size;
+    cache->num_shader_slots = _sg.pools.shader_pool.size;
+    cache->pips = sx_malloc(alloc, sizeof(rizz__pip_cache_entry) * cache->num_pip_slots);
+    cache->shaders = sx_malloc(alloc, sizeof(rizz__shader_cache_entry) * cache->num_shader_slots);
+    if (!cache->pips || !cache->shaders) {
+        sx_out_of_memory();
+        return false;
+    }
+    sx_memset(cache->pips, 0x0, sizeof(rizz__pip_cache_entry) * cache->num_pip_slots);
+    sx_memset(cache->shaders, 0x0, sizeof(rizz__shader_cache_entry) * cache->num_shader_slots);
+
+    cache->pip_tbl = sx_hashtbl_create(alloc, 128);
+    cache->shader_tbl = sx_hashtbl_create(alloc, 128);
+    if (!cache->pip_tbl || !cache->shader_tbl) {
+        sx_out_of_memory();
+        return false;
+    }
+
+    return true;
+}
+
+static void rizz__cache_release(const sx_alloc* alloc)
+{
+    rizz__gfx_cache* cache = &g_gfx.cache;
+    if (cache->pip_tbl)
+        sx_hashtbl_destroy(cache->pip_tbl, alloc);
+    if (cache->shader_tbl)
+        sx_hashtbl_destroy(cache->shader_tbl, alloc);
+    sx_free(alloc, cache->pips);
+    sx_free(alloc, cache->shaders);
+    sx_memset(cache, 0x0, sizeof(*cache));
+}
+
+// copies the descriptor field by field into zeroed memory, so padding bytes and labels don't
+// affect hashing and memcmp
+static void rizz__pip_cache_make_key(sg_pipeline_desc* key, const sg_pipeline_desc* desc)
+{
+    sg_pipeline_desc def = _sg_pipeline_desc_defaults(desc);
+    const sg_depth_stencil_state* ds = &def.depth_stencil;
+    const sg_blend_state* bs = &def.blend;
+    const sg_rasterizer_state* rs = &def.rasterizer;
+
+    sx_memset(key, 0x0, sizeof(*key));
+    key->layout = def.layout;
+    key->shader = def.shader;
+    key->primitive_type = def.primitive_type;
+    key->index_type = def.index_type;
+
+    key->depth_stencil.stencil_front = ds->stencil_front;
+    key->depth_stencil.stencil_back = ds->stencil_back;
+    key->depth_stencil.depth_compare_func = ds->depth_compare_func;
+    key->depth_stencil.depth_write_enabled = ds->depth_write_enabled;
+    key->depth_stencil.stencil_enabled = ds->stencil_enabled;
+    key->depth_stencil.stencil_read_mask = ds->stencil_read_mask;
+    key->depth_stencil.stencil_write_mask = ds->stencil_write_mask;
+    key->depth_stencil.stencil_ref = ds->stencil_ref;
+
+    key->blend.enabled = bs->enabled;
+    key->blend.src_factor_rgb = bs->src_factor_rgb;
+    key->blend.dst_factor_rgb = bs->dst_factor_rgb;
+    key->blend.op_rgb = bs->op_rgb;
+    key->blend.src_factor_alpha = bs->src_factor_alpha;
+    key->blend.dst_factor_alpha = bs->dst_factor_alpha;
+    key->blend.op_alpha = bs->op_alpha;
+    // keep SG_COLORMASK_NONE as is, the key is fed back to sokol on shader reloads (metal)
+    key->blend.color_write_mask = desc->blend.color_write_mask == SG_COLORMASK_NONE
+                                      ? (uint8_t)SG_COLORMASK_NONE
+                                      : bs->color_write_mask;
+    key->blend.color_attachment_count = bs->color_attachment_count;
+    key->blend.color_format = bs->color_format;
+    key->blend.depth_format = bs->depth_format;
+    sx_memcpy(key->blend.blend_color, bs->blend_color, sizeof(bs->blend_color));
+
+    key->rasterizer.alpha_to_coverage_enabled = rs->alpha_to_coverage_enabled;
+    key->rasterizer.cull_mode = rs->cull_mode;
+    key->rasterizer.face_winding = rs->face_winding;
+    key->rasterizer.sample_count = rs->sample_count;
+    key->rasterizer.depth_bias = rs->depth_bias;
+    key->rasterizer.depth_bias_slope_scale = rs->depth_bias_slope_scale;
+    key->rasterizer.depth_bias_clamp = rs->depth_bias_clamp;
+}
+
+static void rizz__pip_cache_add_key(rizz__pip_cache_entry* e, int slot)
+{
+    sx_hashtbl* tbl = g_gfx.cache.pip_tbl;
+
+    e->hash = sx_hash_xxh32(&e->desc, sizeof(e->desc), 0);
+    // on hash collisions, the pipeline is still tracked, but it won't be shared
+    e->cached = sx_hashtbl_find(tbl, e->hash) == -1;
+    if (e->cached) {
+        sx_hashtbl_add_and_grow(g_gfx.cache.pip_tbl, e->hash, slot, g_gfx_alloc);
+    }
+}
+
+static void rizz__pip_cache_remove_key(rizz__pip_cache_entry* e)
+{
+    if (e->cached) {
+        sx_hashtbl_remove_if_found(g_gfx.cache.pip_tbl, e->hash);
+        e->cached = false;
+    }
+}
+
+static void rizz__pip_cache_add(sg_pipeline pip_id, const sg_pipeline_desc* key, bool shared)
+{
+    int slot = _sg_slot_index(pip_id.id);
+    sx_assert(slot < g_gfx.cache.num_pip_slots);
+
+    rizz__pip_cache_entry* e = &g_gfx.cache.pips[slot];
+    sx_assert(e->ref_count == 0 && "pipeline slot is already registered");
+    e->pip = pip_id;
+    e->desc = *key;
+    e->ref_count = 1;
+    if (shared) {
+        rizz__pip_cache_add_key(e, slot);
+    }
+}
+
+static int rizz__pip_cache_find(const sg_pipeline_desc* key)
+{
+    uint32_t hash = sx_hash_xxh32(key, sizeof(*key), 0);
+    int slot = sx_hashtbl_find_get(g_gfx.cache.pip_tbl, hash, -1);
+    if (slot != -1 && sx_memcmp(&g_gfx.cache.pips[slot].desc, key, sizeof(*key)) == 0) {
+        return slot;
+    }
+    return -1;
+}
+
+// points all cached pipelines that use `prev_shader` to `new_shader` and re-keys them
+static void rizz__pip_cache_set_shader(sg_shader prev_shader, sg_shader new_shader,
+                                       const rizz_shader_info* info)
+{
+    rizz__gfx_cache* cache = &g_gfx.cache;
+    for (int i = 0; i < cache->num_pip_slots; i++) {
+        rizz__pip_cache_entry* e = &cache->pips[i];
+        if (e->ref_count == 0 || e->desc.shader.id != prev_shader.id) {
+            continue;
+        }
+
+#if defined(SOKOL_METAL)
+        const sg_pipeline_desc* _desc = &e->desc;
+#else
+        const sg_pipeline_desc* _desc = NULL;
+#endif
+        sg_set_pipeline_shader(e->pip, prev_shader, new_shader, info, _desc);
+
+        bool shared = e->cached;
+        rizz__pip_cache_remove_key(e);
+        e->desc.shader = new_shader;
+        if (shared) {
+            rizz__pip_cache_add_key(e, i);
+        }
+    }
+}
+
+// returns true if the pipeline has no more references and should be destroyed
+static bool rizz__pip_cache_release(sg_pipeline pip_id)
+{
+    int slot = _sg_slot_index(pip_id.id);
+    sx_assert(slot < g_gfx.cache.num_pip_slots);
+
+    rizz__pip_cache_entry* e = &g_gfx.cache.pips[slot];
+    if (e->pip.id != pip_id.id) {
+        return true;    // not tracked
+    }
+
+    sx_assert(e->ref_count > 0);
+    if (--e->ref_count > 0) {
+        return false;
+    }
+
+    rizz__pip_cache_remove_key(e);
+    sx_memset(e, 0x0, sizeof(*e));
+    return true;
+}
+
+static inline uint64_t rizz__shader_cache_hash_str(const char* str, uint64_t seed)
+{
+    // include the null-terminator, so NULL and empty strings hash differently
+    return str ? sx_hash_xxh64(str, sx_strlen(str) + 1, seed) : sx_hash_xxh64(str, 0, seed);
+}
+
+// hashes the contents of the shader (code and reflection), the label is ignored
+static uint64_t rizz__shader_cache_hash(const sg_shader_desc* desc)
+{
+    uint64_t h = 0;
+
+    for (int i = 0; i < SG_MAX_VERTEX_ATTRIBUTES; i++) {
+        const sg_shader_attr_desc* attr = &desc->attrs[i];
+        h = rizz__shader_cache_hash_str(attr->name, h);
+        h = rizz__shader_cache_hash_str(attr->sem_name, h);
+        h = sx_hash_xxh64(&attr->sem_index, sizeof(attr->sem_index), h);
+    }
+
+    const sg_shader_stage_desc* stages[] = { &desc->vs, &desc->fs, &desc->cs };
+    for (int i = 0; i < 3; i++) {
+        const sg_shader_stage_desc* stage = stages[i];
+        h = rizz__shader_cache_hash_str(stage->source, h);
+        h = rizz__shader_cache_hash_str(stage->entry, h);
+        h = sx_hash_xxh64(&stage->byte_code_size, sizeof(stage->byte_code_size), h);
+        if (stage->byte_code) {
+            h = sx_hash_xxh64(stage->byte_code, (size_t)stage->byte_code_size, h);
+        }
+
+        for (int ub_index = 0; ub_index < SG_MAX_SHADERSTAGE_UBS; ub_index++) {
+            const sg_shader_uniform_block_desc* ub = &stage->uniform_blocks[ub_index];
+            h = sx_hash_xxh64(&ub->size, sizeof(ub->size), h);
+            if (ub->size == 0) {
+                continue;
+            }
+            for (int u = 0; u < SG_MAX_UB_MEMBERS; u++) {
+                const sg_shader_uniform_desc* uniform = &ub->uniforms[u];
+                int type_count[2] = { (int)uniform->type, uniform->array_count };
+                h = rizz__shader_cache_hash_str(uniform->name, h);
+                h = sx_hash_xxh64(type_count, sizeof(type_count), h);
+            }
+        }
+
+        for (int img_index = 0; img_index < SG_MAX_SHADERSTAGE_IMAGES; img_index++) {
+            const sg_shader_image_desc* img = &stage->images[img_index];
+            int type = (int)img->type;
+            h = rizz__shader_cache_hash_str(img->name, h);
+            h = sx_hash_xxh64(&type, sizeof(type), h);
+        }
+    }
+
+    return h;
+}
+
+static inline uint32_t rizz__shader_cache_key(uint64_t hash)
+{
+    return (uint32_t)(hash ^ (hash >> 32));
+}
+
+static void rizz__shader_cache_add(sg_shader shd_id, uint64_t hash, bool shared)
+{
+    rizz__gfx_cache* cache = &g_gfx.cache;
+    int slot = _sg_slot_index(shd_id.id);
+    sx_assert(slot < cache->num_shader_slots);
+
+    rizz__shader_cache_entry* e = &cache->shaders[slot];
+    sx_assert(e->ref_count == 0 && "shader slot is already registered");
+    e->shd = shd_id;
+    e->hash = hash;
+    e->ref_count = 1;
+    e->cached =
+        shared && sx_hashtbl_find(cache->shader_tbl, rizz__shader_cache_key(hash)) == -1;
+    if (e->cached) {
+        sx_hashtbl_add_and_grow(cache->shader_tbl, rizz__shader_cache_key(hash), slot,
+                                g_gfx_alloc);
+    }
+}
+
+static int rizz__shader_cache_find(uint64_t hash)
+{
+    int slot = sx_hashtbl_find_get(g_gfx.cache.shader_tbl, rizz__shader_cache_key(hash), -1);
+    return (slot != -1 && g_gfx.cache.shaders[slot].hash == hash) ? slot : -1;
+}
+
+static bool rizz__shader_cache_release(sg_shader shd_id)
+{
+    int slot = _sg_slot_index(shd_id.id);
+    sx_assert(slot < g_gfx.cache.num_shader_slots);
+
+    rizz__shader_cache_entry* e = &g_gfx.cache.shaders[slot];
+    if (e->shd.id != shd_id.id) {
+        return true;
+    }
+
+    sx_assert(e->ref_count > 0);
+    if (--e->ref_count > 0) {
+        return false;
+    }
+
+    if (e->cached) {
+        sx_hashtbl_remove_if_found(g_gfx.cache.shader_tbl, rizz__shader_cache_key(e->hash));
+    }
+    sx_memset(e, 0x0, sizeof(*e));
+    return true;
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 // @texture
 static inline sg_image_type rizz__texture_get_type(const ddsktx_texture_info* tc)
@@ -519,6 +840,124 @@ static inline sg_pixel_format rizz__texture_get_texture_format(ddsktx_format fmt
     // clang-format on
 }
 
+// CPU mip-chain generation for RGBA8 images (2x2 box filter)
+// sRGB images are averaged in linear space: texels are decoded to 14bit linear with a LUT, so the
+// sum of four fits in 16bit lanes, and the result is encoded back with another LUT
+#define RIZZ__MIPS_LINEAR_BITS 14
+#define RIZZ__MIPS_LINEAR_MAX ((1 << RIZZ__MIPS_LINEAR_BITS) - 1)
+#define RIZZ__MIPS_ALPHA_SHIFT (RIZZ__MIPS_LINEAR_BITS - 8)
+
+static void rizz__texture_init_mip_luts(void)
+{
+    rizz__gfx_texture_mgr* mgr = &g_gfx.tex_mgr;
+    for (int i = 0; i < 256; i++) {
+        float l = sx_color_tolinear((float)i / 255.0f);
+        mgr->srgb_to_linear[i] = (uint16_t)(l * (float)RIZZ__MIPS_LINEAR_MAX + 0.5f);
+    }
+    for (int i = 0; i <= RIZZ__MIPS_LINEAR_MAX; i++) {
+        float s = sx_color_togamma((float)i / (float)RIZZ__MIPS_LINEAR_MAX);
+        mgr->linear_to_srgb[i] = (uint8_t)sx_min(s * 255.0f + 0.5f, 255.0f);
+    }
+}
+
+static inline int rizz__texture_num_mips(int width, int height)
+{
+    int mips = 1;
+    for (int size = sx_max(width, height); size > 1; size >>= 1) {
+        ++mips;
+    }
+    return mips;
+}
+
+static inline int rizz__texture_mip_dim(int size, int mip)
+{
+    return sx_max(size >> mip, 1);
+}
+
+static void rizz__mip_decode_srgb(uint16_t* dst, const uint8_t* src, int width)
+{
+    const uint16_t* lut = g_gfx.tex_mgr.srgb_to_linear;
+    for (int x = 0, c = width * 4; x < c; x += 4) {
+        dst[x] = lut[src[x]];
+        dst[x + 1] = lut[src[x + 1]];
+        dst[x + 2] = lut[src[x + 2]];
+        dst[x + 3] = (uint16_t)(src[x + 3] << RIZZ__MIPS_ALPHA_SHIFT);
+    }
+}
+
+static void rizz__mip_encode_srgb(uint8_t* dst, const uint16_t* src, int width)
+{
+    const uint8_t* lut = g_gfx.tex_mgr.linear_to_srgb;
+    const int round = 1 << (RIZZ__MIPS_ALPHA_SHIFT - 1);
+    for (int x = 0, c = width * 4; x < c; x += 4) {
+        dst[x] = lut[src[x]];
+        dst[x + 1] = lut[src[x + 1]];
+        dst[x + 2] = lut[src[x + 2]];
+        dst[x + 3] = (uint8_t)sx_min((src[x + 3] + round) >> RIZZ__MIPS_ALPHA_SHIFT, 255);
+    }
+}
+
+// generates mips [1..num_mips) of an RGBA8 image into `mips` (tightly packed, one after another)
+// in sRGB mode, every level is downsampled from the previous one in linear space, without
+// re-quantizing the intermediate levels to 8bit
+static bool rizz__texture_gen_mips(uint8_t* mips, const uint8_t* pixels, int width, int height,
+                                   int num_mips, bool srgb, const sx_alloc* alloc)
+{
+    if (!srgb) {
+        const uint8_t* src = pixels;
+        for (int mip = 1; mip < num_mips; mip++) {
+            int src_w = rizz__texture_mip_dim(width, mip - 1);
+            int src_h = rizz__texture_mip_dim(height, mip - 1);
+            int dst_w = rizz__texture_mip_dim(width, mip);
+            int dst_h = rizz__texture_mip_dim(height, mip);
+            for (int y = 0; y < dst_h; y++) {
+                const uint8_t* r0 = src + sx_min(y * 2, src_h - 1) * src_w * 4;
+                const uint8_t* r1 = src + sx_min(y * 2 + 1, src_h - 1) * src_w * 4;
+                sx_rgba8_box_batch(mips + y * dst_w * 4, r0, r1, dst_w, src_w);
+            }
+            src = mips;
+            mips += dst_w * dst_h * 4;
+        }
+        return true;
+    }
+
+    // linear working copy: the whole base level (decoded once) plus the first mip level.
+    // deeper levels are downsampled in-place within the mip buffer, since each one is a quarter
+    // of the previous one and rows are consumed before they get overwritten
+    int base_count = width * height * 4;
+    int mip_count = rizz__texture_mip_dim(width, 1) * rizz__texture_mip_dim(height, 1) * 4;
+    uint16_t* base = sx_malloc(alloc, sizeof(uint16_t) * (base_count + mip_count));
+    if (!base) {
+        sx_out_of_memory();
+        return false;
+    }
+    uint16_t* work = base + base_count;
+
+    for (int y = 0; y < height; y++) {
+        rizz__mip_decode_srgb(base + y * width * 4, pixels + y * width * 4, width);
+    }
+
+    const uint16_t* src = base;
+    for (int mip = 1; mip < num_mips; mip++) {
+        int src_w = rizz__texture_mip_dim(width, mip - 1);
+        int src_h = rizz__texture_mip_dim(height, mip - 1);
+        int dst_w = rizz__texture_mip_dim(width, mip);
+        int dst_h = rizz__texture_mip_dim(height, mip);
+        for (int y = 0; y < dst_h; y++) {
+            const uint16_t* r0 = src + sx_min(y * 2, src_h - 1) * src_w * 4;
+            const uint16_t* r1 = src + sx_min(y * 2 + 1, src_h - 1) * src_w * 4;
+            uint16_t* dst_row = work + y * dst_w * 4;
+            sx_rgba16_box_batch(dst_row, r0, r1, dst_w, src_w);
+            rizz__mip_encode_srgb(mips + y * dst_w * 4, dst_row, dst_w);
+        }
+        src = work;
+        mips += dst_w * dst_h * 4;
+    }
+
+    sx_free(alloc, base);
+    return true;
+}
+
 static rizz_asset_load_data rizz__texture_on_prepare(const rizz_asset_load_params* params,
                                                      const void* metadata)
 {
@@ -619,6 +1058,25 @@ static bool rizz__texture_on_load(rizz_asset_load_data* data, const rizz_asset_l
             sx_assert(tex->info.width == w && tex->info.height == h);
             desc->content.subimage[0][0].ptr = pixels;
             desc->content.subimage[0][0].size = w * h * 4;
+
+            if (tparams->generate_mips && desc->num_mipmaps > 1) {
+                int num_mips = sx_min(desc->num_mipmaps, SG_MAX_MIPMAPS);
+                int mips_size = tex->info.mem_size_bytes - w * h * 4;
+                uint8_t* mips = sx_malloc(g_gfx_alloc, mips_size);
+                if (!mips || !rizz__texture_gen_mips(mips, pixels, w, h, num_mips,
+                                                     !tparams->linear_mips, g_gfx_alloc)) {
+                    sx_free(g_gfx_alloc, mips);
+                    stbi_image_free(pixels);
+                    return false;
+                }
+
+                for (int mip = 1; mip < num_mips; mip++) {
+                    int size = rizz__texture_mip_dim(w, mip) * rizz__texture_mip_dim(h, mip) * 4;
+                    desc->content.subimage[0][mip].ptr = mips;
+                    desc->content.subimage[0][mip].size = size;
+                    mips += size;
+                }
+            }
         } else {
             rizz_log_warn("parsing image '%s' failed: %s", params->path, stbi_failure_reason());
             return false;
@@ -643,6 +1101,10 @@ static void rizz__texture_on_finalize(rizz_asset_load_data* data,
     if (!sx_strequalnocase(ext, ".dds") && !sx_strequalnocase(ext, ".ktx")) {
         sx_assert(desc->content.subimage[0][0].ptr);
         stbi_image_free((void*)desc->content.subimage[0][0].ptr);
+        // generated mips are allocated in one block, starting at the second level
+        if (desc->num_mipmaps > 1) {
+            sx_free(g_gfx_alloc, (void*)desc->content.subimage[0][1].ptr);
+        }
     }
 
     sx_free(g_gfx_alloc, data->user);
@@ -672,6 +1134,14 @@ static void rizz__texture_on_release(rizz_asset_obj obj, const sx_alloc* alloc)
     sx_free(alloc, tex);
 }
 
+static int64_t rizz__texture_on_get_size(rizz_asset_obj obj, const void* metadata,
+                                         rizz_mem_id* memid)
+{
+    sx_unused(metadata);
+    *memid = RIZZ_MEMID_GRAPHICS;
+    return ((const rizz_texture*)obj.ptr)->info.mem_size_bytes;
+}
+
 static void rizz__texture_on_read_metadata(void* metadata, const rizz_asset_load_params* params,
                                            const sx_mem_block* mem)
 {
@@ -711,6 +1181,16 @@ static void rizz__texture_on_read_metadata(void* metadata, const rizz_asset_load
             info->layers = 1;
             info->mips = 1;
             info->bpp = 32;
+
+            const rizz_texture_load_params* tparams = params->params;
+            if (tparams && tparams->generate_mips) {
+                info->mips = sx_min(rizz__texture_num_mips(info->width, info->height),
+                                    SG_MAX_MIPMAPS);
+                for (int mip = 1; mip < info->mips; mip++) {
+                    info->mem_size_bytes += 4 * rizz__texture_mip_dim(info->width, mip) *
+                                            rizz__texture_mip_dim(info->height, mip);
+                }
+            }
         } else {
             rizz_log_warn("reading image '%s' metadata failed: %s", params->path,
                           stbi_failure_reason());
@@ -897,6 +1377,8 @@ static void rizz__texture_init()
                                      .bpp = 32 }
     };
 
+    rizz__texture_init_mip_luts();
+
     const sx_color checker_colors[] = { sx_color4u(255, 0, 255, 255),
                                         sx_color4u(255, 255, 255, 255) };
     g_gfx.tex_mgr.checker_tex = rizz__texture_create_checker(CHECKER_TEXTURE_SIZE / 2,
@@ -909,7 +1391,8 @@ static void rizz__texture_init()
                                 .on_finalize = rizz__texture_on_finalize,
                                 .on_reload = rizz__texture_on_reload,
                                 .on_release = rizz__texture_on_release,
-                                .on_read_metadata = rizz__texture_on_read_metadata },
+                                .on_read_metadata = rizz__texture_on_read_metadata,
+                                .on_get_size = rizz__texture_on_get_size },
         "rizz_texture_load_params", sizeof(rizz_texture_load_params), "rizz_texture_info",
         sizeof(rizz_texture_info), (rizz_asset_obj){ .ptr = &g_gfx.tex_mgr.white_tex },
         (rizz_asset_obj){ .ptr = &g_gfx.tex_mgr.white_tex }, 0);
@@ -1660,6 +2143,23 @@ static sg_pipeline_desc* rizz__shader_bindto_pipeline(rizz_shader* shd, sg_pipel
                                            vl);
 }
 
+// `user` data of shader loads: the desc points to the names in the reflection data, so the
+// reflections are kept until `on_finalize`, `on_load` may run on a worker's temp allocator
+typedef struct rizz__shader_load_data {
+    sg_shader_desc desc;
+    rizz_shader_refl* refls[_RIZZ_SHADER_STAGE_COUNT];
+} rizz__shader_load_data;
+
+static void rizz__shader_free_load_data(rizz__shader_load_data* ldata)
+{
+    for (int i = 0; i < _RIZZ_SHADER_STAGE_COUNT; i++) {
+        if (ldata->refls[i]) {
+            rizz__shader_free_reflect(ldata->refls[i], g_gfx_alloc);
+        }
+    }
+    sx_free(g_gfx_alloc, ldata);
+}
+
 static rizz_asset_load_data rizz__shader_on_prepare(const rizz_asset_load_params* params,
                                                     const void* metadata)
 {
@@ -1672,8 +2172,11 @@ static rizz_asset_load_data rizz__shader_on_prepare(const rizz_asset_load_params
     shader->shd = the__gfx.alloc_shader();
     sx_memcpy(&shader->info, info, sizeof(*info));
 
-    return (rizz_asset_load_data){ .obj = { .ptr = shader },
-                                   .user = sx_malloc(g_gfx_alloc, sizeof(sg_shader_desc)) };
+    rizz__shader_load_data* ldata = sx_malloc(g_gfx_alloc, sizeof(rizz__shader_load_data));
+    if (ldata) {
+        sx_memset(ldata, 0x0, sizeof(*ldata));
+    }
+    return (rizz_asset_load_data){ .obj = { .ptr = shader }, .user = ldata };
 }
 
 static bool rizz__shader_on_load(rizz_asset_load_data* data, const rizz_asset_load_params* params,
@@ -1681,8 +2184,10 @@ static bool rizz__shader_on_load(rizz_asset_load_data* data, const rizz_asset_lo
 {
     sx_unused(params);
 
-    const sx_alloc* tmp_alloc = the__core.tmp_alloc_push();
-    sg_shader_desc* shader_desc = data->user;
+    rizz__shader_load_data* ldata = data->user;
+    if (!ldata) {
+        return false;
+    }
 
     rizz_shader_refl *vs_refl = NULL, *fs_refl = NULL, *cs_refl = NULL;
     const uint8_t *vs_data = NULL, *fs_data = NULL, *cs_data = NULL;
@@ -1693,7 +2198,7 @@ static bool rizz__shader_on_load(rizz_asset_load_data* data, const rizz_asset_lo
     uint32_t _sgs;
     sx_mem_read_var(&reader, _sgs);
     if (_sgs != SGS_CHUNK) {
-        return false;
+        goto failed;
     }
     sx_mem_seekr(&reader, sizeof(uint32_t), SX_WHENCE_CURRENT);
 
@@ -1713,7 +2218,7 @@ static bool rizz__shader_on_load(rizz_asset_load_data* data, const rizz_asset_lo
         if (code_chunk.pos == -1) {
             code_chunk = sx_mem_get_iff_chunk(&reader, stage_chunk.size, SGS_CHUNK_DATA);
             if (code_chunk.pos == -1)
-                return false;    // nor data or code chunk is found!
+                goto failed;    // nor data or code chunk is found!
             code_type = RIZZ_SHADER_CODE_BYTECODE;
         }
 
@@ -1738,9 +2243,16 @@ static bool rizz__shader_on_load(rizz_asset_load_data* data, const rizz_asset_lo
         sx_mem_seekr(&reader, code_chunk.size, SX_WHENCE_CURRENT);
         sx_iff_chunk reflect_chunk =
             sx_mem_get_iff_chunk(&reader, stage_chunk.size - code_chunk.size, SGS_CHUNK_REFL);
-        if (reflect_chunk.pos != -1) {
+        if (reflect_chunk.pos != -1 && stage != _RIZZ_SHADER_STAGE_COUNT) {
             rizz_shader_refl* refl = rizz__shader_parse_reflect_bin(
-                tmp_alloc, reader.data + reflect_chunk.pos, reflect_chunk.size);
+                g_gfx_alloc, reader.data + reflect_chunk.pos, reflect_chunk.size);
+            if (!refl) {
+                goto failed;
+            }
+            if (ldata->refls[stage]) {
+                rizz__shader_free_reflect(ldata->refls[stage], g_gfx_alloc);
+            }
+            ldata->refls[stage] = refl;
             refl->lang = rizz__shader_fourcc_to_lang(sinfo.lang);
             refl->stage = stage;
             refl->profile_version = (int)sinfo.profile_ver;
@@ -1762,14 +2274,23 @@ static bool rizz__shader_on_load(rizz_asset_load_data* data, const rizz_asset_lo
     }
 
     if (cs_refl && cs_data) {
-        rizz__shader_setup_desc_cs(shader_desc, cs_refl, cs_data, cs_size);
+        rizz__shader_setup_desc_cs(&ldata->desc, cs_refl, cs_data, cs_size);
     } else {
         sx_assert(vs_refl && fs_refl);
-        rizz__shader_setup_desc(shader_desc, vs_refl, vs_data, vs_size, fs_refl, fs_data, fs_size);
+        if (!vs_refl || !fs_refl) {
+            goto failed;
+        }
+        rizz__shader_setup_desc(&ldata->desc, vs_refl, vs_data, vs_size, fs_refl, fs_data,
+                                fs_size);
     }
 
-    the__core.tmp_alloc_pop();
     return true;
+
+failed:
+    // on_finalize is not called for failed loads
+    rizz__shader_free_load_data(ldata);
+    data->user = NULL;
+    return false;
 }
 
 static void rizz__shader_on_finalize(rizz_asset_load_data* data,
@@ -1779,12 +2300,12 @@ static void rizz__shader_on_finalize(rizz_asset_load_data* data,
     sx_unused(params);
 
     rizz_shader* shader = data->obj.ptr;
-    sg_shader_desc* desc = data->user;
-    sx_assert(desc);
+    rizz__shader_load_data* ldata = data->user;
+    sx_assert(ldata);
 
-    the__gfx.init_shader(shader->shd, desc);
+    the__gfx.init_shader(shader->shd, &ldata->desc);
 
-    sx_free(g_gfx_alloc, data->user);
+    rizz__shader_free_load_data(ldata);
 }
 
 static void rizz__shader_on_reload(rizz_asset handle, rizz_asset_obj prev_obj,
@@ -1794,16 +2315,7 @@ static void rizz__shader_on_reload(rizz_asset handle, rizz_asset_obj prev_obj,
 
     sg_shader prev_shader = ((rizz_shader*)prev_obj.ptr)->shd;
     rizz_shader* new_shader = (rizz_shader*)the__asset.obj(handle).ptr;
-    for (int i = 0, c = sx_array_count(g_gfx.pips); i < c; i++) {
-#if defined(SOKOL_METAL)
-        const sg_pipeline_desc* _desc = &g_gfx.pips[i].desc;
-        sg_pipeline _pip = g_gfx.pips[i].pip;
-#else
-        const sg_pipeline_desc* _desc = NULL;
-        sg_pipeline _pip = g_gfx.pips[i];
-#endif
-        sg_set_pipeline_shader(_pip, prev_shader, new_shader->shd, &new_shader->info, _desc);
-    }
+    rizz__pip_cache_set_shader(prev_shader, new_shader->shd, &new_shader->info);
 }
 
 static void rizz__shader_on_release(rizz_asset_obj obj, const sx_alloc* alloc)
@@ -2813,19 +3325,6 @@ static void rizz__gfx_collect_garbage(int64_t frame)
         sg_pipeline pip_id = g_gfx.destroy_pips[i];
         _sg_pipeline_t* pip = _sg_lookup_pipeline(&_sg.pools, pip_id.id);
         if (frame > pip->used_frame + 1) {
-#if RIZZ_CONFIG_HOT_LOADING
-            for (int ii = 0, cc = sx_array_count(g_gfx.pips); ii < cc; ii++) {
-#    if defined(SOKOL_METAL)
-                sg_pipeline _pip = g_gfx.pips[ii].pip;
-#    else
-                sg_pipeline _pip = g_gfx.pips[ii];
-#    endif
-                if (_pip.id == pip_id.id) {
-                    sx_array_pop(g_gfx.pips, ii);
-                    break;
-                }
-            }
-#endif
             sg_destroy_pipeline(pip_id);
             sx_array_pop(g_gfx.destroy_pips, i);
             i--;
@@ -2875,7 +3374,7 @@ static void rizz__gfx_collect_garbage(int64_t frame)
 //
 bool rizz__gfx_init(const sx_alloc* alloc, const sg_desc* desc, bool enable_profile)
 {
-#if SX_PLATFORM_LINUX
+#if RIZZ_GRAPHICS_API_GL==33
     if (flextInit() != GL_TRUE) {
         rizz_log_error("gfx: could not initialize OpenGL");
         return false;
@@ -2885,6 +3384,10 @@ bool rizz__gfx_init(const sx_alloc* alloc, const sg_desc* desc, bool enable_prof
     sg_setup(desc);
     g_gfx.enable_profile = enable_profile;
 
+    if (!rizz__cache_init(alloc)) {
+        return false;
+    }
+
     // trace calls
     {
         sx_mem_init_writer(&g_gfx.trace.make_cmds_writer, alloc, 0);
@@ -2988,7 +3491,7 @@ void rizz__gfx_release()
     sx_array_free(g_gfx_alloc, g_gfx.cmd_buffers);
     sx_array_free(g_gfx_alloc, g_gfx.stream_buffs);
     sx_array_free(g_gfx_alloc, g_gfx.stages);
-    sx_array_free(g_gfx_alloc, g_gfx.pips);
+    rizz__cache_release(g_gfx_alloc);
 
     sx_mem_release_writer(&g_gfx.trace.make_cmds_writer);
 
@@ -4079,40 +4582,71 @@ static rizz_gfx_stage rizz__stage_find(const char* name)
 
 static void rizz__init_pipeline(sg_pipeline pip_id, const sg_pipeline_desc* desc)
 {
-#if RIZZ_CONFIG_HOT_LOADING
-#    if defined(SOKOL_METAL)
-    rizz__pip_mtl pip = { .pip = pip_id, .desc = *desc };
-    sx_array_push(g_gfx_alloc, g_gfx.pips, pip);
-#    else
-    sx_array_push(g_gfx_alloc, g_gfx.pips, pip_id);
-#    endif
-#endif
+    sg_pipeline_desc key;
+    rizz__pip_cache_make_key(&key, desc);
     sg_init_pipeline(pip_id, desc);
+    rizz__pip_cache_add(pip_id, &key, sg_query_pipeline_state(pip_id) == SG_RESOURCESTATE_VALID);
 }
 
 static sg_pipeline rizz__make_pipeline(const sg_pipeline_desc* desc)
 {
-    sg_pipeline pip_id = sg_make_pipeline(desc);
-#if RIZZ_CONFIG_HOT_LOADING
-#    if defined(SOKOL_METAL)
-    rizz__pip_mtl pip = { .pip = pip_id, .desc = *desc };
-    sx_array_push(g_gfx_alloc, g_gfx.pips, pip);
-#    else
-    sx_array_push(g_gfx_alloc, g_gfx.pips, pip_id);
-#    endif
-#endif
+    sg_pipeline_desc key;
+    rizz__pip_cache_make_key(&key, desc);
+
+    int slot = rizz__pip_cache_find(&key);
+    if (slot != -1) {
+        ++g_gfx.cache.pips[slot].ref_count;
+        ++g_gfx.trace.t.pip_cache_hits;
+        return g_gfx.cache.pips[slot].pip;
+    }
 
+    sg_pipeline pip_id = sg_make_pipeline(desc);
+    if (pip_id.id) {
+        rizz__pip_cache_add(pip_id, &key,
+                            sg_query_pipeline_state(pip_id) == SG_RESOURCESTATE_VALID);
+    }
+    ++g_gfx.trace.t.pip_cache_misses;
     return pip_id;
 }
 
+static void rizz__init_shader(sg_shader shd_id, const sg_shader_desc* desc)
+{
+    sg_init_shader(shd_id, desc);
+    rizz__shader_cache_add(shd_id, rizz__shader_cache_hash(desc), false);
+}
+
+static sg_shader rizz__make_shader(const sg_shader_desc* desc)
+{
+    uint64_t hash = rizz__shader_cache_hash(desc);
+
+    int slot = rizz__shader_cache_find(hash);
+    if (slot != -1) {
+        ++g_gfx.cache.shaders[slot].ref_count;
+        ++g_gfx.trace.t.shader_cache_hits;
+        return g_gfx.cache.shaders[slot].shd;
+    }
+
+    sg_shader shd_id = sg_make_shader(desc);
+    if (shd_id.id) {
+        rizz__shader_cache_add(shd_id, hash,
+                               sg_query_shader_state(shd_id) == SG_RESOURCESTATE_VALID);
+    }
+    ++g_gfx.trace.t.shader_cache_misses;
+    return shd_id;
+}
+
 static void rizz__destroy_pipeline(sg_pipeline pip_id)
 {
-    rizz__queue_destroy(g_gfx.destroy_pips, pip_id, g_gfx_alloc);
+    if (rizz__pip_cache_release(pip_id)) {
+        rizz__queue_destroy(g_gfx.destroy_pips, pip_id, g_gfx_alloc);
+    }
 }
 
 static void rizz__destroy_shader(sg_shader shd_id)
 {
-    rizz__queue_destroy(g_gfx.destroy_shaders, shd_id, g_gfx_alloc);
+    if (rizz__shader_cache_release(shd_id)) {
+        rizz__queue_destroy(g_gfx.destroy_shaders, shd_id, g_gfx_alloc);
+    }
 }
 
 static void rizz__destroy_pass(sg_pass pass_id)
@@ -4249,8 +4783,8 @@ static void rizz__debug_grid_xzplane(float spacing, float spacing_bold, const sx
     the__core.tmp_alloc_pop();
 }
 
-void rizz__debug_grid_xyplane(float spacing, float spacing_bold, const sx_mat4* vp,
-                              const sx_vec3 frustum[8])
+static void rizz__debug_grid_xyplane(float spacing, float spacing_bold, const sx_mat4* vp,
+                                     const sx_vec3 frustum[8])
 {
     static const sx_color color = { { 170, 170, 170, 255 } };
     static const sx_color bold_color = { { 255, 255, 255, 255 } };
@@ -4397,7 +4931,7 @@ rizz_api_gfx the__gfx = {
     .reset_state_cache          = sg_reset_state_cache,
     .make_buffer                = rizz__make_buffer,
     .make_image                 = sg_make_image,
-    .make_shader                = sg_make_shader,
+    .make_shader                = rizz__make_shader,
     .make_pipeline              = rizz__make_pipeline,
     .make_pass                  = sg_make_pass,
     .destroy_buffer             = rizz__destroy_buffer,
@@ -4422,7 +4956,7 @@ rizz_api_gfx the__gfx = {
     .alloc_pass                 = sg_alloc_pass,
     .init_buffer                = rizz__init_buffer,
     .init_image                 = sg_init_image,
-    .init_shader                = sg_init_shader,
+    .init_shader                = rizz__init_shader,
     .init_pipeline              = rizz__init_pipeline,
     .init_pass                  = sg_init_pass,
     .fail_buffer                = sg_fail_buffer,
@@ -2,7 +2,17 @@
 // Copyright 2019 Sepehr Taghdisian (septag@github). All rights reserved.
 // License: https://github.com/septag/rizz#license-bsd-2-clause
 //
-
+// http/1.1 client: requests are processed on a network thread that polls all the connections.
+// connections are kept alive and pooled per host, responses can be read as a whole or streamed.
+// main thread and network thread only communicate through spsc queues:
+//      - cmd_queue (main -> net): submit and cancel requests
+//      - res_queue (net -> main): streamed pieces of data, finished and cancelled requests
+// host names are resolved on a separate resolver thread, because getaddrinfo blocks:
+//      - dns_queue (net -> resolver): hosts to resolve
+//      - dns_res_queue (resolver -> net): resolved addresses, net thread is woken up after each
+// the request objects are owned by the network thread while they are in flight, the main thread
+// only touches `state` and the callbacks until the request is finished (HTTP_RESULT_DONE)
+//
 #include "rizz/http.h"
 #include "config.h"
 #include "rizz/core.h"
@@ -10,309 +20,1241 @@
 #include "sx/allocator.h"
 #include "sx/array.h"
 #include "sx/handle.h"
+#include "sx/lockless.h"
 #include "sx/string.h"
+#include "sx/threads.h"
+#include "sx/timer.h"
 
-#define HTTP_IMPLEMENTATION
-#define HTTP_MALLOC(ctx, size) (sx_malloc((const sx_alloc*)ctx, size))
-#define HTTP_FREE(ctx, ptr) (sx_free((const sx_alloc*)ctx, ptr))
-SX_PRAGMA_DIAGNOSTIC_PUSH()
-SX_PRAGMA_DIAGNOSTIC_IGNORED_CLANG_GCC("-Wunused-variable")
-SX_PRAGMA_DIAGNOSTIC_IGNORED_CLANG("-Wshorten-64-to-32")
-#if SX_PLATFORM_ANDROID
-#    include <linux/in.h>
+#if SX_PLATFORM_WINDOWS
+#    include <winsock2.h>
+#    include <ws2tcpip.h>
+#    pragma comment(lib, "ws2_32.lib")
+typedef SOCKET rizz__socket;
+#    define RIZZ__INVALID_SOCKET INVALID_SOCKET
+#    define RIZZ__SEND_FLAGS 0
+#    define rizz__poll(_fds, _n, _msecs) WSAPoll((_fds), (ULONG)(_n), (_msecs))
+#    define rizz__close_socket(_sock) closesocket(_sock)
+#    define rizz__would_block() (WSAGetLastError() == WSAEWOULDBLOCK)
+#else
+#    include <errno.h>
+#    include <fcntl.h>
+#    include <netdb.h>
+#    include <netinet/in.h>
+#    include <netinet/tcp.h>
+#    include <poll.h>
+#    include <sys/socket.h>
+#    include <unistd.h>
+typedef int rizz__socket;
+#    define RIZZ__INVALID_SOCKET -1
+#    ifdef MSG_NOSIGNAL
+#        define RIZZ__SEND_FLAGS MSG_NOSIGNAL
+#    else
+#        define RIZZ__SEND_FLAGS 0
+#    endif
+#    define rizz__poll(_fds, _n, _msecs) poll((_fds), (nfds_t)(_n), (_msecs))
+#    define rizz__close_socket(_sock) close(_sock)
+#    define rizz__would_block() (errno == EWOULDBLOCK || errno == EAGAIN || errno == EINPROGRESS)
 #endif
-#include "mattias/http.h"
-SX_PRAGMA_DIAGNOSTIC_POP();
 
-typedef enum { HTTP_MODE_NONE, HTTP_MODE_GET, HTTP_MODE_POST } rizz__http_mode;
+#define HTTP_MAX_HEADER_SIZE 0x10000
+#define HTTP_RECV_SIZE 0x4000
+#define HTTP_POLL_INTERVAL 1000    // msecs, timeouts are checked in this interval
 
-typedef struct {
-    char* url;
+typedef enum { HTTP_MODE_GET, HTTP_MODE_POST } rizz__http_mode;
+
+typedef enum {
+    HTTP_CONN_CONNECTING = 0,
+    HTTP_CONN_SENDING,
+    HTTP_CONN_RECV_HEADER,
+    HTTP_CONN_RECV_BODY,          // content-length
+    HTTP_CONN_RECV_CHUNK_SIZE,    // transfer-encoding: chunked
+    HTTP_CONN_RECV_CHUNK_DATA,
+    HTTP_CONN_RECV_CHUNK_END,
+    HTTP_CONN_RECV_TRAILER,
+    HTTP_CONN_RECV_UNTIL_CLOSE,    // no content-length, body ends when server closes connection
+    HTTP_CONN_IDLE
+} rizz__http_conn_state;
+
+typedef enum { HTTP_COMMAND_SUBMIT, HTTP_COMMAND_CANCEL } rizz__http_command_type;
+
+typedef enum {
+    HTTP_RESULT_DATA = 0,    // piece of streamed response body
+    HTTP_RESULT_DONE,        // request is finished, ownership goes back to main thread
+    HTTP_RESULT_CANCELLED    // answer to HTTP_COMMAND_CANCEL, request can be freed
+} rizz__http_result_type;
+
+typedef struct rizz__http_host rizz__http_host;
+typedef struct rizz__http_conn rizz__http_conn;
+
+typedef struct rizz__http_request {
+    // main thread
+    rizz_http handle;
+    rizz_http_state state;
+    rizz_http_cb* callback;
+    rizz_http_data_cb* data_cb;
+    void* user;
+    bool done;     // received HTTP_RESULT_DONE
+    bool freed;    // freed by user while in flight, waiting for HTTP_RESULT_CANCELLED
+
+    // immutable request data, allocated with the request
     rizz__http_mode mode;
-    void* data;
+    char* host;    // NULL if url is invalid
+    char* path;
+    const char* headers;    // extra request header lines, NULL if there are none
+    const void* post_data;
+    size_t post_size;
+    uint16_t port;
+
+    // network thread
+    rizz__http_host* h;
+    rizz__http_conn* conn;
+    struct rizz__http_request* next;    // host queue
+    uint8_t* body;                      // sx_array (non-streamed requests)
+    size_t num_received;
+    int status_code;
+    int retries;
+    bool finished;
+    bool failed;
+    char reason_phrase[64];
+    char content_type[128];
+    char* resp_headers;    // sx_array: response header lines (null-terminated)
+} rizz__http_request;
+
+typedef struct rizz__http_conn {
+    rizz__socket sock;
+    rizz__http_conn_state state;
+    rizz__http_host* host;
+    rizz__http_request* req;
+    char* send_buff;       // sx_array: request header + post data
+    int send_offset;
+    uint8_t* recv_buff;    // sx_array
+    int recv_offset;       // parsed bytes of recv_buff
+    int64_t remain;        // remaining bytes of body or current chunk
+    double last_tm;        // last activity
+    bool keep_alive;
+    bool reused;    // request is sent over a kept-alive connection, retry if it's closed early
+    struct rizz__http_conn* next;    // host idle list
+} rizz__http_conn;
+
+typedef enum {
+    HTTP_DNS_NONE = 0,
+    HTTP_DNS_RESOLVING,
+    HTTP_DNS_RESOLVED
+} rizz__http_dns_state;
+
+typedef struct rizz__http_host {
+    char name[256];
+    uint16_t port;
+    rizz__http_dns_state dns;
+    struct sockaddr_storage addr;
+    int addr_len;
+    int num_conns;                      // idle + busy
+    rizz__http_conn* idle;              // idle keep-alive connections
+    rizz__http_request* queue_first;    // requests waiting for a connection (fifo)
+    rizz__http_request* queue_last;
+} rizz__http_host;
+
+typedef struct {
+    rizz__http_command_type type;
+    rizz__http_request* req;
+} rizz__http_command;
+
+typedef struct {
+    rizz__http_result_type type;
+    rizz__http_request* req;
+    void* data;    // HTTP_RESULT_DATA: freed by main thread after delivery
     size_t size;
-} rizz__http_request_params;
+} rizz__http_result;
 
 typedef struct {
-    http_t* h;
-    rizz__http_request_params* params;    // optional: only allocated for inactive objects
-    rizz_http_cb* callback;
-    void* callback_user;
-} rizz__http;
+    rizz__http_host* host;
+    bool ok;
+    int addr_len;
+    struct sockaddr_storage addr;
+} rizz__http_dns_result;
 
 typedef struct {
     const sx_alloc* alloc;
-    sx_handle_pool* http_handles;    // rizz__http
-    rizz__http* https;               // sx_array
-    rizz_http pending[RIZZ_CONFIG_MAX_HTTP_REQUESTS];
-    int num_pending;
+    sx_handle_pool* http_handles;    // rizz__http_request
+    rizz__http_request** reqs;       // sx_array: indexed by handle
+    sx_thread* thrd;
+    sx_queue_spsc* cmd_queue;    // producer: main, consumer: net thread, data: rizz__http_command
+    sx_queue_spsc* res_queue;    // producer: net thread, consumer: main, data: rizz__http_result
+    rizz__socket wake_sock;      // loopback udp socket, wakes up net thread's poll
+    struct sockaddr_in wake_addr;
+    int quit;
+
+    // resolver thread
+    sx_thread* dns_thrd;
+    sx_sem dns_sem;
+    sx_queue_spsc* dns_queue;        // producer: net thread, consumer: resolver, data: host ptr
+    sx_queue_spsc* dns_res_queue;    // producer: resolver, consumer: net thread
+
+    // network thread
+    rizz__http_host** hosts;     // sx_array
+    rizz__http_conn** conns;     // sx_array: all open connections
+    struct pollfd* pollfds;      // sx_array: [0] = wake_sock, [1..] = conns
+    int num_busy;
 } rizz__http_context;
 
 static rizz__http_context g_http;
 
-bool rizz__http_init(const sx_alloc* alloc)
+static bool rizz__http_set_nonblocking(rizz__socket sock)
 {
-    g_http.alloc = alloc;
-    g_http.http_handles = sx_handle_create_pool(alloc, RIZZ_CONFIG_MAX_HTTP_REQUESTS);
-    if (!g_http.http_handles)
-        return false;
+#if SX_PLATFORM_WINDOWS
+    u_long nonblocking = 1;
+    return ioctlsocket(sock, FIONBIO, &nonblocking) == 0;
+#else
+    int flags = fcntl(sock, F_GETFL, 0);
+    return flags != -1 && fcntl(sock, F_SETFL, flags | O_NONBLOCK) != -1;
+#endif
+}
 
-    return true;
+static void rizz__http_push_result(rizz__http_result_type type, rizz__http_request* req,
+                                   void* data, size_t size)
+{
+    rizz__http_result res = { .type = type, .req = req, .data = data, .size = size };
+    sx_queue_spsc_produce_and_grow(g_http.res_queue, &res, g_http.alloc);
 }
 
-void rizz__http_release()
+static void rizz__http_finish(rizz__http_request* req, bool failed)
 {
-    if (g_http.alloc) {
-        // remove remaining http requests
-        if (g_http.http_handles) {
-            for (int i = 0; i < g_http.http_handles->count; i++) {
-                sx_handle_t handle = sx_handle_at(g_http.http_handles, i);
-                rizz__http* http = &g_http.https[sx_handle_index(handle)];
-                if (http->h) {
-                    rizz_log_warn("un-freed active http request: 0x%p", http->h);
-                    http_release(http->h);
-                } else if (http->params) {
-                    rizz_log_warn("un-freed http request: %s", http->params->url);
-                    sx_free(g_http.alloc, http->params);
-                }
+    sx_assert(!req->finished);
+    req->finished = true;
+    req->failed = failed;
+    req->conn = NULL;
+    rizz__http_push_result(HTTP_RESULT_DONE, req, NULL, 0);
+}
+
+static void rizz__http_deliver(rizz__http_request* req, const void* data, int size)
+{
+    if (size <= 0)
+        return;
+    req->num_received += (size_t)size;
+    if (req->data_cb) {
+        void* piece = sx_malloc(g_http.alloc, (size_t)size);
+        if (!piece) {
+            sx_out_of_memory();
+            return;
+        }
+        sx_memcpy(piece, data, size);
+        rizz__http_push_result(HTTP_RESULT_DATA, req, piece, (size_t)size);
+    } else {
+        sx_memcpy(sx_array_add(g_http.alloc, req->body, size), data, size);
+    }
+}
+
+static rizz__http_host* rizz__http_find_host(const char* name, uint16_t port)
+{
+    for (int i = 0, c = sx_array_count(g_http.hosts); i < c; i++) {
+        rizz__http_host* host = g_http.hosts[i];
+        if (host->port == port && sx_strequalnocase(host->name, name))
+            return host;
+    }
+
+    rizz__http_host* host = sx_malloc(g_http.alloc, sizeof(rizz__http_host));
+    if (!host) {
+        sx_out_of_memory();
+        return NULL;
+    }
+    sx_memset(host, 0x0, sizeof(rizz__http_host));
+    sx_strcpy(host->name, sizeof(host->name), name);
+    host->port = port;
+    sx_array_push(g_http.alloc, g_http.hosts, host);
+    return host;
+}
+
+static void rizz__http_wake();
+
+// resolver thread: the hosts are owned by the network thread, only `name` and `port` are read here
+static int rizz__http_dns_thread(void* user1, void* user2)
+{
+    sx_unused(user1);
+    sx_unused(user2);
+
+    while (!g_http.quit) {
+        sx_semaphore_wait(&g_http.dns_sem, -1);
+
+        rizz__http_host* host;
+        while (!g_http.quit && sx_queue_spsc_consume(g_http.dns_queue, &host)) {
+            rizz__http_dns_result res = { .host = host };
+            char port_str[8];
+            sx_snprintf(port_str, sizeof(port_str), "%u", host->port);
+            struct addrinfo hints = { .ai_family = AF_UNSPEC, .ai_socktype = SOCK_STREAM };
+            struct addrinfo* addrs = NULL;
+            if (getaddrinfo(host->name, port_str, &hints, &addrs) == 0 && addrs) {
+                sx_memcpy(&res.addr, addrs->ai_addr, addrs->ai_addrlen);
+                res.addr_len = (int)addrs->ai_addrlen;
+                res.ok = true;
+                freeaddrinfo(addrs);
             }
 
-            sx_handle_destroy_pool(g_http.http_handles, g_http.alloc);
+            sx_queue_spsc_produce_and_grow(g_http.dns_res_queue, &res, g_http.alloc);
+            rizz__http_wake();
         }
+    }
+
+    rizz__core_thread_exit();
+    return 0;
+}
 
-        sx_array_free(g_http.alloc, g_http.https);
-        sx_memset(&g_http, 0x0, sizeof(g_http));
+// starts resolving the host on the resolver thread, returns true if the address is ready
+static bool rizz__http_resolve(rizz__http_host* host)
+{
+    if (host->dns == HTTP_DNS_NONE) {
+        host->dns = HTTP_DNS_RESOLVING;
+        sx_queue_spsc_produce_and_grow(g_http.dns_queue, &host, g_http.alloc);
+        sx_semaphore_post(&g_http.dns_sem, 1);
     }
+    return host->dns == HTTP_DNS_RESOLVED;
 }
 
-void rizz__http_update()
+static void rizz__http_process_dns_results()
 {
-    int remove_list[RIZZ_CONFIG_MAX_HTTP_REQUESTS];
-    int num_removes = 0;
+    rizz__http_dns_result res;
+    while (sx_queue_spsc_consume(g_http.dns_res_queue, &res)) {
+        rizz__http_host* host = res.host;
+        if (res.ok) {
+            sx_memcpy(&host->addr, &res.addr, res.addr_len);
+            host->addr_len = res.addr_len;
+            host->dns = HTTP_DNS_RESOLVED;
+        } else {
+            // fail the waiting requests, next request to this host resolves it again
+            host->dns = HTTP_DNS_NONE;
+            while (host->queue_first) {
+                rizz__http_request* req = host->queue_first;
+                host->queue_first = req->next;
+                req->next = NULL;
+                rizz__http_finish(req, true);
+            }
+            host->queue_last = NULL;
+        }
+    }
+}
+
+static void rizz__http_remove_idle(rizz__http_conn* conn)
+{
+    rizz__http_host* host = conn->host;
+    rizz__http_conn* prev = NULL;
+    for (rizz__http_conn* c = host->idle; c; prev = c, c = c->next) {
+        if (c == conn) {
+            if (prev)
+                prev->next = c->next;
+            else
+                host->idle = c->next;
+            break;
+        }
+    }
+    conn->next = NULL;
+}
 
-    // process pending
-    // for callback requests, call the callback and release the request automatically
-    for (int i = 0, c = g_http.num_pending; i < c; i++) {
-        rizz_http handle = g_http.pending[i];
-        rizz__http* http = &g_http.https[sx_handle_index(handle.id)];
-        sx_assert(http->h);
-        if (http->h->status != HTTP_STATUS_PENDING)
+static void rizz__http_close(rizz__http_conn* conn)
+{
+    if (conn->state == HTTP_CONN_IDLE)
+        rizz__http_remove_idle(conn);
+    else if (conn->req)
+        --g_http.num_busy;
+
+    for (int i = 0, c = sx_array_count(g_http.conns); i < c; i++) {
+        if (g_http.conns[i] == conn) {
+            sx_array_pop(g_http.conns, i);
+            break;
+        }
+    }
+
+    --conn->host->num_conns;
+    rizz__close_socket(conn->sock);
+    sx_array_free(g_http.alloc, conn->send_buff);
+    sx_array_free(g_http.alloc, conn->recv_buff);
+    sx_free(g_http.alloc, conn);
+}
+
+static rizz__http_conn* rizz__http_connect(rizz__http_host* host, double now)
+{
+    rizz__socket sock = socket(host->addr.ss_family, SOCK_STREAM, IPPROTO_TCP);
+    if (sock == RIZZ__INVALID_SOCKET)
+        return NULL;
+
+    int nodelay = 1;
+    setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, (const char*)&nodelay, sizeof(nodelay));
+#ifdef SO_NOSIGPIPE
+    int nosigpipe = 1;
+    setsockopt(sock, SOL_SOCKET, SO_NOSIGPIPE, (const char*)&nosigpipe, sizeof(nosigpipe));
+#endif
+    if (!rizz__http_set_nonblocking(sock) ||
+        (connect(sock, (const struct sockaddr*)&host->addr, host->addr_len) != 0 &&
+         !rizz__would_block())) {
+        rizz__close_socket(sock);
+        return NULL;
+    }
+
+    rizz__http_conn* conn = sx_malloc(g_http.alloc, sizeof(rizz__http_conn));
+    if (!conn) {
+        rizz__close_socket(sock);
+        sx_out_of_memory();
+        return NULL;
+    }
+    sx_memset(conn, 0x0, sizeof(rizz__http_conn));
+    conn->sock = sock;
+    conn->state = HTTP_CONN_CONNECTING;
+    conn->host = host;
+    conn->last_tm = now;
+    ++host->num_conns;
+    sx_array_push(g_http.alloc, g_http.conns, conn);
+    return conn;
+}
+
+static void rizz__http_append(char** buff, const char* str)
+{
+    int len = sx_strlen(str);
+    sx_memcpy(sx_array_add(g_http.alloc, *buff, len), str, len);
+}
+
+static void rizz__http_send(rizz__http_conn* conn, rizz__http_request* req, double now)
+{
+    conn->req = req;
+    req->conn = conn;
+    ++g_http.num_busy;
+
+    char line[320];
+    sx_array_clear(conn->send_buff);
+    rizz__http_append(&conn->send_buff, req->mode == HTTP_MODE_POST ? "POST " : "GET ");
+    rizz__http_append(&conn->send_buff, req->path);
+    if (req->port != 80)
+        sx_snprintf(line, sizeof(line), " HTTP/1.1\r\nHost: %s:%u\r\n", req->host, req->port);
+    else
+        sx_snprintf(line, sizeof(line), " HTTP/1.1\r\nHost: %s\r\n", req->host);
+    rizz__http_append(&conn->send_buff, line);
+    rizz__http_append(&conn->send_buff, "Connection: keep-alive\r\nAccept-Encoding: identity\r\n");
+    if (req->headers)
+        rizz__http_append(&conn->send_buff, req->headers);
+    if (req->mode == HTTP_MODE_POST) {
+        sx_snprintf(line, sizeof(line), "Content-Length: %u\r\n\r\n", (uint32_t)req->post_size);
+        rizz__http_append(&conn->send_buff, line);
+        if (req->post_size > 0) {
+            sx_memcpy(sx_array_add(g_http.alloc, conn->send_buff, (int)req->post_size),
+                      req->post_data, req->post_size);
+        }
+    } else {
+        rizz__http_append(&conn->send_buff, "\r\n");
+    }
+
+    conn->send_offset = 0;
+    sx_array_clear(conn->recv_buff);
+    conn->recv_offset = 0;
+    conn->remain = 0;
+    conn->keep_alive = false;
+    conn->last_tm = now;
+    conn->reused = conn->state == HTTP_CONN_IDLE;
+    if (conn->reused)
+        conn->state = HTTP_CONN_SENDING;
+}
+
+// releases the connection of a finished request, it will be reused if the server allows it
+static void rizz__http_release_conn(rizz__http_conn* conn, double now)
+{
+    bool keep_alive =
+        conn->keep_alive && conn->recv_offset == sx_array_count(conn->recv_buff) && !g_http.quit;
+    if (keep_alive) {
+        --g_http.num_busy;
+        conn->req = NULL;
+        conn->state = HTTP_CONN_IDLE;
+        conn->last_tm = now;
+        conn->next = conn->host->idle;
+        conn->host->idle = conn;
+    } else {
+        rizz__http_close(conn);
+    }
+}
+
+// failed connections retry their request once on a new connection if the failure happened on a
+// kept-alive connection before receiving anything (server closed the idle connection)
+static void rizz__http_fail(rizz__http_conn* conn)
+{
+    rizz__http_request* req = conn->req;
+    bool retry = conn->reused && req->retries == 0 && req->num_received == 0 &&
+                 sx_array_count(conn->recv_buff) == 0;
+    rizz__http_close(conn);
+
+    if (retry) {
+        ++req->retries;
+        req->conn = NULL;
+        rizz__http_host* host = req->h;
+        req->next = host->queue_first;
+        host->queue_first = req;
+        if (!host->queue_last)
+            host->queue_last = req;
+    } else {
+        rizz__http_finish(req, true);
+    }
+}
+
+static bool rizz__http_parse_header(rizz__http_conn* conn, char* header)
+{
+    rizz__http_request* req = conn->req;
+
+    // status line: HTTP/1.x <code> <reason>
+    if (!sx_strnequal(header, "HTTP/1.", 7) || !sx_isnumchar(header[7]))
+        return false;
+    int minor = header[7] - '0';
+    const char* code = sx_skip_whitespace(header + 8);
+    req->status_code = sx_toint(code);
+    char* eol = (char*)sx_strstr(header, "\r\n");
+    if (eol)
+        *eol = '\0';
+    sx_strcpy(req->reason_phrase, sizeof(req->reason_phrase),
+              sx_skip_whitespace(sx_skip_word(code)));
+
+    int64_t content_len = -1;
+    bool chunked = false;
+    conn->keep_alive = minor >= 1;
+    sx_array_clear(req->resp_headers);
+    for (char* line = eol ? eol + 2 : NULL; line && line[0]; line = eol ? eol + 2 : NULL) {
+        eol = (char*)sx_strstr(line, "\r\n");
+        if (eol)
+            *eol = '\0';
+        char* value = (char*)sx_strchar(line, ':');
+        if (!value)
             continue;
+        *value = '\0';
+        value = (char*)sx_skip_whitespace(value + 1);
 
-        http_status_t status = http_process(http->h);
-        if (status != HTTP_STATUS_PENDING && http->callback) {
-            http->callback((const rizz_http_state*)http->h, http->callback_user);
-            sx_assert(http->h && "must not `free` inside callback");
-            http_release(http->h);
-            http->h = NULL;
+        // keep a normalized copy of each header line for `rizz_api_http.header`
+        rizz__http_append(&req->resp_headers, line);
+        rizz__http_append(&req->resp_headers, ": ");
+        rizz__http_append(&req->resp_headers, value);
+        rizz__http_append(&req->resp_headers, "\r\n");
 
-            remove_list[num_removes++] = i;
+        if (sx_strequalnocase(line, "content-length")) {
+            content_len = (int64_t)sx_touint(value);
+        } else if (sx_strequalnocase(line, "transfer-encoding")) {
+            char encoding[32];
+            sx_tolower(encoding, sizeof(encoding), value);
+            chunked = sx_strstr(encoding, "chunked") != NULL;
+        } else if (sx_strequalnocase(line, "connection")) {
+            if (sx_strnequalnocase(value, "close", 5))
+                conn->keep_alive = false;
+            else if (sx_strnequalnocase(value, "keep-alive", 10))
+                conn->keep_alive = true;
+        } else if (sx_strequalnocase(line, "content-type")) {
+            sx_strcpy(req->content_type, sizeof(req->content_type), value);
         }
     }
 
-    // remove finished requests
-    // this applies to callbacks only, because non-callbacks should be freed by user manually
-    for (int i = 0; i < num_removes; i++) {
-        int index = remove_list[i];
-        sx_handle_del(g_http.http_handles, g_http.pending[index].id);
-        sx_swap(g_http.pending[index], g_http.pending[g_http.num_pending - 1], rizz_http);
-        --g_http.num_pending;
+    if ((req->status_code >= 100 && req->status_code < 200) || req->status_code == 204 ||
+        req->status_code == 304) {
+        conn->remain = 0;
+        conn->state = HTTP_CONN_RECV_BODY;
+    } else if (chunked) {
+        conn->state = HTTP_CONN_RECV_CHUNK_SIZE;
+    } else if (content_len >= 0) {
+        conn->remain = content_len;
+        conn->state = HTTP_CONN_RECV_BODY;
+        if (!req->data_cb && content_len > 0)
+            sx_array_reserve(g_http.alloc, req->body, (int)content_len);
+    } else {
+        conn->keep_alive = false;
+        conn->state = HTTP_CONN_RECV_UNTIL_CLOSE;
     }
+    sx_array_push(g_http.alloc, req->resp_headers, '\0');
+    return true;
+}
 
-    // check if we have new requests to start
-    while (g_http.num_pending < RIZZ_CONFIG_MAX_HTTP_REQUESTS) {
-        // find an inactive handle in order to start new request
-        rizz_http inactive_handle = { 0 };
-        for (int i = 0, c = g_http.http_handles->count; i < c; i++) {
-            rizz_http handle = (rizz_http){ .id = sx_handle_at(g_http.http_handles, i) };
-            if (g_http.https[sx_handle_index(handle.id)].params) {
-                inactive_handle = handle;
-                break;
+static int rizz__http_find_crlf(const uint8_t* data, int size, bool double_crlf)
+{
+    int len = double_crlf ? 4 : 2;
+    for (int i = 0; i + len <= size; i++) {
+        if (data[i] == '\r' && data[i + 1] == '\n' &&
+            (!double_crlf || (data[i + 2] == '\r' && data[i + 3] == '\n'))) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// returns 1 if the response is complete, 0 if more data is needed and -1 on errors
+static int rizz__http_parse(rizz__http_conn* conn)
+{
+    rizz__http_request* req = conn->req;
+    for (;;) {
+        uint8_t* data = conn->recv_buff + conn->recv_offset;
+        int size = sx_array_count(conn->recv_buff) - conn->recv_offset;
+
+        switch (conn->state) {
+        case HTTP_CONN_RECV_HEADER: {
+            int end = rizz__http_find_crlf(data, size, true);
+            if (end < 0)
+                return size > HTTP_MAX_HEADER_SIZE ? -1 : 0;
+            data[end + 2] = '\0';    // keep the last crlf for the line parser
+            conn->recv_offset += end + 4;
+            if (!rizz__http_parse_header(conn, (char*)data))
+                return -1;
+            // skip informational responses (100-continue)
+            if (req->status_code >= 100 && req->status_code < 200)
+                conn->state = HTTP_CONN_RECV_HEADER;
+            break;
+        }
+
+        case HTTP_CONN_RECV_BODY: {
+            int n = (int)sx_min((int64_t)size, conn->remain);
+            rizz__http_deliver(req, data, n);
+            conn->recv_offset += n;
+            conn->remain -= n;
+            return conn->remain == 0 ? 1 : 0;
+        }
+
+        case HTTP_CONN_RECV_CHUNK_SIZE: {
+            int end = rizz__http_find_crlf(data, size, false);
+            if (end < 0)
+                return size > HTTP_MAX_HEADER_SIZE ? -1 : 0;
+            int64_t chunk_size = 0;
+            int digits = 0;
+            for (int i = 0; i < end && sx_ishexchar((char)data[i]); i++, digits++) {
+                char ch = sx_tolowerchar((char)data[i]);
+                chunk_size = (chunk_size << 4) | (ch <= '9' ? ch - '0' : ch - 'a' + 10);
             }
+            if (digits == 0 || digits > 15)
+                return -1;
+            conn->recv_offset += end + 2;
+            conn->remain = chunk_size;
+            conn->state = chunk_size > 0 ? HTTP_CONN_RECV_CHUNK_DATA : HTTP_CONN_RECV_TRAILER;
+            break;
         }
 
-        if (!inactive_handle.id)
+        case HTTP_CONN_RECV_CHUNK_DATA: {
+            int n = (int)sx_min((int64_t)size, conn->remain);
+            rizz__http_deliver(req, data, n);
+            conn->recv_offset += n;
+            conn->remain -= n;
+            if (conn->remain > 0)
+                return 0;
+            conn->state = HTTP_CONN_RECV_CHUNK_END;
             break;
+        }
 
-        rizz__http* http = &g_http.https[sx_handle_index(inactive_handle.id)];
-        const rizz__http_request_params* params = http->params;
-        switch (params->mode) {
-        case HTTP_MODE_GET:
-            http->h = http_get(params->url, (void*)g_http.alloc);
+        case HTTP_CONN_RECV_CHUNK_END:
+            if (size < 2)
+                return 0;
+            if (data[0] != '\r' || data[1] != '\n')
+                return -1;
+            conn->recv_offset += 2;
+            conn->state = HTTP_CONN_RECV_CHUNK_SIZE;
             break;
 
-        case HTTP_MODE_POST:
-            http->h = http_post(params->url, params->data, params->size, (void*)g_http.alloc);
+        case HTTP_CONN_RECV_TRAILER: {
+            int end = rizz__http_find_crlf(data, size, false);
+            if (end < 0)
+                return size > HTTP_MAX_HEADER_SIZE ? -1 : 0;
+            conn->recv_offset += end + 2;
+            if (end == 0)
+                return 1;
             break;
+        }
+
+        case HTTP_CONN_RECV_UNTIL_CLOSE:
+            rizz__http_deliver(req, data, size);
+            conn->recv_offset += size;
+            return 0;
 
         default:
-            sx_assert(0);
-            break;
+            sx_assert(0 && "invalid connection state");
+            return -1;
         }
-        sx_free(g_http.alloc, http->params);
-        http->params = NULL;
-        g_http.pending[g_http.num_pending++] = inactive_handle;
     }
 }
 
-static rizz__http_request_params* rizz__http_alloc_params(const char* url, rizz__http_mode mode,
-                                                          const void* data, size_t size)
+static void rizz__http_update_conn(rizz__http_conn* conn, short revents, double now)
 {
-    int url_size = sx_strlen(url) + 1;
-    size_t total_sz = sizeof(rizz__http_request_params) + url_size + size;
-    uint8_t* buff = sx_malloc(g_http.alloc, total_sz);
-    if (!buff) {
-        sx_out_of_memory();
-        return NULL;
+    if (conn->state == HTTP_CONN_IDLE) {
+        // idle connections must not receive anything, server has closed them
+        if (revents)
+            rizz__http_close(conn);
+        return;
     }
 
-    rizz__http_request_params* p = (rizz__http_request_params*)buff;
-    buff += sizeof(rizz__http_request_params);
+    if (conn->state == HTTP_CONN_CONNECTING) {
+        if (!(revents & (POLLOUT | POLLERR | POLLHUP)))
+            return;
+        int err = 0;
+        socklen_t err_len = sizeof(err);
+        if (getsockopt(conn->sock, SOL_SOCKET, SO_ERROR, (char*)&err, &err_len) != 0 || err != 0) {
+            rizz__http_fail(conn);
+            return;
+        }
+        conn->state = HTTP_CONN_SENDING;
+    }
+
+    if (conn->state == HTTP_CONN_SENDING) {
+        int total = sx_array_count(conn->send_buff);
+        while (conn->send_offset < total) {
+            int r = (int)send(conn->sock, conn->send_buff + conn->send_offset,
+                              total - conn->send_offset, RIZZ__SEND_FLAGS);
+            if (r > 0) {
+                conn->send_offset += r;
+                conn->last_tm = now;
+            } else if (r < 0 && rizz__would_block()) {
+                return;
+            } else {
+                rizz__http_fail(conn);
+                return;
+            }
+        }
+        conn->state = HTTP_CONN_RECV_HEADER;
+        return;
+    }
 
-    p->url = (char*)buff;
-    buff += url_size;
-    sx_memcpy(p->url, url, url_size);
+    if (!(revents & (POLLIN | POLLERR | POLLHUP)))
+        return;
 
-    p->mode = mode;
-    p->size = size;
-    if (data) {
-        p->data = buff;
-        sx_memcpy(p->data, data, size);
+    // compact parsed data before receiving more
+    if (conn->recv_offset > 0) {
+        int count = sx_array_count(conn->recv_buff) - conn->recv_offset;
+        sx_memmove(conn->recv_buff, conn->recv_buff + conn->recv_offset, count);
+        sx_array_pop_lastn(conn->recv_buff, sx_array_count(conn->recv_buff) - count);
+        conn->recv_offset = 0;
     }
 
-    return p;
+    for (;;) {
+        uint8_t* buff = sx_array_add(g_http.alloc, conn->recv_buff, HTTP_RECV_SIZE);
+        int r = (int)recv(conn->sock, (char*)buff, HTTP_RECV_SIZE, 0);
+        sx_array_pop_lastn(conn->recv_buff, HTTP_RECV_SIZE - sx_max(r, 0));
+        if (r > 0) {
+            conn->last_tm = now;
+            int pr = rizz__http_parse(conn);
+            if (pr < 0) {
+                rizz__http_fail(conn);
+                return;
+            } else if (pr > 0) {
+                rizz__http_request* req = conn->req;
+                rizz__http_release_conn(conn, now);
+                rizz__http_finish(req, false);
+                return;
+            }
+        } else if (r == 0) {
+            // connection closed by server, this is the end of body for responses without length
+            rizz__http_request* req = conn->req;
+            if (conn->state == HTTP_CONN_RECV_UNTIL_CLOSE) {
+                rizz__http_close(conn);
+                rizz__http_finish(req, false);
+            } else {
+                rizz__http_fail(conn);
+            }
+            return;
+        } else {
+            if (!rizz__would_block())
+                rizz__http_fail(conn);
+            return;
+        }
+    }
 }
 
-static rizz_http rizz__http_get(const char* url)
+static void rizz__http_process_commands()
 {
-    sx_assert(g_http.alloc);
+    rizz__http_command cmd;
+    while (sx_queue_spsc_consume(g_http.cmd_queue, &cmd)) {
+        rizz__http_request* req = cmd.req;
+        switch (cmd.type) {
+        case HTTP_COMMAND_SUBMIT: {
+            rizz__http_host* host = req->host ? rizz__http_find_host(req->host, req->port) : NULL;
+            if (!host) {
+                rizz__http_finish(req, true);
+                break;
+            }
+            req->h = host;
+            if (host->queue_last)
+                host->queue_last->next = req;
+            else
+                host->queue_first = req;
+            host->queue_last = req;
+            break;
+        }
 
-    rizz_http handle =
-        (rizz_http){ .id = sx_handle_new_and_grow(g_http.http_handles, g_http.alloc) };
-    sx_assert(handle.id);
-    rizz__http _http = (rizz__http){ 0 };
+        case HTTP_COMMAND_CANCEL:
+            if (!req->finished) {
+                if (req->conn) {
+                    rizz__http_close(req->conn);
+                } else {
+                    // still waiting in the host queue
+                    rizz__http_host* host = req->h;
+                    rizz__http_request* prev = NULL;
+                    for (rizz__http_request* r = host->queue_first; r; prev = r, r = r->next) {
+                        if (r == req) {
+                            if (prev)
+                                prev->next = r->next;
+                            else
+                                host->queue_first = r->next;
+                            if (host->queue_last == r)
+                                host->queue_last = prev;
+                            break;
+                        }
+                    }
+                }
+                req->finished = true;
+            }
+            rizz__http_push_result(HTTP_RESULT_CANCELLED, req, NULL, 0);
+            break;
+        }
+    }
+}
 
-    if (g_http.num_pending < RIZZ_CONFIG_MAX_HTTP_REQUESTS) {
-        _http.h = http_get(url, (void*)g_http.alloc);
-        g_http.pending[g_http.num_pending++] = handle;
-    } else {
-        _http.params = rizz__http_alloc_params(url, HTTP_MODE_GET, NULL, 0);
+// assigns queued requests to idle connections or opens new ones within the limits
+static void rizz__http_start_requests(double now)
+{
+    for (int i = 0, c = sx_array_count(g_http.hosts); i < c; i++) {
+        rizz__http_host* host = g_http.hosts[i];
+        while (host->queue_first && g_http.num_busy < RIZZ_CONFIG_MAX_HTTP_REQUESTS) {
+            rizz__http_conn* conn = host->idle;
+            if (conn) {
+                host->idle = conn->next;
+                conn->next = NULL;
+            } else if (host->num_conns < RIZZ_CONFIG_HTTP_MAX_CONNECTIONS_PER_HOST) {
+                // requests stay in the queue until the host is resolved
+                if (!rizz__http_resolve(host))
+                    break;
+                conn = rizz__http_connect(host, now);
+            } else {
+                break;
+            }
+
+            rizz__http_request* req = host->queue_first;
+            host->queue_first = req->next;
+            if (!host->queue_first)
+                host->queue_last = NULL;
+            req->next = NULL;
+
+            if (conn) {
+                rizz__http_send(conn, req, now);
+            } else {
+                rizz__http_finish(req, true);
+            }
+        }
     }
+}
 
-    int index = sx_handle_index(handle.id);
-    if (index >= sx_array_count(g_http.https))
-        sx_array_push(g_http.alloc, g_http.https, _http);
-    else
-        g_http.https[index] = _http;
+static int rizz__http_thread(void* user1, void* user2)
+{
+    sx_unused(user1);
+    sx_unused(user2);
+
+    while (!g_http.quit) {
+        double now = sx_tm_sec(sx_tm_now());
+        rizz__http_process_commands();
+        rizz__http_process_dns_results();
+        rizz__http_start_requests(now);
+
+        int num_conns = sx_array_count(g_http.conns);
+        sx_array_clear(g_http.pollfds);
+        sx_array_push(g_http.alloc, g_http.pollfds,
+                      ((struct pollfd){ .fd = g_http.wake_sock, .events = POLLIN }));
+        for (int i = 0; i < num_conns; i++) {
+            rizz__http_conn* conn = g_http.conns[i];
+            short events = (conn->state == HTTP_CONN_CONNECTING || conn->state == HTTP_CONN_SENDING)
+                               ? POLLOUT
+                               : POLLIN;
+            sx_array_push(g_http.alloc, g_http.pollfds,
+                          ((struct pollfd){ .fd = conn->sock, .events = events }));
+        }
+
+        int r = rizz__poll(g_http.pollfds, num_conns + 1, num_conns > 0 ? HTTP_POLL_INTERVAL : -1);
+        if (r < 0)
+            continue;
+
+        if (g_http.pollfds[0].revents & POLLIN) {
+            char dummy[64];
+            while (recv(g_http.wake_sock, dummy, sizeof(dummy), 0) > 0) {
+            }
+        }
+
+        // iterate backwards, because closed connections are swapped with the last one
+        now = sx_tm_sec(sx_tm_now());
+        for (int i = num_conns - 1; i >= 0; i--) {
+            rizz__http_conn* conn = g_http.conns[i];
+            short revents = g_http.pollfds[i + 1].revents;
+            if (revents) {
+                rizz__http_update_conn(conn, revents, now);
+            } else if (conn->state == HTTP_CONN_IDLE) {
+                if (now - conn->last_tm > RIZZ_CONFIG_HTTP_KEEPALIVE_TIMEOUT)
+                    rizz__http_close(conn);
+            } else if (now - conn->last_tm > RIZZ_CONFIG_HTTP_TIMEOUT) {
+                rizz__http_request* req = conn->req;
+                rizz__http_close(conn);
+                rizz__http_finish(req, true);
+            }
+        }
+    }
 
-    return handle;
+    rizz__core_thread_exit();
+    return 0;
 }
 
-static rizz_http rizz__http_post(const char* url, const void* data, size_t size)
+static void rizz__http_wake()
 {
-    sx_assert(g_http.alloc);
+    char b = 0;
+    sendto(g_http.wake_sock, &b, 1, 0, (const struct sockaddr*)&g_http.wake_addr,
+           sizeof(g_http.wake_addr));
+}
 
-    rizz_http handle =
-        (rizz_http){ .id = sx_handle_new_and_grow(g_http.http_handles, g_http.alloc) };
-    sx_assert(handle.id);
-    rizz__http _http = (rizz__http){ 0 };
+static bool rizz__http_create_wake_socket()
+{
+    g_http.wake_sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (g_http.wake_sock == RIZZ__INVALID_SOCKET)
+        return false;
 
-    if (g_http.num_pending < RIZZ_CONFIG_MAX_HTTP_REQUESTS) {
-        _http.h = http_post(url, data, size, (void*)g_http.alloc);
-        g_http.pending[g_http.num_pending++] = handle;
-    } else {
-        _http.params = rizz__http_alloc_params(url, HTTP_MODE_POST, data, size);
+    struct sockaddr_in addr = { .sin_family = AF_INET };
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t addr_len = sizeof(addr);
+    if (bind(g_http.wake_sock, (const struct sockaddr*)&addr, sizeof(addr)) != 0 ||
+        getsockname(g_http.wake_sock, (struct sockaddr*)&g_http.wake_addr, &addr_len) != 0 ||
+        !rizz__http_set_nonblocking(g_http.wake_sock)) {
+        rizz__close_socket(g_http.wake_sock);
+        g_http.wake_sock = RIZZ__INVALID_SOCKET;
+        return false;
     }
+    return true;
+}
 
-    int index = sx_handle_index(handle.id);
-    if (index >= sx_array_count(g_http.https))
-        sx_array_push(g_http.alloc, g_http.https, _http);
-    else
-        g_http.https[index] = _http;
+bool rizz__http_init(const sx_alloc* alloc)
+{
+    g_http.alloc = alloc;
+    g_http.wake_sock = RIZZ__INVALID_SOCKET;
+    g_http.http_handles = sx_handle_create_pool(alloc, RIZZ_CONFIG_MAX_HTTP_REQUESTS);
+    if (!g_http.http_handles)
+        return false;
+
+#if SX_PLATFORM_WINDOWS
+    WSADATA wsa_data;
+    if (WSAStartup(MAKEWORD(2, 2), &wsa_data) != 0) {
+        rizz_log_error("http: WSAStartup failed");
+        return false;
+    }
+#endif
+
+    if (!rizz__http_create_wake_socket()) {
+        rizz_log_error("http: creating wake socket failed");
+        return false;
+    }
+
+    g_http.cmd_queue = sx_queue_spsc_create(alloc, sizeof(rizz__http_command), 128);
+    g_http.res_queue = sx_queue_spsc_create(alloc, sizeof(rizz__http_result), 256);
+    g_http.dns_queue = sx_queue_spsc_create(alloc, sizeof(rizz__http_host*), 16);
+    g_http.dns_res_queue = sx_queue_spsc_create(alloc, sizeof(rizz__http_dns_result), 16);
+    if (!g_http.cmd_queue || !g_http.res_queue || !g_http.dns_queue || !g_http.dns_res_queue) {
+        sx_out_of_memory();
+        return false;
+    }
 
-    return handle;
+    sx_semaphore_init(&g_http.dns_sem);
+    g_http.dns_thrd =
+        sx_thread_create(alloc, rizz__http_dns_thread, NULL, 256 * 1024, "rizz_http_dns", NULL);
+    if (!g_http.dns_thrd) {
+        rizz_log_error("http: creating resolver thread failed");
+        return false;
+    }
+
+    g_http.thrd = sx_thread_create(alloc, rizz__http_thread, NULL, 256 * 1024, "rizz_http", NULL);
+    if (!g_http.thrd) {
+        rizz_log_error("http: creating network thread failed");
+        return false;
+    }
+
+    return true;
 }
 
-static void rizz__http_free(rizz_http handle)
+static void rizz__http_destroy_request(rizz__http_request* req)
 {
-    sx_assert(g_http.alloc);
+    sx_array_free(g_http.alloc, req->body);
+    sx_array_free(g_http.alloc, req->resp_headers);
+    sx_free(g_http.alloc, req);
+}
 
-    sx_assert(handle.id);
-    rizz__http* http = &g_http.https[sx_handle_index(handle.id)];
-    sx_assert(http->h && "double free?");
-    http_release(http->h);
-    http->h = NULL;
+void rizz__http_release()
+{
+    if (!g_http.alloc)
+        return;
 
-    if (http->params) {
-        sx_free(g_http.alloc, http->params);
-        http->params = NULL;
+    g_http.quit = 1;
+    if (g_http.thrd) {
+        rizz__http_wake();
+        sx_thread_destroy(g_http.thrd, g_http.alloc);
+    }
+    // NOTE: waits for the resolve in progress, getaddrinfo can't be cancelled
+    if (g_http.dns_thrd) {
+        sx_semaphore_post(&g_http.dns_sem, 1);
+        sx_thread_destroy(g_http.dns_thrd, g_http.alloc);
+        sx_semaphore_release(&g_http.dns_sem);
     }
 
-    sx_handle_del(g_http.http_handles, handle.id);
+    // close connections, requests are owned by the main thread now that the thread is stopped
+    while (sx_array_count(g_http.conns) > 0) {
+        rizz__http_close(g_http.conns[0]);
+    }
+    for (int i = 0, c = sx_array_count(g_http.hosts); i < c; i++) {
+        sx_free(g_http.alloc, g_http.hosts[i]);
+    }
+
+    if (g_http.res_queue) {
+        rizz__http_result res;
+        while (sx_queue_spsc_consume(g_http.res_queue, &res)) {
+            if (res.type == HTTP_RESULT_DATA)
+                sx_free(g_http.alloc, res.data);
+            else if (res.type == HTTP_RESULT_CANCELLED)
+                rizz__http_destroy_request(res.req);
+        }
+    }
+
+    // remove remaining http requests
+    if (g_http.http_handles) {
+        for (int i = 0; i < g_http.http_handles->count; i++) {
+            sx_handle_t handle = sx_handle_at(g_http.http_handles, i);
+            rizz__http_request* req = g_http.reqs[sx_handle_index(handle)];
+            rizz_log_warn("un-freed http request: %s%s", req->host ? req->host : "[invalid]",
+                          req->path ? req->path : "");
+            rizz__http_destroy_request(req);
+        }
+        sx_handle_destroy_pool(g_http.http_handles, g_http.alloc);
+    }
 
-    // remove from pending
-    for (int i = 0, c = g_http.num_pending; i < c; i++) {
-        if (g_http.pending[i].id == handle.id) {
-            sx_swap(g_http.pending[i], g_http.pending[c - 1], rizz_http);
-            --g_http.num_pending;
+    if (g_http.cmd_queue)
+        sx_queue_spsc_destroy(g_http.cmd_queue, g_http.alloc);
+    if (g_http.res_queue)
+        sx_queue_spsc_destroy(g_http.res_queue, g_http.alloc);
+    if (g_http.dns_queue)
+        sx_queue_spsc_destroy(g_http.dns_queue, g_http.alloc);
+    if (g_http.dns_res_queue)
+        sx_queue_spsc_destroy(g_http.dns_res_queue, g_http.alloc);
+    if (g_http.wake_sock != RIZZ__INVALID_SOCKET)
+        rizz__close_socket(g_http.wake_sock);
+#if SX_PLATFORM_WINDOWS
+    WSACleanup();
+#endif
+
+    sx_array_free(g_http.alloc, g_http.reqs);
+    sx_array_free(g_http.alloc, g_http.hosts);
+    sx_array_free(g_http.alloc, g_http.conns);
+    sx_array_free(g_http.alloc, g_http.pollfds);
+    sx_memset(&g_http, 0x0, sizeof(g_http));
+}
+
+static void rizz__http_free(rizz_http handle);
+
+// delivers results of the network thread, callbacks are triggered here
+void rizz__http_update()
+{
+    rizz__http_result res;
+    while (sx_queue_spsc_consume(g_http.res_queue, &res)) {
+        rizz__http_request* req = res.req;
+        switch (res.type) {
+        case HTTP_RESULT_DATA:
+            if (!req->freed) {
+                sx_assert(req->data_cb);
+                req->state.response_size += res.size;
+                req->data_cb(res.data, res.size, req->user);
+            }
+            sx_free(g_http.alloc, res.data);
+            break;
+
+        case HTTP_RESULT_DONE: {
+            req->done = true;
+            if (req->freed)
+                break;
+
+            rizz_http_state* state = &req->state;
+            state->status = req->failed ? RIZZ_HTTP_FAILED : RIZZ_HTTP_COMPLETED;
+            state->status_code = req->status_code;
+            state->reason_phrase = req->reason_phrase;
+            state->content_type = req->content_type;
+            state->headers = req->resp_headers ? req->resp_headers : "";
+            if (!req->data_cb) {
+                state->response_data = req->body;
+                state->response_size = (size_t)sx_array_count(req->body);
+            }
+
+            if (req->callback) {
+                req->callback(state, req->user);
+                sx_assert(!req->freed && "must not `free` inside callback");
+            }
+
+            // callback requests are released automatically
+            if (req->callback || req->data_cb) {
+                rizz__http_free(req->handle);
+            }
+            break;
+        }
+
+        case HTTP_RESULT_CANCELLED:
+            sx_assert(req->freed);
+            rizz__http_destroy_request(req);
             break;
         }
     }
 }
 
-static const rizz_http_state* rizz__http_state(rizz_http handle)
+static rizz_http rizz__http_new(const char* url, rizz__http_mode mode, const void* data,
+                                size_t size, const char* headers, rizz_http_cb* callback,
+                                rizz_http_data_cb* data_cb, void* user)
 {
     sx_assert(g_http.alloc);
-    sx_assert(handle.id);
+    sx_assert(url);
+
+    // request and its data are allocated in a single block: host + path + headers + post data
+    int url_len = sx_strlen(url);
+    int headers_len = (headers && headers[0]) ? sx_strlen(headers) : 0;
+    size_t total_sz = sizeof(rizz__http_request) + (size_t)(url_len + 1) * 2 + 1 +
+                      (headers_len > 0 ? (size_t)headers_len + 1 : 0) + size;
+    uint8_t* buff = sx_malloc(g_http.alloc, total_sz);
+    if (!buff) {
+        sx_out_of_memory();
+        return (rizz_http){ 0 };
+    }
+    rizz__http_request* req = (rizz__http_request*)buff;
+    sx_memset(req, 0x0, sizeof(rizz__http_request));
+    buff += sizeof(rizz__http_request);
+
+    req->mode = mode;
+    req->callback = callback;
+    req->data_cb = data_cb;
+    req->user = user;
+    if (size > 0) {
+        sx_assert(data);
+        sx_memcpy(buff, data, size);
+        req->post_data = buff;
+        req->post_size = size;
+        buff += size;
+    }
+    if (headers_len > 0) {
+        sx_assert(sx_strstr(headers, "\r\n") && "header lines must end with \\r\\n");
+        sx_memcpy(buff, headers, headers_len + 1);
+        req->headers = (const char*)buff;
+        buff += headers_len + 1;
+    }
+
+    // url: http://host[:port][/path][?query]
+    if (sx_strnequalnocase(url, "http://", 7)) {
+        const char* host = url + 7;
+        const char* host_end = host;
+        while (*host_end && *host_end != '/' && *host_end != ':' && *host_end != '?')
+            ++host_end;
+        const char* path = host_end;
+        int port = 80;
+        if (*path == ':') {
+            port = sx_toint(path + 1);
+            while (*path && *path != '/' && *path != '?')
+                ++path;
+        }
+
+        if (host_end > host && port > 0 && port < 65536) {
+            req->host = (char*)buff;
+            sx_strncpy(req->host, url_len + 1, host, (int)(host_end - host));
+            buff += url_len + 1;
+
+            req->path = (char*)buff;
+            sx_strcpy(req->path, url_len + 2, *path == '/' ? "" : "/");
+            sx_strcat(req->path, url_len + 2, path);
+            req->port = (uint16_t)port;
+        }
+    }
+    if (!req->host) {
+        rizz_log_warn("http: invalid url (only http:// is supported): %s", url);
+    }
+
+    sx_handle_t handle = sx_handle_new_and_grow(g_http.http_handles, g_http.alloc);
+    sx_assert(handle);
+    req->handle = (rizz_http){ .id = handle };
+    sx_array_push_byindex(g_http.alloc, g_http.reqs, req, sx_handle_index(handle));
+
+    rizz__http_command cmd = { .type = HTTP_COMMAND_SUBMIT, .req = req };
+    sx_queue_spsc_produce_and_grow(g_http.cmd_queue, &cmd, g_http.alloc);
+    rizz__http_wake();
 
-    return (const rizz_http_state*)g_http.https[sx_handle_index(handle.id)].h;
+    return req->handle;
 }
 
-static void rizz__http_get_cb(const char* url, rizz_http_cb* callback, void* user)
+static rizz_http rizz__http_get(const char* url)
 {
-    sx_assert(g_http.alloc);
+    return rizz__http_new(url, HTTP_MODE_GET, NULL, 0, NULL, NULL, NULL, NULL);
+}
+
+static rizz_http rizz__http_post(const char* url, const void* data, size_t size)
+{
+    return rizz__http_new(url, HTTP_MODE_POST, data, size, NULL, NULL, NULL, NULL);
+}
 
-    rizz_http handle =
-        (rizz_http){ .id = sx_handle_new_and_grow(g_http.http_handles, g_http.alloc) };
+static void rizz__http_free(rizz_http handle)
+{
+    sx_assert(g_http.alloc);
     sx_assert(handle.id);
-    rizz__http _http = (rizz__http){ .callback = callback, .callback_user = user };
+    sx_assert_rel(sx_handle_valid(g_http.http_handles, handle.id) && "double free?");
+
+    rizz__http_request* req = g_http.reqs[sx_handle_index(handle.id)];
+    sx_handle_del(g_http.http_handles, handle.id);
 
-    if (g_http.num_pending < RIZZ_CONFIG_MAX_HTTP_REQUESTS) {
-        _http.h = http_get(url, (void*)g_http.alloc);
-        g_http.pending[g_http.num_pending++] = handle;
+    if (req->done) {
+        rizz__http_destroy_request(req);
     } else {
-        _http.params = rizz__http_alloc_params(url, HTTP_MODE_GET, NULL, 0);
+        // in flight: network thread cancels it and sends it back to be destroyed
+        req->freed = true;
+        rizz__http_command cmd = { .type = HTTP_COMMAND_CANCEL, .req = req };
+        sx_queue_spsc_produce_and_grow(g_http.cmd_queue, &cmd, g_http.alloc);
+        rizz__http_wake();
     }
+}
 
-    int index = sx_handle_index(handle.id);
-    if (index >= sx_array_count(g_http.https))
-        sx_array_push(g_http.alloc, g_http.https, _http);
-    else
-        g_http.https[index] = _http;
+static const rizz_http_state* rizz__http_state(rizz_http handle)
+{
+    sx_assert(g_http.alloc);
+    sx_assert_rel(sx_handle_valid(g_http.http_handles, handle.id));
+
+    return &g_http.reqs[sx_handle_index(handle.id)]->state;
+}
+
+static void rizz__http_get_cb(const char* url, rizz_http_cb* callback, void* user)
+{
+    sx_assert(callback);
+    rizz__http_new(url, HTTP_MODE_GET, NULL, 0, NULL, callback, NULL, user);
 }
 
 static void rizz__http_post_cb(const char* url, const void* data, size_t size,
                                rizz_http_cb* callback, void* user)
 {
-    sx_assert(g_http.alloc);
+    sx_assert(callback);
+    rizz__http_new(url, HTTP_MODE_POST, data, size, NULL, callback, NULL, user);
+}
 
-    rizz_http handle =
-        (rizz_http){ .id = sx_handle_new_and_grow(g_http.http_handles, g_http.alloc) };
-    sx_assert(handle.id);
-    rizz__http _http = (rizz__http){ .callback = callback, .callback_user = user };
+static void rizz__http_get_stream(const char* url, rizz_http_data_cb* data_cb,
+                                  rizz_http_cb* callback, void* user)
+{
+    sx_assert(data_cb);
+    rizz__http_new(url, HTTP_MODE_GET, NULL, 0, NULL, callback, data_cb, user);
+}
 
-    if (g_http.num_pending < RIZZ_CONFIG_MAX_HTTP_REQUESTS) {
-        _http.h = http_post(url, data, size, (void*)g_http.alloc);
-        g_http.pending[g_http.num_pending++] = handle;
-    } else {
-        _http.params = rizz__http_alloc_params(url, HTTP_MODE_POST, data, size);
-    }
+static void rizz__http_get_cb_headers(const char* url, const char* headers,
+                                      rizz_http_cb* callback, void* user)
+{
+    sx_assert(callback);
+    rizz__http_new(url, HTTP_MODE_GET, NULL, 0, headers, callback, NULL, user);
+}
 
-    int index = sx_handle_index(handle.id);
-    if (index >= sx_array_count(g_http.https))
-        sx_array_push(g_http.alloc, g_http.https, _http);
-    else
-        g_http.https[index] = _http;
+static bool rizz__http_header(const rizz_http_state* http, const char* name, char* value,
+                              int value_size)
+{
+    sx_assert(http);
+    sx_assert(name);
+
+    int name_len = sx_strlen(name);
+    for (const char* line = http->headers; line && line[0];) {
+        const char* eol = sx_strstr(line, "\r\n");
+        if (!eol)
+            break;
+        if (sx_strnequalnocase(line, name, name_len) && line[name_len] == ':') {
+            if (value) {
+                const char* v = line + name_len + 2;
+                sx_strncpy(value, value_size, v, (int)(eol - v));
+            }
+            return true;
+        }
+        line = eol + 2;
+    }
+    return false;
 }
 
 rizz_api_http the__http = { .get = rizz__http_get,
@@ -320,4 +1262,7 @@ rizz_api_http the__http = { .get = rizz__http_get,
                             .free = rizz__http_free,
                             .state = rizz__http_state,
                             .get_cb = rizz__http_get_cb,
-                            .post_cb = rizz__http_post_cb };
+                            .post_cb = rizz__http_post_cb,
+                            .get_stream = rizz__http_get_stream,
+                            .get_cb_headers = rizz__http_get_cb_headers,
+                            .header = rizz__http_header };
@@ -9,12 +9,18 @@
 #include "sx/allocator.h"
 #include "sx/array.h"
 #include "sx/hash.h"
+#include "sx/io.h"
 #include "sx/string.h"
 
+#include "sjson/sjson.h"
+
 #include <alloca.h>
 
 #define DEFAULT_REG_SIZE 512
 
+#define RIZZ__REFL_BIN_SIGN 0x52535a52    // "RZSR"
+#define RIZZ__REFL_BIN_FORMAT 1
+
 typedef struct rizz__refl_struct {
     char type[32];
     int size;    // size of struct
@@ -45,6 +51,76 @@ typedef struct rizz__reflect_context {
 
 static rizz__reflect_context g_reflect;
 
+// serializers
+typedef enum {
+    RIZZ__REFL_KIND_INT8 = 0,
+    RIZZ__REFL_KIND_INT16,
+    RIZZ__REFL_KIND_INT32,
+    RIZZ__REFL_KIND_INT64,
+    RIZZ__REFL_KIND_UINT8,
+    RIZZ__REFL_KIND_UINT16,
+    RIZZ__REFL_KIND_UINT32,
+    RIZZ__REFL_KIND_UINT64,
+    RIZZ__REFL_KIND_FLOAT,
+    RIZZ__REFL_KIND_DOUBLE,
+    RIZZ__REFL_KIND_BOOL,
+    RIZZ__REFL_KIND_ENUM,
+    RIZZ__REFL_KIND_CSTRING,    // char array, `size` is the whole buffer
+    RIZZ__REFL_KIND_STRUCT,     // json only: nested struct, followed by `num_children` ops
+    RIZZ__REFL_KIND_UNKNOWN
+} rizz__refl_kind;
+
+typedef struct rizz__refl_op {
+    rizz__refl_kind kind;
+    int offset;           // bin: from the start of the root struct, json: from the parent
+    int size;             // element size
+    int count;            // number of array elements, bin: 1 for non-arrays, json: 0
+    int stride;
+    int reg_id;           // index-to: rizz__reflect_context:regs (field name)
+    int enum_id;          // ENUM: index-to: rizz__reflect_context:enums
+    int num_children;     // STRUCT: number of ops of the nested struct (recursive)
+    uint32_t name_hash;   // bin: hash of the field path ("parent.child"), identifies the field
+    int packed_offset;    // bin: offset in the packed item
+} rizz__refl_op;
+
+// continuous byte range of the struct, that is written/read with one copy
+typedef struct rizz__refl_blit {
+    int offset;
+    int packed_offset;
+    int size;
+} rizz__refl_blit;
+
+// binary format: header, `num_fields` x rizz__refl_bin_field, `count` x packed items
+typedef struct rizz__refl_bin_header {
+    uint32_t sign;
+    uint32_t format;
+    uint32_t version;        // user version of the data
+    uint32_t schema_hash;    // if it matches the serializer, items are read with blits
+    int32_t num_fields;
+    int32_t packed_size;
+    int32_t count;
+    uint32_t _reserved;
+} rizz__refl_bin_header;
+
+typedef struct rizz__refl_bin_field {
+    uint32_t name_hash;
+    uint32_t kind;
+    int32_t size;
+    int32_t count;
+} rizz__refl_bin_field;
+
+typedef struct rizz_refl_serializer {
+    char type[32];
+    uint32_t version;
+    uint32_t schema_hash;
+    int struct_size;
+    int packed_size;
+    rizz__refl_op* ops;         // sx_array: bin fields, nested structs and arrays are unrolled
+    rizz__refl_blit* blits;     // sx_array
+    rizz__refl_op* json_ops;    // sx_array: fields in json tree order
+    int json_num_nodes;         // number of json nodes per item, for sizing sjson pools
+} rizz_refl_serializer;
+
 bool rizz__refl_init(const sx_alloc* alloc, int max_regs)
 {
     g_reflect.max_regs = max_regs;
@@ -99,6 +175,25 @@ static inline int rizz__refl_type_size(const char* type_name) {
 }
 // clang-format on
 
+// clang-format off
+static inline rizz__refl_kind rizz__refl_type_kind(const char* type_name) {
+    if (sx_strequal(type_name, "int"))              return RIZZ__REFL_KIND_INT32;
+    else if (sx_strequal(type_name, "float"))       return RIZZ__REFL_KIND_FLOAT;
+    else if (sx_strequal(type_name, "char"))        return RIZZ__REFL_KIND_INT8;
+    else if (sx_strequal(type_name, "double"))      return RIZZ__REFL_KIND_DOUBLE;
+    else if (sx_strequal(type_name, "bool"))        return RIZZ__REFL_KIND_BOOL;
+    else if (sx_strequal(type_name, "uint8_t"))     return RIZZ__REFL_KIND_UINT8;
+    else if (sx_strequal(type_name, "uint32_t"))    return RIZZ__REFL_KIND_UINT32;
+    else if (sx_strequal(type_name, "uint64_t"))    return RIZZ__REFL_KIND_UINT64;
+    else if (sx_strequal(type_name, "uint16_t"))    return RIZZ__REFL_KIND_UINT16;
+    else if (sx_strequal(type_name, "int32_t"))     return RIZZ__REFL_KIND_INT32;
+    else if (sx_strequal(type_name, "int16_t"))     return RIZZ__REFL_KIND_INT16;
+    else if (sx_strequal(type_name, "int8_t"))      return RIZZ__REFL_KIND_INT8;
+    else if (sx_strequal(type_name, "int64_t"))     return RIZZ__REFL_KIND_INT64;
+    else                                            return RIZZ__REFL_KIND_UNKNOWN;
+}
+// clang-format on
+
 static void* rizz__refl_get_func(const char* name)
 {
     int index = sx_hashtbl_find_get(g_reflect.reg_tbl, sx_hash_fnv32_str(name), -1);
@@ -364,6 +459,643 @@ static bool rizz__refl_is_cstring(const rizz_refl_info* r)
     return sx_strequal(r->type, "char") && (r->flags & RIZZ_REFL_FLAG_IS_ARRAY);
 }
 
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// serializers
+static int rizz__refl_find_enum(const char* type)
+{
+    for (int i = 0, c = sx_array_count(g_reflect.enums); i < c; i++) {
+        if (sx_strequal(g_reflect.enums[i].type, type))
+            return i;
+    }
+    return -1;
+}
+
+// returns a field op without the offsets, kind is UNKNOWN if the field can't be serialized
+static rizz__refl_op rizz__refl_make_op(int reg_id)
+{
+    const rizz__refl_data* r = &g_reflect.regs[reg_id];
+    rizz__refl_op op = { .kind = RIZZ__REFL_KIND_UNKNOWN,
+                         .size = r->r.stride,
+                         .count = r->r.array_size,
+                         .stride = r->r.stride,
+                         .reg_id = reg_id,
+                         .enum_id = -1 };
+
+    if (r->r.flags & RIZZ_REFL_FLAG_IS_PTR) {
+        return op;
+    } else if (r->r.flags & RIZZ_REFL_FLAG_IS_STRUCT) {
+        op.kind = RIZZ__REFL_KIND_STRUCT;
+    } else if (r->r.flags & RIZZ_REFL_FLAG_IS_ENUM) {
+        op.kind = RIZZ__REFL_KIND_ENUM;
+        op.enum_id = rizz__refl_find_enum(r->type);
+    } else if (sx_strequal(r->type, "char") && (r->r.flags & RIZZ_REFL_FLAG_IS_ARRAY)) {
+        op.kind = RIZZ__REFL_KIND_CSTRING;
+        op.size = op.stride = r->r.size;
+        op.count = 1;
+    } else {
+        op.kind = rizz__refl_type_kind(r->type);
+    }
+    return op;
+}
+
+static void rizz__refl_compile_bin(rizz_refl_serializer* srz, const char* type, int base_offset,
+                                   const char* path)
+{
+    for (int i = 0, c = sx_array_count(g_reflect.regs); i < c; i++) {
+        const rizz__refl_data* r = &g_reflect.regs[i];
+        if (r->r.internal_type != RIZZ_REFL_FIELD || !sx_strequal(r->base, type))
+            continue;
+
+        rizz__refl_op op = rizz__refl_make_op(i);
+        if (op.kind == RIZZ__REFL_KIND_UNKNOWN)
+            continue;
+
+        char field_path[256];
+        sx_snprintf(field_path, sizeof(field_path), "%s%s%s", path, path[0] ? "." : "", r->name);
+        int offset = base_offset + (int)r->r.offset;
+        if (op.kind == RIZZ__REFL_KIND_STRUCT) {
+            if (r->r.flags & RIZZ_REFL_FLAG_IS_ARRAY) {
+                for (int k = 0; k < op.count; k++) {
+                    char elem_path[256];
+                    sx_snprintf(elem_path, sizeof(elem_path), "%s.%d", field_path, k);
+                    rizz__refl_compile_bin(srz, r->type, offset + k * op.stride, elem_path);
+                }
+            } else {
+                rizz__refl_compile_bin(srz, r->type, offset, field_path);
+            }
+        } else {
+            op.offset = offset;
+            op.name_hash = sx_hash_fnv32_str(field_path);
+            op.packed_offset = srz->packed_size;
+            srz->packed_size += op.size * op.count;
+            sx_array_push(g_reflect.alloc, srz->ops, op);
+        }
+    }
+}
+
+// returns number of ops that are added (recursive)
+static int rizz__refl_compile_json(rizz_refl_serializer* srz, const char* type)
+{
+    int num_ops = 0;
+    for (int i = 0, c = sx_array_count(g_reflect.regs); i < c; i++) {
+        const rizz__refl_data* r = &g_reflect.regs[i];
+        if (r->r.internal_type != RIZZ_REFL_FIELD || !sx_strequal(r->base, type))
+            continue;
+
+        rizz__refl_op op = rizz__refl_make_op(i);
+        if (op.kind == RIZZ__REFL_KIND_UNKNOWN)
+            continue;
+
+        op.offset = (int)r->r.offset;
+        if (!(r->r.flags & RIZZ_REFL_FLAG_IS_ARRAY) || op.kind == RIZZ__REFL_KIND_CSTRING)
+            op.count = 0;    // json: not an array
+        int index = sx_array_count(srz->json_ops);
+        sx_array_push(g_reflect.alloc, srz->json_ops, op);
+        ++num_ops;
+
+        if (op.kind == RIZZ__REFL_KIND_STRUCT) {
+            int num_children = rizz__refl_compile_json(srz, r->type);
+            srz->json_ops[index].num_children = num_children;
+            num_ops += num_children;
+        }
+    }
+    return num_ops;
+}
+
+static int rizz__refl_json_num_nodes(const rizz_refl_serializer* srz, int first, int num_ops)
+{
+    int num_nodes = 0;
+    for (int i = first, end = first + num_ops; i < end; i++) {
+        const rizz__refl_op* op = &srz->json_ops[i];
+        int elem_nodes = op->kind == RIZZ__REFL_KIND_STRUCT
+                             ? (1 + rizz__refl_json_num_nodes(srz, i + 1, op->num_children))
+                             : 1;
+        num_nodes += op->count > 0 ? (1 + op->count * elem_nodes) : elem_nodes;
+        i += op->num_children;
+    }
+    return num_nodes;
+}
+
+static rizz_refl_serializer* rizz__refl_create_serializer(const char* base_type, uint32_t version)
+{
+    int struct_size = rizz__refl_size_of(base_type);
+    if (struct_size == 0) {
+        rizz_log_warn("refl: type '%s' is not registered", base_type);
+        return NULL;
+    }
+
+    rizz_refl_serializer* srz = sx_malloc(g_reflect.alloc, sizeof(rizz_refl_serializer));
+    if (!srz) {
+        sx_out_of_memory();
+        return NULL;
+    }
+    sx_memset(srz, 0x0, sizeof(*srz));
+    sx_strcpy(srz->type, sizeof(srz->type), base_type);
+    srz->version = version;
+    srz->struct_size = struct_size;
+
+    rizz__refl_compile_bin(srz, base_type, 0, "");
+    rizz__refl_compile_json(srz, base_type);
+    srz->json_num_nodes = 1 + rizz__refl_json_num_nodes(srz, 0, sx_array_count(srz->json_ops));
+
+    // merge ops that are continuous in memory into blits, and hash the layout for fast path
+    sx_hash_xxh32_t* hasher = sx_hash_create_xxh32(g_reflect.alloc);
+    sx_hash_xxh32_init(hasher, 0);
+    for (int i = 0, c = sx_array_count(srz->ops); i < c; i++) {
+        const rizz__refl_op* op = &srz->ops[i];
+        rizz__refl_bin_field f = { .name_hash = op->name_hash,
+                                   .kind = (uint32_t)op->kind,
+                                   .size = op->size,
+                                   .count = op->count };
+        sx_hash_xxh32_update(hasher, &f, sizeof(f));
+
+        int size = op->size * op->count;
+        rizz__refl_blit* last = sx_array_count(srz->blits) ? &sx_array_last(srz->blits) : NULL;
+        if (last && last->offset + last->size == op->offset &&
+            last->packed_offset + last->size == op->packed_offset) {
+            last->size += size;
+        } else {
+            rizz__refl_blit blit = { .offset = op->offset,
+                                     .packed_offset = op->packed_offset,
+                                     .size = size };
+            sx_array_push(g_reflect.alloc, srz->blits, blit);
+        }
+    }
+    srz->schema_hash = sx_hash_xxh32_digest(hasher);
+    sx_hash_destroy_xxh32(hasher, g_reflect.alloc);
+
+    return srz;
+}
+
+static void rizz__refl_destroy_serializer(rizz_refl_serializer* srz)
+{
+    if (srz) {
+        sx_array_free(g_reflect.alloc, srz->ops);
+        sx_array_free(g_reflect.alloc, srz->blits);
+        sx_array_free(g_reflect.alloc, srz->json_ops);
+        sx_free(g_reflect.alloc, srz);
+    }
+}
+
+// makes sure that the writer has `size` more bytes, grows it at once (sx_mem_write grows by 4k)
+static bool rizz__refl_writer_reserve(sx_mem_writer* writer, int64_t size)
+{
+    if (writer->size - writer->pos >= size)
+        return true;
+    if (!writer->mem->alloc)
+        return false;
+
+    sx_mem_block* mem = writer->mem;
+    int64_t new_size = sx_max(writer->pos + size, writer->size * 2);
+    if (!sx_mem_grow(&mem, (int)sx_align_mask(new_size, 0xfff)))
+        return false;
+    writer->mem = mem;
+    writer->data = (uint8_t*)mem->data;
+    writer->size = mem->size;
+    return true;
+}
+
+static bool rizz__refl_serialize_bin(const rizz_refl_serializer* srz, sx_mem_writer* writer,
+                                     const void* objs, int count)
+{
+    sx_assert(srz);
+    sx_assert(objs || count == 0);
+
+    int num_fields = sx_array_count(srz->ops);
+    int64_t total = (int64_t)sizeof(rizz__refl_bin_header) +
+                    (int64_t)num_fields * (int64_t)sizeof(rizz__refl_bin_field) +
+                    (int64_t)count * srz->packed_size;
+    if (!rizz__refl_writer_reserve(writer, total))
+        return false;
+
+    rizz__refl_bin_header header = { .sign = RIZZ__REFL_BIN_SIGN,
+                                     .format = RIZZ__REFL_BIN_FORMAT,
+                                     .version = srz->version,
+                                     .schema_hash = srz->schema_hash,
+                                     .num_fields = num_fields,
+                                     .packed_size = srz->packed_size,
+                                     .count = count };
+    sx_mem_write_var(writer, header);
+    for (int i = 0; i < num_fields; i++) {
+        const rizz__refl_op* op = &srz->ops[i];
+        rizz__refl_bin_field f = { .name_hash = op->name_hash,
+                                   .kind = (uint32_t)op->kind,
+                                   .size = op->size,
+                                   .count = op->count };
+        sx_mem_write_var(writer, f);
+    }
+
+    uint8_t* dst = writer->data + writer->pos;
+    const uint8_t* src = objs;
+    const rizz__refl_blit* blits = srz->blits;
+    int num_blits = sx_array_count(blits);
+    for (int i = 0; i < count; i++) {
+        for (int b = 0; b < num_blits; b++) {
+            sx_memcpy(dst + blits[b].packed_offset, src + blits[b].offset, blits[b].size);
+        }
+        dst += srz->packed_size;
+        src += srz->struct_size;
+    }
+    writer->pos += (int64_t)count * srz->packed_size;
+    writer->top = sx_max(writer->top, writer->pos);
+    return true;
+}
+
+static inline bool rizz__refl_kind_is_number(uint32_t kind)
+{
+    return kind <= RIZZ__REFL_KIND_ENUM;
+}
+
+// size of the number that `rizz__refl_read_number` and `rizz__refl_write_number` access
+static int rizz__refl_number_size(uint32_t kind)
+{
+    // clang-format off
+    switch (kind) {
+    case RIZZ__REFL_KIND_INT8:
+    case RIZZ__REFL_KIND_UINT8:     return 1;
+    case RIZZ__REFL_KIND_INT16:
+    case RIZZ__REFL_KIND_UINT16:    return 2;
+    case RIZZ__REFL_KIND_ENUM:
+    case RIZZ__REFL_KIND_INT32:
+    case RIZZ__REFL_KIND_UINT32:
+    case RIZZ__REFL_KIND_FLOAT:     return 4;
+    case RIZZ__REFL_KIND_INT64:
+    case RIZZ__REFL_KIND_UINT64:
+    case RIZZ__REFL_KIND_DOUBLE:    return 8;
+    case RIZZ__REFL_KIND_BOOL:      return (int)sizeof(bool);
+    default:                        return 0;
+    }
+    // clang-format on
+}
+
+static double rizz__refl_read_number(rizz__refl_kind kind, const void* p)
+{
+    // clang-format off
+    switch (kind) {
+    case RIZZ__REFL_KIND_INT8:      return (double)*(const int8_t*)p;
+    case RIZZ__REFL_KIND_INT16:     return (double)*(const int16_t*)p;
+    case RIZZ__REFL_KIND_ENUM:
+    case RIZZ__REFL_KIND_INT32:     return (double)*(const int32_t*)p;
+    case RIZZ__REFL_KIND_INT64:     return (double)*(const int64_t*)p;
+    case RIZZ__REFL_KIND_UINT8:     return (double)*(const uint8_t*)p;
+    case RIZZ__REFL_KIND_UINT16:    return (double)*(const uint16_t*)p;
+    case RIZZ__REFL_KIND_UINT32:    return (double)*(const uint32_t*)p;
+    case RIZZ__REFL_KIND_UINT64:    return (double)*(const uint64_t*)p;
+    case RIZZ__REFL_KIND_FLOAT:     return (double)*(const float*)p;
+    case RIZZ__REFL_KIND_DOUBLE:    return *(const double*)p;
+    case RIZZ__REFL_KIND_BOOL:      return *(const bool*)p ? 1.0 : 0.0;
+    default:                        return 0;
+    }
+    // clang-format on
+}
+
+static void rizz__refl_write_number(rizz__refl_kind kind, void* p, double n)
+{
+    // clang-format off
+    switch (kind) {
+    case RIZZ__REFL_KIND_INT8:      *(int8_t*)p = (int8_t)n;        break;
+    case RIZZ__REFL_KIND_INT16:     *(int16_t*)p = (int16_t)n;      break;
+    case RIZZ__REFL_KIND_ENUM:
+    case RIZZ__REFL_KIND_INT32:     *(int32_t*)p = (int32_t)n;      break;
+    case RIZZ__REFL_KIND_INT64:     *(int64_t*)p = (int64_t)n;      break;
+    case RIZZ__REFL_KIND_UINT8:     *(uint8_t*)p = (uint8_t)n;      break;
+    case RIZZ__REFL_KIND_UINT16:    *(uint16_t*)p = (uint16_t)n;    break;
+    case RIZZ__REFL_KIND_UINT32:    *(uint32_t*)p = (uint32_t)n;    break;
+    case RIZZ__REFL_KIND_UINT64:    *(uint64_t*)p = (uint64_t)n;    break;
+    case RIZZ__REFL_KIND_FLOAT:     *(float*)p = (float)n;          break;
+    case RIZZ__REFL_KIND_DOUBLE:    *(double*)p = n;                break;
+    case RIZZ__REFL_KIND_BOOL:      *(bool*)p = n != 0;             break;
+    default:                                                        break;
+    }
+    // clang-format on
+}
+
+typedef struct rizz__refl_bin_remap {
+    const rizz__refl_op* op;
+    rizz__refl_bin_field field;
+    int packed_offset;    // in the file
+} rizz__refl_bin_remap;
+
+static int rizz__refl_deserialize_bin(const rizz_refl_serializer* srz, sx_mem_reader* reader,
+                                      void* objs, int max_count, uint32_t* version)
+{
+    sx_assert(srz);
+
+    rizz__refl_bin_header header;
+    if (sx_mem_read_var(reader, header) != sizeof(header) || header.sign != RIZZ__REFL_BIN_SIGN ||
+        header.format != RIZZ__REFL_BIN_FORMAT || header.num_fields < 0 || header.count < 0 ||
+        header.packed_size < 0) {
+        rizz_log_warn("refl: invalid binary data for '%s'", srz->type);
+        return -1;
+    }
+    if (version)
+        *version = header.version;
+
+    int64_t fields_size = (int64_t)header.num_fields * (int64_t)sizeof(rizz__refl_bin_field);
+    int64_t items_size = (int64_t)header.count * header.packed_size;
+    if (reader->top - reader->pos < fields_size + items_size) {
+        rizz_log_warn("refl: binary data for '%s' is truncated", srz->type);
+        return -1;
+    }
+    const rizz__refl_bin_field* fields =
+        (const rizz__refl_bin_field*)(reader->data + reader->pos);
+    const uint8_t* src = reader->data + reader->pos + fields_size;
+
+    int count = sx_min(header.count, max_count);
+    uint8_t* dst = objs;
+    if (header.schema_hash == srz->schema_hash && header.packed_size == srz->packed_size) {
+        // fast path: same layout
+        reader->pos += fields_size + items_size;
+        const rizz__refl_blit* blits = srz->blits;
+        int num_blits = sx_array_count(blits);
+        for (int i = 0; i < count; i++) {
+            for (int b = 0; b < num_blits; b++) {
+                sx_memcpy(dst + blits[b].offset, src + blits[b].packed_offset, blits[b].size);
+            }
+            src += srz->packed_size;
+            dst += srz->struct_size;
+        }
+        return count;
+    }
+
+    // schema is changed: map the fields by their names, missing fields are left untouched
+    // fields are validated before they are used, corrupt data must not read out of the items
+    const sx_alloc* tmp_alloc = g_reflect.alloc;
+    rizz__refl_bin_remap* remaps = NULL;
+    int64_t packed_offset = 0;
+    for (int i = 0; i < header.num_fields; i++) {
+        rizz__refl_bin_field f;
+        sx_memcpy(&f, &fields[i], sizeof(f));
+        // numbers have fixed sizes, except enums that can be smaller than int in c++
+        int64_t field_size = (int64_t)f.size * (int64_t)f.count;
+        bool bad_number = rizz__refl_kind_is_number(f.kind) && f.kind != RIZZ__REFL_KIND_ENUM &&
+                          f.size != rizz__refl_number_size(f.kind);
+        if (f.size < 0 || f.count < 0 || bad_number ||
+            packed_offset + field_size > header.packed_size) {
+            rizz_log_warn("refl: invalid field in binary data for '%s'", srz->type);
+            sx_array_free(tmp_alloc, remaps);
+            return -1;
+        }
+
+        for (int k = 0, c = sx_array_count(srz->ops); k < c; k++) {
+            const rizz__refl_op* op = &srz->ops[k];
+            if (op->name_hash == f.name_hash) {
+                bool same = f.kind == (uint32_t)op->kind && f.size == op->size;
+                bool convert = rizz__refl_kind_is_number(f.kind) &&
+                               rizz__refl_kind_is_number((uint32_t)op->kind) &&
+                               f.size == rizz__refl_number_size(f.kind) &&
+                               op->size == rizz__refl_number_size((uint32_t)op->kind);
+                if (same || convert) {
+                    rizz__refl_bin_remap remap = { .op = op,
+                                                   .field = f,
+                                                   .packed_offset = (int)packed_offset };
+                    sx_array_push(tmp_alloc, remaps, remap);
+                }
+                break;
+            }
+        }
+        packed_offset += field_size;
+    }
+    reader->pos += fields_size + items_size;
+
+    int num_remaps = sx_array_count(remaps);
+    for (int i = 0; i < count; i++) {
+        for (int r = 0; r < num_remaps; r++) {
+            const rizz__refl_bin_remap* remap = &remaps[r];
+            const rizz__refl_op* op = remap->op;
+            const uint8_t* fsrc = src + remap->packed_offset;
+            uint8_t* fdst = dst + op->offset;
+            int elems = sx_min(remap->field.count, op->count);
+            if (remap->field.kind == (uint32_t)op->kind && remap->field.size == op->size) {
+                sx_memcpy(fdst, fsrc, elems * op->size);
+                if (op->kind == RIZZ__REFL_KIND_CSTRING)
+                    fdst[op->size - 1] = '\0';
+            } else {
+                for (int e = 0; e < elems; e++) {
+                    double n = rizz__refl_read_number((rizz__refl_kind)remap->field.kind,
+                                                      fsrc + e * remap->field.size);
+                    rizz__refl_write_number(op->kind, fdst + e * op->size, n);
+                }
+            }
+        }
+        src += header.packed_size;
+        dst += srz->struct_size;
+    }
+
+    sx_array_free(tmp_alloc, remaps);
+    return count;
+}
+
+static const char* rizz__refl_enum_name(int enum_id, int value)
+{
+    if (enum_id >= 0) {
+        const int* name_ids = g_reflect.enums[enum_id].name_ids;
+        for (int i = 0, c = sx_array_count(name_ids); i < c; i++) {
+            const rizz__refl_data* r = &g_reflect.regs[name_ids[i]];
+            if (value == (int)r->r.offset)
+                return r->name;
+        }
+    }
+    return "";
+}
+
+static int rizz__refl_enum_value(int enum_id, const char* name)
+{
+    if (enum_id >= 0 && name) {
+        const int* name_ids = g_reflect.enums[enum_id].name_ids;
+        for (int i = 0, c = sx_array_count(name_ids); i < c; i++) {
+            const rizz__refl_data* r = &g_reflect.regs[name_ids[i]];
+            if (sx_strequal(r->name, name))
+                return (int)r->r.offset;
+        }
+    }
+    return 0;
+}
+
+static void rizz__refl_json_read_value(const rizz__refl_op* op, sjson_node* jvalue, uint8_t* value)
+{
+    switch (op->kind) {
+    case RIZZ__REFL_KIND_ENUM: {
+        int eval = rizz__refl_enum_value(op->enum_id, jvalue->tag == SJSON_STRING ? jvalue->string_
+                                                                                  : NULL);
+        sx_memcpy(value, &eval, sx_min(op->size, (int)sizeof(eval)));
+        break;
+    }
+    case RIZZ__REFL_KIND_CSTRING:
+        if (jvalue->tag == SJSON_STRING)
+            sx_strcpy((char*)value, op->size, jvalue->string_);
+        break;
+    case RIZZ__REFL_KIND_BOOL:
+        if (jvalue->tag == SJSON_BOOL)
+            *(bool*)value = jvalue->bool_;
+        break;
+    default:
+        if (jvalue->tag == SJSON_NUMBER)
+            rizz__refl_write_number(op->kind, value, jvalue->number_);
+        break;
+    }
+}
+
+// reads ops [first, first + num_ops) of a (nested) struct from json object
+static void rizz__refl_json_read(const rizz_refl_serializer* srz, int first, int num_ops,
+                                 sjson_node* jobj, uint8_t* obj)
+{
+    for (int i = first, end = first + num_ops; i < end; i++) {
+        const rizz__refl_op* op = &srz->json_ops[i];
+        sjson_node* jfield = sjson_find_member(jobj, g_reflect.regs[op->reg_id].name);
+        int next = i + op->num_children;
+        if (!jfield) {
+            i = next;
+            continue;
+        }
+
+        uint8_t* value = obj + op->offset;
+        if (op->count > 0) {
+            if (jfield->tag != SJSON_ARRAY) {
+                i = next;
+                continue;
+            }
+            sjson_node* jelem = sjson_first_child(jfield);
+            for (int e = 0; e < op->count && jelem; e++, jelem = jelem->next) {
+                if (op->kind == RIZZ__REFL_KIND_STRUCT) {
+                    rizz__refl_json_read(srz, i + 1, op->num_children, jelem,
+                                         value + e * op->stride);
+                } else {
+                    rizz__refl_json_read_value(op, jelem, value + e * op->stride);
+                }
+            }
+        } else if (op->kind == RIZZ__REFL_KIND_STRUCT) {
+            rizz__refl_json_read(srz, i + 1, op->num_children, jfield, value);
+        } else {
+            rizz__refl_json_read_value(op, jfield, value);
+        }
+        i = next;
+    }
+}
+
+static sjson_node* rizz__refl_json_make_value(const rizz__refl_op* op, sjson_context* jctx,
+                                              const uint8_t* value)
+{
+    switch (op->kind) {
+    case RIZZ__REFL_KIND_ENUM: {
+        int eval = 0;
+        sx_memcpy(&eval, value, sx_min(op->size, (int)sizeof(eval)));
+        return sjson_mkstring(jctx, rizz__refl_enum_name(op->enum_id, eval));
+    }
+    case RIZZ__REFL_KIND_CSTRING:
+        return sjson_mkstring(jctx, (const char*)value);
+    case RIZZ__REFL_KIND_BOOL:
+        return sjson_mkbool(jctx, *(const bool*)value);
+    default:
+        return sjson_mknumber(jctx, rizz__refl_read_number(op->kind, value));
+    }
+}
+
+static void rizz__refl_json_write(const rizz_refl_serializer* srz, int first, int num_ops,
+                                  sjson_context* jctx, sjson_node* jobj, const uint8_t* obj)
+{
+    for (int i = first, end = first + num_ops; i < end; i++) {
+        const rizz__refl_op* op = &srz->json_ops[i];
+        const char* name = g_reflect.regs[op->reg_id].name;
+        const uint8_t* value = obj + op->offset;
+        sjson_node* jvalue;
+        if (op->count > 0) {
+            jvalue = sjson_mkarray(jctx);
+            for (int e = 0; e < op->count; e++) {
+                sjson_node* jelem;
+                if (op->kind == RIZZ__REFL_KIND_STRUCT) {
+                    jelem = sjson_mkobject(jctx);
+                    rizz__refl_json_write(srz, i + 1, op->num_children, jctx, jelem,
+                                          value + e * op->stride);
+                } else {
+                    jelem = rizz__refl_json_make_value(op, jctx, value + e * op->stride);
+                }
+                sjson_append_element(jvalue, jelem);
+            }
+        } else if (op->kind == RIZZ__REFL_KIND_STRUCT) {
+            jvalue = sjson_mkobject(jctx);
+            rizz__refl_json_write(srz, i + 1, op->num_children, jctx, jvalue, value);
+        } else {
+            jvalue = rizz__refl_json_make_value(op, jctx, value);
+        }
+        sjson_append_member(jctx, jobj, name, jvalue);
+        i += op->num_children;
+    }
+}
+
+void rizz__refl_read_json(const rizz_refl_serializer* srz, sjson_node* jobj, void* obj)
+{
+    sx_assert(srz);
+    rizz__refl_json_read(srz, 0, sx_array_count(srz->json_ops), jobj, obj);
+}
+
+void rizz__refl_write_json(const rizz_refl_serializer* srz, sjson_context* jctx,
+                           sjson_node* jobj, const void* obj)
+{
+    sx_assert(srz);
+    rizz__refl_json_write(srz, 0, sx_array_count(srz->json_ops), jctx, jobj, obj);
+}
+
+static char* rizz__refl_serialize_json(const rizz_refl_serializer* srz, const void* objs,
+                                       int count, const sx_alloc* alloc)
+{
+    sx_assert(srz);
+    sx_assert(alloc);
+
+    // sjson searches all of it's pages for a free node, so allocate the nodes in one page
+    int pool_size = sx_max(512, 1 + count * srz->json_num_nodes);
+    sjson_context* jctx = sjson_create_context(pool_size, 0, (void*)alloc);
+    if (!jctx)
+        return NULL;
+
+    sjson_node* jroot = sjson_mkarray(jctx);
+    const uint8_t* obj = objs;
+    for (int i = 0; i < count; i++, obj += srz->struct_size) {
+        sjson_node* jitem = sjson_mkobject(jctx);
+        rizz__refl_write_json(srz, jctx, jitem, obj);
+        sjson_append_element(jroot, jitem);
+    }
+
+    char* json = sjson_encode(jctx, jroot);
+    sjson_destroy_context(jctx);
+    return json;
+}
+
+static int rizz__refl_deserialize_json(const rizz_refl_serializer* srz, const char* json,
+                                       void* objs, int max_count)
+{
+    sx_assert(srz);
+
+    // estimate the number of nodes by the json size (roughly one node per 8 chars)
+    int pool_size = sx_max(512, sx_strlen(json) / 8);
+    sjson_context* jctx = sjson_create_context(pool_size, 0, (void*)g_reflect.alloc);
+    if (!jctx)
+        return -1;
+
+    int count = -1;
+    sjson_node* jroot = sjson_decode(jctx, json);
+    if (jroot && jroot->tag == SJSON_ARRAY) {
+        count = 0;
+        uint8_t* obj = objs;
+        sjson_node* jitem;
+        sjson_foreach(jitem, jroot)
+        {
+            if (count == max_count)
+                break;
+            rizz__refl_read_json(srz, jitem, obj);
+            obj += srz->struct_size;
+            ++count;
+        }
+    } else if (jroot && jroot->tag == SJSON_OBJECT && max_count > 0) {
+        rizz__refl_read_json(srz, jroot, objs);
+        count = 1;
+    } else {
+        rizz_log_warn("refl: invalid json data for '%s'", srz->type);
+    }
+
+    sjson_destroy_context(jctx);
+    return count;
+}
 
 rizz_api_refl the__refl = { ._reg = rizz__refl_reg,
                             .size_of = rizz__refl_size_of,
@@ -373,4 +1105,10 @@ rizz_api_refl the__refl = { ._reg = rizz__refl_reg,
                             .get_field = rizz__refl_get_field,
                             .get_fields = rizz__refl_get_fields,
                             .reg_count = rizz__refl_reg_count,
-                            .is_cstring = rizz__refl_is_cstring };
+                            .is_cstring = rizz__refl_is_cstring,
+                            .create_serializer = rizz__refl_create_serializer,
+                            .destroy_serializer = rizz__refl_destroy_serializer,
+                            .serialize_bin = rizz__refl_serialize_bin,
+                            .deserialize_bin = rizz__refl_deserialize_bin,
+                            .serialize_json = rizz__refl_serialize_json,
+                            .deserialize_json = rizz__refl_deserialize_json };
@@ -5,6 +5,7 @@
 #include "config.h"
 
 #include "rizz/core.h"
+#include "rizz/http.h"
 #include "rizz/vfs.h"
 #include "rizz/android.h"
 #include "rizz/ios.h"
@@ -21,12 +22,16 @@ typedef enum efsw_error efsw_error;
 
 #include "sx/allocator.h"
 #include "sx/array.h"
+#include "sx/hash.h"
 #include "sx/io.h"
 #include "sx/os.h"
 #include "sx/string.h"
 #include "sx/threads.h"
 #include "sx/lockless.h"
 
+#include <limits.h>
+#include <time.h>
+
 #if SX_PLATFORM_ANDROID
 #    include <android/asset_manager.h>
 #    include <android/asset_manager_jni.h>
@@ -44,21 +49,66 @@ typedef struct efsw__result {
 } efsw__result;
 #endif    // RIZZ_CONFIG_HOT_LOADING
 
-typedef enum { VFS_COMMAND_READ, VFS_COMMAND_WRITE } rizz__vfs_async_command;
+#define RIZZ__VFS_REMOTE_META_SIGN 0x4d5a5a52    // "RZZM"
+#define RIZZ__VFS_REMOTE_META_VERSION 1
+
+typedef enum {
+    VFS_COMMAND_READ,
+    VFS_COMMAND_WRITE,
+    VFS_COMMAND_REMOTE_READ,    // check the cache of a remote file, serve it or ask for a fetch
+    VFS_COMMAND_REMOTE_STORE    // http response is received, update the cache and serve it
+} rizz__vfs_async_command;
 
 typedef enum {
     VFS_RESPONSE_READ_FAILED,
     VFS_RESPONSE_READ_OK,
     VFS_RESPONSE_WRITE_FAILED,
-    VFS_RESPONSE_WRITE_OK
+    VFS_RESPONSE_WRITE_OK,
+    VFS_RESPONSE_REMOTE_FETCH    // cache is missing or stale, main thread sends the http request
 } rizz__vfs_response_code;
 
+// cache entry of a remote file, stored in "<cache_dir>/http/<url-hash>.meta"
+// content is stored separately, addressed by its hash: "<cache_dir>/http/<content-hash>.bin"
+typedef struct {
+    uint32_t sign;
+    uint32_t version;
+    uint64_t content_hash;
+    int64_t size;
+    int64_t fetch_time;    // unix time of the last fetch or revalidation
+    char etag[128];
+    char last_modified[64];
+} rizz__vfs_remote_meta;
+
+// state of a single remote read, passed between main thread and the worker with the queues
+typedef struct {
+    char path[RIZZ_MAX_PATH];    // vfs path, reported back to callbacks
+    char url[RIZZ_MAX_PATH];
+    char cache_dir[RIZZ_MAX_PATH];
+    uint64_t url_hash;
+    const sx_alloc* alloc;
+    rizz_vfs_flags flags;
+    int max_age;
+    int64_t range_offset;
+    int range_size;    // 0: whole file
+    bool cached;       // `meta` is valid and content file exists
+    rizz__vfs_remote_meta meta;
+
+    // http response
+    int status_code;    // 0 if request failed
+    sx_mem_block* body;
+    char etag[128];
+    char last_modified[64];
+} rizz__vfs_remote_fetch;
+
 typedef struct {
     rizz__vfs_async_command cmd;
     rizz_vfs_flags flags;
     char path[RIZZ_MAX_PATH];
     sx_mem_block* write_mem;
     const sx_alloc* alloc;
+    int64_t range_offset;
+    int range_size;    // 0: whole file
+    rizz__vfs_remote_fetch* remote;
 } rizz__vfs_async_request;
 
 typedef struct {
@@ -69,6 +119,7 @@ typedef struct {
     };
     int write_bytes;    // on writes, it's the number of written bytes. on reads, it's 0
     char path[RIZZ_MAX_PATH];
+    rizz__vfs_remote_fetch* remote;
 } rizz__vfs_async_response;
 
 typedef struct {
@@ -81,9 +132,19 @@ typedef struct {
 #endif
 } rizz__vfs_mount_point;
 
+typedef struct {
+    char url[RIZZ_MAX_PATH];    // base url, without trailing '/'
+    char alias[RIZZ_MAX_PATH];
+    int alias_len;
+    char cache_dir[RIZZ_MAX_PATH];
+    int max_age;
+} rizz__vfs_remote_mount;
+
 typedef struct {
     const sx_alloc* alloc;
     rizz__vfs_mount_point* mounts;
+    rizz__vfs_remote_mount* remotes;    // sx_array
+    rizz__vfs_remote_fetch** fetches;   // sx_array: waiting for http response (main thread)
     rizz_vfs_async_callbacks callbacks;
     sx_thread* worker_thrd;
     sx_queue_spsc* req_queue;    // producer: main, consumer: worker, data: rizz__vfs_async_request
@@ -198,6 +259,309 @@ static sx_mem_block* rizz__vfs_read_asset_android(const char* path, const sx_all
 }
 #endif
 
+// loads `size` bytes of the file from `offset`, `size` = 0 loads the whole file
+// text files are null-terminated, like `sx_file_load_text`
+static sx_mem_block* rizz__vfs_load_file(const char* filepath, int64_t offset, int size,
+                                         rizz_vfs_flags flags, const sx_alloc* alloc)
+{
+    if (size == 0 && offset == 0) {
+        return !(flags & RIZZ_VFS_FLAG_TEXT_FILE) ? sx_file_load_bin(alloc, filepath)
+                                                  : sx_file_load_text(alloc, filepath);
+    }
+
+    sx_file_reader reader;
+    if (!sx_file_open_reader(&reader, filepath))
+        return NULL;
+
+    sx_mem_block* mem = NULL;
+    int64_t file_size = sx_file_seekr(&reader, 0, SX_WHENCE_END);
+    if (offset < file_size) {
+        int64_t count = (size > 0) ? sx_min(file_size - offset, (int64_t)size) : file_size - offset;
+        sx_assert(count < INT_MAX - 1);
+        bool text = (flags & RIZZ_VFS_FLAG_TEXT_FILE) != 0;
+        mem = sx_mem_create_block(alloc, (int)count + (text ? 1 : 0), NULL, 0);
+        if (mem) {
+            sx_file_seekr(&reader, offset, SX_WHENCE_BEGIN);
+            if (sx_file_read(&reader, mem->data, (int)count) == (int)count) {
+                if (text)
+                    ((char*)mem->data)[count] = '\0';
+            } else {
+                sx_mem_destroy_block(mem);
+                mem = NULL;
+            }
+        }
+    }
+    sx_file_close_reader(&reader);
+    return mem;
+}
+
+static const rizz__vfs_remote_mount* rizz__vfs_find_remote(const char* path)
+{
+    for (int i = 0, c = sx_array_count(g_vfs.remotes); i < c; i++) {
+        const rizz__vfs_remote_mount* rm = &g_vfs.remotes[i];
+        if (sx_strnequal(path, rm->alias, rm->alias_len))
+            return rm;
+    }
+    return NULL;
+}
+
+static void rizz__vfs_remote_meta_path(char* out_path, int out_path_sz, const char* cache_dir,
+                                       uint64_t url_hash)
+{
+    char filename[32];
+    sx_snprintf(filename, sizeof(filename), "%016llx.meta", (unsigned long long)url_hash);
+    sx_os_path_join(out_path, out_path_sz, cache_dir, filename);
+}
+
+static void rizz__vfs_remote_content_path(char* out_path, int out_path_sz, const char* cache_dir,
+                                          uint64_t content_hash)
+{
+    char filename[32];
+    sx_snprintf(filename, sizeof(filename), "%016llx.bin", (unsigned long long)content_hash);
+    sx_os_path_join(out_path, out_path_sz, cache_dir, filename);
+}
+
+// loads cache entry of the fetch into `f->meta`, returns true if the content is available
+static bool rizz__vfs_remote_load_meta(rizz__vfs_remote_fetch* f)
+{
+    char filepath[RIZZ_MAX_PATH];
+    rizz__vfs_remote_meta_path(filepath, sizeof(filepath), f->cache_dir, f->url_hash);
+
+    sx_file_reader reader;
+    if (!sx_file_open_reader(&reader, filepath))
+        return false;
+    int r = sx_file_read_var(&reader, f->meta);
+    sx_file_close_reader(&reader);
+    if (r != (int)sizeof(f->meta) || f->meta.sign != RIZZ__VFS_REMOTE_META_SIGN ||
+        f->meta.version != RIZZ__VFS_REMOTE_META_VERSION) {
+        sx_memset(&f->meta, 0x0, sizeof(f->meta));
+        return false;
+    }
+
+    rizz__vfs_remote_content_path(filepath, sizeof(filepath), f->cache_dir,
+                                  f->meta.content_hash);
+    sx_file_info info = sx_os_stat(filepath);
+    return info.type == SX_FILE_TYPE_REGULAR && (int64_t)info.size == f->meta.size;
+}
+
+static bool rizz__vfs_remote_save_meta(const rizz__vfs_remote_fetch* f)
+{
+    char filepath[RIZZ_MAX_PATH];
+    rizz__vfs_remote_meta_path(filepath, sizeof(filepath), f->cache_dir, f->url_hash);
+
+    sx_file_writer writer;
+    if (!sx_file_open_writer(&writer, filepath, 0))
+        return false;
+    int r = sx_file_write_var(&writer, f->meta);
+    sx_file_close_writer(&writer);
+    return r == (int)sizeof(f->meta);
+}
+
+static sx_mem_block* rizz__vfs_remote_load_cached(const rizz__vfs_remote_fetch* f)
+{
+    // empty content is valid for remote files, file loaders treat empty files as failures
+    if (f->meta.size == 0) {
+        if (f->range_offset > 0)
+            return NULL;
+        int text_pad = (f->flags & RIZZ_VFS_FLAG_TEXT_FILE) ? 1 : 0;
+        sx_mem_block* mem = sx_mem_create_block(f->alloc, text_pad, NULL, 0);
+        if (mem && text_pad)
+            ((char*)mem->data)[0] = '\0';
+        return mem;
+    }
+
+    char filepath[RIZZ_MAX_PATH];
+    rizz__vfs_remote_content_path(filepath, sizeof(filepath), f->cache_dir,
+                                  f->meta.content_hash);
+    return rizz__vfs_load_file(filepath, f->range_offset, f->range_size, f->flags, f->alloc);
+}
+
+// writes the received content to the cache, the file is written to a temp file first and then
+// renamed, so an interrupted write never leaves a corrupt entry behind
+static bool rizz__vfs_remote_save_content(rizz__vfs_remote_fetch* f, const void* data, int size)
+{
+    uint64_t content_hash = sx_hash_xxh64(data, (size_t)size, 0);
+    char filepath[RIZZ_MAX_PATH];
+    char tmp_filepath[RIZZ_MAX_PATH];
+    rizz__vfs_remote_content_path(filepath, sizeof(filepath), f->cache_dir, content_hash);
+
+    sx_file_info info = sx_os_stat(filepath);
+    if (info.type != SX_FILE_TYPE_REGULAR || info.size != (uint64_t)size) {
+        sx_snprintf(tmp_filepath, sizeof(tmp_filepath), "%s.tmp", filepath);
+        sx_file_writer writer;
+        if (!sx_file_open_writer(&writer, tmp_filepath, 0))
+            return false;
+        int written = sx_file_write(&writer, data, size);
+        sx_file_close_writer(&writer);
+        if (written != size || !sx_os_rename(tmp_filepath, filepath)) {
+            sx_os_del(tmp_filepath, SX_FILE_TYPE_REGULAR);
+            return false;
+        }
+    }
+
+    // content of the url has changed, remove the old one. if it's also referenced by another
+    // url, that entry fails to load and is fetched again
+    if (f->cached && f->meta.content_hash != content_hash) {
+        rizz__vfs_remote_content_path(tmp_filepath, sizeof(tmp_filepath), f->cache_dir,
+                                      f->meta.content_hash);
+        sx_os_del(tmp_filepath, SX_FILE_TYPE_REGULAR);
+    }
+
+    f->meta = (rizz__vfs_remote_meta){ .sign = RIZZ__VFS_REMOTE_META_SIGN,
+                                       .version = RIZZ__VFS_REMOTE_META_VERSION,
+                                       .content_hash = content_hash,
+                                       .size = size,
+                                       .fetch_time = (int64_t)time(NULL) };
+    sx_strcpy(f->meta.etag, sizeof(f->meta.etag), f->etag);
+    sx_strcpy(f->meta.last_modified, sizeof(f->meta.last_modified), f->last_modified);
+    return rizz__vfs_remote_save_meta(f);
+}
+
+// worker: http response of the fetch is received, updates the cache and returns the data
+static sx_mem_block* rizz__vfs_remote_store(rizz__vfs_remote_fetch* f)
+{
+    int text_pad = (f->flags & RIZZ_VFS_FLAG_TEXT_FILE) ? 1 : 0;
+    sx_mem_block* body = f->body;
+    f->body = NULL;
+
+    switch (f->status_code) {
+    case 200: {
+        int size = body->size - text_pad;
+        if (!rizz__vfs_remote_save_content(f, body->data, size))
+            rizz_log_warn("vfs: could not write cache for '%s'", f->url);
+
+        // server may ignore the range and send the whole file
+        if (f->range_size > 0 || f->range_offset > 0) {
+            sx_mem_block* mem = NULL;
+            if (f->range_offset < size) {
+                int count = size - (int)f->range_offset;
+                if (f->range_size > 0)
+                    count = sx_min(count, f->range_size);
+                mem = sx_mem_create_block(f->alloc, count + text_pad,
+                                          (uint8_t*)body->data + f->range_offset, 0);
+                if (mem && text_pad)
+                    ((char*)mem->data)[count] = '\0';
+            }
+            sx_mem_destroy_block(body);
+            return mem;
+        }
+        return body;
+    }
+
+    case 206:
+        // partial content is not cached
+        return body;
+
+    case 304:
+        f->meta.fetch_time = (int64_t)time(NULL);
+        rizz__vfs_remote_save_meta(f);
+        return rizz__vfs_remote_load_cached(f);
+
+    default:
+        if (body)
+            sx_mem_destroy_block(body);
+        if (f->cached) {
+            rizz_log_warn("vfs: fetching '%s' failed (status: %d), using cached content", f->url,
+                          f->status_code);
+            return rizz__vfs_remote_load_cached(f);
+        }
+        rizz_log_error("vfs: fetching '%s' failed (status: %d)", f->url, f->status_code);
+        return NULL;
+    }
+}
+
+// main thread: http request of the fetch is finished, hands the response to the worker
+static void rizz__vfs_remote_http_cb(const rizz_http_state* http, void* user)
+{
+    rizz__vfs_remote_fetch* f = user;
+
+    // fetches are released with the vfs, don't touch the ones that are not in flight anymore
+    int index = -1;
+    for (int i = 0, c = sx_array_count(g_vfs.fetches); i < c; i++) {
+        if (g_vfs.fetches[i] == f) {
+            index = i;
+            break;
+        }
+    }
+    if (index == -1)
+        return;
+    sx_array_pop(g_vfs.fetches, index);
+
+    f->status_code = http->status == RIZZ_HTTP_COMPLETED ? http->status_code : 0;
+    if (f->status_code == 200 || f->status_code == 206) {
+        // empty body is a valid response, the file is changed to an empty one on the server
+        int text_pad = (f->flags & RIZZ_VFS_FLAG_TEXT_FILE) ? 1 : 0;
+        sx_assert(http->response_size < INT_MAX - 1);
+        f->body = sx_mem_create_block(f->alloc, (int)http->response_size + text_pad,
+                                      http->response_data, 0);
+        if (f->body) {
+            if (text_pad)
+                ((char*)f->body->data)[http->response_size] = '\0';
+        } else {
+            f->status_code = 0;
+        }
+        the__http.header(http, "etag", f->etag, sizeof(f->etag));
+        the__http.header(http, "last-modified", f->last_modified, sizeof(f->last_modified));
+    }
+
+    rizz__vfs_async_request req = { .cmd = VFS_COMMAND_REMOTE_STORE, .remote = f };
+    sx_queue_spsc_produce_and_grow(g_vfs.req_queue, &req, g_vfs.alloc);
+    sx_semaphore_post(&g_vfs.worker_sem, 1);
+}
+
+// main thread: sends the http request, conditional if there is a cached entry
+static void rizz__vfs_remote_fetch_url(rizz__vfs_remote_fetch* f)
+{
+    char headers[512];
+    headers[0] = '\0';
+    if (f->cached) {
+        char line[256];
+        if (f->meta.etag[0]) {
+            sx_snprintf(line, sizeof(line), "If-None-Match: %s\r\n", f->meta.etag);
+            sx_strcat(headers, sizeof(headers), line);
+        }
+        if (f->meta.last_modified[0]) {
+            sx_snprintf(line, sizeof(line), "If-Modified-Since: %s\r\n", f->meta.last_modified);
+            sx_strcat(headers, sizeof(headers), line);
+        }
+    } else if (f->range_size > 0) {
+        sx_snprintf(headers, sizeof(headers), "Range: bytes=%lld-%lld\r\n",
+                    (long long)f->range_offset, (long long)(f->range_offset + f->range_size - 1));
+    } else if (f->range_offset > 0) {
+        sx_snprintf(headers, sizeof(headers), "Range: bytes=%lld-\r\n",
+                    (long long)f->range_offset);
+    }
+
+    sx_array_push(g_vfs.alloc, g_vfs.fetches, f);
+    the__http.get_cb_headers(f->url, headers, rizz__vfs_remote_http_cb, f);
+}
+
+static rizz__vfs_remote_fetch* rizz__vfs_remote_create_fetch(const rizz__vfs_remote_mount* rm,
+                                                             const char* path,
+                                                             rizz_vfs_flags flags,
+                                                             const sx_alloc* alloc)
+{
+    rizz__vfs_remote_fetch* f = sx_malloc(g_vfs.alloc, sizeof(rizz__vfs_remote_fetch));
+    if (!f) {
+        sx_out_of_memory();
+        return NULL;
+    }
+    sx_memset(f, 0x0, sizeof(*f));
+
+    const char* relpath = path + rm->alias_len;
+    sx_strcpy(f->path, sizeof(f->path), path);
+    sx_strcpy(f->url, sizeof(f->url), rm->url);
+    if (relpath[0] != '/')
+        sx_strcat(f->url, sizeof(f->url), "/");
+    sx_strcat(f->url, sizeof(f->url), relpath);
+    sx_strcpy(f->cache_dir, sizeof(f->cache_dir), rm->cache_dir);
+    f->url_hash = sx_hash_xxh64(f->url, (size_t)sx_strlen(f->url), 0);
+    f->alloc = alloc ? alloc : g_vfs.alloc;
+    f->flags = flags;
+    f->max_age = rm->max_age;
+    return f;
+}
+
 static sx_mem_block* rizz__vfs_read(const char* path, rizz_vfs_flags flags, const sx_alloc* alloc)
 {
     if (!alloc)
@@ -216,6 +580,19 @@ static sx_mem_block* rizz__vfs_read(const char* path, rizz_vfs_flags flags, cons
         rizz__vfs_resolve_path(resolved_path, sizeof(resolved_path), path, flags);    
     }
 #else
+    // remote files are only served from the cache, synchronous reads never touch the network
+    const rizz__vfs_remote_mount* rm = rizz__vfs_find_remote(path);
+    if (rm && !(flags & RIZZ_VFS_FLAG_ABSOLUTE_PATH)) {
+        rizz__vfs_remote_fetch* f = rizz__vfs_remote_create_fetch(rm, path, flags, alloc);
+        sx_mem_block* mem = NULL;
+        if (f) {
+            if (rizz__vfs_remote_load_meta(f))
+                mem = rizz__vfs_remote_load_cached(f);
+            sx_free(g_vfs.alloc, f);
+        }
+        return mem;
+    }
+
     rizz__vfs_resolve_path(resolved_path, sizeof(resolved_path), path, flags);
 #endif
 
@@ -232,6 +609,11 @@ static int rizz__vfs_write(const char* path, const sx_mem_block* mem, rizz_vfs_f
     }
 #endif
 
+    if (rizz__vfs_find_remote(path) && !(flags & RIZZ_VFS_FLAG_ABSOLUTE_PATH)) {
+        rizz_log_error("vfs: cannot write to remote path: %s", path);
+        return -1;
+    }
+
     char resolved_path[RIZZ_MAX_PATH];
     sx_file_writer writer;
 
@@ -257,11 +639,21 @@ static int rizz__vfs_worker(void* user1, void* user2)
             rizz__vfs_async_response res;
             res.read_mem = NULL;
             res.write_bytes = 0;
+            res.remote = NULL;
             sx_strcpy(res.path, sizeof(res.path), req.path);
 
             switch (req.cmd) {
             case VFS_COMMAND_READ: {
-                sx_mem_block* mem = rizz__vfs_read(req.path, req.flags, req.alloc);
+                sx_mem_block* mem;
+                if (req.range_size == 0 && req.range_offset == 0) {
+                    mem = rizz__vfs_read(req.path, req.flags, req.alloc);
+                } else {
+                    char resolved_path[RIZZ_MAX_PATH];
+                    rizz__vfs_resolve_path(resolved_path, sizeof(resolved_path), req.path,
+                                           req.flags);
+                    mem = rizz__vfs_load_file(resolved_path, req.range_offset, req.range_size,
+                                              req.flags, req.alloc ? req.alloc : g_vfs.alloc);
+                }
 
                 if (mem) {
                     res.code = VFS_RESPONSE_READ_OK;
@@ -286,6 +678,33 @@ static int rizz__vfs_worker(void* user1, void* user2)
                 sx_queue_spsc_produce_and_grow(g_vfs.res_queue, &res, g_vfs.alloc);
                 break;
             }
+
+            case VFS_COMMAND_REMOTE_READ: {
+                rizz__vfs_remote_fetch* f = req.remote;
+                sx_strcpy(res.path, sizeof(res.path), f->path);
+                f->cached = rizz__vfs_remote_load_meta(f);
+                if (f->cached &&
+                    (f->max_age < 0 || (int64_t)time(NULL) - f->meta.fetch_time < f->max_age)) {
+                    res.read_mem = rizz__vfs_remote_load_cached(f);
+                    res.code = res.read_mem ? VFS_RESPONSE_READ_OK : VFS_RESPONSE_READ_FAILED;
+                    sx_free(g_vfs.alloc, f);
+                } else {
+                    res.code = VFS_RESPONSE_REMOTE_FETCH;
+                    res.remote = f;
+                }
+                sx_queue_spsc_produce_and_grow(g_vfs.res_queue, &res, g_vfs.alloc);
+                break;
+            }
+
+            case VFS_COMMAND_REMOTE_STORE: {
+                rizz__vfs_remote_fetch* f = req.remote;
+                sx_strcpy(res.path, sizeof(res.path), f->path);
+                res.read_mem = rizz__vfs_remote_store(f);
+                res.code = res.read_mem ? VFS_RESPONSE_READ_OK : VFS_RESPONSE_READ_FAILED;
+                sx_free(g_vfs.alloc, f);
+                sx_queue_spsc_produce_and_grow(g_vfs.res_queue, &res, g_vfs.alloc);
+                break;
+            }
             }
         }    // if (queue_consume)
 
@@ -293,6 +712,7 @@ static int rizz__vfs_worker(void* user1, void* user2)
         sx_semaphore_wait(&g_vfs.worker_sem, -1);
     }
 
+    rizz__core_thread_exit();
     return 0;
 }
 
@@ -342,6 +762,46 @@ void rizz__vfs_mount_mobile_assets(const char* alias)
 #endif
 }
 
+static bool rizz__vfs_mount_remote(const char* url, const char* alias, int max_age)
+{
+    if (!sx_strnequalnocase(url, "http://", 7)) {
+        rizz_log_error("vfs: remote mount url is not valid (only http:// is supported): %s", url);
+        return false;
+    }
+
+    const char* cache_dir = the__core.cache_dir();
+    if (!cache_dir) {
+        rizz_log_error("vfs: remote mount needs a cache directory, see `set_cache_dir`");
+        return false;
+    }
+
+    rizz__vfs_remote_mount rm = { .max_age = max_age };
+    sx_strcpy(rm.url, sizeof(rm.url), url);
+    int url_len = sx_strlen(rm.url);
+    while (url_len > 7 && rm.url[url_len - 1] == '/')
+        rm.url[--url_len] = '\0';
+    sx_os_path_unixpath(rm.alias, sizeof(rm.alias), alias);
+    rm.alias_len = sx_strlen(rm.alias);
+
+    sx_os_path_join(rm.cache_dir, sizeof(rm.cache_dir), cache_dir, "http");
+    if (!sx_os_path_isdir(rm.cache_dir) && !sx_os_mkdir(rm.cache_dir)) {
+        rizz_log_error("vfs: could not create cache directory: %s", rm.cache_dir);
+        return false;
+    }
+
+    for (int i = 0, c = sx_array_count(g_vfs.remotes); i < c; i++) {
+        if (sx_strequal(g_vfs.remotes[i].alias, rm.alias)) {
+            rizz_log_error("vfs: alias '%s' is already mounted on '%s'", rm.alias,
+                           g_vfs.remotes[i].url);
+            return false;
+        }
+    }
+
+    sx_array_push(g_vfs.alloc, g_vfs.remotes, rm);
+    rizz_log_info("vfs: mounted '%s' on '%s'", rm.alias, rm.url);
+    return true;
+}
+
 bool rizz__vfs_init(const sx_alloc* alloc)
 {
     g_vfs.alloc = alloc;
@@ -392,10 +852,32 @@ void rizz__vfs_release()
         sx_semaphore_release(&g_vfs.worker_sem);
     }
 
-    if (g_vfs.req_queue)
+    // remote fetches that are still queued or waiting for the http response (http module is
+    // released before vfs and never calls back the requests in flight)
+    for (int i = 0, c = sx_array_count(g_vfs.fetches); i < c; i++) {
+        sx_free(g_vfs.alloc, g_vfs.fetches[i]);
+    }
+    sx_array_free(g_vfs.alloc, g_vfs.fetches);
+
+    if (g_vfs.req_queue) {
+        rizz__vfs_async_request req;
+        while (sx_queue_spsc_consume(g_vfs.req_queue, &req)) {
+            if (req.remote) {
+                if (req.remote->body)
+                    sx_mem_destroy_block(req.remote->body);
+                sx_free(g_vfs.alloc, req.remote);
+            }
+        }
         sx_queue_spsc_destroy(g_vfs.req_queue, g_vfs.alloc);
-    if (g_vfs.res_queue)
+    }
+    if (g_vfs.res_queue) {
+        rizz__vfs_async_response res;
+        while (sx_queue_spsc_consume(g_vfs.res_queue, &res)) {
+            if (res.remote)
+                sx_free(g_vfs.alloc, res.remote);
+        }
         sx_queue_spsc_destroy(g_vfs.res_queue, g_vfs.alloc);
+    }
 
 #if RIZZ_CONFIG_HOT_LOADING
     if (g_vfs.watcher) {
@@ -412,6 +894,7 @@ void rizz__vfs_release()
 #endif
 
     sx_array_free(g_vfs.alloc, g_vfs.mounts);
+    sx_array_free(g_vfs.alloc, g_vfs.remotes);
     g_vfs.alloc = NULL;
 }
 
@@ -445,6 +928,10 @@ void rizz__vfs_async_update()
         case VFS_RESPONSE_WRITE_FAILED:
             g_vfs.callbacks.on_write_error(res.path);
             break;
+
+        case VFS_RESPONSE_REMOTE_FETCH:
+            rizz__vfs_remote_fetch_url(res.remote);
+            break;
         }
     }
 
@@ -466,14 +953,35 @@ void rizz__vfs_async_update()
 #endif
 }
 
-static void rizz__vfs_read_async(const char* path, rizz_vfs_flags flags, const sx_alloc* alloc)
+static void rizz__vfs_read_range_async(const char* path, int64_t offset, int size,
+                                       rizz_vfs_flags flags, const sx_alloc* alloc)
 {
-    rizz__vfs_async_request req = { .cmd = VFS_COMMAND_READ, .flags = flags, .alloc = alloc };
+    sx_assert(offset >= 0 && size >= 0);
+
+    rizz__vfs_async_request req = { .cmd = VFS_COMMAND_READ,
+                                    .flags = flags,
+                                    .alloc = alloc,
+                                    .range_offset = offset,
+                                    .range_size = size };
+    const rizz__vfs_remote_mount* rm = rizz__vfs_find_remote(path);
+    if (rm && !(flags & RIZZ_VFS_FLAG_ABSOLUTE_PATH)) {
+        req.cmd = VFS_COMMAND_REMOTE_READ;
+        req.remote = rizz__vfs_remote_create_fetch(rm, path, flags, alloc);
+        if (!req.remote)
+            return;
+        req.remote->range_offset = offset;
+        req.remote->range_size = size;
+    }
     sx_strcpy(req.path, sizeof(req.path), path);
     sx_queue_spsc_produce_and_grow(g_vfs.req_queue, &req, g_vfs.alloc);
     sx_semaphore_post(&g_vfs.worker_sem, 1);
 }
 
+static void rizz__vfs_read_async(const char* path, rizz_vfs_flags flags, const sx_alloc* alloc)
+{
+    rizz__vfs_read_range_async(path, 0, 0, flags, alloc);
+}
+
 static void rizz__vfs_write_async(const char* path, sx_mem_block* mem, rizz_vfs_flags flags)
 {
     rizz__vfs_async_request req = { .cmd = VFS_COMMAND_WRITE, .flags = flags, .write_mem = mem };
@@ -573,8 +1081,10 @@ static void efsw__fileaction_cb(efsw_watcher watcher, efsw_watchid watchid, cons
 rizz_api_vfs the__vfs = { .set_async_callbacks = rizz__vfs_set_async_callbacks,
                           .mount = rizz__vfs_mount,
                           .mount_mobile_assets = rizz__vfs_mount_mobile_assets,
+                          .mount_remote = rizz__vfs_mount_remote,
                           .watch_mounts = rizz__vfs_watch_mounts,
                           .read_async = rizz__vfs_read_async,
+                          .read_range_async = rizz__vfs_read_range_async,
                           .write_async = rizz__vfs_write_async,
                           .read = rizz__vfs_read,
                           .write = rizz__vfs_write,
@@ -32,6 +32,7 @@ RIZZ_STATE static rizz_api_core* the_core;
 RIZZ_STATE static rizz_api_asset* the_asset;
 RIZZ_STATE static rizz_api_refl* the_refl;
 RIZZ_STATE static rizz_api_imgui* the_imgui;
+RIZZ_STATE static rizz_api_app* the_app;
 
 RIZZ_STATE static const sx_alloc* g_snd_alloc;
 
@@ -171,6 +172,7 @@ typedef struct snd__context {
     snd__bus buses[RIZZ_SND_DEVICE_MAX_BUSES];
     rizz_snd_source silence_src;
     rizz_snd_source beep_src;
+    bool null_device;    // headless: no audio device, mixer output is consumed in `snd__update`
 } snd__context;
 
 RIZZ_STATE static snd__context g_snd;
@@ -498,6 +500,14 @@ static void snd__on_release(rizz_asset_obj obj, const sx_alloc* alloc)
     snd__destroy_source(srchandle, alloc ? alloc : g_snd_alloc);
 }
 
+static int64_t snd__on_get_size(rizz_asset_obj obj, const void* metadata, rizz_mem_id* memid)
+{
+    sx_unused(metadata);
+    const snd__source* src = &g_snd.sources[sx_handle_index((uint32_t)obj.id)];
+    *memid = RIZZ_MEMID_AUDIO;
+    return (int64_t)src->num_frames * sizeof(float) + sizeof(snd__source);
+}
+
 static void snd__on_read_metadata(void* metadata, const rizz_asset_load_params* params,
                                   const sx_mem_block* mem)
 {
@@ -539,6 +549,16 @@ static void snd__on_read_metadata(void* metadata, const rizz_asset_load_params*
     }
 }
 
+static int snd__device_channels()
+{
+    return !g_snd.null_device ? saudio_channels() : RIZZ_SND_DEVICE_NUM_CHANNELS;
+}
+
+static int snd__device_sample_rate()
+{
+    return !g_snd.null_device ? saudio_sample_rate() : RIZZ_SND_DEVICE_SAMPLE_RATE;
+}
+
 static void snd__stream_cb(float* buffer, int num_frames, int num_channels)
 {
     int r = snd__ringbuffer_consume(&g_snd.mixer_buffer, buffer, num_frames * num_channels) /
@@ -649,11 +669,14 @@ static bool snd__init()
         return false;
     }
 
-    saudio_setup(&(saudio_desc){ .sample_rate = RIZZ_SND_DEVICE_SAMPLE_RATE,
-                                 .num_channels = RIZZ_SND_DEVICE_NUM_CHANNELS,
-                                 .stream_cb = snd__stream_cb,
-                                 .buffer_frames = RIZZ_SND_DEVICE_BUFFER_FRAMES,
-                                 .num_packets = 32 });
+    g_snd.null_device = the_app->headless();
+    if (!g_snd.null_device) {
+        saudio_setup(&(saudio_desc){ .sample_rate = RIZZ_SND_DEVICE_SAMPLE_RATE,
+                                     .num_channels = RIZZ_SND_DEVICE_NUM_CHANNELS,
+                                     .stream_cb = snd__stream_cb,
+                                     .buffer_frames = RIZZ_SND_DEVICE_BUFFER_FRAMES,
+                                     .num_packets = 32 });
+    }
 
     // silent/beep source sources
     g_snd.beep_src =
@@ -675,7 +698,8 @@ static bool snd__init()
                                 .on_finalize = snd__on_finalize,
                                 .on_reload = snd__on_reload,
                                 .on_release = snd__on_release,
-                                .on_read_metadata = snd__on_read_metadata },
+                                .on_read_metadata = snd__on_read_metadata,
+                                .on_get_size = snd__on_get_size },
         "rizz_snd_load_params", sizeof(rizz_snd_load_params), "snd__metadata",
         sizeof(snd__metadata), (rizz_asset_obj){ .id = g_snd.beep_src.id },
         (rizz_asset_obj){ .id = g_snd.silence_src.id }, 0);
@@ -701,7 +725,9 @@ static bool snd__init()
 
 static void snd__release()
 {
-    saudio_shutdown();
+    if (!g_snd.null_device) {
+        saudio_shutdown();
+    }
 
     if (g_snd.cmd_buffers) {
         for (int i = 0; i < g_snd.num_cmdbuffers; i++) {
@@ -1057,8 +1083,8 @@ static void snd__mix(float* dst, int dst_num_frames, int dst_num_channels, int d
 
 static void snd__update(float dt)
 {
-    int device_channels = saudio_channels();
-    int device_sample_rate = saudio_sample_rate();
+    int device_channels = snd__device_channels();
+    int device_sample_rate = snd__device_sample_rate();
 
     // update clocked items
     for (int i = 0, c = sx_array_count(g_snd.clocked); i < c; i++) {
@@ -1111,6 +1137,20 @@ static void snd__update(float dt)
 
         the_core->tmp_alloc_pop();
     }
+
+    // null device: play out the time of this frame, so instances advance and finish as usual
+    if (g_snd.null_device) {
+        int frames_played = sx_min((int)(dt * (float)device_sample_rate),
+                                   g_snd.mixer_buffer.capacity / device_channels);
+        if (frames_played > 0) {
+            const sx_alloc* tmp_alloc = the_core->tmp_alloc_push();
+            float* frames = sx_malloc(tmp_alloc, sizeof(float) * frames_played * device_channels);
+            if (frames) {
+                snd__stream_cb(frames, frames_played, device_channels);
+            }
+            the_core->tmp_alloc_pop();
+        }
+    }
 }
 
 static void snd__plot_samples_rms(const char* label, const float* samples, int num_samples,
@@ -1207,15 +1247,15 @@ static void snd__plot_samples_wav(const char* label, const float* samples, int n
 
 static void snd__show_mixer_tab_contents()
 {
-    the_imgui->LabelText("sample_rate", "%d", saudio_sample_rate());
-    the_imgui->LabelText("channels", "%d", saudio_channels());
+    the_imgui->LabelText("sample_rate", "%d", snd__device_sample_rate());
+    the_imgui->LabelText("channels", "%d", snd__device_channels());
     the_imgui->SliderFloat("master", &g_snd.master_volume, 0.0f, 1.2f, "%.1f", 1.0f);
     the_imgui->SliderFloat("pan", &g_snd.master_pan, -1.0f, 1.0f, "%.1f", 1.0f);
 
     // plot samples
     static float plot_scale = 1.0f;
     const sx_alloc* tmp_alloc = the_core->tmp_alloc_push();
-    int num_channels = saudio_channels();
+    int num_channels = snd__device_channels();
     int num_samples = RIZZ_SND_DEVICE_BUFFER_FRAMES * num_channels;
     float* samples = sx_malloc(tmp_alloc, sizeof(float) * num_samples);
     if (!samples) {
@@ -1810,6 +1850,7 @@ rizz_plugin_decl_main(sound, plugin, e)
         the_core = the_plugin->get_api(RIZZ_API_CORE, 0);
         the_asset = the_plugin->get_api(RIZZ_API_ASSET, 0);
         the_refl = the_plugin->get_api(RIZZ_API_REFLECT, 0);
+        the_app = the_plugin->get_api(RIZZ_API_APP, 0);
         the_imgui = the_plugin->get_api_byname("imgui", 0);
 
         if (!snd__init()) {
@@ -2,10 +2,12 @@
 
 #include "sx/allocator.h"
 #include "sx/array.h"
+#include "sx/atomic.h"
 #include "sx/handle.h"
 #include "sx/hash.h"
 #include "sx/os.h"
 #include "sx/pool.h"
+#include "sx/simd.h"
 #include "sx/string.h"
 
 #include "rizz/app.h"
@@ -27,10 +29,31 @@
 #include rizz_shader_path(shaders_h, sprite.vert.h)
 #include rizz_shader_path(shaders_h, sprite_wire.vert.h)
 #include rizz_shader_path(shaders_h, sprite_wire.frag.h)
+#include rizz_shader_path(shaders_h, sprite_inst.vert.h)
+#include rizz_shader_path(shaders_h, sprite_inst.frag.h)
 
 #define MAX_VERTICES 2000
 #define MAX_INDICES 6000
 #define ANIMCTRL_PARAM_ID_END INT_MAX
+#define ANIMCLIP_JOB_THRESHOLD 4096    // minimum number of clips to dispatch batch update to jobs
+
+// dynamic atlas: small standalone textures are packed into shared pages at runtime
+#define DYNATLAS_PAGE_SIZE 2048
+#define DYNATLAS_MAX_PAGES 4
+#define DYNATLAS_MAX_TEXTURE_SIZE 256    // bigger textures are drawn from their own image
+#define DYNATLAS_PADDING 2               // texels around each region, filled with edge texels
+#define DYNATLAS_MAX_BLITS 64            // maximum number of textures packed per frame
+#define DYNATLAS_BLIT_INSTANCES 5        // center + 4 edges of padding
+
+#define LAYER_CHUNK_SIZE 1024    // instances per layer buffer, buffers are uploaded separately
+
+#define STBRP_STATIC
+#define STBRP_ASSERT(e) sx_assert(e)
+#define STB_RECT_PACK_IMPLEMENTATION
+SX_PRAGMA_DIAGNOSTIC_PUSH()
+SX_PRAGMA_DIAGNOSTIC_IGNORED_CLANG_GCC("-Wunused-function")
+#include "cimgui/imgui/imstb_rectpack.h"
+SX_PRAGMA_DIAGNOSTIC_POP()
 
 RIZZ_STATE static rizz_api_core* the_core;
 RIZZ_STATE static rizz_api_plugin* the_plugin;
@@ -53,6 +76,9 @@ typedef struct sprite__data {
     rizz_sprite_animctrl ctrl;
     sx_rect draw_bounds;    // cropped
     sx_rect bounds;
+    int dynatlas_region;    // index to dynatlas.regions, -1 if not a standalone texture sprite
+    rizz_sprite_layer layer;
+    int layer_slot;
 } sprite__data;
 
 typedef struct atlas__sprite {
@@ -63,6 +89,7 @@ typedef struct atlas__sprite {
     int num_verts;
     int ib_index;
     int vb_index;
+    bool quad;    // geometry is a plain quad (no mesh), can be drawn instanced
 } atlas__sprite;
 
 typedef struct atlas__data {
@@ -80,23 +107,41 @@ typedef struct atlas__metadata {
     int num_indices;
 } atlas__metadata;
 
+// binary atlas format (version 1):
+//  header, followed by the payload with exactly the same layout as atlas__on_prepare buffers:
+//      atlas__sprite[num_sprites]
+//      uint32_t keys[hashtbl_cap]      (sprite_tbl)
+//      int values[hashtbl_cap]         (sprite_tbl)
+//      rizz_sprite_vertex[num_vertices]
+//      uint16_t[num_indices]
+#define ATLAS_BINARY_SIGN sx_makefourcc('R', 'Z', 'A', 'T')
+#define ATLAS_BINARY_VERSION 2
+
+typedef struct atlas__binary_header {
+    uint32_t sign;
+    uint32_t version;
+    int img_width;
+    int img_height;
+    int num_sprites;
+    int num_vertices;
+    int num_indices;
+    int hashtbl_cap;
+    int hashtbl_count;
+    int payload_size;
+    char image[RIZZ_MAX_PATH];    // relative to atlas file directory
+} atlas__binary_header;
+
 typedef struct sprite__animclip_frame {
     int16_t atlas_id;
     int16_t trigger;
     rizz_event e;
 } sprite__animclip_frame;
 
+// cold data of anim-clips, hot state (time, frame, ...) lives in sprite__animclip_state
 typedef struct sprite__animclip {
     rizz_asset atlas;
-    int num_frames;
-    float tm;
-    float fps;
-    float len;
-    int frame_id;
     rizz_sprite_flip flip;
     bool trigger_end_event;
-    bool end_triggered;
-    rizz_event_queue equeue;
     const sx_alloc* alloc;
 
 #if RIZZ_SPRITE_ANIMCLIP_MAX_FRAMES > 0
@@ -106,6 +151,26 @@ typedef struct sprite__animclip {
 #endif
 } sprite__animclip;
 
+// hot state of anim-clips in SoA layout, indexed by animclip handle index
+// all arrays are allocated within a single buffer (starting with `tm`)
+typedef struct sprite__animclip_state {
+    float* tm;
+    float* fps;
+    float* len;
+    int* frame_id;
+    int* num_frames;
+    bool* end_triggered;
+    int capacity;
+} sprite__animclip_state;
+
+typedef struct sprite__animclip_update_data {
+    const rizz_sprite_animclip* handles;
+    const int* indices;    // clip indices, padded to multiple of 4
+    int num_clips;
+    float dt;
+    rizz_sprite_event** job_events;    // sx_array per job thread, only for this dispatch
+} sprite__animclip_update_data;
+
 typedef struct sprite__animctrl_transition sprite__animctrl_transition;
 
 typedef struct sprite__animctrl_state {
@@ -146,19 +211,110 @@ typedef struct sprite__animctrl {
     sprite__animctrl_state* state;
     sprite__animctrl_state* start_state;
     sprite__animctrl_param params[RIZZ_SPRITE_ANIMCTRL_MAX_PARAMS];
-    rizz_event_queue equeue;
     void* buff;
 } sprite__animctrl;
 
 typedef struct sprite__draw_context {
     sg_buffer vbuff[2];
     sg_buffer ibuff;
+    sg_buffer quad_vbuff;    // static unit quad for instanced drawing
+    sg_buffer quad_ibuff;
+    sg_buffer inst_buff;     // stream of rizz_sprite_instance
     sg_shader shader;
     sg_shader shader_wire;
+    sg_shader shader_inst;
     sg_pipeline pip;
     sg_pipeline pip_wire;
+    sg_pipeline pip_inst;
 } sprite__draw_context;
 
+typedef struct sprite__dynatlas_region {
+    rizz_asset texture;     // source texture, zero if the slot is free
+    uint32_t src_img_id;    // image that was packed, detects texture reloads
+    int page;               // -1 if not packed (yet)
+    int ref_count;          // number of sprites that use the region
+    int width;
+    int height;
+    sx_vec2 uv_min;
+    sx_vec2 uv_max;
+    bool rejected;          // texture can't be packed, draw it from it's own image
+} sprite__dynatlas_region;
+
+// sampler state of a texture, as far as the atlas can reproduce it
+// filters are the page's own, repeat wrapping is emulated by the padding texels
+typedef struct sprite__dynatlas_sampler {
+    sg_filter min_filter;
+    sg_filter mag_filter;
+    bool repeat_u;
+    bool repeat_v;
+} sprite__dynatlas_sampler;
+
+// textures are only packed into pages with the same filters
+typedef struct sprite__dynatlas_page {
+    sg_image img;
+    sg_pass pass;
+    sg_filter min_filter;
+    sg_filter mag_filter;
+    stbrp_context ctx;
+    stbrp_node* nodes;
+    int ref_count;            // sum of region references in this page
+    int64_t release_frame;    // frame that ref_count dropped to zero
+} sprite__dynatlas_page;
+
+// unused regions stay in the page as cache, until no region of the page is referenced anymore.
+// then the whole page is evicted and reused (stb_rect_pack can't free single rects)
+typedef struct sprite__dynatlas {
+    sprite__dynatlas_region* regions;    // sx_array
+    sx_hashtbl* region_tbl;              // key: texture.id -> index to regions
+    sprite__dynatlas_page pages[DYNATLAS_MAX_PAGES];
+    int num_pages;
+    uint32_t generation;    // incremented whenever a region is packed/rejected/evicted
+    sg_pipeline pip_blit;
+    sg_buffer blit_buff;
+    bool collect_stats;                  // set by debugger
+    sx_atomic_int num_batches;           // distinct images drawn in current frame
+    sx_atomic_int num_batches_unpacked;  // distinct textures drawn in current frame
+    int stats_batches;                   // last frame's numbers, shown in debugger
+    int stats_batches_unpacked;
+} sprite__dynatlas;
+
+// batches are drawn in slot order, a run of mesh sprites between quads is a batch of it's own
+typedef struct sprite__layer_batch {
+    int start;             // index to chunk instances, or to chunk mesh_slots if `mesh` is set
+    int count;
+    rizz_asset texture;    // image is resolved on draw, texture can be reloaded
+    int page;              // dynamic atlas page, -1 if the texture's own image is used
+    bool mesh;             // drawn with vertex/index buffers (sprite__draw_batch)
+} sprite__layer_batch;
+
+typedef struct sprite__layer_slot {
+    rizz_sprite spr;        // zero if the slot is free
+    sx_mat3 mat;
+    sx_color tint;
+    int atlas_sprite_id;    // frame at the time of last build, detects animation changes
+} sprite__layer_slot;
+
+typedef struct sprite__layer_chunk {
+    sg_buffer buff;
+    rizz_sprite_instance* instances;    // world-space, LAYER_CHUNK_SIZE
+    sprite__layer_batch* batches;       // sx_array
+    int* mesh_slots;                    // sx_array: can't be instanced, drawn every frame
+    int64_t update_frame;               // buffers can be updated once per frame
+    bool dirty;
+    bool dynatlas;                      // has texture sprites, rebuilt when atlas changes
+} sprite__layer_chunk;
+
+typedef struct sprite__layer {
+    sprite__layer_slot* slots;
+    sprite__layer_chunk* chunks;
+    int* free_slots;    // sx_array
+    int* animated;      // sx_array: slots with animclip/animctrl, checked on every draw
+    int num_slots;      // high watermark of used slots
+    int max_slots;
+    int num_chunks;
+    uint32_t dynatlas_generation;
+} sprite__layer;
+
 typedef struct sprite__context {
     const sx_alloc* alloc;
     sx_strpool* name_pool;
@@ -167,8 +323,15 @@ typedef struct sprite__context {
     sprite__draw_context drawctx;
     sx_handle_pool* animclip_handles;
     sprite__animclip* animclips;
+    sprite__animclip_state animclip_state;
+    rizz_sprite_event* events;                   // sx_array: frame event stream
+    rizz_sprite_event** thread_events;           // sx_array per thread, merged into `events`
+    int num_thread_event_bufs;
     sx_handle_pool* animctrl_handles;
     sprite__animctrl* animctrls;
+    sprite__dynatlas dynatlas;
+    sx_handle_pool* layer_handles;
+    sprite__layer* layers;
 } sprite__context;
 
 typedef struct sprite__vertex_transform {
@@ -218,6 +381,27 @@ static rizz_vertex_layout k_sprite_wire_vertex_layout = {
                   .buffer_index = 1 }
 };
 
+static rizz_vertex_layout k_sprite_inst_vertex_layout = {
+    .attrs[0] = { .semantic = "POSITION", .offset = 0 },
+    .attrs[1] = { .semantic = "TEXCOORD",
+                  .semantic_idx = 1,
+                  .offset = offsetof(rizz_sprite_instance, t1),
+                  .buffer_index = 1 },
+    .attrs[2] = { .semantic = "TEXCOORD",
+                  .semantic_idx = 2,
+                  .offset = offsetof(rizz_sprite_instance, t2),
+                  .buffer_index = 1 },
+    .attrs[3] = { .semantic = "TEXCOORD",
+                  .semantic_idx = 3,
+                  .offset = offsetof(rizz_sprite_instance, uv_rect),
+                  .buffer_index = 1,
+                  .format = SG_VERTEXFORMAT_USHORT4N },
+    .attrs[4] = { .semantic = "COLOR",
+                  .offset = offsetof(rizz_sprite_instance, color),
+                  .buffer_index = 1,
+                  .format = SG_VERTEXFORMAT_UBYTE4N }
+};
+
 #define SORT_NAME sprite__sort
 #define SORT_TYPE uint64_t
 #define SORT_CMP(x, y) ((x) < (y) ? -1 : 1)
@@ -237,9 +421,60 @@ RIZZ_STATE static sprite__context g_spr;
 static void sprite__animclip_restart(rizz_sprite_animclip handle)
 {
     sx_assert_rel(sx_handle_valid(g_spr.animclip_handles, handle.id));
-    sprite__animclip* clip = &g_spr.animclips[sx_handle_index(handle.id)];
-    clip->frame_id = 0;
-    clip->tm = 0;
+    int index = sx_handle_index(handle.id);
+    g_spr.animclip_state.frame_id[index] = 0;
+    g_spr.animclip_state.tm[index] = 0;
+}
+
+static bool sprite__animclip_state_grow(int index)
+{
+    sprite__animclip_state* st = &g_spr.animclip_state;
+    if (index < st->capacity) {
+        return true;
+    }
+
+    int capacity = sx_max(index + 1, st->capacity << 1);
+    capacity = sx_max(capacity, 64);
+    size_t elem_sz = sizeof(float) * 3 + sizeof(int) * 2 + sizeof(bool);
+    uint8_t* buff = sx_malloc(g_spr.alloc, elem_sz * capacity);
+    if (!buff) {
+        sx_out_of_memory();
+        return false;
+    }
+
+    sprite__animclip_state new_st = { .capacity = capacity };
+    new_st.tm = (float*)buff;
+    new_st.fps = new_st.tm + capacity;
+    new_st.len = new_st.fps + capacity;
+    new_st.frame_id = (int*)(new_st.len + capacity);
+    new_st.num_frames = new_st.frame_id + capacity;
+    new_st.end_triggered = (bool*)(new_st.num_frames + capacity);
+    sx_memset(buff, 0x0, elem_sz * capacity);
+
+    if (st->capacity > 0) {
+        int count = st->capacity;
+        sx_memcpy(new_st.tm, st->tm, sizeof(float) * count);
+        sx_memcpy(new_st.fps, st->fps, sizeof(float) * count);
+        sx_memcpy(new_st.len, st->len, sizeof(float) * count);
+        sx_memcpy(new_st.frame_id, st->frame_id, sizeof(int) * count);
+        sx_memcpy(new_st.num_frames, st->num_frames, sizeof(int) * count);
+        sx_memcpy(new_st.end_triggered, st->end_triggered, sizeof(bool) * count);
+        sx_free(g_spr.alloc, st->tm);
+    }
+
+    *st = new_st;
+    return true;
+}
+
+static void sprite__animclip_state_init(int index, int num_frames, float fps, float len)
+{
+    sprite__animclip_state* st = &g_spr.animclip_state;
+    st->tm[index] = 0;
+    st->fps[index] = fps;
+    st->len[index] = len;
+    st->frame_id[index] = 0;
+    st->num_frames[index] = num_frames;
+    st->end_triggered[index] = false;
 }
 
 static rizz_sprite_animclip sprite__animclip_create(const rizz_sprite_animclip_desc* desc)
@@ -251,27 +486,30 @@ static rizz_sprite_animclip sprite__animclip_create(const rizz_sprite_animclip_d
     const sx_alloc* alloc = desc->alloc ? desc->alloc : g_spr.alloc;
 
     sprite__animclip clip = { .atlas = desc->atlas,
-                              .num_frames =
-                                  RIZZ_SPRITE_ANIMCLIP_MAX_FRAMES > 0
-                                      ? sx_min(RIZZ_SPRITE_ANIMCLIP_MAX_FRAMES, desc->num_frames)
-                                      : desc->num_frames,
-                              .fps = desc->fps,
-                              .len = desc->length,
                               .trigger_end_event = desc->trigger_end_event,
                               .alloc = alloc };
-    if (clip.num_frames < desc->num_frames) {
+    int num_frames = RIZZ_SPRITE_ANIMCLIP_MAX_FRAMES > 0
+                         ? sx_min(RIZZ_SPRITE_ANIMCLIP_MAX_FRAMES, desc->num_frames)
+                         : desc->num_frames;
+    float fps = desc->fps;
+    float len = desc->length;
+    if (num_frames < desc->num_frames) {
         rizz_log_warn(the_core, "num_frames exceeded maximum amount (%d) for sprite-animclip: 0x%x",
                       RIZZ_SPRITE_ANIMCLIP_MAX_FRAMES, handle);
     }
 
-    if (clip.fps > 0) {
-        clip.len = (float)clip.num_frames / clip.fps;
-    } else if (clip.len > 0) {
-        clip.fps = (float)clip.num_frames / clip.len;
+    if (fps > 0) {
+        len = (float)num_frames / fps;
+    } else if (len > 0) {
+        fps = (float)num_frames / len;
     } else {
         sx_assert(0 && "must define either 'fps' or 'length'");
     }
 
+    if (!sprite__animclip_state_grow(sx_handle_index(handle))) {
+        return (rizz_sprite_animclip){ 0 };
+    }
+
     the_asset->ref_add(desc->atlas);
     atlas__data* atlas = the_asset->obj(desc->atlas).ptr;
 
@@ -279,7 +517,7 @@ static rizz_sprite_animclip sprite__animclip_create(const rizz_sprite_animclip_d
     sprite__animclip_frame* frames = clip.frames;
 #else
     sprite__animclip_frame* frames =
-        sx_malloc(alloc, sizeof(sprite__animclip_frame) * clip.num_frames);
+        sx_malloc(alloc, sizeof(sprite__animclip_frame) * num_frames);
     if (!frames) {
         sx_out_of_memory();
         return (rizz_sprite_animclip){ 0 };
@@ -287,9 +525,11 @@ static rizz_sprite_animclip sprite__animclip_create(const rizz_sprite_animclip_d
     clip.frames = frames;
 #endif
 
-    for (int i = 0; i < clip.num_frames; i++) {
+    for (int i = 0; i < num_frames; i++) {
         const rizz_sprite_animclip_frame_desc* frame_desc = &desc->frames[i];
         sprite__animclip_frame* frame = &clip.frames[i];
+        *frame = (sprite__animclip_frame){ .trigger = frame_desc->trigger_event,
+                                           .e = frame_desc->event };
 
         int sidx = sx_hashtbl_find(&atlas->sprite_tbl,
                                    sx_hash_fnv32(frame_desc->name, sx_strlen(frame_desc->name)));
@@ -302,6 +542,7 @@ static rizz_sprite_animclip sprite__animclip_create(const rizz_sprite_animclip_d
     }
 
     sx_array_push_byindex(g_spr.alloc, g_spr.animclips, clip, sx_handle_index(handle));
+    sprite__animclip_state_init(sx_handle_index(handle), num_frames, fps, len);
 
     return (rizz_sprite_animclip){ handle };
 }
@@ -309,23 +550,28 @@ static rizz_sprite_animclip sprite__animclip_create(const rizz_sprite_animclip_d
 static rizz_sprite_animclip sprite__animclip_clone(rizz_sprite_animclip src_handle)
 {
     sx_assert_rel(sx_handle_valid(g_spr.animclip_handles, src_handle.id));
-    sprite__animclip* src = &g_spr.animclips[sx_handle_index(src_handle.id)];
+    int src_index = sx_handle_index(src_handle.id);
 
     sx_handle_t handle = sx_handle_new_and_grow(g_spr.animclip_handles, g_spr.alloc);
     sx_assert(handle);
+    if (!sprite__animclip_state_grow(sx_handle_index(handle))) {
+        return (rizz_sprite_animclip){ 0 };
+    }
+
+    // note: fetch source after grow, because state arrays may be reallocated
+    const sprite__animclip* src = &g_spr.animclips[src_index];
+    const sprite__animclip_state* st = &g_spr.animclip_state;
+    int num_frames = st->num_frames[src_index];
 
     sx_assert(src->atlas.id);
     sprite__animclip clip = { .atlas = src->atlas,
-                              .num_frames = src->num_frames,
-                              .fps = src->fps,
-                              .len = src->len,
                               .trigger_end_event = src->trigger_end_event,
                               .alloc = src->alloc };
 
 #if RIZZ_SPRITE_ANIMCLIP_MAX_FRAMES == 0
     sx_assert(clip.alloc);
     sprite__animclip_frame* frames =
-        sx_malloc(clip.alloc, sizeof(sprite__animclip_frame) * clip.num_frames);
+        sx_malloc(clip.alloc, sizeof(sprite__animclip_frame) * num_frames);
     if (!frames) {
         sx_out_of_memory();
         return (rizz_sprite_animclip){ 0 };
@@ -333,10 +579,12 @@ static rizz_sprite_animclip sprite__animclip_clone(rizz_sprite_animclip src_hand
     clip.frames = frames;
 #endif
 
-    sx_memcpy(clip.frames, src->frames, sizeof(sprite__animclip_frame) * clip.num_frames);
+    sx_memcpy(clip.frames, src->frames, sizeof(sprite__animclip_frame) * num_frames);
     the_asset->ref_add(clip.atlas);
 
     sx_array_push_byindex(g_spr.alloc, g_spr.animclips, clip, sx_handle_index(handle));
+    sprite__animclip_state_init(sx_handle_index(handle), num_frames, st->fps[src_index],
+                                st->len[src_index]);
 
     return (rizz_sprite_animclip){ handle };
 }
@@ -357,36 +605,174 @@ static void sprite__animclip_destroy(rizz_sprite_animclip handle)
     sx_handle_del(g_spr.animclip_handles, handle.id);
 }
 
-static void sprite__animclip_update_batch(const rizz_sprite_animclip* handles, int num_clips,
-                                          float dt)
+// events are never written to the stream directly, any thread can update clips and ctrls
+// every thread has it's own buffer (g_spr.thread_events), which are merged in `sprite__events`
+static void* sprite__thread_events_init(int thread_index, uint32_t thread_id, void* user)
 {
-    for (int i = 0; i < num_clips; i++) {
-        sx_assert_rel(sx_handle_valid(g_spr.animclip_handles, handles[i].id));
+    sx_unused(thread_id);
+    sx_unused(user);
+    sx_assert(thread_index < g_spr.num_thread_event_bufs);
+    return &g_spr.thread_events[thread_index];
+}
+
+static inline rizz_sprite_event** sprite__thread_events(void)
+{
+    return the_core->tls_var("sprite_events");
+}
+
+// job threads of a dispatch append to their own buffers, which are moved to the buffer of the
+// calling thread after the jobs are done. inline updates write to the buffer of the calling thread
+static inline rizz_sprite_event** sprite__animclip_events(const sprite__animclip_update_data* data,
+                                                          int thrd_index)
+{
+    return data->job_events ? &data->job_events[thrd_index] : sprite__thread_events();
+}
+
+static inline void sprite__animclip_emit(rizz_sprite_event** events, rizz_sprite_animclip clip,
+                                         int event, void* user)
+{
+    rizz_sprite_event e = { .clip = clip,
+                            .source = RIZZ_SPRITE_EVENTSOURCE_ANIMCLIP,
+                            .e = event,
+                            .user = user };
+    sx_array_push(g_spr.alloc, *events, e);
+}
+
+// updates clips in groups of 4 (SIMD lanes), `start` and `end` are group indices
+// hot state is gathered from SoA arrays, and cold data (frames) is only touched on events
+static void sprite__animclip_update_kernel(int start, int end, int thrd_index, void* user)
+{
+    const sprite__animclip_update_data* data = user;
+    sprite__animclip_state* st = &g_spr.animclip_state;
 
-        sprite__animclip* clip = &g_spr.animclips[sx_handle_index(handles[i].id)];
-        clip->end_triggered = false;
-        float tadvance = clip->tm + dt;
-        float t = sx_mod(tadvance, clip->len);    // progress time and wrap it onto time length
+    const sx_simd_t dt = sx_simd_splat1(data->dt);
+    const sx_simd_t one = sx_simd_splat1(1.0f);
+    const sx_simd_t epsilon = sx_simd_splat1(0.0001f);
+    sx_align_decl(16, float) tms[4];
+    sx_align_decl(16, int) frame_ids[4];
+    sx_align_decl(16, uint32_t) ends[4];
+    rizz_sprite_event** events = NULL;    // fetched on the first event
+
+    for (int g = start; g < end; g++) {
+        const int* idx = &data->indices[g << 2];
+        sx_simd_t tm = sx_simd_load4(st->tm[idx[0]], st->tm[idx[1]], st->tm[idx[2]],
+                                     st->tm[idx[3]]);
+        sx_simd_t fps = sx_simd_load4(st->fps[idx[0]], st->fps[idx[1]], st->fps[idx[2]],
+                                      st->fps[idx[3]]);
+        sx_simd_t len = sx_simd_load4(st->len[idx[0]], st->len[idx[1]], st->len[idx[2]],
+                                      st->len[idx[3]]);
+        sx_simd_t max_frame = sx_simd_sub(
+            sx_simd_load4((float)st->num_frames[idx[0]], (float)st->num_frames[idx[1]],
+                          (float)st->num_frames[idx[2]], (float)st->num_frames[idx[3]]),
+            one);
+
+        // progress time and wrap it onto time length: t = tadvance - len*floor(tadvance/len)
+        sx_simd_t tadvance = sx_simd_add(tm, dt);
+        sx_simd_t q = sx_simd_div(tadvance, len);
+        sx_simd_t qi = sx_simd_itof(sx_simd_ftoi(q));
+        qi = sx_simd_sub(qi, sx_simd_and(sx_simd_cmpgt(qi, q), one));    // ftoi rounds
+        sx_simd_t t = sx_simd_max(sx_simd_sub(tadvance, sx_simd_mul(len, qi)), sx_simd_zero());
 
         // detect timeline end
-        if (t < (tadvance - 0.0001f)) {
-            if (clip->trigger_end_event) {
-                rizz_event_push(&clip->equeue, RIZZ_SPRITE_ANIMCLIP_EVENT_END, NULL);
+        sx_simd_t ended = sx_simd_cmplt(t, sx_simd_sub(tadvance, epsilon));
+
+        sx_simd_t f = sx_simd_mul(fps, t);
+        sx_simd_t fi = sx_simd_itof(sx_simd_ftoi(f));
+        fi = sx_simd_sub(fi, sx_simd_and(sx_simd_cmpgt(fi, f), one));
+        fi = sx_simd_min(fi, max_frame);
+
+        sx_simd_store(tms, t);
+        sx_simd_store(frame_ids, sx_simd_ftoi(fi));
+        sx_simd_store(ends, ended);
+
+        for (int l = 0, lc = sx_min(4, data->num_clips - (g << 2)); l < lc; l++) {
+            int index = idx[l];
+            int frame_id = frame_ids[l];
+            bool end_triggered = ends[l] != 0;
+            const sprite__animclip* clip = &g_spr.animclips[index];
+
+            if (end_triggered && clip->trigger_end_event) {
+                events = events ? events : sprite__animclip_events(data, thrd_index);
+                sprite__animclip_emit(events, data->handles[(g << 2) + l],
+                                      RIZZ_SPRITE_ANIMCLIP_EVENT_END, NULL);
             }
-            clip->end_triggered = true;
-        }
 
-        int frame_id = (int)(clip->fps * t);
-        frame_id = sx_min(frame_id, clip->num_frames - 1);
+            if (frame_id != st->frame_id[index]) {
+                const sprite__animclip_frame* frame = &clip->frames[frame_id];
+                if (frame->trigger) {
+                    events = events ? events : sprite__animclip_events(data, thrd_index);
+                    sprite__animclip_emit(events, data->handles[(g << 2) + l], frame->e.e,
+                                          frame->e.user);
+                }
+            }
 
-        const sprite__animclip_frame* frame = &clip->frames[frame_id];
-        if (frame->trigger && frame_id != clip->frame_id) {
-            rizz_event_push(&clip->equeue, frame->e.e, frame->e.user);
+            st->end_triggered[index] = end_triggered;
+            st->frame_id[index] = frame_id;
+            st->tm[index] = tms[l];
         }
+    }
+}
+
+// big batches are split between job threads, events are then collected in per-thread buffers
+// of the dispatch and appended to the buffer of the calling thread in thread order, after all jobs
+// are finished
+static void sprite__animclip_update_batch(const rizz_sprite_animclip* handles, int num_clips,
+                                          float dt)
+{
+    if (num_clips <= 0) {
+        return;
+    }
+
+    const sx_alloc* tmp_alloc = the_core->tmp_alloc_push();
+    int num_groups = (num_clips + 3) >> 2;
+    int* indices = sx_malloc(tmp_alloc, sizeof(int) * (num_groups << 2));
+    if (!indices) {
+        sx_out_of_memory();
+        the_core->tmp_alloc_pop();
+        return;
+    }
+
+    for (int i = 0; i < num_clips; i++) {
+        sx_assert(sx_handle_valid(g_spr.animclip_handles, handles[i].id));
+        indices[i] = sx_handle_index(handles[i].id);
+    }
+    for (int i = num_clips, ic = num_groups << 2; i < ic; i++) {
+        indices[i] = indices[num_clips - 1];
+    }
 
-        clip->frame_id = frame_id;
-        clip->tm = t;
+    sprite__animclip_update_data data = {
+        .handles = handles, .indices = indices, .num_clips = num_clips, .dt = dt
+    };
+    if (num_clips >= ANIMCLIP_JOB_THRESHOLD && g_spr.num_thread_event_bufs > 1) {
+        data.job_events = sx_malloc(tmp_alloc, sizeof(rizz_sprite_event*) *
+                                                   g_spr.num_thread_event_bufs);
+        if (!data.job_events) {
+            sx_out_of_memory();
+            the_core->tmp_alloc_pop();
+            return;
+        }
+        sx_memset(data.job_events, 0x0, sizeof(rizz_sprite_event*) * g_spr.num_thread_event_bufs);
+
+        sx_job_t job = the_core->job_dispatch(num_groups, sprite__animclip_update_kernel, &data,
+                                              SX_JOB_PRIORITY_HIGH, 0);
+        the_core->job_wait_and_del(job);
+
+        // fetched after the wait, in case the calling job is resumed by another thread
+        rizz_sprite_event** events = sprite__thread_events();
+        for (int i = 0; i < g_spr.num_thread_event_bufs; i++) {
+            rizz_sprite_event* job_events = data.job_events[i];
+            int count = sx_array_count(job_events);
+            if (count > 0) {
+                sx_memcpy(sx_array_add(g_spr.alloc, *events, count), job_events,
+                          sizeof(rizz_sprite_event) * count);
+            }
+            sx_array_free(g_spr.alloc, job_events);
+        }
+    } else {
+        sprite__animclip_update_kernel(0, num_groups, 0, &data);
     }
+
+    the_core->tmp_alloc_pop();
 }
 
 static void sprite__animclip_update(rizz_sprite_animclip clip, float dt)
@@ -397,15 +783,13 @@ static void sprite__animclip_update(rizz_sprite_animclip clip, float dt)
 static float sprite__animclip_fps(rizz_sprite_animclip handle)
 {
     sx_assert_rel(sx_handle_valid(g_spr.animclip_handles, handle.id));
-    sprite__animclip* clip = &g_spr.animclips[sx_handle_index(handle.id)];
-    return clip->fps;
+    return g_spr.animclip_state.fps[sx_handle_index(handle.id)];
 }
 
 static float sprite__animclip_len(rizz_sprite_animclip handle)
 {
     sx_assert_rel(sx_handle_valid(g_spr.animclip_handles, handle.id));
-    sprite__animclip* clip = &g_spr.animclips[sx_handle_index(handle.id)];
-    return clip->len;
+    return g_spr.animclip_state.len[sx_handle_index(handle.id)];
 }
 
 static rizz_sprite_flip sprite__animclip_flip(rizz_sprite_animclip handle)
@@ -415,31 +799,26 @@ static rizz_sprite_flip sprite__animclip_flip(rizz_sprite_animclip handle)
     return clip->flip;
 }
 
-static rizz_event_queue* sprite__animclip_events(rizz_sprite_animclip handle)
-{
-    sx_assert_rel(sx_handle_valid(g_spr.animclip_handles, handle.id));
-    sprite__animclip* clip = &g_spr.animclips[sx_handle_index(handle.id)];
-    return &clip->equeue;
-}
-
 static void sprite__animclip_set_fps(rizz_sprite_animclip handle, float fps)
 {
     sx_assert_rel(sx_handle_valid(g_spr.animclip_handles, handle.id));
-    sprite__animclip* clip = &g_spr.animclips[sx_handle_index(handle.id)];
-    sx_assert(clip->num_frames > 0);
+    sprite__animclip_state* st = &g_spr.animclip_state;
+    int index = sx_handle_index(handle.id);
+    sx_assert(st->num_frames[index] > 0);
     sx_assert(fps > 0);
-    clip->len = (float)clip->num_frames / fps;
-    clip->fps = fps;
+    st->len[index] = (float)st->num_frames[index] / fps;
+    st->fps[index] = fps;
 }
 
 static void sprite__animclip_set_len(rizz_sprite_animclip handle, float length)
 {
     sx_assert_rel(sx_handle_valid(g_spr.animclip_handles, handle.id));
-    sprite__animclip* clip = &g_spr.animclips[sx_handle_index(handle.id)];
-    sx_assert(clip->num_frames > 0);
+    sprite__animclip_state* st = &g_spr.animclip_state;
+    int index = sx_handle_index(handle.id);
+    sx_assert(st->num_frames[index] > 0);
     sx_assert(length > 0);
-    clip->fps = (float)clip->num_frames / length;
-    clip->len = length;
+    st->fps[index] = (float)st->num_frames[index] / length;
+    st->len[index] = length;
 }
 
 void animclip_set_flip(rizz_sprite_animclip handle, rizz_sprite_flip flip)
@@ -560,13 +939,6 @@ static void sprite__animctrl_restart(rizz_sprite_animctrl handle)
     sprite__animclip_restart(ctrl->state->clip);
 }
 
-static rizz_event_queue* sprite__animctrl_events(rizz_sprite_animctrl handle)
-{
-    sx_assert_rel(sx_handle_valid(g_spr.animctrl_handles, handle.id));
-    sprite__animctrl* ctrl = &g_spr.animctrls[sx_handle_index(handle.id)];
-    return &ctrl->equeue;
-}
-
 static rizz_sprite_animctrl sprite__animctrl_create(const rizz_sprite_animctrl_desc* desc)
 {
     sx_assert(desc->num_states > 1);
@@ -801,14 +1173,19 @@ static sprite__animctrl_cmp_fn* k_compare_funcs[_RIZZ_SPRITE_COMPAREFUNC_COUNT]
     sprite__animctrl_cmp_lte
 };
 
-static void sprite__animctrl_trigger_transition(sprite__animctrl* ctrl, int transition_id)
+static void sprite__animctrl_trigger_transition(sprite__animctrl* ctrl, rizz_sprite_animctrl handle,
+                                                int transition_id)
 {
     sprite__animctrl_state* state = ctrl->state;
     sprite__animctrl_transition* transition = &state->transitions[transition_id];
 
     ctrl->state = transition->target;
     if (transition->trigger_event) {
-        rizz_event_push(&ctrl->equeue, transition->event.e, transition->event.user);
+        rizz_sprite_event e = { .ctrl = handle,
+                                .source = RIZZ_SPRITE_EVENTSOURCE_ANIMCTRL,
+                                .e = transition->event.e,
+                                .user = transition->event.user };
+        sx_array_push(g_spr.alloc, *sprite__thread_events(), e);
     }
 }
 
@@ -844,14 +1221,13 @@ static void sprite__animctrl_update_batch(const rizz_sprite_animctrl* handles, i
                     (sprite__animctrl_value){ .i = transition->trigger.value.i },
                     &ctrl->params[transition->trigger.param_id]);
                 if (r) {
-                    sprite__animctrl_trigger_transition(ctrl, t);
+                    sprite__animctrl_trigger_transition(ctrl, handles[i], t);
                     break;
                 }
             } else {
                 sx_assert(sx_handle_valid(g_spr.animclip_handles, state->clip.id));
-                sprite__animclip* clip = &g_spr.animclips[sx_handle_index(state->clip.id)];
-                if (clip->end_triggered) {
-                    sprite__animctrl_trigger_transition(ctrl, t);
+                if (g_spr.animclip_state.end_triggered[sx_handle_index(state->clip.id)]) {
+                    sprite__animctrl_trigger_transition(ctrl, handles[i], t);
                     break;
                 }
             }
@@ -871,14 +1247,33 @@ static void sprite__animctrl_update(rizz_sprite_animctrl handle, float dt)
     sprite__animctrl_update_batch(&handle, 1, dt);
 }
 
+// buffers of all threads are appended to the stream in thread order, so events of a clip/ctrl that
+// is always updated by the same thread keep their trigger order
+static const rizz_sprite_event* sprite__events(int* num_events)
+{
+    sx_assert(num_events);
+    for (int i = 0; i < g_spr.num_thread_event_bufs; i++) {
+        rizz_sprite_event* events = g_spr.thread_events[i];
+        int count = sx_array_count(events);
+        if (count > 0) {
+            sx_memcpy(sx_array_add(g_spr.alloc, g_spr.events, count), events,
+                      sizeof(rizz_sprite_event) * count);
+            sx_array_clear(events);
+        }
+    }
+    *num_events = sx_array_count(g_spr.events);
+    return g_spr.events;
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 // sprite
 static void sprite__sync_with_animclip(sprite__data* spr)
 {
     rizz_sprite_animclip clip_handle = spr->clip;
     if (sx_handle_valid(g_spr.animclip_handles, clip_handle.id)) {
-        sprite__animclip* clip = &g_spr.animclips[sx_handle_index(clip_handle.id)];
-        spr->atlas_sprite_id = (int)clip->frames[clip->frame_id].atlas_id;
+        int index = sx_handle_index(clip_handle.id);
+        sprite__animclip* clip = &g_spr.animclips[index];
+        spr->atlas_sprite_id = (int)clip->frames[g_spr.animclip_state.frame_id[index]].atlas_id;
         spr->flip = clip->flip;
     } else {
         rizz_log_warn(
@@ -982,6 +1377,7 @@ static rizz_asset_load_data atlas__on_prepare(const rizz_asset_load_params* para
     }
     sx_memset(atlas, 0x0, total_sz);
 
+    // note: layout of this buffer is mirrored by binary atlas payload, see atlas__binary_header
     uint8_t* buff = (uint8_t*)(atlas + 1);
     atlas->sprites = (atlas__sprite*)buff;
     buff += sizeof(atlas__sprite) * meta->num_sprites;
@@ -1006,11 +1402,111 @@ static rizz_asset_load_data atlas__on_prepare(const rizz_asset_load_params* para
     return (rizz_asset_load_data){ .obj = { .ptr = atlas }, .user = buff };
 }
 
+static int64_t atlas__binary_payload_size(int num_sprites, int num_vertices, int num_indices,
+                                          int hashtbl_cap)
+{
+    return (int64_t)num_sprites * (int64_t)sizeof(atlas__sprite) +
+           (int64_t)hashtbl_cap * (int64_t)(sizeof(uint32_t) + sizeof(int)) +
+           (int64_t)num_vertices * (int64_t)sizeof(rizz_sprite_vertex) +
+           (int64_t)num_indices * (int64_t)sizeof(uint16_t);
+}
+
+static const atlas__binary_header* atlas__binary_get_header(const sx_mem_block* mem)
+{
+    if (mem->size < (int64_t)sizeof(atlas__binary_header)) {
+        return NULL;
+    }
+
+    const atlas__binary_header* header = mem->data;
+    return header->sign == ATLAS_BINARY_SIGN ? header : NULL;
+}
+
+// checks the header fields that are used before the payload is loaded (metadata/prepare)
+static bool atlas__binary_header_valid(const atlas__binary_header* header)
+{
+    return header->num_sprites >= 0 && header->num_vertices >= 0 && header->num_indices >= 0 &&
+           header->hashtbl_count >= 0 && header->hashtbl_count <= header->hashtbl_cap &&
+           memchr(header->image, '\0', sizeof(header->image)) != NULL;
+}
+
+// sprite geometry must be inside the atlas buffers, quads are drawn from the corner vertices
+static bool atlas__binary_sprite_valid(const atlas__data* atlas, const atlas__sprite* aspr,
+                                       const atlas__binary_header* header)
+{
+    if (aspr->num_verts < 0 || aspr->num_indices < 0 || aspr->num_indices % 3 != 0 ||
+        aspr->vb_index < 0 || aspr->ib_index < 0 ||
+        aspr->vb_index > header->num_vertices - aspr->num_verts ||
+        aspr->ib_index > header->num_indices - aspr->num_indices ||
+        (aspr->quad && (aspr->num_verts != 4 || aspr->num_indices != 6))) {
+        return false;
+    }
+
+    const uint16_t* indices = &atlas->indices[aspr->ib_index];
+    for (int i = 0; i < aspr->num_indices; i++) {
+        if (indices[i] >= aspr->num_verts)
+            return false;
+    }
+    return true;
+}
+
+// binary atlas payload is already laid out like our object buffers, so the whole sprites/hashtbl/
+// geometry data is copied with a single memcpy instead of being parsed
+// everything that is later used as an index is validated after the copy
+static bool atlas__load_binary(atlas__data* atlas, const atlas__binary_header* header,
+                               const rizz_asset_load_params* params, const sx_mem_block* mem)
+{
+    if (header->version != ATLAS_BINARY_VERSION) {
+        rizz_log_warn(the_core, "loading atlas '%s' failed: unsupported binary version: %u",
+                      params->path, header->version);
+        return false;
+    }
+
+    int64_t payload_size = atlas__binary_header_valid(header)
+                           ? atlas__binary_payload_size(header->num_sprites, header->num_vertices,
+                                                        header->num_indices, header->hashtbl_cap)
+                           : -1;
+    if (payload_size < 0 || header->payload_size != payload_size ||
+        mem->size < (int64_t)sizeof(atlas__binary_header) + payload_size ||
+        header->hashtbl_cap != atlas->sprite_tbl.capacity) {
+        rizz_log_warn(the_core, "loading atlas '%s' failed: corrupt binary data", params->path);
+        return false;
+    }
+
+    sx_memcpy(atlas->sprites, header + 1, (size_t)payload_size);
+
+    for (int i = 0; i < header->num_sprites; i++) {
+        if (!atlas__binary_sprite_valid(atlas, &atlas->sprites[i], header)) {
+            rizz_log_warn(the_core, "loading atlas '%s' failed: corrupt binary data (sprite: %d)",
+                          params->path, i);
+            return false;
+        }
+    }
+    for (int i = 0; i < header->hashtbl_cap; i++) {
+        if (atlas->sprite_tbl.keys[i] &&
+            (atlas->sprite_tbl.values[i] < 0 ||
+             atlas->sprite_tbl.values[i] >= header->num_sprites)) {
+            rizz_log_warn(the_core, "loading atlas '%s' failed: corrupt binary data (hashtbl)",
+                          params->path);
+            return false;
+        }
+    }
+    atlas->sprite_tbl.count = header->hashtbl_count;
+    atlas->a.info.img_width = header->img_width;
+    atlas->a.info.img_height = header->img_height;
+    atlas->a.info.num_sprites = header->num_sprites;
+    return true;
+}
+
 static bool atlas__on_load(rizz_asset_load_data* data, const rizz_asset_load_params* params,
                            const sx_mem_block* mem)
 {
     atlas__data* atlas = data->obj.ptr;
 
+    const atlas__binary_header* header = atlas__binary_get_header(mem);
+    if (header) {
+        return atlas__load_binary(atlas, header, params, mem);
+    }
+
     const sx_alloc* tmp_alloc = the_core->tmp_alloc_push();
 
     char* buff = sx_malloc(tmp_alloc, (size_t)mem->size + 1);
@@ -1061,8 +1557,9 @@ static bool atlas__on_load(rizz_asset_load_data* data, const rizz_asset_load_par
         sjson_node* jmesh = sjson_find_member(jsprite, "mesh");
         if (jmesh) {
             // sprite-mesh
-            aspr->num_indices = sjson_get_int(jmesh, "num_tris", 0) * 3;
-            aspr->num_verts = sjson_get_int(jmesh, "num_vertices", 0);
+            aspr->quad = false;
+            aspr->num_indices = sx_max(0, sjson_get_int(jmesh, "num_tris", 0)) * 3;
+            aspr->num_verts = sx_max(0, sjson_get_int(jmesh, "num_vertices", 0));
             rizz_sprite_vertex* verts = &atlas->vertices[vb_index];
             uint16_t* indices = &atlas->indices[ib_index];
             sjson_get_uint16s(indices, aspr->num_indices, jmesh, "indices");
@@ -1074,7 +1571,8 @@ static bool atlas__on_load(rizz_asset_load_data* data, const rizz_asset_load_par
                 {
                     sx_vec2 pos;
                     sjson_get_floats(pos.f, 2, jpos, NULL);
-                    sx_assert(v < aspr->num_verts);
+                    if (v >= aspr->num_verts)
+                        break;
                     verts[v].pos = sprite__normalize_pos(pos, base_size_rcp);
                     v++;
                 }
@@ -1087,7 +1585,8 @@ static bool atlas__on_load(rizz_asset_load_data* data, const rizz_asset_load_par
                 {
                     sx_vec2 uv;
                     sjson_get_floats(uv.f, 2, juv, NULL);
-                    sx_assert(v < aspr->num_verts);
+                    if (v >= aspr->num_verts)
+                        break;
                     verts[v].uv = sx_vec2_mul(uv, atlas_size_rcp);
                     v++;
                 }
@@ -1095,6 +1594,7 @@ static bool atlas__on_load(rizz_asset_load_data* data, const rizz_asset_load_par
 
         } else {
             // sprite-quad
+            aspr->quad = true;
             aspr->num_indices = 6;
             aspr->num_verts = 4;
             rizz_sprite_vertex* verts = &atlas->vertices[vb_index];
@@ -1163,10 +1663,49 @@ static void atlas__on_release(rizz_asset_obj obj, const sx_alloc* alloc)
     sx_free(alloc, atlas);
 }
 
+// a cached atlas keeps its texture referenced, so the texture is accounted here as well
+static int64_t atlas__on_get_size(rizz_asset_obj obj, const void* metadata, rizz_mem_id* memid)
+{
+    const atlas__data* atlas = obj.ptr;
+    const atlas__metadata* meta = metadata;
+    sx_assert(atlas);
+
+    int64_t size = sizeof(atlas__data) + sx_hashtbl_fixed_size(atlas->a.info.num_sprites) +
+                   atlas->a.info.num_sprites * sizeof(atlas__sprite);
+    if (meta) {
+        size += meta->num_indices * sizeof(uint16_t) +
+                meta->num_vertices * sizeof(rizz_sprite_vertex);
+    }
+    if (atlas->a.texture.id) {
+        const rizz_texture* tex = the_asset->obj(atlas->a.texture).ptr;
+        size += tex->info.mem_size_bytes;
+    }
+
+    *memid = RIZZ_MEMID_GRAPHICS;
+    return size;
+}
+
 static void atlas__on_read_metadata(void* metadata, const rizz_asset_load_params* params,
                                     const sx_mem_block* mem)
 {
     atlas__metadata* meta = metadata;
+
+    const atlas__binary_header* header = atlas__binary_get_header(mem);
+    if (header) {
+        // corrupt header: leave the metadata empty, atlas__load_binary rejects the data later
+        if (!atlas__binary_header_valid(header))
+            return;
+
+        char dirname[RIZZ_MAX_PATH];
+        sx_os_path_dirname(dirname, sizeof(dirname), params->path);
+        sx_os_path_join(meta->img_filepath, sizeof(meta->img_filepath), dirname, header->image);
+        sx_os_path_unixpath(meta->img_filepath, sizeof(meta->img_filepath), meta->img_filepath);
+        meta->num_sprites = header->num_sprites;
+        meta->num_vertices = header->num_vertices;
+        meta->num_indices = header->num_indices;
+        return;
+    }
+
     const sx_alloc* tmp_alloc = the_core->tmp_alloc_push();
 
     char* buff = sx_malloc(tmp_alloc, (size_t)mem->size + 1);
@@ -1198,8 +1737,8 @@ static void atlas__on_read_metadata(void* metadata, const rizz_asset_load_params
     {
         sjson_node* jmesh = sjson_find_member(jsprite, "mesh");
         if (jmesh) {
-            num_indices += 3 * sjson_get_int(jmesh, "num_tris", 0);
-            num_vertices += sjson_get_int(jmesh, "num_vertices", 0);
+            num_indices += 3 * sx_max(0, sjson_get_int(jmesh, "num_tris", 0));
+            num_vertices += sx_max(0, sjson_get_int(jmesh, "num_vertices", 0));
         } else {
             num_indices += 6;
             num_vertices += 4;
@@ -1213,99 +1752,658 @@ static void atlas__on_read_metadata(void* metadata, const rizz_asset_load_params
     the_core->tmp_alloc_pop();
 }
 
-static bool sprite__resize_draw_limits(int max_verts, int max_indices)
+// writes the loaded atlas in binary format, which can be loaded a lot faster than json atlases
+// with large number of sprites. `filepath` is a file-system path (not vfs)
+static bool atlas__save_binary(rizz_asset atlas_handle, const char* filepath)
 {
-    sx_assert(max_verts < UINT16_MAX);
+    sx_assert(sx_strequal(the_asset->type_name(atlas_handle), "atlas"));
+    const atlas__data* atlas = the_asset->obj(atlas_handle).ptr;
+    if (the_asset->state(atlas_handle) != RIZZ_ASSET_STATE_OK || !atlas) {
+        return false;
+    }
 
-    // recreate vertex/index buffers
-    sprite__draw_context* dc = &g_spr.drawctx;
-    if (dc->vbuff[0].id)
-        the_gfx->destroy_buffer(dc->vbuff[0]);
-    if (dc->vbuff[1].id)
-        the_gfx->destroy_buffer(dc->vbuff[1]);
-    if (dc->ibuff.id)
-        the_gfx->destroy_buffer(dc->ibuff);
+    int num_vertices = 0, num_indices = 0;
+    for (int i = 0; i < atlas->a.info.num_sprites; i++) {
+        num_vertices += atlas->sprites[i].num_verts;
+        num_indices += atlas->sprites[i].num_indices;
+    }
+
+    atlas__binary_header header = {
+        .sign = ATLAS_BINARY_SIGN,
+        .version = ATLAS_BINARY_VERSION,
+        .img_width = atlas->a.info.img_width,
+        .img_height = atlas->a.info.img_height,
+        .num_sprites = atlas->a.info.num_sprites,
+        .num_vertices = num_vertices,
+        .num_indices = num_indices,
+        .hashtbl_cap = atlas->sprite_tbl.capacity,
+        .hashtbl_count = atlas->sprite_tbl.count,
+        .payload_size = (int)atlas__binary_payload_size(atlas->a.info.num_sprites, num_vertices,
+                                                        num_indices, atlas->sprite_tbl.capacity)
+    };
+    sx_os_path_basename(header.image, sizeof(header.image), the_asset->path(atlas->a.texture));
 
-    if (max_verts == 0 || max_indices == 0) {
-        dc->vbuff[0] = dc->vbuff[1] = dc->ibuff = (sg_buffer){ 0 };
-        return true;
+    sx_file_writer writer;
+    if (!sx_file_open_writer(&writer, filepath, 0)) {
+        rizz_log_warn(the_core, "saving atlas failed: could not open file '%s' for writing",
+                      filepath);
+        return false;
     }
 
-    dc->vbuff[0] =
-        the_gfx->make_buffer(&(sg_buffer_desc){ .size = sizeof(rizz_sprite_vertex) * max_verts,
-                                                .usage = SG_USAGE_STREAM,
-                                                .type = SG_BUFFERTYPE_VERTEXBUFFER });
-    dc->vbuff[1] = the_gfx->make_buffer(
-        &(sg_buffer_desc){ .size = sizeof(sprite__vertex_transform) * max_verts,
-                           .usage = SG_USAGE_STREAM,
-                           .type = SG_BUFFERTYPE_VERTEXBUFFER });
-    dc->ibuff = the_gfx->make_buffer(&(sg_buffer_desc){ .size = sizeof(uint16_t) * max_indices,
-                                                        .usage = SG_USAGE_STREAM,
-                                                        .type = SG_BUFFERTYPE_INDEXBUFFER });
+    // payload is written in the same order as in-memory buffers, see atlas__on_prepare
+    const sx_hashtbl* tbl = &atlas->sprite_tbl;
+    int written = sx_file_write_var(&writer, header);
+    written += sx_file_write(&writer, atlas->sprites,
+                             sizeof(atlas__sprite) * atlas->a.info.num_sprites);
+    written += sx_file_write(&writer, tbl->keys, sizeof(uint32_t) * tbl->capacity);
+    written += sx_file_write(&writer, tbl->values, sizeof(int) * tbl->capacity);
+    written += sx_file_write(&writer, atlas->vertices, sizeof(rizz_sprite_vertex) * num_vertices);
+    written += sx_file_write(&writer, atlas->indices, sizeof(uint16_t) * num_indices);
+    sx_file_close_writer(&writer);
 
-    return dc->vbuff[0].id && dc->vbuff[1].id && dc->ibuff.id;
+    return written == (int)sizeof(header) + header.payload_size;
 }
 
-static bool sprite__init()
+// sprite instances
+static inline uint16_t sprite__unorm16(float f)
 {
-    g_spr.alloc = the_core->alloc(RIZZ_MEMID_GRAPHICS);
-    g_spr.name_pool = sx_strpool_create(
-        g_spr.alloc, &(sx_strpool_config){ .counter_bits = SX_CONFIG_HANDLE_GEN_BITS,
-                                           .index_bits = 32 - SX_CONFIG_HANDLE_GEN_BITS,
-                                           .entry_capacity = 4096,
-                                           .block_capacity = 32,
-                                           .block_sz_kb = 64,
-                                           .min_str_len = 23 });
+    return (uint16_t)(sx_saturate(f) * 65535.0f + 0.5f);
+}
 
-    if (!g_spr.name_pool) {
-        sx_out_of_memory();
+// instance transform maps unit quad corners to sprite's local (origin/size applied) positions
+// pos_min and pos_max are normalized positions of (0, 0) and (1, 1) corners
+static void sprite__instance_make(rizz_sprite_instance* inst, sx_vec2 pos_min, sx_vec2 pos_max,
+                                  sx_vec2 uv_min, sx_vec2 uv_max, sx_vec2 origin, sx_vec2 size,
+                                  sx_color color)
+{
+    sx_vec2 offset = sx_vec2_mul(sx_vec2_sub(pos_min, origin), size);
+    sx_vec2 scale = sx_vec2_mul(sx_vec2_sub(pos_max, pos_min), size);
+    inst->t1 = sx_vec3f(scale.x, 0, 0);
+    inst->t2 = sx_vec3f(scale.y, offset.x, offset.y);
+    inst->uv_rect[0] = sprite__unorm16(uv_min.x);
+    inst->uv_rect[1] = sprite__unorm16(uv_min.y);
+    inst->uv_rect[2] = sprite__unorm16(uv_max.x);
+    inst->uv_rect[3] = sprite__unorm16(uv_max.y);
+    inst->color = color;
+}
+
+// dynamic atlas
+// returns false if the texture can't be drawn from a page with the same result:
+// pages have no mips and border color is not supported
+static bool sprite__dynatlas_get_sampler(rizz_asset texture, const rizz_texture* tex,
+                                         sprite__dynatlas_sampler* sampler)
+{
+    const rizz_texture_load_params* params = the_asset->params(texture);
+    rizz_texture_load_params p = params ? *params : (rizz_texture_load_params){ 0 };
+
+    // unset values are sokol's defaults
+    sg_filter min_filter = p.min_filter != _SG_FILTER_DEFAULT ? p.min_filter : SG_FILTER_NEAREST;
+    sg_filter mag_filter = p.mag_filter != _SG_FILTER_DEFAULT ? p.mag_filter : SG_FILTER_NEAREST;
+    sg_wrap wrap_u = p.wrap_u != _SG_WRAP_DEFAULT ? p.wrap_u : SG_WRAP_REPEAT;
+    sg_wrap wrap_v = p.wrap_v != _SG_WRAP_DEFAULT ? p.wrap_v : SG_WRAP_REPEAT;
+
+    if (tex->info.mips > 1 ||
+        (min_filter != SG_FILTER_NEAREST && min_filter != SG_FILTER_LINEAR) ||
+        wrap_u == SG_WRAP_CLAMP_TO_BORDER || wrap_v == SG_WRAP_CLAMP_TO_BORDER) {
         return false;
     }
 
-    g_spr.sprite_handles = sx_handle_create_pool(g_spr.alloc, 256);
-    sx_assert(g_spr.sprite_handles);
+    *sampler = (sprite__dynatlas_sampler){ .min_filter = min_filter,
+                                           .mag_filter = mag_filter,
+                                           .repeat_u = wrap_u == SG_WRAP_REPEAT,
+                                           .repeat_v = wrap_v == SG_WRAP_REPEAT };
+    return true;
+}
 
-    g_spr.animclip_handles = sx_handle_create_pool(g_spr.alloc, 256);
-    sx_assert(g_spr.animclip_handles);
+// creates the render-target of the page and clears it
+static bool sprite__dynatlas_make_page_image(sprite__dynatlas_page* page, sg_filter min_filter,
+                                             sg_filter mag_filter)
+{
+    page->img = the_gfx->make_image(&(sg_image_desc){ .render_target = true,
+                                                      .width = DYNATLAS_PAGE_SIZE,
+                                                      .height = DYNATLAS_PAGE_SIZE,
+                                                      .pixel_format = SG_PIXELFORMAT_RGBA8,
+                                                      .sample_count = 1,
+                                                      .min_filter = min_filter,
+                                                      .mag_filter = mag_filter,
+                                                      .wrap_u = SG_WRAP_CLAMP_TO_EDGE,
+                                                      .wrap_v = SG_WRAP_CLAMP_TO_EDGE,
+                                                      .label = "sprite_dynatlas" });
+    page->pass = the_gfx->make_pass(
+        &(sg_pass_desc){ .color_attachments[0].image = page->img, .label = "sprite_dynatlas" });
+    if (!page->img.id || !page->pass.id) {
+        if (page->pass.id)
+            the_gfx->destroy_pass(page->pass);
+        if (page->img.id)
+            the_gfx->destroy_image(page->img);
+        page->img = (sg_image){ 0 };
+        page->pass = (sg_pass){ 0 };
+        return false;
+    }
+    page->min_filter = min_filter;
+    page->mag_filter = mag_filter;
 
-    g_spr.animctrl_handles = sx_handle_create_pool(g_spr.alloc, 128);
-    sx_assert(g_spr.animctrl_handles);
+    // padding of the regions that are not drawn by the blit must be transparent
+    the_gfx->imm.begin_pass(page->pass, &(sg_pass_action){ .colors[0] = { SG_ACTION_CLEAR } });
+    the_gfx->imm.end_pass();
+    return true;
+}
 
-    // register "atlas" asset type and metadata
-    rizz_refl_field(the_refl, atlas__metadata, char[RIZZ_MAX_PATH], img_filepath, "img_filepath");
-    rizz_refl_field(the_refl, atlas__metadata, int, num_sprites, "num_sprites");
-    rizz_refl_field(the_refl, atlas__metadata, int, num_vertices, "num_vertices");
-    rizz_refl_field(the_refl, atlas__metadata, int, num_indices, "num_indices");
+static int sprite__dynatlas_add_page(const sprite__dynatlas_sampler* sampler)
+{
+    sprite__dynatlas* da = &g_spr.dynatlas;
+    sx_assert(da->num_pages < DYNATLAS_MAX_PAGES);
 
-    the_asset->register_asset_type(
-        "atlas",
-        (rizz_asset_callbacks){ .on_prepare = atlas__on_prepare,
-                                .on_load = atlas__on_load,
-                                .on_finalize = atlas__on_finalize,
-                                .on_reload = atlas__on_reload,
-                                .on_release = atlas__on_release,
-                                .on_read_metadata = atlas__on_read_metadata },
-        "rizz_atlas_load_params", sizeof(rizz_atlas_load_params), "atlas__metadata",
-        sizeof(atlas__metadata), (rizz_asset_obj){ .ptr = NULL }, (rizz_asset_obj){ .ptr = NULL },
-        0);
+    sprite__dynatlas_page* page = &da->pages[da->num_pages];
+    page->nodes = sx_malloc(g_spr.alloc, sizeof(stbrp_node) * DYNATLAS_PAGE_SIZE);
+    if (!page->nodes) {
+        sx_out_of_memory();
+        return -1;
+    }
 
-    // init draw context
-    if (!sprite__resize_draw_limits(MAX_VERTICES, MAX_INDICES)) {
-        return false;
+    if (!sprite__dynatlas_make_page_image(page, sampler->min_filter, sampler->mag_filter)) {
+        sx_free(g_spr.alloc, page->nodes);
+        sx_memset(page, 0x0, sizeof(*page));
+        return -1;
     }
 
-    const sx_alloc* tmp_alloc = the_core->tmp_alloc_push();
+    stbrp_init_target(&page->ctx, DYNATLAS_PAGE_SIZE, DYNATLAS_PAGE_SIZE, page->nodes,
+                      DYNATLAS_PAGE_SIZE);
+    page->ref_count = 0;
+    page->release_frame = -1;
 
-    rizz_shader shader = the_gfx->shader_make_with_data(
-        tmp_alloc, k_sprite_vs_size, k_sprite_vs_data, k_sprite_vs_refl_size, k_sprite_vs_refl_data,
-        k_sprite_fs_size, k_sprite_fs_data, k_sprite_fs_refl_size, k_sprite_fs_refl_data);
-    g_spr.drawctx.shader = shader.shd;
+    return da->num_pages++;
+}
 
-    sg_pipeline_desc pip_desc =
-        (sg_pipeline_desc){ .layout.buffers[0].stride = sizeof(rizz_sprite_vertex),
-                            .layout.buffers[1].stride = sizeof(sprite__vertex_transform),
-                            .index_type = SG_INDEXTYPE_UINT16,
-                            .rasterizer = { .cull_mode = SG_CULLMODE_BACK },
+// removes all (unreferenced) regions of the page and starts packing from scratch
+// the image is recreated if the page is reused for other filters
+static bool sprite__dynatlas_evict_page(int page_index, const sprite__dynatlas_sampler* sampler)
+{
+    sprite__dynatlas* da = &g_spr.dynatlas;
+    sprite__dynatlas_page* page = &da->pages[page_index];
+    sx_assert(page->ref_count == 0);
+
+    for (int i = 0, c = sx_array_count(da->regions); i < c; i++) {
+        sprite__dynatlas_region* region = &da->regions[i];
+        if (region->texture.id && region->page == page_index) {
+            sx_assert(region->ref_count == 0);
+            sx_hashtbl_remove_if_found(da->region_tbl, region->texture.id);
+            sx_memset(region, 0x0, sizeof(*region));
+        }
+    }
+
+    stbrp_init_target(&page->ctx, DYNATLAS_PAGE_SIZE, DYNATLAS_PAGE_SIZE, page->nodes,
+                      DYNATLAS_PAGE_SIZE);
+    page->release_frame = -1;
+    ++da->generation;
+
+    // image creation could have failed on previous reuse
+    if (!page->img.id || page->min_filter != sampler->min_filter ||
+        page->mag_filter != sampler->mag_filter) {
+        if (page->pass.id)
+            the_gfx->destroy_pass(page->pass);
+        if (page->img.id)
+            the_gfx->destroy_image(page->img);
+        return sprite__dynatlas_make_page_image(page, sampler->min_filter, sampler->mag_filter);
+    }
+
+    the_gfx->imm.begin_pass(page->pass, &(sg_pass_action){ .colors[0] = { SG_ACTION_CLEAR } });
+    the_gfx->imm.end_pass();
+    return true;
+}
+
+// returns a page with the same filters that has room for the rect (which is packed), or -1
+static int sprite__dynatlas_pack_rect(stbrp_rect* rect, const sprite__dynatlas_sampler* sampler)
+{
+    sprite__dynatlas* da = &g_spr.dynatlas;
+    for (int i = 0; i < da->num_pages; i++) {
+        const sprite__dynatlas_page* page = &da->pages[i];
+        if (!page->img.id || page->min_filter != sampler->min_filter ||
+            page->mag_filter != sampler->mag_filter) {
+            continue;
+        }
+        stbrp_pack_rects(&da->pages[i].ctx, rect, 1);
+        if (rect->was_packed) {
+            return i;
+        }
+    }
+
+    // evict pages that are not referenced since last frame: their commands are already submitted
+    // before we overwrite them with immediate API, then add new pages if there is still room
+    int64_t frame = the_core->frame_index();
+    int page_index = -1;
+    for (int i = 0; i < da->num_pages; i++) {
+        const sprite__dynatlas_page* page = &da->pages[i];
+        if (page->ref_count == 0 && page->release_frame < frame) {
+            if (sprite__dynatlas_evict_page(i, sampler)) {
+                page_index = i;
+            }
+            break;
+        }
+    }
+
+    if (page_index == -1 && da->num_pages < DYNATLAS_MAX_PAGES) {
+        page_index = sprite__dynatlas_add_page(sampler);
+    }
+
+    if (page_index != -1) {
+        stbrp_pack_rects(&da->pages[page_index].ctx, rect, 1);
+        if (rect->was_packed) {
+            return page_index;
+        }
+    }
+
+    return -1;
+}
+
+static inline void sprite__dynatlas_blit_instance(rizz_sprite_instance* inst, float x, float y,
+                                                  float w, float h, sx_vec2 uv_min, sx_vec2 uv_max)
+{
+    sprite__instance_make(inst, sx_vec2f(x, y), sx_vec2f(x + w, y + h), uv_min, uv_max,
+                          SX_VEC2_ZERO, sx_vec2f(1.0f, 1.0f), sx_colorn(0xffffffff));
+}
+
+// draws the texture into it's page region with the instanced sprite shader
+// padding is filled by stretching the edge texels, to avoid bleeding with linear filtering
+// for repeat wrapping, the padding of each side is filled with the texels of the opposite side
+static void sprite__dynatlas_blit(const sprite__dynatlas_region* region, int x, int y,
+                                  const rizz_texture* tex, const sprite__dynatlas_sampler* sampler)
+{
+    const sprite__dynatlas* da = &g_spr.dynatlas;
+    const sprite__dynatlas_page* page = &da->pages[region->page];
+    const sprite__draw_context* dc = &g_spr.drawctx;
+
+    float fx = (float)x, fy = (float)y;
+    float w = (float)region->width, h = (float)region->height;
+    float p = (float)DYNATLAS_PADDING;
+    float hu = 0.5f / w, hv = 0.5f / h;    // sample texel centers at the edges
+    float left = sampler->repeat_u ? 1.0f - hu : hu;
+    float right = sampler->repeat_u ? hu : 1.0f - hu;
+    float top = sampler->repeat_v ? 1.0f - hv : hv;
+    float bottom = sampler->repeat_v ? hv : 1.0f - hv;
+    rizz_sprite_instance insts[DYNATLAS_BLIT_INSTANCES];
+    sprite__dynatlas_blit_instance(&insts[0], fx, fy, w, h, sx_vec2f(0, 0), sx_vec2f(1.0f, 1.0f));
+    sprite__dynatlas_blit_instance(&insts[1], fx - p, fy, p, h, sx_vec2f(left, 0),
+                                   sx_vec2f(left, 1.0f));
+    sprite__dynatlas_blit_instance(&insts[2], fx + w, fy, p, h, sx_vec2f(right, 0),
+                                   sx_vec2f(right, 1.0f));
+    sprite__dynatlas_blit_instance(&insts[3], fx, fy - p, w, p, sx_vec2f(0, top),
+                                   sx_vec2f(1.0f, top));
+    sprite__dynatlas_blit_instance(&insts[4], fx, fy + h, w, p, sx_vec2f(0, bottom),
+                                   sx_vec2f(1.0f, bottom));
+
+    // page pixels (top-left origin) to clip space, GL render targets are upside down
+    float sy = the_gfx->GL_family() ? 1.0f : -1.0f;
+    float rcp = 2.0f / (float)DYNATLAS_PAGE_SIZE;
+    sx_mat4 vp = sx_mat4f(rcp, 0, 0, -1.0f, 0, sy * rcp, 0, -sy, 0, 0, 1.0f, 0, 0, 0, 0, 1.0f);
+
+    int offset = the_gfx->imm.append_buffer(da->blit_buff, insts, sizeof(insts));
+    sg_bindings bindings = { .index_buffer = dc->quad_ibuff,
+                             .vertex_buffers[0] = dc->quad_vbuff,
+                             .vertex_buffers[1] = da->blit_buff,
+                             .vertex_buffer_offsets[1] = offset,
+                             .fs_images[0] = tex->img };
+
+    the_gfx->imm.begin_pass(
+        page->pass,
+        &(sg_pass_action){ .colors[0] = { SG_ACTION_LOAD },
+                           .depth = { SG_ACTION_DONTCARE },
+                           .stencil = { SG_ACTION_DONTCARE } });
+    the_gfx->imm.apply_pipeline(da->pip_blit);
+    the_gfx->imm.apply_uniforms(SG_SHADERSTAGE_VS, 0, &vp, sizeof(vp));
+    the_gfx->imm.apply_bindings(&bindings);
+    the_gfx->imm.draw(0, 6, DYNATLAS_BLIT_INSTANCES);
+    the_gfx->imm.end_pass();
+}
+
+static bool sprite__dynatlas_pack(sprite__dynatlas_region* region)
+{
+    sx_assert(region->page == -1);
+
+    const rizz_texture* tex = (const rizz_texture*)the_asset->obj(region->texture).ptr;
+    sprite__dynatlas_sampler sampler;
+    if (tex->info.type != SG_IMAGETYPE_2D || tex->info.width > DYNATLAS_MAX_TEXTURE_SIZE ||
+        tex->info.height > DYNATLAS_MAX_TEXTURE_SIZE ||
+        !sprite__dynatlas_get_sampler(region->texture, tex, &sampler)) {
+        // remember the image, the texture is checked again when it's reloaded
+        region->rejected = true;
+        region->src_img_id = tex->img.id;
+        ++g_spr.dynatlas.generation;
+        return false;
+    }
+
+    stbrp_rect rect = { .w = (stbrp_coord)(tex->info.width + DYNATLAS_PADDING * 2),
+                        .h = (stbrp_coord)(tex->info.height + DYNATLAS_PADDING * 2) };
+    int page_index = sprite__dynatlas_pack_rect(&rect, &sampler);
+    if (page_index == -1) {
+        return false;    // out of pages, retry later when some page is evicted
+    }
+
+    int x = rect.x + DYNATLAS_PADDING;
+    int y = rect.y + DYNATLAS_PADDING;
+    float rcp = 1.0f / (float)DYNATLAS_PAGE_SIZE;
+    region->page = page_index;
+    region->src_img_id = tex->img.id;
+    region->width = tex->info.width;
+    region->height = tex->info.height;
+    region->uv_min = sx_vec2f((float)x * rcp, (float)y * rcp);
+    region->uv_max = sx_vec2f((float)(x + region->width) * rcp, (float)(y + region->height) * rcp);
+    g_spr.dynatlas.pages[page_index].ref_count += region->ref_count;
+    ++g_spr.dynatlas.generation;
+
+    sprite__dynatlas_blit(region, x, y, tex, &sampler);
+    return true;
+}
+
+static void sprite__dynatlas_addref(int index)
+{
+    sprite__dynatlas* da = &g_spr.dynatlas;
+    sprite__dynatlas_region* region = &da->regions[index];
+    ++region->ref_count;
+    if (region->page >= 0) {
+        ++da->pages[region->page].ref_count;
+    }
+}
+
+// texture is packed later in `sprite__dynatlas_update`, when it's loaded
+static int sprite__dynatlas_acquire(rizz_asset texture)
+{
+    sprite__dynatlas* da = &g_spr.dynatlas;
+    int index = sx_hashtbl_find_get(da->region_tbl, texture.id, -1);
+    if (index == -1) {
+        for (int i = 0, c = sx_array_count(da->regions); i < c; i++) {
+            if (!da->regions[i].texture.id) {
+                index = i;
+                break;
+            }
+        }
+
+        sprite__dynatlas_region region = { .texture = texture, .page = -1 };
+        if (index == -1) {
+            index = sx_array_count(da->regions);
+            sx_array_push(g_spr.alloc, da->regions, region);
+        } else {
+            da->regions[index] = region;
+        }
+
+        if (sx_hashtbl_full(da->region_tbl) && !sx_hashtbl_grow(&da->region_tbl, g_spr.alloc)) {
+            sx_out_of_memory();
+            return -1;
+        }
+        sx_hashtbl_add(da->region_tbl, texture.id, index);
+    }
+
+    sprite__dynatlas_addref(index);
+    return index;
+}
+
+static void sprite__dynatlas_release(int index)
+{
+    sprite__dynatlas* da = &g_spr.dynatlas;
+    sprite__dynatlas_region* region = &da->regions[index];
+    sx_assert(region->ref_count > 0);
+
+    if (--region->ref_count == 0 && region->page == -1) {
+        // not packed: nothing to keep
+        sx_hashtbl_remove_if_found(da->region_tbl, region->texture.id);
+        sx_memset(region, 0x0, sizeof(*region));
+        return;
+    }
+
+    if (region->page >= 0) {
+        sprite__dynatlas_page* page = &da->pages[region->page];
+        sx_assert(page->ref_count > 0);
+        if (--page->ref_count == 0) {
+            page->release_frame = the_core->frame_index();
+        }
+    }
+}
+
+static inline const sprite__dynatlas_region* sprite__dynatlas_get(const sprite__data* spr)
+{
+    if (spr->dynatlas_region >= 0) {
+        const sprite__dynatlas_region* region = &g_spr.dynatlas.regions[spr->dynatlas_region];
+        return region->page >= 0 ? region : NULL;
+    }
+    return NULL;
+}
+
+// packs newly loaded textures and repacks reloaded ones, main thread only (immediate API)
+static void sprite__dynatlas_update(void)
+{
+    sprite__dynatlas* da = &g_spr.dynatlas;
+    da->stats_batches = sx_atomic_xchg(&da->num_batches, 0);
+    da->stats_batches_unpacked = sx_atomic_xchg(&da->num_batches_unpacked, 0);
+    da->collect_stats = false;
+
+    int num_blits = 0;
+    for (int i = 0, c = sx_array_count(da->regions); i < c && num_blits < DYNATLAS_MAX_BLITS;
+         i++) {
+        sprite__dynatlas_region* region = &da->regions[i];
+        if (!region->texture.id || region->ref_count == 0 ||
+            the_asset->state(region->texture) != RIZZ_ASSET_STATE_OK) {
+            continue;
+        }
+
+        if (region->rejected) {
+            // reloaded texture may be packable now (size, type, mips)
+            const rizz_texture* tex = (const rizz_texture*)the_asset->obj(region->texture).ptr;
+            if (tex->img.id == region->src_img_id) {
+                continue;
+            }
+            region->rejected = false;
+        }
+
+        if (region->page >= 0) {
+            const rizz_texture* tex = (const rizz_texture*)the_asset->obj(region->texture).ptr;
+            if (tex->img.id == region->src_img_id) {
+                continue;
+            }
+
+            // texture is reloaded: leave the old rect in the page (reclaimed on eviction)
+            sprite__dynatlas_page* page = &da->pages[region->page];
+            page->ref_count -= region->ref_count;
+            if (page->ref_count == 0) {
+                page->release_frame = the_core->frame_index();
+            }
+            region->page = -1;
+            ++da->generation;
+        }
+
+        if (sprite__dynatlas_pack(region)) {
+            ++num_blits;
+        }
+    }
+}
+
+static bool sprite__dynatlas_init(rizz_shader* shader_inst, sg_pipeline_desc pip_desc)
+{
+    sprite__dynatlas* da = &g_spr.dynatlas;
+    da->region_tbl = sx_hashtbl_create(g_spr.alloc, 256);
+    if (!da->region_tbl) {
+        sx_out_of_memory();
+        return false;
+    }
+
+    da->blit_buff = the_gfx->make_buffer(&(sg_buffer_desc){
+        .size = sizeof(rizz_sprite_instance) * DYNATLAS_BLIT_INSTANCES * DYNATLAS_MAX_BLITS,
+        .usage = SG_USAGE_STREAM,
+        .type = SG_BUFFERTYPE_VERTEXBUFFER });
+
+    // copy texels as they are, into the render-target pages
+    pip_desc.blend = (sg_blend_state){ .color_format = SG_PIXELFORMAT_RGBA8,
+                                       .depth_format = SG_PIXELFORMAT_NONE };
+    pip_desc.rasterizer = (sg_rasterizer_state){ .cull_mode = SG_CULLMODE_NONE,
+                                                 .sample_count = 1 };
+    da->pip_blit = the_gfx->make_pipeline(
+        the_gfx->shader_bindto_pipeline(shader_inst, &pip_desc, &k_sprite_inst_vertex_layout));
+
+    return da->blit_buff.id && da->pip_blit.id;
+}
+
+static void sprite__dynatlas_release_all(void)
+{
+    sprite__dynatlas* da = &g_spr.dynatlas;
+    for (int i = 0; i < da->num_pages; i++) {
+        sprite__dynatlas_page* page = &da->pages[i];
+        if (page->pass.id)
+            the_gfx->destroy_pass(page->pass);
+        if (page->img.id)
+            the_gfx->destroy_image(page->img);
+        sx_free(g_spr.alloc, page->nodes);
+    }
+    if (da->pip_blit.id)
+        the_gfx->destroy_pipeline(da->pip_blit);
+    if (da->blit_buff.id)
+        the_gfx->destroy_buffer(da->blit_buff);
+    if (da->region_tbl)
+        sx_hashtbl_destroy(da->region_tbl, g_spr.alloc);
+    sx_array_free(g_spr.alloc, da->regions);
+}
+
+// layers
+static inline void sprite__layer_mark_dirty(const sprite__data* spr)
+{
+    if (spr->layer.id) {
+        sprite__layer* layer = &g_spr.layers[sx_handle_index(spr->layer.id)];
+        layer->chunks[spr->layer_slot / LAYER_CHUNK_SIZE].dirty = true;
+    }
+}
+
+static void sprite__layer_remove_sprite(sprite__layer* layer, sprite__data* spr)
+{
+    int slot_index = spr->layer_slot;
+    sprite__layer_slot* slot = &layer->slots[slot_index];
+    layer->chunks[slot_index / LAYER_CHUNK_SIZE].dirty = true;
+
+    for (int i = 0, c = sx_array_count(layer->animated); i < c; i++) {
+        if (layer->animated[i] == slot_index) {
+            sx_array_pop(layer->animated, i);
+            break;
+        }
+    }
+
+    sx_memset(slot, 0x0, sizeof(*slot));
+    sx_array_push(g_spr.alloc, layer->free_slots, slot_index);
+    spr->layer = (rizz_sprite_layer){ 0 };
+    spr->layer_slot = 0;
+}
+
+static bool sprite__resize_draw_limits(int max_verts, int max_indices)
+{
+    sx_assert(max_verts < UINT16_MAX);
+
+    // recreate vertex/index buffers
+    sprite__draw_context* dc = &g_spr.drawctx;
+    if (dc->vbuff[0].id)
+        the_gfx->destroy_buffer(dc->vbuff[0]);
+    if (dc->vbuff[1].id)
+        the_gfx->destroy_buffer(dc->vbuff[1]);
+    if (dc->ibuff.id)
+        the_gfx->destroy_buffer(dc->ibuff);
+    if (dc->inst_buff.id)
+        the_gfx->destroy_buffer(dc->inst_buff);
+
+    if (max_verts == 0 || max_indices == 0) {
+        dc->vbuff[0] = dc->vbuff[1] = dc->ibuff = dc->inst_buff = (sg_buffer){ 0 };
+        return true;
+    }
+
+    dc->vbuff[0] =
+        the_gfx->make_buffer(&(sg_buffer_desc){ .size = sizeof(rizz_sprite_vertex) * max_verts,
+                                                .usage = SG_USAGE_STREAM,
+                                                .type = SG_BUFFERTYPE_VERTEXBUFFER });
+    dc->vbuff[1] = the_gfx->make_buffer(
+        &(sg_buffer_desc){ .size = sizeof(sprite__vertex_transform) * max_verts,
+                           .usage = SG_USAGE_STREAM,
+                           .type = SG_BUFFERTYPE_VERTEXBUFFER });
+    dc->ibuff = the_gfx->make_buffer(&(sg_buffer_desc){ .size = sizeof(uint16_t) * max_indices,
+                                                        .usage = SG_USAGE_STREAM,
+                                                        .type = SG_BUFFERTYPE_INDEXBUFFER });
+    // instanced quad sprites: every quad costs 4 vertices in non-instanced path
+    dc->inst_buff = the_gfx->make_buffer(
+        &(sg_buffer_desc){ .size = sizeof(rizz_sprite_instance) * sx_max(max_verts / 4, 1),
+                           .usage = SG_USAGE_STREAM,
+                           .type = SG_BUFFERTYPE_VERTEXBUFFER });
+
+    return dc->vbuff[0].id && dc->vbuff[1].id && dc->ibuff.id && dc->inst_buff.id;
+}
+
+static bool sprite__init()
+{
+    g_spr.alloc = the_core->alloc(RIZZ_MEMID_GRAPHICS);
+    g_spr.name_pool = sx_strpool_create(
+        g_spr.alloc, &(sx_strpool_config){ .counter_bits = SX_CONFIG_HANDLE_GEN_BITS,
+                                           .index_bits = 32 - SX_CONFIG_HANDLE_GEN_BITS,
+                                           .entry_capacity = 4096,
+                                           .block_capacity = 32,
+                                           .block_sz_kb = 64,
+                                           .min_str_len = 23 });
+
+    if (!g_spr.name_pool) {
+        sx_out_of_memory();
+        return false;
+    }
+
+    g_spr.sprite_handles = sx_handle_create_pool(g_spr.alloc, 256);
+    sx_assert(g_spr.sprite_handles);
+
+    g_spr.animclip_handles = sx_handle_create_pool(g_spr.alloc, 256);
+    sx_assert(g_spr.animclip_handles);
+
+    g_spr.animctrl_handles = sx_handle_create_pool(g_spr.alloc, 128);
+    sx_assert(g_spr.animctrl_handles);
+
+    g_spr.layer_handles = sx_handle_create_pool(g_spr.alloc, 16);
+    sx_assert(g_spr.layer_handles);
+
+    // per-thread event buffers: main thread + workers
+    g_spr.num_thread_event_bufs = the_core->job_num_workers();
+    g_spr.thread_events =
+        sx_malloc(g_spr.alloc, sizeof(rizz_sprite_event*) * g_spr.num_thread_event_bufs);
+    if (!g_spr.thread_events) {
+        sx_out_of_memory();
+        return false;
+    }
+    sx_memset(g_spr.thread_events, 0x0, sizeof(rizz_sprite_event*) * g_spr.num_thread_event_bufs);
+    the_core->tls_register("sprite_events", NULL, sprite__thread_events_init);
+
+    // register "atlas" asset type and metadata
+    rizz_refl_field(the_refl, atlas__metadata, char[RIZZ_MAX_PATH], img_filepath, "img_filepath");
+    rizz_refl_field(the_refl, atlas__metadata, int, num_sprites, "num_sprites");
+    rizz_refl_field(the_refl, atlas__metadata, int, num_vertices, "num_vertices");
+    rizz_refl_field(the_refl, atlas__metadata, int, num_indices, "num_indices");
+
+    the_asset->register_asset_type(
+        "atlas",
+        (rizz_asset_callbacks){ .on_prepare = atlas__on_prepare,
+                                .on_load = atlas__on_load,
+                                .on_finalize = atlas__on_finalize,
+                                .on_reload = atlas__on_reload,
+                                .on_release = atlas__on_release,
+                                .on_read_metadata = atlas__on_read_metadata,
+                                .on_get_size = atlas__on_get_size },
+        "rizz_atlas_load_params", sizeof(rizz_atlas_load_params), "atlas__metadata",
+        sizeof(atlas__metadata), (rizz_asset_obj){ .ptr = NULL }, (rizz_asset_obj){ .ptr = NULL },
+        0);
+
+    // init draw context
+    if (!sprite__resize_draw_limits(MAX_VERTICES, MAX_INDICES)) {
+        return false;
+    }
+
+    const sx_alloc* tmp_alloc = the_core->tmp_alloc_push();
+
+    rizz_shader shader = the_gfx->shader_make_with_data(
+        tmp_alloc, k_sprite_vs_size, k_sprite_vs_data, k_sprite_vs_refl_size, k_sprite_vs_refl_data,
+        k_sprite_fs_size, k_sprite_fs_data, k_sprite_fs_refl_size, k_sprite_fs_refl_data);
+    g_spr.drawctx.shader = shader.shd;
+
+    sg_pipeline_desc pip_desc =
+        (sg_pipeline_desc){ .layout.buffers[0].stride = sizeof(rizz_sprite_vertex),
+                            .layout.buffers[1].stride = sizeof(sprite__vertex_transform),
+                            .index_type = SG_INDEXTYPE_UINT16,
+                            .rasterizer = { .cull_mode = SG_CULLMODE_BACK },
                             .blend = { .enabled = true,
                                        .src_factor_rgb = SG_BLENDFACTOR_SRC_ALPHA,
                                        .dst_factor_rgb = SG_BLENDFACTOR_ONE_MINUS_SRC_ALPHA } };
@@ -1318,11 +2416,43 @@ static bool sprite__init()
         tmp_alloc, k_sprite_wire_vs_size, k_sprite_wire_vs_data, k_sprite_wire_vs_refl_size,
         k_sprite_wire_vs_refl_data, k_sprite_wire_fs_size, k_sprite_wire_fs_data,
         k_sprite_wire_fs_refl_size, k_sprite_wire_fs_refl_data);
-    g_spr.drawctx.shader = shader_wire.shd;
+    g_spr.drawctx.shader_wire = shader_wire.shd;
     pip_desc.index_type = SG_INDEXTYPE_NONE;
     g_spr.drawctx.pip_wire = the_gfx->make_pipeline(
         the_gfx->shader_bindto_pipeline(&shader_wire, &pip_desc, &k_sprite_wire_vertex_layout));
 
+    // instanced pipeline: static unit quad (buffer 0) + per-instance data (buffer 1)
+    rizz_shader shader_inst = the_gfx->shader_make_with_data(
+        tmp_alloc, k_sprite_inst_vs_size, k_sprite_inst_vs_data, k_sprite_inst_vs_refl_size,
+        k_sprite_inst_vs_refl_data, k_sprite_inst_fs_size, k_sprite_inst_fs_data,
+        k_sprite_inst_fs_refl_size, k_sprite_inst_fs_refl_data);
+    g_spr.drawctx.shader_inst = shader_inst.shd;
+    pip_desc.index_type = SG_INDEXTYPE_UINT16;
+    pip_desc.layout.buffers[0].stride = sizeof(sx_vec2);
+    pip_desc.layout.buffers[1].stride = sizeof(rizz_sprite_instance);
+    pip_desc.layout.buffers[1].step_func = SG_VERTEXSTEP_PER_INSTANCE;
+    g_spr.drawctx.pip_inst = the_gfx->make_pipeline(
+        the_gfx->shader_bindto_pipeline(&shader_inst, &pip_desc, &k_sprite_inst_vertex_layout));
+    if (!sprite__dynatlas_init(&shader_inst, pip_desc)) {
+        the_core->tmp_alloc_pop();
+        return false;
+    }
+
+    // same corner order and winding as atlas quads (see atlas__on_load)
+    const sx_vec2 quad_verts[] = { { { 0, 0 } }, { { 1.0f, 0 } }, { { 0, 1.0f } },
+                                   { { 1.0f, 1.0f } } };
+    const uint16_t quad_indices[] = { 0, 1, 2, 2, 1, 3 };
+    g_spr.drawctx.quad_vbuff =
+        the_gfx->make_buffer(&(sg_buffer_desc){ .size = sizeof(quad_verts),
+                                                .usage = SG_USAGE_IMMUTABLE,
+                                                .type = SG_BUFFERTYPE_VERTEXBUFFER,
+                                                .content = quad_verts });
+    g_spr.drawctx.quad_ibuff =
+        the_gfx->make_buffer(&(sg_buffer_desc){ .size = sizeof(quad_indices),
+                                                .usage = SG_USAGE_IMMUTABLE,
+                                                .type = SG_BUFFERTYPE_INDEXBUFFER,
+                                                .content = quad_indices });
+
     the_core->tmp_alloc_pop();
     return true;
 }
@@ -1341,6 +2471,12 @@ static void sprite__release()
             the_gfx->destroy_buffer(dc->vbuff[1]);
         if (dc->ibuff.id)
             the_gfx->destroy_buffer(dc->ibuff);
+        if (dc->inst_buff.id)
+            the_gfx->destroy_buffer(dc->inst_buff);
+        if (dc->quad_vbuff.id)
+            the_gfx->destroy_buffer(dc->quad_vbuff);
+        if (dc->quad_ibuff.id)
+            the_gfx->destroy_buffer(dc->quad_ibuff);
         if (dc->shader.id)
             the_gfx->destroy_shader(dc->shader);
         if (dc->shader_wire.id)
@@ -1349,8 +2485,14 @@ static void sprite__release()
             the_gfx->destroy_pipeline(dc->pip);
         if (dc->pip_wire.id)
             the_gfx->destroy_pipeline(dc->pip_wire);
+        if (dc->shader_inst.id)
+            the_gfx->destroy_shader(dc->shader_inst);
+        if (dc->pip_inst.id)
+            the_gfx->destroy_pipeline(dc->pip_inst);
     }
 
+    sprite__dynatlas_release_all();
+
     if (g_spr.sprite_handles) {
         if (g_spr.sprite_handles->count > 0) {
             rizz_log_warn(the_core, "total %d sprites are not released",
@@ -1376,12 +2518,32 @@ static void sprite__release()
         sx_handle_destroy_pool(g_spr.animctrl_handles, g_spr.alloc);
     }
 
+    if (g_spr.layer_handles) {
+        if (g_spr.layer_handles->count > 0) {
+            rizz_log_warn(the_core, "total %d sprite_layers are not released",
+                          g_spr.layer_handles->count);
+        }
+        sx_handle_destroy_pool(g_spr.layer_handles, g_spr.alloc);
+    }
+
     if (g_spr.name_pool)
         sx_strpool_destroy(g_spr.name_pool, g_spr.alloc);
 
     sx_array_free(g_spr.alloc, g_spr.sprites);
     sx_array_free(g_spr.alloc, g_spr.animctrls);
     sx_array_free(g_spr.alloc, g_spr.animclips);
+    sx_array_free(g_spr.alloc, g_spr.layers);
+
+    if (g_spr.thread_events) {
+        for (int i = 0; i < g_spr.num_thread_event_bufs; i++) {
+            sx_array_free(g_spr.alloc, g_spr.thread_events[i]);
+        }
+        sx_free(g_spr.alloc, g_spr.thread_events);
+    }
+    sx_array_free(g_spr.alloc, g_spr.events);
+    if (g_spr.animclip_state.tm) {
+        sx_free(g_spr.alloc, g_spr.animclip_state.tm);
+    }
 
     the_asset->unregister_asset_type("atlas");
 }
@@ -1401,7 +2563,8 @@ static rizz_sprite sprite__create(const rizz_sprite_desc* desc)
                          .color = desc->color.n != 0 ? desc->color : sx_colorn(0xffffffff),
                          .flip = desc->flip,
                          .clip = desc->clip,
-                         .ctrl = desc->ctrl };
+                         .ctrl = desc->ctrl,
+                         .dynatlas_region = -1 };
 
     if (spr.ctrl.id) {
         spr.clip = sprite__animctrl_clip(spr.ctrl);
@@ -1409,10 +2572,11 @@ static rizz_sprite sprite__create(const rizz_sprite_desc* desc)
 
     if (spr.clip.id) {
         sx_assert_rel(sx_handle_valid(g_spr.animclip_handles, spr.clip.id));
-        sprite__animclip* clip = &g_spr.animclips[sx_handle_index(spr.clip.id)];
-        sx_assert(clip->num_frames > 0);
+        int index = sx_handle_index(spr.clip.id);
+        sprite__animclip* clip = &g_spr.animclips[index];
+        sx_assert(g_spr.animclip_state.num_frames[index] > 0);
         spr.atlas = clip->atlas;
-        spr.atlas_sprite_id = (int)clip->frames[clip->frame_id].atlas_id;
+        spr.atlas_sprite_id = (int)clip->frames[g_spr.animclip_state.frame_id[index]].atlas_id;
         atlas__data* atlas = the_asset->obj(clip->atlas).ptr;
         spr.texture = atlas->a.texture;
         the_asset->ref_add(spr.atlas);
@@ -1423,6 +2587,7 @@ static rizz_sprite sprite__create(const rizz_sprite_desc* desc)
             the_asset->ref_add(spr.texture);
 
             spr.atlas_sprite_id = -1;
+            spr.dynatlas_region = sprite__dynatlas_acquire(spr.texture);
         } else if (sx_strequal(img_type, "atlas")) {
             sx_assert(desc->name && "for atlases, desc->name should be set");
             spr.atlas = desc->atlas;
@@ -1469,15 +2634,17 @@ rizz_sprite sprite__clone(rizz_sprite src_handle, rizz_sprite_animclip clip_hand
                          .atlas_sprite_id = src->atlas_sprite_id,
                          .texture = src->texture,
                          .draw_bounds = src->draw_bounds,
-                         .bounds = src->bounds };
+                         .bounds = src->bounds,
+                         .dynatlas_region = -1 };
 
     // if new clip is set, override the previous one
     if (clip_handle.id) {
         sx_assert_rel(sx_handle_valid(g_spr.animclip_handles, clip_handle.id));
-        sprite__animclip* clip = &g_spr.animclips[sx_handle_index(clip_handle.id)];
-        sx_assert(clip->num_frames > 0);
+        int index = sx_handle_index(clip_handle.id);
+        sprite__animclip* clip = &g_spr.animclips[index];
+        sx_assert(g_spr.animclip_state.num_frames[index] > 0);
         spr.atlas = clip->atlas;
-        spr.atlas_sprite_id = (int)clip->frames[clip->frame_id].atlas_id;
+        spr.atlas_sprite_id = (int)clip->frames[g_spr.animclip_state.frame_id[index]].atlas_id;
         atlas__data* atlas = the_asset->obj(clip->atlas).ptr;
         spr.texture = atlas->a.texture;
     }
@@ -1487,6 +2654,10 @@ rizz_sprite sprite__clone(rizz_sprite src_handle, rizz_sprite_animclip clip_hand
     } else {
         sx_assert(spr.texture.id);
         the_asset->ref_add(spr.texture);
+        if (src->dynatlas_region >= 0) {
+            spr.dynatlas_region = src->dynatlas_region;
+            sprite__dynatlas_addref(spr.dynatlas_region);
+        }
     }
 
     sx_array_push_byindex(g_spr.alloc, g_spr.sprites, spr, sx_handle_index(handle));
@@ -1505,6 +2676,14 @@ static void sprite__destroy(rizz_sprite handle)
         the_asset->unload(spr->texture);
     }
 
+    if (spr->dynatlas_region >= 0) {
+        sprite__dynatlas_release(spr->dynatlas_region);
+    }
+
+    if (spr->layer.id) {
+        sprite__layer_remove_sprite(&g_spr.layers[sx_handle_index(spr->layer.id)], spr);
+    }
+
     if (spr->name) {
         sx_strpool_del(g_spr.name_pool, spr->name);
     }
@@ -1566,6 +2745,7 @@ static void sprite__set_size(rizz_sprite handle, const sx_vec2 size)
     sx_assert_rel(sx_handle_valid(g_spr.sprite_handles, handle.id));
     sprite__data* spr = &g_spr.sprites[sx_handle_index(handle.id)];
     spr->size = size;
+    sprite__layer_mark_dirty(spr);
     sprite__update_bounds(spr);
 }
 
@@ -1574,6 +2754,7 @@ static void sprite__set_origin(rizz_sprite handle, const sx_vec2 origin)
     sx_assert_rel(sx_handle_valid(g_spr.sprite_handles, handle.id));
     sprite__data* spr = &g_spr.sprites[sx_handle_index(handle.id)];
     spr->origin = origin;
+    sprite__layer_mark_dirty(spr);
     sprite__update_bounds(spr);
 }
 
@@ -1582,6 +2763,7 @@ static void sprite__set_color(rizz_sprite handle, const sx_color color)
     sx_assert_rel(sx_handle_valid(g_spr.sprite_handles, handle.id));
     sprite__data* spr = &g_spr.sprites[sx_handle_index(handle.id)];
     spr->color = color;
+    sprite__layer_mark_dirty(spr);
 }
 
 static void sprite__set_flip(rizz_sprite handle, rizz_sprite_flip flip)
@@ -1589,19 +2771,77 @@ static void sprite__set_flip(rizz_sprite handle, rizz_sprite_flip flip)
     sx_assert_rel(sx_handle_valid(g_spr.sprite_handles, handle.id));
     sprite__data* spr = &g_spr.sprites[sx_handle_index(handle.id)];
     spr->flip = flip;
+    sprite__layer_mark_dirty(spr);
     sprite__update_bounds(spr);
 }
 
 // draw-data
-static rizz_sprite_drawdata* sprite__drawdata_make_batch(const rizz_sprite* sprs, int num_sprites,
-                                                         const sx_alloc* alloc)
+// image to bind for the sprite: dynamic atlas page or the texture's image
+static inline sg_image sprite__image(const sprite__data* spr)
+{
+    const sprite__dynatlas_region* region = sprite__dynatlas_get(spr);
+    if (region) {
+        return g_spr.dynatlas.pages[region->page].img;
+    }
+    return ((rizz_texture*)the_asset->obj_threadsafe(spr->texture).ptr)->img;
+}
+
+// base size and uv rect of standalone texture sprites, uv_rect.vmin maps to top-left corner
+static inline sx_vec2 sprite__texture_rect(const sprite__data* spr, sx_rect* uv_rect)
+{
+    const sprite__dynatlas_region* region = sprite__dynatlas_get(spr);
+    if (region) {
+        *uv_rect = sx_rectv(region->uv_min, region->uv_max);
+        return sx_vec2f((float)region->width, (float)region->height);
+    }
+
+    rizz_texture* tex = (rizz_texture*)the_asset->obj_threadsafe(spr->texture).ptr;
+    sx_assert(tex);
+    *uv_rect = sx_rectf(0, 0, 1.0f, 1.0f);
+    return sx_vec2f((float)tex->info.width, (float)tex->info.height);
+}
+
+static inline bool sprite__is_instanced(const sprite__data* spr)
+{
+    if (spr->atlas.id && spr->atlas_sprite_id >= 0) {
+        const atlas__data* atlas = (atlas__data*)the_asset->obj_threadsafe(spr->atlas).ptr;
+        return atlas->sprites[spr->atlas_sprite_id].quad;
+    }
+    return true;
+}
+
+// local (sprite space) instance of a quad sprite, see `sprite__is_instanced`
+static void sprite__instance_local(const sprite__data* spr, rizz_sprite_instance* inst)
+{
+    if (spr->atlas.id && spr->atlas_sprite_id >= 0) {
+        const atlas__data* atlas = (atlas__data*)the_asset->obj_threadsafe(spr->atlas).ptr;
+        const atlas__sprite* aspr = &atlas->sprites[spr->atlas_sprite_id];
+        const rizz_sprite_vertex* v = &atlas->vertices[aspr->vb_index];
+        sx_vec2 size = sprite__calc_size(spr->size, aspr->base_size, spr->flip);
+        sprite__instance_make(inst, v[0].pos, v[3].pos, v[0].uv, v[3].uv, spr->origin, size,
+                              spr->color);
+    } else {
+        sx_rect uv_rect;
+        sx_vec2 base_size = sprite__texture_rect(spr, &uv_rect);
+        sx_vec2 size = sprite__calc_size(spr->size, base_size, spr->flip);
+        // corner (0, 0) is top-left, to keep the same winding as atlas quads
+        sprite__instance_make(inst, sx_vec2f(-0.5f, 0.5f), sx_vec2f(0.5f, -0.5f), uv_rect.vmin,
+                              uv_rect.vmax, spr->origin, size, spr->color);
+    }
+}
+
+static rizz_sprite_drawdata* sprite__drawdata_make_batch_internal(const rizz_sprite* sprs,
+                                                                  int num_sprites,
+                                                                  const sx_alloc* alloc,
+                                                                  bool instanced)
 {
     sx_assert(num_sprites > 0);
     sx_assert(sprs);
 
-    // count final vertices and indices,
+    // count final vertices, indices and instances
     int num_verts = 0;
     int num_indices = 0;
+    int num_instances = 0;
     for (int i = 0; i < num_sprites; i++) {
         sx_assert_rel(sx_handle_valid(g_spr.sprite_handles, sprs[i].id));
 
@@ -1617,7 +2857,9 @@ static rizz_sprite_drawdata* sprite__drawdata_make_batch(const rizz_sprite* sprs
             sprite__sync_with_animclip(spr);
         }
 
-        if (spr->atlas.id && spr->atlas_sprite_id >= 0) {
+        if (instanced && sprite__is_instanced(spr)) {
+            ++num_instances;
+        } else if (spr->atlas.id && spr->atlas_sprite_id >= 0) {
             const atlas__data* atlas = (atlas__data*)the_asset->obj_threadsafe(spr->atlas).ptr;
             sx_assert(spr->atlas_sprite_id < atlas->a.info.num_sprites);
 
@@ -1631,9 +2873,12 @@ static rizz_sprite_drawdata* sprite__drawdata_make_batch(const rizz_sprite* sprs
     }
 
     // assume that every sprite is a batch, so we can pre-allocate loosely
-    int total_sz = sizeof(rizz_sprite_drawdata) + num_verts * sizeof(rizz_sprite_vertex) +
-                   num_indices * sizeof(uint16_t) +
-                   (sizeof(rizz_sprite_drawbatch) + sizeof(rizz_sprite_drawsprite)) * num_sprites;
+    int num_inst_batches = instanced ? num_sprites : 0;
+    int total_sz = sizeof(rizz_sprite_drawdata) +
+                   (sizeof(rizz_sprite_drawbatch) + sizeof(rizz_sprite_drawsprite)) * num_sprites +
+                   sizeof(rizz_sprite_instbatch) * num_inst_batches +
+                   sizeof(rizz_sprite_instance) * num_instances +
+                   num_verts * sizeof(rizz_sprite_vertex) + num_indices * sizeof(uint16_t);
     rizz_sprite_drawdata* dd = sx_malloc(alloc, total_sz);
     if (!dd) {
         sx_out_of_memory();
@@ -1646,47 +2891,97 @@ static rizz_sprite_drawdata* sprite__drawdata_make_batch(const rizz_sprite* sprs
     sx_assert(keys);
 
     for (int i = 0; i < num_sprites; i++) {
-        sx_assert_rel(sx_handle_valid(g_spr.sprite_handles, sprs[i].id));
-
-        int index = sx_handle_index(sprs[i].id);
-        sprite__data* spr = &g_spr.sprites[index];
-
-        keys[i] = ((uint64_t)spr->texture.id << 32) | (uint64_t)index;
+        const sprite__data* spr = &g_spr.sprites[sx_handle_index(sprs[i].id)];
+        keys[i] = ((uint64_t)sprite__image(spr).id << 32) | (uint64_t)i;
     }
 
     // sort sprites:
-    //      high-bits (32): texture handle. main batching
-    //      low-bits  (32): sprite index. cache coherence
+    //      high-bits (32): image handle. main batching
+    //      low-bits  (32): index to input array. keeps the order of sprites with same image
     if (num_sprites > 1)
         sprite__sort_tim_sort(keys, num_sprites);
 
+    // batch counts with and without dynamic atlas, for the debugger
+    sprite__dynatlas* da = &g_spr.dynatlas;
+    if (da->collect_stats) {
+        sx_hashtbl* tex_tbl = sx_hashtbl_create(tmp_alloc, num_sprites * 2);
+        int num_images = 0;
+        int num_textures = 0;
+        uint32_t last_img_id = 0;
+        for (int i = 0; i < num_sprites && tex_tbl; i++) {
+            uint32_t img_id = (uint32_t)(keys[i] >> 32);
+            uint32_t tex_id = g_spr.sprites[sx_handle_index(sprs[i].id)].texture.id;
+            num_images += img_id != last_img_id ? 1 : 0;
+            last_img_id = img_id;
+            if (sx_hashtbl_find(tex_tbl, tex_id) == -1) {
+                sx_hashtbl_add(tex_tbl, tex_id, 0);
+                ++num_textures;
+            }
+        }
+        sx_atomic_fetch_add(&da->num_batches, num_images);
+        sx_atomic_fetch_add(&da->num_batches_unpacked, num_textures);
+    }
+
     memset(dd, 0x0, sizeof(rizz_sprite_drawdata));
     uint8_t* buff = (uint8_t*)(dd + 1);
     dd->sprites = (rizz_sprite_drawsprite*)buff;
     buff += sizeof(rizz_sprite_drawsprite) * num_sprites;
     dd->batches = (rizz_sprite_drawbatch*)buff;
     buff += sizeof(rizz_sprite_drawbatch) * num_sprites;
+    dd->instance_batches = num_inst_batches ? (rizz_sprite_instbatch*)buff : NULL;
+    buff += sizeof(rizz_sprite_instbatch) * num_inst_batches;
+    dd->instances = num_instances ? (rizz_sprite_instance*)buff : NULL;
+    buff += sizeof(rizz_sprite_instance) * num_instances;
     dd->verts = (rizz_sprite_vertex*)buff;
     buff += sizeof(rizz_sprite_vertex) * num_verts;
     dd->indices = (uint16_t*)buff;
-    dd->num_batches = 0;
-    dd->num_verts = num_verts;
-    dd->num_indices = num_indices;
 
     // fill buffers and batch
     rizz_sprite_vertex* verts = dd->verts;
     uint16_t* indices = dd->indices;
     int index_idx = 0;
     int vertex_idx = 0;
+    int instance_idx = 0;
     uint32_t last_batch_key = 0;
+    uint32_t last_inst_batch_key = 0;
     int num_batches = 0;
+    int num_instance_batches = 0;
 
     for (int i = 0; i < num_sprites; i++) {
-        int index = (int)(keys[i] & 0xffffffff);
-        const sprite__data* spr = &g_spr.sprites[index];
+        int sprite_idx = (int)(keys[i] & 0xffffffff);
+        const sprite__data* spr = &g_spr.sprites[sx_handle_index(sprs[sprite_idx].id)];
         sx_color color = spr->color;
         int index_start = index_idx;
         int vertex_start = vertex_idx;
+        uint32_t key = (uint32_t)(keys[i] >> 32);
+        sg_image img = (sg_image){ key };
+
+        if (instanced && sprite__is_instanced(spr)) {
+            // quad sprites: a single instance that transforms the unit quad
+            sprite__instance_local(spr, &dd->instances[instance_idx]);
+
+            if (last_inst_batch_key != key) {
+                rizz_sprite_instbatch* batch = &dd->instance_batches[num_instance_batches++];
+                batch->texture = spr->texture;
+                batch->image = img;
+                batch->instance_start = instance_idx;
+                batch->instance_count = 1;
+                batch->batch_index = num_batches;
+                last_inst_batch_key = key;
+            } else {
+                sx_assert(num_instance_batches > 0);
+                dd->instance_batches[num_instance_batches - 1].instance_count++;
+            }
+            // next mesh sprite of the same image is drawn after this one, so it starts a new batch
+            last_batch_key = 0;
+
+            dd->sprites[sprite_idx] = (rizz_sprite_drawsprite){ .index = sprite_idx,
+                                                                .start_vertex = vertex_start,
+                                                                .start_index = index_start,
+                                                                .instance = instance_idx };
+            ++instance_idx;
+            continue;
+        }
 
         // there are two types of sprites :
         //  - atlas sprites
@@ -1719,41 +3014,43 @@ static rizz_sprite_drawdata* sprite__drawdata_make_batch(const rizz_sprite* sprs
             index_idx += aspr->num_indices;
         } else {
             // normal texture sprite: there is no atalas. sprite takes the whole texture
-            rizz_texture* tex = (rizz_texture*)the_asset->obj_threadsafe(spr->texture).ptr;
-            sx_assert(tex);
-            sx_vec2 base_size = sx_vec2f((float)tex->info.width, (float)tex->info.height);
+            // (or it's region in dynamic atlas)
+            sx_rect uv_rect;
+            sx_vec2 base_size = sprite__texture_rect(spr, &uv_rect);
             sx_vec2 size = sprite__calc_size(spr->size, base_size, spr->flip);
             sx_vec2 origin = spr->origin;
             sx_rect rect = sx_rectf(-0.5f, -0.5f, 0.5f, 0.5f);
+            rizz_sprite_vertex* dst_verts = &verts[vertex_idx];
+            uint16_t* dst_indices = &indices[index_idx];
 
-            verts[0].pos = sx_vec2_mul(sx_vec2_sub(sx_rect_corner(&rect, 0), origin), size);
-            verts[0].uv = sx_vec2f(0.0f, 1.0f);
-            verts[0].color = color;
-            verts[1].pos = sx_vec2_mul(sx_vec2_sub(sx_rect_corner(&rect, 1), origin), size);
-            verts[1].uv = sx_vec2f(1.0f, 1.0f);
-            verts[2].color = color;
-            verts[2].pos = sx_vec2_mul(sx_vec2_sub(sx_rect_corner(&rect, 2), origin), size);
-            verts[2].uv = sx_vec2f(0.0f, 0.0f);
-            verts[2].color = color;
-            verts[3].pos = sx_vec2_mul(sx_vec2_sub(sx_rect_corner(&rect, 3), origin), size);
-            verts[3].uv = sx_vec2f(1.0f, 0.0f);
-            verts[3].color = color;
+            dst_verts[0].pos = sx_vec2_mul(sx_vec2_sub(sx_rect_corner(&rect, 0), origin), size);
+            dst_verts[0].uv = sx_vec2f(uv_rect.xmin, uv_rect.ymax);
+            dst_verts[0].color = color;
+            dst_verts[1].pos = sx_vec2_mul(sx_vec2_sub(sx_rect_corner(&rect, 1), origin), size);
+            dst_verts[1].uv = sx_vec2f(uv_rect.xmax, uv_rect.ymax);
+            dst_verts[1].color = color;
+            dst_verts[2].pos = sx_vec2_mul(sx_vec2_sub(sx_rect_corner(&rect, 2), origin), size);
+            dst_verts[2].uv = sx_vec2f(uv_rect.xmin, uv_rect.ymin);
+            dst_verts[2].color = color;
+            dst_verts[3].pos = sx_vec2_mul(sx_vec2_sub(sx_rect_corner(&rect, 3), origin), size);
+            dst_verts[3].uv = sx_vec2f(uv_rect.xmax, uv_rect.ymin);
+            dst_verts[3].color = color;
 
             // clang-format off
-            int v = vertex_start;
-            indices[3] = v;         indices[4] = v + 2;     indices[5] = v + 1;
-            indices[0] = v + 1;     indices[1] = v + 2;     indices[2] = v + 3;
-            // clang-format on            
+            uint16_t v = (uint16_t)vertex_start;
+            dst_indices[3] = v;         dst_indices[4] = v + 2;     dst_indices[5] = v + 1;
+            dst_indices[0] = v + 1;     dst_indices[1] = v + 2;     dst_indices[2] = v + 3;
+            // clang-format on
 
             vertex_idx += 4;
             index_idx += 6;
         }
 
         // batch by texture
-        uint32_t key = spr->texture.id;
         if (last_batch_key != key) {
             rizz_sprite_drawbatch* batch = &dd->batches[num_batches++];
             batch->texture = spr->texture;
+            batch->image = img;
             batch->index_start = index_start;
             batch->index_count = index_idx - index_start;
             last_batch_key = key;
@@ -1762,13 +3059,15 @@ static rizz_sprite_drawdata* sprite__drawdata_make_batch(const rizz_sprite* sprs
             rizz_sprite_drawbatch* batch = &dd->batches[num_batches-1];
             batch->index_count += (index_idx - index_start);
         }
+        last_inst_batch_key = 0;
 
-        dd->sprites[index] = (rizz_sprite_drawsprite) {
-            .index = index,
+        dd->sprites[sprite_idx] = (rizz_sprite_drawsprite) {
+            .index = sprite_idx,
             .start_vertex = vertex_start,
             .start_index = index_start,
             .num_verts = vertex_idx - vertex_start,
-            .num_indices = index_idx - index_start
+            .num_indices = index_idx - index_start,
+            .instance = -1
         };        
     }
 
@@ -1776,11 +3075,26 @@ static rizz_sprite_drawdata* sprite__drawdata_make_batch(const rizz_sprite* sprs
     dd->num_verts = num_verts;
     dd->num_batches = num_batches;
     dd->num_sprites = num_sprites;
+    dd->num_instances = num_instances;
+    dd->num_instance_batches = num_instance_batches;
 
     the_core->tmp_alloc_pop();
     return dd;
 }
 
+static rizz_sprite_drawdata* sprite__drawdata_make_batch(const rizz_sprite* sprs, int num_sprites,
+                                                         const sx_alloc* alloc)
+{
+    return sprite__drawdata_make_batch_internal(sprs, num_sprites, alloc, false);
+}
+
+static rizz_sprite_drawdata* sprite__drawdata_make_instanced_batch(const rizz_sprite* sprs,
+                                                                   int num_sprites,
+                                                                   const sx_alloc* alloc)
+{
+    return sprite__drawdata_make_batch_internal(sprs, num_sprites, alloc, true);
+}
+
 static rizz_sprite_drawdata* sprite__drawdata_make(rizz_sprite spr, const sx_alloc* alloc) {
     return sprite__drawdata_make_batch(&spr, 1, alloc);
 }
@@ -1789,14 +3103,31 @@ static void sprite__drawdata_free(rizz_sprite_drawdata* data, const sx_alloc* al
     sx_free(alloc, data);
 }
 
+// composes sprite matrix with instance's local transform, both are in shader's 2x3 packing
+static inline void sprite__instance_transform(rizz_sprite_instance* inst, const sx_mat3* m)
+{
+    float la = inst->t1.x, lb = inst->t1.y, lc = inst->t1.z;
+    float ld = inst->t2.x, le = inst->t2.y, lf = inst->t2.z;
+    inst->t1 = sx_vec3f(m->m11 * la + m->m21 * lb, m->m12 * la + m->m22 * lb,
+                        m->m11 * lc + m->m21 * ld);
+    inst->t2 = sx_vec3f(m->m12 * lc + m->m22 * ld, m->m11 * le + m->m21 * lf + m->m13,
+                        m->m12 * le + m->m22 * lf + m->m23);
+}
+
+static inline sx_color sprite__color_mul(sx_color a, sx_color b)
+{
+    return sx_color4u((unsigned char)(((int)a.r * (int)b.r + 127) / 255),
+                      (unsigned char)(((int)a.g * (int)b.g + 127) / 255),
+                      (unsigned char)(((int)a.b * (int)b.b + 127) / 255),
+                      (unsigned char)(((int)a.a * (int)b.a + 127) / 255));
+}
+
 static void sprite__draw_batch(const rizz_sprite* sprs, int num_sprites, const sx_mat4* vp, 
                                const sx_mat3* mats, sx_color* tints) {
-    sx_unused(tints);   // TODO
-
     const sx_alloc* tmp_alloc = the_core->tmp_alloc_push();
 
     rizz_sprite_drawdata* dd =
-        sprite__drawdata_make_batch(sprs, num_sprites, tmp_alloc);
+        sprite__drawdata_make_instanced_batch(sprs, num_sprites, tmp_alloc);
     if (!dd) {
         sx_assert(0 && "out of memory");
         return;
@@ -1814,58 +3145,395 @@ static void sprite__draw_batch(const rizz_sprite* sprs, int num_sprites, const s
 
     const sprite__draw_context* dc = &g_spr.drawctx;
 
-    // append drawdata to buffers
-    int ib_offset = the_gfx->staged.append_buffer(dc->ibuff, dd->indices, 
-                                                  sizeof(uint16_t)*dd->num_indices);
-    int vb_offset1 = the_gfx->staged.append_buffer(dc->vbuff[0], dd->verts, 
-                                                   sizeof(rizz_sprite_vertex)*dd->num_verts);
+    // quad sprites: transform instances to world, they are drawn with the static unit quad
+    sg_bindings inst_bindings = { .index_buffer = dc->quad_ibuff,
+                                  .vertex_buffers[0] = dc->quad_vbuff,
+                                  .vertex_buffers[1] = dc->inst_buff };
+    int inst_offset = 0;
+    if (dd->num_instances > 0) {
+        for (int i = 0; i < dd->num_sprites; i++) {
+            const rizz_sprite_drawsprite* dspr = &dd->sprites[i];
+            if (dspr->instance >= 0) {
+                rizz_sprite_instance* inst = &dd->instances[dspr->instance];
+                sprite__instance_transform(inst, &mats[i]);
+                inst->color = sprite__color_mul(inst->color, tints[i]);
+            }
+        }
 
-    sprite__vertex_transform* tverts = sx_malloc(tmp_alloc, 
-                                                 sizeof(sprite__vertex_transform)*dd->num_verts);
-    sx_assert(tverts);
+        inst_offset = the_gfx->staged.append_buffer(
+            dc->inst_buff, dd->instances, sizeof(rizz_sprite_instance) * dd->num_instances);
+    }
+
+    // mesh sprites: vertices + per-vertex transforms
+    sg_bindings bindings = { .index_buffer = dc->ibuff,
+                             .vertex_buffers[0] = dc->vbuff[0],
+                             .vertex_buffers[1] = dc->vbuff[1] };
+    if (dd->num_verts > 0) {
+        // append drawdata to buffers
+        bindings.index_buffer_offset = the_gfx->staged.append_buffer(
+            dc->ibuff, dd->indices, sizeof(uint16_t) * dd->num_indices);
+        bindings.vertex_buffer_offsets[0] = the_gfx->staged.append_buffer(
+            dc->vbuff[0], dd->verts, sizeof(rizz_sprite_vertex) * dd->num_verts);
+
+        sprite__vertex_transform* tverts =
+            sx_malloc(tmp_alloc, sizeof(sprite__vertex_transform) * dd->num_verts);
+        sx_assert(tverts);
+
+        // put transforms into another vbuff
+        for (int i = 0; i < dd->num_sprites; i++) {
+            rizz_sprite_drawsprite* dspr = &dd->sprites[i];
+            const sx_mat3* m = &mats[i];
+
+            sx_vec3 t1 = sx_vec3f(m->m11, m->m12, m->m21);
+            sx_vec3 t2 = sx_vec3f(m->m22, m->m13, m->m23);
+            int end_vertex = dspr->start_vertex + dspr->num_verts;
+            for (int v = dspr->start_vertex; v < end_vertex; v++) {
+                tverts[v].t1 = t1;
+                tverts[v].t2 = t2;
+                tverts[v].color = tints[i].n;
+            }
+        }
+        bindings.vertex_buffer_offsets[1] = the_gfx->staged.append_buffer(
+            dc->vbuff[1], tverts, sizeof(sprite__vertex_transform) * dd->num_verts);
+    }
+
+    // draw both kinds of batches in one sequence, switch pipelines only where they interleave
+    sg_pipeline cur_pip = { 0 };
+    int b = 0;
+    for (int ib = 0; ib <= dd->num_instance_batches; ib++) {
+        int batch_end = ib < dd->num_instance_batches ? dd->instance_batches[ib].batch_index
+                                                      : dd->num_batches;
+        if (b < batch_end && cur_pip.id != dc->pip.id) {
+            cur_pip = dc->pip;
+            the_gfx->staged.apply_pipeline(cur_pip);
+            the_gfx->staged.apply_uniforms(SG_SHADERSTAGE_VS, 0, vp, sizeof(*vp));
+        }
+        for (; b < batch_end; b++) {
+            const rizz_sprite_drawbatch* batch = &dd->batches[b];
+            bindings.fs_images[0] = batch->image;
+            the_gfx->staged.apply_bindings(&bindings);
+            the_gfx->staged.draw(batch->index_start, batch->index_count, 1);
+        }
 
-    // put transforms into another vbuff
-    for (int i = 0; i < dd->num_sprites; i++) {
-        rizz_sprite_drawsprite* dspr = &dd->sprites[i];
-        const sx_mat3* m = &mats[i];
+        if (ib < dd->num_instance_batches) {
+            const rizz_sprite_instbatch* batch = &dd->instance_batches[ib];
+            if (cur_pip.id != dc->pip_inst.id) {
+                cur_pip = dc->pip_inst;
+                the_gfx->staged.apply_pipeline(cur_pip);
+                the_gfx->staged.apply_uniforms(SG_SHADERSTAGE_VS, 0, vp, sizeof(*vp));
+            }
+            inst_bindings.vertex_buffer_offsets[1] =
+                inst_offset + batch->instance_start * (int)sizeof(rizz_sprite_instance);
+            inst_bindings.fs_images[0] = batch->image;
+            the_gfx->staged.apply_bindings(&inst_bindings);
+            the_gfx->staged.draw(0, 6, batch->instance_count);
+        }
+    }
 
-        sx_vec3 t1 = sx_vec3f(m->m11, m->m12, m->m21);
-        sx_vec3 t2 = sx_vec3f(m->m22, m->m13, m->m23);
-        int end_vertex = dspr->start_vertex + dspr->num_verts;
-        for (int v = dspr->start_vertex; v < end_vertex; v++) {
-            tverts[v].t1 = t1;
-            tverts[v].t2 = t2;
-            tverts[v].color = tints[i].n;
+    the_core->tmp_alloc_pop();
+}
+
+static void sprite__draw(rizz_sprite spr, const sx_mat4* vp, const sx_mat3* mat, sx_color tint) {
+    sprite__draw_batch(&spr, 1, vp, mat, &tint);
+}
+
+static rizz_sprite_layer sprite__layer_create(int max_sprites)
+{
+    sx_assert(max_sprites > 0);
+
+    sx_handle_t handle = sx_handle_new_and_grow(g_spr.layer_handles, g_spr.alloc);
+    sx_assert(handle);
+
+    int num_chunks = (max_sprites + LAYER_CHUNK_SIZE - 1) / LAYER_CHUNK_SIZE;
+    sprite__layer layer = { .max_slots = max_sprites,
+                            .num_chunks = num_chunks,
+                            .dynatlas_generation = g_spr.dynatlas.generation };
+
+    // slots, chunks and chunk instances in one buffer
+    size_t total_sz = sizeof(sprite__layer_slot) * max_sprites +
+                      sizeof(sprite__layer_chunk) * num_chunks +
+                      sizeof(rizz_sprite_instance) * LAYER_CHUNK_SIZE * num_chunks;
+    uint8_t* buff = sx_malloc(g_spr.alloc, total_sz);
+    if (!buff) {
+        sx_out_of_memory();
+        sx_handle_del(g_spr.layer_handles, handle);
+        return (rizz_sprite_layer){ 0 };
+    }
+    sx_memset(buff, 0x0, total_sz);
+
+    layer.slots = (sprite__layer_slot*)buff;
+    buff += sizeof(sprite__layer_slot) * max_sprites;
+    layer.chunks = (sprite__layer_chunk*)buff;
+    buff += sizeof(sprite__layer_chunk) * num_chunks;
+    for (int i = 0; i < num_chunks; i++) {
+        sprite__layer_chunk* chunk = &layer.chunks[i];
+        chunk->instances = (rizz_sprite_instance*)buff;
+        chunk->update_frame = -1;
+        buff += sizeof(rizz_sprite_instance) * LAYER_CHUNK_SIZE;
+        chunk->buff = the_gfx->make_buffer(
+            &(sg_buffer_desc){ .size = sizeof(rizz_sprite_instance) * LAYER_CHUNK_SIZE,
+                               .usage = SG_USAGE_DYNAMIC,
+                               .type = SG_BUFFERTYPE_VERTEXBUFFER });
+        sx_assert(chunk->buff.id);
+    }
+
+    sx_array_push_byindex(g_spr.alloc, g_spr.layers, layer, sx_handle_index(handle));
+    return (rizz_sprite_layer){ handle };
+}
+
+static void sprite__layer_destroy(rizz_sprite_layer handle)
+{
+    sx_assert_rel(sx_handle_valid(g_spr.layer_handles, handle.id));
+    sprite__layer* layer = &g_spr.layers[sx_handle_index(handle.id)];
+
+    for (int i = 0; i < layer->num_slots; i++) {
+        const sprite__layer_slot* slot = &layer->slots[i];
+        if (slot->spr.id && sx_handle_valid(g_spr.sprite_handles, slot->spr.id)) {
+            sprite__data* spr = &g_spr.sprites[sx_handle_index(slot->spr.id)];
+            spr->layer = (rizz_sprite_layer){ 0 };
         }
     }
-    int vb_offset2 = the_gfx->staged.append_buffer(dc->vbuff[1], tverts, 
-                                                   sizeof(sprite__vertex_transform)*dd->num_verts);
 
-    sg_bindings bindings = {
-        .index_buffer = g_spr.drawctx.ibuff,
-        .vertex_buffers[0] = g_spr.drawctx.vbuff[0],
-        .vertex_buffers[1] = g_spr.drawctx.vbuff[1],
-        .vertex_buffer_offsets[0] = vb_offset1,
-        .vertex_buffer_offsets[1] = vb_offset2,
-        .index_buffer_offset = ib_offset,
-    };
+    for (int i = 0; i < layer->num_chunks; i++) {
+        sprite__layer_chunk* chunk = &layer->chunks[i];
+        if (chunk->buff.id)
+            the_gfx->destroy_buffer(chunk->buff);
+        sx_array_free(g_spr.alloc, chunk->batches);
+        sx_array_free(g_spr.alloc, chunk->mesh_slots);
+    }
 
-    the_gfx->staged.apply_pipeline(dc->pip);
-    the_gfx->staged.apply_uniforms(SG_SHADERSTAGE_VS, 0, vp, sizeof(*vp));
+    sx_array_free(g_spr.alloc, layer->free_slots);
+    sx_array_free(g_spr.alloc, layer->animated);
+    sx_free(g_spr.alloc, layer->slots);    // the whole buffer, see `sprite__layer_create`
+    sx_memset(layer, 0x0, sizeof(*layer));
 
-    // draw with batching
-    for (int i = 0; i < dd->num_batches; i++)  {
-        rizz_sprite_drawbatch* batch = &dd->batches[i];
-        bindings.fs_images[0] = ((rizz_texture*)the_asset->obj_threadsafe(batch->texture).ptr)->img;
-        the_gfx->staged.apply_bindings(&bindings);
-        the_gfx->staged.draw(batch->index_start, batch->index_count, 1);
-    }    
+    sx_handle_del(g_spr.layer_handles, handle.id);
+}
 
-    the_core->tmp_alloc_pop();
+static bool sprite__layer_add(rizz_sprite_layer handle, rizz_sprite spr_handle, const sx_mat3* mat,
+                              sx_color tint)
+{
+    sx_assert_rel(sx_handle_valid(g_spr.layer_handles, handle.id));
+    sx_assert_rel(sx_handle_valid(g_spr.sprite_handles, spr_handle.id));
+    sprite__layer* layer = &g_spr.layers[sx_handle_index(handle.id)];
+    sprite__data* spr = &g_spr.sprites[sx_handle_index(spr_handle.id)];
+    sx_assert(!spr->layer.id && "sprite is already in a layer");
+
+    int slot_index;
+    if (sx_array_count(layer->free_slots) > 0) {
+        slot_index = sx_array_last(layer->free_slots);
+        sx_array_pop_last(layer->free_slots);
+    } else if (layer->num_slots < layer->max_slots) {
+        slot_index = layer->num_slots++;
+    } else {
+        return false;
+    }
+
+    layer->slots[slot_index] = (sprite__layer_slot){ .spr = spr_handle,
+                                                     .mat = *mat,
+                                                     .tint = tint,
+                                                     .atlas_sprite_id = spr->atlas_sprite_id };
+    if (spr->clip.id || spr->ctrl.id) {
+        sx_array_push(g_spr.alloc, layer->animated, slot_index);
+    }
+
+    spr->layer = handle;
+    spr->layer_slot = slot_index;
+    layer->chunks[slot_index / LAYER_CHUNK_SIZE].dirty = true;
+    return true;
 }
 
-static void sprite__draw(rizz_sprite spr, const sx_mat4* vp, const sx_mat3* mat, sx_color tint) {
-    sprite__draw_batch(&spr, 1, vp, mat, &tint);
+static void sprite__layer_remove(rizz_sprite_layer handle, rizz_sprite spr_handle)
+{
+    sx_assert_rel(sx_handle_valid(g_spr.layer_handles, handle.id));
+    sx_assert_rel(sx_handle_valid(g_spr.sprite_handles, spr_handle.id));
+    sprite__data* spr = &g_spr.sprites[sx_handle_index(spr_handle.id)];
+    sx_assert(spr->layer.id == handle.id && "sprite is not in this layer");
+
+    sprite__layer_remove_sprite(&g_spr.layers[sx_handle_index(handle.id)], spr);
+}
+
+static void sprite__layer_set_transform(rizz_sprite_layer handle, rizz_sprite spr_handle,
+                                        const sx_mat3* mat, sx_color tint)
+{
+    sx_assert_rel(sx_handle_valid(g_spr.layer_handles, handle.id));
+    sx_assert_rel(sx_handle_valid(g_spr.sprite_handles, spr_handle.id));
+    const sprite__data* spr = &g_spr.sprites[sx_handle_index(spr_handle.id)];
+    sx_assert(spr->layer.id == handle.id && "sprite is not in this layer");
+
+    sprite__layer* layer = &g_spr.layers[sx_handle_index(handle.id)];
+    sprite__layer_slot* slot = &layer->slots[spr->layer_slot];
+    slot->mat = *mat;
+    slot->tint = tint;
+    layer->chunks[spr->layer_slot / LAYER_CHUNK_SIZE].dirty = true;
+}
+
+// rebuilds world-space instances and batches of the chunk
+// free slots and mesh sprites are written as degenerate (zero) instances, free slots can stay in
+// the middle of a batch, mesh sprites end it, so they are drawn in between
+static void sprite__layer_build_chunk(sprite__layer* layer, int chunk_index)
+{
+    sprite__layer_chunk* chunk = &layer->chunks[chunk_index];
+    sx_array_clear(chunk->batches);
+    sx_array_clear(chunk->mesh_slots);
+    chunk->dynatlas = false;
+
+    int start = chunk_index * LAYER_CHUNK_SIZE;
+    int end = sx_min(start + LAYER_CHUNK_SIZE, layer->num_slots);
+    sprite__layer_batch* batch = NULL;
+    for (int i = start; i < end; i++) {
+        sprite__layer_slot* slot = &layer->slots[i];
+        rizz_sprite_instance* inst = &chunk->instances[i - start];
+        const sprite__data* spr =
+            slot->spr.id ? &g_spr.sprites[sx_handle_index(slot->spr.id)] : NULL;
+
+        if (spr) {
+            slot->atlas_sprite_id = spr->atlas_sprite_id;
+            chunk->dynatlas |= spr->dynatlas_region >= 0;
+        }
+
+        if (!spr) {
+            sx_memset(inst, 0x0, sizeof(*inst));
+            if (batch && !batch->mesh) {
+                ++batch->count;
+            }
+            continue;
+        }
+
+        if (!sprite__is_instanced(spr)) {
+            sx_memset(inst, 0x0, sizeof(*inst));
+            if (batch && batch->mesh) {
+                ++batch->count;
+            } else {
+                sprite__layer_batch b = { .start = sx_array_count(chunk->mesh_slots),
+                                          .count = 1,
+                                          .mesh = true };
+                sx_array_push(g_spr.alloc, chunk->batches, b);
+                batch = &sx_array_last(chunk->batches);
+            }
+            sx_array_push(g_spr.alloc, chunk->mesh_slots, i);
+            continue;
+        }
+
+        sprite__instance_local(spr, inst);
+        sprite__instance_transform(inst, &slot->mat);
+        inst->color = sprite__color_mul(inst->color, slot->tint);
+
+        const sprite__dynatlas_region* region = sprite__dynatlas_get(spr);
+        int page = region ? region->page : -1;
+        if (!batch || batch->mesh || batch->page != page ||
+            (page == -1 && batch->texture.id != spr->texture.id)) {
+            sprite__layer_batch b = { .start = i - start,
+                                      .count = 1,
+                                      .texture = spr->texture,
+                                      .page = page };
+            sx_array_push(g_spr.alloc, chunk->batches, b);
+            batch = &sx_array_last(chunk->batches);
+        } else {
+            ++batch->count;
+        }
+    }
+}
+
+static void sprite__layer_draw(rizz_sprite_layer handle, const sx_mat4* vp)
+{
+    sx_assert_rel(sx_handle_valid(g_spr.layer_handles, handle.id));
+    sprite__layer* layer = &g_spr.layers[sx_handle_index(handle.id)];
+    const sprite__dynatlas* da = &g_spr.dynatlas;
+    const sprite__draw_context* dc = &g_spr.drawctx;
+
+    if (layer->num_slots == 0) {
+        return;
+    }
+
+    // texture sprites change image/uv when they are packed into dynamic atlas
+    if (layer->dynatlas_generation != da->generation) {
+        for (int i = 0; i < layer->num_chunks; i++) {
+            layer->chunks[i].dirty |= layer->chunks[i].dynatlas;
+        }
+        layer->dynatlas_generation = da->generation;
+    }
+
+    // animated sprites are dirty only when their frame changes
+    for (int i = 0, c = sx_array_count(layer->animated); i < c; i++) {
+        int slot_index = layer->animated[i];
+        sprite__data* spr = &g_spr.sprites[sx_handle_index(layer->slots[slot_index].spr.id)];
+        if (spr->ctrl.id) {
+            spr->clip = sprite__animctrl_clip(spr->ctrl);
+        }
+        if (spr->clip.id) {
+            sprite__sync_with_animclip(spr);
+        }
+        if (spr->atlas_sprite_id != layer->slots[slot_index].atlas_sprite_id) {
+            layer->chunks[slot_index / LAYER_CHUNK_SIZE].dirty = true;
+        }
+    }
+
+    const sx_alloc* tmp_alloc = the_core->tmp_alloc_push();
+    int64_t frame = the_core->frame_index();
+    int num_chunks = (layer->num_slots + LAYER_CHUNK_SIZE - 1) / LAYER_CHUNK_SIZE;
+
+    // mesh sprites are not retained, runs of them are gathered here and drawn in between batches
+    rizz_sprite* sprs = NULL;
+    sx_mat3* mats = NULL;
+    sx_color* tints = NULL;
+
+    sg_bindings bindings = { .index_buffer = dc->quad_ibuff, .vertex_buffers[0] = dc->quad_vbuff };
+    the_gfx->staged.apply_pipeline(dc->pip_inst);
+    the_gfx->staged.apply_uniforms(SG_SHADERSTAGE_VS, 0, vp, sizeof(*vp));
+
+    for (int i = 0; i < num_chunks; i++) {
+        sprite__layer_chunk* chunk = &layer->chunks[i];
+
+        // dynamic buffers can only be updated once per frame, changes after that are delayed
+        if (chunk->dirty && chunk->update_frame != frame) {
+            sprite__layer_build_chunk(layer, i);
+            int count = sx_min(LAYER_CHUNK_SIZE, layer->num_slots - i * LAYER_CHUNK_SIZE);
+            the_gfx->staged.update_buffer(chunk->buff, chunk->instances,
+                                          sizeof(rizz_sprite_instance) * count);
+            chunk->update_frame = frame;
+            chunk->dirty = false;
+        }
+
+        bindings.vertex_buffers[1] = chunk->buff;
+        for (int b = 0, bc = sx_array_count(chunk->batches); b < bc; b++) {
+            const sprite__layer_batch* batch = &chunk->batches[b];
+            if (batch->mesh) {
+                if (!sprs) {
+                    sprs = sx_malloc(tmp_alloc, sizeof(rizz_sprite) * LAYER_CHUNK_SIZE);
+                    mats = sx_malloc(tmp_alloc, sizeof(sx_mat3) * LAYER_CHUNK_SIZE);
+                    tints = sx_malloc(tmp_alloc, sizeof(sx_color) * LAYER_CHUNK_SIZE);
+                    if (!sprs || !mats || !tints) {
+                        sx_out_of_memory();
+                        the_core->tmp_alloc_pop();
+                        return;
+                    }
+                }
+                for (int m = 0; m < batch->count; m++) {
+                    const sprite__layer_slot* slot =
+                        &layer->slots[chunk->mesh_slots[batch->start + m]];
+                    sprs[m] = slot->spr;
+                    mats[m] = slot->mat;
+                    tints[m] = slot->tint;
+                }
+                sprite__draw_batch(sprs, batch->count, vp, mats, tints);
+
+                the_gfx->staged.apply_pipeline(dc->pip_inst);
+                the_gfx->staged.apply_uniforms(SG_SHADERSTAGE_VS, 0, vp, sizeof(*vp));
+                continue;
+            }
+
+            bindings.vertex_buffer_offsets[1] = batch->start * (int)sizeof(rizz_sprite_instance);
+            bindings.fs_images[0] =
+                batch->page >= 0
+                    ? da->pages[batch->page].img
+                    : ((rizz_texture*)the_asset->obj_threadsafe(batch->texture).ptr)->img;
+            the_gfx->staged.apply_bindings(&bindings);
+            the_gfx->staged.draw(0, 6, batch->count);
+        }
+    }
+
+    the_core->tmp_alloc_pop();
 }
 
 static void sprite__draw_wireframe_batch(const rizz_sprite* sprs, int num_sprites, const sx_mat4* vp, 
@@ -2073,7 +3741,9 @@ static void sprite__show_animclip_tab_contents(sprite__data* spr)
     sx_assert(spr->clip.id);
     sx_assert(sx_handle_valid(g_spr.animclip_handles, spr->clip.id));
 
-    sprite__animclip* clip = &g_spr.animclips[sx_handle_index(spr->clip.id)];
+    int clip_index = sx_handle_index(spr->clip.id);
+    sprite__animclip* clip = &g_spr.animclips[clip_index];
+    sprite__animclip_state* st = &g_spr.animclip_state;
 
     the_imgui->Columns(2, "animclip_cols", true);
 
@@ -2083,24 +3753,24 @@ static void sprite__show_animclip_tab_contents(sprite__data* spr)
 
     the_imgui->Text("num_frames");
     the_imgui->NextColumn();
-    the_imgui->Text("%d", clip->num_frames);
+    the_imgui->Text("%d", st->num_frames[clip_index]);
     the_imgui->NextColumn();
     the_imgui->Text("time");
     the_imgui->NextColumn();
-    the_imgui->Text("%.3f", clip->tm);
+    the_imgui->Text("%.3f", st->tm[clip_index]);
     the_imgui->NextColumn();
     the_imgui->Text("frame");
     the_imgui->NextColumn();
-    the_imgui->Text("%d", clip->frame_id);
+    the_imgui->Text("%d", st->frame_id[clip_index]);
     the_imgui->NextColumn();
     the_imgui->Text("duration");
     the_imgui->NextColumn();
-    the_imgui->Text("%.2f", clip->len);
+    the_imgui->Text("%.2f", st->len[clip_index]);
     the_imgui->NextColumn();
     the_imgui->Text("fps");
     the_imgui->NextColumn();
-    if (the_imgui->DragFloat("", &clip->fps, 0.1f, 0.1f, 200.0f, "%.1f", 1.0f)) {
-        clip->len = (float)clip->num_frames / clip->fps;
+    if (the_imgui->DragFloat("", &st->fps[clip_index], 0.1f, 0.1f, 200.0f, "%.1f", 1.0f)) {
+        st->len[clip_index] = (float)st->num_frames[clip_index] / st->fps[clip_index];
     }
     the_imgui->NextColumn();
 
@@ -2183,6 +3853,14 @@ static void sprite__show_debugger(bool* p_open)
     the_imgui->SetNextWindowSizeConstraints(sx_vec2f(350.0f, 500.0f), sx_vec2f(FLT_MAX, FLT_MAX),
                                             NULL, NULL);
     if (the_imgui->Begin("Sprite Debugger", p_open, 0)) {
+        const sprite__dynatlas* da = &g_spr.dynatlas;
+        g_spr.dynatlas.collect_stats = true;
+        the_imgui->Text("Batches: %d (without dynamic atlas: %d)", da->stats_batches,
+                        da->stats_batches_unpacked);
+        the_imgui->Text("Dynamic atlas: %d/%d pages (%dx%d)", da->num_pages, DYNATLAS_MAX_PAGES,
+                        DYNATLAS_PAGE_SIZE, DYNATLAS_PAGE_SIZE);
+        the_imgui->Separator();
+
         the_imgui->Columns(3, NULL, false);
         the_imgui->SetColumnWidth(0, 70.0f);
         the_imgui->Text("Handle");
@@ -2272,11 +3950,19 @@ static rizz_api_sprite the__sprite = { .create = sprite__create,
                                        .set_flip = sprite__set_flip,
                                        .make_drawdata = sprite__drawdata_make,
                                        .make_drawdata_batch = sprite__drawdata_make_batch,
+                                       .make_drawdata_instanced_batch =
+                                           sprite__drawdata_make_instanced_batch,
                                        .free_drawdata = sprite__drawdata_free,
                                        .draw = sprite__draw,
                                        .draw_batch = sprite__draw_batch,
                                        .draw_wireframe_batch = sprite__draw_wireframe_batch,
                                        .resize_draw_limits = sprite__resize_draw_limits,
+                                       .layer_create = sprite__layer_create,
+                                       .layer_destroy = sprite__layer_destroy,
+                                       .layer_add = sprite__layer_add,
+                                       .layer_remove = sprite__layer_remove,
+                                       .layer_set_transform = sprite__layer_set_transform,
+                                       .layer_draw = sprite__layer_draw,
                                        .animclip_create = sprite__animclip_create,
                                        .animclip_destroy = sprite__animclip_destroy,
                                        .animclip_clone = sprite__animclip_clone,
@@ -2284,7 +3970,6 @@ static rizz_api_sprite the__sprite = { .create = sprite__create,
                                        .animclip_update_batch = sprite__animclip_update_batch,
                                        .animclip_fps = sprite__animclip_fps,
                                        .animclip_len = sprite__animclip_len,
-                                       .animclip_events = sprite__animclip_events,
                                        .animclip_set_fps = sprite__animclip_set_fps,
                                        .animclip_set_len = sprite__animclip_set_len,
                                        .animclip_restart = sprite__animclip_restart,
@@ -2299,12 +3984,19 @@ static rizz_api_sprite the__sprite = { .create = sprite__create,
                                        .animctrl_param_valuei = sprite__animctrl_param_valuei,
                                        .animctrl_param_valuef = sprite__animctrl_param_valuef,
                                        .animctrl_restart = sprite__animctrl_restart,
+                                       .events = sprite__events,
+                                       .atlas_save_binary = atlas__save_binary,
                                        .show_debugger = sprite__show_debugger };
 
 rizz_plugin_decl_main(sprite, plugin, e)
 {
     switch (e) {
     case RIZZ_PLUGIN_EVENT_STEP:
+        sx_array_clear(g_spr.events);
+        for (int i = 0; i < g_spr.num_thread_event_bufs; i++) {
+            sx_array_clear(g_spr.thread_events[i]);
+        }
+        sprite__dynatlas_update();
         break;
 
     case RIZZ_PLUGIN_EVENT_INIT:
@@ -7,7 +7,11 @@ layout (location = TEXCOORD2) in vec3 a_transform2;
 
 layout (location = COLOR0) flat out vec4 f_color;
 
-#ifdef WIREFRAME
+#if defined(INSTANCED)
+// a_pos: unit quad corner, everything else is per-instance (see rizz_sprite_instance)
+layout (location = TEXCOORD3) in vec4 a_uv_rect;
+layout (location = TEXCOORD0) out vec2 f_uv;
+#elif defined(WIREFRAME)
 layout (location = TEXCOORD3) in  vec3 a_bc;
 layout (location = TEXCOORD0) out vec3 f_bc;
 #else
@@ -30,7 +34,10 @@ void main()
     gl_Position = vp * pos;
 
 
-#ifdef WIREFRAME
+#if defined(INSTANCED)
+    f_color = a_color1;
+    f_uv = mix(a_uv_rect.xy, a_uv_rect.zw, a_pos);
+#elif defined(WIREFRAME)
     f_color = a_color1;
     f_bc = a_bc;
 #else
@@ -5,7 +5,10 @@
 #include "sx/fiber.h"
 #include "sx/allocator.h"
 #include "sx/os.h"
+#include "sx/atomic.h"
 #include "sx/pool.h"
+#include "sx/threads.h"
+#include "sx/virtual-alloc.h"
 
 #include <stdlib.h>
 
@@ -89,6 +92,283 @@ void sx_fiber_stack_release(sx_fiber_stack* fstack)
 #endif
 }
 
+// Stack pool: each class reserves a continuous range of virtual memory for all of it's stacks
+//             Each slot is [guard page][stack memory], and the guard page is never committed
+typedef struct sx__fiber_stack_class {
+    uint8_t* base;
+    size_t slot_sz;
+    int stack_sz;
+    int max_stacks;
+    int num_new;       // slots [0, num_new) are taken at least once
+    int num_free;      // count of free_list
+    int* free_list;    // LIFO: last item is the most recently returned stack
+    int* hwm;          // high-water mark of each slot, recorded before decommit
+    bool* committed;
+} sx__fiber_stack_class;
+
+typedef struct sx_fiber_stack_pool {
+    sx__fiber_stack_class classes[2];    // 0: small, 1: large
+    sx_lock_t lock;
+} sx_fiber_stack_pool;
+
+static bool sx__fiber_stack_class_init(sx__fiber_stack_class* c, const sx_alloc* alloc,
+                                       int stack_sz, int max_stacks)
+{
+    sx_memset(c, 0x0, sizeof(sx__fiber_stack_class));
+    if (stack_sz <= 0 || max_stacks <= 0)
+        return true;
+
+    c->stack_sz = (int)sx_os_align_pagesz((size_t)stack_sz);
+    c->slot_sz = (size_t)c->stack_sz + sx_os_pagesz();
+    c->max_stacks = max_stacks;
+    c->base = (uint8_t*)sx_virtual_reserve(c->slot_sz * (size_t)max_stacks);
+    if (!c->base) {
+        sx_out_of_memory();
+        return false;
+    }
+
+    uint8_t* buff = sx_malloc(alloc, (sizeof(int) * 2 + sizeof(bool)) * (size_t)max_stacks);
+    if (!buff) {
+        // leave the class empty, so nothing is left behind for the caller to release
+        sx_virtual_release(c->base, c->slot_sz * (size_t)max_stacks);
+        sx_memset(c, 0x0, sizeof(sx__fiber_stack_class));
+        sx_out_of_memory();
+        return false;
+    }
+    c->free_list = (int*)buff;
+    buff += sizeof(int) * max_stacks;
+    c->hwm = (int*)buff;
+    buff += sizeof(int) * max_stacks;
+    c->committed = (bool*)buff;
+    sx_memset(c->hwm, 0x0, sizeof(int) * max_stacks);
+    sx_memset(c->committed, 0x0, sizeof(bool) * max_stacks);
+    return true;
+}
+
+static inline uint8_t* sx__fiber_stack_class_bottom(const sx__fiber_stack_class* c, int index)
+{
+    return c->base + c->slot_sz * (size_t)index + sx_os_pagesz();
+}
+
+// posix: stacks are mapped with MAP_NORESERVE, so they are not charged up-front and only the pages
+//        that the fiber touches are backed, the stack grows page by page
+// windows: the whole stack is committed, the guard page mechanism that grows thread stacks doesn't
+//          apply to fibers
+static bool sx__fiber_stack_commit(void* ptr, size_t sz)
+{
+#if SX_PLATFORM_POSIX
+#    ifndef MAP_NORESERVE
+#        define MAP_NORESERVE 0
+#    endif
+    return mmap(ptr, sz, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED | MAP_NORESERVE, -1, 0) != MAP_FAILED;
+#else
+    return sx_virtual_commit(ptr, sz) != NULL;
+#endif
+}
+
+// measures the high-water mark of the stack and adds the backed memory of it to `backed_sz`
+#if SX_PLATFORM_POSIX
+// the lowest resident page is the high-water mark (page granular). mincore doesn't touch the pages,
+// scanning the memory for the lowest non-zero word would back all of them
+static int sx__fiber_stack_class_usage(sx__fiber_stack_class* c, int index, int64_t* backed_sz)
+{
+    if (c->committed[index]) {
+        size_t page_sz = sx_os_pagesz();
+        uint8_t* bottom = sx__fiber_stack_class_bottom(c, index);
+        int num_pages = (int)((size_t)c->stack_sz / page_sz);
+        int lowest = num_pages;
+        unsigned char vec[256];
+        for (int p = 0; p < num_pages; p += (int)sizeof(vec)) {
+            int count = sx_min(num_pages - p, (int)sizeof(vec));
+            if (mincore(bottom + page_sz * (size_t)p, page_sz * (size_t)count, (void*)vec) != 0)
+                break;
+            for (int i = 0; i < count; i++) {
+                if (vec[i] & 1) {
+                    lowest = sx_min(lowest, p + i);
+                    if (backed_sz)
+                        *backed_sz += (int64_t)page_sz;
+                }
+            }
+        }
+        c->hwm[index] = sx_max(c->hwm[index], (int)(page_sz * (size_t)(num_pages - lowest)));
+    }
+    return c->hwm[index];
+}
+#else
+// finds the lowest touched (non-zero) word of the stack
+static int sx__fiber_stack_class_usage(sx__fiber_stack_class* c, int index, int64_t* backed_sz)
+{
+    if (c->committed[index]) {
+        const uintptr_t* bottom = (const uintptr_t*)sx__fiber_stack_class_bottom(c, index);
+        const uintptr_t* limit = (const uintptr_t*)((uint8_t*)bottom + c->stack_sz - c->hwm[index]);
+        for (const uintptr_t* p = bottom; p < limit; p++) {
+            if (*p) {
+                c->hwm[index] = c->stack_sz - (int)((uint8_t*)p - (uint8_t*)bottom);
+                break;
+            }
+        }
+        if (backed_sz)
+            *backed_sz += c->stack_sz;
+    }
+    return c->hwm[index];
+}
+#endif
+
+static sx__fiber_stack_class* sx__fiber_stack_pool_find(sx_fiber_stack_pool* pool,
+                                                        const sx_fiber_stack* fstack, int* index)
+{
+    for (int i = 0; i < 2; i++) {
+        sx__fiber_stack_class* c = &pool->classes[i];
+        uint8_t* sptr = (uint8_t*)fstack->sptr;
+        if (c->base && sptr > c->base && sptr <= c->base + c->slot_sz * (size_t)c->max_stacks) {
+            *index = (int)((size_t)(sptr - c->base) / c->slot_sz) - 1;
+            return c;
+        }
+    }
+
+    sx_assert(0 && "stack does not belong to the pool");
+    return NULL;
+}
+
+sx_fiber_stack_pool* sx_fiber_stack_pool_create(const sx_alloc* alloc,
+                                                const sx_fiber_stack_pool_desc* desc)
+{
+    sx_assert(desc->small_stack_sz <= desc->large_stack_sz || desc->max_large == 0);
+
+    sx_fiber_stack_pool* pool = sx_malloc(alloc, sizeof(sx_fiber_stack_pool));
+    if (!pool) {
+        sx_out_of_memory();
+        return NULL;
+    }
+    sx_memset(pool, 0x0, sizeof(sx_fiber_stack_pool));
+
+    if (!sx__fiber_stack_class_init(&pool->classes[0], alloc, desc->small_stack_sz,
+                                    desc->max_small) ||
+        !sx__fiber_stack_class_init(&pool->classes[1], alloc, desc->large_stack_sz,
+                                    desc->max_large)) {
+        sx_fiber_stack_pool_destroy(pool, alloc);
+        return NULL;
+    }
+
+    return pool;
+}
+
+void sx_fiber_stack_pool_destroy(sx_fiber_stack_pool* pool, const sx_alloc* alloc)
+{
+    sx_assert(pool);
+    for (int i = 0; i < 2; i++) {
+        sx__fiber_stack_class* c = &pool->classes[i];
+        if (c->base)
+            sx_virtual_release(c->base, c->slot_sz * (size_t)c->max_stacks);
+        sx_free(alloc, c->free_list);
+    }
+    sx_free(alloc, pool);
+}
+
+bool sx_fiber_stack_pool_get(sx_fiber_stack_pool* pool, int size, sx_fiber_stack* fstack)
+{
+    sx__fiber_stack_class* c = size <= pool->classes[0].stack_sz ? &pool->classes[0]
+                                                                  : &pool->classes[1];
+    if (size > c->stack_sz) {
+        sx_assert(0 && "stack size is larger than the pool's large class");
+        return false;
+    }
+
+    sx_lock(&pool->lock, 1);
+    int index;
+    if (c->num_free > 0) {
+        index = c->free_list[--c->num_free];
+    } else if (c->num_new < c->max_stacks) {
+        index = c->num_new++;
+    } else {
+        sx_unlock(&pool->lock);
+        return false;
+    }
+
+    if (!c->committed[index]) {
+        if (!sx__fiber_stack_commit(sx__fiber_stack_class_bottom(c, index), (size_t)c->stack_sz)) {
+            c->free_list[c->num_free++] = index;
+            sx_unlock(&pool->lock);
+            sx_out_of_memory();
+            return false;
+        }
+        c->committed[index] = true;
+    }
+    sx_unlock(&pool->lock);
+
+    fstack->sptr = sx__fiber_stack_class_bottom(c, index) + c->stack_sz;
+    fstack->ssize = (unsigned int)c->stack_sz;
+    return true;
+}
+
+void sx_fiber_stack_pool_put(sx_fiber_stack_pool* pool, sx_fiber_stack* fstack)
+{
+    int index;
+    sx__fiber_stack_class* c = sx__fiber_stack_pool_find(pool, fstack, &index);
+    if (c) {
+        sx_lock(&pool->lock, 1);
+        sx_assert(c->num_free < c->max_stacks);
+        c->free_list[c->num_free++] = index;
+        sx_unlock(&pool->lock);
+    }
+    fstack->sptr = NULL;
+    fstack->ssize = 0;
+}
+
+void sx_fiber_stack_pool_trim(sx_fiber_stack_pool* pool, int keep)
+{
+    sx_lock(&pool->lock, 1);
+    for (int i = 0; i < 2; i++) {
+        sx__fiber_stack_class* c = &pool->classes[i];
+        for (int k = 0, count = c->num_free - keep; k < count; k++) {
+            int index = c->free_list[k];
+            if (c->committed[index]) {
+                sx__fiber_stack_class_usage(c, index, NULL);
+                sx_virtual_decommit(sx__fiber_stack_class_bottom(c, index), (size_t)c->stack_sz);
+                c->committed[index] = false;
+            }
+        }
+    }
+    sx_unlock(&pool->lock);
+}
+
+int sx_fiber_stack_pool_usage(sx_fiber_stack_pool* pool, const sx_fiber_stack* fstack)
+{
+    int index;
+    sx__fiber_stack_class* c = sx__fiber_stack_pool_find(pool, fstack, &index);
+    if (!c)
+        return 0;
+
+    sx_lock(&pool->lock, 1);
+    int usage = sx__fiber_stack_class_usage(c, index, NULL);
+    sx_unlock(&pool->lock);
+    return usage;
+}
+
+void sx_fiber_stack_pool_get_info(sx_fiber_stack_pool* pool, sx_fiber_stack_pool_info* info)
+{
+    sx_fiber_stack_pool_class_info* infos[2] = { &info->small, &info->large };
+
+    sx_lock(&pool->lock, 1);
+    for (int i = 0; i < 2; i++) {
+        sx__fiber_stack_class* c = &pool->classes[i];
+        sx_fiber_stack_pool_class_info* ci = infos[i];
+        ci->stack_sz = c->stack_sz;
+        ci->max_stacks = c->max_stacks;
+        ci->num_used = c->num_new - c->num_free;
+        ci->num_committed = 0;
+        ci->committed_sz = 0;
+        ci->peak_usage = 0;
+        for (int k = 0; k < c->num_new; k++) {
+            ci->num_committed += c->committed[k] ? 1 : 0;
+            int usage = sx__fiber_stack_class_usage(c, k, &ci->committed_sz);
+            ci->peak_usage = sx_max(ci->peak_usage, usage);
+        }
+    }
+    sx_unlock(&pool->lock);
+}
+
 sx_fiber_t sx_fiber_create(const sx_fiber_stack stack, sx_fiber_cb* fiber_cb)
 {
     return make_fcontext(stack.sptr, stack.ssize, fiber_cb);
@@ -104,13 +384,34 @@ typedef enum {
     CORO_RET_END,      // Executation is finished
     CORO_RET_YIELD,    // Pass this 'update' to the next N update which is 'arg' in
                        // sx_fiber_return
-    CORO_RET_WAIT      // Wait for msecs: 'arg' is msecs in sx_fiber_return
+    CORO_RET_WAIT,     // Wait for msecs: 'arg' is msecs in sx_fiber_return
+    CORO_RET_WAIT_COUNTER    // Wait for a counter (sx_job_t) to reach zero
 } sx_coro_ret_type;
 
+// scheduling: yielded coroutines are kept in buckets by the update number they resume on, and
+// waiting ones in a hierarchical timer wheel (1ms ticks), so updates only touch due coroutines
+#define SX__CORO_YIELD_BUCKETS 64    // pow2: yields of more updates stay in their bucket longer
+#define SX__CORO_WHEEL_BITS0 8       // level0: 256 slots of 1ms
+#define SX__CORO_WHEEL_BITS 6        // level1..3: 64 slots each, 256ms / 16.4s / 17.5min per slot
+#define SX__CORO_WHEEL_LEVELS 4
+#define SX__CORO_WHEEL_SLOTS0 (1 << SX__CORO_WHEEL_BITS0)
+#define SX__CORO_WHEEL_SLOTS (1 << SX__CORO_WHEEL_BITS)
+#define SX__CORO_WHEEL_MAX_DELTA \
+    (((int64_t)1 << (SX__CORO_WHEEL_BITS0 + SX__CORO_WHEEL_BITS * (SX__CORO_WHEEL_LEVELS - 1))) - 1)
+
+#define SX__CORO_TRIM_INTERVAL 1.0    // seconds: owned stack pool is trimmed this often
+#define SX__CORO_KEEP_STACKS 4        // free stacks that stay committed when the pool is trimmed
+
 typedef union {
-    float tm;
-    int n;
-} sx__coro_state_counter;
+    double tm;        // CORO_RET_WAIT: wake time in seconds (context time)
+    int64_t frame;    // CORO_RET_YIELD: update number to resume on
+    volatile int* counter;    // CORO_RET_WAIT_COUNTER
+} sx__coro_wake;
+
+typedef struct sx__coro_list {
+    struct sx__coro_state* first;
+    struct sx__coro_state* last;
+} sx__coro_list;
 
 typedef struct sx__coro_state {
     sx_fiber_t fiber;
@@ -118,48 +419,159 @@ typedef struct sx__coro_state {
     sx_fiber_cb* callback;
     void* user;
     sx_coro_ret_type ret_state;
-    sx__coro_state_counter arg;
-    sx__coro_state_counter counter;
+    sx_coro_flags flags;
+    sx__coro_wake wake;
+    sx__coro_list* list;    // schedule list that the coroutine is in (NULL while running)
     struct sx__coro_state* next;
     struct sx__coro_state* prev;
+    struct sx__coro_state* all_next;    // links of sx_coro_context.all (all coroutines)
+    struct sx__coro_state* all_prev;
 } sx__coro_state;
 
 typedef struct sx_coro_context {
     sx_pool* coro_pool;
-    sx__coro_state* run_list;
-    sx__coro_state* run_list_last;
+    sx_fiber_stack_pool* stack_pool;
+    sx__coro_state* all;
     sx__coro_state* cur_coro;
     int stack_sz;
+    bool own_stack_pool;
+
+    // between sx_coro_update_begin/end, coroutines may run on any thread: the running coroutine is
+    // kept per-thread and the lists/pools are protected by `lk`
+    bool mt;
+    sx_tls cur_tls;
+    sx_lock_t lk;
+    sx__coro_state** due;    // count: max_fibers, any-thread ones first, main-thread ones at the end
+    int num_due_any;
+    int num_due_main;
+    int max_fibers;
+
+    double time;         // accumulated delta-time of updates (seconds)
+    double trim_time;    // next time that the owned stack pool is trimmed
+    int64_t tick;     // last processed tick of the timer wheel (ms)
+    int64_t frame;    // number of updates
+    sx__coro_list yields[SX__CORO_YIELD_BUCKETS];
+    sx__coro_list wheel0[SX__CORO_WHEEL_SLOTS0];
+    sx__coro_list wheel[SX__CORO_WHEEL_LEVELS - 1][SX__CORO_WHEEL_SLOTS];
+    sx__coro_list pending;     // waits that are due in the current tick, checked on each update
+    sx__coro_list counters;    // counter waits, checked on each update
 } sx_coro_context;
 
-static inline void sx__coro_add_list(sx__coro_state** pfirst, sx__coro_state** plast,
-                                     sx__coro_state* node)
+static inline void sx__coro_add_list(sx__coro_list* list, sx__coro_state* node)
 {
     // Add to the end of the list
-    if (*plast) {
-        (*plast)->next = node;
-        node->prev = *plast;
+    sx_assert(node->list == NULL);
+    if (list->last) {
+        list->last->next = node;
+        node->prev = list->last;
     }
-    *plast = node;
-    if (*pfirst == NULL)
-        *pfirst = node;
+    list->last = node;
+    if (list->first == NULL)
+        list->first = node;
+    node->list = list;
 }
 
-static inline void sx__coro_remove_list(sx__coro_state** pfirst, sx__coro_state** plast,
-                                        sx__coro_state* node)
+static inline void sx__coro_remove_list(sx__coro_state* node)
 {
+    sx__coro_list* list = node->list;
+    if (!list)
+        return;
     if (node->prev)
         node->prev->next = node->next;
     if (node->next)
         node->next->prev = node->prev;
-    if (*pfirst == node)
-        *pfirst = node->next;
-    if (*plast == node)
-        *plast = node->prev;
+    if (list->first == node)
+        list->first = node->next;
+    if (list->last == node)
+        list->last = node->prev;
     node->prev = node->next = NULL;
+    node->list = NULL;
 }
 
-sx_coro_context* sx_coro_create_context(const sx_alloc* alloc, int max_fibers, int stack_sz)
+// moves all nodes of `src` to the end of `dst`
+static inline void sx__coro_move_list(sx__coro_list* dst, sx__coro_list* src)
+{
+    for (sx__coro_state* node = src->first; node; node = node->next)
+        node->list = dst;
+    if (src->first) {
+        if (dst->last) {
+            dst->last->next = src->first;
+            src->first->prev = dst->last;
+        } else {
+            dst->first = src->first;
+        }
+        dst->last = src->last;
+    }
+    src->first = src->last = NULL;
+}
+
+static inline int64_t sx__coro_wake_tick(const sx__coro_state* fs)
+{
+    return (int64_t)(fs->wake.tm * 1000.0);
+}
+
+static void sx__coro_schedule_wait(sx_coro_context* ctx, sx__coro_state* fs)
+{
+    int64_t wake_tick = sx__coro_wake_tick(fs);
+    int64_t delta = wake_tick - ctx->tick;
+    if (delta <= 0) {
+        sx__coro_add_list(&ctx->pending, fs);
+    } else if (delta < SX__CORO_WHEEL_SLOTS0) {
+        sx__coro_add_list(&ctx->wheel0[wake_tick & (SX__CORO_WHEEL_SLOTS0 - 1)], fs);
+    } else {
+        // far timers are clamped to the last level, and rescheduled when they are cascaded
+        if (delta > SX__CORO_WHEEL_MAX_DELTA)
+            wake_tick = ctx->tick + SX__CORO_WHEEL_MAX_DELTA;
+
+        int shift = SX__CORO_WHEEL_BITS0;
+        int level = 0;
+        while (level < SX__CORO_WHEEL_LEVELS - 2 &&
+               delta >= ((int64_t)1 << (shift + SX__CORO_WHEEL_BITS))) {
+            shift += SX__CORO_WHEEL_BITS;
+            ++level;
+        }
+        sx__coro_add_list(&ctx->wheel[level][(wake_tick >> shift) & (SX__CORO_WHEEL_SLOTS - 1)],
+                          fs);
+    }
+}
+
+static void sx__coro_schedule(sx_coro_context* ctx, sx__coro_state* fs)
+{
+    switch (fs->ret_state) {
+    case CORO_RET_YIELD:
+        sx__coro_add_list(&ctx->yields[fs->wake.frame & (SX__CORO_YIELD_BUCKETS - 1)], fs);
+        break;
+    case CORO_RET_WAIT:
+        sx__coro_schedule_wait(ctx, fs);
+        break;
+    case CORO_RET_WAIT_COUNTER:
+        sx__coro_add_list(&ctx->counters, fs);
+        break;
+    default:
+        sx_assert(0 && "Invalid ret type for scheduling");
+        break;
+    }
+}
+
+// moves the timers of the level's current slot down to lower levels, when the level below wraps
+static void sx__coro_cascade(sx_coro_context* ctx, int level)
+{
+    int shift = SX__CORO_WHEEL_BITS0 + level * SX__CORO_WHEEL_BITS;
+    int slot = (int)((ctx->tick >> shift) & (SX__CORO_WHEEL_SLOTS - 1));
+    if (slot == 0 && level < SX__CORO_WHEEL_LEVELS - 2)
+        sx__coro_cascade(ctx, level + 1);
+
+    sx__coro_list list = { NULL, NULL };
+    sx__coro_move_list(&list, &ctx->wheel[level][slot]);
+    while (list.first) {
+        sx__coro_state* fs = list.first;
+        sx__coro_remove_list(fs);
+        sx__coro_schedule_wait(ctx, fs);
+    }
+}
+
+sx_coro_context* sx_coro_create_context_with_pool(const sx_alloc* alloc, int max_fibers,
+                                                  int stack_sz, sx_fiber_stack_pool* pool)
 {
     sx_assert(max_fibers > 0);
     sx_assert((size_t)stack_sz >= sx_os_minstacksz() && "stack size too small");
@@ -173,101 +585,293 @@ sx_coro_context* sx_coro_create_context(const sx_alloc* alloc, int max_fibers, i
 
     ctx->coro_pool = sx_pool_create(alloc, sizeof(sx__coro_state), max_fibers);
     if (!ctx->coro_pool) {
+        sx_coro_destroy_context(ctx, alloc);
         sx_out_of_memory();
         return NULL;
     }
     sx_memset(ctx->coro_pool->pages->buff, 0x0, sizeof(sx__coro_state) * max_fibers);
     ctx->stack_sz = stack_sz;
+    ctx->max_fibers = max_fibers;
+
+    ctx->due = (sx__coro_state**)sx_malloc(alloc, sizeof(sx__coro_state*) * max_fibers);
+    if (!ctx->due) {
+        sx_coro_destroy_context(ctx, alloc);
+        sx_out_of_memory();
+        return NULL;
+    }
+
+    ctx->cur_tls = sx_tls_create();
+    if (!ctx->cur_tls) {
+        sx_coro_destroy_context(ctx, alloc);
+        return NULL;
+    }
+
+    if (pool) {
+        ctx->stack_pool = pool;
+    } else {
+        ctx->stack_pool = sx_fiber_stack_pool_create(
+            alloc, &(sx_fiber_stack_pool_desc){ .large_stack_sz = stack_sz,
+                                                .max_large = max_fibers });
+        if (!ctx->stack_pool) {
+            sx_coro_destroy_context(ctx, alloc);
+            return NULL;
+        }
+        ctx->own_stack_pool = true;
+    }
 
     return ctx;
 }
 
+sx_coro_context* sx_coro_create_context(const sx_alloc* alloc, int max_fibers, int stack_sz)
+{
+    return sx_coro_create_context_with_pool(alloc, max_fibers, stack_sz, NULL);
+}
+
+static inline void sx__coro_remove_all(sx_coro_context* ctx, sx__coro_state* fs)
+{
+    if (fs->all_prev)
+        fs->all_prev->all_next = fs->all_next;
+    else
+        ctx->all = fs->all_next;
+    if (fs->all_next)
+        fs->all_next->all_prev = fs->all_prev;
+    fs->all_prev = fs->all_next = NULL;
+}
+
+static void sx__coro_del(sx_coro_context* ctx, sx__coro_state* fs)
+{
+    sx__coro_remove_list(fs);
+    sx__coro_remove_all(ctx, fs);
+    sx_fiber_stack_pool_put(ctx->stack_pool, &fs->stack_mem);
+    sx_pool_del(ctx->coro_pool, fs);
+}
+
+static inline sx__coro_state* sx__coro_current(sx_coro_context* ctx)
+{
+    return ctx->mt ? (sx__coro_state*)sx_tls_get(ctx->cur_tls) : ctx->cur_coro;
+}
+
+static inline void sx__coro_set_current(sx_coro_context* ctx, sx__coro_state* fs)
+{
+    if (ctx->mt)
+        sx_tls_set(ctx->cur_tls, fs);
+    else
+        ctx->cur_coro = fs;
+}
+
+// runs the coroutine until it returns, then schedules it by it's new state or deletes it
+static void sx__coro_switch(sx_coro_context* ctx, sx__coro_state* fs)
+{
+    // coroutines can be invoked from within other coroutines, so keep the caller
+    sx__coro_state* prev = sx__coro_current(ctx);
+    sx__coro_set_current(ctx, fs);
+    fs->fiber = sx_fiber_switch(fs->fiber, fs->user).from;
+    sx__coro_set_current(ctx, prev);
+
+    bool mt = ctx->mt;
+    if (fs->ret_state == CORO_RET_END) {
+        // coroutine has ended, we are not running on it's stack anymore so it can be reused
+        sx_fiber_stack_pool_put(ctx->stack_pool, &fs->stack_mem);
+        if (mt)
+            sx_lock(&ctx->lk, 1);
+        sx__coro_remove_all(ctx, fs);
+        sx_pool_del(ctx->coro_pool, fs);
+    } else {
+        if (mt)
+            sx_lock(&ctx->lk, 1);
+        sx__coro_schedule(ctx, fs);
+    }
+    if (mt)
+        sx_unlock(&ctx->lk);
+}
+
 void sx_coro_destroy_context(sx_coro_context* ctx, const sx_alloc* alloc)
 {
     sx_assert(ctx);
+
+    if (ctx->stack_pool) {
+        while (ctx->all) {
+            sx__coro_del(ctx, ctx->all);
+        }
+        if (ctx->own_stack_pool)
+            sx_fiber_stack_pool_destroy(ctx->stack_pool, alloc);
+    }
+
     if (ctx->coro_pool)
         sx_pool_destroy(ctx->coro_pool, alloc);
-
-    // TODO: release fiber's stack memory
+    if (ctx->cur_tls)
+        sx_tls_destroy(ctx->cur_tls);
+    sx_free(alloc, ctx->due);
 
     sx_free(alloc, ctx);
 }
 
-void sx__coro_invoke(sx_coro_context* ctx, sx_fiber_cb* callback, void* user)
+void sx__coro_invoke_with_flags(sx_coro_context* ctx, sx_fiber_cb* callback, void* user,
+                                sx_coro_flags flags)
 {
+    bool mt = ctx->mt;
+    if (mt)
+        sx_lock(&ctx->lk, 1);
     sx__coro_state* fs = (sx__coro_state*)sx_pool_new(ctx->coro_pool);
+    if (fs) {
+        fs->all_prev = NULL;
+        fs->all_next = ctx->all;
+        if (ctx->all)
+            ctx->all->all_prev = fs;
+        ctx->all = fs;
+    }
+    if (mt)
+        sx_unlock(&ctx->lk);
 
     if (fs) {
-        if (!fs->stack_mem.sptr) {
-            // Initialize stack memory
-            if (!sx_fiber_stack_init(&fs->stack_mem, ctx->stack_sz)) {
-                sx_out_of_memory();
-                return;
-            }
+        if (!sx_fiber_stack_pool_get(ctx->stack_pool, ctx->stack_sz, &fs->stack_mem)) {
+            if (mt)
+                sx_lock(&ctx->lk, 1);
+            sx__coro_remove_all(ctx, fs);
+            sx_pool_del(ctx->coro_pool, fs);
+            if (mt)
+                sx_unlock(&ctx->lk);
+            sx_out_of_memory();
+            return;
         }
         fs->fiber = sx_fiber_create(fs->stack_mem, callback);
         fs->callback = callback;
         fs->user = user;
-        // Add to the end of the list
-        sx__coro_add_list(&ctx->run_list, &ctx->run_list_last, fs);
-
-        ctx->cur_coro = fs;
-        fs->fiber = sx_fiber_switch(fs->fiber, user).from;
+        fs->flags = flags;
+        fs->ret_state = CORO_RET_NONE;
+        fs->list = NULL;
+        fs->next = fs->prev = NULL;
+
+        if (mt && (flags & SX_CORO_FLAG_MAIN_THREAD)) {
+            // we may not be on the updating thread, so start it with the next update
+            fs->ret_state = CORO_RET_YIELD;
+            fs->wake.frame = ctx->frame + 1;
+            sx_lock(&ctx->lk, 1);
+            sx__coro_schedule(ctx, fs);
+            sx_unlock(&ctx->lk);
+        } else {
+            sx__coro_switch(ctx, fs);
+        }
     }
 }
 
-void sx_coro_update(sx_coro_context* ctx, float dt)
+void sx__coro_invoke(sx_coro_context* ctx, sx_fiber_cb* callback, void* user)
 {
-    sx_assert(ctx->cur_coro == NULL);
+    sx__coro_invoke_with_flags(ctx, callback, user, 0);
+}
 
-    sx__coro_state* fs = ctx->run_list;
+// moves the coroutines of the list that are due to the `due` array, the rest stay in the list
+static void sx__coro_collect_list(sx_coro_context* ctx, sx__coro_list* list)
+{
+    sx__coro_state* fs = list->first;
     while (fs) {
         sx__coro_state* next = fs->next;
-
-        // Check state and take action for pending fibers
+        bool due;
         switch (fs->ret_state) {
-        case CORO_RET_YIELD: {
-            ++fs->counter.n;
-            if (fs->counter.n >= fs->arg.n) {
-                ctx->cur_coro = fs;
-                fs->fiber = sx_fiber_switch(fs->fiber, fs->user).from;
-            }
+        case CORO_RET_YIELD:
+            due = fs->wake.frame <= ctx->frame;
             break;
-        }
-        case CORO_RET_WAIT: {
-            fs->counter.tm += dt;
-            if (fs->counter.tm >= fs->arg.tm) {
-                ctx->cur_coro = fs;
-                fs->fiber = sx_fiber_switch(fs->fiber, fs->user).from;
-            }
+        case CORO_RET_WAIT:
+            due = fs->wake.tm <= ctx->time;
+            break;
+        case CORO_RET_WAIT_COUNTER:
+            due = *fs->wake.counter == 0;
             break;
-        }
         default:
+            due = false;
             sx_assert(0 && "Invalid ret type in update loop");
             break;
         }
 
+        if (due) {
+            sx__coro_remove_list(fs);
+            if (fs->flags & SX_CORO_FLAG_MAIN_THREAD)
+                ctx->due[ctx->max_fibers - (++ctx->num_due_main)] = fs;
+            else
+                ctx->due[ctx->num_due_any++] = fs;
+        }
         fs = next;
     }
 }
 
+int sx_coro_update_begin(sx_coro_context* ctx, float dt)
+{
+    sx_assert(!ctx->mt && ctx->cur_coro == NULL);
+
+    ++ctx->frame;
+    ctx->time += dt;
+    ctx->num_due_any = ctx->num_due_main = 0;
+
+    // everything that is due is collected before any coroutine runs, so a resumed coroutine that
+    // yields or waits again (even 0ms) is rescheduled for the next update at the earliest
+
+    sx__coro_collect_list(ctx, &ctx->yields[ctx->frame & (SX__CORO_YIELD_BUCKETS - 1)]);
+    sx__coro_collect_list(ctx, &ctx->counters);
+
+    // advance the timer wheel, due waits are checked in the pending list with the exact time
+    int64_t now_tick = (int64_t)(ctx->time * 1000.0);
+    while (ctx->tick < now_tick) {
+        ++ctx->tick;
+        int slot = (int)(ctx->tick & (SX__CORO_WHEEL_SLOTS0 - 1));
+        if (slot == 0)
+            sx__coro_cascade(ctx, 0);
+        sx__coro_move_list(&ctx->pending, &ctx->wheel0[slot]);
+    }
+    sx__coro_collect_list(ctx, &ctx->pending);
+
+    ctx->mt = true;
+    return ctx->num_due_any;
+}
+
+void sx_coro_resume(sx_coro_context* ctx, int index)
+{
+    sx_assert(ctx->mt && "must be called between sx_coro_update_begin and sx_coro_update_end");
+    sx_assert(index >= 0 && index < ctx->num_due_any);
+    sx__coro_switch(ctx, ctx->due[index]);
+}
+
+void sx_coro_update_end(sx_coro_context* ctx)
+{
+    sx_assert(ctx->mt);
+    ctx->mt = false;
+
+    for (int i = 0, c = ctx->num_due_main; i < c; i++) {
+        sx__coro_switch(ctx, ctx->due[ctx->max_fibers - 1 - i]);
+    }
+    ctx->num_due_any = ctx->num_due_main = 0;
+
+    // decommit the stacks that stayed unused after a spike of coroutines
+    if (ctx->own_stack_pool && ctx->time >= ctx->trim_time) {
+        sx_fiber_stack_pool_trim(ctx->stack_pool, SX__CORO_KEEP_STACKS);
+        ctx->trim_time = ctx->time + SX__CORO_TRIM_INTERVAL;
+    }
+}
+
+void sx_coro_update(sx_coro_context* ctx, float dt)
+{
+    for (int i = 0, c = sx_coro_update_begin(ctx, dt); i < c; i++) {
+        sx__coro_switch(ctx, ctx->due[i]);
+    }
+    sx_coro_update_end(ctx);
+}
+
 bool sx_coro_replace_callback(sx_coro_context* ctx, sx_fiber_cb* callback,
                               sx_fiber_cb* new_callback)
 {
     sx_assert(callback);
+    sx_assert(!ctx->mt && "cannot replace callbacks during update");
     bool r = false;
 
-    sx__coro_state* fs = ctx->run_list;
+    sx__coro_state* fs = ctx->all;
     while (fs) {
-        sx__coro_state* next = fs->next;
+        sx__coro_state* next = fs->all_next;
         if (fs->callback == callback) {
             if (new_callback) {
                 fs->callback = new_callback;
                 fs->fiber = sx_fiber_create(fs->stack_mem, new_callback);
                 r = true;
             } else {
-                sx__coro_remove_list(&ctx->run_list, &ctx->run_list_last, fs);
-                sx_pool_del(ctx->coro_pool, fs);
+                sx__coro_del(ctx, fs);
             }
         }
         fs = next;
@@ -279,26 +883,18 @@ bool sx_coro_replace_callback(sx_coro_context* ctx, sx_fiber_cb* callback,
 static inline void sx__coro_return(sx_coro_context* ctx, sx_fiber_t* pfrom, sx_coro_ret_type type,
                                    int arg)
 {
-    sx_assert(ctx->cur_coro &&
+    sx__coro_state* fs = sx__coro_current(ctx);
+    sx_assert(fs &&
               "You must call this function from within sx_fiber_cb invoked by sx_fiber_invoke");
     sx_assert(type != CORO_RET_NONE && "Invalid enum for type");
 
-    sx__coro_state* fs = ctx->cur_coro;
-
-    // If fiber is finished, just remove it from the list
-    if (type == CORO_RET_END) {
-        sx__coro_remove_list(&ctx->run_list, &ctx->run_list_last, fs);
-        sx_pool_del(ctx->coro_pool, fs);
-    } else {
-        fs->ret_state = type;
-        fs->counter.n = 0;
-        if (type == CORO_RET_WAIT)
-            fs->arg.tm = ((float)arg) * 0.001f;    // Convert msecs to seconds
-        else if (type == CORO_RET_YIELD)
-            fs->arg.n = arg;    // Number of next update passes
-    }
+    // the coroutine is scheduled (or deleted, if finished) by sx__coro_switch after switching back
+    fs->ret_state = type;
+    if (type == CORO_RET_WAIT)
+        fs->wake.tm = ctx->time + ((double)arg) * 0.001;    // Convert msecs to seconds
+    else if (type == CORO_RET_YIELD)
+        fs->wake.frame = ctx->frame + sx_max(arg, 1);    // Number of next update passes
 
-    ctx->cur_coro = NULL;
     *pfrom = sx_fiber_switch(*pfrom, NULL).from;
 }
 
@@ -316,3 +912,10 @@ void sx__coro_yield(sx_coro_context* ctx, sx_fiber_t* pfrom, int nupdates)
 {
     sx__coro_return(ctx, pfrom, CORO_RET_YIELD, nupdates);
 }
+
+void sx__coro_wait_counter(sx_coro_context* ctx, sx_fiber_t* pfrom, volatile int* counter)
+{
+    sx_assert(counter);
+    sx__coro_current(ctx)->wake.counter = counter;
+    sx__coro_return(ctx, pfrom, CORO_RET_WAIT_COUNTER, 0);
+}
@@ -4,6 +4,7 @@
 //
 #include "sx/handle.h"
 #include "sx/allocator.h"
+#include "sx/math.h"
 
 const uint32_t k__handle_index_mask = (1 << (32 - SX_CONFIG_HANDLE_GEN_BITS)) - 1;
 const uint32_t k__handle_gen_mask = ((1 << SX_CONFIG_HANDLE_GEN_BITS) - 1);
@@ -57,3 +58,190 @@ bool sx_handle_grow_pool(sx_handle_pool** ppool, const sx_alloc* alloc)
     *ppool = new_pool;
     return true;
 }
+
+// free-list head: 32bit ABA tag in the high bits, slot index in the low bits
+// the tag is incremented on every push/pop, so it takes 2^32 operations to wrap around
+#define SX__HANDLE_MT_EMPTY k__handle_index_mask
+
+static inline int64_t sx__handle_mt_head(uint32_t tag, int index)
+{
+    return (int64_t)(((uint64_t)tag << 32) | (uint32_t)index);
+}
+
+static inline uint32_t sx__handle_mt_head_tag(int64_t head)
+{
+    return (uint32_t)((uint64_t)head >> 32);
+}
+
+static inline int sx__handle_mt_head_index(int64_t head)
+{
+    return (int)(uint32_t)head;
+}
+
+sx_handle_pool_mt* sx_handle_create_pool_mt(const sx_alloc* alloc, int capacity)
+{
+    int block_size = sx_nearest_pow2(sx_max(capacity, 16));
+    int max_slots = (int)k__handle_index_mask;    // last index is reserved for the empty list
+    sx_assert(block_size <= max_slots && "capacity is too high");
+
+    int max_blocks = (max_slots + block_size - 1) / block_size;
+    uint8_t* buff = (uint8_t*)sx_malloc(alloc, sizeof(sx_handle_pool_mt) +
+                                                   sizeof(sx_handle_pool_mt_slot*) * max_blocks);
+    if (!buff) {
+        sx_out_of_memory();
+        return NULL;
+    }
+
+    sx_handle_pool_mt* pool = (sx_handle_pool_mt*)buff;
+    sx_memset(pool, 0x0, sizeof(sx_handle_pool_mt));
+    pool->blocks = (sx_handle_pool_mt_slot* volatile*)(buff + sizeof(sx_handle_pool_mt));
+    sx_memset((void*)pool->blocks, 0x0, sizeof(sx_handle_pool_mt_slot*) * max_blocks);
+    pool->free_head = sx__handle_mt_head(0, (int)SX__HANDLE_MT_EMPTY);
+    pool->block_mask = block_size - 1;
+    pool->max_blocks = max_blocks;
+    pool->alloc = alloc;
+    while ((1 << pool->block_shift) < block_size) {
+        ++pool->block_shift;
+    }
+
+    // first block is allocated up-front, so the initial `capacity` handles never allocate
+    pool->blocks[0] = (sx_handle_pool_mt_slot*)sx_malloc(
+        alloc, sizeof(sx_handle_pool_mt_slot) * block_size);
+    if (!pool->blocks[0]) {
+        sx_free(alloc, pool);
+        sx_out_of_memory();
+        return NULL;
+    }
+    sx_memset(pool->blocks[0], 0x0, sizeof(sx_handle_pool_mt_slot) * block_size);
+
+    return pool;
+}
+
+void sx_handle_destroy_pool_mt(sx_handle_pool_mt* pool)
+{
+    if (pool) {
+        const sx_alloc* alloc = pool->alloc;
+        for (int i = 0; i < pool->max_blocks; i++) {
+            if (pool->blocks[i]) {
+                sx_free(alloc, pool->blocks[i]);
+            }
+        }
+        sx_free(alloc, pool);
+    }
+}
+
+static sx_handle_pool_mt_slot* sx__handle_mt_add_block(sx_handle_pool_mt* pool, int block)
+{
+    sx_lock(&pool->grow_lk, 1);
+    sx_handle_pool_mt_slot* slots = pool->blocks[block];
+    if (!slots) {
+        int block_size = pool->block_mask + 1;
+        slots = (sx_handle_pool_mt_slot*)sx_malloc(pool->alloc,
+                                                   sizeof(sx_handle_pool_mt_slot) * block_size);
+        if (slots) {
+            sx_memset(slots, 0x0, sizeof(sx_handle_pool_mt_slot) * block_size);
+            // slots must be visible before the block pointer is published to readers
+            sx_memory_barrier();
+            pool->blocks[block] = slots;
+        } else {
+            sx_out_of_memory();
+        }
+    }
+    sx_unlock(&pool->grow_lk);
+    return slots;
+}
+
+static int sx__handle_mt_pop_free(sx_handle_pool_mt* pool)
+{
+    for (;;) {
+        // a torn read on 32bit targets is caught by the CAS, like any other stale value
+        int64_t head = pool->free_head;
+        int index = sx__handle_mt_head_index(head);
+        if (index == (int)SX__HANDLE_MT_EMPTY) {
+            return -1;
+        }
+
+        // slot memory is never freed while the pool is alive, so reading `next` of a slot that
+        // is popped by another thread in the meantime is harmless, the tag makes the CAS fail
+        int next = sx__handle_slot_mt(pool, index)->next;
+        int64_t new_head = sx__handle_mt_head(sx__handle_mt_head_tag(head) + 1, next);
+        if (sx_atomic_cas64(&pool->free_head, new_head, head) == head) {
+            return index;
+        }
+        sx_yield_cpu();
+    }
+}
+
+static void sx__handle_mt_push_free(sx_handle_pool_mt* pool, int index)
+{
+    sx_handle_pool_mt_slot* slot = sx__handle_slot_mt(pool, index);
+    for (;;) {
+        int64_t head = pool->free_head;
+        slot->next = sx__handle_mt_head_index(head);
+        int64_t new_head = sx__handle_mt_head(sx__handle_mt_head_tag(head) + 1, index);
+        if (sx_atomic_cas64(&pool->free_head, new_head, head) == head) {
+            return;
+        }
+        sx_yield_cpu();
+    }
+}
+
+// the block of the next slot is allocated before the slot is claimed, so a failed allocation
+// doesn't leave a claimed slot without memory behind
+static int sx__handle_mt_new_slot(sx_handle_pool_mt* pool)
+{
+    for (;;) {
+        int index = pool->num_slots;
+        if (index >= (int)SX__HANDLE_MT_EMPTY) {
+            return -1;
+        }
+
+        int block = index >> pool->block_shift;
+        if (!pool->blocks[block] && !sx__handle_mt_add_block(pool, block)) {
+            return -1;
+        }
+
+        if (sx_atomic_cas(&pool->num_slots, index + 1, index) == index) {
+            return index;
+        }
+    }
+}
+
+sx_handle_t sx_handle_new_mt(sx_handle_pool_mt* pool)
+{
+    int index = sx__handle_mt_pop_free(pool);
+    if (index == -1) {
+        index = sx__handle_mt_new_slot(pool);
+        if (index == -1) {
+            sx_assert(0 && "handle pool is full");
+            return SX_INVALID_HANDLE;
+        }
+    }
+
+    // the slot is exclusively owned by this thread until the handle is published
+    sx_handle_pool_mt_slot* slot = sx__handle_slot_mt(pool, index);
+    int gen = (slot->gen + 1) & (int)k__handle_gen_mask;
+    slot->gen = gen ? gen : 1;    // zero generation is never used, so handles are never zero
+    sx_handle_t handle = sx__handle_make(slot->gen, index);
+    sx_atomic_xchg((sx_atomic_int*)&slot->handle, (int)handle);
+    sx_atomic_incr(&pool->count);
+    return handle;
+}
+
+void sx_handle_del_mt(sx_handle_pool_mt* pool, sx_handle_t handle)
+{
+    sx_assert(handle);
+    int index = sx_handle_index(handle);
+    sx_handle_pool_mt_slot* slot = sx__handle_slot_mt(pool, index);
+    sx_assert(slot);
+
+    // only one thread can win the slot, double deletes and stale handles are ignored
+    if ((sx_handle_t)sx_atomic_cas((sx_atomic_int*)&slot->handle, SX_INVALID_HANDLE,
+                                   (int)handle) != handle) {
+        sx_assert(0 && "invalid handle");
+        return;
+    }
+
+    sx_atomic_decr(&pool->count);
+    sx__handle_mt_push_free(pool, index);
+}
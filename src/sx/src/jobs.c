@@ -22,6 +22,7 @@
 #define COUNTER_POOL_SIZE 256
 #define DEFAULT_MAX_FIBERS 64
 #define DEFAULT_FIBER_STACK_SIZE 1048576    // 1MB
+#define STACK_TRIM_WAITS 256    // owned stack pool is trimmed after every N finished waits
 
 typedef struct sx__job {
     int job_index;
@@ -69,6 +70,9 @@ typedef struct sx_job_context {
     int num_threads;
     int stack_sz;
     sx_pool* job_pool;        // sx__job: not-growable !
+    sx_fiber_stack_pool* stack_pool;
+    bool own_stack_pool;
+    sx_atomic_int num_waits;    // counts sx_job_wait_and_del calls, to trim the owned stack pool
     sx_pool* counter_pool;    // int: growable
     sx__job* waiting_list[SX_JOB_PRIORITY_COUNT];
     sx__job* waiting_list_last[SX_JOB_PRIORITY_COUNT];
@@ -88,6 +92,7 @@ typedef struct sx_job_context {
 static void sx__del_job(sx_job_context* ctx, sx__job* job)
 {
     sx_lock(&ctx->job_lk, 1);
+    sx_fiber_stack_pool_put(ctx->stack_pool, &job->stack_mem);
     sx_pool_del(ctx->job_pool, job);
     sx_unlock(&ctx->job_lk);
 }
@@ -123,12 +128,10 @@ static sx__job* sx__new_job(sx_job_context* ctx, int index, sx_job_cb* callback,
         j->owner_tid = 0;
         j->tags = tags;
         j->done = 0;
-        if (!j->stack_mem.sptr) {
-            // Initialize stack memory
-            if (!sx_fiber_stack_init(&j->stack_mem, ctx->stack_sz)) {
-                sx_out_of_memory();
-                return NULL;
-            }
+        if (!sx_fiber_stack_pool_get(ctx->stack_pool, ctx->stack_sz, &j->stack_mem)) {
+            sx_pool_del(ctx->job_pool, j);
+            sx_out_of_memory();
+            return NULL;
         }
         j->fiber = sx_fiber_create(j->stack_mem, fiber_fn);
         j->counter = counter;
@@ -233,7 +236,9 @@ static void sx__job_selector_main_thrd(sx_fiber_transfer transfer)
         }
     }
 
-    tdata->selector_fiber = sx_fiber_create(tdata->selector_stack, sx__job_selector_main_thrd);
+    // the next wait creates a new selector, creating it here would write the new context over the
+    // frame of this function, which is at the top of the same stack
+    tdata->selector_fiber = NULL;
     sx_fiber_switch(transfer.from, transfer.user);
 }
 
@@ -449,6 +454,10 @@ void sx_job_wait_and_del(sx_job_context* ctx, sx_job_t job)
                 sx_semaphore_post(&ctx->sem, 1);
         }
 
+        if (!tdata->selector_fiber) {
+            tdata->selector_fiber =
+                sx_fiber_create(tdata->selector_stack, sx__job_selector_main_thrd);
+        }
         sx_fiber_switch(tdata->selector_fiber, ctx);    // Switch to selector loop
 
         sx_yield_cpu();
@@ -463,6 +472,10 @@ void sx_job_wait_and_del(sx_job_context* ctx, sx_job_t job)
     sx_lock(&ctx->job_lk, 1);
     sx__job_process_pending(ctx);
     sx_unlock(&ctx->job_lk);
+
+    // decommit the stacks that stayed unused after a spike of jobs, one stays warm for each thread
+    if (ctx->own_stack_pool && (sx_atomic_incr(&ctx->num_waits) % STACK_TRIM_WAITS) == 0)
+        sx_fiber_stack_pool_trim(ctx->stack_pool, ctx->num_threads + 1);
 }
 
 bool sx_job_test_and_del(sx_job_context* ctx, sx_job_t job)
@@ -578,6 +591,18 @@ sx_job_context* sx_job_create_context(const sx_alloc* alloc, const sx_job_contex
         return NULL;
     sx_memset(ctx->job_pool->pages->buff, 0x0, sizeof(sx__job) * max_fibers);
 
+    // fiber stacks: use the shared pool, or create one for the jobs only
+    if (desc->stack_pool) {
+        ctx->stack_pool = desc->stack_pool;
+    } else {
+        ctx->stack_pool = sx_fiber_stack_pool_create(
+            alloc, &(sx_fiber_stack_pool_desc){ .large_stack_sz = ctx->stack_sz,
+                                                .max_large = max_fibers });
+        if (!ctx->stack_pool)
+            return NULL;
+        ctx->own_stack_pool = true;
+    }
+
     // keep tags in an array for evaluating num_jobs
     ctx->tags = sx_malloc(alloc, sizeof(uint32_t) * ((size_t)ctx->num_threads + 1));
     sx_memset(ctx->tags, 0xff, sizeof(uint32_t) * ((size_t)ctx->num_threads + 1));
@@ -615,7 +640,8 @@ void sx_job_destroy_context(sx_job_context* ctx, const sx_alloc* alloc)
 
     sx__job_destroy_tdata((sx__job_thread_data*)sx_tls_get(ctx->thread_tls), alloc);
 
-    // TODO: destroy job_pool's stack memories
+    if (ctx->own_stack_pool)
+        sx_fiber_stack_pool_destroy(ctx->stack_pool, alloc);
     sx_pool_destroy(ctx->job_pool, alloc);
     sx_pool_destroy(ctx->counter_pool, alloc);
     sx_semaphore_release(&ctx->sem);
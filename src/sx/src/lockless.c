@@ -1,6 +1,7 @@
 #include "sx/lockless.h"
 #include "sx/atomic.h"
 #include "sx/allocator.h"
+#include "sx/math.h"
 
 // single producer/single consumer - self contained queue
 // Reference:
@@ -51,6 +52,7 @@ static sx__queue_spsc_bin* sx__queue_spsc_create_bin(const sx_alloc* alloc, int
     bin->buff = buff;
 
     bin->iter = capacity;
+    bin->next = NULL;
 
     for (int i = 0; i < capacity; i++) {
         bin->ptrs[capacity - i - 1] =
@@ -121,10 +123,37 @@ void sx_queue_spsc_destroy(sx_queue_spsc* queue, const sx_alloc* alloc)
     sx_free(alloc, queue);
 }
 
+// returns the node to the buffer or grow bin that it was allocated from
+static void sx__queue_spsc_recycle(sx_queue_spsc* queue, sx__queue_spsc_node* node)
+{
+    size_t buff_sz = (sizeof(sx__queue_spsc_node) + queue->stride) * (size_t)queue->capacity;
+    uint8_t* ptr = (uint8_t*)node;
+    if (ptr >= queue->buff && ptr < queue->buff + buff_sz) {
+        sx_assert(queue->iter != queue->capacity);
+        queue->ptrs[queue->iter++] = node;
+        return;
+    }
+
+    for (sx__queue_spsc_bin* bin = queue->grow_bins; bin; bin = bin->next) {
+        if (ptr >= bin->buff && ptr < bin->buff + buff_sz) {
+            sx_assert(bin->iter != queue->capacity);
+            bin->ptrs[bin->iter++] = node;
+            return;
+        }
+    }
+    sx_assert(0 && "node does not belong to the queue");
+}
+
 bool sx_queue_spsc_produce(sx_queue_spsc* queue, const void* data)
 {
+    // trim/remove consumed nodes first, so a full queue can produce again after it is consumed
+    while (queue->first != queue->divider) {
+        sx__queue_spsc_node* first = (sx__queue_spsc_node*)queue->first;
+        queue->first = first->next;
+        sx__queue_spsc_recycle(queue, first);
+    }
+
     sx__queue_spsc_node* node = NULL;
-    sx__queue_spsc_bin* node_bin = NULL;
     if (queue->iter > 0) {
         node = queue->ptrs[--queue->iter];
     } else {
@@ -133,7 +162,6 @@ bool sx_queue_spsc_produce(sx_queue_spsc* queue, const void* data)
         while (bin && !node) {
             if (bin->iter > 0) {
                 node = bin->ptrs[--bin->iter];
-                node_bin = bin;
             }
             bin = bin->next;
         }
@@ -147,20 +175,6 @@ bool sx_queue_spsc_produce(sx_queue_spsc* queue, const void* data)
         last->next = node;
 
         sx_atomic_xchg_ptr(&queue->last, node);
-
-        // trim/remove un-used nodes
-        while (queue->first != queue->divider) {
-            sx__queue_spsc_node* first = (sx__queue_spsc_node*)queue->first;
-            queue->first = first->next;
-
-            if (!node_bin) {
-                sx_assert(queue->iter != queue->capacity);
-                queue->ptrs[queue->iter++] = first;
-            } else {
-                sx_assert(node_bin->iter != queue->capacity);
-                node_bin->ptrs[node_bin->iter++] = node;
-            }
-        }
         return true;
     } else {
         return false;
@@ -215,4 +229,328 @@ bool sx_queue_spsc_full(const sx_queue_spsc* queue)
     return false;
 }
 
+// multi-producer/multi-consumer - bounded queue
+// each cell has a sequence number that tells producers and consumers about the state of the cell
+// positions are 32bit counters that wrap around, so the differences are calculated unsigned
+typedef struct sx__queue_mpmc_cell {
+    sx_atomic_int sequence;
+    int _reserved;
+} sx__queue_mpmc_cell;
+
+typedef struct sx_queue_mpmc {
+    sx_align_decl(64, sx_atomic_int) enqueue_pos;
+    sx_align_decl(64, sx_atomic_int) dequeue_pos;
+    sx_align_decl(64, uint8_t*) cells;
+    int mask;
+    int stride;    // cell stride: sizeof(sx__queue_mpmc_cell) + aligned item_sz
+    int item_sz;
+} sx_queue_mpmc;
+
+static inline int sx__queue_mpmc_diff(int a, int b)
+{
+    return (int)((uint32_t)a - (uint32_t)b);
+}
+
+static inline sx__queue_mpmc_cell* sx__queue_mpmc_get_cell(const sx_queue_mpmc* queue, int pos)
+{
+    return (sx__queue_mpmc_cell*)(queue->cells + (pos & queue->mask) * queue->stride);
+}
+
+sx_queue_mpmc* sx_queue_mpmc_create(const sx_alloc* alloc, int item_sz, int capacity)
+{
+    sx_assert(item_sz > 0);
+    sx_assert(capacity > 1);
+
+    capacity = sx_ispow2(capacity) ? capacity : sx_nearest_pow2(capacity);
+    int stride = (int)sizeof(sx__queue_mpmc_cell) + sx_align_mask(item_sz, 7);
+
+    // aligned, so positions really sit on their own cache lines
+    uint8_t* buff =
+        (uint8_t*)sx_aligned_malloc(alloc, sizeof(sx_queue_mpmc) + stride * capacity, 64);
+    if (!buff) {
+        sx_out_of_memory();
+        return NULL;
+    }
+
+    sx_queue_mpmc* queue = (sx_queue_mpmc*)buff;
+    sx_memset(queue, 0x0, sizeof(sx_queue_mpmc));
+    queue->cells = buff + sizeof(sx_queue_mpmc);
+    queue->mask = capacity - 1;
+    queue->stride = stride;
+    queue->item_sz = item_sz;
+
+    for (int i = 0; i < capacity; i++) {
+        sx__queue_mpmc_get_cell(queue, i)->sequence = i;
+    }
+
+    return queue;
+}
+
+void sx_queue_mpmc_destroy(sx_queue_mpmc* queue, const sx_alloc* alloc)
+{
+    sx_assert(queue);
+    sx_aligned_free(alloc, queue, 64);
+}
+
+bool sx_queue_mpmc_produce(sx_queue_mpmc* queue, const void* data)
+{
+    sx__queue_mpmc_cell* cell;
+    int pos = queue->enqueue_pos;
+    for (;;) {
+        cell = sx__queue_mpmc_get_cell(queue, pos);
+        int seq = cell->sequence;    // CAS below is a full barrier, no need for read barrier
+        int dif = sx__queue_mpmc_diff(seq, pos);
+        if (dif == 0) {
+            int prev = sx_atomic_cas(&queue->enqueue_pos, pos + 1, pos);
+            if (prev == pos)
+                break;
+            pos = prev;
+        } else if (dif < 0) {
+            return false;    // full
+        } else {
+            pos = queue->enqueue_pos;
+        }
+    }
+
+    sx_memcpy(cell + 1, data, queue->item_sz);
+    sx_memory_write_barrier();
+    cell->sequence = pos + 1;
+    return true;
+}
+
+bool sx_queue_mpmc_consume(sx_queue_mpmc* queue, void* data)
+{
+    sx__queue_mpmc_cell* cell;
+    int pos = queue->dequeue_pos;
+    for (;;) {
+        cell = sx__queue_mpmc_get_cell(queue, pos);
+        int seq = cell->sequence;    // CAS below is a full barrier, no need for read barrier
+        int dif = sx__queue_mpmc_diff(seq, pos + 1);
+        if (dif == 0) {
+            int prev = sx_atomic_cas(&queue->dequeue_pos, pos + 1, pos);
+            if (prev == pos)
+                break;
+            pos = prev;
+        } else if (dif < 0) {
+            return false;    // empty
+        } else {
+            pos = queue->dequeue_pos;
+        }
+    }
+
+    sx_memcpy(data, cell + 1, queue->item_sz);
+    sx_memory_barrier();
+    cell->sequence = pos + queue->mask + 1;
+    return true;
+}
+
+// batch versions claim a whole range of cells with a single CAS on the position counter:
+// cells are counted from the current position while they are in the expected state, so after the
+// CAS succeeds, the claimed cells can not be touched by any other producer/consumer
+int sx_queue_mpmc_produce_batch(sx_queue_mpmc* queue, const void* data, int count)
+{
+    const uint8_t* items = (const uint8_t*)data;
+    int pos = queue->enqueue_pos;
+    int n;
+    for (;;) {
+        n = 0;
+        while (n < count) {
+            int seq = sx__queue_mpmc_get_cell(queue, pos + n)->sequence;
+            if (sx__queue_mpmc_diff(seq, pos + n) != 0)
+                break;
+            n++;
+        }
+
+        if (n == 0) {
+            int seq = sx__queue_mpmc_get_cell(queue, pos)->sequence;
+            if (sx__queue_mpmc_diff(seq, pos) < 0)
+                return 0;    // full
+            pos = queue->enqueue_pos;
+            continue;
+        }
+
+        int prev = sx_atomic_cas(&queue->enqueue_pos, pos + n, pos);
+        if (prev == pos)
+            break;
+        pos = prev;
+    }
+
+    for (int i = 0; i < n; i++) {
+        sx__queue_mpmc_cell* cell = sx__queue_mpmc_get_cell(queue, pos + i);
+        sx_memcpy(cell + 1, items + i * queue->item_sz, queue->item_sz);
+    }
+    sx_memory_write_barrier();
+    for (int i = 0; i < n; i++) {
+        sx__queue_mpmc_get_cell(queue, pos + i)->sequence = pos + i + 1;
+    }
+    return n;
+}
+
+int sx_queue_mpmc_consume_batch(sx_queue_mpmc* queue, void* data, int max_count)
+{
+    uint8_t* items = (uint8_t*)data;
+    int pos = queue->dequeue_pos;
+    int n;
+    for (;;) {
+        n = 0;
+        while (n < max_count) {
+            int seq = sx__queue_mpmc_get_cell(queue, pos + n)->sequence;
+            if (sx__queue_mpmc_diff(seq, pos + n + 1) != 0)
+                break;
+            n++;
+        }
+
+        if (n == 0) {
+            int seq = sx__queue_mpmc_get_cell(queue, pos)->sequence;
+            if (sx__queue_mpmc_diff(seq, pos + 1) < 0)
+                return 0;    // empty
+            pos = queue->dequeue_pos;
+            continue;
+        }
+
+        int prev = sx_atomic_cas(&queue->dequeue_pos, pos + n, pos);
+        if (prev == pos)
+            break;
+        pos = prev;
+    }
+
+    for (int i = 0; i < n; i++) {
+        sx__queue_mpmc_cell* cell = sx__queue_mpmc_get_cell(queue, pos + i);
+        sx_memcpy(items + i * queue->item_sz, cell + 1, queue->item_sz);
+    }
+    sx_memory_barrier();
+    for (int i = 0; i < n; i++) {
+        sx__queue_mpmc_get_cell(queue, pos + i)->sequence = pos + i + queue->mask + 1;
+    }
+    return n;
+}
+
+bool sx_queue_mpmc_full(const sx_queue_mpmc* queue)
+{
+    int pos = queue->enqueue_pos;
+    return sx__queue_mpmc_diff(sx__queue_mpmc_get_cell(queue, pos)->sequence, pos) < 0;
+}
+
+// multi-producer/single-consumer - intrusive unbounded queue
+// producers only do a single atomic exchange on head, the consumer owns tail
+// the queue keeps a stub node, so it's never empty internally
+typedef struct sx_queue_mpsc {
+    sx_align_decl(64, sx_atomic_ptr) head;    // sx_queue_mpsc_node*: last produced node
+    sx_align_decl(64, sx_queue_mpsc_node*) tail;
+    sx_queue_mpsc_node stub;
+} sx_queue_mpsc;
+
+sx_queue_mpsc* sx_queue_mpsc_create(const sx_alloc* alloc)
+{
+    sx_queue_mpsc* queue = (sx_queue_mpsc*)sx_aligned_malloc(alloc, sizeof(sx_queue_mpsc), 64);
+    if (!queue) {
+        sx_out_of_memory();
+        return NULL;
+    }
+
+    queue->stub.next = NULL;
+    queue->head = &queue->stub;
+    queue->tail = &queue->stub;
+    return queue;
+}
+
+void sx_queue_mpsc_destroy(sx_queue_mpsc* queue, const sx_alloc* alloc)
+{
+    sx_assert(queue);
+    sx_aligned_free(alloc, queue, 64);
+}
+
+static inline void sx__queue_mpsc_push(sx_queue_mpsc* queue, sx_queue_mpsc_node* first,
+                                       sx_queue_mpsc_node* last)
+{
+    last->next = NULL;
+    sx_memory_write_barrier();
+    sx_queue_mpsc_node* prev = (sx_queue_mpsc_node*)sx_atomic_xchg_ptr(&queue->head, last);
+    prev->next = first;
+}
+
+void sx_queue_mpsc_produce(sx_queue_mpsc* queue, sx_queue_mpsc_node* node)
+{
+    sx_assert(node);
+    sx__queue_mpsc_push(queue, node, node);
+}
+
+void sx_queue_mpsc_produce_batch(sx_queue_mpsc* queue, sx_queue_mpsc_node** nodes, int count)
+{
+    if (count <= 0)
+        return;
+
+    for (int i = 0; i < count - 1; i++) {
+        nodes[i]->next = nodes[i + 1];
+    }
+    sx__queue_mpsc_push(queue, nodes[0], nodes[count - 1]);
+}
+
+// returns NULL if the queue is empty, or a producer is in the middle of pushing the next node
+sx_queue_mpsc_node* sx_queue_mpsc_consume(sx_queue_mpsc* queue)
+{
+    sx_queue_mpsc_node* tail = queue->tail;
+    sx_queue_mpsc_node* next = tail->next;
+    if (tail == &queue->stub) {
+        if (!next)
+            return NULL;
+        queue->tail = next;
+        tail = next;
+        next = next->next;
+    }
+
+    if (next) {
+        sx_memory_read_barrier();
+        queue->tail = next;
+        return tail;
+    }
+
+    if (tail != (sx_queue_mpsc_node*)queue->head)
+        return NULL;
+
+    // tail is the last node, put the stub back behind it, so we can take it out
+    sx__queue_mpsc_push(queue, &queue->stub, &queue->stub);
+    next = tail->next;
+    if (next) {
+        sx_memory_read_barrier();
+        queue->tail = next;
+        return tail;
+    }
+
+    return NULL;
+}
+
+// walks the linked nodes directly and updates tail once, only the last node (which may need the
+// stub to be pushed back behind it) goes through the single consume path
+int sx_queue_mpsc_consume_batch(sx_queue_mpsc* queue, sx_queue_mpsc_node** nodes, int max_count)
+{
+    if (max_count <= 0)
+        return 0;
+
+    sx_queue_mpsc_node* tail = queue->tail;
+    sx_queue_mpsc_node* next = tail->next;
+    if (tail == &queue->stub) {
+        if (!next)
+            return 0;
+        tail = next;
+        next = next->next;
+    }
 
+    int i = 0;
+    if (next) {
+        sx_memory_read_barrier();
+        while (next && i < max_count) {
+            nodes[i++] = tail;
+            tail = next;
+            next = tail->next;
+        }
+    }
+    queue->tail = tail;
+
+    for (; i < max_count; i++) {
+        nodes[i] = sx_queue_mpsc_consume(queue);
+        if (!nodes[i])
+            break;
+    }
+    return i;
+}
@@ -0,0 +1,788 @@
+//
+// Copyright 2018 Sepehr Taghdisian (septag@github). All rights reserved.
+// License: https://github.com/septag/sx#license-bsd-2-clause
+//
+// math-simd.c - batch (array) math kernels
+//      Every kernel has a scalar fallback, plus SSE2/AVX2 (x86) or NEON (arm) paths
+//      x86 paths are selected at runtime on first call (AVX2 requires FMA and OS support)
+//      all kernels accept dst == src (in-place), but other partial overlaps are not supported
+//
+#include "sx/math.h"
+#include "sx/atomic.h"
+
+#define SX__MATH_SSE2 0
+#define SX__MATH_AVX2 0
+#define SX__MATH_NEON 0
+
+#if !SX_CONFIG_SIMD_DISABLE
+#    if SX_CPU_X86 && \
+        (defined(__SSE2__) || (SX_COMPILER_MSVC && (SX_ARCH_64BIT || _M_IX86_FP >= 2)))
+#        include <emmintrin.h>
+#        undef SX__MATH_SSE2
+#        define SX__MATH_SSE2 1
+#        if SX_COMPILER_MSVC || SX_COMPILER_GCC >= 40900 || SX_COMPILER_CLANG
+#            include <immintrin.h>
+#            undef SX__MATH_AVX2
+#            define SX__MATH_AVX2 1
+#        endif
+#        if SX_COMPILER_MSVC
+#            include <intrin.h>
+#        endif
+#    elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#        include <arm_neon.h>
+#        undef SX__MATH_NEON
+#        define SX__MATH_NEON 1
+#    endif
+#endif
+
+#if SX__MATH_AVX2 && !SX_COMPILER_MSVC
+#    define SX__AVX2_FUNC __attribute__((target("avx2,fma")))
+#else
+#    define SX__AVX2_FUNC
+#endif
+
+typedef struct sx__math_batch_api {
+    void (*mat4_mul)(sx_mat4* dst, const sx_mat4* a, const sx_mat4* b, int count);
+    void (*mat4_mul_vec3)(sx_vec3* dst, const sx_mat4* mat, const sx_vec3* src, int count);
+    void (*mat3_mul_vec2)(sx_vec2* dst, const sx_mat3* mat, const sx_vec2* src, int count);
+    void (*aabb_transform)(sx_aabb* dst, const sx_mat4* mat, const sx_aabb* src, int count);
+    void (*quat_mat4)(sx_mat4* dst, const sx_quat* src, int count);
+    const char* name;
+} sx__math_batch_api;
+
+static sx__math_batch_api g_math_batch;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// scalar
+static void sx__mat4_mul_ref(sx_mat4* dst, const sx_mat4* a, const sx_mat4* b, int count)
+{
+    for (int i = 0; i < count; i++) {
+        dst[i] = sx_mat4_mul(&a[i], &b[i]);
+    }
+}
+
+static void sx__mat4_mul_vec3_ref(sx_vec3* dst, const sx_mat4* mat, const sx_vec3* src, int count)
+{
+    for (int i = 0; i < count; i++) {
+        dst[i] = sx_mat4_mul_vec3(mat, src[i]);
+    }
+}
+
+static void sx__mat3_mul_vec2_ref(sx_vec2* dst, const sx_mat3* mat, const sx_vec2* src, int count)
+{
+    for (int i = 0; i < count; i++) {
+        dst[i] = sx_mat3_mul_vec2(mat, src[i]);
+    }
+}
+
+// Arvo's method: transform the center and accumulate the absolute rotation/scale into extents
+static inline sx_aabb sx__aabb_transform(const sx_mat4* mat, const sx_aabb* box)
+{
+    sx_vec3 center = sx_vec3_mulf(sx_vec3_add(box->vmin, box->vmax), 0.5f);
+    sx_vec3 extent = sx_vec3_mulf(sx_vec3_sub(box->vmax, box->vmin), 0.5f);
+    sx_vec3 c = sx_mat4_mul_vec3(mat, center);
+    sx_vec3 e = sx_vec3f(
+        sx_abs(mat->m11) * extent.x + sx_abs(mat->m12) * extent.y + sx_abs(mat->m13) * extent.z,
+        sx_abs(mat->m21) * extent.x + sx_abs(mat->m22) * extent.y + sx_abs(mat->m23) * extent.z,
+        sx_abs(mat->m31) * extent.x + sx_abs(mat->m32) * extent.y + sx_abs(mat->m33) * extent.z);
+    return sx_aabbv(sx_vec3_sub(c, e), sx_vec3_add(c, e));
+}
+
+static void sx__aabb_transform_ref(sx_aabb* dst, const sx_mat4* mat, const sx_aabb* src, int count)
+{
+    for (int i = 0; i < count; i++) {
+        dst[i] = sx__aabb_transform(mat, &src[i]);
+    }
+}
+
+static void sx__quat_mat4_ref(sx_mat4* dst, const sx_quat* src, int count)
+{
+    for (int i = 0; i < count; i++) {
+        dst[i] = sx_quat_mat4(src[i]);
+    }
+}
+
+#if SX__MATH_SSE2
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// SSE2
+#    define sx__sse_splat(_v, _i) _mm_shuffle_ps((_v), (_v), _MM_SHUFFLE(_i, _i, _i, _i))
+
+// 4x4 transpose that only uses in-lane shuffles, so it also works on both lanes of __m256
+#    define sx__transpose4(_type, _unpacklo, _unpackhi, _shuffle, _r0, _r1, _r2, _r3) \
+        do {                                                                          \
+            _type t0_ = _unpacklo(_r0, _r1);                                          \
+            _type t1_ = _unpacklo(_r2, _r3);                                          \
+            _type t2_ = _unpackhi(_r0, _r1);                                          \
+            _type t3_ = _unpackhi(_r2, _r3);                                          \
+            _r0 = _shuffle(t0_, t1_, _MM_SHUFFLE(1, 0, 1, 0));                        \
+            _r1 = _shuffle(t0_, t1_, _MM_SHUFFLE(3, 2, 3, 2));                        \
+            _r2 = _shuffle(t2_, t3_, _MM_SHUFFLE(1, 0, 1, 0));                        \
+            _r3 = _shuffle(t2_, t3_, _MM_SHUFFLE(3, 2, 3, 2));                        \
+        } while (0)
+
+// a = x0 y0 z0 x1, b = y1 z1 x2 y2, c = z2 x3 y3 z3  <->  x = x0..x3, y = y0..y3, z = z0..z3
+#    define sx__deinterleave3(_type, _shuffle, _a, _b, _c, _x, _y, _z)                         \
+        do {                                                                                   \
+            _type bc_ = _shuffle(_b, _c, _MM_SHUFFLE(1, 1, 3, 2));                             \
+            _x = _shuffle(_a, bc_, _MM_SHUFFLE(2, 0, 3, 0));                                   \
+            _y = _shuffle(_shuffle(_a, _b, _MM_SHUFFLE(0, 0, 1, 1)),                           \
+                          _shuffle(_b, _c, _MM_SHUFFLE(2, 2, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0)); \
+            _z = _shuffle(_shuffle(_a, _b, _MM_SHUFFLE(1, 1, 2, 2)),                           \
+                          _shuffle(_c, _c, _MM_SHUFFLE(3, 3, 0, 0)), _MM_SHUFFLE(2, 0, 2, 0)); \
+        } while (0)
+
+#    define sx__interleave3(_type, _shuffle, _x, _y, _z, _a, _b, _c)                          \
+        do {                                                                                  \
+            _a = _shuffle(_shuffle(_x, _y, _MM_SHUFFLE(0, 0, 0, 0)),                          \
+                          _shuffle(_z, _x, _MM_SHUFFLE(1, 1, 0, 0)), _MM_SHUFFLE(2, 0, 2, 0)); \
+            _b = _shuffle(_shuffle(_y, _z, _MM_SHUFFLE(1, 1, 1, 1)),                          \
+                          _shuffle(_x, _y, _MM_SHUFFLE(2, 2, 2, 2)), _MM_SHUFFLE(2, 0, 2, 0)); \
+            _c = _shuffle(_shuffle(_z, _x, _MM_SHUFFLE(3, 3, 2, 2)),                          \
+                          _shuffle(_y, _z, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0)); \
+        } while (0)
+
+static void sx__mat4_mul_sse2(sx_mat4* dst, const sx_mat4* a, const sx_mat4* b, int count)
+{
+    for (int i = 0; i < count; i++) {
+        const float* fa = a[i].f;
+        const float* fb = b[i].f;
+        __m128 a0 = _mm_loadu_ps(fa);
+        __m128 a1 = _mm_loadu_ps(fa + 4);
+        __m128 a2 = _mm_loadu_ps(fa + 8);
+        __m128 a3 = _mm_loadu_ps(fa + 12);
+        __m128 b_cols[4] = { _mm_loadu_ps(fb), _mm_loadu_ps(fb + 4), _mm_loadu_ps(fb + 8),
+                             _mm_loadu_ps(fb + 12) };
+        for (int c = 0; c < 4; c++) {
+            __m128 bc = b_cols[c];
+            __m128 r = _mm_mul_ps(a0, sx__sse_splat(bc, 0));
+            r = _mm_add_ps(r, _mm_mul_ps(a1, sx__sse_splat(bc, 1)));
+            r = _mm_add_ps(r, _mm_mul_ps(a2, sx__sse_splat(bc, 2)));
+            r = _mm_add_ps(r, _mm_mul_ps(a3, sx__sse_splat(bc, 3)));
+            _mm_storeu_ps(dst[i].f + c * 4, r);
+        }
+    }
+}
+
+static void sx__mat4_mul_vec3_sse2(sx_vec3* dst, const sx_mat4* mat, const sx_vec3* src, int count)
+{
+    __m128 m11 = _mm_set1_ps(mat->m11), m12 = _mm_set1_ps(mat->m12), m13 = _mm_set1_ps(mat->m13);
+    __m128 m21 = _mm_set1_ps(mat->m21), m22 = _mm_set1_ps(mat->m22), m23 = _mm_set1_ps(mat->m23);
+    __m128 m31 = _mm_set1_ps(mat->m31), m32 = _mm_set1_ps(mat->m32), m33 = _mm_set1_ps(mat->m33);
+    __m128 m14 = _mm_set1_ps(mat->m14), m24 = _mm_set1_ps(mat->m24), m34 = _mm_set1_ps(mat->m34);
+
+    int i = 0;
+    for (int ic = count & ~3; i < ic; i += 4) {
+        const float* fs = src[i].f;
+        __m128 a = _mm_loadu_ps(fs), b = _mm_loadu_ps(fs + 4), c = _mm_loadu_ps(fs + 8);
+        __m128 x, y, z;
+        sx__deinterleave3(__m128, _mm_shuffle_ps, a, b, c, x, y, z);
+
+        __m128 rx = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, m11), _mm_mul_ps(y, m12)),
+                               _mm_add_ps(_mm_mul_ps(z, m13), m14));
+        __m128 ry = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, m21), _mm_mul_ps(y, m22)),
+                               _mm_add_ps(_mm_mul_ps(z, m23), m24));
+        __m128 rz = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, m31), _mm_mul_ps(y, m32)),
+                               _mm_add_ps(_mm_mul_ps(z, m33), m34));
+
+        sx__interleave3(__m128, _mm_shuffle_ps, rx, ry, rz, a, b, c);
+        float* fd = dst[i].f;
+        _mm_storeu_ps(fd, a);
+        _mm_storeu_ps(fd + 4, b);
+        _mm_storeu_ps(fd + 8, c);
+    }
+
+    sx__mat4_mul_vec3_ref(dst + i, mat, src + i, count - i);
+}
+
+static void sx__mat3_mul_vec2_sse2(sx_vec2* dst, const sx_mat3* mat, const sx_vec2* src, int count)
+{
+    __m128 m11 = _mm_set1_ps(mat->m11), m12 = _mm_set1_ps(mat->m12), m13 = _mm_set1_ps(mat->m13);
+    __m128 m21 = _mm_set1_ps(mat->m21), m22 = _mm_set1_ps(mat->m22), m23 = _mm_set1_ps(mat->m23);
+
+    int i = 0;
+    for (int ic = count & ~3; i < ic; i += 4) {
+        const float* fs = src[i].f;
+        __m128 a = _mm_loadu_ps(fs), b = _mm_loadu_ps(fs + 4);
+        __m128 x = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+        __m128 y = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+
+        __m128 rx = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, m11), _mm_mul_ps(y, m12)), m13);
+        __m128 ry = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, m21), _mm_mul_ps(y, m22)), m23);
+
+        float* fd = dst[i].f;
+        _mm_storeu_ps(fd, _mm_unpacklo_ps(rx, ry));
+        _mm_storeu_ps(fd + 4, _mm_unpackhi_ps(rx, ry));
+    }
+
+    sx__mat3_mul_vec2_ref(dst + i, mat, src + i, count - i);
+}
+
+static void sx__aabb_transform_sse2(sx_aabb* dst, const sx_mat4* mat, const sx_aabb* src, int count)
+{
+    const __m128 abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+    const __m128 half = _mm_set1_ps(0.5f);
+    __m128 c1 = _mm_loadu_ps(mat->f), c2 = _mm_loadu_ps(mat->f + 4);
+    __m128 c3 = _mm_loadu_ps(mat->f + 8), c4 = _mm_loadu_ps(mat->f + 12);
+    __m128 ac1 = _mm_and_ps(c1, abs_mask), ac2 = _mm_and_ps(c2, abs_mask);
+    __m128 ac3 = _mm_and_ps(c3, abs_mask);
+
+    for (int i = 0; i < count; i++) {
+        const float* fs = src[i].f;
+        __m128 vmin = _mm_loadu_ps(fs);    // xmin ymin zmin xmax
+        __m128 vmax = _mm_loadu_ps(fs + 2);
+        vmax = _mm_shuffle_ps(vmax, vmax, _MM_SHUFFLE(3, 3, 2, 1));
+        __m128 center = _mm_mul_ps(_mm_add_ps(vmin, vmax), half);
+        __m128 extent = _mm_mul_ps(_mm_sub_ps(vmax, vmin), half);
+
+        __m128 c = _mm_add_ps(_mm_add_ps(_mm_mul_ps(c1, sx__sse_splat(center, 0)),
+                                         _mm_mul_ps(c2, sx__sse_splat(center, 1))),
+                              _mm_add_ps(_mm_mul_ps(c3, sx__sse_splat(center, 2)), c4));
+        __m128 e = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ac1, sx__sse_splat(extent, 0)),
+                                         _mm_mul_ps(ac2, sx__sse_splat(extent, 1))),
+                              _mm_mul_ps(ac3, sx__sse_splat(extent, 2)));
+        __m128 rmin = _mm_sub_ps(c, e);
+        __m128 rmax = _mm_add_ps(c, e);
+
+        // store as: [xmin ymin zmin xmax] [ymax zmax]
+        __m128 t = _mm_shuffle_ps(rmin, rmax, _MM_SHUFFLE(0, 0, 2, 2));
+        float* fd = dst[i].f;
+        _mm_storeu_ps(fd, _mm_shuffle_ps(rmin, t, _MM_SHUFFLE(2, 0, 1, 0)));
+        _mm_storel_pi((__m64*)(fd + 4), _mm_shuffle_ps(rmax, rmax, _MM_SHUFFLE(3, 3, 2, 1)));
+    }
+}
+
+static void sx__quat_mat4_sse2(sx_mat4* dst, const sx_quat* src, int count)
+{
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 two = _mm_set1_ps(2.0f);
+
+    int i = 0;
+    for (int ic = count & ~3; i < ic; i += 4) {
+        __m128 x = _mm_loadu_ps(src[i].f), y = _mm_loadu_ps(src[i + 1].f);
+        __m128 z = _mm_loadu_ps(src[i + 2].f), w = _mm_loadu_ps(src[i + 3].f);
+        sx__transpose4(__m128, _mm_unpacklo_ps, _mm_unpackhi_ps, _mm_shuffle_ps, x, y, z, w);
+
+        __m128 norm = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)),
+                                             _mm_add_ps(_mm_mul_ps(z, z), _mm_mul_ps(w, w))));
+        __m128 s = _mm_and_ps(_mm_cmpgt_ps(norm, zero), _mm_div_ps(two, norm));
+
+        __m128 sx_ = _mm_mul_ps(s, x), sy = _mm_mul_ps(s, y), sz = _mm_mul_ps(s, z);
+        __m128 xx = _mm_mul_ps(sx_, x), xy = _mm_mul_ps(sx_, y), xz = _mm_mul_ps(sx_, z);
+        __m128 yy = _mm_mul_ps(sy, y), yz = _mm_mul_ps(sy, z), zz = _mm_mul_ps(sz, z);
+        __m128 wx = _mm_mul_ps(sx_, w), wy = _mm_mul_ps(sy, w), wz = _mm_mul_ps(sz, w);
+
+        __m128 r0 = _mm_sub_ps(_mm_sub_ps(one, yy), zz), r1 = _mm_add_ps(xy, wz);
+        __m128 r2 = _mm_sub_ps(xz, wy), r3 = zero;
+        sx__transpose4(__m128, _mm_unpacklo_ps, _mm_unpackhi_ps, _mm_shuffle_ps, r0, r1, r2, r3);
+        _mm_storeu_ps(dst[i].f, r0);
+        _mm_storeu_ps(dst[i + 1].f, r1);
+        _mm_storeu_ps(dst[i + 2].f, r2);
+        _mm_storeu_ps(dst[i + 3].f, r3);
+
+        r0 = _mm_sub_ps(xy, wz), r1 = _mm_sub_ps(_mm_sub_ps(one, xx), zz);
+        r2 = _mm_add_ps(yz, wx), r3 = zero;
+        sx__transpose4(__m128, _mm_unpacklo_ps, _mm_unpackhi_ps, _mm_shuffle_ps, r0, r1, r2, r3);
+        _mm_storeu_ps(dst[i].f + 4, r0);
+        _mm_storeu_ps(dst[i + 1].f + 4, r1);
+        _mm_storeu_ps(dst[i + 2].f + 4, r2);
+        _mm_storeu_ps(dst[i + 3].f + 4, r3);
+
+        r0 = _mm_add_ps(xz, wy), r1 = _mm_sub_ps(yz, wx);
+        r2 = _mm_sub_ps(_mm_sub_ps(one, xx), yy), r3 = zero;
+        sx__transpose4(__m128, _mm_unpacklo_ps, _mm_unpackhi_ps, _mm_shuffle_ps, r0, r1, r2, r3);
+        _mm_storeu_ps(dst[i].f + 8, r0);
+        _mm_storeu_ps(dst[i + 1].f + 8, r1);
+        _mm_storeu_ps(dst[i + 2].f + 8, r2);
+        _mm_storeu_ps(dst[i + 3].f + 8, r3);
+
+        __m128 col4 = _mm_set_ps(1.0f, 0.0f, 0.0f, 0.0f);
+        _mm_storeu_ps(dst[i].f + 12, col4);
+        _mm_storeu_ps(dst[i + 1].f + 12, col4);
+        _mm_storeu_ps(dst[i + 2].f + 12, col4);
+        _mm_storeu_ps(dst[i + 3].f + 12, col4);
+    }
+
+    sx__quat_mat4_ref(dst + i, src + i, count - i);
+}
+#endif    // SX__MATH_SSE2
+
+#if SX__MATH_AVX2
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// AVX2 + FMA
+// points and quaternions are processed 8 at a time: the first 4 items go to the low lane, and the
+// next 4 go to the high lane, so in-lane shuffles of the SSE2 path can be reused as is
+#    define sx__avx_load2(_lo, _hi) \
+        _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(_lo)), _mm_loadu_ps(_hi), 1)
+#    define sx__avx_store2(_lo, _hi, _v)                      \
+        do {                                                  \
+            _mm_storeu_ps(_lo, _mm256_castps256_ps128(_v));   \
+            _mm_storeu_ps(_hi, _mm256_extractf128_ps(_v, 1)); \
+        } while (0)
+
+SX__AVX2_FUNC static void sx__mat4_mul_avx2(sx_mat4* dst, const sx_mat4* a, const sx_mat4* b,
+                                            int count)
+{
+    for (int i = 0; i < count; i++) {
+        const float* fa = a[i].f;
+        const float* fb = b[i].f;
+        __m256 a0 = _mm256_broadcast_ps((const __m128*)fa);
+        __m256 a1 = _mm256_broadcast_ps((const __m128*)(fa + 4));
+        __m256 a2 = _mm256_broadcast_ps((const __m128*)(fa + 8));
+        __m256 a3 = _mm256_broadcast_ps((const __m128*)(fa + 12));
+        __m256 b01 = _mm256_loadu_ps(fb);
+        __m256 b23 = _mm256_loadu_ps(fb + 8);
+
+        __m256 r01 = _mm256_mul_ps(a0, _mm256_permute_ps(b01, 0x00));
+        r01 = _mm256_fmadd_ps(a1, _mm256_permute_ps(b01, 0x55), r01);
+        r01 = _mm256_fmadd_ps(a2, _mm256_permute_ps(b01, 0xaa), r01);
+        r01 = _mm256_fmadd_ps(a3, _mm256_permute_ps(b01, 0xff), r01);
+
+        __m256 r23 = _mm256_mul_ps(a0, _mm256_permute_ps(b23, 0x00));
+        r23 = _mm256_fmadd_ps(a1, _mm256_permute_ps(b23, 0x55), r23);
+        r23 = _mm256_fmadd_ps(a2, _mm256_permute_ps(b23, 0xaa), r23);
+        r23 = _mm256_fmadd_ps(a3, _mm256_permute_ps(b23, 0xff), r23);
+
+        _mm256_storeu_ps(dst[i].f, r01);
+        _mm256_storeu_ps(dst[i].f + 8, r23);
+    }
+}
+
+SX__AVX2_FUNC static void sx__mat4_mul_vec3_avx2(sx_vec3* dst, const sx_mat4* mat,
+                                                 const sx_vec3* src, int count)
+{
+    __m256 m11 = _mm256_set1_ps(mat->m11), m12 = _mm256_set1_ps(mat->m12);
+    __m256 m13 = _mm256_set1_ps(mat->m13), m14 = _mm256_set1_ps(mat->m14);
+    __m256 m21 = _mm256_set1_ps(mat->m21), m22 = _mm256_set1_ps(mat->m22);
+    __m256 m23 = _mm256_set1_ps(mat->m23), m24 = _mm256_set1_ps(mat->m24);
+    __m256 m31 = _mm256_set1_ps(mat->m31), m32 = _mm256_set1_ps(mat->m32);
+    __m256 m33 = _mm256_set1_ps(mat->m33), m34 = _mm256_set1_ps(mat->m34);
+
+    int i = 0;
+    for (int ic = count & ~7; i < ic; i += 8) {
+        const float* fs = src[i].f;
+        __m256 a = sx__avx_load2(fs, fs + 12);
+        __m256 b = sx__avx_load2(fs + 4, fs + 16);
+        __m256 c = sx__avx_load2(fs + 8, fs + 20);
+        __m256 x, y, z;
+        sx__deinterleave3(__m256, _mm256_shuffle_ps, a, b, c, x, y, z);
+
+        __m256 rx = _mm256_fmadd_ps(x, m11, _mm256_fmadd_ps(y, m12, _mm256_fmadd_ps(z, m13, m14)));
+        __m256 ry = _mm256_fmadd_ps(x, m21, _mm256_fmadd_ps(y, m22, _mm256_fmadd_ps(z, m23, m24)));
+        __m256 rz = _mm256_fmadd_ps(x, m31, _mm256_fmadd_ps(y, m32, _mm256_fmadd_ps(z, m33, m34)));
+
+        sx__interleave3(__m256, _mm256_shuffle_ps, rx, ry, rz, a, b, c);
+        float* fd = dst[i].f;
+        sx__avx_store2(fd, fd + 12, a);
+        sx__avx_store2(fd + 4, fd + 16, b);
+        sx__avx_store2(fd + 8, fd + 20, c);
+    }
+
+    sx__mat4_mul_vec3_ref(dst + i, mat, src + i, count - i);
+}
+
+SX__AVX2_FUNC static void sx__mat3_mul_vec2_avx2(sx_vec2* dst, const sx_mat3* mat,
+                                                 const sx_vec2* src, int count)
+{
+    __m256 m11 = _mm256_set1_ps(mat->m11), m12 = _mm256_set1_ps(mat->m12);
+    __m256 m13 = _mm256_set1_ps(mat->m13), m21 = _mm256_set1_ps(mat->m21);
+    __m256 m22 = _mm256_set1_ps(mat->m22), m23 = _mm256_set1_ps(mat->m23);
+
+    int i = 0;
+    for (int ic = count & ~7; i < ic; i += 8) {
+        const float* fs = src[i].f;
+        __m256 a = _mm256_loadu_ps(fs), b = _mm256_loadu_ps(fs + 8);
+        __m256 x = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+        __m256 y = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+
+        __m256 rx = _mm256_fmadd_ps(x, m11, _mm256_fmadd_ps(y, m12, m13));
+        __m256 ry = _mm256_fmadd_ps(x, m21, _mm256_fmadd_ps(y, m22, m23));
+
+        float* fd = dst[i].f;
+        _mm256_storeu_ps(fd, _mm256_unpacklo_ps(rx, ry));
+        _mm256_storeu_ps(fd + 8, _mm256_unpackhi_ps(rx, ry));
+    }
+
+    sx__mat3_mul_vec2_ref(dst + i, mat, src + i, count - i);
+}
+
+SX__AVX2_FUNC static void sx__quat_mat4_avx2(sx_mat4* dst, const sx_quat* src, int count)
+{
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 two = _mm256_set1_ps(2.0f);
+    const __m128 col4 = _mm_set_ps(1.0f, 0.0f, 0.0f, 0.0f);
+
+    int i = 0;
+    for (int ic = count & ~7; i < ic; i += 8) {
+        const sx_quat* q = &src[i];
+        __m256 x = sx__avx_load2(q[0].f, q[4].f), y = sx__avx_load2(q[1].f, q[5].f);
+        __m256 z = sx__avx_load2(q[2].f, q[6].f), w = sx__avx_load2(q[3].f, q[7].f);
+        sx__transpose4(__m256, _mm256_unpacklo_ps, _mm256_unpackhi_ps, _mm256_shuffle_ps, x, y,
+                       z, w);
+
+        __m256 norm = _mm256_sqrt_ps(_mm256_fmadd_ps(
+            x, x, _mm256_fmadd_ps(y, y, _mm256_fmadd_ps(z, z, _mm256_mul_ps(w, w)))));
+        __m256 s = _mm256_and_ps(_mm256_cmp_ps(norm, zero, _CMP_GT_OQ), _mm256_div_ps(two, norm));
+
+        __m256 sx_ = _mm256_mul_ps(s, x), sy = _mm256_mul_ps(s, y), sz = _mm256_mul_ps(s, z);
+        __m256 xx = _mm256_mul_ps(sx_, x), xy = _mm256_mul_ps(sx_, y), xz = _mm256_mul_ps(sx_, z);
+        __m256 yy = _mm256_mul_ps(sy, y), yz = _mm256_mul_ps(sy, z), zz = _mm256_mul_ps(sz, z);
+        __m256 wx = _mm256_mul_ps(sx_, w), wy = _mm256_mul_ps(sy, w), wz = _mm256_mul_ps(sz, w);
+
+        __m256 cols[3][4] = {
+            { _mm256_sub_ps(_mm256_sub_ps(one, yy), zz), _mm256_add_ps(xy, wz),
+              _mm256_sub_ps(xz, wy), zero },
+            { _mm256_sub_ps(xy, wz), _mm256_sub_ps(_mm256_sub_ps(one, xx), zz),
+              _mm256_add_ps(yz, wx), zero },
+            { _mm256_add_ps(xz, wy), _mm256_sub_ps(yz, wx),
+              _mm256_sub_ps(_mm256_sub_ps(one, xx), yy), zero },
+        };
+
+        sx_mat4* d = &dst[i];
+        for (int c = 0; c < 3; c++) {
+            __m256 r0 = cols[c][0], r1 = cols[c][1], r2 = cols[c][2], r3 = cols[c][3];
+            sx__transpose4(__m256, _mm256_unpacklo_ps, _mm256_unpackhi_ps, _mm256_shuffle_ps, r0,
+                           r1, r2, r3);
+            sx__avx_store2(d[0].f + c * 4, d[4].f + c * 4, r0);
+            sx__avx_store2(d[1].f + c * 4, d[5].f + c * 4, r1);
+            sx__avx_store2(d[2].f + c * 4, d[6].f + c * 4, r2);
+            sx__avx_store2(d[3].f + c * 4, d[7].f + c * 4, r3);
+        }
+        for (int k = 0; k < 8; k++) {
+            _mm_storeu_ps(d[k].f + 12, col4);
+        }
+    }
+
+    sx__quat_mat4_sse2(dst + i, src + i, count - i);
+}
+
+static bool sx__cpu_has_avx2(void)
+{
+#    if SX_COMPILER_MSVC
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+        return false;
+    }
+    __cpuid(info, 1);
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool avx = (info[2] & (1 << 28)) != 0;
+    bool fma = (info[2] & (1 << 12)) != 0;
+    if (!osxsave || !avx || !fma || (_xgetbv(0) & 0x6) != 0x6) {
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#    else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#    endif
+}
+#endif    // SX__MATH_AVX2
+
+#if SX__MATH_NEON
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// NEON
+static void sx__mat4_mul_neon(sx_mat4* dst, const sx_mat4* a, const sx_mat4* b, int count)
+{
+    for (int i = 0; i < count; i++) {
+        const float* fa = a[i].f;
+        const float* fb = b[i].f;
+        float32x4_t a0 = vld1q_f32(fa), a1 = vld1q_f32(fa + 4);
+        float32x4_t a2 = vld1q_f32(fa + 8), a3 = vld1q_f32(fa + 12);
+        float32x4_t b_cols[4] = { vld1q_f32(fb), vld1q_f32(fb + 4), vld1q_f32(fb + 8),
+                                  vld1q_f32(fb + 12) };
+        for (int c = 0; c < 4; c++) {
+            float32x4_t bc = b_cols[c];
+            float32x4_t r = vmulq_n_f32(a0, vgetq_lane_f32(bc, 0));
+            r = vmlaq_n_f32(r, a1, vgetq_lane_f32(bc, 1));
+            r = vmlaq_n_f32(r, a2, vgetq_lane_f32(bc, 2));
+            r = vmlaq_n_f32(r, a3, vgetq_lane_f32(bc, 3));
+            vst1q_f32(dst[i].f + c * 4, r);
+        }
+    }
+}
+
+static void sx__mat4_mul_vec3_neon(sx_vec3* dst, const sx_mat4* mat, const sx_vec3* src, int count)
+{
+    int i = 0;
+    for (int ic = count & ~3; i < ic; i += 4) {
+        float32x4x3_t p = vld3q_f32(src[i].f);
+        float32x4x3_t r;
+        r.val[0] = vmlaq_n_f32(vmlaq_n_f32(vmlaq_n_f32(vdupq_n_f32(mat->m14), p.val[0], mat->m11),
+                                           p.val[1], mat->m12),
+                               p.val[2], mat->m13);
+        r.val[1] = vmlaq_n_f32(vmlaq_n_f32(vmlaq_n_f32(vdupq_n_f32(mat->m24), p.val[0], mat->m21),
+                                           p.val[1], mat->m22),
+                               p.val[2], mat->m23);
+        r.val[2] = vmlaq_n_f32(vmlaq_n_f32(vmlaq_n_f32(vdupq_n_f32(mat->m34), p.val[0], mat->m31),
+                                           p.val[1], mat->m32),
+                               p.val[2], mat->m33);
+        vst3q_f32(dst[i].f, r);
+    }
+
+    sx__mat4_mul_vec3_ref(dst + i, mat, src + i, count - i);
+}
+
+static void sx__mat3_mul_vec2_neon(sx_vec2* dst, const sx_mat3* mat, const sx_vec2* src, int count)
+{
+    int i = 0;
+    for (int ic = count & ~3; i < ic; i += 4) {
+        float32x4x2_t p = vld2q_f32(src[i].f);
+        float32x4x2_t r;
+        r.val[0] = vmlaq_n_f32(vmlaq_n_f32(vdupq_n_f32(mat->m13), p.val[0], mat->m11), p.val[1],
+                               mat->m12);
+        r.val[1] = vmlaq_n_f32(vmlaq_n_f32(vdupq_n_f32(mat->m23), p.val[0], mat->m21), p.val[1],
+                               mat->m22);
+        vst2q_f32(dst[i].f, r);
+    }
+
+    sx__mat3_mul_vec2_ref(dst + i, mat, src + i, count - i);
+}
+
+static void sx__aabb_transform_neon(sx_aabb* dst, const sx_mat4* mat, const sx_aabb* src, int count)
+{
+    float32x4_t c1 = vld1q_f32(mat->f), c2 = vld1q_f32(mat->f + 4);
+    float32x4_t c3 = vld1q_f32(mat->f + 8), c4 = vld1q_f32(mat->f + 12);
+    float32x4_t ac1 = vabsq_f32(c1), ac2 = vabsq_f32(c2), ac3 = vabsq_f32(c3);
+
+    for (int i = 0; i < count; i++) {
+        const float* fs = src[i].f;
+        float32x4_t vmin = vld1q_f32(fs);    // xmin ymin zmin xmax
+        float32x4_t vmax = vld1q_f32(fs + 2);
+        vmax = vextq_f32(vmax, vmax, 1);
+        float32x4_t center = vmulq_n_f32(vaddq_f32(vmin, vmax), 0.5f);
+        float32x4_t extent = vmulq_n_f32(vsubq_f32(vmax, vmin), 0.5f);
+
+        float32x4_t c = vmlaq_n_f32(c4, c1, vgetq_lane_f32(center, 0));
+        c = vmlaq_n_f32(c, c2, vgetq_lane_f32(center, 1));
+        c = vmlaq_n_f32(c, c3, vgetq_lane_f32(center, 2));
+        float32x4_t e = vmulq_n_f32(ac1, vgetq_lane_f32(extent, 0));
+        e = vmlaq_n_f32(e, ac2, vgetq_lane_f32(extent, 1));
+        e = vmlaq_n_f32(e, ac3, vgetq_lane_f32(extent, 2));
+        float32x4_t rmin = vsubq_f32(c, e);
+        float32x4_t rmax = vaddq_f32(c, e);
+
+        float* fd = dst[i].f;
+        vst1q_f32(fd, vsetq_lane_f32(vgetq_lane_f32(rmax, 0), rmin, 3));
+        vst1_f32(fd + 4, vget_low_f32(vextq_f32(rmax, rmax, 1)));
+    }
+}
+
+static void sx__quat_mat4_neon(sx_mat4* dst, const sx_quat* src, int count)
+{
+    const float32x4_t one = vdupq_n_f32(1.0f);
+
+    int i = 0;
+    for (int ic = count & ~3; i < ic; i += 4) {
+        float32x4x4_t q = vld4q_f32(src[i].f);
+        float32x4_t x = q.val[0], y = q.val[1], z = q.val[2], w = q.val[3];
+
+        float norm[4], dot[4];
+        vst1q_f32(dot, vmlaq_f32(vmlaq_f32(vmlaq_f32(vmulq_f32(w, w), z, z), y, y), x, x));
+        for (int k = 0; k < 4; k++) {
+            float n = sx_sqrt(dot[k]);
+            norm[k] = n > 0.0f ? (2.0f / n) : 0.0f;
+        }
+        float32x4_t s = vld1q_f32(norm);
+
+        float32x4_t sx_ = vmulq_f32(s, x), sy = vmulq_f32(s, y), sz = vmulq_f32(s, z);
+        float32x4_t xx = vmulq_f32(sx_, x), xy = vmulq_f32(sx_, y), xz = vmulq_f32(sx_, z);
+        float32x4_t yy = vmulq_f32(sy, y), yz = vmulq_f32(sy, z), zz = vmulq_f32(sz, z);
+        float32x4_t wx = vmulq_f32(sx_, w), wy = vmulq_f32(sy, w), wz = vmulq_f32(sz, w);
+
+        float m[9][4];
+        vst1q_f32(m[0], vsubq_f32(vsubq_f32(one, yy), zz));
+        vst1q_f32(m[1], vaddq_f32(xy, wz));
+        vst1q_f32(m[2], vsubq_f32(xz, wy));
+        vst1q_f32(m[3], vsubq_f32(xy, wz));
+        vst1q_f32(m[4], vsubq_f32(vsubq_f32(one, xx), zz));
+        vst1q_f32(m[5], vaddq_f32(yz, wx));
+        vst1q_f32(m[6], vaddq_f32(xz, wy));
+        vst1q_f32(m[7], vsubq_f32(yz, wx));
+        vst1q_f32(m[8], vsubq_f32(vsubq_f32(one, xx), yy));
+
+        for (int k = 0; k < 4; k++) {
+            // clang-format off
+            dst[i + k] = sx_mat4f(m[0][k],  m[3][k],    m[6][k],    0.0f,
+                                  m[1][k],  m[4][k],    m[7][k],    0.0f,
+                                  m[2][k],  m[5][k],    m[8][k],    0.0f,
+                                  0.0f,     0.0f,       0.0f,       1.0f);
+            // clang-format on
+        }
+    }
+
+    sx__quat_mat4_ref(dst + i, src + i, count - i);
+}
+#endif    // SX__MATH_NEON
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// dispatch
+static const sx__math_batch_api* sx__math_batch(void)
+{
+    if (g_math_batch.name) {
+        return &g_math_batch;
+    }
+
+    sx__math_batch_api api = { .mat4_mul = sx__mat4_mul_ref,
+                               .mat4_mul_vec3 = sx__mat4_mul_vec3_ref,
+                               .mat3_mul_vec2 = sx__mat3_mul_vec2_ref,
+                               .aabb_transform = sx__aabb_transform_ref,
+                               .quat_mat4 = sx__quat_mat4_ref,
+                               .name = "scalar" };
+#if SX__MATH_SSE2
+    api = (sx__math_batch_api){ .mat4_mul = sx__mat4_mul_sse2,
+                                .mat4_mul_vec3 = sx__mat4_mul_vec3_sse2,
+                                .mat3_mul_vec2 = sx__mat3_mul_vec2_sse2,
+                                .aabb_transform = sx__aabb_transform_sse2,
+                                .quat_mat4 = sx__quat_mat4_sse2,
+                                .name = "sse2" };
+#    if SX__MATH_AVX2
+    if (sx__cpu_has_avx2()) {
+        api.mat4_mul = sx__mat4_mul_avx2;
+        api.mat4_mul_vec3 = sx__mat4_mul_vec3_avx2;
+        api.mat3_mul_vec2 = sx__mat3_mul_vec2_avx2;
+        api.quat_mat4 = sx__quat_mat4_avx2;
+        api.name = "avx2";
+    }
+#    endif
+#elif SX__MATH_NEON
+    api = (sx__math_batch_api){ .mat4_mul = sx__mat4_mul_neon,
+                                .mat4_mul_vec3 = sx__mat4_mul_vec3_neon,
+                                .mat3_mul_vec2 = sx__mat3_mul_vec2_neon,
+                                .aabb_transform = sx__aabb_transform_neon,
+                                .quat_mat4 = sx__quat_mat4_neon,
+                                .name = "neon" };
+#endif
+
+    // all threads that race here resolve to the same values, `name` is published last
+    g_math_batch.mat4_mul = api.mat4_mul;
+    g_math_batch.mat4_mul_vec3 = api.mat4_mul_vec3;
+    g_math_batch.mat3_mul_vec2 = api.mat3_mul_vec2;
+    g_math_batch.aabb_transform = api.aabb_transform;
+    g_math_batch.quat_mat4 = api.quat_mat4;
+    sx_compiler_write_barrier();
+    g_math_batch.name = api.name;
+    return &g_math_batch;
+}
+
+void sx_mat4_mul_batch(sx_mat4* dst, const sx_mat4* a, const sx_mat4* b, int count)
+{
+    sx_assert(count >= 0);
+    sx__math_batch()->mat4_mul(dst, a, b, count);
+}
+
+void sx_mat4_mul_vec3_batch(sx_vec3* dst, const sx_mat4* mat, const sx_vec3* src, int count)
+{
+    sx_assert(count >= 0);
+    sx__math_batch()->mat4_mul_vec3(dst, mat, src, count);
+}
+
+void sx_mat3_mul_vec2_batch(sx_vec2* dst, const sx_mat3* mat, const sx_vec2* src, int count)
+{
+    sx_assert(count >= 0);
+    sx__math_batch()->mat3_mul_vec2(dst, mat, src, count);
+}
+
+sx_aabb sx_aabb_transform(const sx_aabb* box, const sx_mat4* mat)
+{
+    return sx__aabb_transform(mat, box);
+}
+
+void sx_aabb_transform_batch(sx_aabb* dst, const sx_mat4* mat, const sx_aabb* src, int count)
+{
+    sx_assert(count >= 0);
+    sx__math_batch()->aabb_transform(dst, mat, src, count);
+}
+
+void sx_quat_mat4_batch(sx_mat4* dst, const sx_quat* src, int count)
+{
+    sx_assert(count >= 0);
+    sx__math_batch()->quat_mat4(dst, src, count);
+}
+
+const char* sx_math_batch_backend(void)
+{
+    return sx__math_batch()->name;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// 2x2 box filter of RGBA rows (mip generation)
+// SIMD paths consume pairs of source texels, the scalar tail also clamps odd/1 texel widths
+void sx_rgba8_box_batch(uint8_t* dst, const uint8_t* r0, const uint8_t* r1, int dst_w, int src_w)
+{
+    sx_assert(dst_w >= 0 && src_w > 0);
+    int x = 0;
+    if (src_w >= dst_w * 2) {
+#if SX__MATH_SSE2
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i two = _mm_set1_epi16(2);
+        for (; x + 2 <= dst_w; x += 2) {
+            __m128i a = _mm_loadu_si128((const __m128i*)(r0 + x * 8));
+            __m128i b = _mm_loadu_si128((const __m128i*)(r1 + x * 8));
+            __m128i v0 = _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero));
+            __m128i v1 = _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero));
+            __m128i h = _mm_add_epi16(_mm_unpacklo_epi64(v0, v1), _mm_unpackhi_epi64(v0, v1));
+            h = _mm_srli_epi16(_mm_add_epi16(h, two), 2);
+            _mm_storel_epi64((__m128i*)(dst + x * 4), _mm_packus_epi16(h, h));
+        }
+#elif SX__MATH_NEON
+        for (; x + 2 <= dst_w; x += 2) {
+            uint8x16_t a = vld1q_u8(r0 + x * 8);
+            uint8x16_t b = vld1q_u8(r1 + x * 8);
+            uint16x8_t v0 = vaddl_u8(vget_low_u8(a), vget_low_u8(b));
+            uint16x8_t v1 = vaddl_u8(vget_high_u8(a), vget_high_u8(b));
+            uint16x8_t h = vaddq_u16(vcombine_u16(vget_low_u16(v0), vget_low_u16(v1)),
+                                     vcombine_u16(vget_high_u16(v0), vget_high_u16(v1)));
+            vst1_u8(dst + x * 4, vrshrn_n_u16(h, 2));
+        }
+#endif
+    }
+
+    for (; x < dst_w; x++) {
+        int x0 = sx_min(x * 2, src_w - 1) * 4;
+        int x1 = sx_min(x * 2 + 1, src_w - 1) * 4;
+        for (int c = 0; c < 4; c++) {
+            int sum = r0[x0 + c] + r0[x1 + c] + r1[x0 + c] + r1[x1 + c];
+            dst[x * 4 + c] = (uint8_t)((sum + 2) >> 2);
+        }
+    }
+}
+
+void sx_rgba16_box_batch(uint16_t* dst, const uint16_t* r0, const uint16_t* r1, int dst_w,
+                         int src_w)
+{
+    sx_assert(dst_w >= 0 && src_w > 0);
+    int x = 0;
+    if (src_w >= dst_w * 2) {
+#if SX__MATH_SSE2
+        const __m128i two = _mm_set1_epi16(2);
+        for (; x + 2 <= dst_w; x += 2) {
+            const __m128i* a = (const __m128i*)(r0 + x * 8);
+            const __m128i* b = (const __m128i*)(r1 + x * 8);
+            __m128i v0 = _mm_add_epi16(_mm_loadu_si128(a), _mm_loadu_si128(b));
+            __m128i v1 = _mm_add_epi16(_mm_loadu_si128(a + 1), _mm_loadu_si128(b + 1));
+            __m128i h = _mm_add_epi16(_mm_unpacklo_epi64(v0, v1), _mm_unpackhi_epi64(v0, v1));
+            _mm_storeu_si128((__m128i*)(dst + x * 4), _mm_srli_epi16(_mm_add_epi16(h, two), 2));
+        }
+#elif SX__MATH_NEON
+        for (; x + 2 <= dst_w; x += 2) {
+            uint16x8_t v0 = vaddq_u16(vld1q_u16(r0 + x * 8), vld1q_u16(r1 + x * 8));
+            uint16x8_t v1 = vaddq_u16(vld1q_u16(r0 + x * 8 + 8), vld1q_u16(r1 + x * 8 + 8));
+            uint16x8_t h = vaddq_u16(vcombine_u16(vget_low_u16(v0), vget_low_u16(v1)),
+                                     vcombine_u16(vget_high_u16(v0), vget_high_u16(v1)));
+            vst1q_u16(dst + x * 4, vrshrq_n_u16(h, 2));
+        }
+#endif
+    }
+
+    for (; x < dst_w; x++) {
+        int x0 = sx_min(x * 2, src_w - 1) * 4;
+        int x1 = sx_min(x * 2 + 1, src_w - 1) * 4;
+        for (int c = 0; c < 4; c++) {
+            int sum = r0[x0 + c] + r0[x1 + c] + r1[x0 + c] + r1[x1 + c];
+            dst[x * 4 + c] = (uint16_t)((sum + 2) >> 2);
+        }
+    }
+}
@@ -140,19 +140,18 @@ bool sx_semaphore_wait(sx_sem* sem, int msecs)
 // Other implementations are either Posix or Win32
 #if SX_PLATFORM_POSIX
 
-// Tls
+// Tls: keys are stored +1, because zero is a valid key and NULL is returned on failure
 sx_tls sx_tls_create()
 {
     pthread_key_t key;
     int r = pthread_key_create(&key, NULL);
     sx_assert(r == 0 && "pthread_key_create failed");
-    sx_unused(r);
-    return (sx_tls)(uintptr_t)key;
+    return r == 0 ? (sx_tls)((uintptr_t)key + 1) : NULL;
 }
 
 void sx_tls_destroy(sx_tls tls)
 {
-    pthread_key_t key = (pthread_key_t)(uintptr_t)tls;
+    pthread_key_t key = (pthread_key_t)((uintptr_t)tls - 1);
     int r = pthread_key_delete(key);
     sx_assert(r == 0 && "pthread_key_delete failed");
     sx_unused(r);
@@ -160,7 +159,7 @@ void sx_tls_destroy(sx_tls tls)
 
 void sx_tls_set(sx_tls tls, void* data)
 {
-    pthread_key_t key = (pthread_key_t)(uintptr_t)tls;
+    pthread_key_t key = (pthread_key_t)((uintptr_t)tls - 1);
     int r = pthread_setspecific(key, data);
     sx_assert(r == 0 && "pthread_setspcific failed");
     sx_unused(r);
@@ -168,7 +167,7 @@ void sx_tls_set(sx_tls tls, void* data)
 
 void* sx_tls_get(sx_tls tls)
 {
-    pthread_key_t key = (pthread_key_t)(uintptr_t)tls;
+    pthread_key_t key = (pthread_key_t)((uintptr_t)tls - 1);
     return pthread_getspecific(key);
 }
 
@@ -461,27 +460,27 @@ bool sx_semaphore_wait(sx_sem* sem, int msecs)
 }
 #    endif
 #elif SX_PLATFORM_WINDOWS
-// Tls
+// Tls: indices are stored +1, because zero is a valid index and NULL is returned on failure
 sx_tls sx_tls_create()
 {
     DWORD tls_id = TlsAlloc();
     sx_assert(tls_id != TLS_OUT_OF_INDEXES && "Failed to create tls!");
-    return (sx_tls)(uintptr_t)tls_id;
+    return tls_id != TLS_OUT_OF_INDEXES ? (sx_tls)((uintptr_t)tls_id + 1) : NULL;
 }
 
 void sx_tls_destroy(sx_tls tls)
 {
-    TlsFree((DWORD)(uintptr_t)tls);
+    TlsFree((DWORD)((uintptr_t)tls - 1));
 }
 
 void sx_tls_set(sx_tls tls, void* data)
 {
-    TlsSetValue((DWORD)(uintptr_t)tls, data);
+    TlsSetValue((DWORD)((uintptr_t)tls - 1), data);
 }
 
 void* sx_tls_get(sx_tls tls)
 {
-    return TlsGetValue((DWORD)(uintptr_t)tls);
+    return TlsGetValue((DWORD)((uintptr_t)tls - 1));
 }
 
 // Mutex
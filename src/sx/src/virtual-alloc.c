@@ -25,7 +25,8 @@ void* sx_virtual_reserve(size_t reserve_sz)
 #if SX_PLATFORM_WINDOWS
     return VirtualAlloc(NULL, reserve_sz, MEM_RESERVE, PAGE_READWRITE);
 #elif SX_PLATFORM_POSIX
-    return mmap(NULL, reserve_sz, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    void* ptr = mmap(NULL, reserve_sz, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    return ptr != MAP_FAILED ? ptr : NULL;
 #endif
 }
 
@@ -57,7 +58,9 @@ void* sx_virtual_commit(void* addr, size_t sz)
 #if SX_PLATFORM_WINDOWS
     return VirtualAlloc(addr, sz, MEM_COMMIT, PAGE_READWRITE);
 #elif SX_PLATFORM_POSIX
-    return mmap(addr, sz, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0);
+    void* ptr =
+        mmap(addr, sz, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0);
+    return ptr != MAP_FAILED ? ptr : NULL;
 #endif
 }
 
@@ -70,7 +73,9 @@ void sx_virtual_decommit(void* addr, size_t sz)
 #if SX_PLATFORM_WINDOWS
     VirtualFree(addr, sz, MEM_DECOMMIT);
 #elif SX_PLATFORM_POSIX
-    munmap(addr, sz);
+    // map the range back to inaccessible pages instead of unmapping it, so the address range stays
+    // reserved and can be committed again later
+    mmap(addr, sz, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0);
 #endif
 }
 
@@ -0,0 +1,246 @@
+//
+// Scheduling test and benchmark for coroutines (sx_coro_context of sx/fiber.h)
+//  - sequence: yield/wait/yieldn resume on the expected updates, a 0ms wait right after a resume
+//              from a yield bucket runs on the next update, not in the same one
+//  - waits: many coroutines wait random times (through all levels of the timer wheel), every
+//           one must resume in the first update that passes it's wake time
+//  - benchmark: update cost with mostly idle coroutines (long waits), short waits and yields
+// run with '-b' for the full benchmark (100k coroutines), otherwise a short version is executed
+// NOTE: on linux, every committed stack and it's guard page take two memory mappings, so the number
+//       of coroutines is limited by vm.max_map_count (default: 65530)
+//
+#include "sx/allocator.h"
+#include "sx/fiber.h"
+#include "sx/string.h"
+#include "sx/timer.h"
+
+#include <stdio.h>
+
+#if SX_PLATFORM_LINUX
+// every stack is two mappings (guard page + stack), keep some for the rest of the process
+static int max_coros_by_map_count(int num_coros)
+{
+    FILE* f = fopen("/proc/sys/vm/max_map_count", "rt");
+    int max_map_count = 0;
+    if (f) {
+        if (fscanf(f, "%d", &max_map_count) != 1)
+            max_map_count = 0;
+        fclose(f);
+    }
+    int limit = (max_map_count - 1000) / 2;
+    return limit > 0 ? sx_min(num_coros, limit) : num_coros;
+}
+#else
+static int max_coros_by_map_count(int num_coros)
+{
+    return num_coros;
+}
+#endif
+
+#define STACK_SIZE (32 * 1024)
+#define DT (1.0f / 64.0f)    // exact in float, so expected wake updates are exact too
+
+typedef struct coro_data {
+    sx_coro_context* ctx;
+    int64_t wait_frame;    // update that the coroutine started waiting in
+    double wake;           // wake time of the wait
+    uint32_t seed;
+    int max_wait;          // msecs
+} coro_data;
+
+static const sx_alloc* g_alloc;
+static int64_t g_frame;          // number of updates, same as the context
+static double g_time;            // accumulated time, same arithmetic as the context
+static double g_prev_time;       // time of the previous update
+static int g_num_errors;
+static int64_t g_num_resumes;
+static bool g_quit;
+
+static int64_t g_seq_frames[8];
+static int g_seq_count;
+
+static void report_error(const char* msg, int64_t expected, int64_t frame)
+{
+    if (++g_num_errors <= 10)
+        printf("\t%s (expected: %d, update: %d)\n", msg, (int)expected, (int)frame);
+}
+
+static inline uint32_t rand_next(uint32_t* seed)
+{
+    *seed = *seed * 1664525u + 1013904223u;
+    return *seed >> 8;
+}
+
+sx_coro_declare(sequence)
+{
+    sx_coro_context* ctx = sx_coro_userdata();
+    g_seq_frames[g_seq_count++] = g_frame;    // 0: runs on invoke
+    sx_coro_yield(ctx);
+    g_seq_frames[g_seq_count++] = g_frame;    // 1
+    sx_coro_wait(ctx, 0);
+    g_seq_frames[g_seq_count++] = g_frame;    // 2: not in the same update as the yield resume
+    sx_coro_yieldn(ctx, 3);
+    g_seq_frames[g_seq_count++] = g_frame;    // 5
+    sx_coro_wait(ctx, 125);
+    g_seq_frames[g_seq_count++] = g_frame;    // 13: 125ms = 8 updates
+    sx_coro_wait(ctx, 20000);
+    g_seq_frames[g_seq_count++] = g_frame;    // 1293: cascaded from the upper wheel levels
+    sx_coro_yieldn(ctx, 100);
+    g_seq_frames[g_seq_count++] = g_frame;    // 1393: more updates than the yield buckets
+    sx_coro_end(ctx);
+}
+
+static bool test_sequence(void)
+{
+    static const int64_t expected[] = { 0, 1, 2, 5, 13, 1293, 1393 };
+    const int num_expected = (int)(sizeof(expected) / sizeof(expected[0]));
+
+    sx_coro_context* ctx = sx_coro_create_context(g_alloc, 4, STACK_SIZE);
+    if (!ctx)
+        return false;
+
+    g_frame = 0;
+    g_seq_count = 0;
+    int errors = g_num_errors;
+    sx_coro_invoke(ctx, sequence, ctx);
+    for (int i = 0; i < 1500; i++) {
+        ++g_frame;
+        sx_coro_update(ctx, DT);
+    }
+
+    if (g_seq_count != num_expected) {
+        report_error("sequence: wrong number of resumes", num_expected, g_seq_count);
+    } else {
+        for (int i = 0; i < num_expected; i++) {
+            if (g_seq_frames[i] != expected[i])
+                report_error("sequence: resumed on the wrong update", expected[i], g_seq_frames[i]);
+        }
+    }
+
+    sx_coro_destroy_context(ctx, g_alloc);
+    return errors == g_num_errors;
+}
+
+sx_coro_declare(waiter)
+{
+    coro_data* d = sx_coro_userdata();
+    while (!g_quit) {
+        int msecs = (int)(rand_next(&d->seed) % (uint32_t)(d->max_wait + 1));
+        d->wait_frame = g_frame;
+        d->wake = g_time + (double)msecs * 0.001;
+        sx_coro_wait(d->ctx, msecs);
+
+        ++g_num_resumes;
+        if (g_frame <= d->wait_frame) {
+            report_error("wait: resumed in the same update", d->wait_frame + 1, g_frame);
+        } else if (g_time < d->wake) {
+            report_error("wait: resumed too early", (int64_t)(d->wake * 1000.0),
+                         (int64_t)(g_time * 1000.0));
+        } else if (g_frame > d->wait_frame + 1 && g_prev_time >= d->wake) {
+            report_error("wait: resumed too late", (int64_t)(d->wake * 1000.0),
+                         (int64_t)(g_time * 1000.0));
+        }
+    }
+    sx_coro_end(d->ctx);
+}
+
+sx_coro_declare(yielder)
+{
+    coro_data* d = sx_coro_userdata();
+    while (!g_quit) {
+        d->wait_frame = g_frame;
+        sx_coro_yield(d->ctx);
+        ++g_num_resumes;
+        if (g_frame != d->wait_frame + 1)
+            report_error("yield: resumed on the wrong update", d->wait_frame + 1, g_frame);
+    }
+    sx_coro_end(d->ctx);
+}
+
+static void update(sx_coro_context* ctx)
+{
+    ++g_frame;
+    g_prev_time = g_time;
+    g_time += DT;
+    sx_coro_update(ctx, DT);
+}
+
+// returns average update time in seconds, or negative value on failure
+static double test_coros(int num_coros, int num_updates, sx_fiber_cb* coro_fn, int max_wait)
+{
+    sx_coro_context* ctx = sx_coro_create_context(g_alloc, num_coros, STACK_SIZE);
+    coro_data* datas = sx_malloc(g_alloc, sizeof(coro_data) * num_coros);
+    if (!ctx || !datas)
+        return -1.0;
+
+    g_frame = 0;
+    g_time = g_prev_time = 0;
+    g_num_resumes = 0;
+    g_quit = false;
+    int errors = g_num_errors;
+
+    for (int i = 0; i < num_coros; i++) {
+        datas[i] = (coro_data){ .ctx = ctx, .seed = (uint32_t)i + 1, .max_wait = max_wait };
+        sx__coro_invoke(ctx, coro_fn, &datas[i]);
+    }
+    g_num_resumes = 0;
+
+    uint64_t start = sx_tm_now();
+    for (int i = 0; i < num_updates; i++)
+        update(ctx);
+    double elapsed = sx_tm_sec(sx_tm_since(start));
+
+    // let every coroutine see the quit flag and end, the waits are bounded by max_wait
+    g_quit = true;
+    int64_t num_resumes = g_num_resumes;
+    for (int i = 0, c = (int)((double)max_wait * 0.001 / DT) + 2; i < c; i++)
+        update(ctx);
+    g_num_resumes = num_resumes;
+
+    sx_coro_destroy_context(ctx, g_alloc);
+    sx_free(g_alloc, datas);
+    return errors == g_num_errors ? elapsed / (double)num_updates : -1.0;
+}
+
+int main(int argc, char* argv[])
+{
+    bool bench = argc > 1 && sx_strequal(argv[1], "-b");
+    int num_coros = bench ? 100000 : 10000;
+    int num_updates = bench ? 1000 : 100;
+    if (max_coros_by_map_count(num_coros) < num_coros) {
+        num_coros = max_coros_by_map_count(num_coros);
+        printf("number of coroutines is limited to %d by vm.max_map_count\n", num_coros);
+    }
+
+    g_alloc = sx_alloc_malloc();
+    sx_tm_init();
+
+    int result = 0;
+    if (!test_sequence()) {
+        puts("sequence: FAILED");
+        result = 1;
+    }
+
+    struct {
+        const char* name;
+        sx_fiber_cb* coro_fn;
+        int max_wait;
+    } tests[] = { { "long waits (0..60s)", coro__waiter, 60000 },
+                  { "random waits (0..1s)", coro__waiter, 1000 },
+                  { "yield", coro__yielder, 0 } };
+
+    printf("coroutines: %d, updates: %d, dt: %.2f ms\n", num_coros, num_updates, DT * 1000.0f);
+
+    for (int i = 0; i < (int)(sizeof(tests) / sizeof(tests[0])); i++) {
+        double avg = test_coros(num_coros, num_updates, tests[i].coro_fn, tests[i].max_wait);
+        if (avg < 0) {
+            printf("%s: FAILED\n", tests[i].name);
+            result = 1;
+            continue;
+        }
+        printf("%-22s %10.2f us/update  %10.0f resumes/update\n", tests[i].name, avg * 1000000.0,
+               (double)g_num_resumes / (double)num_updates);
+    }
+
+    return result;
+}
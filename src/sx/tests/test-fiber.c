@@ -0,0 +1,281 @@
+//
+// Test and benchmark for fiber stack pools (sx_fiber_stack_pool of sx/fiber.h)
+//  - guard: the page below each stack is not accessible (posix: checked in a forked process)
+//  - lifo: returned stacks are taken again in reverse order, so warm stacks are reused first
+//  - usage: a fiber touches part of it's stack, the high-water mark covers it and only the touched
+//           pages are backed (posix)
+//  - trim: all free stacks but the `keep` most recent ones are decommitted, their memory is zero
+//          when they are taken again and their high-water mark is kept
+//  - benchmark: get/put of warm stacks, and get/put/trim of cold stacks (commit + decommit)
+// run with '-b' for the full benchmark, otherwise a short version is executed
+//
+#include "sx/allocator.h"
+#include "sx/fiber.h"
+#include "sx/os.h"
+#include "sx/string.h"
+#include "sx/timer.h"
+
+#include <stdio.h>
+
+#if SX_PLATFORM_POSIX
+#    include <signal.h>
+#    include <sys/wait.h>
+#    include <unistd.h>
+#endif
+
+#define STACK_SIZE (256 * 1024)
+#define MAX_STACKS 16
+
+static const sx_alloc* g_alloc;
+
+static sx_fiber_stack_pool* create_pool(void)
+{
+    return sx_fiber_stack_pool_create(
+        g_alloc, &(sx_fiber_stack_pool_desc){ .small_stack_sz = STACK_SIZE / 4,
+                                              .max_small = MAX_STACKS,
+                                              .large_stack_sz = STACK_SIZE,
+                                              .max_large = MAX_STACKS });
+}
+
+static uint8_t* stack_bottom(const sx_fiber_stack* fstack)
+{
+    return (uint8_t*)fstack->sptr - fstack->ssize;
+}
+
+#if SX_PLATFORM_POSIX
+// returns true if writing to `ptr` crashes the (forked) process
+static bool write_crashes(uint8_t* ptr)
+{
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid < 0)
+        return false;
+    if (pid == 0) {
+        *(volatile uint8_t*)ptr = 1;
+        _exit(0);
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+    return WIFSIGNALED(status) && (WTERMSIG(status) == SIGSEGV || WTERMSIG(status) == SIGBUS);
+}
+
+static bool test_guard(sx_fiber_stack_pool* pool)
+{
+    sx_fiber_stack stacks[2];
+    if (!sx_fiber_stack_pool_get(pool, STACK_SIZE, &stacks[0]) ||
+        !sx_fiber_stack_pool_get(pool, STACK_SIZE, &stacks[1])) {
+        return false;
+    }
+
+    bool r = true;
+    for (int i = 0; i < 2; i++) {
+        uint8_t* bottom = stack_bottom(&stacks[i]);
+        bottom[0] = 1;
+        ((uint8_t*)stacks[i].sptr)[-1] = 1;
+        r = r && write_crashes(bottom - 1);
+    }
+    // the guard page is all that separates the stacks
+    r = r && stack_bottom(&stacks[1]) - (uint8_t*)stacks[0].sptr == (ptrdiff_t)sx_os_pagesz();
+
+    sx_fiber_stack_pool_put(pool, &stacks[1]);
+    sx_fiber_stack_pool_put(pool, &stacks[0]);
+    return r;
+}
+#else
+static bool test_guard(sx_fiber_stack_pool* pool)
+{
+    sx_unused(pool);
+    puts("\tguard: skipped, needs fork");
+    return true;
+}
+#endif
+
+static bool test_lifo(sx_fiber_stack_pool* pool)
+{
+    sx_fiber_stack stacks[4];
+    void* sptrs[4];
+    for (int i = 0; i < 4; i++) {
+        if (!sx_fiber_stack_pool_get(pool, STACK_SIZE, &stacks[i]))
+            return false;
+        sptrs[i] = stacks[i].sptr;
+    }
+    for (int i = 0; i < 4; i++)
+        sx_fiber_stack_pool_put(pool, &stacks[i]);
+
+    bool r = true;
+    for (int i = 3; i >= 0; i--) {
+        if (!sx_fiber_stack_pool_get(pool, STACK_SIZE, &stacks[i]))
+            return false;
+        r = r && stacks[i].sptr == sptrs[i];
+    }
+
+    // small requests are taken from the small class
+    sx_fiber_stack small;
+    if (!sx_fiber_stack_pool_get(pool, STACK_SIZE / 8, &small))
+        return false;
+    r = r && small.ssize == STACK_SIZE / 4;
+    sx_fiber_stack_pool_put(pool, &small);
+
+    for (int i = 0; i < 4; i++)
+        sx_fiber_stack_pool_put(pool, &stacks[i]);
+    return r;
+}
+
+typedef struct touch_data {
+    int num_kb;
+    sx_fiber_t from;
+} touch_data;
+
+// every call takes more than 1kb of the stack, the array is used after the recursion, so the call
+// stays on the stack
+static int touch_stack(int depth)
+{
+    volatile uint8_t buff[1024];
+    for (int i = 0; i < (int)sizeof(buff); i++)
+        buff[i] = (uint8_t)(depth + i);
+    int r = depth > 1 ? touch_stack(depth - 1) : 0;
+    return r + buff[depth % sizeof(buff)];
+}
+
+static void touch_fiber_fn(sx_fiber_transfer transfer)
+{
+    touch_data* data = transfer.user;
+    touch_stack(data->num_kb);
+    sx_fiber_switch(transfer.from, NULL);
+}
+
+static bool test_usage(sx_fiber_stack_pool* pool)
+{
+    const int num_kb = 64;
+    sx_fiber_stack stack;
+    if (!sx_fiber_stack_pool_get(pool, STACK_SIZE, &stack))
+        return false;
+
+    touch_data data = { .num_kb = num_kb };
+    sx_fiber_t fiber = sx_fiber_create(stack, touch_fiber_fn);
+    sx_fiber_switch(fiber, &data);
+
+    int usage = sx_fiber_stack_pool_usage(pool, &stack);
+    bool r = usage >= num_kb * 1024 && usage < STACK_SIZE;
+    if (!r)
+        printf("\tusage: %d bytes, expected at least %d\n", usage, num_kb * 1024);
+
+    sx_fiber_stack_pool_info info;
+    sx_fiber_stack_pool_get_info(pool, &info);
+    r = r && info.large.num_used == 1 && info.large.peak_usage >= usage;
+#if SX_PLATFORM_POSIX
+    // only the touched pages are backed, the stacks of the other tests are barely used
+    r = r && info.large.committed_sz >= num_kb * 1024 &&
+        info.large.committed_sz < (int64_t)STACK_SIZE * info.large.num_committed / 2;
+#endif
+
+    sx_fiber_stack_pool_put(pool, &stack);
+    return r;
+}
+
+static bool test_trim(sx_fiber_stack_pool* pool)
+{
+    const int count = 8;
+    const int keep = 2;
+    sx_fiber_stack stacks[8];
+    void* sptrs[8];
+    for (int i = 0; i < count; i++) {
+        if (!sx_fiber_stack_pool_get(pool, STACK_SIZE, &stacks[i]))
+            return false;
+        sptrs[i] = stacks[i].sptr;
+        sx_memset(stack_bottom(&stacks[i]), 0xff, STACK_SIZE / 2);
+    }
+    for (int i = 0; i < count; i++)
+        sx_fiber_stack_pool_put(pool, &stacks[i]);
+
+    sx_fiber_stack_pool_info info;
+    sx_fiber_stack_pool_get_info(pool, &info);
+    bool r = info.large.num_used == 0 && info.large.num_committed >= count;
+
+    sx_fiber_stack_pool_trim(pool, keep);
+    sx_fiber_stack_pool_get_info(pool, &info);
+    r = r && info.large.num_committed == keep;
+    // high-water marks are recorded before the stacks are decommitted
+    r = r && info.large.peak_usage >= STACK_SIZE / 2;
+
+    // most recent ones are still warm, the rest are committed again with zero memory
+    for (int i = count - 1; i >= 0; i--) {
+        if (!sx_fiber_stack_pool_get(pool, STACK_SIZE, &stacks[i]))
+            return false;
+        uint8_t expected = i >= count - keep ? 0xff : 0;
+        r = r && stacks[i].sptr == sptrs[i] && stack_bottom(&stacks[i])[0] == expected;
+    }
+    for (int i = 0; i < count; i++)
+        sx_fiber_stack_pool_put(pool, &stacks[i]);
+
+    sx_fiber_stack_pool_trim(pool, 0);
+    sx_fiber_stack_pool_get_info(pool, &info);
+    r = r && info.large.num_committed == 0 && info.small.num_committed == 0 &&
+        info.large.committed_sz == 0;
+    return r;
+}
+
+// returns get/put pairs per second, `trim` decommits the stacks after each round
+static double bench_get_put(sx_fiber_stack_pool* pool, int num_rounds, bool trim)
+{
+    sx_fiber_stack stacks[MAX_STACKS];
+    uint64_t start = sx_tm_now();
+    for (int r = 0; r < num_rounds; r++) {
+        for (int i = 0; i < MAX_STACKS; i++) {
+            if (!sx_fiber_stack_pool_get(pool, STACK_SIZE, &stacks[i]))
+                return -1.0;
+            ((uint8_t*)stacks[i].sptr)[-1] = 1;    // fibers write their context to the top
+        }
+        for (int i = 0; i < MAX_STACKS; i++)
+            sx_fiber_stack_pool_put(pool, &stacks[i]);
+        if (trim)
+            sx_fiber_stack_pool_trim(pool, 0);
+    }
+    return (double)num_rounds * MAX_STACKS / sx_tm_sec(sx_tm_since(start));
+}
+
+int main(int argc, char* argv[])
+{
+    bool bench = argc > 1 && sx_strequal(argv[1], "-b");
+    int num_rounds = bench ? 100000 : 1000;
+
+    g_alloc = sx_alloc_malloc();
+    sx_tm_init();
+
+    struct {
+        const char* name;
+        bool (*test_fn)(sx_fiber_stack_pool* pool);
+    } tests[] = { { "guard", test_guard },
+                  { "lifo", test_lifo },
+                  { "usage", test_usage },
+                  { "trim", test_trim } };
+
+    int result = 0;
+    for (int i = 0; i < (int)(sizeof(tests) / sizeof(tests[0])); i++) {
+        sx_fiber_stack_pool* pool = create_pool();
+        if (!pool) {
+            puts("creating stack pool failed");
+            return 1;
+        }
+        bool r = tests[i].test_fn(pool);
+        printf("%-8s %s\n", tests[i].name, r ? "ok" : "FAILED");
+        result = r ? result : 1;
+        sx_fiber_stack_pool_destroy(pool, g_alloc);
+    }
+
+    sx_fiber_stack_pool* pool = create_pool();
+    if (!pool)
+        return 1;
+    double warm = bench_get_put(pool, num_rounds, false);
+    double cold = bench_get_put(pool, num_rounds / 10, true);
+    if (warm < 0 || cold < 0) {
+        puts("benchmark: FAILED");
+        result = 1;
+    } else {
+        printf("%-8s %10.2f M get+put/s\n", "warm", warm / 1000000.0);
+        printf("%-8s %10.2f M get+put+trim/s\n", "cold", cold / 1000000.0);
+    }
+    sx_fiber_stack_pool_destroy(pool, g_alloc);
+
+    return result;
+}
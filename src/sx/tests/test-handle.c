@@ -0,0 +1,208 @@
+//
+// Stress test and benchmark for the thread-safe handle pool (sx_handle_pool_mt of sx/handle.h)
+//  - several threads create and delete handles, no slot may be owned by two threads at once
+//  - handles must be valid while they are owned and invalid after they are deleted
+//  - benchmark: sx_handle_pool_mt (without the checks) vs. sx_handle_pool behind a lock,
+//    new+del pairs per second
+// run with '-b' for the full benchmark, otherwise a short version is executed (ctest)
+//
+#include "sx/allocator.h"
+#include "sx/atomic.h"
+#include "sx/handle.h"
+#include "sx/string.h"
+#include "sx/threads.h"
+#include "sx/timer.h"
+
+#include <stdio.h>
+
+#define NUM_THREADS 4
+#define BATCH_SIZE 64       // handles held by each thread at a time
+#define POOL_CAPACITY 64    // small blocks, so the pool grows while the threads are running
+
+typedef struct handle_test {
+    sx_handle_pool_mt* pool;
+    sx_handle_pool* locked_pool;
+    sx_lock_t lock;
+    int num_iters;    // per thread
+    bool locked;
+    bool check;
+    int* owners;    // [max_slots]: owner thread + 1, zero if free (atomic)
+    int max_slots;
+    sx_atomic_int num_errors;
+} handle_test;
+
+typedef struct thread_data {
+    handle_test* test;
+    int index;
+} thread_data;
+
+static const sx_alloc* g_alloc;
+
+static void report_error(handle_test* t, const char* msg, int index)
+{
+    if (sx_atomic_incr(&t->num_errors) <= 10) {
+        printf("\t%s (slot: %d)\n", msg, index);
+    }
+}
+
+static int handle_mt_cb(void* user_data1, void* user_data2)
+{
+    sx_unused(user_data2);
+    thread_data* td = user_data1;
+    handle_test* t = td->test;
+    int owner = td->index + 1;
+    sx_handle_t handles[BATCH_SIZE];
+
+    for (int iter = 0; iter < t->num_iters; iter++) {
+        for (int i = 0; i < BATCH_SIZE; i++) {
+            sx_handle_t handle = sx_handle_new_mt(t->pool);
+            int index = sx_handle_index(handle);
+            if (!handle || index >= t->max_slots) {
+                report_error(t, "invalid handle", index);
+                return -1;
+            }
+            if (t->check && sx_atomic_cas((sx_atomic_int*)&t->owners[index], owner, 0) != 0) {
+                report_error(t, "slot is owned by another thread", index);
+            }
+            handles[i] = handle;
+        }
+
+        // delete in a different order than they were created, to shuffle the free-list
+        for (int i = 0; i < BATCH_SIZE; i++) {
+            sx_handle_t handle = handles[(i * 7) % BATCH_SIZE];
+            if (!t->check) {
+                sx_handle_del_mt(t->pool, handle);
+                continue;
+            }
+
+            int index = sx_handle_index(handle);
+            if (!sx_handle_valid_mt(t->pool, handle)) {
+                report_error(t, "owned handle is not valid", index);
+            }
+            if (sx_atomic_cas((sx_atomic_int*)&t->owners[index], 0, owner) != owner) {
+                report_error(t, "slot is stolen by another thread", index);
+            }
+            sx_handle_del_mt(t->pool, handle);
+            if (sx_handle_valid_mt(t->pool, handle)) {
+                report_error(t, "deleted handle is still valid", index);
+            }
+        }
+    }
+    return 0;
+}
+
+// reference: single-threaded pool behind a lock, same access pattern without the checks
+static int handle_locked_cb(void* user_data1, void* user_data2)
+{
+    sx_unused(user_data2);
+    thread_data* td = user_data1;
+    handle_test* t = td->test;
+    sx_handle_t handles[BATCH_SIZE];
+
+    for (int iter = 0; iter < t->num_iters; iter++) {
+        for (int i = 0; i < BATCH_SIZE; i++) {
+            sx_lock(&t->lock, 1);
+            handles[i] = sx_handle_new_and_grow(t->locked_pool, g_alloc);
+            sx_unlock(&t->lock);
+        }
+        for (int i = 0; i < BATCH_SIZE; i++) {
+            sx_lock(&t->lock, 1);
+            sx_handle_del(t->locked_pool, handles[(i * 7) % BATCH_SIZE]);
+            sx_unlock(&t->lock);
+        }
+    }
+    return 0;
+}
+
+// returns elapsed time in seconds, or negative value on failure
+static double test_handles(int num_iters, bool locked, bool check)
+{
+    handle_test t = { .num_iters = num_iters, .locked = locked, .check = check };
+    t.max_slots = NUM_THREADS * BATCH_SIZE * 2;
+    t.owners = sx_malloc(g_alloc, sizeof(int) * t.max_slots);
+    if (locked) {
+        t.locked_pool = sx_handle_create_pool(g_alloc, POOL_CAPACITY);
+    } else {
+        t.pool = sx_handle_create_pool_mt(g_alloc, POOL_CAPACITY);
+    }
+    if (!t.owners || (!t.pool && !t.locked_pool))
+        return -1.0;
+    sx_memset(t.owners, 0x0, sizeof(int) * t.max_slots);
+
+    thread_data tds[NUM_THREADS];
+    sx_thread* thrds[NUM_THREADS];
+    uint64_t start = sx_tm_now();
+    for (int i = 0; i < NUM_THREADS; i++) {
+        tds[i] = (thread_data){ .test = &t, .index = i };
+        thrds[i] = sx_thread_create(g_alloc, locked ? handle_locked_cb : handle_mt_cb, &tds[i], 0,
+                                    "handle", NULL);
+    }
+    int num_failed = 0;
+    for (int i = 0; i < NUM_THREADS; i++) {
+        num_failed += sx_thread_destroy(thrds[i], g_alloc) != 0 ? 1 : 0;
+    }
+    double elapsed = sx_tm_sec(sx_tm_since(start));
+
+    int errors = t.num_errors + num_failed;
+    if (!locked) {
+        if (sx_handle_count_mt(t.pool) != 0) {
+            printf("\thandle count is %d after deleting all handles\n", sx_handle_count_mt(t.pool));
+            ++errors;
+        }
+        // every slot must be reused from the free-list, instead of growing without bounds
+        if (sx_handle_num_slots_mt(t.pool) > NUM_THREADS * BATCH_SIZE) {
+            printf("\t%d slots are used for %d handles\n", sx_handle_num_slots_mt(t.pool),
+                   NUM_THREADS * BATCH_SIZE);
+            ++errors;
+        }
+        sx_handle_destroy_pool_mt(t.pool);
+    } else {
+        sx_handle_destroy_pool(t.locked_pool, g_alloc);
+    }
+
+    sx_free(g_alloc, t.owners);
+    return errors == 0 ? elapsed : -1.0;
+}
+
+int main(int argc, char* argv[])
+{
+    bool bench = argc > 1 && sx_strequal(argv[1], "-b");
+    int num_iters = bench ? 20000 : 1000;
+    int num_runs = bench ? 5 : 1;
+
+    g_alloc = sx_alloc_malloc();
+    sx_tm_init();
+
+    struct {
+        const char* name;
+        bool locked;
+        bool check;
+    } tests[] = { { "handle_pool_mt (checked)", false, true },
+                  { "handle_pool_mt", false, false },
+                  { "handle_pool+lock", true, false } };
+
+    printf("threads: %d, handles per thread: %d, iterations: %d\n", NUM_THREADS, BATCH_SIZE,
+           num_iters);
+
+    int result = 0;
+    for (int i = 0; i < (int)(sizeof(tests) / sizeof(tests[0])); i++) {
+        double best = 0;
+        for (int r = 0; r < num_runs; r++) {
+            double elapsed = test_handles(num_iters, tests[i].locked, tests[i].check);
+            if (elapsed < 0) {
+                printf("%s: FAILED\n", tests[i].name);
+                result = 1;
+                best = -1.0;
+                break;
+            }
+            best = (r == 0) ? elapsed : sx_min(best, elapsed);
+        }
+
+        if (best > 0) {
+            double mops = (double)NUM_THREADS * BATCH_SIZE * num_iters / best / 1000000.0;
+            printf("%-26s %8.2f ms  %8.2f M new+del/s\n", tests[i].name, best * 1000.0, mops);
+        }
+    }
+
+    return result;
+}
@@ -0,0 +1,156 @@
+//
+// Test and benchmark for the job dispatcher (sx_job_context of sx/jobs.h)
+//  - ranges: every index of a dispatch is visited exactly once, by a valid thread index
+//  - nested: jobs dispatch and wait for their own jobs, so waits run from inside job fibers and
+//            the main thread resumes jobs that other threads have suspended
+//  - benchmark: dispatch+wait rounds per second, for small and large dispatches
+// the main thread takes part in every wait, run many rounds, so the selector of the main thread is
+// recreated again and again (optimized builds are the ones that catch bugs there)
+// run with '-b' for the full benchmark, otherwise a short version is executed
+//
+#include "sx/allocator.h"
+#include "sx/atomic.h"
+#include "sx/jobs.h"
+#include "sx/os.h"
+#include "sx/string.h"
+#include "sx/timer.h"
+
+#include <stdio.h>
+
+#define NUM_INDICES 4096
+#define NUM_CHILDREN 64
+
+typedef struct ranges_data {
+    int* visits;    // [NUM_INDICES]
+    int num_threads;
+    sx_atomic_int num_errors;
+} ranges_data;
+
+typedef struct nested_data {
+    sx_job_context* ctx;
+    int* visits;    // [count * NUM_CHILDREN]
+} nested_data;
+
+static void ranges_job_cb(int range_start, int range_end, int thread_index, void* user)
+{
+    ranges_data* data = user;
+    if (thread_index < 0 || thread_index > data->num_threads)
+        sx_atomic_incr(&data->num_errors);
+    for (int i = range_start; i < range_end; i++)
+        sx_atomic_incr((sx_atomic_int*)&data->visits[i]);
+}
+
+static void child_job_cb(int range_start, int range_end, int thread_index, void* user)
+{
+    sx_unused(thread_index);
+    int* visits = user;
+    for (int i = range_start; i < range_end; i++)
+        sx_atomic_incr((sx_atomic_int*)&visits[i]);
+}
+
+static void parent_job_cb(int range_start, int range_end, int thread_index, void* user)
+{
+    sx_unused(thread_index);
+    nested_data* data = user;
+    for (int i = range_start; i < range_end; i++) {
+        sx_job_t job = sx_job_dispatch(data->ctx, NUM_CHILDREN, child_job_cb,
+                                       &data->visits[i * NUM_CHILDREN], SX_JOB_PRIORITY_HIGH, 0);
+        sx_job_wait_and_del(data->ctx, job);
+    }
+}
+
+static bool test_ranges(sx_job_context* ctx, const sx_alloc* alloc, int num_rounds)
+{
+    ranges_data data = { .num_threads = sx_job_num_worker_threads(ctx) };
+    data.visits = sx_malloc(alloc, sizeof(int) * NUM_INDICES);
+    if (!data.visits)
+        return false;
+
+    bool r = true;
+    for (int round = 0; round < num_rounds && r; round++) {
+        // counts from 1 to NUM_INDICES, so ranges of all sizes and remainders are dispatched
+        int count = 1 + (round * 97) % NUM_INDICES;
+        sx_memset(data.visits, 0x0, sizeof(int) * count);
+        sx_job_t job = sx_job_dispatch(ctx, count, ranges_job_cb, &data, SX_JOB_PRIORITY_HIGH, 0);
+        sx_job_wait_and_del(ctx, job);
+        for (int i = 0; i < count; i++)
+            r = r && data.visits[i] == 1;
+    }
+
+    sx_free(alloc, data.visits);
+    return r && data.num_errors == 0;
+}
+
+static bool test_nested(sx_job_context* ctx, const sx_alloc* alloc, int num_rounds)
+{
+    const int count = 8;
+    nested_data data = { .ctx = ctx };
+    data.visits = sx_malloc(alloc, sizeof(int) * count * NUM_CHILDREN);
+    if (!data.visits)
+        return false;
+
+    bool r = true;
+    for (int round = 0; round < num_rounds && r; round++) {
+        sx_memset(data.visits, 0x0, sizeof(int) * count * NUM_CHILDREN);
+        sx_job_t job = sx_job_dispatch(ctx, count, parent_job_cb, &data, SX_JOB_PRIORITY_NORMAL, 0);
+        sx_job_wait_and_del(ctx, job);
+        for (int i = 0; i < count * NUM_CHILDREN; i++)
+            r = r && data.visits[i] == 1;
+    }
+
+    sx_free(alloc, data.visits);
+    return r;
+}
+
+static void empty_job_cb(int range_start, int range_end, int thread_index, void* user)
+{
+    sx_unused(range_start);
+    sx_unused(range_end);
+    sx_unused(thread_index);
+    sx_unused(user);
+}
+
+// returns dispatch+wait rounds per second
+static double bench_dispatch(sx_job_context* ctx, int count, int num_rounds)
+{
+    uint64_t start = sx_tm_now();
+    for (int r = 0; r < num_rounds; r++) {
+        sx_job_t job = sx_job_dispatch(ctx, count, empty_job_cb, NULL, SX_JOB_PRIORITY_HIGH, 0);
+        sx_job_wait_and_del(ctx, job);
+    }
+    return (double)num_rounds / sx_tm_sec(sx_tm_since(start));
+}
+
+int main(int argc, char* argv[])
+{
+    bool bench = argc > 1 && sx_strequal(argv[1], "-b");
+    int num_rounds = bench ? 100000 : 2000;
+
+    const sx_alloc* alloc = sx_alloc_malloc();
+    sx_tm_init();
+
+    sx_job_context* ctx = sx_job_create_context(
+        alloc, &(sx_job_context_desc){ .num_threads = sx_max(1, sx_os_numcores() - 1),
+                                       .max_fibers = 64,
+                                       .fiber_stack_sz = 256 * 1024 });
+    if (!ctx) {
+        puts("creating job context failed");
+        return 1;
+    }
+    printf("threads: %d\n", sx_job_num_worker_threads(ctx));
+
+    int result = 0;
+    bool r = test_ranges(ctx, alloc, num_rounds);
+    printf("%-8s %s\n", "ranges", r ? "ok" : "FAILED");
+    result = r ? result : 1;
+
+    r = test_nested(ctx, alloc, num_rounds / 10);
+    printf("%-8s %s\n", "nested", r ? "ok" : "FAILED");
+    result = r ? result : 1;
+
+    printf("%-8s %10.2f k rounds/s\n", "small", bench_dispatch(ctx, 4, num_rounds) / 1000.0);
+    printf("%-8s %10.2f k rounds/s\n", "large", bench_dispatch(ctx, 4096, num_rounds) / 1000.0);
+
+    sx_job_destroy_context(ctx, alloc);
+    return result;
+}
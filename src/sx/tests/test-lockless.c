@@ -0,0 +1,348 @@
+//
+// Stress test and benchmark for lock-free queues (sx/lockless.h)
+//  - SPSC: single producer/consumer, every item must arrive once and in order
+//  - MPMC: several producers/consumers, every item must be consumed exactly once
+//  - MPSC: several producers, every item must arrive once and in order per producer
+//  - benchmark: items per second, all queues with one producer and one consumer (1:1) to compare
+//    with sx_queue_spsc, then MPMC/MPSC with several producers, single vs. batch operations
+// run with '-b' for the full benchmark, otherwise a short version is executed (ctest)
+//
+#include "sx/allocator.h"
+#include "sx/atomic.h"
+#include "sx/lockless.h"
+#include "sx/string.h"
+#include "sx/threads.h"
+#include "sx/timer.h"
+
+#include <stdio.h>
+
+#define NUM_PRODUCERS 4
+#define NUM_CONSUMERS 4
+#define BATCH_SIZE 32
+
+typedef struct spsc_test {
+    sx_queue_spsc* queue;
+    int num_items;
+} spsc_test;
+
+typedef struct mpmc_test {
+    sx_queue_mpmc* queue;
+    int num_items;    // per producer
+    int num_producers;
+    bool batch;
+    sx_atomic_int num_consumed;
+    int* counts;    // [num_producers * num_items]: consume count of each item (atomic)
+} mpmc_test;
+
+typedef struct mpsc_item {
+    sx_queue_mpsc_node node;
+    int producer;
+    int index;
+} mpsc_item;
+
+typedef struct mpsc_test {
+    sx_queue_mpsc* queue;
+    mpsc_item* items;    // [num_producers * num_items]
+    int num_items;
+    int num_producers;
+    bool batch;
+} mpsc_test;
+
+typedef struct thread_data {
+    void* test;
+    int index;
+} thread_data;
+
+static const sx_alloc* g_alloc;
+
+static int spsc_producer_cb(void* user_data1, void* user_data2)
+{
+    sx_unused(user_data2);
+    spsc_test* t = user_data1;
+    for (int i = 0; i < t->num_items; i++) {
+        while (!sx_queue_spsc_produce(t->queue, &i))
+            sx_thread_yield();
+    }
+    return 0;
+}
+
+// returns elapsed time in seconds, or negative value on failure
+// spsc has no batch operations and always runs 1:1
+static double test_spsc(int num_items, bool batch, int num_producers, int num_consumers)
+{
+    sx_unused(batch);
+    sx_unused(num_producers);
+    sx_unused(num_consumers);
+
+    spsc_test t = { .queue = sx_queue_spsc_create(g_alloc, sizeof(int), 1024),
+                    .num_items = num_items };
+    if (!t.queue)
+        return -1.0;
+
+    uint64_t start = sx_tm_now();
+    sx_thread* thrd = sx_thread_create(g_alloc, spsc_producer_cb, &t, 0, "producer", NULL);
+
+    // consume on this thread, items must arrive in order
+    int errors = 0;
+    for (int i = 0; i < num_items;) {
+        int item;
+        if (!sx_queue_spsc_consume(t.queue, &item)) {
+            sx_thread_yield();
+            continue;
+        }
+        if (item != i && errors++ < 10)
+            printf("\tSPSC: expected item %d, got %d\n", i, item);
+        i++;
+    }
+
+    sx_thread_destroy(thrd, g_alloc);
+    double elapsed = sx_tm_sec(sx_tm_since(start));
+
+    sx_queue_spsc_destroy(t.queue, g_alloc);
+    return errors == 0 ? elapsed : -1.0;
+}
+
+static int mpmc_producer_cb(void* user_data1, void* user_data2)
+{
+    sx_unused(user_data2);
+    thread_data* td = user_data1;
+    mpmc_test* t = td->test;
+    int base = td->index * t->num_items;
+
+    if (t->batch) {
+        int items[BATCH_SIZE];
+        for (int i = 0; i < t->num_items;) {
+            int count = sx_min(BATCH_SIZE, t->num_items - i);
+            for (int k = 0; k < count; k++)
+                items[k] = base + i + k;
+            int offset = 0;
+            while (offset < count) {
+                int n = sx_queue_mpmc_produce_batch(t->queue, items + offset, count - offset);
+                if (n == 0)
+                    sx_thread_yield();
+                offset += n;
+            }
+            i += count;
+        }
+    } else {
+        for (int i = 0; i < t->num_items; i++) {
+            int item = base + i;
+            while (!sx_queue_mpmc_produce(t->queue, &item))
+                sx_thread_yield();
+        }
+    }
+    return 0;
+}
+
+static int mpmc_consumer_cb(void* user_data1, void* user_data2)
+{
+    sx_unused(user_data2);
+    thread_data* td = user_data1;
+    mpmc_test* t = td->test;
+    int total = t->num_producers * t->num_items;
+
+    int items[BATCH_SIZE];
+    while (t->num_consumed < total) {
+        int n;
+        if (t->batch) {
+            n = sx_queue_mpmc_consume_batch(t->queue, items, BATCH_SIZE);
+        } else {
+            n = sx_queue_mpmc_consume(t->queue, &items[0]) ? 1 : 0;
+        }
+
+        if (n == 0) {
+            sx_thread_yield();
+            continue;
+        }
+        for (int i = 0; i < n; i++)
+            sx_atomic_incr((sx_atomic_int*)&t->counts[items[i]]);
+        sx_atomic_fetch_add(&t->num_consumed, n);
+    }
+    return 0;
+}
+
+// returns elapsed time in seconds, or negative value on failure
+static double test_mpmc(int num_items, bool batch, int num_producers, int num_consumers)
+{
+    int total = num_producers * num_items;
+    mpmc_test t = { .queue = sx_queue_mpmc_create(g_alloc, sizeof(int), 1024),
+                    .num_items = num_items,
+                    .num_producers = num_producers,
+                    .batch = batch,
+                    .counts = sx_malloc(g_alloc, sizeof(int) * total) };
+    if (!t.queue || !t.counts)
+        return -1.0;
+    sx_memset(t.counts, 0x0, sizeof(int) * total);
+
+    // positions are padded to cache lines, that only holds if the queue itself is aligned
+    if ((uintptr_t)t.queue & 63) {
+        puts("\tMPMC: queue is not aligned to 64 bytes");
+        return -1.0;
+    }
+
+    thread_data tds[NUM_PRODUCERS + NUM_CONSUMERS];
+    sx_thread* thrds[NUM_PRODUCERS + NUM_CONSUMERS];
+    uint64_t start = sx_tm_now();
+    for (int i = 0; i < num_producers + num_consumers; i++) {
+        bool producer = i < num_producers;
+        tds[i] = (thread_data){ .test = &t, .index = producer ? i : i - num_producers };
+        thrds[i] = sx_thread_create(g_alloc, producer ? mpmc_producer_cb : mpmc_consumer_cb,
+                                    &tds[i], 0, producer ? "producer" : "consumer", NULL);
+    }
+    for (int i = 0; i < num_producers + num_consumers; i++)
+        sx_thread_destroy(thrds[i], g_alloc);
+    double elapsed = sx_tm_sec(sx_tm_since(start));
+
+    int errors = 0;
+    for (int i = 0; i < total; i++) {
+        if (t.counts[i] != 1) {
+            if (errors++ < 10)
+                printf("\tMPMC: item %d consumed %d times\n", i, t.counts[i]);
+        }
+    }
+
+    sx_free(g_alloc, t.counts);
+    sx_queue_mpmc_destroy(t.queue, g_alloc);
+    return errors == 0 ? elapsed : -1.0;
+}
+
+static int mpsc_producer_cb(void* user_data1, void* user_data2)
+{
+    sx_unused(user_data2);
+    thread_data* td = user_data1;
+    mpsc_test* t = td->test;
+    mpsc_item* items = t->items + td->index * t->num_items;
+
+    if (t->batch) {
+        sx_queue_mpsc_node* nodes[BATCH_SIZE];
+        for (int i = 0; i < t->num_items;) {
+            int count = sx_min(BATCH_SIZE, t->num_items - i);
+            for (int k = 0; k < count; k++)
+                nodes[k] = &items[i + k].node;
+            sx_queue_mpsc_produce_batch(t->queue, nodes, count);
+            i += count;
+        }
+    } else {
+        for (int i = 0; i < t->num_items; i++)
+            sx_queue_mpsc_produce(t->queue, &items[i].node);
+    }
+    return 0;
+}
+
+static double test_mpsc(int num_items, bool batch, int num_producers, int num_consumers)
+{
+    sx_unused(num_consumers);    // always consumed on this thread
+
+    int total = num_producers * num_items;
+    mpsc_test t = { .queue = sx_queue_mpsc_create(g_alloc),
+                    .items = sx_malloc(g_alloc, sizeof(mpsc_item) * total),
+                    .num_items = num_items,
+                    .num_producers = num_producers,
+                    .batch = batch };
+    if (!t.queue || !t.items)
+        return -1.0;
+    for (int i = 0; i < total; i++)
+        t.items[i] = (mpsc_item){ .producer = i / num_items, .index = i % num_items };
+
+    thread_data tds[NUM_PRODUCERS];
+    sx_thread* thrds[NUM_PRODUCERS];
+    uint64_t start = sx_tm_now();
+    for (int i = 0; i < num_producers; i++) {
+        tds[i] = (thread_data){ .test = &t, .index = i };
+        thrds[i] = sx_thread_create(g_alloc, mpsc_producer_cb, &tds[i], 0, "producer", NULL);
+    }
+
+    // consume on this thread, items of each producer must arrive in order
+    int next_index[NUM_PRODUCERS] = { 0 };
+    int num_consumed = 0;
+    int errors = 0;
+    sx_queue_mpsc_node* nodes[BATCH_SIZE];
+    while (num_consumed < total) {
+        int n;
+        if (batch) {
+            n = sx_queue_mpsc_consume_batch(t.queue, nodes, BATCH_SIZE);
+        } else {
+            nodes[0] = sx_queue_mpsc_consume(t.queue);
+            n = nodes[0] ? 1 : 0;
+        }
+
+        if (n == 0) {
+            sx_thread_yield();
+            continue;
+        }
+        for (int i = 0; i < n; i++) {
+            mpsc_item* item = sx_queue_mpsc_data(nodes[i], mpsc_item, node);
+            if (item->index != next_index[item->producer]) {
+                if (errors++ < 10) {
+                    printf("\tMPSC: producer %d: expected item %d, got %d\n", item->producer,
+                           next_index[item->producer], item->index);
+                }
+            }
+            next_index[item->producer] = item->index + 1;
+        }
+        num_consumed += n;
+    }
+
+    for (int i = 0; i < num_producers; i++)
+        sx_thread_destroy(thrds[i], g_alloc);
+    double elapsed = sx_tm_sec(sx_tm_since(start));
+
+    if (sx_queue_mpsc_consume(t.queue)) {
+        puts("\tMPSC: queue is not empty after consuming all items");
+        errors++;
+    }
+
+    sx_free(g_alloc, t.items);
+    sx_queue_mpsc_destroy(t.queue, g_alloc);
+    return errors == 0 ? elapsed : -1.0;
+}
+
+int main(int argc, char* argv[])
+{
+    bool bench = argc > 1 && sx_strequal(argv[1], "-b");
+    int num_items = bench ? 1000000 : 50000;
+    int num_runs = bench ? 5 : 1;
+
+    g_alloc = sx_alloc_malloc();
+    sx_tm_init();
+
+    struct {
+        const char* name;
+        double (*test_fn)(int num_items, bool batch, int num_producers, int num_consumers);
+        bool batch;
+        int num_producers;
+        int num_consumers;
+    } tests[] = { { "spsc 1:1", test_spsc, false, 1, 1 },
+                  { "mpmc 1:1", test_mpmc, false, 1, 1 },
+                  { "mpsc 1:1", test_mpsc, false, 1, 1 },
+                  { "mpmc", test_mpmc, false, NUM_PRODUCERS, NUM_CONSUMERS },
+                  { "mpmc (batch)", test_mpmc, true, NUM_PRODUCERS, NUM_CONSUMERS },
+                  { "mpsc", test_mpsc, false, NUM_PRODUCERS, 1 },
+                  { "mpsc (batch)", test_mpsc, true, NUM_PRODUCERS, 1 } };
+
+    printf("producers: %d, consumers (mpmc): %d, items per producer: %d, batch: %d\n",
+           NUM_PRODUCERS, NUM_CONSUMERS, num_items, BATCH_SIZE);
+
+    int result = 0;
+    for (int i = 0; i < (int)(sizeof(tests) / sizeof(tests[0])); i++) {
+        double best = 0;
+        for (int r = 0; r < num_runs; r++) {
+            double elapsed = tests[i].test_fn(num_items, tests[i].batch, tests[i].num_producers,
+                                              tests[i].num_consumers);
+            if (elapsed < 0) {
+                printf("%s: FAILED\n", tests[i].name);
+                result = 1;
+                best = -1.0;
+                break;
+            }
+            best = (r == 0) ? elapsed : sx_min(best, elapsed);
+        }
+
+        if (best > 0) {
+            double mitems = (double)tests[i].num_producers * num_items / best / 1000000.0;
+            printf("%-16s %8.2f ms  %8.2f M items/s\n", tests[i].name, best * 1000.0, mitems);
+        }
+    }
+
+    return result;
+}
@@ -0,0 +1,302 @@
+//
+// Test and benchmark for batch math kernels (sx_xxx_batch functions of sx/math.h)
+//  - every kernel is checked against the scalar functions of math.h, including in-place calls
+//  - benchmark: scalar loop vs. batch kernel, items per second
+// run with '-b' for the full benchmark, otherwise a short version is executed (ctest)
+//
+#include "sx/allocator.h"
+#include "sx/math.h"
+#include "sx/rng.h"
+#include "sx/string.h"
+#include "sx/timer.h"
+
+#include <stdio.h>
+
+#define NUM_ODD_ITEMS 13    // not a multiple of SIMD width, to hit the scalar tails
+
+typedef struct test_data {
+    sx_mat4* mats_a;
+    sx_mat4* mats_b;
+    sx_mat4* mats_ref;
+    sx_mat4* mats_dst;
+    sx_vec3* pts3;
+    sx_vec3* pts3_ref;
+    sx_vec3* pts3_dst;
+    sx_vec2* pts2;
+    sx_vec2* pts2_ref;
+    sx_vec2* pts2_dst;
+    sx_aabb* boxes;
+    sx_aabb* boxes_ref;
+    sx_aabb* boxes_dst;
+    sx_quat* quats;
+    sx_mat4 mat;
+    sx_mat3 mat3;
+    int count;
+} test_data;
+
+typedef struct bench_result {
+    double scalar;
+    double batch;
+} bench_result;
+
+static const sx_alloc* g_alloc;
+static sx_rng g_rng;
+
+static float randf(void)
+{
+    return sx_rng_gen_f(&g_rng) * 20.0f - 10.0f;
+}
+
+static bool equalf(float a, float b)
+{
+    return sx_abs(a - b) <= 1e-4f * (1.0f + sx_abs(b));
+}
+
+static bool equal_floats(const float* a, const float* b, int count)
+{
+    for (int i = 0; i < count; i++) {
+        if (!equalf(a[i], b[i]))
+            return false;
+    }
+    return true;
+}
+
+static sx_mat4 random_affine(void)
+{
+    sx_quat q = sx_quat_norm(sx_quat4f(randf(), randf(), randf(), randf()));
+    sx_mat4 m = sx_quat_mat4(q);
+    float s = 0.5f + sx_rng_gen_f(&g_rng);
+    m.col1 = sx_vec4_mulf(m.col1, s);
+    m.col2 = sx_vec4_mulf(m.col2, s);
+    m.col3 = sx_vec4_mulf(m.col3, s);
+    m.col4 = sx_vec4f(randf(), randf(), randf(), 1.0f);
+    return m;
+}
+
+static bool test_data_init(test_data* d, int count)
+{
+    sx_memset(d, 0x0, sizeof(*d));
+    d->count = count;
+    d->mats_a = sx_malloc(g_alloc, sizeof(sx_mat4) * count);
+    d->mats_b = sx_malloc(g_alloc, sizeof(sx_mat4) * count);
+    d->mats_ref = sx_malloc(g_alloc, sizeof(sx_mat4) * count);
+    d->mats_dst = sx_malloc(g_alloc, sizeof(sx_mat4) * count);
+    d->pts3 = sx_malloc(g_alloc, sizeof(sx_vec3) * count);
+    d->pts3_ref = sx_malloc(g_alloc, sizeof(sx_vec3) * count);
+    d->pts3_dst = sx_malloc(g_alloc, sizeof(sx_vec3) * count);
+    d->pts2 = sx_malloc(g_alloc, sizeof(sx_vec2) * count);
+    d->pts2_ref = sx_malloc(g_alloc, sizeof(sx_vec2) * count);
+    d->pts2_dst = sx_malloc(g_alloc, sizeof(sx_vec2) * count);
+    d->boxes = sx_malloc(g_alloc, sizeof(sx_aabb) * count);
+    d->boxes_ref = sx_malloc(g_alloc, sizeof(sx_aabb) * count);
+    d->boxes_dst = sx_malloc(g_alloc, sizeof(sx_aabb) * count);
+    d->quats = sx_malloc(g_alloc, sizeof(sx_quat) * count);
+    if (!d->mats_a || !d->mats_b || !d->mats_ref || !d->mats_dst || !d->pts3 || !d->pts3_ref ||
+        !d->pts3_dst || !d->pts2 || !d->pts2_ref || !d->pts2_dst || !d->boxes ||
+        !d->boxes_ref || !d->boxes_dst || !d->quats) {
+        return false;
+    }
+
+    for (int i = 0; i < count; i++) {
+        d->mats_a[i] = random_affine();
+        d->mats_b[i] = random_affine();
+        d->pts3[i] = sx_vec3f(randf(), randf(), randf());
+        d->pts2[i] = sx_vec2f(randf(), randf());
+        sx_vec3 center = sx_vec3f(randf(), randf(), randf());
+        sx_vec3 extent = sx_vec3f(sx_abs(randf()), sx_abs(randf()), sx_abs(randf()));
+        d->boxes[i] = sx_aabbv(sx_vec3_sub(center, extent), sx_vec3_add(center, extent));
+        d->quats[i] = sx_quat_norm(sx_quat4f(randf(), randf(), randf(), randf()));
+    }
+    d->mat = random_affine();
+    d->mat3 = sx_mat3f(d->mat.m11, d->mat.m12, d->mat.m14, d->mat.m21, d->mat.m22, d->mat.m24,
+                       0, 0, 1.0f);
+    return true;
+}
+
+static void test_data_release(test_data* d)
+{
+    sx_free(g_alloc, d->mats_a);
+    sx_free(g_alloc, d->mats_b);
+    sx_free(g_alloc, d->mats_ref);
+    sx_free(g_alloc, d->mats_dst);
+    sx_free(g_alloc, d->pts3);
+    sx_free(g_alloc, d->pts3_ref);
+    sx_free(g_alloc, d->pts3_dst);
+    sx_free(g_alloc, d->pts2);
+    sx_free(g_alloc, d->pts2_ref);
+    sx_free(g_alloc, d->pts2_dst);
+    sx_free(g_alloc, d->boxes);
+    sx_free(g_alloc, d->boxes_ref);
+    sx_free(g_alloc, d->boxes_dst);
+    sx_free(g_alloc, d->quats);
+}
+
+// reference AABB transform: bounds of the 8 transformed corners
+static sx_aabb aabb_transform_corners(const sx_mat4* mat, const sx_aabb* box)
+{
+    sx_aabb r = sx_aabb_empty();
+    for (int i = 0; i < 8; i++)
+        sx_aabb_add_point(&r, sx_mat4_mul_vec3(mat, sx_aabb_corner(box, i)));
+    return r;
+}
+
+// each kernel runs the scalar version into `xxx_ref`, the batch version into `xxx_dst`, then
+// compares them. returns false on mismatch
+static bool run_mat4_mul(test_data* d, int count, bench_result* r)
+{
+    uint64_t t = sx_tm_now();
+    for (int i = 0; i < count; i++)
+        d->mats_ref[i] = sx_mat4_mul(&d->mats_a[i], &d->mats_b[i]);
+    r->scalar += sx_tm_sec(sx_tm_since(t));
+
+    t = sx_tm_now();
+    sx_mat4_mul_batch(d->mats_dst, d->mats_a, d->mats_b, count);
+    r->batch += sx_tm_sec(sx_tm_since(t));
+
+    return equal_floats(d->mats_dst->f, d->mats_ref->f, count * 16);
+}
+
+static bool run_mat4_mul_vec3(test_data* d, int count, bench_result* r)
+{
+    uint64_t t = sx_tm_now();
+    for (int i = 0; i < count; i++)
+        d->pts3_ref[i] = sx_mat4_mul_vec3(&d->mat, d->pts3[i]);
+    r->scalar += sx_tm_sec(sx_tm_since(t));
+
+    t = sx_tm_now();
+    sx_mat4_mul_vec3_batch(d->pts3_dst, &d->mat, d->pts3, count);
+    r->batch += sx_tm_sec(sx_tm_since(t));
+
+    return equal_floats(d->pts3_dst->f, d->pts3_ref->f, count * 3);
+}
+
+static bool run_mat3_mul_vec2(test_data* d, int count, bench_result* r)
+{
+    uint64_t t = sx_tm_now();
+    for (int i = 0; i < count; i++)
+        d->pts2_ref[i] = sx_mat3_mul_vec2(&d->mat3, d->pts2[i]);
+    r->scalar += sx_tm_sec(sx_tm_since(t));
+
+    t = sx_tm_now();
+    sx_mat3_mul_vec2_batch(d->pts2_dst, &d->mat3, d->pts2, count);
+    r->batch += sx_tm_sec(sx_tm_since(t));
+
+    return equal_floats(d->pts2_dst->f, d->pts2_ref->f, count * 2);
+}
+
+static bool run_aabb_transform(test_data* d, int count, bench_result* r)
+{
+    uint64_t t = sx_tm_now();
+    for (int i = 0; i < count; i++)
+        d->boxes_ref[i] = sx_aabb_transform(&d->boxes[i], &d->mat);
+    r->scalar += sx_tm_sec(sx_tm_since(t));
+
+    t = sx_tm_now();
+    sx_aabb_transform_batch(d->boxes_dst, &d->mat, d->boxes, count);
+    r->batch += sx_tm_sec(sx_tm_since(t));
+
+    return equal_floats(d->boxes_dst->f, d->boxes_ref->f, count * 6);
+}
+
+static bool run_quat_mat4(test_data* d, int count, bench_result* r)
+{
+    uint64_t t = sx_tm_now();
+    for (int i = 0; i < count; i++)
+        d->mats_ref[i] = sx_quat_mat4(d->quats[i]);
+    r->scalar += sx_tm_sec(sx_tm_since(t));
+
+    t = sx_tm_now();
+    sx_quat_mat4_batch(d->mats_dst, d->quats, count);
+    r->batch += sx_tm_sec(sx_tm_since(t));
+
+    return equal_floats(d->mats_dst->f, d->mats_ref->f, count * 16);
+}
+
+// kernels must also work when the destination is one of the sources
+// AABBs are checked against the transformed corners here, instead of the scalar Arvo's method
+static bool test_in_place(test_data* d)
+{
+    int count = NUM_ODD_ITEMS;
+    bool ok = true;
+
+    sx_memcpy(d->mats_dst, d->mats_a, sizeof(sx_mat4) * count);
+    sx_mat4_mul_batch(d->mats_dst, d->mats_dst, d->mats_b, count);
+    for (int i = 0; i < count; i++)
+        d->mats_ref[i] = sx_mat4_mul(&d->mats_a[i], &d->mats_b[i]);
+    ok &= equal_floats(d->mats_dst->f, d->mats_ref->f, count * 16);
+
+    sx_memcpy(d->pts3_dst, d->pts3, sizeof(sx_vec3) * count);
+    sx_mat4_mul_vec3_batch(d->pts3_dst, &d->mat, d->pts3_dst, count);
+    for (int i = 0; i < count; i++)
+        d->pts3_ref[i] = sx_mat4_mul_vec3(&d->mat, d->pts3[i]);
+    ok &= equal_floats(d->pts3_dst->f, d->pts3_ref->f, count * 3);
+
+    sx_memcpy(d->pts2_dst, d->pts2, sizeof(sx_vec2) * count);
+    sx_mat3_mul_vec2_batch(d->pts2_dst, &d->mat3, d->pts2_dst, count);
+    for (int i = 0; i < count; i++)
+        d->pts2_ref[i] = sx_mat3_mul_vec2(&d->mat3, d->pts2[i]);
+    ok &= equal_floats(d->pts2_dst->f, d->pts2_ref->f, count * 2);
+
+    sx_memcpy(d->boxes_dst, d->boxes, sizeof(sx_aabb) * count);
+    sx_aabb_transform_batch(d->boxes_dst, &d->mat, d->boxes_dst, count);
+    for (int i = 0; i < count; i++)
+        d->boxes_ref[i] = aabb_transform_corners(&d->mat, &d->boxes[i]);
+    ok &= equal_floats(d->boxes_dst->f, d->boxes_ref->f, count * 6);
+
+    return ok;
+}
+
+int main(int argc, char* argv[])
+{
+    bool bench = argc > 1 && sx_strequal(argv[1], "-b");
+    int count = bench ? 100000 : 10000;
+    int num_runs = bench ? 50 : 2;
+
+    g_alloc = sx_alloc_malloc();
+    sx_tm_init();
+    sx_rng_seed(&g_rng, 0x5eed);
+
+    test_data d;
+    if (!test_data_init(&d, count)) {
+        puts("out of memory");
+        return 1;
+    }
+
+    struct {
+        const char* name;
+        bool (*run_fn)(test_data* d, int count, bench_result* r);
+    } tests[] = { { "mat4_mul", run_mat4_mul },
+                  { "mat4_mul_vec3", run_mat4_mul_vec3 },
+                  { "mat3_mul_vec2", run_mat3_mul_vec2 },
+                  { "aabb_transform", run_aabb_transform },
+                  { "quat_mat4", run_quat_mat4 } };
+
+    printf("backend: %s, items: %d, runs: %d\n", sx_math_batch_backend(), count, num_runs);
+
+    int result = 0;
+    for (int i = 0; i < (int)(sizeof(tests) / sizeof(tests[0])); i++) {
+        bench_result r = { 0 };
+        bool ok = tests[i].run_fn(&d, NUM_ODD_ITEMS, &r);
+        r = (bench_result){ 0 };
+        for (int k = 0; k < num_runs && ok; k++)
+            ok = tests[i].run_fn(&d, count, &r);
+
+        if (!ok) {
+            printf("%s: FAILED\n", tests[i].name);
+            result = 1;
+            continue;
+        }
+
+        double total = (double)count * (double)num_runs / 1000000.0;
+        printf("%-16s scalar: %8.2f M items/s  batch: %8.2f M items/s  (x%.2f)\n", tests[i].name,
+               total / r.scalar, total / r.batch, r.scalar / r.batch);
+    }
+
+    if (!test_in_place(&d)) {
+        puts("in-place: FAILED");
+        result = 1;
+    }
+
+    test_data_release(&d);
+    return result;
+}
@@ -0,0 +1,298 @@
+//
+// Test and benchmark for mip generation kernels (sx_rgba8_box_batch and sx_rgba16_box_batch of
+// sx/math.h), the 2x2 box filters of the texture loader of rizz (graphics.c)
+//  - kernels are checked bit-exact against a scalar reference: even, odd and 1 texel widths, single
+//    row sources, in-place downsampling and whole mip-chains
+//  - benchmark: scalar reference vs. SIMD kernels, base level megapixels per second of a full
+//    mip-chain, for both filters of the loader:
+//      linear: RGBA8 texels are averaged as they are
+//      srgb:   texels are decoded to 14bit linear with a LUT, averaged, then encoded back with
+//              another LUT. intermediate levels stay linear
+// run with '-b' for the full benchmark, otherwise a short version is executed (ctest)
+//
+#include "sx/allocator.h"
+#include "sx/math.h"
+#include "sx/rng.h"
+#include "sx/string.h"
+#include "sx/timer.h"
+
+#include <stdio.h>
+
+#define LINEAR_BITS 14
+#define LINEAR_MAX ((1 << LINEAR_BITS) - 1)
+#define ALPHA_SHIFT (LINEAR_BITS - 8)
+#define MAX_ROW_WIDTH 40
+
+typedef void(box8_fn)(uint8_t* dst, const uint8_t* r0, const uint8_t* r1, int dst_w, int src_w);
+typedef void(box16_fn)(uint16_t* dst, const uint16_t* r0, const uint16_t* r1, int dst_w,
+                       int src_w);
+
+typedef struct mip_kernels {
+    box8_fn* box8;
+    box16_fn* box16;
+} mip_kernels;
+
+typedef struct mip_image {
+    uint8_t* pixels;
+    uint8_t* mips;        // levels [1..num_mips), one after another
+    uint16_t* work;       // decoded base level + first mip level
+    int width;
+    int height;
+    int num_mips;
+    int mips_size;
+} mip_image;
+
+static const sx_alloc* g_alloc;
+static sx_rng g_rng;
+static uint16_t g_srgb_to_linear[256];
+static uint8_t g_linear_to_srgb[LINEAR_MAX + 1];
+
+static void ref_box_rgba8(uint8_t* dst, const uint8_t* r0, const uint8_t* r1, int dst_w, int src_w)
+{
+    for (int x = 0; x < dst_w; x++) {
+        int x0 = sx_min(x * 2, src_w - 1) * 4;
+        int x1 = sx_min(x * 2 + 1, src_w - 1) * 4;
+        for (int c = 0; c < 4; c++) {
+            int sum = r0[x0 + c] + r0[x1 + c] + r1[x0 + c] + r1[x1 + c];
+            dst[x * 4 + c] = (uint8_t)((sum + 2) >> 2);
+        }
+    }
+}
+
+static void ref_box_rgba16(uint16_t* dst, const uint16_t* r0, const uint16_t* r1, int dst_w,
+                           int src_w)
+{
+    for (int x = 0; x < dst_w; x++) {
+        int x0 = sx_min(x * 2, src_w - 1) * 4;
+        int x1 = sx_min(x * 2 + 1, src_w - 1) * 4;
+        for (int c = 0; c < 4; c++) {
+            int sum = r0[x0 + c] + r0[x1 + c] + r1[x0 + c] + r1[x1 + c];
+            dst[x * 4 + c] = (uint16_t)((sum + 2) >> 2);
+        }
+    }
+}
+
+static const mip_kernels k_scalar = { ref_box_rgba8, ref_box_rgba16 };
+static const mip_kernels k_simd = { sx_rgba8_box_batch, sx_rgba16_box_batch };
+
+// same LUTs as the texture loader
+static void init_luts(void)
+{
+    for (int i = 0; i < 256; i++) {
+        float l = sx_color_tolinear((float)i / 255.0f);
+        g_srgb_to_linear[i] = (uint16_t)(l * (float)LINEAR_MAX + 0.5f);
+    }
+    for (int i = 0; i <= LINEAR_MAX; i++) {
+        float s = sx_color_togamma((float)i / (float)LINEAR_MAX);
+        g_linear_to_srgb[i] = (uint8_t)sx_min(s * 255.0f + 0.5f, 255.0f);
+    }
+}
+
+static inline int mip_dim(int size, int mip)
+{
+    return sx_max(size >> mip, 1);
+}
+
+static void decode_srgb(uint16_t* dst, const uint8_t* src, int width)
+{
+    for (int x = 0, c = width * 4; x < c; x += 4) {
+        dst[x] = g_srgb_to_linear[src[x]];
+        dst[x + 1] = g_srgb_to_linear[src[x + 1]];
+        dst[x + 2] = g_srgb_to_linear[src[x + 2]];
+        dst[x + 3] = (uint16_t)(src[x + 3] << ALPHA_SHIFT);
+    }
+}
+
+static void encode_srgb(uint8_t* dst, const uint16_t* src, int width)
+{
+    const int round = 1 << (ALPHA_SHIFT - 1);
+    for (int x = 0, c = width * 4; x < c; x += 4) {
+        dst[x] = g_linear_to_srgb[src[x]];
+        dst[x + 1] = g_linear_to_srgb[src[x + 1]];
+        dst[x + 2] = g_linear_to_srgb[src[x + 2]];
+        dst[x + 3] = (uint8_t)sx_min((src[x + 3] + round) >> ALPHA_SHIFT, 255);
+    }
+}
+
+// mip-chain of the image, the same passes as rizz__texture_gen_mips of graphics.c
+static void gen_mips(mip_image* img, const mip_kernels* k, bool srgb)
+{
+    int width = img->width, height = img->height;
+    uint8_t* mips = img->mips;
+    if (!srgb) {
+        const uint8_t* src = img->pixels;
+        for (int mip = 1; mip < img->num_mips; mip++) {
+            int src_w = mip_dim(width, mip - 1), src_h = mip_dim(height, mip - 1);
+            int dst_w = mip_dim(width, mip), dst_h = mip_dim(height, mip);
+            for (int y = 0; y < dst_h; y++) {
+                const uint8_t* r0 = src + sx_min(y * 2, src_h - 1) * src_w * 4;
+                const uint8_t* r1 = src + sx_min(y * 2 + 1, src_h - 1) * src_w * 4;
+                k->box8(mips + y * dst_w * 4, r0, r1, dst_w, src_w);
+            }
+            src = mips;
+            mips += dst_w * dst_h * 4;
+        }
+        return;
+    }
+
+    uint16_t* base = img->work;
+    uint16_t* work = base + width * height * 4;
+    for (int y = 0; y < height; y++)
+        decode_srgb(base + y * width * 4, img->pixels + y * width * 4, width);
+
+    const uint16_t* src = base;
+    for (int mip = 1; mip < img->num_mips; mip++) {
+        int src_w = mip_dim(width, mip - 1), src_h = mip_dim(height, mip - 1);
+        int dst_w = mip_dim(width, mip), dst_h = mip_dim(height, mip);
+        for (int y = 0; y < dst_h; y++) {
+            const uint16_t* r0 = src + sx_min(y * 2, src_h - 1) * src_w * 4;
+            const uint16_t* r1 = src + sx_min(y * 2 + 1, src_h - 1) * src_w * 4;
+            uint16_t* dst_row = work + y * dst_w * 4;
+            k->box16(dst_row, r0, r1, dst_w, src_w);
+            encode_srgb(mips + y * dst_w * 4, dst_row, dst_w);
+        }
+        src = work;
+        mips += dst_w * dst_h * 4;
+    }
+}
+
+static bool mip_image_init(mip_image* img, int width, int height)
+{
+    sx_memset(img, 0x0, sizeof(*img));
+    img->width = width;
+    img->height = height;
+    img->num_mips = 1;
+    for (int size = sx_max(width, height); size > 1; size >>= 1)
+        ++img->num_mips;
+    for (int mip = 1; mip < img->num_mips; mip++)
+        img->mips_size += mip_dim(width, mip) * mip_dim(height, mip) * 4;
+
+    img->pixels = sx_malloc(g_alloc, width * height * 4);
+    img->mips = sx_malloc(g_alloc, sx_max(img->mips_size, 1));
+    img->work = sx_malloc(g_alloc, sizeof(uint16_t) * 4 *
+                                       (width * height + mip_dim(width, 1) * mip_dim(height, 1)));
+    if (!img->pixels || !img->mips || !img->work)
+        return false;
+    for (int i = 0; i < width * height * 4; i++)
+        img->pixels[i] = (uint8_t)sx_rng_gen_irange(&g_rng, 0, 255);
+    return true;
+}
+
+static void mip_image_release(mip_image* img)
+{
+    sx_free(g_alloc, img->pixels);
+    sx_free(g_alloc, img->mips);
+    sx_free(g_alloc, img->work);
+}
+
+// single rows of every width up to MAX_ROW_WIDTH, with two rows, a single row and in-place
+static bool test_rows(void)
+{
+    uint8_t r8[2][MAX_ROW_WIDTH * 4], dst8[MAX_ROW_WIDTH * 4], ref8[MAX_ROW_WIDTH * 4];
+    uint16_t r16[2][MAX_ROW_WIDTH * 4], dst16[MAX_ROW_WIDTH * 4], ref16[MAX_ROW_WIDTH * 4];
+    uint16_t inplace[MAX_ROW_WIDTH * 8];
+    for (int i = 0; i < MAX_ROW_WIDTH * 4; i++) {
+        r8[0][i] = (uint8_t)sx_rng_gen_irange(&g_rng, 0, 255);
+        r8[1][i] = (uint8_t)sx_rng_gen_irange(&g_rng, 0, 255);
+        r16[0][i] = (uint16_t)sx_rng_gen_irange(&g_rng, 0, LINEAR_MAX);
+        r16[1][i] = (uint16_t)sx_rng_gen_irange(&g_rng, 0, LINEAR_MAX);
+    }
+    // maximum values at the start, rounding must not overflow 16bit lanes
+    for (int i = 0; i < 8; i++) {
+        r8[0][i] = r8[1][i] = 0xff;
+        r16[0][i] = r16[1][i] = LINEAR_MAX;
+    }
+
+    bool ok = true;
+    for (int src_w = 1; src_w <= MAX_ROW_WIDTH; src_w++) {
+        int dst_w = mip_dim(src_w, 1);
+        for (int single = 0; single < 2; single++) {
+            int r1 = single ? 0 : 1;
+            sx_rgba8_box_batch(dst8, r8[0], r8[r1], dst_w, src_w);
+            ref_box_rgba8(ref8, r8[0], r8[r1], dst_w, src_w);
+            ok &= sx_memcmp(dst8, ref8, dst_w * 4) == 0;
+
+            sx_rgba16_box_batch(dst16, r16[0], r16[r1], dst_w, src_w);
+            ref_box_rgba16(ref16, r16[0], r16[r1], dst_w, src_w);
+            ok &= sx_memcmp(dst16, ref16, sizeof(uint16_t) * dst_w * 4) == 0;
+        }
+
+        // destination is the first source row, like deeper sRGB levels of the loader
+        sx_memcpy(inplace, r16[0], sizeof(uint16_t) * src_w * 4);
+        sx_memcpy(inplace + src_w * 4, r16[1], sizeof(uint16_t) * src_w * 4);
+        sx_rgba16_box_batch(inplace, inplace, inplace + src_w * 4, dst_w, src_w);
+        ref_box_rgba16(ref16, r16[0], r16[1], dst_w, src_w);
+        ok &= sx_memcmp(inplace, ref16, sizeof(uint16_t) * dst_w * 4) == 0;
+    }
+    return ok;
+}
+
+// whole mip-chains of odd, thin and power-of-two images
+static bool test_chains(void)
+{
+    const int sizes[][2] = { { 37, 13 }, { 1, 9 }, { 9, 1 }, { 64, 64 }, { 130, 66 } };
+    bool ok = true;
+    for (int i = 0; i < (int)(sizeof(sizes) / sizeof(sizes[0])) && ok; i++) {
+        mip_image img;
+        uint8_t* ref = NULL;
+        ok = mip_image_init(&img, sizes[i][0], sizes[i][1]);
+        ok = ok && (ref = sx_malloc(g_alloc, sx_max(img.mips_size, 1))) != NULL;
+        for (int srgb = 0; srgb < 2 && ok; srgb++) {
+            gen_mips(&img, &k_scalar, srgb != 0);
+            sx_memcpy(ref, img.mips, img.mips_size);
+            gen_mips(&img, &k_simd, srgb != 0);
+            ok = sx_memcmp(ref, img.mips, img.mips_size) == 0;
+        }
+        sx_free(g_alloc, ref);
+        mip_image_release(&img);
+    }
+    return ok;
+}
+
+// returns base level megapixels per second
+static double bench_mips(mip_image* img, const mip_kernels* k, bool srgb, int num_runs)
+{
+    uint64_t start = sx_tm_now();
+    for (int r = 0; r < num_runs; r++)
+        gen_mips(img, k, srgb);
+    double mp = (double)img->width * (double)img->height * (double)num_runs / 1000000.0;
+    return mp / sx_tm_sec(sx_tm_since(start));
+}
+
+int main(int argc, char* argv[])
+{
+    bool bench = argc > 1 && sx_strequal(argv[1], "-b");
+    int size = bench ? 1024 : 256;
+    int num_runs = bench ? 50 : 2;
+
+    g_alloc = sx_alloc_malloc();
+    sx_tm_init();
+    sx_rng_seed(&g_rng, 0x5eed);
+    init_luts();
+
+    printf("image: %dx%d, runs: %d\n", size, size, num_runs);
+
+    int result = 0;
+    bool ok = test_rows();
+    printf("%-8s %s\n", "rows", ok ? "ok" : "FAILED");
+    result = ok ? result : 1;
+
+    ok = test_chains();
+    printf("%-8s %s\n", "chains", ok ? "ok" : "FAILED");
+    result = ok ? result : 1;
+
+    mip_image img;
+    if (!mip_image_init(&img, size, size)) {
+        puts("out of memory");
+        mip_image_release(&img);
+        return 1;
+    }
+    for (int srgb = 0; srgb < 2; srgb++) {
+        double scalar = bench_mips(&img, &k_scalar, srgb != 0, num_runs);
+        double simd = bench_mips(&img, &k_simd, srgb != 0, num_runs);
+        printf("%-8s scalar: %8.1f MP/s  simd: %8.1f MP/s  (x%.2f)\n", srgb ? "srgb" : "linear",
+               scalar, simd, simd / scalar);
+    }
+    mip_image_release(&img);
+    return result;
+}